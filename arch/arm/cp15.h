@@ -77,6 +77,22 @@
  * permission fault cannot be generated. */
 #define CP15_DACR_MANAGER_ACCESS(x) (3u << (2 * ((x) & 15)))
 
+/* PMCR: E - Enable all counters */
+#define CP15_PMCR_E (1u << 0)
+
+/* PMCR: P - Reset all event counters (not PMCCNTR) */
+#define CP15_PMCR_P (1u << 1)
+
+/* PMCR: C - Reset cycle counter (PMCCNTR) */
+#define CP15_PMCR_C (1u << 2)
+
+/* PMCR: N - Number of event counters */
+#define CP15_PMCR_N_Pos 11
+#define CP15_PMCR_N_Msk (0x1fu << CP15_PMCR_N_Pos)
+
+/* PMCNTENSET/PMCNTENCLR/PMOVSR: C - Cycle counter bit */
+#define CP15_PMCNTEN_C (1u << 31)
+
 /*------------------------------------------------------------------------------ */
 /*         Exported functions */
 /*------------------------------------------------------------------------------ */
@@ -219,4 +235,103 @@ static inline void cp15_dcache_clean_invalidate_mva(uint32_t mva)
 	asm("mcr p15, 0, %0, c7, c14, 1" :: "r"(mva));
 }
 
+/**
+ * \brief Read the Performance Monitors Control Register (PMCR).
+ * \return register contents
+ */
+static inline uint32_t cp15_read_pmcr(void)
+{
+	uint32_t pmcr;
+	asm volatile("mrc p15, 0, %0, c9, c12, 0" : "=r"(pmcr));
+	return pmcr;
+}
+
+/**
+ * \brief Modify the Performance Monitors Control Register (PMCR).
+ * \param value new value for PMCR
+ */
+static inline void cp15_write_pmcr(uint32_t value)
+{
+	asm volatile("mcr p15, 0, %0, c9, c12, 0" :: "r"(value));
+}
+
+/**
+ * \brief Enable performance counters (PMCNTENSET).
+ * \param mask counters to enable (bit 31 is the cycle counter)
+ */
+static inline void cp15_write_pmcntenset(uint32_t mask)
+{
+	asm volatile("mcr p15, 0, %0, c9, c12, 1" :: "r"(mask));
+}
+
+/**
+ * \brief Disable performance counters (PMCNTENCLR).
+ * \param mask counters to disable (bit 31 is the cycle counter)
+ */
+static inline void cp15_write_pmcntenclr(uint32_t mask)
+{
+	asm volatile("mcr p15, 0, %0, c9, c12, 2" :: "r"(mask));
+}
+
+/**
+ * \brief Read and clear the overflow flags (PMOVSR).
+ * \return overflow flags before clearing
+ */
+static inline uint32_t cp15_read_clear_pmovsr(void)
+{
+	uint32_t pmovsr;
+	asm volatile("mrc p15, 0, %0, c9, c12, 3" : "=r"(pmovsr));
+	asm volatile("mcr p15, 0, %0, c9, c12, 3" :: "r"(pmovsr));
+	return pmovsr;
+}
+
+/**
+ * \brief Select an event counter (PMSELR).
+ * \param counter counter index
+ */
+static inline void cp15_write_pmselr(uint32_t counter)
+{
+	asm volatile("mcr p15, 0, %0, c9, c12, 5" :: "r"(counter));
+}
+
+/**
+ * \brief Read the Cycle Count Register (PMCCNTR).
+ * \return cycle count
+ */
+static inline uint32_t cp15_read_pmccntr(void)
+{
+	uint32_t pmccntr;
+	asm volatile("mrc p15, 0, %0, c9, c13, 0" : "=r"(pmccntr));
+	return pmccntr;
+}
+
+/**
+ * \brief Set the event type of the selected counter (PMXEVTYPER).
+ * \param event event number
+ */
+static inline void cp15_write_pmxevtyper(uint32_t event)
+{
+	asm volatile("mcr p15, 0, %0, c9, c13, 1" :: "r"(event));
+}
+
+/**
+ * \brief Read the selected event counter (PMXEVCNTR).
+ * \return counter value
+ */
+static inline uint32_t cp15_read_pmxevcntr(void)
+{
+	uint32_t value;
+	asm volatile("mrc p15, 0, %0, c9, c13, 2" : "=r"(value));
+	return value;
+}
+
+/**
+ * \brief Write the selected event counter (PMXEVCNTR).
+ * \param value new counter value
+ */
+static inline void cp15_write_pmxevcntr(uint32_t value)
+{
+	asm volatile("mcr p15, 0, %0, c9, c13, 2" :: "r"(value));
+}
+
 #endif /* CP15_H_ */
@@ -0,0 +1,100 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef ARM_CYCLE_COUNTER_H_
+#define ARM_CYCLE_COUNTER_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+#if defined(CONFIG_ARCH_ARMV7A)
+#include "cp15.h"
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+#if defined(CONFIG_ARCH_ARMV7A) || defined(CONFIG_ARCH_ARMV7M)
+#define CONFIG_HAVE_CYCLE_COUNTER
+#endif
+
+#if defined(CONFIG_ARCH_ARMV7M)
+/* Debug Exception and Monitor Control Register */
+#define ARM_DEMCR        (*(volatile uint32_t*)0xE000EDFCu)
+#define ARM_DEMCR_TRCENA (1u << 24)
+/* Data Watchpoint and Trace unit */
+#define ARM_DWT_CTRL     (*(volatile uint32_t*)0xE0001000u)
+#define ARM_DWT_CTRL_CYCCNTENA (1u << 0)
+#define ARM_DWT_CYCCNT   (*(volatile uint32_t*)0xE0001004u)
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Public functions
+ *----------------------------------------------------------------------------*/
+
+#if defined(CONFIG_ARCH_ARMV7A)
+
+/**
+ * \brief Enable the PMU cycle counter (PMCCNTR), counting every cycle.
+ */
+static inline void cycle_counter_enable(void)
+{
+	cp15_write_pmcr(cp15_read_pmcr() | CP15_PMCR_E | CP15_PMCR_C);
+	cp15_write_pmcntenset(CP15_PMCNTEN_C);
+}
+
+static inline uint32_t cycle_counter_read(void)
+{
+	return cp15_read_pmccntr();
+}
+
+#elif defined(CONFIG_ARCH_ARMV7M)
+
+/**
+ * \brief Enable the DWT cycle counter (CYCCNT).
+ */
+static inline void cycle_counter_enable(void)
+{
+	ARM_DEMCR |= ARM_DEMCR_TRCENA;
+	ARM_DWT_CYCCNT = 0;
+	ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+}
+
+static inline uint32_t cycle_counter_read(void)
+{
+	return ARM_DWT_CYCCNT;
+}
+
+#endif
+
+#endif /* ARM_CYCLE_COUNTER_H_ */
@@ -34,6 +34,7 @@
  *        Headers
  *----------------------------------------------------------------------------*/
 
+#include <stdbool.h>
 #include <stdint.h>
 
 /*----------------------------------------------------------------------------
@@ -56,6 +57,27 @@ static inline void arch_irq_disable(void)
 	asm("msr cpsr_c, %0" :: "r"(cpsr | 0x80));
 }
 
+static inline uint32_t arch_irq_save(void)
+{
+	uint32_t cpsr;
+	asm("mrs %0, cpsr" : "=r"(cpsr));
+	asm("msr cpsr_c, %0" :: "r"(cpsr | 0x80) : "memory");
+	return cpsr;
+}
+
+static inline void arch_irq_restore(uint32_t flags)
+{
+	asm("msr cpsr_c, %0" :: "r"(flags) : "memory");
+}
+
+/* true when an interrupt cannot be taken now: masked, or in a handler */
+static inline bool arch_irq_is_masked(void)
+{
+	uint32_t cpsr;
+	asm("mrs %0, cpsr" : "=r"(cpsr));
+	return (cpsr & 0x80) != 0;
+}
+
 #elif defined(CONFIG_ARCH_ARMV7A)
 
 static inline void arch_irq_enable(void)
@@ -68,6 +90,27 @@ static inline void arch_irq_disable(void)
 	asm("cpsid if");
 }
 
+static inline uint32_t arch_irq_save(void)
+{
+	uint32_t cpsr;
+	asm("mrs %0, cpsr" : "=r"(cpsr));
+	asm("cpsid if" ::: "memory");
+	return cpsr;
+}
+
+static inline void arch_irq_restore(uint32_t flags)
+{
+	asm("msr cpsr_c, %0" :: "r"(flags) : "memory");
+}
+
+/* true when an interrupt cannot be taken now: masked, or in a handler */
+static inline bool arch_irq_is_masked(void)
+{
+	uint32_t cpsr;
+	asm("mrs %0, cpsr" : "=r"(cpsr));
+	return (cpsr & 0x80) != 0;
+}
+
 #elif defined(CONFIG_ARCH_ARMV7M)
 
 static inline void arch_irq_enable(void)
@@ -80,6 +123,28 @@ static inline void arch_irq_disable(void)
 	asm("cpsid i");
 }
 
+static inline uint32_t arch_irq_save(void)
+{
+	uint32_t primask;
+	asm("mrs %0, primask" : "=r"(primask));
+	asm("cpsid i" ::: "memory");
+	return primask;
+}
+
+static inline void arch_irq_restore(uint32_t flags)
+{
+	asm("msr primask, %0" :: "r"(flags) : "memory");
+}
+
+/* true when an interrupt cannot be taken now: masked, or in a handler */
+static inline bool arch_irq_is_masked(void)
+{
+	uint32_t primask, ipsr;
+	asm("mrs %0, primask" : "=r"(primask));
+	asm("mrs %0, ipsr" : "=r"(ipsr));
+	return (primask & 1) || ipsr;
+}
+
 #endif
 
 #endif /* ARM_IRQFLAGS_H_ */
@@ -39,6 +39,8 @@
 #include "callback.h"
 #include "chip.h"
 #include "dma/dma.h"
+#include "errno.h"
+#include "irqflags.h"
 #include "mm/cache.h"
 #include "trace.h"
 
@@ -134,6 +136,128 @@ static void _configure_pdmic(struct _audio_desc *desc)
 }
 #endif
 
+/**
+ * Get the DMA channel of the device and the configuration of a stream
+ * transfer: data width, and address of the peripheral data register.
+ */
+static struct _dma_channel* _stream_dma(struct _audio_desc *desc,
+		struct _dma_cfg *cfg, void **reg)
+{
+	switch (desc->type) {
+#if defined(CONFIG_HAVE_CLASSD)
+	case AUDIO_DEVICE_CLASSD:
+		if (desc->direction != AUDIO_DEVICE_PLAY)
+			return NULL;
+		*cfg = desc->device.classd.desc.tx.dma.cfg_dma;
+		if (desc->device.classd.desc.left_enable &&
+		    desc->device.classd.desc.right_enable)
+			cfg->data_width = DMA_DATA_WIDTH_WORD;
+		else
+			cfg->data_width = DMA_DATA_WIDTH_HALF_WORD;
+		*reg = (void*)&desc->device.classd.addr->CLASSD_THR;
+		return desc->device.classd.desc.tx.dma.channel;
+#endif
+#if defined(CONFIG_HAVE_SSC)
+	case AUDIO_DEVICE_SSC:
+	{
+		struct _ssc_desc* ssc = &desc->device.ssc.desc;
+		struct _dma_channel* channel;
+
+		if (desc->direction == AUDIO_DEVICE_PLAY) {
+			*cfg = ssc->tx.dma.cfg_dma;
+			*reg = (void*)&ssc->addr->SSC_THR;
+			channel = ssc->tx.dma.channel;
+		} else {
+			*cfg = ssc->rx.dma.cfg_dma;
+			*reg = (void*)&ssc->addr->SSC_RHR;
+			channel = ssc->rx.dma.channel;
+		}
+		if (ssc->slot_length == 8)
+			cfg->data_width = DMA_DATA_WIDTH_BYTE;
+		else if (ssc->slot_length == 16)
+			cfg->data_width = DMA_DATA_WIDTH_HALF_WORD;
+		else
+			cfg->data_width = DMA_DATA_WIDTH_WORD;
+		return channel;
+	}
+#endif
+#if defined(CONFIG_HAVE_PDMIC)
+	case AUDIO_DEVICE_PDMIC:
+		if (desc->direction != AUDIO_DEVICE_RECORD)
+			return NULL;
+		*cfg = desc->device.pdmic.desc.rx.dma.cfg_dma;
+		if (desc->device.pdmic.desc.dsp_size == PDMIC_CONVERTED_DATA_SIZE_32)
+			cfg->data_width = DMA_DATA_WIDTH_WORD;
+		else
+			cfg->data_width = DMA_DATA_WIDTH_HALF_WORD;
+		*reg = (void*)&desc->device.pdmic.addr->PDMIC_CDR;
+		return desc->device.pdmic.desc.rx.dma.channel;
+#endif
+	default:
+		return NULL;
+	}
+}
+
+static uint8_t* _stream_period(struct _audio_stream *stream, uint32_t index)
+{
+	return stream->buffer + (index % stream->periods) * stream->period_size;
+}
+
+/**
+ * Called from the DMA interrupt at the end of each period of a stream.
+ */
+static int _stream_period_callback(void* arg, void* arg2)
+{
+	struct _audio_desc* desc = (struct _audio_desc*)arg;
+	struct _audio_stream* stream = &desc->stream;
+	uint8_t* period = _stream_period(stream, stream->hw);
+	bool xrun;
+	uint32_t level;
+
+	if (desc->direction == AUDIO_DEVICE_PLAY) {
+		/* Clear the period played, it is silence if not filled again */
+		memset(period, 0, stream->period_size);
+		cache_clean_region(period, stream->period_size);
+		stream->hw++;
+
+		/* Period 'hw' is being played, skip it if it was not filled */
+		xrun = stream->appl <= stream->hw;
+		if (xrun)
+			stream->appl = stream->hw + 1;
+		level = stream->appl - stream->hw;
+	} else {
+		cache_invalidate_region(period, stream->period_size);
+		stream->hw++;
+
+		/* Period 'hw' is being recorded over the oldest one */
+		xrun = stream->hw - stream->appl >= stream->periods;
+		if (xrun)
+			stream->appl = stream->hw - stream->periods + 1;
+		level = stream->hw - stream->appl;
+	}
+
+	if (xrun) {
+		if (!stream->xrun)
+			stream->stats.xruns++;
+		stream->stats.lost++;
+	}
+	stream->xrun = xrun;
+
+	stream->stats.periods++;
+	if (level < stream->stats.min_level)
+		stream->stats.min_level = level;
+	if (level > stream->stats.max_level)
+		stream->stats.max_level = level;
+
+	return callback_call(&stream->callback, desc);
+}
+
+static void _stream_reset_stats(struct _audio_stream *stream)
+{
+	memset(&stream->stats, 0, sizeof(stream->stats));
+	stream->stats.min_level = UINT32_MAX;
+}
+
 /**
  * Configure audio play/record
  */
@@ -495,3 +619,279 @@ void audio_sync_adjust(struct _audio_desc *desc, int32_t adjust)
 #endif
 #endif
 }
+
+int audio_stream_configure(struct _audio_desc *desc, void *buffer,
+		uint32_t period_size, uint8_t periods, struct _callback *cb)
+{
+	struct _audio_stream* stream = &desc->stream;
+	struct _dma_cfg cfg;
+	void* reg;
+
+	if (stream->running)
+		return -EBUSY;
+	if (!_stream_dma(desc, &cfg, &reg))
+		return -EINVAL;
+	if (!buffer || ((uint32_t)buffer & (L1_CACHE_BYTES - 1)))
+		return -EINVAL;
+	if (!period_size || (period_size & (L1_CACHE_BYTES - 1)))
+		return -EINVAL;
+	if ((period_size >> cfg.data_width) > DMA_MAX_BT_SIZE)
+		return -EINVAL;
+	if (periods < 2 || periods > CONFIG_AUDIO_STREAM_MAX_PERIODS)
+		return -EINVAL;
+
+	stream->buffer = (uint8_t*)buffer;
+	stream->period_size = period_size;
+	stream->periods = periods;
+	stream->hw = 0;
+	stream->appl = 0;
+	stream->reserved = 0;
+	stream->offset = 0;
+	stream->xrun = false;
+	callback_copy(&stream->callback, cb);
+	_stream_reset_stats(stream);
+
+	memset(buffer, 0, period_size * periods);
+	cache_clean_region(buffer, period_size * periods);
+
+	return 0;
+}
+
+int audio_stream_start(struct _audio_desc *desc)
+{
+	struct _audio_stream* stream = &desc->stream;
+	struct _dma_transfer_cfg list[CONFIG_AUDIO_STREAM_MAX_PERIODS];
+	struct _dma_channel* channel;
+	struct _dma_cfg cfg;
+	struct _callback _cb;
+	void* reg;
+	uint8_t i;
+	int err;
+
+	if (stream->running)
+		return -EBUSY;
+	channel = _stream_dma(desc, &cfg, &reg);
+	if (!channel || !stream->buffer)
+		return -EINVAL;
+
+	for (i = 0; i < stream->periods; i++) {
+		if (desc->direction == AUDIO_DEVICE_PLAY) {
+			list[i].saddr = _stream_period(stream, i);
+			list[i].daddr = reg;
+		} else {
+			list[i].saddr = reg;
+			list[i].daddr = _stream_period(stream, i);
+		}
+		list[i].len = stream->period_size >> cfg.data_width;
+	}
+	cfg.loop = true;
+
+	err = dma_configure_transfer(channel, &cfg, list, stream->periods);
+	if (err)
+		return err;
+	callback_set(&_cb, _stream_period_callback, desc);
+	dma_set_callback(channel, &_cb);
+
+	stream->running = true;
+	audio_enable(desc, true);
+	err = dma_start_transfer(channel);
+	if (err) {
+		audio_stream_stop(desc);
+		return err;
+	}
+	return 0;
+}
+
+void audio_stream_stop(struct _audio_desc *desc)
+{
+	audio_stop(desc);
+	audio_enable(desc, false);
+	desc->stream.running = false;
+}
+
+uint32_t audio_stream_avail(struct _audio_desc *desc)
+{
+	struct _audio_stream* stream = &desc->stream;
+
+	if (desc->direction == AUDIO_DEVICE_PLAY)
+		return stream->hw + stream->periods - stream->appl;
+	else
+		return stream->hw - stream->appl;
+}
+
+uint32_t audio_stream_get_level(struct _audio_desc *desc)
+{
+	struct _audio_stream* stream = &desc->stream;
+
+	if (desc->direction == AUDIO_DEVICE_PLAY)
+		return stream->appl - stream->hw;
+	else
+		return stream->hw - stream->appl;
+}
+
+/**
+ * Get the number of bytes of the current period already transferred by the
+ * DMA, and the index of this period.
+ * Must be called with interrupts disabled.
+ */
+static uint32_t _stream_position(struct _audio_desc *desc, uint32_t *hw)
+{
+	struct _audio_stream* stream = &desc->stream;
+	struct _dma_channel* channel;
+	struct _dma_cfg cfg;
+	void* reg;
+	uint32_t done = 0;
+
+	*hw = stream->hw;
+	channel = _stream_dma(desc, &cfg, &reg);
+	if (stream->running && channel) {
+		done = dma_get_transferred_data_len(channel, cfg.data_width,
+				stream->period_size);
+		/* period completed, its interrupt not yet handled */
+		if (done > stream->period_size)
+			done = stream->period_size;
+	}
+	return done;
+}
+
+uint32_t audio_stream_get_position(struct _audio_desc *desc)
+{
+	uint32_t flags, hw, done;
+
+	flags = arch_irq_save();
+	done = _stream_position(desc, &hw);
+	arch_irq_restore(flags);
+	return hw * desc->stream.period_size + done;
+}
+
+uint32_t audio_stream_get_delay(struct _audio_desc *desc)
+{
+	struct _audio_stream* stream = &desc->stream;
+	uint32_t flags, hw, done, partial, queued;
+
+	flags = arch_irq_save();
+	done = _stream_position(desc, &hw);
+	partial = stream->reserved == stream->appl ? stream->offset : 0;
+	if (desc->direction == AUDIO_DEVICE_PLAY) {
+		queued = (stream->appl - hw) * stream->period_size + partial;
+		queued = queued > done ? queued - done : 0;
+	} else {
+		queued = (hw - stream->appl) * stream->period_size + done;
+		queued = queued > partial ? queued - partial : 0;
+	}
+	arch_irq_restore(flags);
+	return queued;
+}
+
+void* audio_stream_get_period(struct _audio_desc *desc)
+{
+	struct _audio_stream* stream = &desc->stream;
+	uint32_t flags;
+	void* period = NULL;
+
+	flags = arch_irq_save();
+	if (audio_stream_avail(desc)) {
+		/* An xrun moved 'appl': the partial period is lost */
+		if (stream->reserved != stream->appl) {
+			stream->reserved = stream->appl;
+			stream->offset = 0;
+		}
+		period = _stream_period(stream, stream->appl);
+	}
+	arch_irq_restore(flags);
+	return period;
+}
+
+int audio_stream_put_period(struct _audio_desc *desc)
+{
+	struct _audio_stream* stream = &desc->stream;
+	uint32_t flags;
+	int err = 0;
+
+	if (desc->direction == AUDIO_DEVICE_PLAY)
+		cache_clean_region(_stream_period(stream, stream->reserved),
+				stream->period_size);
+
+	flags = arch_irq_save();
+	if (stream->reserved == stream->appl)
+		stream->appl++;
+	else
+		err = -EPIPE;
+	arch_irq_restore(flags);
+	return err;
+}
+
+uint32_t audio_stream_write(struct _audio_desc *desc, const void *data,
+		uint32_t size)
+{
+	struct _audio_stream* stream = &desc->stream;
+	const uint8_t* src = (const uint8_t*)data;
+	uint32_t done = 0, len;
+	uint8_t* period;
+
+	while (done < size) {
+		period = (uint8_t*)audio_stream_get_period(desc);
+		if (!period)
+			break;
+		len = stream->period_size - stream->offset;
+		if (len > size - done)
+			len = size - done;
+		memcpy(period + stream->offset, src + done, len);
+		stream->offset += len;
+		done += len;
+		if (stream->offset == stream->period_size) {
+			stream->offset = 0;
+			audio_stream_put_period(desc);
+		}
+	}
+	return done;
+}
+
+uint32_t audio_stream_read(struct _audio_desc *desc, void *data,
+		uint32_t size)
+{
+	struct _audio_stream* stream = &desc->stream;
+	uint8_t* dst = (uint8_t*)data;
+	uint32_t done = 0, len;
+	uint8_t* period;
+
+	while (done < size) {
+		period = (uint8_t*)audio_stream_get_period(desc);
+		if (!period)
+			break;
+		len = stream->period_size - stream->offset;
+		if (len > size - done)
+			len = size - done;
+		memcpy(dst + done, period + stream->offset, len);
+		stream->offset += len;
+		done += len;
+		if (stream->offset == stream->period_size) {
+			stream->offset = 0;
+			audio_stream_put_period(desc);
+		}
+	}
+	return done;
+}
+
+void audio_stream_get_stats(struct _audio_desc *desc,
+		struct _audio_stream_stats *stats, bool reset)
+{
+	struct _audio_stream* stream = &desc->stream;
+	uint32_t frame_size = desc->num_channels * desc->bits_per_sample / 8;
+	uint64_t period_ns = 0;
+	uint32_t flags;
+
+	flags = arch_irq_save();
+	*stats = stream->stats;
+	if (reset)
+		_stream_reset_stats(stream);
+	arch_irq_restore(flags);
+
+	if (!stats->periods)
+		stats->min_level = 0;
+	if (frame_size && desc->sample_rate)
+		period_ns = (uint64_t)stream->period_size * 1000000000ull /
+			((uint64_t)frame_size * desc->sample_rate);
+	stats->min_latency = (uint32_t)(stats->min_level * period_ns / 1000);
+	stats->max_latency = (uint32_t)(stats->max_level * period_ns / 1000);
+}
@@ -56,6 +56,11 @@
 
 #define AUDIO_PLAY_MAX_VOLUME    (100)
 
+/** Maximum number of periods of a stream ring */
+#ifndef CONFIG_AUDIO_STREAM_MAX_PERIODS
+#define CONFIG_AUDIO_STREAM_MAX_PERIODS 16
+#endif
+
 /*------------------------------------------------------------------------------
  *        Types
  *----------------------------------------------------------------------------*/
@@ -112,6 +117,36 @@ enum audio_device_direction {
 	AUDIO_DEVICE_RECORD,
 };
 
+/** Statistics of a stream, see audio_stream_get_stats() */
+struct _audio_stream_stats {
+	uint32_t periods;     /**< periods transferred by the DMA */
+	uint32_t xruns;       /**< underruns (play) or overruns (record) */
+	uint32_t lost;        /**< periods of silence played or recorded periods dropped */
+	uint32_t min_level;   /**< fewest periods queued when a period ended */
+	uint32_t max_level;   /**< most periods queued when a period ended */
+	uint32_t min_latency; /**< min_level as a delay, in microseconds */
+	uint32_t max_latency; /**< max_level as a delay, in microseconds */
+};
+
+/**
+ * Ring of periods continuously transferred by the DMA.  'hw' counts the
+ * periods ended, 'appl' the periods filled (play) or consumed (record) by the
+ * application; both are free running.
+ */
+struct _audio_stream {
+	uint8_t* buffer;
+	uint32_t period_size;
+	uint8_t periods;
+	bool running;
+	bool xrun;
+	volatile uint32_t hw;
+	volatile uint32_t appl;
+	uint32_t reserved;      /**< period returned by audio_stream_get_period() */
+	uint32_t offset;        /**< bytes of period 'appl' done by write/read */
+	struct _callback callback;
+	struct _audio_stream_stats stats;
+};
+
 struct _audio_desc {
 	enum audio_device_direction direction;
 	enum audio_device_type type;
@@ -143,6 +178,8 @@ struct _audio_desc {
 	uint16_t num_channels;
 	/* 8 bits = 8, 16 bits = 16, etc. */
 	uint16_t bits_per_sample;
+	/* Streaming state, see audio_stream_configure() */
+	struct _audio_stream stream;
 };
 
 
@@ -204,4 +241,115 @@ extern bool audio_transfer_is_done(struct _audio_desc *desc);
  */
 extern void audio_sync_adjust(struct _audio_desc *desc, int32_t adjust);
 
+/**
+ * \brief Set up a stream: a ring of periods transferred without gaps by a
+ * circular DMA list, in place of audio_transfer() calls.
+ *
+ * For playback, the application fills periods ahead of the DMA, and a period
+ * not filled in time is played as silence (an underrun): each period is
+ * cleared once played.  For recording, the application consumes the periods
+ * filled by the DMA, and the oldest period is dropped when the ring is full
+ * (an overrun).  Periods of a stream being configured can be filled before
+ * audio_stream_start().
+ *
+ * \param desc         Audio descriptor, configured with audio_configure()
+ * \param buffer       Ring of periods * period_size bytes, cache aligned
+ * \param period_size  Size of a period in bytes, multiple of the cache line
+ * \param periods      Number of periods, 2 to CONFIG_AUDIO_STREAM_MAX_PERIODS
+ * \param cb           Called from the DMA interrupt at the end of each
+ *                     period, may be NULL
+ * \return 0 on success, -EINVAL for bad parameters, -EBUSY if running
+ */
+extern int audio_stream_configure(struct _audio_desc *desc, void *buffer,
+		uint32_t period_size, uint8_t periods, struct _callback *cb);
+
+/**
+ * \brief Enable the device and start the transfer of the stream ring
+ * \param desc     Audio descriptor
+ * \return 0 on success, or an error code from the DMA driver
+ */
+extern int audio_stream_start(struct _audio_desc *desc);
+
+/**
+ * \brief Stop the transfer of the stream ring and disable the device
+ * \param desc     Audio descriptor
+ */
+extern void audio_stream_stop(struct _audio_desc *desc);
+
+/**
+ * \brief Number of periods the application can fill (play) or read (record)
+ * \param desc     Audio descriptor
+ */
+extern uint32_t audio_stream_avail(struct _audio_desc *desc);
+
+/**
+ * \brief Number of periods queued between the application and the DMA, i.e.
+ * the current latency in periods
+ * \param desc     Audio descriptor
+ */
+extern uint32_t audio_stream_get_level(struct _audio_desc *desc);
+
+/**
+ * \brief Number of bytes transferred by the DMA since the stream was
+ * configured, including the current period, wrapping at 2^32
+ * \param desc     Audio descriptor
+ * The position follows the clock of the device (codec or PDM clock). It may
+ * lag by one period when read while the period interrupt is pending, i.e.
+ * from an interrupt handler of same priority.
+ */
+extern uint32_t audio_stream_get_position(struct _audio_desc *desc);
+
+/**
+ * \brief Number of bytes queued between the application and the DMA
+ * position, i.e. the current latency in bytes
+ * \param desc     Audio descriptor
+ */
+extern uint32_t audio_stream_get_delay(struct _audio_desc *desc);
+
+/**
+ * \brief Get the next period to fill (play) or to read (record), for zero
+ * copy processing
+ * \param desc     Audio descriptor
+ * \return pointer to period_size bytes, or NULL if no period is available
+ */
+extern void* audio_stream_get_period(struct _audio_desc *desc);
+
+/**
+ * \brief Hand the period returned by audio_stream_get_period() back to the
+ * DMA
+ * \param desc     Audio descriptor
+ * \return 0 on success, -EPIPE if the period was skipped by an xrun in the
+ * meantime (its data is lost)
+ */
+extern int audio_stream_put_period(struct _audio_desc *desc);
+
+/**
+ * \brief Copy data to a playback stream
+ * \param desc     Audio descriptor
+ * \param data     Samples
+ * \param size     Size in bytes
+ * \return number of bytes copied, less than size if the ring is full
+ */
+extern uint32_t audio_stream_write(struct _audio_desc *desc, const void *data,
+		uint32_t size);
+
+/**
+ * \brief Copy data from a record stream
+ * \param desc     Audio descriptor
+ * \param data     Buffer for the samples
+ * \param size     Size in bytes
+ * \return number of bytes copied, less than size if the ring is empty
+ */
+extern uint32_t audio_stream_read(struct _audio_desc *desc, void *data,
+		uint32_t size);
+
+/**
+ * \brief Get the statistics of a stream
+ * \param desc     Audio descriptor
+ * \param stats    Filled with the statistics since start or last reset
+ * \param reset    Restart the statistics
+ */
+extern void audio_stream_get_stats(struct _audio_desc *desc,
+		struct _audio_stream_stats *stats, bool reset);
+
 #endif /* AUDIO_DEVICE_API_H */
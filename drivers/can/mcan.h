@@ -180,7 +180,7 @@ extern "C" {
 #define MCAN_RAM_E0_ESI (0x1u << 31) /**< \brief (E0) Error State Indicator */
 /* -------- MCAN Message RAM : Tx Event FIFO Element (E1) -------- */
 #define MCAN_RAM_E1_TXTS_Pos 0
-#define MCAN_RAM_E1_TXTS_Msk (0xffffu << MCAN_RAM_E1_RXTS_Pos) /**< \brief (E1) Tx Timestamp */
+#define MCAN_RAM_E1_TXTS_Msk (0xffffu << MCAN_RAM_E1_TXTS_Pos) /**< \brief (E1) Tx Timestamp */
 #define MCAN_RAM_E1_DLC_Pos 16
 #define MCAN_RAM_E1_DLC_Msk (0xfu << MCAN_RAM_E1_DLC_Pos) /**< \brief (E1) Data Length Code */
 #define MCAN_RAM_E1_DLC(value) ((MCAN_RAM_E1_DLC_Msk & ((value) << MCAN_RAM_E1_DLC_Pos)))
@@ -86,20 +86,19 @@ struct _mcan_quanta {
 /* size of our custom Rx and Tx Buffer Elements, in words */
 #define RAM_BUF_SIZE                  (MCAN_RAM_BUF_HDR_SIZE + 64u / 4)
 
-#define RAM_FILT_STD_CNT       (8u)
-#define RAM_FILT_EXT_CNT       (8u)
-#define RAM_RX_FIFO0_CNT       (12u)
-/* no Rx FIFO 1 in our Message RAM */
-#define RAM_RX_FIFO1_CNT       (0u)
-#define RAM_RX_BUF_CNT         (4u)
-/* no Tx Event FIFO in our Message RAM */
-#define RAM_TX_EVENT_CNT       (0u)
-#define RAM_TX_BUF_CNT         (4u)
-#define RAM_TX_FIFO_CNT        (4u)
+#define RAM_FILT_STD_CNT       (CONFIG_MCAND_FILT_STD_CNT)
+#define RAM_FILT_EXT_CNT       (CONFIG_MCAND_FILT_EXT_CNT)
+#define RAM_RX_FIFO0_CNT       (CONFIG_MCAND_RX_FIFO0_CNT)
+#define RAM_RX_FIFO1_CNT       (CONFIG_MCAND_RX_FIFO1_CNT)
+#define RAM_RX_BUF_CNT         (CONFIG_MCAND_RX_BUF_CNT)
+#define RAM_TX_EVENT_CNT       (CONFIG_MCAND_TX_EVENT_CNT)
+#define RAM_TX_BUF_CNT         (CONFIG_MCAND_TX_BUF_CNT)
+#define RAM_TX_FIFO_CNT        (CONFIG_MCAND_TX_FIFO_CNT)
 
 #define MSG_RAM_SIZE0      ( \
 	RAM_FILT_STD_CNT * MCAN_RAM_FILT_STD_SIZE \
 	+ RAM_FILT_EXT_CNT * MCAN_RAM_FILT_EXT_SIZE \
+	+ RAM_TX_EVENT_CNT * MCAN_RAM_TX_EVT_SIZE \
 	+ RAM_TX_BUF_CNT * RAM_BUF_SIZE \
 	+ RAM_TX_FIFO_CNT * RAM_BUF_SIZE )
 
@@ -114,6 +113,7 @@ struct _mcan_quanta {
 	+ RAM_RX_FIFO0_CNT \
 	+ RAM_RX_FIFO1_CNT \
 	+ RAM_RX_BUF_CNT \
+	+ RAM_TX_EVENT_CNT \
 	+ RAM_TX_BUF_CNT \
 	+ RAM_TX_FIFO_CNT)
 
@@ -145,7 +145,7 @@ static struct mcan_config mcan_cfg = {
 	.item_count[MCAN_RAM_TX_FIFO]	 = RAM_TX_FIFO_CNT,
 
 	.buf_size_rx_fifo0 = 64,
-	.buf_size_rx_fifo1 = 0,
+	.buf_size_rx_fifo1 = RAM_RX_FIFO1_CNT ? 64 : 0,
 	.buf_size_rx = 64,
 	.buf_size_tx = 64,
 };
@@ -353,6 +353,10 @@ static int mcan_initialize(struct _mcan_desc* desc, const struct mcan_config *cf
 	if (!mcan_set_tx_element_size(mcan, cfg->buf_size_tx))
 		return -EINVAL;
 
+	/* Timestamps and timeouts counted in nominal bit times */
+	mcan->MCAN_TSCC = MCAN_TSCC_TSS_TCP_INC | MCAN_TSCC_TCP(0);
+	mcan->MCAN_TOCC = MCAN_TOCC_ETOC_NO_TIMEOUT;
+
 	mcan->MCAN_NDAT1 = 0xFFFFFFFF;   /* clear new (rx) data flags */
 	mcan->MCAN_NDAT2 = 0xFFFFFFFF;   /* clear new (rx) data flags */
 
@@ -495,8 +499,6 @@ static void _mcand_tx_buffer_handler(struct _mcan_desc *desc)
 static void _mcand_tx_fifo_handler(struct _mcan_desc *desc)
 {
 	uint32_t fifo_idx;
-	uint32_t id;
-	uint32_t len;
 	struct _cand_ram_item *ram_item;
 	uint32_t *tx_fifo;
 	uint32_t fifo_start = desc->set.cfg.item_count[MCAN_RAM_TX_BUFFER];
@@ -506,7 +508,7 @@ static void _mcand_tx_fifo_handler(struct _mcan_desc *desc)
 	uint8_t get_index = (uint8_t)
 		((mcan->MCAN_TXFQS & MCAN_TXFQS_TFGI_Msk) >> MCAN_TXFQS_TFGI_Pos);
 	uint8_t put_index = (uint8_t)
-		((mcan->MCAN_TXFQS & MCAN_TXFQS_TFGI_Msk) >> MCAN_TXFQS_TFGI_Pos);
+		((mcan->MCAN_TXFQS & MCAN_TXFQS_TFQPI_Msk) >> MCAN_TXFQS_TFQPI_Pos);
 
 	get_index = (get_index == fifo_start) ? fifo_start + fifo_count - 1 : get_index - 1;
 
@@ -527,16 +529,6 @@ static void _mcand_tx_fifo_handler(struct _mcan_desc *desc)
 		if (tx_fifo[0] & MCAN_RAM_T0_RTR) {
 			// Remote Transmission Request
 		}
-		if (tx_fifo[0] & MCAN_RAM_T0_XTD)
-			id = (tx_fifo[0] & MCAN_RAM_T0_XTDID_Msk) >> MCAN_RAM_T0_XTDID_Pos;
-		else
-			id = (tx_fifo[0] & MCAN_RAM_T0_STDID_Msk) >> MCAN_RAM_T0_STDID_Pos;
-
-		len = get_data_length((enum mcan_dlc)
-				((tx_fifo[1] & MCAN_RAM_T1_DLC_Msk) >> MCAN_RAM_T1_DLC_Pos));
-		printf("tx_fifo idx=%u, id=0x%x, len=%u, data=%08x %08x\n\r",
-			(unsigned)fifo_idx, (unsigned)id, (unsigned)len,
-			(unsigned)tx_fifo[2], (unsigned)tx_fifo[3]);
 		if (ram_item->buf)
 			ram_item->buf->attr |= CAND_BUF_ATTR_TRANSFER_DONE;
 		else {
@@ -549,6 +541,21 @@ static void _mcand_tx_fifo_handler(struct _mcan_desc *desc)
 	}
 }
 
+static void _mcand_count_match(struct _mcan_desc *desc, const uint32_t *rx_buf)
+{
+	uint32_t filter_idx = (rx_buf[1] & MCAN_RAM_R1_FIDX_Msk) >> MCAN_RAM_R1_FIDX_Pos;
+
+	if (rx_buf[1] & MCAN_RAM_R1_ANMF)
+		desc->stats.rx_no_match++;
+	else if (rx_buf[0] & MCAN_RAM_R0_XTD) {
+		if (filter_idx < ARRAY_SIZE(desc->stats.filt_ext))
+			desc->stats.filt_ext[filter_idx]++;
+	} else {
+		if (filter_idx < ARRAY_SIZE(desc->stats.filt_std))
+			desc->stats.filt_std[filter_idx]++;
+	}
+}
+
 static void _mcand_rx_proc(struct _mcan_desc *desc, enum _mcan_ram ram, uint32_t buf_idx)
 {
 	uint32_t ram_idx =  desc->set.cfg.ram_index[ram];
@@ -590,6 +597,7 @@ static void _mcand_rx_proc(struct _mcan_desc *desc, enum _mcan_ram ram, uint32_t
 	}
 
 	filter_idx = (rx_buf[1] & MCAN_RAM_R1_FIDX_Msk) >> MCAN_RAM_R1_FIDX_Pos;
+	_mcand_count_match(desc, rx_buf);
 	len = get_data_length((enum mcan_dlc)
 			((rx_buf[1] & MCAN_RAM_R1_DLC_Msk) >> MCAN_RAM_R1_DLC_Pos));
 
@@ -670,6 +678,152 @@ static void _mcand_rx_fifo_handler(struct _mcan_desc *desc, enum _mcan_ram fifo)
 	}
 }
 
+/**
+ * \brief Get the fill level, the get index and the first element of a Rx FIFO.
+ * \return the size of a FIFO element, in words.
+ */
+static uint32_t _mcand_rx_fifo_status(struct _mcan_desc *desc, uint8_t fifo,
+		uint32_t *fill, uint32_t *get, uint32_t **ram)
+{
+	Mcan *mcan = desc->addr;
+	uint32_t status;
+
+	if (fifo == 0) {
+		status = mcan->MCAN_RXF0S;
+		*fill = (status & MCAN_RXF0S_F0FL_Msk) >> MCAN_RXF0S_F0FL_Pos;
+		*get = (status & MCAN_RXF0S_F0GI_Msk) >> MCAN_RXF0S_F0GI_Pos;
+		*ram = desc->set.ram_fifo_rx0;
+		return MCAN_RAM_BUF_HDR_SIZE + desc->set.cfg.buf_size_rx_fifo0 / 4;
+	} else {
+		status = mcan->MCAN_RXF1S;
+		*fill = (status & MCAN_RXF1S_F1FL_Msk) >> MCAN_RXF1S_F1FL_Pos;
+		*get = (status & MCAN_RXF1S_F1GI_Msk) >> MCAN_RXF1S_F1GI_Pos;
+		*ram = desc->set.ram_fifo_rx1;
+		return MCAN_RAM_BUF_HDR_SIZE + desc->set.cfg.buf_size_rx_fifo1 / 4;
+	}
+}
+
+static void _mcand_rx_decode(const uint32_t *rx_buf, uint32_t ram_size,
+		struct _mcan_msg *msg)
+{
+	uint32_t r0 = rx_buf[0];
+	uint32_t r1 = rx_buf[1];
+
+	msg->flags = 0;
+	if (r0 & MCAN_RAM_R0_XTD) {
+		msg->id = (r0 & MCAN_RAM_R0_XTDID_Msk) >> MCAN_RAM_R0_XTDID_Pos;
+		msg->flags |= MCAND_MSG_EXTENDED;
+	} else {
+		msg->id = (r0 & MCAN_RAM_R0_STDID_Msk) >> MCAN_RAM_R0_STDID_Pos;
+	}
+	if (r0 & MCAN_RAM_R0_RTR)
+		msg->flags |= MCAND_MSG_REMOTE;
+	if (r0 & MCAN_RAM_R0_ESI)
+		msg->flags |= MCAND_MSG_ESI;
+	if (r1 & MCAN_RAM_R1_FDF)
+		msg->flags |= MCAND_MSG_FD;
+	if (r1 & MCAN_RAM_R1_BRS)
+		msg->flags |= MCAND_MSG_BRS;
+
+	msg->data = (const uint8_t *)&rx_buf[2];
+	msg->len = get_data_length((enum mcan_dlc)
+			((r1 & MCAN_RAM_R1_DLC_Msk) >> MCAN_RAM_R1_DLC_Pos));
+	if (msg->len > ram_size)
+		msg->len = ram_size;
+	msg->timestamp = (r1 & MCAN_RAM_R1_RXTS_Msk) >> MCAN_RAM_R1_RXTS_Pos;
+	if (r1 & MCAN_RAM_R1_ANMF)
+		msg->filter = MCAND_FILTER_NONE;
+	else
+		msg->filter = (r1 & MCAN_RAM_R1_FIDX_Msk) >> MCAN_RAM_R1_FIDX_Pos;
+	msg->marker = 0;
+}
+
+/**
+ * \brief Hand the content of a Rx FIFO to its callback, by batches.
+ * Only the messages present on entry are handled, so that a busy bus cannot
+ * keep the handler running.
+ */
+static void _mcand_rx_fifo_stream(struct _mcan_desc *desc, uint8_t fifo)
+{
+	struct _mcan_batch batch;
+	uint32_t fill, get;
+	uint32_t *ram;
+
+	_mcand_rx_fifo_status(desc, fifo, &fill, &get, &ram);
+
+	batch.fifo = fifo;
+	batch.msgs = desc->batch;
+	while (fill) {
+		batch.count = mcand_rx_fifo_peek(desc, fifo, desc->batch,
+				fill < ARRAY_SIZE(desc->batch) ? fill : ARRAY_SIZE(desc->batch));
+		if (batch.count == 0)
+			break;
+		callback_call(&desc->rx_fifo_cb[fifo], &batch);
+		mcand_rx_fifo_release(desc, fifo, batch.count);
+		desc->stats.rx_batches[fifo]++;
+		fill -= batch.count;
+	}
+}
+
+/**
+ * \brief Hand the Tx events to the Tx FIFO callback, by batches, and release
+ * them with a single acknowledge per batch.
+ */
+static void _mcand_tx_event_handler(struct _mcan_desc *desc)
+{
+	Mcan *mcan = desc->addr;
+	struct _mcan_batch batch;
+	struct _mcan_msg *msg;
+	uint32_t status = mcan->MCAN_TXEFS;
+	uint32_t fill = (status & MCAN_TXEFS_EFFL_Msk) >> MCAN_TXEFS_EFFL_Pos;
+	uint32_t get = (status & MCAN_TXEFS_EFGI_Msk) >> MCAN_TXEFS_EFGI_Pos;
+	uint32_t total = desc->set.cfg.item_count[MCAN_RAM_TX_EVENT];
+	uint32_t last;
+	const uint32_t *evt;
+	uint32_t e0, e1;
+
+	batch.fifo = MCAND_TX_EVENT_FIFO;
+	batch.msgs = desc->batch;
+	while (fill) {
+		for (batch.count = 0; batch.count < fill &&
+				batch.count < ARRAY_SIZE(desc->batch); batch.count++) {
+			evt = desc->set.ram_fifo_tx_evt + get * MCAN_RAM_TX_EVT_SIZE;
+			e0 = evt[0];
+			e1 = evt[1];
+			msg = &desc->batch[batch.count];
+			msg->flags = 0;
+			if (e0 & MCAN_RAM_E0_XTD) {
+				msg->id = (e0 & MCAN_RAM_E0_XTDID_Msk) >> MCAN_RAM_E0_XTDID_Pos;
+				msg->flags |= MCAND_MSG_EXTENDED;
+			} else {
+				msg->id = (e0 & MCAN_RAM_E0_STDID_Msk) >> MCAN_RAM_E0_STDID_Pos;
+			}
+			if (e0 & MCAN_RAM_E0_RTR)
+				msg->flags |= MCAND_MSG_REMOTE;
+			if (e0 & MCAN_RAM_E0_ESI)
+				msg->flags |= MCAND_MSG_ESI;
+			if (e1 & MCAN_RAM_E1_FDF)
+				msg->flags |= MCAND_MSG_FD;
+			if (e1 & MCAN_RAM_E1_BRS)
+				msg->flags |= MCAND_MSG_BRS;
+			msg->data = NULL;
+			msg->len = get_data_length((enum mcan_dlc)
+					((e1 & MCAN_RAM_E1_DLC_Msk) >> MCAN_RAM_E1_DLC_Pos));
+			msg->timestamp = (e1 & MCAN_RAM_E1_TXTS_Msk) >> MCAN_RAM_E1_TXTS_Pos;
+			msg->filter = MCAND_FILTER_NONE;
+			msg->marker = (e1 & MCAN_RAM_E1_MM_Msk) >> MCAN_RAM_E1_MM_Pos;
+			last = get;
+			if (++get >= total)
+				get = 0;
+		}
+		callback_call(&desc->tx_event_cb, &batch);
+		/* release all the events of the batch at once */
+		mcan->MCAN_TXEFA = MCAN_TXEFA_EFAI(last);
+		desc->stats.tx_events += batch.count;
+		fill -= batch.count;
+	}
+}
+
 /**
  * Interrupt handler for MCAN Driver.
  */
@@ -703,39 +857,59 @@ static void _mcan_handler(uint32_t source, void* user_arg)
 	status = mcan_get_status(mcan);
 
 	dsb();
-	if (status & MCAN_IR_RF0N) {
-		mcan_clear_status(mcan, MCAN_IR_RF0N);
-		_mcand_rx_fifo_handler(desc, MCAN_RAM_RX_FIFO0);
-	}
-	if (status & MCAN_IR_RF1N) {
-		mcan_clear_status(mcan, MCAN_IR_RF1N);
-		_mcand_rx_fifo_handler(desc, MCAN_RAM_RX_FIFO1);
-	}
+	if (status & MCAN_IR_TOO)
+		mcan_clear_status(mcan, MCAN_IR_TOO);
 
+	if (status & MCAN_IR_RF0L) {
+		mcan_clear_status(mcan, MCAN_IR_RF0L);
+		desc->stats.rx_lost[0]++;
+		trace_warning("Receive FIFO 0 Message Lost\n\r");
+	}
 	if (status & MCAN_IR_RF0F) {
 		mcan_clear_status(mcan, MCAN_IR_RF0F);
-		trace_warning("Receive FIFO 0 Watermark Reached\n\r");
+		desc->stats.rx_full[0]++;
+		if (!desc->rx_fifo_cb[0].method)
+			trace_warning("Receive FIFO 0 Full\n\r");
 	}
 	if (status & MCAN_IR_RF0W) {
 		mcan_clear_status(mcan, MCAN_IR_RF0W);
-		trace_warning("Receive FIFO 0 Full\n\r");
+		if (!desc->rx_fifo_cb[0].method)
+			trace_warning("Receive FIFO 0 Watermark Reached\n\r");
 	}
-	if (status & MCAN_IR_RF0L) {
-		mcan_clear_status(mcan, MCAN_IR_RF0L);
-		trace_warning("Receive FIFO 0 Message Lost\n\r");
+	if (status & MCAN_IR_RF0N) {
+		mcan_clear_status(mcan, MCAN_IR_RF0N);
+		if (!desc->rx_fifo_cb[0].method)
+			_mcand_rx_fifo_handler(desc, MCAN_RAM_RX_FIFO0);
+	}
+	if (desc->rx_fifo_cb[0].method && (status & (MCAN_IR_RF0N
+			| MCAN_IR_RF0W | MCAN_IR_RF0F | MCAN_IR_TOO)))
+		_mcand_rx_fifo_stream(desc, 0);
+
+	if (status & MCAN_IR_RF1L) {
+		mcan_clear_status(mcan, MCAN_IR_RF1L);
+		desc->stats.rx_lost[1]++;
+		trace_warning("Receive FIFO 1 Message Lost\n\r");
 	}
 	if (status & MCAN_IR_RF1F) {
 		mcan_clear_status(mcan, MCAN_IR_RF1F);
-		trace_warning("Receive FIFO 1 Watermark Reached\n\r");
+		desc->stats.rx_full[1]++;
+		if (!desc->rx_fifo_cb[1].method)
+			trace_warning("Receive FIFO 1 Full\n\r");
 	}
 	if (status & MCAN_IR_RF1W) {
 		mcan_clear_status(mcan, MCAN_IR_RF1W);
-		trace_warning("Receive FIFO 1 Full\n\r");
+		if (!desc->rx_fifo_cb[1].method)
+			trace_warning("Receive FIFO 1 Watermark Reached\n\r");
 	}
-	if (status & MCAN_IR_RF1L) {
-		mcan_clear_status(mcan, MCAN_IR_RF1L);
-		trace_warning("Receive FIFO 1 Message Lost\n\r");
+	if (status & MCAN_IR_RF1N) {
+		mcan_clear_status(mcan, MCAN_IR_RF1N);
+		if (!desc->rx_fifo_cb[1].method)
+			_mcand_rx_fifo_handler(desc, MCAN_RAM_RX_FIFO1);
 	}
+	if (desc->rx_fifo_cb[1].method && (status & (MCAN_IR_RF1N
+			| MCAN_IR_RF1W | MCAN_IR_RF1F | MCAN_IR_TOO)))
+		_mcand_rx_fifo_stream(desc, 1);
+
 	if (status & MCAN_IR_HPM) {
 		mcan_clear_status(mcan, MCAN_IR_HPM);
 		trace_warning("High priority message received\n\r");
@@ -756,20 +930,27 @@ static void _mcan_handler(uint32_t source, void* user_arg)
 	}
 	if (status & MCAN_IR_TEFN) {
 		mcan_clear_status(mcan, MCAN_IR_TEFN);
-		trace_info(" Tx Handler wrote Tx Event FIFO element\n\r");
+		if (!desc->tx_event_cb.method)
+			trace_info(" Tx Handler wrote Tx Event FIFO element\n\r");
 	}
 	if (status & MCAN_IR_TEFW) {
 		mcan_clear_status(mcan, MCAN_IR_TEFW);
-		trace_info("Tx Event FIFO fill level reached watermark\n\r");
+		if (!desc->tx_event_cb.method)
+			trace_info("Tx Event FIFO fill level reached watermark\n\r");
 	}
 	if (status & MCAN_IR_TEFF) {
 		mcan_clear_status(mcan, MCAN_IR_TEFF);
-		trace_info("Tx Event FIFO full\n\r");
+		if (!desc->tx_event_cb.method)
+			trace_info("Tx Event FIFO full\n\r");
 	}
 	if (status & MCAN_IR_TEFL) {
 		mcan_clear_status(mcan, MCAN_IR_TEFL);
+		desc->stats.tx_events_lost++;
 		trace_info("Tx Event FIFO element lost\n\r");
 	}
+	if (desc->tx_event_cb.method && (status & (MCAN_IR_TEFN
+			| MCAN_IR_TEFW | MCAN_IR_TEFF)))
+		_mcand_tx_event_handler(desc);
 	if (status & MCAN_IR_TSW) {
 		mcan_clear_status(mcan, MCAN_IR_TSW);
 		trace_info("Timestamp counter wrapped around\n\r");
@@ -1249,3 +1430,289 @@ int mcand_transfer(struct _mcan_desc *desc, struct _buffer *buf,
 		return mcand_rx(desc, buf, cb);
 	return -EINVAL;
 }
+
+int mcand_add_filter(struct _mcan_desc* desc, uint32_t id, uint32_t mask,
+		uint8_t flags, uint8_t fifo)
+{
+	struct mcan_set *set = &desc->set;
+	uint32_t *filter;
+	uint8_t filt_idx;
+	int status;
+
+	if (fifo > 1 || set->cfg.item_count[fifo ? MCAN_RAM_RX_FIFO1 : MCAN_RAM_RX_FIFO0] == 0)
+		return -EINVAL;
+
+	if (flags & MCAND_MSG_EXTENDED) {
+		status = mcand_get_ram(desc, MCAN_RAM_EXT_FILTER, &filt_idx);
+		if (status < 0)
+			return status;
+		filter = set->ram_filt_ext + filt_idx * MCAN_RAM_FILT_EXT_SIZE;
+		filter[1] = MCAN_RAM_F1_EFT_CLASSIC | MCAN_RAM_F1_EFID2(mask);
+		dsb();
+		filter[0] = (fifo ? MCAN_RAM_F0_EFEC_FIFO1 : MCAN_RAM_F0_EFEC_FIFO0)
+			| MCAN_RAM_F0_EFID1(id);
+	} else {
+		status = mcand_get_ram(desc, MCAN_RAM_STD_FILTER, &filt_idx);
+		if (status < 0)
+			return status;
+		filter = set->ram_filt_std + filt_idx * MCAN_RAM_FILT_STD_SIZE;
+		filter[0] = MCAN_RAM_S0_SFT_CLASSIC
+			| (fifo ? MCAN_RAM_S0_SFEC_FIFO1 : MCAN_RAM_S0_SFEC_FIFO0)
+			| MCAN_RAM_S0_SFID1(id) | MCAN_RAM_S0_SFID2(mask);
+	}
+	dsb();
+
+	return filt_idx;
+}
+
+void mcand_remove_filter(struct _mcan_desc* desc, uint8_t filter, uint8_t flags)
+{
+	if (flags & MCAND_MSG_EXTENDED)
+		mcand_release_ram(desc, MCAN_RAM_EXT_FILTER, filter);
+	else
+		mcand_release_ram(desc, MCAN_RAM_STD_FILTER, filter);
+	dsb();
+}
+
+int mcand_rx_fifo_start(struct _mcan_desc* desc, uint8_t fifo,
+		uint8_t watermark, uint16_t timeout, struct _callback* cb)
+{
+	Mcan *mcan = desc->addr;
+	uint32_t tocc, tos, it;
+	uint8_t total;
+
+	if (fifo > 1)
+		return -EINVAL;
+	total = desc->set.cfg.item_count[fifo ? MCAN_RAM_RX_FIFO1 : MCAN_RAM_RX_FIFO0];
+	if (total == 0 || watermark >= total)
+		return -EINVAL;
+	if (watermark < 2)
+		watermark = 0;
+	/* a batch below the watermark would wait forever */
+	if (cb && watermark && !timeout)
+		return -EINVAL;
+	/* FIFO and timeout configuration registers are write-protected */
+	if (mcan_is_enabled(mcan))
+		return -EBUSY;
+	mcan_reconfigure(mcan);
+
+	tos = fifo ? MCAN_TOCC_TOS_RX1_EV_TIMEOUT : MCAN_TOCC_TOS_RX0_EV_TIMEOUT;
+	tocc = mcan->MCAN_TOCC;
+	if (cb && watermark) {
+		if ((tocc & MCAN_TOCC_ETOC) && (tocc & MCAN_TOCC_TOS_Msk) != tos)
+			return -EBUSY;
+		mcan->MCAN_TOCC = MCAN_TOCC_ETOC_TOS_CONTROLLED | tos
+			| MCAN_TOCC_TOP(timeout);
+	} else if ((tocc & MCAN_TOCC_ETOC) && (tocc & MCAN_TOCC_TOS_Msk) == tos) {
+		mcan->MCAN_TOCC = MCAN_TOCC_ETOC_NO_TIMEOUT;
+	}
+
+	/* blocking mode: new messages are lost when the FIFO is full, the
+	 * unread ones are never overwritten */
+	if (fifo == 0) {
+		mcan->MCAN_RXF0C = (mcan->MCAN_RXF0C
+			& ~(MCAN_RXF0C_F0WM_Msk | MCAN_RXF0C_F0OM))
+			| MCAN_RXF0C_F0WM(watermark);
+		it = MCAN_IE_RF0FE | MCAN_IE_RF0LE;
+		if (cb)
+			it |= watermark ? (MCAN_IE_RF0WE | MCAN_IE_TOOE) : MCAN_IE_RF0NE;
+		mcan_disable_it(mcan, MCAN_IE_RF0NE | MCAN_IE_RF0WE);
+		mcan_clear_status(mcan, MCAN_IR_RF0N | MCAN_IR_RF0W
+				| MCAN_IR_RF0F | MCAN_IR_RF0L);
+	} else {
+		mcan->MCAN_RXF1C = (mcan->MCAN_RXF1C
+			& ~(MCAN_RXF1C_F1WM_Msk | MCAN_RXF1C_F1OM))
+			| MCAN_RXF1C_F1WM(watermark);
+		it = MCAN_IE_RF1FE | MCAN_IE_RF1LE;
+		if (cb)
+			it |= watermark ? (MCAN_IE_RF1WE | MCAN_IE_TOOE) : MCAN_IE_RF1NE;
+		mcan_disable_it(mcan, MCAN_IE_RF1NE | MCAN_IE_RF1WE);
+		mcan_clear_status(mcan, MCAN_IR_RF1N | MCAN_IR_RF1W
+				| MCAN_IR_RF1F | MCAN_IR_RF1L);
+	}
+
+	callback_copy(&desc->rx_fifo_cb[fifo], cb);
+	mcan_enable_it(mcan, it);
+
+	return 0;
+}
+
+void mcand_rx_fifo_stop(struct _mcan_desc* desc, uint8_t fifo)
+{
+	Mcan *mcan = desc->addr;
+
+	assert(fifo < 2);
+
+	if (fifo == 0)
+		mcan_disable_it(mcan, MCAN_IE_RF0NE | MCAN_IE_RF0WE
+				| MCAN_IE_RF0FE | MCAN_IE_RF0LE);
+	else
+		mcan_disable_it(mcan, MCAN_IE_RF1NE | MCAN_IE_RF1WE
+				| MCAN_IE_RF1FE | MCAN_IE_RF1LE);
+	if ((mcan->MCAN_TOCC & MCAN_TOCC_TOS_Msk) ==
+			(fifo ? MCAN_TOCC_TOS_RX1_EV_TIMEOUT : MCAN_TOCC_TOS_RX0_EV_TIMEOUT))
+		mcan_disable_it(mcan, MCAN_IE_TOOE);
+	callback_copy(&desc->rx_fifo_cb[fifo], NULL);
+}
+
+uint8_t mcand_rx_fifo_peek(struct _mcan_desc* desc, uint8_t fifo,
+		struct _mcan_msg* msgs, uint8_t max)
+{
+	uint32_t fill, get, elem_size, total, i;
+	uint32_t *ram;
+
+	assert(fifo < 2);
+
+	elem_size = _mcand_rx_fifo_status(desc, fifo, &fill, &get, &ram);
+	total = desc->set.cfg.item_count[fifo ? MCAN_RAM_RX_FIFO1 : MCAN_RAM_RX_FIFO0];
+
+	for (i = 0; i < fill && i < max; i++) {
+		_mcand_rx_decode(ram + get * elem_size,
+				(elem_size - MCAN_RAM_BUF_HDR_SIZE) * 4, &msgs[i]);
+		if (++get >= total)
+			get = 0;
+	}
+	return i;
+}
+
+void mcand_rx_fifo_release(struct _mcan_desc* desc, uint8_t fifo, uint8_t count)
+{
+	uint32_t fill, get, elem_size, total, i;
+	uint32_t *ram;
+
+	assert(fifo < 2);
+
+	elem_size = _mcand_rx_fifo_status(desc, fifo, &fill, &get, &ram);
+	total = desc->set.cfg.item_count[fifo ? MCAN_RAM_RX_FIFO1 : MCAN_RAM_RX_FIFO0];
+	if (count > fill)
+		count = fill;
+	if (count == 0)
+		return;
+
+	for (i = 0; i < count; i++) {
+		_mcand_count_match(desc, ram + get * elem_size);
+		if (++get >= total)
+			get = 0;
+	}
+	desc->stats.rx_msgs[fifo] += count;
+
+	/* acknowledging the last element releases all the previous ones */
+	get = get ? get - 1 : total - 1;
+	if (fifo == 0)
+		mcan_rx_fifo0_ack(desc->addr, get);
+	else
+		mcan_rx_fifo1_ack(desc->addr, get);
+}
+
+int mcand_tx_fifo_start(struct _mcan_desc* desc, uint8_t watermark,
+		struct _callback* cb)
+{
+	Mcan *mcan = desc->addr;
+	uint8_t total = desc->set.cfg.item_count[MCAN_RAM_TX_EVENT];
+
+	if (total == 0 || desc->set.cfg.item_count[MCAN_RAM_TX_FIFO] == 0
+			|| watermark > total)
+		return -EINVAL;
+	if (watermark < 2)
+		watermark = 0;
+	if (mcan_is_enabled(mcan))
+		return -EBUSY;
+	mcan_reconfigure(mcan);
+
+	mcan->MCAN_TXEFC = (mcan->MCAN_TXEFC & ~MCAN_TXEFC_EFWM_Msk)
+		| MCAN_TXEFC_EFWM(watermark);
+	mcan_clear_status(mcan, MCAN_IR_TEFN | MCAN_IR_TEFW
+			| MCAN_IR_TEFF | MCAN_IR_TEFL);
+	callback_copy(&desc->tx_event_cb, cb);
+	mcan_disable_it(mcan, MCAN_IE_TEFNE | MCAN_IE_TEFWE);
+	/* the Tx Event FIFO holds as many events as the Tx FIFO holds
+	 * messages at most, full events are only reported at the watermark */
+	mcan_enable_it(mcan, MCAN_IE_TEFFE | MCAN_IE_TEFLE
+			| (watermark ? MCAN_IE_TEFWE : MCAN_IE_TEFNE));
+
+	return 0;
+}
+
+uint8_t mcand_tx_fifo_free(struct _mcan_desc* desc)
+{
+	return (desc->addr->MCAN_TXFQS & MCAN_TXFQS_TFFL_Msk) >> MCAN_TXFQS_TFFL_Pos;
+}
+
+uint8_t* mcand_tx_fifo_get_buffer(struct _mcan_desc* desc, uint32_t id,
+		uint8_t flags, uint8_t len, uint8_t marker)
+{
+	struct mcan_set *set = &desc->set;
+	Mcan *mcan = desc->addr;
+	const enum can_mode mode = mcan_get_mode(mcan);
+	uint32_t status = mcan->MCAN_TXFQS;
+	uint32_t put_idx;
+	uint32_t *tx_buf;
+	uint32_t val;
+	enum mcan_dlc dlc;
+
+	if (set->cfg.item_count[MCAN_RAM_TX_FIFO] == 0 || (status & MCAN_TXFQS_TFQF))
+		return NULL;
+	if (len > set->cfg.buf_size_tx || !mcan_get_length_code(len, &dlc))
+		return NULL;
+
+	/* the put index counts the dedicated Tx Buffers too */
+	put_idx = (status & MCAN_TXFQS_TFQPI_Msk) >> MCAN_TXFQS_TFQPI_Pos;
+	tx_buf = set->ram_array_tx + put_idx
+		* (MCAN_RAM_BUF_HDR_SIZE + set->cfg.buf_size_tx / 4);
+
+	if (flags & MCAND_MSG_EXTENDED)
+		val = MCAN_RAM_T0_XTD | MCAN_RAM_T0_XTDID(id);
+	else
+		val = MCAN_RAM_T0_STDID(id);
+	if (flags & MCAND_MSG_REMOTE)
+		val |= MCAN_RAM_T0_RTR;
+	tx_buf[0] = val;
+
+	val = MCAN_RAM_T1_MM(marker) | MCAN_RAM_T1_DLC((uint32_t)dlc);
+	if (desc->tx_event_cb.method)
+		val |= MCAN_RAM_T1_EFC;
+	if (mode == CAN_MODE_CAN_FD_CONST_RATE)
+		val |= MCAN_RAM_T1_FDF;
+	else if (mode == CAN_MODE_CAN_FD_DUAL_RATE)
+		val |= MCAN_RAM_T1_FDF | MCAN_RAM_T1_BRS;
+	tx_buf[1] = val;
+
+	return (uint8_t *)&tx_buf[2];
+}
+
+void mcand_tx_fifo_submit(struct _mcan_desc* desc)
+{
+	Mcan *mcan = desc->addr;
+	uint32_t put_idx = (mcan->MCAN_TXFQS & MCAN_TXFQS_TFQPI_Msk)
+		>> MCAN_TXFQS_TFQPI_Pos;
+
+	dsb();
+	mcan->MCAN_TXBAR = (1 << put_idx);
+	desc->stats.tx_queued++;
+}
+
+int mcand_tx_fifo_send(struct _mcan_desc* desc, const struct _mcan_msg* msg)
+{
+	uint8_t *data;
+
+	if (mcand_tx_fifo_free(desc) == 0)
+		return -EBUSY;
+	data = mcand_tx_fifo_get_buffer(desc, msg->id, msg->flags, msg->len,
+			msg->marker);
+	if (!data)
+		return -EINVAL;
+	memcpy(data, msg->data, msg->len);
+	mcand_tx_fifo_submit(desc);
+
+	return 0;
+}
+
+const struct _mcan_stats* mcand_get_stats(struct _mcan_desc* desc)
+{
+	return &desc->stats;
+}
+
+void mcand_clear_stats(struct _mcan_desc* desc)
+{
+	memset(&desc->stats, 0, sizeof(desc->stats));
+}
@@ -41,6 +41,50 @@
  *        Definitions
  *----------------------------------------------------------------------------*/
 
+/* Number of elements of each Message RAM section, for each MCAN instance */
+#ifndef CONFIG_MCAND_FILT_STD_CNT
+#define CONFIG_MCAND_FILT_STD_CNT 8
+#endif
+#ifndef CONFIG_MCAND_FILT_EXT_CNT
+#define CONFIG_MCAND_FILT_EXT_CNT 8
+#endif
+#ifndef CONFIG_MCAND_RX_FIFO0_CNT
+#define CONFIG_MCAND_RX_FIFO0_CNT 24
+#endif
+#ifndef CONFIG_MCAND_RX_FIFO1_CNT
+#define CONFIG_MCAND_RX_FIFO1_CNT 0
+#endif
+#ifndef CONFIG_MCAND_RX_BUF_CNT
+#define CONFIG_MCAND_RX_BUF_CNT 4
+#endif
+#ifndef CONFIG_MCAND_TX_BUF_CNT
+#define CONFIG_MCAND_TX_BUF_CNT 4
+#endif
+#ifndef CONFIG_MCAND_TX_FIFO_CNT
+#define CONFIG_MCAND_TX_FIFO_CNT 8
+#endif
+#ifndef CONFIG_MCAND_TX_EVENT_CNT
+#define CONFIG_MCAND_TX_EVENT_CNT CONFIG_MCAND_TX_FIFO_CNT
+#endif
+
+/* Maximum number of messages handed to a FIFO callback at once */
+#ifndef CONFIG_MCAND_BATCH_SIZE
+#define CONFIG_MCAND_BATCH_SIZE 16
+#endif
+
+/* Flags of struct _mcan_msg */
+#define MCAND_MSG_EXTENDED   0x01 /* 29-bit identifier */
+#define MCAND_MSG_REMOTE     0x02 /* remote frame */
+#define MCAND_MSG_FD         0x04 /* CAN FD format */
+#define MCAND_MSG_BRS        0x08 /* bit rate switching */
+#define MCAND_MSG_ESI        0x10 /* transmitter was error passive */
+
+/* Filter index of messages accepted without matching any filter */
+#define MCAND_FILTER_NONE    0xff
+
+/* FIFO index of the batches built from the Tx Event FIFO */
+#define MCAND_TX_EVENT_FIFO  2
+
 /*----------------------------------------------------------------------------
  *        Types
  *----------------------------------------------------------------------------*/
@@ -63,6 +107,38 @@ enum _mcan_ram {
 	MCAN_RAM_TOTAL      = 15,
 };
 
+/** Message in a Rx FIFO or event from the Tx Event FIFO */
+struct _mcan_msg {
+	uint32_t id;          /**< 11 or 29-bit identifier */
+	const uint8_t* data;  /**< payload; received messages point into the
+	                       *   Message RAM until released */
+	uint16_t timestamp;   /**< Rx or Tx timestamp, in nominal bit times */
+	uint8_t len;          /**< payload length, in bytes */
+	uint8_t flags;        /**< MCAND_MSG_xxx flags */
+	uint8_t filter;       /**< matching filter element (Rx only) */
+	uint8_t marker;       /**< message marker (Tx events only) */
+};
+
+/** Argument passed to the FIFO callbacks */
+struct _mcan_batch {
+	uint8_t fifo;                 /**< Rx FIFO 0/1 or MCAND_TX_EVENT_FIFO */
+	uint8_t count;                /**< number of messages */
+	const struct _mcan_msg* msgs; /**< messages, in reception order */
+};
+
+struct _mcan_stats {
+	uint32_t rx_msgs[2];      /* messages released from Rx FIFO 0/1 */
+	uint32_t rx_batches[2];   /* batches handed to the Rx FIFO callbacks */
+	uint32_t rx_full[2];      /* Rx FIFO full events */
+	uint32_t rx_lost[2];      /* Rx FIFO message lost events */
+	uint32_t rx_no_match;     /* messages accepted without filter match */
+	uint32_t tx_queued;       /* messages queued in the Tx FIFO */
+	uint32_t tx_events;       /* Tx Event FIFO elements read */
+	uint32_t tx_events_lost;  /* Tx Event FIFO element lost events */
+	uint32_t filt_std[CONFIG_MCAND_FILT_STD_CNT]; /* matches per filter */
+	uint32_t filt_ext[CONFIG_MCAND_FILT_EXT_CNT];
+};
+
 struct mcan_config
 {
 	uint32_t *msg_ram[2];           /* base address of the Message RAM to be
@@ -110,6 +186,11 @@ struct _mcan_desc {
 
 	struct _cand_ram_item * ram_item;
 	struct mcan_set set;
+
+	struct _callback rx_fifo_cb[2];  /**< Rx FIFO batch callbacks */
+	struct _callback tx_event_cb;    /**< Tx Event FIFO batch callback */
+	struct _mcan_msg batch[CONFIG_MCAND_BATCH_SIZE];
+	struct _mcan_stats stats;
 };
 
 /*----------------------------------------------------------------------------
@@ -127,5 +208,112 @@ extern int mcand_configure(struct _mcan_desc* desc);
  */
 extern int mcand_transfer(struct _mcan_desc* desc, struct _buffer *buf,
 			  struct _callback* cb);
+
+/**
+ * \brief Add a classic (identifier and mask) filter element storing the
+ * matching messages in a Rx FIFO.
+ * \param desc  Pointer to CAN Driver descriptor instance.
+ * \param id    Identifier to match.
+ * \param mask  Bits of the identifier to compare.
+ * \param flags MCAND_MSG_EXTENDED for a 29-bit filter, 0 otherwise.
+ * \param fifo  Rx FIFO (0 or 1).
+ * \return the filter element index (reported in struct _mcan_msg and counted
+ * in struct _mcan_stats), or a negative error code.
+ */
+extern int mcand_add_filter(struct _mcan_desc* desc, uint32_t id,
+			    uint32_t mask, uint8_t flags, uint8_t fifo);
+
+/**
+ * \brief Disable a filter element added by mcand_add_filter().
+ */
+extern void mcand_remove_filter(struct _mcan_desc* desc, uint8_t filter,
+				uint8_t flags);
+
+/**
+ * \brief Start batched reception on a Rx FIFO.
+ * The callback is called from the interrupt handler with a struct _mcan_batch
+ * as second argument, once the FIFO fill level reaches the watermark or once
+ * the oldest message waited for the timeout. Messages point into the Message
+ * RAM and are released all at once when the callback returns.
+ * Without callback, the FIFO is read with mcand_rx_fifo_peek() and
+ * mcand_rx_fifo_release().
+ * The MCAN must be in initialization mode (not activated).
+ * \param desc       Pointer to CAN Driver descriptor instance.
+ * \param fifo       Rx FIFO (0 or 1).
+ * \param watermark  Fill level triggering the callback, 0 or 1 to trigger it
+ * for each new message.
+ * \param timeout    Maximum wait of a message below the watermark, in nominal
+ * bit times. Only one Rx FIFO can use a timeout.
+ * \param cb         Batch callback, or NULL.
+ * \return 0 on success, a negative error code otherwise.
+ */
+extern int mcand_rx_fifo_start(struct _mcan_desc* desc, uint8_t fifo,
+			       uint8_t watermark, uint16_t timeout,
+			       struct _callback* cb);
+
+/**
+ * \brief Stop batched reception on a Rx FIFO.
+ */
+extern void mcand_rx_fifo_stop(struct _mcan_desc* desc, uint8_t fifo);
+
+/**
+ * \brief Get the oldest messages of a Rx FIFO without copying them.
+ * \return the number of messages stored in msgs.
+ */
+extern uint8_t mcand_rx_fifo_peek(struct _mcan_desc* desc, uint8_t fifo,
+				  struct _mcan_msg* msgs, uint8_t max);
+
+/**
+ * \brief Release the oldest messages of a Rx FIFO with a single acknowledge.
+ */
+extern void mcand_rx_fifo_release(struct _mcan_desc* desc, uint8_t fifo,
+				  uint8_t count);
+
+/**
+ * \brief Track the completion of the messages queued in the Tx FIFO.
+ * The callback is called from the interrupt handler with a struct _mcan_batch
+ * of Tx events (identifier, length, timestamp and message marker).
+ * The MCAN must be in initialization mode (not activated).
+ * \param desc       Pointer to CAN Driver descriptor instance.
+ * \param watermark  Number of events triggering the callback, 0 or 1 to
+ * trigger it for each event.
+ * \param cb         Batch callback.
+ * \return 0 on success, a negative error code otherwise.
+ */
+extern int mcand_tx_fifo_start(struct _mcan_desc* desc, uint8_t watermark,
+			       struct _callback* cb);
+
+/**
+ * \brief Get the number of free elements in the Tx FIFO.
+ */
+extern uint8_t mcand_tx_fifo_free(struct _mcan_desc* desc);
+
+/**
+ * \brief Get the data field of the next Tx FIFO element to fill it in place.
+ * The message is sent by mcand_tx_fifo_submit().
+ * \return pointer into the Message RAM, or NULL if the FIFO is full or the
+ * length is not valid.
+ */
+extern uint8_t* mcand_tx_fifo_get_buffer(struct _mcan_desc* desc, uint32_t id,
+					 uint8_t flags, uint8_t len,
+					 uint8_t marker);
+
+/**
+ * \brief Request transmission of the element filled after
+ * mcand_tx_fifo_get_buffer().
+ */
+extern void mcand_tx_fifo_submit(struct _mcan_desc* desc);
+
+/**
+ * \brief Queue a message in the Tx FIFO.
+ * \return 0 on success, -EBUSY if the FIFO is full, -EINVAL if the length is
+ * not valid.
+ */
+extern int mcand_tx_fifo_send(struct _mcan_desc* desc,
+			      const struct _mcan_msg* msg);
+
+extern const struct _mcan_stats* mcand_get_stats(struct _mcan_desc* desc);
+
+extern void mcand_clear_stats(struct _mcan_desc* desc);
 /**@}*/
 #endif /* #ifndef _MCAN_H_ */
@@ -0,0 +1,945 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "compiler.h"
+#include "fastmem.h"
+#include "intmath.h"
+
+#include "display/gfx.h"
+
+#ifdef CONFIG_ARCH_ARM
+#include "mm/cache.h"
+#endif
+
+#if defined(CONFIG_HAVE_XDMAC) || defined(CONFIG_HAVE_DMAC)
+#include "dma/dma.h"
+#define GFX_DMA
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Rows per DMA transfer, one scatter-gather item each */
+#define GFX_DMA_ROWS 32
+
+/** Run count of the glyphs too complex to be cached as runs */
+#define GLYPH_UNCACHEABLE 0xff
+
+/*----------------------------------------------------------------------------
+ *        Local types
+ *----------------------------------------------------------------------------*/
+
+struct _glyph_run {
+	uint8_t x;
+	uint8_t y;
+	uint8_t len;
+};
+
+struct _glyph {
+	const struct _gfx_font* font;
+	uint8_t c;
+	uint8_t count;
+	struct _glyph_run runs[GFX_GLYPH_MAX_RUNS];
+};
+
+#ifdef GFX_DMA
+/** State of the DMA fills and copies, shared by all surfaces */
+struct _gfx_dma {
+	struct _dma_channel* channel;  /**< reserved on first use */
+	bool busy;
+	uint8_t* start;                /**< region written by the transfer */
+	uint32_t len;
+	uint32_t rows;                 /**< rows handled since startup */
+};
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Two-way set associative, so that the printable ASCII characters (95)
+ * do not conflict with the default size */
+static struct _glyph _glyph_cache[CONFIG_GFX_GLYPH_CACHE_SIZE / 2][2];
+
+/** Way to replace next in each set */
+static uint8_t _glyph_victim[CONFIG_GFX_GLYPH_CACHE_SIZE / 2];
+
+#ifdef GFX_DMA
+static struct _gfx_dma _gfx_dma;
+
+/** Source of the DMA fills */
+CACHE_ALIGNED static uint32_t _gfx_pattern[L1_CACHE_BYTES / 4];
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static void _clean(const void* start, uint32_t len)
+{
+#ifdef CONFIG_ARCH_ARM
+	cache_clean_region(start, len);
+#else
+	(void)start;
+	(void)len;
+#endif
+}
+
+static inline uint8_t* _pixel_address(const struct _gfx_surface* surface,
+		int x, int y)
+{
+	return surface->buffer + y * (int)surface->stride + x * (surface->bpp / 8);
+}
+
+/**
+ * \brief Clip a rectangle to a surface
+ *
+ * The offsets (ox, oy) are moved by the amount clipped on the top-left side,
+ * they locate the matching pixel in a source image.
+ *
+ * \return false if nothing is left to draw
+ */
+static bool _clip_offset(const struct _gfx_surface* surface, int* x, int* y,
+		int* w, int* h, int* ox, int* oy)
+{
+	if (*x < 0) {
+		*ox -= *x;
+		*w += *x;
+		*x = 0;
+	}
+	if (*y < 0) {
+		*oy -= *y;
+		*h += *y;
+		*y = 0;
+	}
+	if (*w > surface->width - *x)
+		*w = surface->width - *x;
+	if (*h > surface->height - *y)
+		*h = surface->height - *y;
+	return *w > 0 && *h > 0;
+}
+
+static bool _clip(const struct _gfx_surface* surface, int* x, int* y,
+		int* w, int* h)
+{
+	int ox = 0, oy = 0;
+
+	return _clip_offset(surface, x, y, w, h, &ox, &oy);
+}
+
+/**
+ * \brief Add a clipped rectangle to the dirty rectangles of a surface
+ *
+ * The rectangle is merged with a dirty rectangle when their union is not
+ * larger than both, otherwise it takes a free slot.  When all slots are
+ * used, it is merged with the rectangle growing the least.
+ */
+static void _mark_dirty(struct _gfx_surface* surface, int x, int y,
+		int w, int h)
+{
+	struct _gfx_rect* r;
+	int32_t growth, best_growth = INT32_MAX;
+	int ux, uy, ux1, uy1;
+	uint8_t i, best = 0;
+
+	for (i = 0; i < surface->dirty_count; i++) {
+		r = &surface->dirty[i];
+		ux = min_u32(r->x, x);
+		uy = min_u32(r->y, y);
+		ux1 = max_u32(r->x + r->w, x + w);
+		uy1 = max_u32(r->y + r->h, y + h);
+		growth = (ux1 - ux) * (uy1 - uy) - r->w * r->h - w * h;
+		if (growth < best_growth) {
+			best_growth = growth;
+			best = i;
+		}
+		if (growth <= 0)
+			break;
+	}
+
+	if (best_growth > 0 && surface->dirty_count < GFX_DIRTY_RECTS) {
+		r = &surface->dirty[surface->dirty_count++];
+		r->x = x;
+		r->y = y;
+		r->w = w;
+		r->h = h;
+		return;
+	}
+
+	r = &surface->dirty[best];
+	ux = min_u32(r->x, x);
+	uy = min_u32(r->y, y);
+	ux1 = max_u32(r->x + r->w, x + w);
+	uy1 = max_u32(r->y + r->h, y + h);
+	r->x = ux;
+	r->y = uy;
+	r->w = ux1 - ux;
+	r->h = uy1 - uy;
+}
+
+static inline uint32_t _get_pixel(const uint8_t* p, uint8_t bpp)
+{
+	switch (bpp) {
+	case 16:
+		return *(const uint16_t*)p;
+	case 24:
+		return p[0] | (p[1] << 8) | (p[2] << 16);
+	default:
+		return *(const uint32_t*)p;
+	}
+}
+
+static inline void _put_pixel(uint8_t* p, uint8_t bpp, uint32_t color)
+{
+	switch (bpp) {
+	case 16:
+		*(uint16_t*)p = color;
+		break;
+	case 24:
+		p[0] = color;
+		p[1] = color >> 8;
+		p[2] = color >> 16;
+		break;
+	default:
+		*(uint32_t*)p = color;
+		break;
+	}
+}
+
+/**
+ * \brief Fill a row of pixels with word stores
+ */
+static void _fill_row(uint8_t* p, uint8_t bpp, int w, uint32_t color)
+{
+	uint32_t* wp;
+	uint32_t w0, w1, w2;
+
+	switch (bpp) {
+	case 16:
+		color &= 0xffff;
+		if ((uintptr_t)p & 2) {
+			*(uint16_t*)p = color;
+			p += 2;
+			w--;
+		}
+		fast_memset32(p, color | (color << 16), w * 2);
+		break;
+	case 24:
+		for (; w && ((uintptr_t)p & 3); w--) {
+			_put_pixel(p, 24, color);
+			p += 3;
+		}
+		/* 4 pixels in 3 words */
+		color &= 0xffffff;
+		w0 = color | (color << 24);
+		w1 = (color >> 8) | (color << 16);
+		w2 = (color >> 16) | (color << 8);
+		for (wp = (uint32_t*)p; w >= 4; w -= 4) {
+			wp[0] = w0;
+			wp[1] = w1;
+			wp[2] = w2;
+			wp += 3;
+		}
+		for (p = (uint8_t*)wp; w; w--) {
+			_put_pixel(p, 24, color);
+			p += 3;
+		}
+		break;
+	default:
+		fast_memset32(p, color, w * 4);
+		break;
+	}
+}
+
+/**
+ * \brief Fill a rectangle with the CPU, without dirty tracking
+ */
+static void _fill(struct _gfx_surface* surface, int x, int y, int w, int h,
+		uint32_t color)
+{
+	uint8_t* p;
+
+	if (!_clip(surface, &x, &y, &w, &h))
+		return;
+
+	p = _pixel_address(surface, x, y);
+	for (; h; h--) {
+		_fill_row(p, surface->bpp, w, color);
+		p += surface->stride;
+	}
+}
+
+/**
+ * \brief Alpha blend (ARGB8888) a row of pixels
+ *
+ * \param src  Source pixels, or color for a constant blend
+ * \param inc  1 to blend an image row, 0 for a constant blend
+ */
+static void _blend_row(uint8_t* p, uint8_t bpp, const uint32_t* src,
+		uint32_t inc, int w)
+{
+	uint32_t s, d, a, rb, g, da;
+
+	for (; w; w--, src += inc) {
+		s = *src;
+		a = s >> 24;
+		if (a == 0) {
+			p += bpp / 8;
+			continue;
+		}
+		/* scale to 0..256 so that opaque is exact */
+		a += a >> 7;
+
+		switch (bpp) {
+		case 16:
+			/* RGB565 spread as 0000_0ggg_ggg0_0000_rrrr_r000_000b_bbbb */
+			s = ((s >> 8) & 0xf800) | ((s >> 5) & 0x07e0) | ((s >> 3) & 0x001f);
+			s = (s | (s << 16)) & 0x07e0f81f;
+			d = *(uint16_t*)p;
+			d = (d | (d << 16)) & 0x07e0f81f;
+			d = (d + (((s - d) * (a >> 3)) >> 5)) & 0x07e0f81f;
+			*(uint16_t*)p = d | (d >> 16);
+			p += 2;
+			break;
+		case 24:
+			d = _get_pixel(p, 24);
+			rb = ((s & 0xff00ff) * a + (d & 0xff00ff) * (256 - a)) >> 8;
+			g = ((s & 0x00ff00) * a + (d & 0x00ff00) * (256 - a)) >> 8;
+			_put_pixel(p, 24, (rb & 0xff00ff) | (g & 0x00ff00));
+			p += 3;
+			break;
+		default:
+			d = *(uint32_t*)p;
+			rb = ((s & 0xff00ff) * a + (d & 0xff00ff) * (256 - a)) >> 8;
+			g = ((s & 0x00ff00) * a + (d & 0x00ff00) * (256 - a)) >> 8;
+			da = (d >> 24) * (256 - a) >> 8;
+			*(uint32_t*)p = (rb & 0xff00ff) | (g & 0x00ff00)
+			              | (((a - (a >> 8)) + da) << 24);
+			p += 4;
+			break;
+		}
+	}
+}
+
+#ifdef GFX_DMA
+/**
+ * \brief Wait for the pending DMA transfer, then drop the cache lines it
+ * wrote
+ */
+static void _dma_wait(void)
+{
+	if (!_gfx_dma.busy)
+		return;
+
+	while (!dma_is_transfer_done(_gfx_dma.channel))
+		dma_poll();
+	/* releases the scatter-gather items */
+	dma_reset_channel(_gfx_dma.channel);
+	cache_invalidate_region(_gfx_dma.start, _gfx_dma.len);
+	_gfx_dma.busy = false;
+}
+
+/**
+ * \brief Fill or copy rows with the DMA
+ *
+ * The region covering the destination rows is cleaned before the transfer
+ * (so that no dirty line is evicted over the DMA data) and invalidated once
+ * it completes.  The last batch of rows is left in progress.
+ *
+ * \param surface     Destination surface
+ * \param dst         First pixel of the first destination row
+ * \param src         First pixel of the first source row, NULL to fill with
+ *                    _gfx_pattern
+ * \param src_stride  Distance between the source rows, in bytes
+ * \param bytes       Bytes per row
+ * \param h           Number of rows
+ * \return the number of rows handled, 0 if the DMA is not used
+ */
+static int _dma_rows(struct _gfx_surface* surface, uint8_t* dst,
+		const uint8_t* src, uint32_t src_stride, uint32_t bytes, int h)
+{
+	struct _dma_transfer_cfg rows[GFX_DMA_ROWS];
+	struct _dma_cfg cfg;
+	uint32_t align, span;
+	int i, n, done;
+
+	if (!surface->dma || bytes * h < CONFIG_GFX_DMA_THRESHOLD)
+		return 0;
+
+	if (!_gfx_dma.channel) {
+		_gfx_dma.channel = dma_allocate_channel(DMA_PERIPH_MEMORY,
+		                                        DMA_PERIPH_MEMORY);
+		if (!_gfx_dma.channel)
+			return 0;
+	}
+
+	/* widest data width allowed by the rows alignment */
+	align = (uint32_t)dst | surface->stride | bytes;
+	if (src)
+		align |= (uint32_t)src | src_stride;
+	memset(&cfg, 0, sizeof(cfg));
+	if ((align & 3) == 0)
+		cfg.data_width = DMA_DATA_WIDTH_WORD;
+	else if ((align & 1) == 0)
+		cfg.data_width = DMA_DATA_WIDTH_HALF_WORD;
+	else
+		cfg.data_width = DMA_DATA_WIDTH_BYTE;
+	cfg.chunk_size = DMA_CHUNK_SIZE_1;
+	cfg.incr_saddr = src != NULL;
+	cfg.incr_daddr = true;
+
+	if (!src)
+		cache_clean_region(_gfx_pattern, sizeof(_gfx_pattern));
+
+	for (done = 0; done < h; done += n) {
+		n = min_u32(h - done, GFX_DMA_ROWS);
+		for (i = 0; i < n; i++) {
+			rows[i].saddr = src ? src + i * src_stride : (const void*)_gfx_pattern;
+			rows[i].daddr = dst + i * surface->stride;
+			rows[i].len = bytes >> cfg.data_width;
+		}
+
+		_dma_wait();
+		if (dma_configure_transfer(_gfx_dma.channel, &cfg, rows, n) < 0)
+			break;
+
+		span = (n - 1) * surface->stride + bytes;
+		if (src)
+			cache_clean_region(src, (n - 1) * src_stride + bytes);
+		cache_clean_region(dst, span);
+
+		_gfx_dma.start = dst;
+		_gfx_dma.len = span;
+		_gfx_dma.busy = true;
+		if (dma_start_transfer(_gfx_dma.channel) < 0) {
+			_gfx_dma.busy = false;
+			dma_reset_channel(_gfx_dma.channel);
+			break;
+		}
+
+		_gfx_dma.rows += n;
+		dst += n * surface->stride;
+		if (src)
+			src += n * src_stride;
+	}
+
+	return done;
+}
+#else
+static inline void _dma_wait(void)
+{
+}
+#endif
+
+/**
+ * \brief Copy clipped rows, with the DMA for large ones
+ */
+static void _copy_rows(struct _gfx_surface* surface, int x, int y,
+		const uint8_t* src, uint32_t src_stride, int w, int h)
+{
+	uint8_t* dst = _pixel_address(surface, x, y);
+	uint32_t bytes = w * (surface->bpp / 8);
+	int done = 0;
+
+#ifdef GFX_DMA
+	done = _dma_rows(surface, dst, src, src_stride, bytes, h);
+	if (done == h)
+		return;
+	dst += done * surface->stride;
+	src += done * src_stride;
+#endif
+	_mark_dirty(surface, x, y + done, w, h - done);
+
+	if (bytes == surface->stride && bytes == src_stride) {
+		fast_memcpy(dst, src, bytes * (h - done));
+		return;
+	}
+	for (; done < h; done++) {
+		fast_memcpy(dst, src, bytes);
+		dst += surface->stride;
+		src += src_stride;
+	}
+}
+
+/**
+ * \brief Get a glyph from the cache, decoding it on a miss
+ */
+static struct _glyph* _glyph_get(const struct _gfx_font* font, uint8_t c)
+{
+	struct _glyph* glyph;
+	uint32_t set;
+	uint8_t x, y, start;
+
+	set = (c - 0x20 + ((uintptr_t)font >> 2)) % ARRAY_SIZE(_glyph_cache);
+	glyph = _glyph_cache[set];
+	if (glyph[0].font == font && glyph[0].c == c) {
+		_glyph_victim[set] = 1;
+		return &glyph[0];
+	}
+	if (glyph[1].font == font && glyph[1].c == c) {
+		_glyph_victim[set] = 0;
+		return &glyph[1];
+	}
+
+	glyph = &glyph[_glyph_victim[set]];
+	_glyph_victim[set] ^= 1;
+	glyph->font = font;
+	glyph->c = c;
+	glyph->count = 0;
+	for (y = 0; y < font->height; y++) {
+		x = 0;
+		while (x < font->width) {
+			if (!font->pixel(font, c, x, y)) {
+				x++;
+				continue;
+			}
+			start = x;
+			while (x < font->width && font->pixel(font, c, x, y))
+				x++;
+			if (glyph->count == GFX_GLYPH_MAX_RUNS) {
+				glyph->count = GLYPH_UNCACHEABLE;
+				return glyph;
+			}
+			glyph->runs[glyph->count].x = start;
+			glyph->runs[glyph->count].y = y;
+			glyph->runs[glyph->count].len = x - start;
+			glyph->count++;
+		}
+	}
+	return glyph;
+}
+
+/**
+ * \brief Draw the runs of a cached glyph lying entirely in the surface
+ *
+ * Runs are a few pixels long, they are stored inline rather than through
+ * the row fill.
+ */
+static void _draw_runs(struct _gfx_surface* surface, int x, int y,
+		const struct _glyph* glyph, uint32_t color)
+{
+	const struct _glyph_run* run = glyph->runs;
+	const struct _glyph_run* end = run + glyph->count;
+	uint8_t* base = _pixel_address(surface, x, y);
+	uint8_t* p;
+	uint8_t n;
+
+	switch (surface->bpp) {
+	case 16:
+		for (; run < end; run++) {
+			uint16_t* p16 = (uint16_t*)(base + run->y * surface->stride) + run->x;
+			for (n = run->len; n; n--)
+				*p16++ = color;
+		}
+		break;
+	case 24:
+		for (; run < end; run++) {
+			p = base + run->y * surface->stride + run->x * 3;
+			for (n = run->len; n; n--) {
+				p[0] = color;
+				p[1] = color >> 8;
+				p[2] = color >> 16;
+				p += 3;
+			}
+		}
+		break;
+	default:
+		for (; run < end; run++) {
+			uint32_t* p32 = (uint32_t*)(base + run->y * surface->stride) + run->x;
+			for (n = run->len; n; n--)
+				*p32++ = color;
+		}
+		break;
+	}
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+int gfx_surface_initialize(struct _gfx_surface* surface, void* buffer,
+		uint16_t width, uint16_t height, uint8_t bpp)
+{
+	if (bpp != 16 && bpp != 24 && bpp != 32)
+		return -EINVAL;
+
+	surface->buffer = (uint8_t*)buffer;
+	surface->width = width;
+	surface->height = height;
+	surface->bpp = bpp;
+	/* word aligned rows */
+	surface->stride = ((width * bpp / 8) + 3) & ~3;
+	surface->dma = false;
+	surface->dirty_count = 0;
+	return 0;
+}
+
+void gfx_enable_dma(struct _gfx_surface* surface, bool enable)
+{
+#ifdef GFX_DMA
+	_dma_wait();
+	surface->dma = enable;
+#else
+	(void)enable;
+#endif
+}
+
+void gfx_sync(void)
+{
+	_dma_wait();
+}
+
+uint32_t gfx_get_dma_rows(void)
+{
+#ifdef GFX_DMA
+	return _gfx_dma.rows;
+#else
+	return 0;
+#endif
+}
+
+uint32_t gfx_color(const struct _gfx_surface* surface, uint32_t argb)
+{
+	switch (surface->bpp) {
+	case 16:
+		return ((argb >> 8) & 0xf800) | ((argb >> 5) & 0x07e0)
+		     | ((argb >> 3) & 0x001f);
+	case 24:
+		return argb & 0xffffff;
+	default:
+		return argb;
+	}
+}
+
+void gfx_draw_pixel(struct _gfx_surface* surface, int x, int y,
+		uint32_t color)
+{
+	_dma_wait();
+	if ((unsigned)x >= surface->width || (unsigned)y >= surface->height)
+		return;
+	_put_pixel(_pixel_address(surface, x, y), surface->bpp, color);
+	_mark_dirty(surface, x, y, 1, 1);
+}
+
+uint32_t gfx_read_pixel(struct _gfx_surface* surface, int x, int y)
+{
+	_dma_wait();
+	if ((unsigned)x >= surface->width || (unsigned)y >= surface->height)
+		return 0;
+	return _get_pixel(_pixel_address(surface, x, y), surface->bpp);
+}
+
+void gfx_fill_rect(struct _gfx_surface* surface, int x, int y, int w, int h,
+		uint32_t color)
+{
+	int done = 0;
+
+	_dma_wait();
+	if (!_clip(surface, &x, &y, &w, &h))
+		return;
+
+#ifdef GFX_DMA
+	/* 24 bpp patterns do not fit in a word */
+	if (surface->bpp != 24) {
+		if (surface->bpp == 16)
+			_gfx_pattern[0] = (color & 0xffff) * 0x10001;
+		else
+			_gfx_pattern[0] = color;
+		done = _dma_rows(surface, _pixel_address(surface, x, y), NULL, 0,
+		                 w * (surface->bpp / 8), h);
+		if (done == h)
+			return;
+	}
+#endif
+	_mark_dirty(surface, x, y + done, w, h - done);
+	_fill(surface, x, y + done, w, h - done, color);
+}
+
+void gfx_draw_rect(struct _gfx_surface* surface, int x, int y, int w, int h,
+		uint32_t color)
+{
+	if (w <= 0 || h <= 0)
+		return;
+
+	gfx_fill_rect(surface, x, y, w, 1, color);
+	gfx_fill_rect(surface, x, y + h - 1, w, 1, color);
+	gfx_fill_rect(surface, x, y + 1, 1, h - 2, color);
+	gfx_fill_rect(surface, x + w - 1, y + 1, 1, h - 2, color);
+}
+
+void gfx_draw_line(struct _gfx_surface* surface, int x0, int y0,
+		int x1, int y1, uint32_t color)
+{
+	int dx = x1 > x0 ? x1 - x0 : x0 - x1;
+	int dy = y1 > y0 ? y1 - y0 : y0 - y1;
+	int sx = x0 < x1 ? 1 : -1;
+	int sy = y0 < y1 ? 1 : -1;
+	int cw = surface->bpp / 8;
+	int err = dx - dy;
+	int e2, bx, by, bw, bh;
+	uint8_t* p;
+
+	if (dx == 0 || dy == 0) {
+		gfx_fill_rect(surface, x0 < x1 ? x0 : x1, y0 < y1 ? y0 : y1,
+		              dx + 1, dy + 1, color);
+		return;
+	}
+
+	_dma_wait();
+	bx = x0 < x1 ? x0 : x1;
+	by = y0 < y1 ? y0 : y1;
+	bw = dx + 1;
+	bh = dy + 1;
+	if (!_clip(surface, &bx, &by, &bw, &bh))
+		return;
+	_mark_dirty(surface, bx, by, bw, bh);
+
+	/* Bresenham, stepping the pixel address along */
+	p = _pixel_address(surface, x0, y0);
+	while (1) {
+		if ((unsigned)x0 < surface->width && (unsigned)y0 < surface->height)
+			_put_pixel(p, surface->bpp, color);
+		if (x0 == x1 && y0 == y1)
+			break;
+		e2 = 2 * err;
+		if (e2 > -dy) {
+			err -= dy;
+			x0 += sx;
+			p += sx * cw;
+		}
+		if (e2 < dx) {
+			err += dx;
+			y0 += sy;
+			p += sy * (int)surface->stride;
+		}
+	}
+}
+
+void gfx_blit(struct _gfx_surface* surface, int x, int y, const void* image,
+		uint32_t stride, int w, int h)
+{
+	int ox = 0, oy = 0;
+
+	_dma_wait();
+	if (!_clip_offset(surface, &x, &y, &w, &h, &ox, &oy))
+		return;
+
+	_copy_rows(surface, x, y, (const uint8_t*)image + oy * stride
+	           + ox * (surface->bpp / 8), stride, w, h);
+}
+
+void gfx_copy_rect(struct _gfx_surface* dst, int dx, int dy,
+		struct _gfx_surface* src, int sx, int sy, int w, int h)
+{
+	uint32_t bytes;
+	uint8_t* d;
+	const uint8_t* s;
+
+	if (dst->bpp != src->bpp)
+		return;
+
+	_dma_wait();
+	if (!_clip_offset(src, &sx, &sy, &w, &h, &dx, &dy))
+		return;
+	if (!_clip_offset(dst, &dx, &dy, &w, &h, &sx, &sy))
+		return;
+
+	if (dst->buffer != src->buffer) {
+		_copy_rows(dst, dx, dy, _pixel_address(src, sx, sy), src->stride,
+		           w, h);
+		return;
+	}
+
+	/* same surface: rows may overlap, copy them away from the overlap */
+	_mark_dirty(dst, dx, dy, w, h);
+	bytes = w * (dst->bpp / 8);
+	if (dy > sy) {
+		d = _pixel_address(dst, dx, dy + h - 1);
+		s = _pixel_address(src, sx, sy + h - 1);
+		for (; h; h--) {
+			fast_memmove(d, s, bytes);
+			d -= dst->stride;
+			s -= src->stride;
+		}
+	} else {
+		d = _pixel_address(dst, dx, dy);
+		s = _pixel_address(src, sx, sy);
+		for (; h; h--) {
+			fast_memmove(d, s, bytes);
+			d += dst->stride;
+			s += src->stride;
+		}
+	}
+}
+
+void gfx_blend_rect(struct _gfx_surface* surface, int x, int y, int w, int h,
+		uint32_t argb)
+{
+	uint8_t* p;
+
+	if ((argb >> 24) == 0xff) {
+		gfx_fill_rect(surface, x, y, w, h, gfx_color(surface, argb));
+		return;
+	}
+
+	_dma_wait();
+	if ((argb >> 24) == 0 || !_clip(surface, &x, &y, &w, &h))
+		return;
+	_mark_dirty(surface, x, y, w, h);
+
+	p = _pixel_address(surface, x, y);
+	for (; h; h--) {
+		_blend_row(p, surface->bpp, &argb, 0, w);
+		p += surface->stride;
+	}
+}
+
+void gfx_blit_argb(struct _gfx_surface* surface, int x, int y,
+		const uint32_t* image, uint32_t stride, int w, int h)
+{
+	int ox = 0, oy = 0;
+	uint8_t* p;
+
+	_dma_wait();
+	if (!_clip_offset(surface, &x, &y, &w, &h, &ox, &oy))
+		return;
+	_mark_dirty(surface, x, y, w, h);
+
+	p = _pixel_address(surface, x, y);
+	image += oy * stride + ox;
+	for (; h; h--) {
+		_blend_row(p, surface->bpp, image, 1, w);
+		p += surface->stride;
+		image += stride;
+	}
+}
+
+void gfx_draw_char(struct _gfx_surface* surface, int x, int y,
+		const struct _gfx_font* font, uint8_t c, uint32_t color,
+		uint32_t bgcolor, bool opaque)
+{
+	struct _glyph* glyph;
+	int bx = x, by = y, bw = font->width, bh = font->height;
+	uint8_t i, px, py;
+
+	_dma_wait();
+	if (!_clip(surface, &bx, &by, &bw, &bh))
+		return;
+	_mark_dirty(surface, bx, by, bw, bh);
+
+	if (opaque)
+		_fill(surface, x, y, font->width, font->height, bgcolor);
+
+	glyph = _glyph_get(font, c);
+	if (glyph->count != GLYPH_UNCACHEABLE) {
+		if (bx == x && by == y && bw == font->width && bh == font->height) {
+			_draw_runs(surface, x, y, glyph, color);
+			return;
+		}
+		for (i = 0; i < glyph->count; i++)
+			_fill(surface, x + glyph->runs[i].x, y + glyph->runs[i].y,
+			      glyph->runs[i].len, 1, color);
+		return;
+	}
+
+	for (py = 0; py < font->height; py++)
+		for (px = 0; px < font->width; px++)
+			if (font->pixel(font, c, px, py))
+				_fill(surface, x + px, y + py, 1, 1, color);
+}
+
+void gfx_draw_string(struct _gfx_surface* surface, int x, int y,
+		const struct _gfx_font* font, const char* str, uint32_t color,
+		uint32_t bgcolor, bool opaque)
+{
+	int xorg = x;
+
+	for (; *str; str++) {
+		if (*str == '\n') {
+			y += font->height + font->spacing;
+			x = xorg;
+		} else {
+			gfx_draw_char(surface, x, y, font, *str, color, bgcolor,
+			              opaque);
+			x += font->width + font->spacing;
+		}
+	}
+}
+
+void gfx_glyph_cache_flush(const struct _gfx_font* font)
+{
+	uint32_t i, way;
+
+	for (i = 0; i < ARRAY_SIZE(_glyph_cache); i++)
+		for (way = 0; way < 2; way++)
+			if (!font || _glyph_cache[i][way].font == font)
+				_glyph_cache[i][way].font = NULL;
+}
+
+void gfx_invalidate(struct _gfx_surface* surface, int x, int y, int w, int h)
+{
+	if (_clip(surface, &x, &y, &w, &h))
+		_mark_dirty(surface, x, y, w, h);
+}
+
+void gfx_flush(struct _gfx_surface* surface)
+{
+	struct _gfx_rect* r;
+	uint32_t len;
+	uint8_t* p;
+	uint8_t i;
+	int y;
+
+	_dma_wait();
+
+	for (i = 0; i < surface->dirty_count; i++) {
+		r = &surface->dirty[i];
+		p = _pixel_address(surface, r->x, r->y);
+		len = r->w * (surface->bpp / 8);
+		/* one region for wide rectangles, row by row otherwise */
+		if (r->h == 1 || 2 * len >= surface->stride) {
+			_clean(p, (r->h - 1) * surface->stride + len);
+		} else {
+			for (y = 0; y < r->h; y++) {
+				_clean(p, len);
+				p += surface->stride;
+			}
+		}
+	}
+	surface->dirty_count = 0;
+}
@@ -0,0 +1,263 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * 2D drawing on memory framebuffers (LCDC canvas, off-screen surfaces).
+ *
+ * Rows are filled and copied with word and burst stores (NEON when
+ * available, see fastmem.h) instead of per-pixel writes.  Large fills and
+ * copies can be offloaded to the DMA (mem2mem, one scatter-gather item per
+ * row); they are asynchronous and every other drawing function waits for
+ * them, so the CPU only needs gfx_sync() before accessing the pixels by
+ * itself.
+ *
+ * Rectangles written by the CPU are recorded as dirty, gfx_flush() then
+ * cleans only the cache lines of these rectangles before the display
+ * controller fetches the frame.
+ *
+ * Pixel formats are 16 bpp (RGB565), 24 bpp (RGB888) and 32 bpp (ARGB8888),
+ * colors given as 'native' are written as-is in the pixel bytes
+ * (little-endian), ARGB colors are 0xAARRGGBB.
+ */
+
+#ifndef GFX_H_
+#define GFX_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Fills and copies smaller than this are done by the CPU, in bytes */
+#ifndef CONFIG_GFX_DMA_THRESHOLD
+#define CONFIG_GFX_DMA_THRESHOLD 4096
+#endif
+
+/** Number of glyphs in the glyph cache, the default holds the printable
+ * ASCII characters of one font */
+#ifndef CONFIG_GFX_GLYPH_CACHE_SIZE
+#define CONFIG_GFX_GLYPH_CACHE_SIZE 96
+#endif
+
+/** Number of dirty rectangles tracked per surface */
+#define GFX_DIRTY_RECTS 4
+
+/** Maximum number of horizontal runs of a cached glyph */
+#define GFX_GLYPH_MAX_RUNS 48
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+struct _gfx_rect {
+	int16_t x;
+	int16_t y;
+	uint16_t w;
+	uint16_t h;
+};
+
+struct _gfx_surface {
+	uint8_t* buffer;   /**< first pixel, word aligned */
+	uint16_t width;    /**< width in pixels */
+	uint16_t height;   /**< height in pixels */
+	uint32_t stride;   /**< distance between rows, in bytes */
+	uint8_t bpp;       /**< 16, 24 or 32 */
+	bool dma;          /**< offload large fills and copies to the DMA */
+
+	/* private */
+	uint8_t dirty_count;
+	struct _gfx_rect dirty[GFX_DIRTY_RECTS];
+};
+
+/**
+ * \brief Bitmap font
+ *
+ * Glyphs are read through the 'pixel' callback when they are first drawn,
+ * then drawn from the glyph cache as horizontal runs, so the font data can
+ * use any layout.
+ */
+struct _gfx_font {
+	uint8_t width;     /**< glyph width in pixels */
+	uint8_t height;    /**< glyph height in pixels */
+	uint8_t spacing;   /**< space between glyphs and lines, in pixels */
+	const void* data;  /**< font data, for the pixel callback */
+	/** tells if pixel (x, y) of the glyph of character 'c' is set */
+	bool (*pixel)(const struct _gfx_font* font, uint8_t c, uint8_t x,
+			uint8_t y);
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize a surface on a framebuffer
+ *
+ * Rows are word aligned, as for LCDC layers.  DMA is disabled.
+ *
+ * \param surface  Surface to initialize
+ * \param buffer   Framebuffer, word aligned
+ * \param width    Width in pixels
+ * \param height   Height in pixels
+ * \param bpp      Bits per pixel: 16, 24 or 32
+ * \return 0 on success, -EINVAL if the format is not supported
+ */
+extern int gfx_surface_initialize(struct _gfx_surface* surface, void* buffer,
+		uint16_t width, uint16_t height, uint8_t bpp);
+
+/**
+ * \brief Enable or disable DMA fills and copies on a surface
+ *
+ * Ignored on devices without DMA.  The framebuffer must be cache line
+ * aligned.
+ */
+extern void gfx_enable_dma(struct _gfx_surface* surface, bool enable);
+
+/**
+ * \brief Wait for the completion of the DMA fills and copies
+ *
+ * Needed before reading or writing the pixels without this module.
+ */
+extern void gfx_sync(void);
+
+/**
+ * \brief Number of rows filled or copied by the DMA since startup
+ *
+ * Always 0 on devices without DMA.
+ */
+extern uint32_t gfx_get_dma_rows(void);
+
+/**
+ * \brief Convert an ARGB8888 color to the native format of a surface
+ */
+extern uint32_t gfx_color(const struct _gfx_surface* surface, uint32_t argb);
+
+extern void gfx_draw_pixel(struct _gfx_surface* surface, int x, int y,
+		uint32_t color);
+
+extern uint32_t gfx_read_pixel(struct _gfx_surface* surface, int x, int y);
+
+/**
+ * \brief Fill a rectangle with a native color, clipped to the surface
+ */
+extern void gfx_fill_rect(struct _gfx_surface* surface, int x, int y,
+		int w, int h, uint32_t color);
+
+/**
+ * \brief Draw the outline of a rectangle
+ */
+extern void gfx_draw_rect(struct _gfx_surface* surface, int x, int y,
+		int w, int h, uint32_t color);
+
+/**
+ * \brief Draw a line from (x0, y0) to (x1, y1), both included
+ *
+ * Horizontal and vertical lines are drawn as rectangles.
+ */
+extern void gfx_draw_line(struct _gfx_surface* surface, int x0, int y0,
+		int x1, int y1, uint32_t color);
+
+/**
+ * \brief Copy an image in the format of the surface
+ *
+ * \param surface  Destination surface
+ * \param x        X-coordinate of the image top-left corner
+ * \param y        Y-coordinate of the image top-left corner
+ * \param image    Pixels of the image
+ * \param stride   Distance between the image rows, in bytes
+ * \param w        Image width in pixels
+ * \param h        Image height in pixels
+ */
+extern void gfx_blit(struct _gfx_surface* surface, int x, int y,
+		const void* image, uint32_t stride, int w, int h);
+
+/**
+ * \brief Copy a rectangle between two surfaces of the same format
+ *
+ * The surfaces may be the same one, overlapping copies (scrolling) are then
+ * done by the CPU in the right order.
+ */
+extern void gfx_copy_rect(struct _gfx_surface* dst, int dx, int dy,
+		struct _gfx_surface* src, int sx, int sy, int w, int h);
+
+/**
+ * \brief Blend an ARGB color over a rectangle (constant alpha)
+ */
+extern void gfx_blend_rect(struct _gfx_surface* surface, int x, int y,
+		int w, int h, uint32_t argb);
+
+/**
+ * \brief Blend an ARGB8888 image over the surface (per-pixel alpha)
+ *
+ * \param stride  Distance between the image rows, in pixels
+ */
+extern void gfx_blit_argb(struct _gfx_surface* surface, int x, int y,
+		const uint32_t* image, uint32_t stride, int w, int h);
+
+/**
+ * \brief Draw a character, with a background unless 'opaque' is false
+ */
+extern void gfx_draw_char(struct _gfx_surface* surface, int x, int y,
+		const struct _gfx_font* font, uint8_t c, uint32_t color,
+		uint32_t bgcolor, bool opaque);
+
+/**
+ * \brief Draw a string, line breaks are honored
+ */
+extern void gfx_draw_string(struct _gfx_surface* surface, int x, int y,
+		const struct _gfx_font* font, const char* str, uint32_t color,
+		uint32_t bgcolor, bool opaque);
+
+/**
+ * \brief Drop the cached glyphs of a font (when its data changes)
+ */
+extern void gfx_glyph_cache_flush(const struct _gfx_font* font);
+
+/**
+ * \brief Record a rectangle written without this module as dirty
+ */
+extern void gfx_invalidate(struct _gfx_surface* surface, int x, int y,
+		int w, int h);
+
+/**
+ * \brief Clean the cache lines of the dirty rectangles and clear them
+ *
+ * To be called before the display controller fetches the frame.
+ */
+extern void gfx_flush(struct _gfx_surface* surface);
+
+#endif /* GFX_H_ */
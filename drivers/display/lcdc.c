@@ -33,6 +33,7 @@
  *        Headers
  *----------------------------------------------------------------------------*/
 
+#include <errno.h>
 #include <math.h>
 #include <string.h>
 #include <stdio.h>
@@ -40,7 +41,10 @@
 #include "chip.h"
 #include "compiler.h"
 #include "display/lcdc.h"
+#include "fastmem.h"
 #include "gpio/pio.h"
+#include "irq/irq.h"
+#include "irqflags.h"
 #include "mm/cache.h"
 #include "peripherals/pmc.h"
 
@@ -51,6 +55,16 @@
 
 /**@{*/
 
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Number of entries in lcdc_layers[], including LCDC_CONTROLLER */
+#define LCDC_NUM_LAYERS 5
+
+/** Swap chain frame index meaning "no frame" */
+#define SWAP_NONE 0xff
+
 /*----------------------------------------------------------------------------
  *        Local types
  *----------------------------------------------------------------------------*/
@@ -59,6 +73,7 @@
 struct _layer_info {
 	struct _layer_data* data;
 	bool                stride_supported;
+	uint32_t            irq_mask;       /**< layer bit in LCDC_LCDIER/ISR */
 	volatile uint32_t  *reg_enable;     /**< regs: _ER, _DR, _SR, _IER, _IDR, _IMR, _ISR */
 	volatile uint32_t  *reg_blender;    /**< regs: blender */
 	volatile uint32_t  *reg_dma_head;   /**< regs: _HEAD, _ADDRESS, _CONTROL, _NEXT */
@@ -88,6 +103,26 @@ struct _layer_data {
 	uint8_t                bpp;
 };
 
+/** Frame presented to a swap chain, waiting for the LCDC to load it */
+struct _swap_entry {
+	uint8_t          index; /**< frame index */
+	lcdc_fence_cb_t  cb;    /**< fence callback */
+	void            *arg;   /**< fence callback argument */
+};
+
+/** Swap chain state of a layer */
+struct _swap_chain {
+	struct _lcdc_frame frames[CONFIG_LCDC_SWAP_CHAIN_DEPTH];
+	/** Presented frames, queue[0] is the one in the layer head register */
+	struct _swap_entry queue[CONFIG_LCDC_SWAP_CHAIN_DEPTH];
+	uint32_t           size;    /**< bytes in RGB/Y plane */
+	uint32_t           size_uv; /**< bytes in each chroma plane */
+	uint8_t            count;   /**< frames in chain, 0 when unused */
+	uint8_t            back;    /**< frame returned by get_back */
+	volatile uint8_t   front;   /**< frame being scanned out */
+	volatile uint8_t   queued;  /**< entries in queue */
+};
+
 /*----------------------------------------------------------------------------
  *        Local variables
  *----------------------------------------------------------------------------*/
@@ -126,6 +161,17 @@ static struct _lcdc_dma_desc heo_dma_v_desc; /**< DMA desc. for HEO V Layer */
 
 static struct _layer_data lcdc_heo;          /**< HEO Layer */
 
+/** DMA descriptors of swap chain frames (Y/RGB, U/UV, V), they are written
+ * once when the chain is created and never modified while in use */
+CACHE_ALIGNED_DDR
+static struct _lcdc_dma_desc swap_dma_desc[LCDC_NUM_LAYERS][CONFIG_LCDC_SWAP_CHAIN_DEPTH][3];
+
+static struct _swap_chain swap_chains[LCDC_NUM_LAYERS]; /**< By layer ID */
+
+static volatile uint32_t vsync_count;        /**< Start of frame counter */
+
+static bool lcdc_irq_installed;
+
 /*----------------------------------------------------------------------------
  *        Local constants
  *----------------------------------------------------------------------------*/
@@ -141,6 +187,7 @@ static const struct _layer_info lcdc_layers[] = {
 	{
 		.data = &lcdc_base,
 		.stride_supported = false,
+		.irq_mask = LCDC_LCDISR_BASE,
 		.reg_enable = &LCDC->LCDC_BASECHER,
 		.reg_blender = &LCDC->LCDC_BASECFG4,
 		.reg_dma_head = &LCDC->LCDC_BASEHEAD,
@@ -154,6 +201,7 @@ static const struct _layer_info lcdc_layers[] = {
 	{
 		.data = &lcdc_ovr1,
 		.stride_supported = true,
+		.irq_mask = LCDC_LCDISR_OVR1,
 		.reg_enable = &LCDC->LCDC_OVR1CHER,
 		.reg_blender = &LCDC->LCDC_OVR1CFG9,
 		.reg_dma_head = &LCDC->LCDC_OVR1HEAD,
@@ -173,6 +221,7 @@ static const struct _layer_info lcdc_layers[] = {
 	{
 		.data = &lcdc_heo,
 		.stride_supported = true,
+		.irq_mask = LCDC_LCDISR_HEO,
 		.reg_enable = &LCDC->LCDC_HEOCHER,
 		.reg_blender = &LCDC->LCDC_HEOCFG12,
 		.reg_dma_head = &LCDC->LCDC_HEOHEAD,
@@ -190,6 +239,7 @@ static const struct _layer_info lcdc_layers[] = {
 	{
 		.data = &lcdc_ovr2,
 		.stride_supported = true,
+		.irq_mask = LCDC_LCDISR_OVR2,
 		.reg_enable = &LCDC->LCDC_OVR2CHER,
 		.reg_blender = &LCDC->LCDC_OVR2CFG9,
 		.reg_dma_head = &LCDC->LCDC_OVR2HEAD,
@@ -316,6 +366,121 @@ static void _clear_dma_desc(struct _lcdc_dma_desc *desc,
 	dma_head_reg[3] = (uint32_t)desc;
 }
 
+/**
+ * Write a looping DMA descriptor to the head register of a LCDC DMA channel,
+ * it is loaded at the end of the current frame once A2QEN is set
+ */
+static void _queue_dma_desc(void *buffer, struct _lcdc_dma_desc *desc,
+		volatile uint32_t *dma_head_reg)
+{
+	desc->addr = (uint32_t)buffer;
+	desc->ctrl = LCDC_BASECTRL_DFETCH;
+	desc->next = (uint32_t)desc;
+	cache_clean_region(desc, sizeof(struct _lcdc_dma_desc));
+	dma_head_reg[0] = (uint32_t)desc;
+}
+
+/**
+ * Add the prepared descriptors of a swap chain frame to the layer queue
+ */
+static void _swap_chain_queue(uint8_t layer_id, uint8_t index)
+{
+	const struct _layer_info *layer = &lcdc_layers[layer_id];
+	const struct _lcdc_frame *frame = &swap_chains[layer_id].frames[index];
+	struct _lcdc_dma_desc *desc = swap_dma_desc[layer_id][index];
+
+	layer->reg_dma_head[0] = (uint32_t)&desc[0];
+	if (frame->buffer_u)
+		layer->reg_dma_u_head[0] = (uint32_t)&desc[1];
+	if (frame->buffer_v)
+		layer->reg_dma_v_head[0] = (uint32_t)&desc[2];
+	layer->reg_enable[0] = LCDC_HEOCHER_A2QEN;
+}
+
+/**
+ * Detach the swap chain of a layer, pending fences are dropped
+ */
+static void _swap_chain_release(uint8_t layer_id)
+{
+	const struct _layer_info *layer = &lcdc_layers[layer_id];
+	struct _swap_chain *chain = &swap_chains[layer_id];
+
+	if (!chain->count)
+		return;
+
+	LCDC->LCDC_LCDIDR = layer->irq_mask;
+	layer->reg_enable[4] = LCDC_BASEIDR_ADD;
+	chain->count = 0;
+	chain->queued = 0;
+	chain->front = SWAP_NONE;
+	chain->back = SWAP_NONE;
+}
+
+/**
+ * Head descriptor loaded: the first presented frame is now scanned out
+ */
+static void _swap_chain_flip(uint8_t layer_id)
+{
+	struct _swap_chain *chain = &swap_chains[layer_id];
+	struct _swap_entry entry;
+	uint8_t released, i;
+
+	if (!chain->queued)
+		return;
+
+	entry = chain->queue[0];
+	for (i = 1; i < chain->queued; i++)
+		chain->queue[i - 1] = chain->queue[i];
+	chain->queued--;
+
+	released = chain->front;
+	chain->front = entry.index;
+	lcdc_layers[layer_id].data->buffer = chain->frames[entry.index].buffer;
+
+	/* Next presented frame is committed at the following end of frame */
+	if (chain->queued)
+		_swap_chain_queue(layer_id, chain->queue[0].index);
+
+	if (entry.cb)
+		entry.cb(layer_id, released == SWAP_NONE ?
+				NULL : &chain->frames[released], entry.arg);
+}
+
+/**
+ * LCDC interrupt handler: vsync counter and swap chain flips
+ */
+static void _lcdc_handler(uint32_t source, void* user_arg)
+{
+	uint32_t status = LCDC->LCDC_LCDISR;
+	uint8_t i;
+
+	if (status & LCDC_LCDISR_SOF)
+		vsync_count++;
+
+	for (i = 1; i < LCDC_NUM_LAYERS; i++) {
+		const struct _layer_info *layer = &lcdc_layers[i];
+
+		if (!layer->data || !(status & layer->irq_mask))
+			continue;
+		/* reading the layer ISR clears it */
+		if (layer->reg_enable[6] & LCDC_BASEISR_ADD)
+			_swap_chain_flip(i);
+	}
+}
+
+/**
+ * Enable LCDC interrupts, installing the handler on first use
+ */
+static void _enable_irq(uint32_t mask)
+{
+	if (!lcdc_irq_installed) {
+		irq_add_handler(ID_LCDC, _lcdc_handler, NULL);
+		irq_enable(ID_LCDC);
+		lcdc_irq_installed = true;
+	}
+	LCDC->LCDC_LCDIER = mask;
+}
+
 /**
  * Compute scaling factors
  */
@@ -811,6 +976,9 @@ void * lcdc_put_image_rotated(uint8_t layer_id,
 	if (!layer->reg_cfg)
 		return old_buffer;
 
+	/* The layer own descriptor replaces any swap chain */
+	_swap_chain_release(layer_id);
+
 	//printf("Show %x @ %d: (%d,%d)+(%d,%d) img %d x %d * %d\n\r", buffer, layer_id, x, y, w, h, img_w, img_h, bpp);
 
 	switch (bpp) {
@@ -1125,6 +1293,8 @@ void * lcdc_show_base(void *buffer, uint8_t bpp, bool bottom_up)
  */
 void lcdc_stop_base(void)
 {
+	_swap_chain_release(LCDC_BASE);
+
 	if (!(LCDC->LCDC_BASECHSR & LCDC_BASECHSR_CHSR))
 		return;
 
@@ -1161,6 +1331,8 @@ void *lcdc_show_ovr1(void *buffer, uint8_t bpp, uint32_t x, uint32_t y,
  */
 void lcdc_stop_ovr1(void)
 {
+	_swap_chain_release(LCDC_OVR1);
+
 	if (!(LCDC->LCDC_OVR1CHSR & LCDC_OVR1CHSR_CHSR))
 		return;
 
@@ -1198,6 +1370,8 @@ void *lcdc_show_heo(void *buffer, uint8_t bpp, uint32_t x, uint32_t y,
  */
 void lcdc_stop_heo(void)
 {
+	_swap_chain_release(LCDC_HEO);
+
 	if (!(LCDC->LCDC_HEOCHSR & LCDC_HEOCHSR_CHSR))
 		return;
 
@@ -1348,6 +1522,11 @@ void lcdc_on(void)
  */
 void lcdc_off(void)
 {
+	uint8_t i;
+
+	for (i = 1; i < LCDC_NUM_LAYERS; i++)
+		_swap_chain_release(i);
+
 	/* 1. Clear the DFETCH bit in the DSCR.CHXCTRL field of the DSCR structure
 	   will disable the channel at the end of the frame. */
 
@@ -1453,13 +1632,17 @@ struct _lcdc_layer *lcdc_get_canvas(void)
 
 /**
  * Flush the current canvas layer*
+ * \note Use gfx_flush() to clean only the regions drawn since last flush.
  */
 void lcdc_flush_canvas(void)
 {
 	struct _lcdc_layer *layer;
+	uint32_t row;
 
 	layer = lcdc_get_canvas();
-	cache_clean_region(layer->buffer, layer->height * layer->width * 4);
+	/* 4-byte aligned rows */
+	row = ((layer->width * layer->bpp / 8) + 3) & ~3;
+	cache_clean_region(layer->buffer, layer->height * row);
 }
 
 /**
@@ -1535,7 +1718,7 @@ void * lcdc_create_canvas(uint8_t layer_id, void *buffer, uint8_t bpp,
 	/* Clear buffer */
 	bits_per_row = w * bpp;
 	bytes_per_row = (bits_per_row & 0x7) ? (bits_per_row / 8 + 1) : (bits_per_row / 8);
-	memset(buffer, 0, bytes_per_row * h);
+	fast_memset(buffer, 0, bytes_per_row * h);
 
 	old_buffer = lcdc_put_image_rotated(layer_id, buffer, bpp,
 			x, y, w, h, w, h, 0);
@@ -1585,7 +1768,7 @@ void *lcdc_create_canvas_yuv_planar(uint8_t layer_id,
 	/* Clear buffer */
 	bits_per_row = w * bpp;
 	bytes_per_row = (bits_per_row & 0x7) ? (bits_per_row / 8 + 1) : (bits_per_row / 8);
-	memset(buffer_y, 0xFF, bytes_per_row * h);
+	fast_memset(buffer_y, 0xFF, bytes_per_row * h);
 
 	/* Setup window */
 	if (layer->reg_win) {
@@ -1636,7 +1819,7 @@ void *lcdc_create_canvas_yuv_semiplanar(uint8_t layer_id,
 	/* Clear buffer */
 	bits_per_row = w * bpp;
 	bytes_per_row = (bits_per_row & 0x7) ? (bits_per_row / 8 + 1) : (bits_per_row / 8);
-	memset(buffer_y, 0xFF, bytes_per_row * h);
+	fast_memset(buffer_y, 0xFF, bytes_per_row * h);
 
 	if (layer->reg_win) {
 		layer->reg_win[0] = LCDC_HEOCFG2_XPOS(x) | LCDC_HEOCFG2_YPOS(y);
@@ -1650,6 +1833,250 @@ void *lcdc_create_canvas_yuv_semiplanar(uint8_t layer_id,
 	return 0;
 }
 
+/**
+ * \brief Attach a swap chain to a layer for tear-free page flipping.
+ *
+ * The layer must have been set up (format, window, scaling) with
+ * lcdc_put_image*(), lcdc_create_canvas() or lcdc_create_canvas_yuv_*().
+ * The first frame is displayed from the next frame start, the others are
+ * then rendered into and presented in turn.
+ * \note Frames are scanned from their start address: mirrored or rotated
+ *       scanning set up by lcdc_put_image_rotated() is not supported.
+ * \param layer_id Layer ID.
+ * \param frames   Frame buffers, buffer_u/buffer_v are used only for YUV
+ *                 planar (both) and semiplanar (buffer_u) HEO layers.
+ * \param count    Number of frames (2 or 3, up to
+ *                 CONFIG_LCDC_SWAP_CHAIN_DEPTH).
+ * \param size     Size in bytes of the RGB or Y plane of each frame.
+ * \param size_uv  Size in bytes of each chroma plane.
+ * \return 0 on success, -EINVAL on invalid parameters.
+ */
+int lcdc_swap_chain_create(uint8_t layer_id,
+		const struct _lcdc_frame *frames, uint8_t count,
+		uint32_t size, uint32_t size_uv)
+{
+	const struct _layer_info *layer;
+	struct _swap_chain *chain;
+	struct _lcdc_dma_desc *desc;
+	uint8_t i;
+
+	if (layer_id == LCDC_CONTROLLER || layer_id >= LCDC_NUM_LAYERS)
+		return -EINVAL;
+	layer = &lcdc_layers[layer_id];
+	if (!layer->data || !layer->reg_dma_head)
+		return -EINVAL;
+	if (count < 2 || count > CONFIG_LCDC_SWAP_CHAIN_DEPTH)
+		return -EINVAL;
+	for (i = 0; i < count; i++) {
+		if (!frames[i].buffer)
+			return -EINVAL;
+		if (frames[i].buffer_u && !layer->reg_dma_u_head)
+			return -EINVAL;
+		if (frames[i].buffer_v && !layer->reg_dma_v_head)
+			return -EINVAL;
+	}
+
+	_swap_chain_release(layer_id);
+
+	chain = &swap_chains[layer_id];
+	for (i = 0; i < count; i++) {
+		chain->frames[i] = frames[i];
+		desc = swap_dma_desc[layer_id][i];
+		desc[0].addr = (uint32_t)frames[i].buffer;
+		desc[0].ctrl = LCDC_BASECTRL_DFETCH | LCDC_BASECTRL_ADDIEN;
+		desc[0].next = (uint32_t)&desc[0];
+		desc[1].addr = (uint32_t)frames[i].buffer_u;
+		desc[1].ctrl = LCDC_BASECTRL_DFETCH;
+		desc[1].next = (uint32_t)&desc[1];
+		desc[2].addr = (uint32_t)frames[i].buffer_v;
+		desc[2].ctrl = LCDC_BASECTRL_DFETCH;
+		desc[2].next = (uint32_t)&desc[2];
+	}
+	cache_clean_region(swap_dma_desc[layer_id], sizeof(swap_dma_desc[0]));
+
+	chain->size = size;
+	chain->size_uv = size_uv;
+	chain->front = SWAP_NONE;
+	chain->back = SWAP_NONE;
+	chain->queued = 0;
+	chain->count = count;
+
+	layer->reg_enable[3] = LCDC_BASEIER_ADD;
+	_enable_irq(layer->irq_mask);
+
+	/* Show first frame */
+	chain->back = 0;
+	return lcdc_swap_chain_present(layer_id, NULL, NULL);
+}
+
+/**
+ * \brief Detach the swap chain of a layer.
+ * The last presented frame stays on display, through the layer own
+ * descriptors. Fences not signaled yet are dropped.
+ * \param layer_id Layer ID.
+ */
+void lcdc_swap_chain_destroy(uint8_t layer_id)
+{
+	const struct _layer_info *layer;
+	struct _swap_chain *chain;
+	const struct _lcdc_frame *frame;
+	uint32_t flags;
+
+	if (layer_id == LCDC_CONTROLLER || layer_id >= LCDC_NUM_LAYERS)
+		return;
+	layer = &lcdc_layers[layer_id];
+	chain = &swap_chains[layer_id];
+
+	flags = arch_irq_save();
+	if (!chain->count) {
+		arch_irq_restore(flags);
+		return;
+	}
+	if (chain->queued)
+		frame = &chain->frames[chain->queue[chain->queued - 1].index];
+	else
+		frame = &chain->frames[chain->front];
+	_swap_chain_release(layer_id);
+	arch_irq_restore(flags);
+
+	_queue_dma_desc(frame->buffer, layer->data->dma_desc,
+			layer->reg_dma_head);
+	if (frame->buffer_u)
+		_queue_dma_desc(frame->buffer_u, layer->data->dma_u_desc,
+				layer->reg_dma_u_head);
+	if (frame->buffer_v)
+		_queue_dma_desc(frame->buffer_v, layer->data->dma_v_desc,
+				layer->reg_dma_v_head);
+	layer->reg_enable[0] = LCDC_HEOCHER_A2QEN;
+	layer->data->buffer = frame->buffer;
+}
+
+/**
+ * \brief Get the frame to render next into.
+ * The frame is neither scanned out nor waiting to be, so drawing into it
+ * never tears. The same frame is returned until it is presented.
+ * \param layer_id Layer ID.
+ * \return Back frame, or NULL if all frames are displayed or queued (wait
+ *         for a fence or for vsync and retry) or no chain is attached.
+ */
+struct _lcdc_frame *lcdc_swap_chain_get_back(uint8_t layer_id)
+{
+	struct _swap_chain *chain;
+	uint32_t flags;
+	uint8_t i, q;
+
+	if (layer_id >= LCDC_NUM_LAYERS)
+		return NULL;
+	chain = &swap_chains[layer_id];
+
+	flags = arch_irq_save();
+	if (chain->count && chain->back == SWAP_NONE) {
+		for (i = 0; i < chain->count; i++) {
+			if (i == chain->front)
+				continue;
+			for (q = 0; q < chain->queued; q++)
+				if (chain->queue[q].index == i)
+					break;
+			if (q == chain->queued) {
+				chain->back = i;
+				break;
+			}
+		}
+	}
+	arch_irq_restore(flags);
+
+	if (!chain->count || chain->back == SWAP_NONE)
+		return NULL;
+	return &chain->frames[chain->back];
+}
+
+/**
+ * \brief Present the back frame.
+ * The frame is cleaned from the data cache and queued on the layer DMA,
+ * the swap is committed by the LCDC at the end of the frame being scanned
+ * out (or after the frames presented before it). The function does not
+ * wait: the caller can get the next back frame immediately.
+ * \param layer_id Layer ID.
+ * \param cb       Fence callback invoked from interrupt context when the
+ *                 frame starts scanning out (may be NULL).
+ * \param arg      Fence callback argument.
+ * \return 0 on success, -EINVAL if no back frame was acquired.
+ */
+int lcdc_swap_chain_present(uint8_t layer_id, lcdc_fence_cb_t cb, void *arg)
+{
+	const struct _layer_info *layer;
+	struct _swap_chain *chain;
+	const struct _lcdc_frame *frame;
+	uint32_t flags;
+	uint8_t index;
+
+	if (layer_id >= LCDC_NUM_LAYERS)
+		return -EINVAL;
+	layer = &lcdc_layers[layer_id];
+	chain = &swap_chains[layer_id];
+	if (!chain->count || chain->back == SWAP_NONE)
+		return -EINVAL;
+
+	index = chain->back;
+	frame = &chain->frames[index];
+	cache_clean_region(frame->buffer, chain->size);
+	if (frame->buffer_u)
+		cache_clean_region(frame->buffer_u, chain->size_uv);
+	if (frame->buffer_v)
+		cache_clean_region(frame->buffer_v, chain->size_uv);
+
+	flags = arch_irq_save();
+	chain->back = SWAP_NONE;
+	if (!(layer->reg_enable[2] & LCDC_BASECHSR_CHSR)) {
+		/* Channel stopped: frame is used as soon as it is enabled */
+		struct _lcdc_dma_desc *desc = swap_dma_desc[layer_id][index];
+		layer->reg_dma_head[1] = desc[0].addr;
+		layer->reg_dma_head[2] = desc[0].ctrl;
+		layer->reg_dma_head[3] = (uint32_t)&desc[0];
+		if (frame->buffer_u) {
+			layer->reg_dma_u_head[1] = desc[1].addr;
+			layer->reg_dma_u_head[2] = desc[1].ctrl;
+			layer->reg_dma_u_head[3] = (uint32_t)&desc[1];
+		}
+		if (frame->buffer_v) {
+			layer->reg_dma_v_head[1] = desc[2].addr;
+			layer->reg_dma_v_head[2] = desc[2].ctrl;
+			layer->reg_dma_v_head[3] = (uint32_t)&desc[2];
+		}
+		layer->data->buffer = frame->buffer;
+		chain->front = index;
+		chain->queued = 0;
+		arch_irq_restore(flags);
+		if (cb)
+			cb(layer_id, NULL, arg);
+		return 0;
+	}
+	chain->queue[chain->queued].index = index;
+	chain->queue[chain->queued].cb = cb;
+	chain->queue[chain->queued].arg = arg;
+	chain->queued++;
+	if (chain->queued == 1)
+		_swap_chain_queue(layer_id, index);
+	arch_irq_restore(flags);
+
+	return 0;
+}
+
+/**
+ * \brief Wait for the next LCD start of frame.
+ * Returns at once if the LCD timing engine is not running.
+ */
+void lcdc_wait_vsync(void)
+{
+	uint32_t count = vsync_count;
+
+	if (!(LCDC->LCDC_LCDSR & LCDC_LCDSR_LCDSTS))
+		return;
+
+	_enable_irq(LCDC_LCDIER_SOFIE);
+	while (count == vsync_count);
+}
+
 /**
  * \brief Change RGB Input Mode Selection for given layer.
  * \param layer_id   Layer ID.
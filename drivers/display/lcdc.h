@@ -63,6 +63,16 @@
  *                            drawing on
  *    -# lcdc_select_canvas(): Select a displayer as canvas to drawing on
  *    -# lcdc_get_canvas():    Get current selected canvas layer
+ * -# Tear-free animation on base, overlay and HEO layers:
+ *    -# lcdc_swap_chain_create(): Attach 2 or 3 frame buffers (RGB or
+ *       YUV planar/semiplanar) to a layer already configured with
+ *       lcdc_put_image() or lcdc_create_canvas*()
+ *    -# lcdc_swap_chain_get_back(): Get a frame that is neither displayed
+ *       nor queued, to render the next image into
+ *    -# lcdc_swap_chain_present(): Queue the rendered frame, it is shown
+ *       from the next frame start and the fence callback is invoked then
+ *    -# lcdc_swap_chain_destroy(): Return the layer to single buffering
+ *    -# lcdc_wait_vsync(): Wait for the next start of frame
  *
  * For LCD drawing functions, refer to \ref lcdc_draw.
  *
@@ -115,10 +125,33 @@ enum {
 #include <stdint.h>
 #include <stdbool.h>
 
+/** Maximum number of frames in a layer swap chain */
+#ifndef CONFIG_LCDC_SWAP_CHAIN_DEPTH
+#define CONFIG_LCDC_SWAP_CHAIN_DEPTH 3
+#endif
+
 /*----------------------------------------------------------------------------
  *        Types
  *----------------------------------------------------------------------------*/
 
+/** Frame buffer of a swap chain */
+struct _lcdc_frame {
+	void *buffer;   /**< RGB or Y plane */
+	void *buffer_u; /**< U plane (planar) or UV plane (semiplanar) */
+	void *buffer_v; /**< V plane (planar only) */
+};
+
+/**
+ * Fence callback, invoked from the LCDC interrupt when a presented frame
+ * starts scanning out.
+ * \param layer    Layer ID.
+ * \param released Frame no longer read by the LCDC (NULL for the first
+ *                 frame presented), may be rendered into again.
+ * \param arg      Argument given to lcdc_swap_chain_present().
+ */
+typedef void (*lcdc_fence_cb_t)(uint8_t layer,
+		const struct _lcdc_frame *released, void *arg);
+
 /** LCD display layer information */
 struct _lcdc_layer {
 	void    *buffer;   /**< Display image buffer */
@@ -225,6 +258,19 @@ extern void *lcdc_create_canvas_yuv_semiplanar(uint8_t layer,
 		void *buffer_y, void *buffer_uv, uint8_t bpp,
 		uint16_t x, uint16_t y, uint16_t w, uint16_t h);
 
+extern int lcdc_swap_chain_create(uint8_t layer,
+		const struct _lcdc_frame *frames, uint8_t count,
+		uint32_t size, uint32_t size_uv);
+
+extern void lcdc_swap_chain_destroy(uint8_t layer);
+
+extern struct _lcdc_frame *lcdc_swap_chain_get_back(uint8_t layer);
+
+extern int lcdc_swap_chain_present(uint8_t layer,
+		lcdc_fence_cb_t cb, void *arg);
+
+extern void lcdc_wait_vsync(void);
+
 /**  @}*/
 
 #endif /* CONFIG_HAVE_LCDC */
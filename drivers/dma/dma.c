@@ -46,7 +46,9 @@
 #include "compiler.h"
 #include "dma/dma.h"
 #include "irq/irq.h"
+#include "irqflags.h"
 #include "errno.h"
+#include "fastmem.h"
 #include "mm/cache.h"
 #include "mutex.h"
 #include "peripherals/pmc.h"
@@ -111,7 +113,7 @@ static uint32_t controllers[] = {
  * functions defined below. */
 struct _dma_sg_desc {
 #ifdef CONFIG_HAVE_XDMAC
-	struct _xdmac_desc_view1 desc;
+	struct _xdmac_desc_view2 desc; /* view 1 unless items have their own cfg */
 #elif defined(CONFIG_HAVE_DMAC)
 	struct _dmac_desc desc;
 #endif
@@ -127,11 +129,21 @@ struct _dma_sg_pool {
 };
 
 
+/** State of the asynchronous memory copies (see dma_memcpy) */
+struct _dma_memcpy {
+	struct _dma_channel* channel;  /**< reserved on first use */
+	void* dst;
+	uint32_t len;
+	struct _callback callback;
+	volatile bool busy;
+};
+
 /** DMA driver instance */
 struct _dma_ctrl {
 	struct _dma_controller controllers[DMA_CONTROLLERS];
 	bool polling;
 	uint8_t polling_timeout;
+	struct _dma_memcpy memcpy;
 };
 
 /*----------------------------------------------------------------------------
@@ -156,6 +168,37 @@ static inline bool is_dest_periph(struct _dma_channel* channel)
 	return ((channel->dest_txif != 0xff) | (channel->dest_rxif != 0xff));
 }
 
+#if defined(CONFIG_HAVE_XDMAC)
+/**
+ * \brief Memory burst size of memory to memory transfers: the chunk size is
+ * only used by peripheral synchronized transfers, so it gives the burst size
+ * of the others.
+ */
+static uint32_t _dma_xdmac_mbsize(uint32_t chunk_size)
+{
+	switch (chunk_size) {
+	case DMA_CHUNK_SIZE_1:
+	case DMA_CHUNK_SIZE_2:
+		return XDMAC_CC_MBSIZE_SINGLE;
+	case DMA_CHUNK_SIZE_4:
+		return XDMAC_CC_MBSIZE_FOUR;
+	case DMA_CHUNK_SIZE_8:
+		return XDMAC_CC_MBSIZE_EIGHT;
+	default:
+		return XDMAC_CC_MBSIZE_SIXTEEN;
+	}
+}
+#endif
+
+static int _dma_memcpy_callback(void* arg, void* arg2)
+{
+	struct _dma_memcpy* mc = (struct _dma_memcpy*)arg;
+
+	cache_invalidate_region(mc->dst, mc->len);
+	mc->busy = false;
+	return callback_call(&mc->callback, NULL);
+}
+
 /**
  * \brief Preinitialize all descriptors and pool and link them together
  */
@@ -187,11 +230,14 @@ static struct _dma_sg_desc* _dma_sg_desc_alloc(uint8_t count)
 
 	if (count == 0)
 		return NULL;
-	if (count > _dma_sg_pool.count)
-		return NULL;
 
 	mutex_lock(&_dma_sg_pool.mutex);
 
+	if (count > _dma_sg_pool.count) {
+		mutex_unlock(&_dma_sg_pool.mutex);
+		return NULL;
+	}
+
 	list_head = _dma_sg_pool.head;
 	curr = list_head;
 	for (i = 0; i < (count - 1); i++) {
@@ -217,6 +263,7 @@ static void _dma_sg_desc_free(struct _dma_sg_desc* list_head)
 {
 	struct _dma_sg_desc* curr = list_head;
 	struct _dma_sg_desc* tail;
+	uint32_t count = 0;
 
 	if (list_head == NULL)
 		return;
@@ -224,8 +271,8 @@ static void _dma_sg_desc_free(struct _dma_sg_desc* list_head)
 	do {
 		tail = curr;
 		curr = DMA_SG_DESC_GET_NEXT(curr);
+		count++;
 	} while ((curr != NULL) && (curr != list_head));
-	curr = list_head;
 
 	mutex_lock(&_dma_sg_pool.mutex);
 
@@ -236,6 +283,7 @@ static void _dma_sg_desc_free(struct _dma_sg_desc* list_head)
 		DMA_SG_DESC_SET_NEXT(_dma_sg_pool.tail, list_head);
 	_dma_sg_pool.tail = tail;
 	DMA_SG_DESC_SET_NEXT(_dma_sg_pool.tail, 0);
+	_dma_sg_pool.count += count;
 
 	mutex_unlock(&_dma_sg_pool.mutex);
 }
@@ -256,6 +304,9 @@ static int _dma_configure_transfer(struct _dma_channel* channel,
 
 	memset(&desc, 0, sizeof(desc));
 
+	_dma_sg_desc_free(channel->sg_list);
+	channel->sg_list = NULL;
+	channel->loop = false;
 	src_is_periph = is_source_periph(channel);
 	dst_is_periph = is_dest_periph(channel);
 
@@ -308,7 +359,7 @@ static int _dma_configure_transfer(struct _dma_channel* channel,
 	desc.cfg |= dst_is_periph ? XDMAC_CC_DIF_AHB_IF1 : XDMAC_CC_DIF_AHB_IF0;
 	desc.cfg |= cfg_dma->incr_saddr ? XDMAC_CC_SAM_INCREMENTED_AM : XDMAC_CC_SAM_FIXED_AM;
 	desc.cfg |= cfg_dma->incr_daddr ? XDMAC_CC_DAM_INCREMENTED_AM : XDMAC_CC_DAM_FIXED_AM;
-	desc.cfg |= (src_is_periph || dst_is_periph) ? 0 : XDMAC_CC_SWREQ_SWR_CONNECTED;
+	desc.cfg |= (src_is_periph || dst_is_periph) ? 0 : XDMAC_CC_SWREQ_SWR_CONNECTED | _dma_xdmac_mbsize(cfg_dma->chunk_size);
 	desc.ds = 0;
 	desc.sus = 0;
 	desc.dus = 0;
@@ -351,19 +402,55 @@ static int _dma_configure_transfer(struct _dma_channel* channel,
 #endif /* CONFIG_HAVE_DMAC */
 }
 
+#if defined(CONFIG_HAVE_XDMAC)
+/**
+ * \brief Compute the XDMAC channel configuration of a scatter/gather item,
+ * including the peripheral ID as it is loaded from view 2 descriptors.
+ */
+static uint32_t _dma_sg_xdmac_cc(struct _dma_channel* channel,
+				 const struct _dma_cfg* cfg_dma)
+{
+	bool src_is_periph = is_source_periph(channel);
+	bool dst_is_periph = is_dest_periph(channel);
+	uint32_t cc;
+
+	cc = (src_is_periph | dst_is_periph) ? XDMAC_CC_TYPE_PER_TRAN : XDMAC_CC_TYPE_MEM_TRAN;
+	cc |= src_is_periph ? XDMAC_CC_DSYNC_PER2MEM : XDMAC_CC_DSYNC_MEM2PER;
+	cc |= XDMAC_CC_CSIZE(cfg_dma->chunk_size);
+	cc |= XDMAC_CC_DWIDTH(cfg_dma->data_width);
+	cc |= src_is_periph ? XDMAC_CC_SIF_AHB_IF1 : XDMAC_CC_SIF_AHB_IF0;
+	cc |= dst_is_periph ? XDMAC_CC_DIF_AHB_IF1 : XDMAC_CC_DIF_AHB_IF0;
+	cc |= cfg_dma->incr_saddr ? XDMAC_CC_SAM_INCREMENTED_AM : XDMAC_CC_SAM_FIXED_AM;
+	cc |= cfg_dma->incr_daddr ? XDMAC_CC_DAM_INCREMENTED_AM : XDMAC_CC_DAM_FIXED_AM;
+	if (src_is_periph)
+		cc |= XDMAC_CC_PERID(channel->src_rxif);
+	else if (dst_is_periph)
+		cc |= XDMAC_CC_PERID(channel->dest_txif);
+	else
+		cc |= XDMAC_CC_SWREQ_SWR_CONNECTED | XDMAC_CC_PERID_Msk | _dma_xdmac_mbsize(cfg_dma->chunk_size);
+	return cc;
+}
+#endif
+
 static int _dma_sg_configure_transfer(struct _dma_channel* channel,
 				      struct _dma_cfg* cfg_dma,
+				      struct _dma_cfg* item_cfg,
 				      struct _dma_transfer_cfg* sg_list, uint8_t sg_list_size)
 {
 	struct _dma_sg_desc* _sg_head;
 	struct _dma_sg_desc* curr;
 	struct _dma_transfer_cfg* cfg;
+	struct _dma_cfg* icfg;
 	bool src_is_periph, dst_is_periph;
 	uint8_t idx;
 
 	if ((sg_list == NULL) || (sg_list_size == 0))
 		return -EINVAL;
 
+	/* give back the descriptors of a completed transfer */
+	_dma_sg_desc_free(channel->sg_list);
+	channel->sg_list = NULL;
+
 	src_is_periph = is_source_periph(channel);
 	dst_is_periph = is_dest_periph(channel);
 
@@ -378,12 +465,14 @@ static int _dma_sg_configure_transfer(struct _dma_channel* channel,
 	/* Update linked list */
 	for (idx = 0; idx < sg_list_size; idx++) {
 		cfg = &sg_list[idx];
+		icfg = item_cfg ? &item_cfg[idx] : cfg_dma;
 
 		DMA_SG_DESC_SET_SADDR(curr, cfg->saddr);
 		DMA_SG_DESC_SET_DADDR(curr, cfg->daddr);
 
 #if defined(CONFIG_HAVE_XDMAC)
-		curr->desc.mbr_ubc = XDMA_UBC_NVIEW_NDV1
+		/* NVIEW gives the view of the next item, they are all alike */
+		curr->desc.mbr_ubc = (item_cfg ? XDMA_UBC_NVIEW_NDV2 : XDMA_UBC_NVIEW_NDV1)
 			| XDMA_UBC_NSEN_UPDATED
 			| XDMA_UBC_NDEN_UPDATED
 			| XDMA_UBC_NDE_FETCH_EN
@@ -393,12 +482,14 @@ static int _dma_sg_configure_transfer(struct _dma_channel* channel,
 			if (DMA_SG_DESC_GET_NEXT(curr) == 0)
 				curr->desc.mbr_ubc &= ~XDMA_UBC_NDE_FETCH_EN;
 		}
+		if (item_cfg)
+			curr->desc.mbr_cfg = _dma_sg_xdmac_cc(channel, icfg);
 
 #elif defined(CONFIG_HAVE_DMAC)
-		curr->desc.ctrla = (cfg_dma->data_width << DMAC_CTRLA_SRC_WIDTH_Pos)
-			| (cfg_dma->data_width << DMAC_CTRLA_DST_WIDTH_Pos)
-			| (cfg_dma->chunk_size << DMAC_CTRLA_SCSIZE_Pos)
-			| (cfg_dma->chunk_size << DMAC_CTRLA_DCSIZE_Pos)
+		curr->desc.ctrla = (icfg->data_width << DMAC_CTRLA_SRC_WIDTH_Pos)
+			| (icfg->data_width << DMAC_CTRLA_DST_WIDTH_Pos)
+			| (icfg->chunk_size << DMAC_CTRLA_SCSIZE_Pos)
+			| (icfg->chunk_size << DMAC_CTRLA_DCSIZE_Pos)
 			| DMAC_CTRLA_BTSIZE(cfg->len);
 
 #if defined(CONFIG_SOC_SAMA5D3)
@@ -415,8 +506,8 @@ static int _dma_sg_configure_transfer(struct _dma_channel* channel,
 		else
 			curr->desc.ctrlb |= DMAC_CTRLB_FC_MEM2MEM_DMA_FC;
 
-		curr->desc.ctrlb |= cfg_dma->incr_saddr ? DMAC_CTRLB_SRC_INCR_INCREMENTING : DMAC_CTRLB_SRC_INCR_FIXED;
-		curr->desc.ctrlb |= cfg_dma->incr_daddr ? DMAC_CTRLB_DST_INCR_INCREMENTING : DMAC_CTRLB_DST_INCR_FIXED;
+		curr->desc.ctrlb |= icfg->incr_saddr ? DMAC_CTRLB_SRC_INCR_INCREMENTING : DMAC_CTRLB_SRC_INCR_FIXED;
+		curr->desc.ctrlb |= icfg->incr_daddr ? DMAC_CTRLB_DST_INCR_INCREMENTING : DMAC_CTRLB_DST_INCR_FIXED;
 
 		curr->desc.ctrlb |= DMAC_CTRLB_SRC_DSCR_FETCH_FROM_MEM | DMAC_CTRLB_DST_DSCR_FETCH_FROM_MEM;
 
@@ -427,6 +518,7 @@ static int _dma_sg_configure_transfer(struct _dma_channel* channel,
 		curr = DMA_SG_DESC_GET_NEXT(curr);
 	}
 	channel->sg_list = _sg_head;
+	channel->loop = cfg_dma->loop;
 
 	cache_clean_region(_dma_sg_pool.desc, sizeof(_dma_sg_pool.desc));
 
@@ -435,6 +527,10 @@ static int _dma_sg_configure_transfer(struct _dma_channel* channel,
 	struct _xdmacd_cfg xdmacd_cfg;
 	uint32_t desc_ctrl;
 
+	/* The channel starts with the configuration of the first item */
+	if (item_cfg)
+		cfg_dma = &item_cfg[0];
+
 	xdmacd_cfg.cfg = (src_is_periph | dst_is_periph) ? XDMAC_CC_TYPE_PER_TRAN : XDMAC_CC_TYPE_MEM_TRAN;
 	xdmacd_cfg.cfg |= src_is_periph ? XDMAC_CC_DSYNC_PER2MEM : XDMAC_CC_DSYNC_MEM2PER;
 	xdmacd_cfg.cfg |= XDMAC_CC_CSIZE(cfg_dma->chunk_size);
@@ -449,12 +545,19 @@ static int _dma_sg_configure_transfer(struct _dma_channel* channel,
 	xdmacd_cfg.sus = 0;
 	xdmacd_cfg.dus = 0;
 
-	desc_ctrl = XDMAC_CNDC_NDVIEW_NDV1
+	desc_ctrl = (item_cfg ? XDMAC_CNDC_NDVIEW_NDV2 : XDMAC_CNDC_NDVIEW_NDV1)
 	           | XDMAC_CNDC_NDE_DSCR_FETCH_EN
 	           | XDMAC_CNDC_NDSUP_SRC_PARAMS_UPDATED
 	           | XDMAC_CNDC_NDDUP_DST_PARAMS_UPDATED;
 
-	return xdmacd_configure_transfer(channel, &xdmacd_cfg, desc_ctrl, (void *)_sg_head);
+	int err = xdmacd_configure_transfer(channel, &xdmacd_cfg, desc_ctrl, (void *)_sg_head);
+	if (err)
+		return err;
+
+	/* A circular list never ends, notify the end of each item instead */
+	if (cfg_dma->loop)
+		xdmac_enable_channel_it(channel->hw, channel->id, XDMAC_CIE_BIE);
+	return 0;
 #elif defined(CONFIG_HAVE_DMAC)
 	struct _dmacd_cfg dmacd_cfg;
 
@@ -484,6 +587,7 @@ void dma_initialize(bool polling)
 	_dma_sg_init();
 
 	_dma_ctrl.polling = polling;
+	memset(&_dma_ctrl.memcpy, 0, sizeof(_dma_ctrl.memcpy));
 
 	for (ctrl = 0; ctrl < DMA_CONTROLLERS; ctrl++) {
 		struct _dma_controller* controller = &_dma_ctrl.controllers[ctrl];
@@ -518,7 +622,8 @@ void dma_initialize(bool polling)
 
 void dma_poll(void)
 {
-	if (_dma_ctrl.polling) {
+	/* with the interrupts masked, the handler would never run */
+	if (_dma_ctrl.polling || arch_irq_is_masked()) {
 		uint32_t ctrl;
 		for (ctrl = 0; ctrl < DMA_CONTROLLERS; ctrl++) {
 			struct _dma_controller* controller = &_dma_ctrl.controllers[ctrl];
@@ -527,6 +632,11 @@ void dma_poll(void)
 	}
 }
 
+bool dma_is_polling(void)
+{
+	return _dma_ctrl.polling;
+}
+
 struct _dma_channel* dma_allocate_channel(uint8_t src, uint8_t dest)
 {
 	uint32_t chan, ctrl;
@@ -569,8 +679,12 @@ struct _dma_channel* dma_allocate_channel(uint8_t src, uint8_t dest)
 
 int dma_reset_channel(struct _dma_channel* channel)
 {
-	if (channel->state == DMA_STATE_ALLOCATED)
+	if (channel->state == DMA_STATE_ALLOCATED) {
+		/* the transfer may have been configured but never started */
+		_dma_sg_desc_free(channel->sg_list);
+		channel->sg_list = NULL;
 		return 0;
+	}
 
 	if (channel->state == DMA_STATE_STARTED)
 		return -EBUSY;
@@ -659,6 +773,11 @@ int dma_stop_transfer(struct _dma_channel* channel)
 	/* Change state to 'allocated' */
 	channel->state = DMA_STATE_ALLOCATED;
 
+	/* The descriptors of a stopped transfer are not used anymore */
+	_dma_sg_desc_free(channel->sg_list);
+	channel->sg_list = NULL;
+	channel->loop = false;
+
 	return 0;
 }
 
@@ -709,7 +828,18 @@ int dma_configure_transfer(struct _dma_channel* channel,
 	if ((list_size == 1) && (!cfg_dma->loop))
 		return _dma_configure_transfer(channel, cfg_dma, list);
 	else
-		return _dma_sg_configure_transfer(channel, cfg_dma, list, list_size);
+		return _dma_sg_configure_transfer(channel, cfg_dma, NULL, list, list_size);
+}
+
+int dma_configure_sg_transfer(struct _dma_channel* channel,
+			      struct _dma_cfg* cfg_dma,
+			      struct _dma_cfg* item_cfg,
+			      struct _dma_transfer_cfg* list, uint8_t list_size)
+{
+	if (list_size == 0 || item_cfg == NULL)
+		return -EINVAL;
+
+	return _dma_sg_configure_transfer(channel, cfg_dma, item_cfg, list, list_size);
 }
 
 uint32_t dma_get_transferred_data_len(struct _dma_channel* channel, uint8_t chunk_size, uint32_t len)
@@ -739,4 +869,82 @@ bool dma_is_transfer_done(struct _dma_channel* channel)
 		&& (channel->state != DMA_STATE_SUSPENDED));
 }
 
+void dma_prepare_memory_transfer(struct _dma_cfg* cfg,
+		struct _dma_transfer_cfg* xfer, void* dst, const void* src,
+		uint32_t len, uint32_t chunk_size)
+{
+	/* widest data width allowed by the buffers alignment */
+	uint32_t align = (uint32_t)dst | (uint32_t)src | len;
+
+	memset(cfg, 0, sizeof(*cfg));
+#ifdef DMA_DATA_WIDTH_DWORD
+	if ((align & 7) == 0)
+		cfg->data_width = DMA_DATA_WIDTH_DWORD;
+	else
+#endif
+	if ((align & 3) == 0)
+		cfg->data_width = DMA_DATA_WIDTH_WORD;
+	else if ((align & 1) == 0)
+		cfg->data_width = DMA_DATA_WIDTH_HALF_WORD;
+	else
+		cfg->data_width = DMA_DATA_WIDTH_BYTE;
+	cfg->chunk_size = chunk_size;
+	cfg->incr_saddr = true;
+	cfg->incr_daddr = true;
+
+	xfer->saddr = src;
+	xfer->daddr = dst;
+	xfer->len = len >> cfg->data_width;
+}
+
+int dma_memcpy(void* dst, const void* src, uint32_t len, struct _callback* cb)
+{
+	struct _dma_memcpy* mc = &_dma_ctrl.memcpy;
+	struct _callback _cb;
+	struct _dma_transfer_cfg xfer;
+	struct _dma_cfg cfg;
+	int err;
+
+	if (mc->busy)
+		return -EBUSY;
+
+	if (len >= CONFIG_DMA_MEMCPY_THRESHOLD && !mc->channel)
+		mc->channel = dma_allocate_channel(DMA_PERIPH_MEMORY,
+		                                   DMA_PERIPH_MEMORY);
+
+	if (len < CONFIG_DMA_MEMCPY_THRESHOLD || !mc->channel) {
+		fast_memcpy(dst, src, len);
+		callback_call(cb, NULL);
+		return 0;
+	}
+
+	dma_prepare_memory_transfer(&cfg, &xfer, dst, src, len,
+			DMA_CHUNK_SIZE_1);
+	err = dma_configure_transfer(mc->channel, &cfg, &xfer, 1);
+	if (err < 0)
+		return err;
+
+	mc->dst = dst;
+	mc->len = len;
+	callback_copy(&mc->callback, cb);
+	callback_set(&_cb, _dma_memcpy_callback, mc);
+	dma_set_callback(mc->channel, &_cb);
+
+	/* write back the source, and the destination so that no dirty line
+	 * gets evicted over the DMA data */
+	cache_clean_region(src, len);
+	cache_clean_region(dst, len);
+
+	mc->busy = true;
+	err = dma_start_transfer(mc->channel);
+	if (err < 0)
+		mc->busy = false;
+	return err;
+}
+
+bool dma_memcpy_is_busy(void)
+{
+	return _dma_ctrl.memcpy.busy;
+}
+
 /**@}*/
@@ -61,6 +61,11 @@ enum {
 
 #define DMA_PERIPH_MEMORY  0xFF
 
+/** Copies shorter than this are done by the CPU in dma_memcpy(), in bytes */
+#ifndef CONFIG_DMA_MEMCPY_THRESHOLD
+#define CONFIG_DMA_MEMCPY_THRESHOLD 1024
+#endif
+
 #define DMA_DATA_WIDTH_BYTE        0
 #define DMA_DATA_WIDTH_HALF_WORD   1
 #define DMA_DATA_WIDTH_WORD        2
@@ -132,6 +137,7 @@ struct _dma_channel {
 	volatile uint32_t rep_count;/* repeat count in auto mode */
 #endif
 	volatile uint8_t state;		/* Channel State */
+	bool loop;			/* Circular scatter/gather list */
 
 	struct _dma_sg_desc* sg_list;
 };
@@ -147,7 +153,7 @@ struct _dma_cfg {
 	uint32_t chunk_size;
 	bool incr_saddr;
 	bool incr_daddr;
-	bool loop; /* Used by scatter/gather only */
+	bool loop; /* Used by scatter/gather only, see dma_configure_transfer() */
 };
 
 struct _dma_controller {
@@ -177,11 +183,17 @@ extern void dma_initialize(bool polling);
 
 /**
  * \brief Poll for transfers completion.
- * If polling mode is enabled, this function will call callbacks for completed
- * transfers.  If interrupt mode is enabled, this function will do nothing.
+ * If polling mode is enabled, or if the interrupts are masked, this function
+ * will call callbacks for completed transfers.  Otherwise, this function will
+ * do nothing.
  */
 extern void dma_poll(void);
 
+/**
+ * \brief Tell if the driver was initialized in polling mode.
+ */
+extern bool dma_is_polling(void);
+
 /**
  * \brief Enable clock of the DMA peripheral, Enable the peripheral,
  * setup configuration register for transfer.
@@ -218,6 +230,12 @@ extern int dma_set_callback(struct _dma_channel* channel, struct _callback* call
  * \param cfg_dma DMA transfer configuration
  * \param cfg     List of transfer specific configuration
  * \list_size     0: single/multi block transfer, 1-n: scatter/gather transfer
+ *
+ * When cfg_dma->loop is set, the list is circular: the transfer never ends
+ * and the callback is invoked at the end of each item of the list, the
+ * channel staying started until dma_stop_transfer().  Items should be long
+ * enough for the callback to be run before the next one ends, as two items
+ * ending before the interrupt is handled give a single call.
  * \return error code
  */
 extern int dma_configure_transfer(struct _dma_channel* channel,
@@ -225,6 +243,27 @@ extern int dma_configure_transfer(struct _dma_channel* channel,
 				  struct _dma_transfer_cfg* list,
 				  uint8_t list_size);
 
+/**
+ * \brief Configure DMA for a scatter/gather transfer whose items have their
+ * own data width, chunk size and addressing modes.
+ *
+ * This allows a single list to mix buffers with dummy data, such as the
+ * successive phases of a SPI transaction.  The lengths of the list are in
+ * data units of each item.  The loop member of the item configurations is
+ * ignored, cfg_dma->loop is used for the whole list.
+ * \param channel   Channel pointer
+ * \param cfg_dma   DMA transfer configuration
+ * \param item_cfg  Configuration of each item of the list
+ * \param list      List of transfer specific configuration
+ * \param list_size Number of items in both lists
+ * \return error code
+ */
+extern int dma_configure_sg_transfer(struct _dma_channel* channel,
+				     struct _dma_cfg* cfg_dma,
+				     struct _dma_cfg* item_cfg,
+				     struct _dma_transfer_cfg* list,
+				     uint8_t list_size);
+
 /**
  * \brief Stop DMA transfer.
  * \param channel Channel pointer
@@ -261,6 +300,50 @@ extern int dma_reset_channel(struct _dma_channel* channel);
  */
 extern bool dma_is_transfer_done(struct _dma_channel* channel);
 
+/**
+ * \brief Prepare a memory to memory transfer with incrementing addresses.
+ *
+ * The widest data width allowed by the alignment of both buffers and of the
+ * length is selected.
+ * \param cfg        Channel configuration to fill
+ * \param xfer       Transfer configuration to fill
+ * \param dst        Destination buffer
+ * \param src        Source buffer
+ * \param len        Number of bytes to copy
+ * \param chunk_size Chunk size (DMA_CHUNK_SIZE_x)
+ */
+extern void dma_prepare_memory_transfer(struct _dma_cfg* cfg,
+		struct _dma_transfer_cfg* xfer, void* dst, const void* src,
+		uint32_t len, uint32_t chunk_size);
+
+/**
+ * \brief Copy memory asynchronously on a reserved DMA channel.
+ *
+ * A memory to memory channel is allocated on first use and kept for
+ * subsequent copies.  Copies shorter than CONFIG_DMA_MEMCPY_THRESHOLD bytes
+ * (or any copy if no channel is available) are done synchronously by the CPU
+ * with fast_memcpy(), the callback is then invoked before returning.
+ * Otherwise, the caches are maintained for both buffers and the callback is
+ * invoked from the DMA interrupt (or from dma_poll() in polling mode) once
+ * the destination is visible to the CPU.
+ *
+ * \note The destination buffer should be aligned on cache lines, as data
+ * sharing its first and last lines is invalidated at the end of the copy.
+ * \param dst Destination buffer
+ * \param src Source buffer
+ * \param len Number of bytes to copy
+ * \param cb  Callback invoked on completion, may be NULL
+ * \return 0 on success, -EBUSY if a previous copy is in progress, or an error
+ * code from the DMA driver.
+ */
+extern int dma_memcpy(void* dst, const void* src, uint32_t len,
+		      struct _callback* cb);
+
+/**
+ * \brief Tells if a copy started by dma_memcpy() is in progress.
+ */
+extern bool dma_memcpy_is_busy(void);
+
 /**
  * \brief Flush FIFO of DMA.
  * \param channel Channel pointer
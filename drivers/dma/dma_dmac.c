@@ -175,6 +175,12 @@ void dma_irq_handler(uint32_t source, void* user_arg)
 			continue;
 		if (channel->state == DMA_STATE_FREE)
 			continue;
+		if (channel->loop) {
+			/* Circular list: the channel keeps running */
+			if (gis & (DMAC_EBCISR_BTC0 << chan))
+				callback_call(&channel->callback, NULL);
+			continue;
+		}
 		if (gis & (DMAC_EBCISR_CBTC0 << chan)) {
 			if (channel->rep_count) {
 				if (channel->rep_count == 1) {
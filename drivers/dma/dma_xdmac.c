@@ -180,6 +180,13 @@ void dma_irq_handler(uint32_t source, void* user_arg)
 		if (channel->state == DMA_STATE_FREE)
 			continue;
 
+		if (channel->loop) {
+			/* Circular list: the channel keeps running */
+			if (xdmac_get_channel_isr(xdmac, chan) & XDMAC_CIS_BIS)
+				callback_call(&channel->callback, NULL);
+			continue;
+		}
+
 		if (!(gcs & (1 << chan))) {
 			uint32_t cis = xdmac_get_channel_isr(xdmac, chan);
 
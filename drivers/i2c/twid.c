@@ -57,17 +57,11 @@
 #define TWID_POLLING_THRESHOLD  16
 #define TWID_TIMEOUT            100
 
-/** \brief twi asynchronous transfer descriptor.*/
+/** \brief twi slave asynchronous descriptor.*/
 struct _async_desc
 {
-	bool master;
-	union {
-		struct _twi_desc *twi_desc;
-		struct _twi_slave_desc *twi_slave_desc;
-	};
+	struct _twi_slave_desc *twi_slave_desc;
 	uint32_t twi_id;
-	struct _buffer buf;
-	uint32_t transferred; /**< Number of already transferred bytes. */
 };
 
 /*----------------------------------------------------------------------------
@@ -177,12 +171,14 @@ static int _twid_dma_read_callback(void* arg, void* arg2)
 {
 	struct _twi_desc* desc = (struct _twi_desc *)arg;
 
-	cache_invalidate_region(desc->dma.rx.cfg.daddr, desc->dma.rx.cfg.len);
+	cache_invalidate_region(desc->dma.rx.cfg.daddr,
+		desc->dma.rx.cfg.len * DMA_DATA_WIDTH_IN_BYTE(desc->dma.rx.cfg_dma.data_width));
 
 	dma_reset_channel(desc->dma.rx.channel);
 
 	if (_check_rx_timeout(desc)) {
 		mutex_unlock(&desc->mutex);
+		callback_call(&desc->callback, (void*)-ETIMEDOUT);
 		return -ETIMEDOUT;
 	}
 
@@ -197,6 +193,7 @@ static int _twid_dma_read_callback(void* arg, void* arg2)
 
 		if (_check_rx_timeout(desc)) {
 			mutex_unlock(&desc->mutex);
+			callback_call(&desc->callback, (void*)-ETIMEDOUT);
 			return -ETIMEDOUT;
 		}
 
@@ -228,7 +225,9 @@ static void _twid_dma_read(struct _twi_desc* desc, struct _buffer* buffer)
 			desc->addr->TWI_FMR = (desc->addr->TWI_FMR & ~TWI_FMR_RXRDYM_Msk) | TWI_FMR_RXRDYM_ONE_DATA;
 			desc->dma.rx.cfg_dma.data_width = DMA_DATA_WIDTH_BYTE;
 		}
-		desc->dma.rx.cfg.len = buffer->size;
+		/* the DMA length is in data units: one DMA request per
+		 * RXRDYM threshold, i.e. up to four bytes per bus access */
+		desc->dma.rx.cfg.len = buffer->size / DMA_DATA_WIDTH_IN_BYTE(desc->dma.rx.cfg_dma.data_width);
 	} else {
 		desc->dma.rx.cfg.len = buffer->size - 2;
 		desc->addr->TWI_FMR = (desc->addr->TWI_FMR & ~TWI_FMR_RXRDYM_Msk) | TWI_FMR_RXRDYM_ONE_DATA;
@@ -255,6 +254,7 @@ static int _twid_dma_write_callback(void* arg, void* arg2)
 
 	if (_check_tx_timeout(desc)) {
 		mutex_unlock(&desc->mutex);
+		callback_call(&desc->callback, (void*)-ETIMEDOUT);
 		return -ETIMEDOUT;
 	}
 
@@ -293,7 +293,7 @@ static void _twid_dma_write(struct _twi_desc* desc, struct _buffer* buffer)
 			desc->addr->TWI_FMR = (desc->addr->TWI_FMR & ~TWI_FMR_TXRDYM_Msk) | TWI_FMR_TXRDYM_ONE_DATA;
 			desc->dma.tx.cfg_dma.data_width = DMA_DATA_WIDTH_BYTE;
 		}
-		desc->dma.tx.cfg.len = buffer->size;
+		desc->dma.tx.cfg.len = buffer->size / DMA_DATA_WIDTH_IN_BYTE(desc->dma.tx.cfg_dma.data_width);
 	} else {
 		desc->addr->TWI_FMR = (desc->addr->TWI_FMR & ~TWI_FMR_TXRDYM_Msk) | TWI_FMR_TXRDYM_ONE_DATA;
 		desc->dma.tx.cfg.len = buffer->size - 1;
@@ -306,12 +306,13 @@ static void _twid_dma_write(struct _twi_desc* desc, struct _buffer* buffer)
 	dma_configure_transfer(desc->dma.tx.channel, &desc->dma.tx.cfg_dma, &desc->dma.tx.cfg, 1);
 	callback_set(&_cb, _twid_dma_write_callback, (void*)desc);
 	dma_set_callback(desc->dma.tx.channel, &_cb);
-	cache_clean_region(desc->dma.tx.cfg.saddr, desc->dma.tx.cfg.len);
+	cache_clean_region(desc->dma.tx.cfg.saddr,
+		desc->dma.tx.cfg.len * DMA_DATA_WIDTH_IN_BYTE(desc->dma.tx.cfg_dma.data_width));
 	dma_start_transfer(desc->dma.tx.channel);
 }
 
 /*
- *
+ * Master interrupt handler, registered once by twid_configure()
  */
 static void _twid_handler(uint32_t source, void* user_arg)
 {
@@ -319,13 +320,13 @@ static void _twid_handler(uint32_t source, void* user_arg)
 	Twi* addr;
 	uint32_t buf_size;
 	bool use_fifo = false;
-	struct _async_desc* adesc = (struct _async_desc*)user_arg;
+	struct _twi_desc* desc = (struct _twi_desc*)user_arg;
 
-	addr = adesc->twi_desc->addr;
+	addr = desc->addr;
 	status = twi_get_masked_status(addr);
 
 #if defined(CONFIG_HAVE_TWI_FIFO)
-	use_fifo = adesc->twi_desc->use_fifo;
+	use_fifo = desc->use_fifo;
 #endif
 
 	if (TWI_STATUS_RXRDY(status)) {
@@ -333,88 +334,86 @@ static void _twid_handler(uint32_t source, void* user_arg)
 #ifdef CONFIG_HAVE_TWI_FIFO
 			uint8_t size = twi_fifo_get_rx_size(addr);
 
-			adesc->transferred += twi_fifo_read(addr, &adesc->buf.data[adesc->transferred], size);
+			desc->async.transferred += twi_fifo_read(addr, &desc->async.buf.data[desc->async.transferred], size);
 
-			if ((adesc->buf.size - adesc->transferred) >= 4)
+			if ((desc->async.buf.size - desc->async.transferred) >= 4)
 				addr->TWI_FMR = (addr->TWI_FMR & ~TWI_FMR_RXRDYM_Msk) | TWI_FMR_RXRDYM_FOUR_DATA;
-			else if ((adesc->buf.size - adesc->transferred) >= 2)
+			else if ((desc->async.buf.size - desc->async.transferred) >= 2)
 				addr->TWI_FMR = (addr->TWI_FMR & ~TWI_FMR_RXRDYM_Msk) | TWI_FMR_RXRDYM_TWO_DATA;
 			else
 				addr->TWI_FMR = (addr->TWI_FMR & ~TWI_FMR_RXRDYM_Msk) | TWI_FMR_RXRDYM_ONE_DATA;
 
-			buf_size = adesc->buf.size;
+			buf_size = desc->async.buf.size;
 #endif /* CONFIG_HAVE_TWI_FIFO */
 		} else {
-			adesc->buf.data[adesc->transferred] = twi_read_byte(addr);
-			adesc->transferred++;
-			buf_size = adesc->buf.size - 1;
+			desc->async.buf.data[desc->async.transferred] = twi_read_byte(addr);
+			desc->async.transferred++;
+			buf_size = desc->async.buf.size - 1;
 		}
 
 		/* Only one byte remaining, send stop condition */
-		if (adesc->transferred == buf_size)
-			if (adesc->twi_desc->flags & BUS_I2C_BUF_ATTR_STOP)
+		if (desc->async.transferred == buf_size)
+			if (desc->flags & BUS_I2C_BUF_ATTR_STOP)
 				twi_send_stop_condition(addr);
 
-		if (adesc->transferred == adesc->buf.size) {
+		if (desc->async.transferred == desc->async.buf.size) {
 			twi_disable_it(addr, TWI_IDR_RXRDY);
-			if (adesc->twi_desc->flags & BUS_I2C_BUF_ATTR_STOP) {
+			if (desc->flags & BUS_I2C_BUF_ATTR_STOP) {
 				twi_enable_it(addr, TWI_IER_TXCOMP);
 			} else {
-				adesc->twi_id = 0;
-				mutex_unlock(&adesc->twi_desc->mutex);
+				mutex_unlock(&desc->mutex);
+				callback_call(&desc->callback, NULL);
 			}
 		}
 	} else if (TWI_STATUS_TXRDY(status)) {
 		if (use_fifo) {
 #ifdef CONFIG_HAVE_TWI_FIFO
 			uint8_t len = 0;
-			uint8_t size = adesc->twi_desc->fifo.tx.size - twi_fifo_get_tx_size(addr);
+			uint8_t size = desc->fifo.tx.size - twi_fifo_get_tx_size(addr);
 
-			if ((adesc->buf.size - adesc->transferred) > size)
+			if ((desc->async.buf.size - desc->async.transferred) > size)
 				len = size;
 			else
-				len = adesc->buf.size - adesc->transferred;
-			adesc->transferred += twi_fifo_write(addr, &adesc->buf.data[adesc->transferred], len);
+				len = desc->async.buf.size - desc->async.transferred;
+			desc->async.transferred += twi_fifo_write(addr, &desc->async.buf.data[desc->async.transferred], len);
 
 			/* Transfer finished ? */
-			if (adesc->transferred == adesc->buf.size)
-				if (adesc->twi_desc->flags & BUS_I2C_BUF_ATTR_STOP)
+			if (desc->async.transferred == desc->async.buf.size)
+				if (desc->flags & BUS_I2C_BUF_ATTR_STOP)
 					twi_send_stop_condition(addr);
 
-			if ((adesc->buf.size - adesc->transferred) >= 4)
+			if ((desc->async.buf.size - desc->async.transferred) >= 4)
 				addr->TWI_FMR = (addr->TWI_FMR & ~TWI_FMR_TXRDYM_Msk) | TWI_FMR_TXRDYM_FOUR_DATA;
-			else if ((adesc->buf.size - adesc->transferred) >= 2)
+			else if ((desc->async.buf.size - desc->async.transferred) >= 2)
 				addr->TWI_FMR = (addr->TWI_FMR & ~TWI_FMR_TXRDYM_Msk) | TWI_FMR_TXRDYM_TWO_DATA;
 			else
 				addr->TWI_FMR = (addr->TWI_FMR & ~TWI_FMR_TXRDYM_Msk) | TWI_FMR_TXRDYM_ONE_DATA;
 #endif /* CONFIG_HAVE_TWI_FIFO */
 		} else {
 			/* Transfer finished ? */
-			if (adesc->transferred == adesc->buf.size - 1)
-				if (adesc->twi_desc->flags & BUS_I2C_BUF_ATTR_STOP)
+			if (desc->async.transferred == desc->async.buf.size - 1)
+				if (desc->flags & BUS_I2C_BUF_ATTR_STOP)
 					twi_send_stop_condition(addr);
 
-			twi_write_byte(addr, adesc->buf.data[adesc->transferred]);
-			adesc->transferred++;
+			twi_write_byte(addr, desc->async.buf.data[desc->async.transferred]);
+			desc->async.transferred++;
 		}
 
-		if (adesc->transferred >= adesc->buf.size){
+		if (desc->async.transferred >= desc->async.buf.size){
 			twi_disable_it(addr, TWI_IDR_TXRDY);
-			if (adesc->twi_desc->flags & BUS_I2C_BUF_ATTR_STOP) {
+			if (desc->flags & BUS_I2C_BUF_ATTR_STOP) {
 				twi_enable_it(addr, TWI_IER_TXCOMP);
 			} else {
-				adesc->twi_id = 0;
-				mutex_unlock(&adesc->twi_desc->mutex);
+				mutex_unlock(&desc->mutex);
+				callback_call(&desc->callback, NULL);
 			}
 		}
 	}
 	/* Transfer complete*/
 	else if (TWI_STATUS_TXCOMP(status)) {
-		irq_disable(adesc->twi_id);
 		twi_disable_it(addr, TWI_IDR_TXCOMP);
-		adesc->twi_id = 0;
-		mutex_unlock(&adesc->twi_desc->mutex);
-		callback_call(&adesc->twi_desc->callback, NULL);
+		mutex_unlock(&desc->mutex);
+		callback_call(&desc->callback, NULL);
 	}
 }
 
@@ -643,7 +642,6 @@ static void _twid_slave_handler(uint32_t source, void* user_arg)
 static int _twid_transfer(struct _twi_desc* desc, struct _buffer* buf,  struct _callback* cb)
 {
 	int err = 0;
-	uint32_t id;
 	uint8_t tmode;
 
 	if (!mutex_try_lock(&desc->mutex))
@@ -653,10 +651,13 @@ static int _twid_transfer(struct _twi_desc* desc, struct _buffer* buf,  struct _
 	desc->flags = buf->attr;
 	tmode = desc->transfer_mode;
 
-	/* If short transfer detected, use POLLING mode */
+	/* Short buffers are polled from thread context. From an interrupt
+	 * handler (e.g. chained from the completion of the previous buffer),
+	 * they are interrupt driven so as not to hold the CPU meanwhile. */
 	if (tmode != BUS_TRANSFER_MODE_POLLING) {
 		if (buf->size < TWID_POLLING_THRESHOLD)
-			tmode = BUS_TRANSFER_MODE_POLLING;
+			tmode = irq_is_in_handler() ? BUS_TRANSFER_MODE_ASYNC
+			                            : BUS_TRANSFER_MODE_POLLING;
 	}
 
 	if (desc->flags & BUS_I2C_BUF_ATTR_START) {
@@ -667,7 +668,9 @@ static int _twid_transfer(struct _twi_desc* desc, struct _buffer* buf,  struct _
 				twi_fifo_flush_tx(desc->addr);
 #endif
 		} else {
-			twi_init_read(desc->addr, desc->slave_addr, 0, 0);
+			/* the internal address bytes, if any, are sent by
+			 * the controller, followed by a repeated start */
+			twi_init_read(desc->addr, desc->slave_addr, desc->xfer.iaddr, desc->xfer.isize);
 #ifdef CONFIG_HAVE_TWI_FIFO
 			if (desc->use_fifo)
 				twi_fifo_flush_rx(desc->addr);
@@ -677,25 +680,15 @@ static int _twid_transfer(struct _twi_desc* desc, struct _buffer* buf,  struct _
 
 	switch (tmode) {
 	case BUS_TRANSFER_MODE_ASYNC:
-		/* Copy descriptor to async descriptor */
-		async_desc[adesc_index].twi_desc = desc;
-		/* Init param used by interrupt handler */
-		async_desc[adesc_index].transferred = 0;
-		async_desc[adesc_index].buf.data = buf->data;
-		async_desc[adesc_index].buf.size = buf->size;
-		async_desc[adesc_index].buf.attr = buf->attr;
-		id = get_twi_id_from_addr(desc->addr);
-		async_desc[adesc_index].twi_id = id;
-
-		/* Set TWI handler */
-		irq_add_handler(id, _twid_handler, &async_desc[adesc_index]);
-		/* Enable TWI interrupt */
-		irq_enable(id);
+		/* Init param used by interrupt handler, set by twid_configure() */
+		desc->async.transferred = 0;
+		desc->async.buf.data = buf->data;
+		desc->async.buf.size = buf->size;
+		desc->async.buf.attr = buf->attr;
 
 		if (desc->flags & BUS_BUF_ATTR_TX) {
 			if (_check_tx_timeout(desc)) {
 				twi_disable_it(desc->addr, TWI_IER_TXRDY);
-				irq_disable(id);
 				return -ETIMEDOUT;
 			}
 
@@ -705,7 +698,7 @@ static int _twid_transfer(struct _twi_desc* desc, struct _buffer* buf,  struct _
 #endif /* CONFIG_HAVE_TWI_FIFO */
 
 			/* Start twi with send first byte */
-			async_desc[adesc_index].transferred = 1;
+			desc->async.transferred = 1;
 			twi_enable_it(desc->addr, TWI_IER_TXRDY);
 			twi_write_byte(desc->addr, buf->data[0]);
 		} else {
@@ -720,8 +713,6 @@ static int _twid_transfer(struct _twi_desc* desc, struct _buffer* buf,  struct _
 			if (desc->flags & BUS_I2C_BUF_ATTR_START)
 				twi_send_start_condition(desc->addr);
 		}
-
-		adesc_index = (adesc_index + 1) % TWI_IFACE_COUNT;
 		break;
 
 	case BUS_TRANSFER_MODE_POLLING:
@@ -730,9 +721,10 @@ static int _twid_transfer(struct _twi_desc* desc, struct _buffer* buf,  struct _
 		else
 			err = _twid_poll_read(desc, buf);
 
+		/* unlock first: the callback may start the next buffer */
+		mutex_unlock(&desc->mutex);
 		if (err == 0)
 			callback_call(&desc->callback, NULL);
-		mutex_unlock(&desc->mutex);
 		break;
 
 	case BUS_TRANSFER_MODE_DMA:
@@ -750,6 +742,104 @@ static int _twid_transfer(struct _twi_desc* desc, struct _buffer* buf,  struct _
 	return err;
 }
 
+static void _twid_configure_master(struct _twi_desc* desc)
+{
+	/* twi_configure_master() resets the controller, FIFO setup included */
+	twi_configure_master(desc->addr, desc->freq);
+#ifdef CONFIG_HAVE_TWI_FIFO
+	twid_fifo_configure(desc);
+	if (desc->use_fifo)
+		twi_fifo_enable(desc->addr, true);
+#endif
+}
+
+static int _twid_mck_notify(void* arg, void* arg2)
+{
+	struct _twi_desc* desc = (struct _twi_desc*)arg;
+	enum _pmc_mck_event event = (enum _pmc_mck_event)arg2;
+
+	if (event == PMC_MCK_PRE_CHANGE) {
+		/* Hold the bus until the clock dividers are updated */
+		while (!mutex_try_lock(&desc->mutex)) {
+			if (desc->transfer_mode == BUS_TRANSFER_MODE_DMA)
+				dma_poll();
+		}
+	} else {
+		_twid_configure_master(desc);
+		mutex_unlock(&desc->mutex);
+	}
+
+	return 0;
+}
+
+/*
+ * A short write opening the transfer and followed by a read with a
+ * (repeated) start is a register address: it is sent by the controller
+ * from TWI_IADR as part of the read.
+ */
+static bool _twid_is_iaddr(const struct _buffer* buf, int index, int buffers)
+{
+	if ((index + 1) >= buffers)
+		return false;
+	if (buf[index].attr != (BUS_I2C_BUF_ATTR_START | BUS_BUF_ATTR_TX))
+		return false;
+	if (buf[index].size == 0 || buf[index].size > 3)
+		return false;
+	return (buf[index + 1].attr & (BUS_I2C_BUF_ATTR_START | BUS_BUF_ATTR_RX)) ==
+		(BUS_I2C_BUF_ATTR_START | BUS_BUF_ATTR_RX);
+}
+
+static int _twid_transfer_next(void* arg, void* arg2);
+
+static int _twid_transfer_buffer(struct _twi_desc* desc)
+{
+	struct _callback _cb;
+	struct _buffer* buf = desc->xfer.buf;
+	int i;
+
+	desc->xfer.iaddr = 0;
+	desc->xfer.isize = 0;
+	if (_twid_is_iaddr(buf, desc->xfer.index, desc->xfer.buffers)) {
+		for (i = 0 ; i < buf[desc->xfer.index].size ; i++)
+			desc->xfer.iaddr = (desc->xfer.iaddr << 8) | buf[desc->xfer.index].data[i];
+		desc->xfer.isize = buf[desc->xfer.index].size;
+		desc->xfer.index++;
+		desc->stats.combined++;
+	}
+
+	callback_set(&_cb, _twid_transfer_next, (void*)desc);
+	return _twid_transfer(desc, &buf[desc->xfer.index], &_cb);
+}
+
+static void _twid_transfer_done(struct _twi_desc* desc, int err)
+{
+	uint32_t elapsed = (uint32_t)(timer_get_us() - desc->xfer.start_us);
+
+	desc->stats.transfers++;
+	if (err < 0)
+		desc->stats.errors++;
+	desc->stats.last_us = elapsed;
+	desc->stats.total_us += elapsed;
+	if (elapsed > desc->stats.max_us)
+		desc->stats.max_us = elapsed;
+}
+
+static int _twid_transfer_next(void* arg, void* arg2)
+{
+	struct _twi_desc* desc = (struct _twi_desc*)arg;
+	int err = (int)arg2;
+
+	if (err == 0 && ++desc->xfer.index < desc->xfer.buffers) {
+		err = _twid_transfer_buffer(desc);
+		if (err == 0)
+			return 0;
+	}
+
+	_twid_transfer_done(desc, err);
+	callback_call(&desc->xfer.callback, (void*)err);
+	return err;
+}
+
 /*----------------------------------------------------------------------------
  *        External functions
  *----------------------------------------------------------------------------*/
@@ -769,14 +859,14 @@ int twid_configure(struct _twi_desc* desc)
 #endif
 
 	pmc_configure_peripheral(id, NULL, true);
-	twi_configure_master(desc->addr, desc->freq);
-#ifdef CONFIG_HAVE_TWI_FIFO
-	twid_fifo_configure(desc);
-	if (desc->use_fifo)
-		twi_fifo_enable(desc->addr, true);
-#endif
+	_twid_configure_master(desc);
+
+	/* Register the handler once: transfers only enable the sources.
+	 * twid_configure() is also called on errors, keep it cheap. */
+	irq_add_handler(id, _twid_handler, desc);
+	irq_enable(id);
 
-	if (desc->transfer_mode == BUS_TRANSFER_MODE_DMA) {
+	if (desc->transfer_mode == BUS_TRANSFER_MODE_DMA && !desc->dma.rx.channel) {
 		desc->dma.tx.channel = dma_allocate_channel(DMA_PERIPH_MEMORY, id);
 		assert(desc->dma.tx.channel);
 
@@ -796,6 +886,9 @@ int twid_configure(struct _twi_desc* desc)
 
 	desc->mutex = 0;
 
+	callback_set(&desc->mck_notifier.callback, _twid_mck_notify, desc);
+	pmc_register_mck_notifier(&desc->mck_notifier);
+
 	return 0;
 }
 
@@ -835,7 +928,7 @@ int twid_transfer(struct _twi_desc* desc, struct _buffer* buf, int buffers, stru
 	int b;
 	int err;
 
-	if (buf == NULL)
+	if (buf == NULL || buffers <= 0)
 		return -EINVAL;
 
 	for (b = 0 ; b < buffers ; b++) {
@@ -845,22 +938,46 @@ int twid_transfer(struct _twi_desc* desc, struct _buffer* buf, int buffers, stru
 		if ((buf[b].attr & (BUS_BUF_ATTR_TX | BUS_BUF_ATTR_RX)) == (BUS_BUF_ATTR_TX | BUS_BUF_ATTR_RX))
 			return -EINVAL;
 
-		if (b == (buffers - 1)) {
-			err = _twid_transfer(desc, &buf[b], cb);
-		} else {
 #if defined(CONFIG_SOC_SAM9XX5) || defined(CONFIG_SOC_SAMA5D3)
-			/* workaround for IP versions that do not support manual restart */
-			if (buf[b + 1].attr & BUS_I2C_BUF_ATTR_START)
-				buf[b].attr |= BUS_I2C_BUF_ATTR_STOP;
+		/* workaround for IP versions that do not support manual restart,
+		 * not needed when the repeated start is done by the controller */
+		if (b < (buffers - 1) && (buf[b + 1].attr & BUS_I2C_BUF_ATTR_START) &&
+		    !_twid_is_iaddr(buf, b, buffers))
+			buf[b].attr |= BUS_I2C_BUF_ATTR_STOP;
 #endif
-			err = _twid_transfer(desc, &buf[b], NULL);
-		}
-		if (err < 0)
-			return err;
-		twid_wait_transfer(desc);
 	}
 
-	return 0;
+	if (twid_is_busy(desc))
+		return -EBUSY;
+
+	desc->xfer.buf = buf;
+	desc->xfer.buffers = buffers;
+	desc->xfer.index = 0;
+	desc->xfer.start_us = timer_get_us();
+	callback_copy(&desc->xfer.callback, cb);
+
+	/* The next buffers are started from the completion callback of
+	 * the previous one, so that the transfer can be issued from
+	 * interrupt context (e.g. by the bus request queue). */
+	err = _twid_transfer_buffer(desc);
+	if (err < 0)
+		_twid_transfer_done(desc, err);
+	return err;
+}
+
+void twid_get_stats(const struct _twi_desc* desc, struct _twid_stats* stats)
+{
+	*stats = desc->stats;
+}
+
+void twid_reset_stats(struct _twi_desc* desc)
+{
+	memset(&desc->stats, 0, sizeof(desc->stats));
+}
+
+void twid_poll(struct _twi_desc* desc)
+{
+	_twid_handler(get_twi_id_from_addr(desc->addr), desc);
 }
 
 bool twid_is_busy(const struct _twi_desc* desc)
@@ -39,11 +39,22 @@
 #include "i2c/twi.h"
 #include "io.h"
 #include "mutex.h"
+#include "peripherals/pmc.h"
 
 /*------------------------------------------------------------------------------
  *        Types
  *----------------------------------------------------------------------------*/
 
+/** \brief Transfer counters of a TWI master (twid_get_stats()) */
+struct _twid_stats {
+	uint32_t transfers;  /**< calls to twid_transfer() completed */
+	uint32_t combined;   /**< register address sent from TWI_IADR */
+	uint32_t errors;
+	uint32_t last_us;    /**< latency of the last transfer */
+	uint32_t max_us;
+	uint64_t total_us;
+};
+
 struct _twi_desc
 {
 	Twi*  addr;
@@ -72,6 +83,27 @@ struct _twi_desc
 			struct _dma_transfer_cfg cfg;
 		} rx, tx;
 	} dma;
+
+	/* buffers of the transfer in progress, chained from completion */
+	struct {
+		struct _buffer* buf;
+		int buffers;
+		int index;
+		uint32_t iaddr;
+		uint8_t isize;
+		uint64_t start_us;
+		struct _callback callback;
+	} xfer;
+
+	/* state of the interrupt handler (BUS_TRANSFER_MODE_ASYNC) */
+	struct {
+		struct _buffer buf;
+		uint32_t transferred;
+	} async;
+
+	struct _twid_stats stats;
+
+	struct _pmc_mck_notifier mck_notifier;
 };
 
 struct _twi_slave_ops {
@@ -102,6 +134,13 @@ extern int twid_transfer(struct _twi_desc* desc, struct _buffer* buf, int buffer
 
 extern bool twid_is_busy(const struct _twi_desc* desc);
 
+/* Run the interrupt handler, to wait with the interrupts masked */
+extern void twid_poll(struct _twi_desc* desc);
+
 extern void twid_wait_transfer(const struct _twi_desc* desc);
 
+extern void twid_get_stats(const struct _twi_desc* desc, struct _twid_stats* stats);
+
+extern void twid_reset_stats(struct _twi_desc* desc);
+
 #endif /* TWID_H_ */
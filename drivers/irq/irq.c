@@ -41,8 +41,23 @@
 #include "irq/nvic.h"
 #endif
 
+#include "irqflags.h"
+
 #include <assert.h>
 
+#ifdef CONFIG_IRQ_PROFILE
+#include <stdio.h>
+#include <string.h>
+
+#include "cycle_counter.h"
+#include "intmath.h"
+#include "peripherals/pmc.h"
+
+#ifndef CONFIG_HAVE_CYCLE_COUNTER
+#error CONFIG_IRQ_PROFILE requires a cycle counter (ARMv7-A PMU or ARMv7-M DWT)
+#endif
+#endif
+
 /*------------------------------------------------------------------------------
  *         Local types
  *------------------------------------------------------------------------------*/
@@ -53,6 +68,13 @@ struct handler_entry {
 	struct handler_entry* next;
 };
 
+/** Direct dispatch entry, handler is NULL unless exactly one handler is
+ * registered for the source */
+struct _irq_vector {
+	irq_handler_t handler;
+	void* user_arg;
+};
+
 /*------------------------------------------------------------------------------
  *         Local variables
  *------------------------------------------------------------------------------*/
@@ -60,6 +82,19 @@ struct handler_entry {
 static struct handler_entry  handlers_pool[ID_PERIPH_COUNT * 2];
 static struct handler_entry* next_free_handler;
 static struct handler_entry* handlers[ID_PERIPH_COUNT];
+static struct _irq_vector vectors[ID_PERIPH_COUNT];
+
+/** Number of nested handlers in progress */
+static volatile uint32_t depth;
+
+#ifdef CONFIG_IRQ_PROFILE
+static struct _irq_profile profiles[ID_PERIPH_COUNT];
+
+static struct {
+	irq_latency_probe_t probe;
+	void* user_arg;
+} latency_probes[ID_PERIPH_COUNT];
+#endif
 
 /*------------------------------------------------------------------------------
  *         Local functions
@@ -99,10 +134,144 @@ static void _free_handler(struct handler_entry* entry)
 	next_free_handler = entry;
 }
 
+#ifdef CONFIG_IRQ_PROFILE
+
+static uint32_t _profile_bucket(uint32_t cycles)
+{
+	uint32_t bucket = fls(cycles >> IRQ_PROFILE_HIST_SHIFT);
+	return bucket < IRQ_PROFILE_HIST_BUCKETS ? bucket : IRQ_PROFILE_HIST_BUCKETS - 1;
+}
+
+static void _profile_record(uint32_t source, uint32_t duration, bool shared,
+		uint32_t nesting, bool has_latency, uint32_t latency)
+{
+	struct _irq_profile* p = &profiles[source];
+
+	if (has_latency) {
+		if (p->latency_count == 0 || latency < p->latency_min)
+			p->latency_min = latency;
+		if (latency > p->latency_max)
+			p->latency_max = latency;
+		p->latency_total += latency;
+		p->latency_hist[_profile_bucket(latency)]++;
+		p->latency_count++;
+	}
+	if (p->count == 0 || duration < p->duration_min)
+		p->duration_min = duration;
+	if (duration > p->duration_max)
+		p->duration_max = duration;
+	p->duration_total += duration;
+	p->duration_hist[_profile_bucket(duration)]++;
+	if (shared)
+		p->shared++;
+	if (nesting > 1)
+		p->nested++;
+	if (nesting > p->max_depth)
+		p->max_depth = nesting;
+	p->count++;
+}
+
+#endif /* CONFIG_IRQ_PROFILE */
+
+/**
+ * \brief Refresh the direct dispatch entry of a source from its handler
+ * chain.  Must be called with interrupts masked.
+ */
+static void _update_vector(uint32_t source)
+{
+	struct handler_entry* entry = handlers[source];
+
+	if (entry && !entry->next) {
+		vectors[source].handler = entry->handler;
+		vectors[source].user_arg = entry->user_arg;
+	} else {
+		vectors[source].handler = NULL;
+		vectors[source].user_arg = NULL;
+	}
+}
+
+static void _irq_dispatch(uint32_t source)
+{
+	irq_handler_t handler = vectors[source].handler;
+	struct handler_entry *entry;
+#ifdef CONFIG_IRQ_PROFILE
+	irq_latency_probe_t probe = latency_probes[source].probe;
+	uint32_t latency = probe ? probe(source, latency_probes[source].user_arg) : 0;
+	uint32_t nesting = depth + 1;
+	uint32_t start_cycles = cycle_counter_read();
+#endif
+
+	depth++;
+	if (handler) {
+		/* single handler: call it directly */
+		handler(source, vectors[source].user_arg);
+	} else {
+		/* shared source: walk the chain */
+		entry = handlers[source];
+		if (!entry) {
+			// no handler for interrupt, block
+			while (1);
+		}
+
+		while (entry) {
+			if (entry->handler)
+				entry->handler(source, entry->user_arg);
+			entry = entry->next;
+		}
+	}
+	depth--;
+
+#ifdef CONFIG_IRQ_PROFILE
+	_profile_record(source, cycle_counter_read() - start_cycles,
+			handler == NULL, nesting, probe != NULL, latency);
+#endif
+}
+
+/* One vector per source, so that the interrupt controller hands over the
+ * source number directly instead of having it read back from AIC_ISR/IPSR */
+
+#if ID_PERIPH_COUNT > 80
+#error Not enough IRQ vectors, please extend the vector table
+#endif
+
+#define _IRQ_VECTOR(n) \
+	static void _irq_vector_##n(void) { _irq_dispatch(n); }
+#define _IRQ_VECTORS_10(d) \
+	_IRQ_VECTOR(d##0) _IRQ_VECTOR(d##1) _IRQ_VECTOR(d##2) \
+	_IRQ_VECTOR(d##3) _IRQ_VECTOR(d##4) _IRQ_VECTOR(d##5) \
+	_IRQ_VECTOR(d##6) _IRQ_VECTOR(d##7) _IRQ_VECTOR(d##8) \
+	_IRQ_VECTOR(d##9)
+
+#define _IRQ_VECTOR_REF(n) _irq_vector_##n,
+#define _IRQ_VECTOR_REFS_10(d) \
+	_IRQ_VECTOR_REF(d##0) _IRQ_VECTOR_REF(d##1) _IRQ_VECTOR_REF(d##2) \
+	_IRQ_VECTOR_REF(d##3) _IRQ_VECTOR_REF(d##4) _IRQ_VECTOR_REF(d##5) \
+	_IRQ_VECTOR_REF(d##6) _IRQ_VECTOR_REF(d##7) _IRQ_VECTOR_REF(d##8) \
+	_IRQ_VECTOR_REF(d##9)
+
+_IRQ_VECTORS_10()
+_IRQ_VECTORS_10(1)
+_IRQ_VECTORS_10(2)
+_IRQ_VECTORS_10(3)
+_IRQ_VECTORS_10(4)
+_IRQ_VECTORS_10(5)
+_IRQ_VECTORS_10(6)
+_IRQ_VECTORS_10(7)
+
+static void (* const irq_vectors[])(void) = {
+	_IRQ_VECTOR_REFS_10()
+	_IRQ_VECTOR_REFS_10(1)
+	_IRQ_VECTOR_REFS_10(2)
+	_IRQ_VECTOR_REFS_10(3)
+	_IRQ_VECTOR_REFS_10(4)
+	_IRQ_VECTOR_REFS_10(5)
+	_IRQ_VECTOR_REFS_10(6)
+	_IRQ_VECTOR_REFS_10(7)
+};
+
 static void _default_irq_handler(void)
 {
 	uint32_t source;
-	struct handler_entry *entry;
 
 #if defined(CONFIG_HAVE_AIC2) || defined(CONFIG_HAVE_AIC5)
 	source = aic_get_current_interrupt_source();
@@ -112,17 +281,7 @@ static void _default_irq_handler(void)
 #error Unknown IRQ controller!
 #endif
 
-	entry = handlers[source];
-	if (!entry) {
-		// no handler for interrupt, block
-		while (1);
-	}
-
-	while (entry) {
-		if (entry->handler)
-			entry->handler(source, entry->user_arg);
-		entry = entry->next;
-	}
+	_irq_dispatch(source);
 }
 
 /*----------------------------------------------------------------------------
@@ -131,7 +290,19 @@ static void _default_irq_handler(void)
 
 void irq_initialize(void)
 {
+	uint32_t source;
+
 	_initialize_handlers_pool();
+	for (source = 0; source < ID_PERIPH_COUNT; source++) {
+		handlers[source] = NULL;
+		vectors[source].handler = NULL;
+		vectors[source].user_arg = NULL;
+	}
+
+#ifdef CONFIG_IRQ_PROFILE
+	cycle_counter_enable();
+	irq_profile_reset();
+#endif
 
 #if defined(CONFIG_HAVE_AIC2) || defined(CONFIG_HAVE_AIC5)
 	aic_initialize(_default_irq_handler);
@@ -140,6 +311,14 @@ void irq_initialize(void)
 #else
 #error Unknown IRQ controller!
 #endif
+
+	for (source = 0; source < ID_PERIPH_COUNT; source++) {
+#if defined(CONFIG_HAVE_AIC2) || defined(CONFIG_HAVE_AIC5)
+		aic_set_source_vector(source, irq_vectors[source]);
+#elif defined(CONFIG_HAVE_NVIC)
+		nvic_set_source_vector(source, irq_vectors[source]);
+#endif
+	}
 }
 
 void irq_configure_mode(uint32_t source, enum _irq_mode mode)
@@ -167,12 +346,15 @@ void irq_configure_priority(uint32_t source, uint8_t priority)
 void irq_add_handler(uint32_t source, irq_handler_t handler, void* user_arg)
 {
 	struct handler_entry* entry;
+	uint32_t flags = arch_irq_save();
 
 	/* check if handler is already registered */
 	entry = handlers[source];
 	while (entry) {
 		if (entry->handler == handler) {
 			entry->user_arg = user_arg;
+			_update_vector(source);
+			arch_irq_restore(flags);
 			return;
 		}
 		entry = entry->next;
@@ -184,12 +366,16 @@ void irq_add_handler(uint32_t source, irq_handler_t handler, void* user_arg)
 	entry->user_arg = user_arg;
 	entry->next = handlers[source];
 	handlers[source] = entry;
+	_update_vector(source);
+
+	arch_irq_restore(flags);
 }
 
 void irq_remove_handler(uint32_t source, irq_handler_t handler)
 {
 	struct handler_entry* prev;
 	struct handler_entry* cur;
+	uint32_t flags = arch_irq_save();
 
 	/* remove handler from linked list */
 	prev = NULL;
@@ -198,11 +384,17 @@ void irq_remove_handler(uint32_t source, irq_handler_t handler)
 		if (cur->handler == handler) {
 			if (prev)
 				prev->next = cur->next;
+			else
+				handlers[source] = cur->next;
 			_free_handler(cur);
-			return;
+			break;
 		}
+		prev = cur;
 		cur = cur->next;
 	}
+	_update_vector(source);
+
+	arch_irq_restore(flags);
 }
 
 void irq_enable(uint32_t source)
@@ -226,3 +418,97 @@ void irq_disable(uint32_t source)
 #error Unknown IRQ controller!
 #endif
 }
+
+bool irq_is_in_handler(void)
+{
+	return depth != 0;
+}
+
+#ifdef CONFIG_IRQ_PROFILE
+
+void irq_profile_reset(void)
+{
+	uint32_t flags = arch_irq_save();
+	memset(profiles, 0, sizeof(profiles));
+	arch_irq_restore(flags);
+}
+
+bool irq_profile_get(uint32_t source, struct _irq_profile* profile)
+{
+	uint32_t flags;
+
+	if (source >= ID_PERIPH_COUNT)
+		return false;
+
+	flags = arch_irq_save();
+	*profile = profiles[source];
+	arch_irq_restore(flags);
+
+	return profile->count != 0;
+}
+
+void irq_profile_set_latency_probe(uint32_t source,
+		irq_latency_probe_t probe, void* user_arg)
+{
+	uint32_t flags;
+
+	if (source >= ID_PERIPH_COUNT)
+		return;
+
+	flags = arch_irq_save();
+	latency_probes[source].probe = probe;
+	latency_probes[source].user_arg = user_arg;
+	arch_irq_restore(flags);
+}
+
+static void _profile_print_hist(const char* name, const uint32_t* hist)
+{
+	uint32_t i;
+
+	printf("      %s:", name);
+	for (i = 0; i < IRQ_PROFILE_HIST_BUCKETS; i++)
+		if (hist[i])
+			printf(" <%u:%u", (unsigned)(1u << (i + IRQ_PROFILE_HIST_SHIFT)),
+					(unsigned)hist[i]);
+	printf("\r\n");
+}
+
+void irq_profile_dump(uint32_t budget_us)
+{
+	uint32_t cycles_per_us = pmc_get_processor_clock() / 1000000;
+	uint32_t source, worst;
+	struct _irq_profile p;
+
+	if (cycles_per_us == 0)
+		cycles_per_us = 1;
+
+	printf("IRQ profile (cycles, %u cycles/us, budget %uus)\r\n",
+			(unsigned)cycles_per_us, (unsigned)budget_us);
+	printf(" src    count shared nested depth        dur min/avg/max\r\n");
+	for (source = 0; source < ID_PERIPH_COUNT; source++) {
+		if (!irq_profile_get(source, &p))
+			continue;
+		worst = p.duration_max;
+		if (p.latency_count)
+			worst += p.latency_max;
+		printf("%4u %8u %6u %6u %5u %6u/%6u/%6u%s\r\n",
+			(unsigned)source, (unsigned)p.count,
+			(unsigned)p.shared, (unsigned)p.nested,
+			(unsigned)p.max_depth,
+			(unsigned)p.duration_min,
+			(unsigned)(p.duration_total / p.count),
+			(unsigned)p.duration_max,
+			(budget_us && worst > budget_us * cycles_per_us) ?
+				"  OVER BUDGET" : "");
+		if (p.latency_count) {
+			printf("      lat min/avg/max: %u/%u/%u\r\n",
+				(unsigned)p.latency_min,
+				(unsigned)(p.latency_total / p.latency_count),
+				(unsigned)p.latency_max);
+			_profile_print_hist("lat", p.latency_hist);
+		}
+		_profile_print_hist("dur", p.duration_hist);
+	}
+}
+
+#endif /* CONFIG_IRQ_PROFILE */
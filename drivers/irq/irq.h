@@ -34,6 +34,7 @@
  *         Headers
  *------------------------------------------------------------------------------*/
 
+#include <stdbool.h>
 #include <stdint.h>
 
 typedef void (*irq_handler_t)(uint32_t source, void* user_arg);
@@ -45,6 +46,47 @@ enum _irq_mode {
 	IRQ_MODE_NEGATIVE_EDGE,
 };
 
+#ifdef CONFIG_IRQ_PROFILE
+
+/** Histogram buckets: bucket 0 counts values below 2^IRQ_PROFILE_HIST_SHIFT
+ * cycles, bucket n values in [2^(n-1+SHIFT), 2^(n+SHIFT)), the last bucket
+ * also counts all larger values */
+#define IRQ_PROFILE_HIST_SHIFT 6
+#define IRQ_PROFILE_HIST_BUCKETS 14
+
+/**
+ * \brief Per-source interrupt statistics, all times in CPU cycles.
+ *
+ * Duration covers all handlers chained on the source, including the nested
+ * interrupts taken while they run.  The entry latency, from the source
+ * becoming pending to the dispatcher, is only known for sources with a
+ * latency probe (see irq_profile_set_latency_probe()), the system timer
+ * registers one.
+ */
+struct _irq_profile {
+	uint32_t count;
+	uint32_t shared;        /**< dispatches with several handlers chained */
+	uint32_t nested;        /**< dispatches that preempted another handler */
+	uint32_t max_depth;     /**< deepest nesting level, 1 when never nested */
+	uint32_t latency_count; /**< dispatches with a latency sample */
+	uint32_t latency_min;
+	uint32_t latency_max;
+	uint64_t latency_total;
+	uint32_t duration_min;
+	uint32_t duration_max;
+	uint64_t duration_total;
+	uint32_t latency_hist[IRQ_PROFILE_HIST_BUCKETS];
+	uint32_t duration_hist[IRQ_PROFILE_HIST_BUCKETS];
+};
+
+/**
+ * Latency probe, called on entry of the dispatcher before the handlers.
+ * Returns the CPU cycles elapsed since the source became pending.
+ */
+typedef uint32_t (*irq_latency_probe_t)(uint32_t source, void* user_arg);
+
+#endif /* CONFIG_IRQ_PROFILE */
+
 /*------------------------------------------------------------------------------
  *         Global functions
  *------------------------------------------------------------------------------*/
@@ -83,7 +125,11 @@ extern void irq_configure_priority(uint32_t source, uint8_t priority);
  * \brief Add a handler for a given interrupt source (ID_xxx).
  *
  * If the handler is already configured for the interrupt source, this function
- * does nothing.
+ * only updates its user argument.
+ *
+ * A source with a single handler is dispatched directly from its vector.
+ * Handlers are only chained, and called in turn, when several of them share
+ * the same source.
  *
  * \param source   Interrupt source to configure
  * \param handler  Handler for the interrupt
@@ -116,6 +162,50 @@ extern void irq_enable(uint32_t source);
  */
 extern void irq_disable(uint32_t source);
 
+/**
+ * \brief Tell if the caller runs from an interrupt handler.
+ *
+ * Handlers run with the interrupts enabled (nesting), so this is not the
+ * same as arch_irq_is_masked().
+ */
+extern bool irq_is_in_handler(void);
+
+#ifdef CONFIG_IRQ_PROFILE
+
+/**
+ * \brief Clear the interrupt statistics of all sources.
+ */
+extern void irq_profile_reset(void);
+
+/**
+ * \brief Get a snapshot of the interrupt statistics of a source.
+ *
+ * \param source   Interrupt source (ID_xxx)
+ * \param profile  Filled with the statistics
+ * \return true if the source was dispatched at least once
+ */
+extern bool irq_profile_get(uint32_t source, struct _irq_profile* profile);
+
+/**
+ * \brief Set the entry latency probe of a source.
+ *
+ * \param source    Interrupt source (ID_xxx)
+ * \param probe     Latency probe, NULL to remove it
+ * \param user_arg  User argument for the probe
+ */
+extern void irq_profile_set_latency_probe(uint32_t source,
+		irq_latency_probe_t probe, void* user_arg);
+
+/**
+ * \brief Print the statistics of all dispatched sources on the console.
+ *
+ * \param budget_us  Sources whose worst latency plus duration exceeds this
+ * budget (in microseconds) are flagged, 0 to disable
+ */
+extern void irq_profile_dump(uint32_t budget_us);
+
+#endif /* CONFIG_IRQ_PROFILE */
+
 #ifdef __cplusplus
 }
 #endif
@@ -167,10 +167,16 @@ void l2cc_enable_event_counter(uint8_t event_counter)
 	}
 }
 
+void l2cc_disable_event_counters(void)
+{
+	L2CC->L2CC_ECR = 0;
+}
+
 void l2cc_event_config(uint8_t event_counter, uint8_t source, uint8_t it)
 {
 	assert(event_counter < 2);
-	assert(!l2cache_is_enabled());
+	/* counter sources can only be changed while counting is stopped */
+	assert(!(L2CC->L2CC_ECR & L2CC_ECR_EVCEN));
 
 	switch (event_counter) {
 	case 0:
@@ -389,6 +395,7 @@ void l2cc_configure(const struct _l2cc_config* cfg)
 {
 	assert(!l2cache_is_enabled());
 
+	l2cc_disable_event_counters();
 	l2cc_event_config(0, L2CC_ECFGR0_ESRC_SRC_DRHIT,
 	                  L2CC_ECFGR0_EIGEN_INT_DIS);
 	l2cc_event_config(1, L2CC_ECFGR0_ESRC_SRC_DWHIT,
@@ -123,8 +123,14 @@ extern void l2cc_inst_prefetch_enable(void);
  */
 extern void l2cc_enable_event_counter(uint8_t event_counter);
 
+/**
+ * \brief Stops both event counters so that they can be reconfigured.
+ */
+extern void l2cc_disable_event_counters(void);
+
 /**
  * \brief Configures Event of Level 2 cache.
+ * Event counters must be disabled (see l2cc_disable_event_counters).
  * \param event_counter  Eventcounter 1 or 0
  * \param source  Event Genration source
  * \param it  Event Counter Interrupt Generation condition
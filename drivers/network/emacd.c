@@ -512,4 +512,5 @@ const struct _ethd_op _emac_op = {
 	.poll = (_ethd_poll)ethd_poll,
 	.set_rx_callback = (_ethd_set_rx_callback)emacd_set_rx_callback,
 	.set_tx_wakeup_callback = (_ethd_set_tx_wakeup_callback)ethd_set_tx_wakeup_callback,
+	.set_checksum_offload = NULL, /* no checksum offload on EMAC */
 };
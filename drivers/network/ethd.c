@@ -34,6 +34,7 @@
  *----------------------------------------------------------------------------*/
 
 #include "barriers.h"
+#include "fastmem.h"
 #include "trace.h"
 #include "ring.h"
 
@@ -76,6 +77,7 @@ bool ethd_configure(struct _ethd * ethd, enum _eth_type eth_type, void * addr, u
 {
 	ethd->addr = addr;
 	ethd->op = NULL;
+	ethd->csum_offload = false;
 
 #ifdef CONFIG_HAVE_EMAC
 	if (ETH_TYPE_EMAC == eth_type)
@@ -161,7 +163,7 @@ uint8_t ethd_send_sg(struct _ethd* ethd, uint8_t queue, const struct _eth_sg_lis
 
 		/* Copy data into transmittion buffer */
 		if (sg->buffer && sg->size) {
-			memcpy((void*)desc->addr, sg->buffer, sg->size);
+			fast_memcpy((void*)desc->addr, sg->buffer, sg->size);
 			cache_clean_region((void*)desc->addr, sg->size);
 		}
 
@@ -232,6 +234,7 @@ uint8_t ethd_poll(struct _ethd* ethd, uint8_t queue, uint8_t* buffer, uint32_t b
 
 	/* Set the default return value */
 	*recv_size = 0;
+	q->rx_csum = ETH_RX_STATUS_CSUM_NONE;
 
 	/* Process RX descriptors */
 	idx = q->rx_head;
@@ -273,7 +276,7 @@ uint8_t ethd_poll(struct _ethd* ethd, uint8_t queue, uint8_t* buffer, uint32_t b
 
 			void* addr = (void*)(desc->addr & ETH_RX_ADDR_MASK);
 			cache_invalidate_region(addr, length);
-			memcpy(cur_frame, addr, length);
+			fast_memcpy(cur_frame, addr, length);
 			cur_frame += length;
 			cur_frame_size += length;
 
@@ -282,6 +285,11 @@ uint8_t ethd_poll(struct _ethd* ethd, uint8_t queue, uint8_t* buffer, uint32_t b
 				/* Frame size from the ETH */
 				*recv_size = desc->status & ETH_RX_STATUS_LENGTH_MASK;
 
+				/* Checksum status, only meaningful when the
+				 * offload is enabled */
+				if (ethd->csum_offload)
+					q->rx_csum = desc->status & ETH_RX_STATUS_CSUM_MASK;
+
 				/* Application frame buffer is too small all
 				 * data have not been copied */
 				if (cur_frame_size < *recv_size) {
@@ -312,6 +320,28 @@ uint8_t ethd_poll(struct _ethd* ethd, uint8_t queue, uint8_t* buffer, uint32_t b
 	return ETH_RX_NULL;
 }
 
+uint32_t ethd_get_rx_checksum(struct _ethd* ethd, uint8_t queue)
+{
+	return ethd->queues[queue].rx_csum;
+}
+
+bool ethd_set_checksum_offload(struct _ethd* ethd, bool enable)
+{
+	if (!ethd->op->set_checksum_offload) {
+		ethd->csum_offload = false;
+		return !enable;
+	}
+
+	ethd->op->set_checksum_offload(ethd, enable);
+	ethd->csum_offload = enable;
+	return true;
+}
+
+bool ethd_get_checksum_offload(struct _ethd* ethd)
+{
+	return ethd->csum_offload;
+}
+
 void ethd_set_rx_callback(struct _ethd *ethd, uint8_t queue, ethd_callback_t callback)
 {
 	ethd->op->set_rx_callback(ethd, queue, callback);
@@ -89,6 +89,15 @@ enum _eth_speed {
 #define ETH_RX_STATUS_SOF         (1u << 14)
 #define ETH_RX_STATUS_EOF         (1u << 15)
 
+/* Checksum offload status in struct _eth_desc status (GMAC only, valid when
+ * RX checksum offload is enabled; frames with a bad checksum are dropped by
+ * the MAC) */
+#define ETH_RX_STATUS_CSUM_MASK   (3u << 22)
+#define ETH_RX_STATUS_CSUM_NONE   (0u << 22) /**< not checked by hardware */
+#define ETH_RX_STATUS_CSUM_IP     (1u << 22) /**< IP header checked */
+#define ETH_RX_STATUS_CSUM_TCP    (2u << 22) /**< IP header and TCP checked */
+#define ETH_RX_STATUS_CSUM_UDP    (3u << 22) /**< IP header and UDP checked */
+
 /* Bits contained in struct _eth_desc status when used for TX */
 #define ETH_TX_STATUS_LASTBUF (1u << 15)
 #define ETH_TX_STATUS_WRAP    (1u << 30)
@@ -188,6 +197,8 @@ typedef void (*_ethd_set_rx_callback)(void *ethd, uint8_t queue, ethd_callback_t
 
 typedef uint8_t (*_ethd_set_tx_wakeup_callback)(void *ethd, uint8_t queue, ethd_wakeup_cb_t wakeup_callback, uint16_t threshold);
 
+typedef void (*_ethd_set_checksum_offload)(void *ethd, bool enable);
+
 /** @}*/
 
 /** \addtogroup ethd_structs
@@ -206,6 +217,7 @@ struct _ethd_op {
 	_ethd_poll poll;
 	_ethd_set_rx_callback set_rx_callback;
 	_ethd_set_tx_wakeup_callback set_tx_wakeup_callback;
+	_ethd_set_checksum_offload set_checksum_offload; /**< NULL if not supported */
 };
 
 struct _ethd_queue {
@@ -214,6 +226,7 @@ struct _ethd_queue {
 	uint16_t          rx_size;
 	uint16_t          rx_head;
 	ethd_callback_t   rx_callback;
+	uint32_t          rx_csum;  /**< checksum status of the last polled frame */
 
 	uint8_t          *tx_buffer;
 	struct _eth_desc *tx_desc;
@@ -241,6 +254,7 @@ struct _ethd {
 	};
 	struct _ethd_queue queues[ETH_QUEUE_COUNT];
 	const struct _ethd_op *op;
+	bool csum_offload;        /**< IP/TCP/UDP checksum offload enabled */
 };
 
 /** @}*/
@@ -303,6 +317,36 @@ extern uint32_t ethd_get_tx_load(struct _ethd* ethd, uint8_t queue);
  */
 extern uint8_t ethd_poll(struct _ethd* ethd, uint8_t queue, uint8_t* buffer, uint32_t buffer_size, uint32_t* recv_size);
 
+/**
+ * \brief Get the hardware checksum status of the last frame returned by
+ * ethd_poll() on a queue.
+ *  \param ethd Pointer to ETH Driver instance.
+ *  \param queue Queue index.
+ *  \return One of ETH_RX_STATUS_CSUM_xxx. ETH_RX_STATUS_CSUM_NONE when the
+ *  checksum offload is disabled or when the frame has not been checked by the
+ *  hardware (IP fragments, options, non IP protocols...), the checksums must
+ *  then be verified by software.
+ */
+extern uint32_t ethd_get_rx_checksum(struct _ethd* ethd, uint8_t queue);
+
+/**
+ * \brief Enable or disable the IP/TCP/UDP checksum offload. When enabled, the
+ * MAC verifies the checksums of received frames, and drops the ones with a bad
+ * checksum, and fills in the checksums of transmitted frames.
+ * Must be called after ethd_configure().
+ *  \param ethd Pointer to ETH Driver instance.
+ *  \param enable true to enable the offload, false to disable it.
+ *  \return true on success, false if the offload is requested on a MAC
+ *  without checksum engines (EMAC), software checksums must then be used.
+ */
+extern bool ethd_set_checksum_offload(struct _ethd* ethd, bool enable);
+
+/**
+ * \brief Check if the IP/TCP/UDP checksum offload is enabled.
+ *  \param ethd Pointer to ETH Driver instance.
+ */
+extern bool ethd_get_checksum_offload(struct _ethd* ethd);
+
 extern void ethd_set_rx_callback(struct _ethd *ethd, uint8_t queue, ethd_callback_t callback);
 
 /**
@@ -202,6 +202,16 @@ uint32_t gmac_get_network_config_register(Gmac* gmac)
 	return gmac->GMAC_NCFGR;
 }
 
+void gmac_set_dma_config_register(Gmac* gmac, uint32_t dcfgr)
+{
+	gmac->GMAC_DCFGR = dcfgr;
+}
+
+uint32_t gmac_get_dma_config_register(Gmac* gmac)
+{
+	return gmac->GMAC_DCFGR;
+}
+
 void gmac_enable_mdio(Gmac* gmac)
 {
 	/* Disable RX/TX */
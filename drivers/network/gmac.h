@@ -136,6 +136,16 @@ extern void gmac_set_network_config_register(Gmac* gmac, uint32_t ncfgr);
 
 extern uint32_t gmac_get_network_config_register(Gmac* gmac);
 
+/**
+ *  \brief Set DMA configuration register
+ */
+extern void gmac_set_dma_config_register(Gmac* gmac, uint32_t dcfgr);
+
+/**
+ *  \brief Get DMA configuration register
+ */
+extern uint32_t gmac_get_dma_config_register(Gmac* gmac);
+
 /**
  *  \brief Enable MDI with PHY
  *  \param gmac Pointer to an Gmac instance.
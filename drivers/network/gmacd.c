@@ -53,6 +53,11 @@
 #define GMAC_NCFGR_DBW_DBW64 0
 #endif
 
+/* Not described in all chip headers but present on all GMAC revisions */
+#ifndef GMAC_DCFGR_TXCOEN
+#define GMAC_DCFGR_TXCOEN (0x1u << 11)
+#endif
+
 // Interrupt bits
 #define GMAC_INT_RX_BITS     (GMAC_IER_RCOMP | GMAC_IER_RXUBR | GMAC_IER_ROVR)
 #define GMAC_INT_TX_ERR_BITS (GMAC_IER_TUR | GMAC_IER_RLEX | GMAC_IER_TFC)
@@ -519,6 +524,31 @@ void gmacd_reset(struct _ethd* gmacd)
 			GMAC_NCR_WESTAT | GMAC_NCR_CLRSTAT);
 }
 
+/**
+ * \brief Enable or disable the IP/TCP/UDP checksum engines: verification of
+ * received frames (frames with a bad checksum are discarded and the status is
+ * reported in the RX descriptors) and generation of the checksums of
+ * transmitted frames.
+ *  \param gmacd Pointer to GMAC Driver instance.
+ *  \param enable true to enable the checksum offload.
+ */
+void gmacd_set_checksum_offload(struct _ethd* gmacd, bool enable)
+{
+	Gmac* gmac = gmacd->gmac;
+	uint32_t ncfgr = gmac_get_network_config_register(gmac);
+	uint32_t dcfgr = gmac_get_dma_config_register(gmac);
+
+	if (enable) {
+		ncfgr |= GMAC_NCFGR_RXCOEN;
+		dcfgr |= GMAC_DCFGR_TXCOEN;
+	} else {
+		ncfgr &= ~GMAC_NCFGR_RXCOEN;
+		dcfgr &= ~GMAC_DCFGR_TXCOEN;
+	}
+	gmac_set_network_config_register(gmac, ncfgr);
+	gmac_set_dma_config_register(gmac, dcfgr);
+}
+
 /**
  * \brief Registers pRxCb callback. Callback will be invoked after the next received
  * frame. When ethd_poll() returns GMAC_RX_NO_DATA the application task call
@@ -554,4 +584,5 @@ const struct _ethd_op _gmac_op = {
 	.poll = (_ethd_poll)ethd_poll,
 	.set_rx_callback = (_ethd_set_rx_callback)gmacd_set_rx_callback,
 	.set_tx_wakeup_callback = (_ethd_set_tx_wakeup_callback)ethd_set_tx_wakeup_callback,
+	.set_checksum_offload = (_ethd_set_checksum_offload)gmacd_set_checksum_offload,
 };
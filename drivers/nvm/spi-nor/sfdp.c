@@ -34,6 +34,7 @@
 #include "nvm/spi-nor/sfdp.h"
 #include "nvm/spi-nor/spi-nor.h"
 #include "string.h"
+#include "trace.h"
 
 /*----------------------------------------------------------------------------
  *        Local Functions
@@ -69,6 +70,7 @@ struct sfdp_parameter_header {
 
 
 #define SFDP_BFPT_ID		0xff00u	/* Basic Flash Parameter Table */
+#define SFDP_SECTOR_MAP_ID	0xff81u	/* Sector Map Parameter Table */
 #define SFDP_4BAIT_ID		0xff84u	/* 4-byte Address Instruction Table */
 
 #define SFDP_SIGNATURE		0x50444653u
@@ -133,9 +135,37 @@ enum sfdp_bfpt_dword {
 #define BFPT_DWORD5_FAST_READ_2_2_2      (0x1UL << 0)
 #define BFPT_DWORD5_FAST_READ_4_4_4      (0x1UL << 4)
 
+/*
+ * 10th DWORD: the typical erase time of the Erase Type i + 1 is
+ * (count + 1) * unit, with count in the 5 bits at 4 + 7 * i and unit in the
+ * next two bits: 1ms, 16ms, 128ms or 1s.
+ */
+#define BFPT_DWORD10_ERASE_TIME_SHIFT(n) (4 + 7 * (n))
+#define BFPT_DWORD10_ERASE_COUNT(dw, n)  (((dw) >> BFPT_DWORD10_ERASE_TIME_SHIFT(n)) & 0x1Fu)
+#define BFPT_DWORD10_ERASE_UNIT(dw, n)   (((dw) >> (BFPT_DWORD10_ERASE_TIME_SHIFT(n) + 5)) & 0x3u)
+
 /* 11th DWORD. */
 #define BFPT_DWORD11_PAGE_SIZE_SHIFT     4
 #define BFPT_DWORD11_PAGE_SIZE_MASK      (0xFUL << 4)
+/* Typical chip erase time: (count + 1) * unit, unit is 16ms, 256ms, 4s or 64s */
+#define BFPT_DWORD11_CHIP_ERASE_COUNT(dw) (((dw) >> 24) & 0x1Fu)
+#define BFPT_DWORD11_CHIP_ERASE_UNIT(dw)  (((dw) >> 29) & 0x3u)
+
+/* 12th DWORD: Suspend and Resume, the units of the latencies are 128ns, 1us,
+ * 8us or 64us, the intervals are counted in 64us. */
+#define BFPT_DWORD12_NO_SUSPEND           (0x1UL << 31)
+#define BFPT_DWORD12_PRG_INTERVAL(dw)     (((((dw) >> 9) & 0xFu) + 1) * 64)
+#define BFPT_DWORD12_PRG_LATENCY_COUNT(dw) (((dw) >> 13) & 0x1Fu)
+#define BFPT_DWORD12_PRG_LATENCY_UNIT(dw) (((dw) >> 18) & 0x3u)
+#define BFPT_DWORD12_ERS_INTERVAL(dw)     (((((dw) >> 20) & 0xFu) + 1) * 64)
+#define BFPT_DWORD12_ERS_LATENCY_COUNT(dw) (((dw) >> 24) & 0x1Fu)
+#define BFPT_DWORD12_ERS_LATENCY_UNIT(dw) (((dw) >> 29) & 0x3u)
+
+/* 13th DWORD: Suspend and Resume instructions. */
+#define BFPT_DWORD13_PRG_RESUME(dw)       (((dw) >> 0) & 0xFFu)
+#define BFPT_DWORD13_PRG_SUSPEND(dw)      (((dw) >> 8) & 0xFFu)
+#define BFPT_DWORD13_RESUME(dw)           (((dw) >> 16) & 0xFFu)
+#define BFPT_DWORD13_SUSPEND(dw)          (((dw) >> 24) & 0xFFu)
 
 /* 15th DWORD. */
 
@@ -383,6 +413,42 @@ static int spi_flash_parse_bfpt(struct spi_flash *flash,
 	if (bfpt_header->length < BFPT_DWORD_MAX)
 		return 0;
 
+	/* Typical erase times, used to plan erase operations. */
+	for (i = 0; i < SFLASH_CMD_ERASE_MAX; i++) {
+		static const uint16_t units[] = { 1, 16, 128, 1000 };
+		uint32_t dw = bfpt.dwords[BFPT_DWORD10];
+
+		if (map->commands[i].size)
+			map->commands[i].typ_time = (BFPT_DWORD10_ERASE_COUNT(dw, i) + 1) *
+				units[BFPT_DWORD10_ERASE_UNIT(dw, i)];
+	}
+	{
+		static const uint32_t units[] = { 16, 256, 4000, 64000 };
+		uint32_t dw = bfpt.dwords[BFPT_DWORD11];
+
+		map->chip_erase_time = (BFPT_DWORD11_CHIP_ERASE_COUNT(dw) + 1) *
+			units[BFPT_DWORD11_CHIP_ERASE_UNIT(dw)];
+	}
+
+	/* Program and erase suspend: DWORD12 bit 31 is cleared if supported. */
+	if (!(bfpt.dwords[BFPT_DWORD12] & BFPT_DWORD12_NO_SUSPEND)) {
+		static const uint16_t units[] = { 1, 1, 8, 64 }; /* 128ns rounded */
+		uint32_t dw12 = bfpt.dwords[BFPT_DWORD12];
+		uint32_t dw13 = bfpt.dwords[BFPT_DWORD13];
+
+		flash->program_suspend.suspend_inst = BFPT_DWORD13_PRG_SUSPEND(dw13);
+		flash->program_suspend.resume_inst = BFPT_DWORD13_PRG_RESUME(dw13);
+		flash->program_suspend.latency = (BFPT_DWORD12_PRG_LATENCY_COUNT(dw12) + 1) *
+			units[BFPT_DWORD12_PRG_LATENCY_UNIT(dw12)];
+		flash->program_suspend.interval = BFPT_DWORD12_PRG_INTERVAL(dw12);
+
+		flash->erase_suspend.suspend_inst = BFPT_DWORD13_SUSPEND(dw13);
+		flash->erase_suspend.resume_inst = BFPT_DWORD13_RESUME(dw13);
+		flash->erase_suspend.latency = (BFPT_DWORD12_ERS_LATENCY_COUNT(dw12) + 1) *
+			units[BFPT_DWORD12_ERS_LATENCY_UNIT(dw12)];
+		flash->erase_suspend.interval = BFPT_DWORD12_ERS_INTERVAL(dw12);
+	}
+
 	/* Page size: this field specifies 'N' so the page size = 2^N bytes. */
 	params->page_size = bfpt.dwords[BFPT_DWORD11];
 	params->page_size &= BFPT_DWORD11_PAGE_SIZE_MASK;
@@ -428,6 +494,160 @@ static int spi_flash_parse_bfpt(struct spi_flash *flash,
 	return 0;
 }
 
+/* Sector Map Parameter Table */
+
+/*
+ * (from JESD216B)
+ * The table is a list of descriptors: first the Configuration Detection
+ * Commands, of two DWORDs each, then the Sector Map descriptors, of one
+ * header DWORD followed by one DWORD per region. Bit 0 of the first DWORD of
+ * a descriptor marks the last one, bit 1 gives its type.
+ * The bits read by the detection commands, the first one as MSB, make the
+ * ID of the configuration in use, i.e. of the map to use.
+ */
+#define SMPT_DESC_END                (0x1UL << 0)
+#define SMPT_DESC_TYPE_MAP           (0x1UL << 1)
+
+#define SMPT_CMD_INST(dw)            (((dw) >> 8) & 0xFFu)
+#define SMPT_CMD_READ_DUMMY(dw)      (((dw) >> 16) & 0xFu)
+#define SMPT_CMD_READ_DUMMY_VARIABLE 0xFu
+#define SMPT_CMD_ADDR_LEN(dw)        (((dw) >> 22) & 0x3u)
+#define SMPT_CMD_ADDR_LEN_0          0x0u
+#define SMPT_CMD_ADDR_LEN_3          0x1u
+#define SMPT_CMD_ADDR_LEN_4          0x2u
+#define SMPT_CMD_READ_DATA_MASK(dw)  (((dw) >> 24) & 0xFFu)
+
+#define SMPT_MAP_ID(dw)              (((dw) >> 8) & 0xFFu)
+#define SMPT_MAP_REGION_COUNT(dw)    ((((dw) >> 16) & 0xFFu) + 1)
+
+#define SMPT_REGION_ERASE_TYPES(dw)  ((dw) & 0xFu)
+#define SMPT_REGION_SIZE(dw)         (((((dw) >> 8) & 0xFFFFFFu) + 1) * 256)
+
+#define SMPT_MAX_DWORDS              64
+
+static uint32_t smpt[SMPT_MAX_DWORDS];
+
+static int spi_flash_smpt_detect(struct spi_flash *flash, const uint32_t *desc, uint8_t *value)
+{
+	struct spi_flash_command cmd;
+	uint8_t addr_len, dummy;
+
+	switch (SMPT_CMD_ADDR_LEN(desc[0])) {
+	case SMPT_CMD_ADDR_LEN_0:
+		addr_len = 0;
+		break;
+	case SMPT_CMD_ADDR_LEN_4:
+		addr_len = 4;
+		break;
+	default:
+		/* 3-byte or current address mode, still 3 while probing */
+		addr_len = 3;
+		break;
+	}
+
+	dummy = SMPT_CMD_READ_DUMMY(desc[0]);
+	if (dummy == SMPT_CMD_READ_DUMMY_VARIABLE)
+		dummy = 8;
+
+	spi_flash_command_init(&cmd, SMPT_CMD_INST(desc[0]), addr_len, SFLASH_TYPE_READ_REG);
+	cmd.proto = flash->reg_proto;
+	cmd.addr = desc[1];
+	cmd.num_wait_states = dummy;
+	cmd.data_len = 1;
+	cmd.rx_data = value;
+	return spi_flash_exec(flash, &cmd);
+}
+
+static int spi_flash_parse_smpt(struct spi_flash *flash,
+				const struct sfdp_parameter_header *smpt_header,
+				struct spi_flash_parameters *params)
+{
+	struct spi_flash_erase_map *map = &flash->erase_map;
+	uint32_t len, i, j, count, erase_mask, common_mask, last_mask;
+	uint32_t offset, size;
+	uint8_t map_id, value;
+	bool overflow;
+	int rc;
+
+	len = min_u32(SMPT_MAX_DWORDS, smpt_header->length);
+	memset(smpt, 0, sizeof(smpt));
+	rc = spi_flash_read_sfdp(flash, SFDP_PARAM_HEADER_PTP(smpt_header),
+				 len * sizeof(uint32_t), smpt);
+	if (rc < 0)
+		return rc;
+
+	/* Run the detection commands to get the ID of the map in use. */
+	map_id = 0;
+	for (i = 0; i + 1 < len && !(smpt[i] & SMPT_DESC_TYPE_MAP); i += 2) {
+		rc = spi_flash_smpt_detect(flash, &smpt[i], &value);
+		if (rc < 0)
+			return rc;
+		map_id = (map_id << 1) | ((value & SMPT_CMD_READ_DATA_MASK(smpt[i])) != 0);
+	}
+
+	/* Find the matching map descriptor. */
+	while (i < len && SMPT_MAP_ID(smpt[i]) != map_id) {
+		if (smpt[i] & SMPT_DESC_END)
+			return -EINVAL;
+		i += SMPT_MAP_REGION_COUNT(smpt[i]) + 1;
+	}
+	if (i >= len || !(smpt[i] & SMPT_DESC_TYPE_MAP))
+		return -EINVAL;
+
+	count = SMPT_MAP_REGION_COUNT(smpt[i]);
+	if (i + count >= len)
+		return -EINVAL;
+
+	/* Build the regions, merging the neighbours with the same erase types. */
+	erase_mask = map->uniform_region.cmd_mask;
+	common_mask = erase_mask;
+	last_mask = 0;
+	offset = 0;
+	overflow = false;
+	j = 0;
+	for (i = i + 1; count > 0; i++, count--) {
+		uint32_t mask = SMPT_REGION_ERASE_TYPES(smpt[i]) & erase_mask;
+
+		size = SMPT_REGION_SIZE(smpt[i]);
+		common_mask &= mask;
+		if (j > 0 && last_mask == mask) {
+			if (!overflow)
+				map->sector_map[j - 1].size += size;
+		} else if (j < SFLASH_MAX_ERASE_REGIONS) {
+			map->sector_map[j].cmd_mask = mask;
+			map->sector_map[j].offset = offset;
+			map->sector_map[j].size = size;
+			j++;
+		} else {
+			/* j stays at the limit, only the common mask is kept. */
+			overflow = true;
+		}
+		last_mask = mask;
+		offset += size;
+	}
+
+	if (offset != params->size)
+		return -EINVAL;
+
+	if (overflow) {
+		/* Too many regions: keep the erase types usable everywhere. */
+		if (!common_mask)
+			return -EINVAL;
+		trace_warning("SF: erase map too large, using common erase sizes\r\n");
+		map->uniform_region.cmd_mask = common_mask;
+		return 0;
+	}
+
+	if (j > 1) {
+		map->regions = map->sector_map;
+		map->num_regions = j;
+	} else {
+		map->uniform_region.cmd_mask = map->sector_map[0].cmd_mask;
+	}
+
+	return 0;
+}
+
 static struct sfdp_header header;
 static struct sfdp_parameter_header param_header;
 
@@ -494,6 +714,11 @@ int spi_flash_parse_sfdp(struct spi_flash *flash, struct spi_flash_parameters *p
 			goto exit;
 
 		switch (SFDP_PARAM_HEADER_ID(&param_header)) {
+		case SFDP_SECTOR_MAP_ID:
+			/* Not fatal: the uniform erase map is kept on error. */
+			if (spi_flash_parse_smpt(flash, &param_header, params) < 0)
+				trace_warning("SF: invalid sector map, using uniform erase\r\n");
+			break;
 		default:
 			break;
 		}
@@ -73,7 +73,7 @@ int spi_flash_write_reg(struct spi_flash *flash, uint8_t inst, const uint8_t *bu
 	return spi_flash_exec(flash, &cmd);
 }
 
-static int spi_flash_is_ready(struct spi_flash *flash)
+int spi_flash_is_ready(struct spi_flash *flash)
 {
 	uint8_t sr, fsr;
 	int rc;
@@ -260,6 +260,7 @@ void spi_flash_set_erase_command(struct spi_flash_erase_command *cmd, size_t siz
 {
 	cmd->size = size;
 	cmd->inst = inst;
+	cmd->typ_time = 0;
 
 	if (IS_POWER_OF_TWO(cmd->size))
 		cmd->size_shift = fls(cmd->size) - 1;
@@ -290,6 +291,7 @@ void spi_flash_init_uniform_erase_map(struct spi_flash_erase_map *map, uint32_t
 	map->uniform_region.cmd_mask = cmd_mask;
 	map->uniform_region.offset = 0;
 	map->uniform_region.size = flash_size;
+	map->chip_erase_time = 0;
 }
 
 int spi_flash_exec(struct spi_flash *flash, const struct spi_flash_command *cmd)
@@ -363,19 +365,36 @@ bool spi_flash_has_uniform_erase(const struct spi_flash *flash)
 uint32_t spi_flash_get_uniform_erase_map(const struct spi_flash *flash)
 {
 	uint32_t erase_map = 0;
+	uint32_t cmd_mask = SFLASH_CMD_ERASE_MASK;
+	int i;
 
-	if (spi_flash_has_uniform_erase(flash)) {
-		int i;
-		for (i = 0; i < SFLASH_CMD_ERASE_MAX; i++) {
-			if (flash->erase_map.uniform_region.cmd_mask & (1u << i)) {
-				erase_map |= flash->erase_map.commands[i].size / flash->page_size;
-			}
+	/* with a non-uniform map, only the erase sizes usable everywhere */
+	for (i = 0; i < flash->erase_map.num_regions; i++)
+		cmd_mask &= flash->erase_map.regions[i].cmd_mask;
+
+	for (i = 0; i < SFLASH_CMD_ERASE_MAX; i++) {
+		if (cmd_mask & (1u << i)) {
+			erase_map |= flash->erase_map.commands[i].size / flash->page_size;
 		}
 	}
 
 	return erase_map;
 }
 
+const struct spi_flash_erase_region *spi_flash_get_erase_region(const struct spi_flash *flash, size_t offset)
+{
+	const struct spi_flash_erase_map *map = &flash->erase_map;
+	int i;
+
+	for (i = 0; i < map->num_regions; i++) {
+		if (offset >= map->regions[i].offset &&
+		    offset - map->regions[i].offset < map->regions[i].size)
+			return &map->regions[i];
+	}
+
+	return NULL;
+}
+
 void spi_flash_command_init(struct spi_flash_command *cmd, uint8_t inst, uint8_t addr_len, uint8_t flags)
 {
 	memset(cmd, 0, sizeof(*cmd));
@@ -38,6 +38,7 @@
 
 #include "compiler.h"
 #include "intmath.h"
+#include "timer.h"
 #include "peripherals/bus.h"
 #ifdef CONFIG_HAVE_QSPI
 #include "spi/qspi.h"
@@ -92,6 +93,10 @@
 #define SFLASH_INST_ULBPR              0x98
 #define SFLASH_INST_RESET_ENABLE       0x66
 #define SFLASH_INST_RESET              0x99
+#define SFLASH_INST_SUSPEND            0x75
+#define SFLASH_INST_RESUME             0x7A
+#define SFLASH_INST_SUSPEND_MX         0xB0
+#define SFLASH_INST_RESUME_MX          0x30
 
 /**
  * Erase instructions.
@@ -99,6 +104,7 @@
 #define SFLASH_INST_ERASE_4K  0x20
 #define SFLASH_INST_ERASE_32K 0x52
 #define SFLASH_INST_ERASE_64K 0xD8
+#define SFLASH_INST_CHIP_ERASE 0xC7
 
 /**
  * 4-byte address instruction set.
@@ -176,6 +182,7 @@
 	 SFLASH_PROTO_DATA(data_nbits))
 
 #define SFLASH_CMD_ERASE_MAX	4
+#define SFLASH_MAX_ERASE_REGIONS 8
 #define SFLASH_CMD_ERASE_MASK	0xFULL
 #define SFLASH_CMD_ERASE_OFFSET(_cmd_mask, _offset)		\
 	((((uint64_t)(_offset)) & ~SFLASH_CMD_ERASE_MASK) |	\
@@ -236,7 +243,11 @@ enum spi_flash_protocol {
 #define SFLASH_TYPE_READ_REG	(0x3UL << 0)
 #define SFLASH_TYPE_WRITE_REG	(0x4UL << 0)
 
+/* The command is issued from interrupt context: do not wait for DMA. */
+#define SFLASH_OPT_POLLING	(0x1UL << 4)
+
 #define SFLASH_FLG_HAS_FSR (0x1UL << 0)
+#define SFLASH_FLG_4BAIS   (0x1UL << 1)
 
 /*----------------------------------------------------------------------------
  *        Exported Typedefs
@@ -257,6 +268,9 @@ enum spi_flash_protocol {
  * @data_len:		Number of bytes to be sent during data clock cycles.
  * @tx_data:		Data sent to the SPI slave during data clock cycles.
  * @rx_data:		Data read from the SPI slave during data clock cycles.
+ * @callback:		If not NULL, a controller that can complete the read in
+ *			the background returns -EINPROGRESS and calls it, with
+ *			the status as second argument, at the end.
  */
 struct spi_flash_command {
 	enum spi_flash_protocol proto;
@@ -271,6 +285,7 @@ struct spi_flash_command {
 	const void *tx_data;
 	void *rx_data;
 	uint32_t timeout;
+	struct _callback *callback;
 #ifdef CONFIG_HAVE_AESB
 	bool use_aesb;
 #endif
@@ -282,12 +297,14 @@ struct spi_flash_command {
  * @size_shift:		the size shift: if @size is a power of 2 then the shift
  *			is stored in @size_shift, otherwise @size_shift is zero.
  * @size_mask:		the size mask based on @size_shift.
+ * @typ_time:		the typical erase time in ms (from SFDP), 0 if unknown.
  * @inst:		the SPI command op code to erase the sector/block.
  */
 struct spi_flash_erase_command {
 	uint32_t size;
 	uint32_t size_shift;
 	uint32_t size_mask;
+	uint32_t typ_time;
 	uint8_t	inst;
 };
 
@@ -310,15 +327,94 @@ struct spi_flash_erase_region {
  * @commands:		an array of erase commands shared by all the regions.
  * @uniform_region:	a pre-allocated erase region for SPI FLASH with a uniform
  *			sector size (legacy implementation).
+ * @sector_map:		the erase regions of SPI FLASH with a non-uniform sector
+ *			size (SFDP Sector Map Parameter Table).
  * @regions:		point to an array describing the boundaries of the erase
- *			regions.
+ *			regions, ordered by offset.
  * @num_regions:	the number of elements in the @regions array.
+ * @chip_erase_time:	the typical chip erase time in ms (from SFDP), 0 if
+ *			unknown.
  */
 struct spi_flash_erase_map {
 	struct spi_flash_erase_command commands[SFLASH_CMD_ERASE_MAX];
 	struct spi_flash_erase_region uniform_region;
+	struct spi_flash_erase_region sector_map[SFLASH_MAX_ERASE_REGIONS];
 	struct spi_flash_erase_region *regions;
 	uint32_t num_regions;
+	uint32_t chip_erase_time;
+};
+
+/**
+ * struct spi_flash_suspend - Structure to describe program or erase suspend
+ * @suspend_inst:	the op code to suspend the operation, 0 if not supported.
+ * @resume_inst:	the op code to resume the operation.
+ * @latency:		the maximum time to suspend, in us.
+ * @interval:		the minimum time from resume to the next suspend, in us.
+ */
+struct spi_flash_suspend {
+	uint8_t suspend_inst;
+	uint8_t resume_inst;
+	uint32_t latency;
+	uint32_t interval;
+};
+
+#define SFLASH_READ_LATENCY_BUCKETS 12
+
+/**
+ * struct spi_flash_read_stats - Latency of the reads done during a background
+ * program or erase.
+ * @count:		the number of reads.
+ * @suspends:		the number of suspended operations.
+ * @max:		the maximum latency, in us.
+ * @histogram:		the number of reads by latency: bucket 0 is below 16us,
+ *			bucket i below 2^(i + 4) us, the last one is above.
+ */
+struct spi_flash_read_stats {
+	uint32_t count;
+	uint32_t suspends;
+	uint32_t max;
+	uint32_t histogram[SFLASH_READ_LATENCY_BUCKETS];
+};
+
+enum spi_flash_bg_op {
+	SFLASH_BG_IDLE = 0,
+	SFLASH_BG_PROGRAM,
+	SFLASH_BG_ERASE,
+};
+
+/**
+ * struct spi_flash_bg - State of a background program or erase
+ * @op:			the operation in progress.
+ * @hold:		the number of foreground accesses in progress, the
+ *			operation is not advanced while not zero.
+ * @suspended:		the operation in progress is suspended.
+ * @offset:		the address of the current step.
+ * @len:		the remaining length, current step included.
+ * @buf:		the data of the current step (program).
+ * @step:		the size of the current step.
+ * @deadline:		the time limit of the current step (timer_get_us()).
+ * @resume_time:	the time of the last resume.
+ * @hold_time:		the time of the first hold.
+ * @callback:		called, from interrupt context, with the status.
+ * @event:		the timer event polling the status register.
+ * @stats:		the latency of the reads held by the operation.
+ */
+struct spi_flash_bg {
+	volatile enum spi_flash_bg_op op;
+	volatile uint8_t hold;
+	bool suspended;
+	size_t offset;
+	size_t len;
+	const uint8_t *buf;
+	size_t step;
+	uint64_t deadline;
+	uint64_t resume_time;
+	uint64_t hold_time;
+	struct _callback callback;
+#ifndef CONFIG_TIMER_POLLING
+	struct _timer_event event;
+#endif
+	struct spi_flash_read_stats stats;
 };
 
 struct spi_flash;
@@ -373,6 +469,9 @@ struct spi_flash_hwcaps {
  * @size:		The total SPI flash size (in bytes).
  * @page_size:		The page size (in bytes).
  * @erase_map:		The erase map of the SPI flash.
+ * @erase_suspend:	The erase suspend/resume commands.
+ * @program_suspend:	The program suspend/resume commands.
+ * @bg:			The background program/erase in progress.
  * @ops:		[DRIVER-SPECIFIC] The SPI controller interface.
  * @read:		[FLASH-SPECIFIC] Read data from the SPI flash.
  * @write:		[FLASH-SPECIFIC] Write data into the SPI flash.
@@ -401,6 +500,9 @@ struct spi_flash {
 	size_t size;
 	size_t page_size;
 	struct spi_flash_erase_map erase_map;
+	struct spi_flash_suspend erase_suspend;
+	struct spi_flash_suspend program_suspend;
+	struct spi_flash_bg bg;
 
 	const struct spi_ops *ops;
 
@@ -453,6 +555,8 @@ extern bool spi_flash_has_uniform_erase(const struct spi_flash *flash);
 
 extern uint32_t spi_flash_get_uniform_erase_map(const struct spi_flash *flash);
 
+extern const struct spi_flash_erase_region *spi_flash_get_erase_region(const struct spi_flash *flash, size_t offset);
+
 extern uint8_t spi_flash_protocol_get_inst_nbits(enum spi_flash_protocol proto);
 
 extern uint8_t spi_flash_protocol_get_addr_nbits(enum spi_flash_protocol proto);
@@ -476,6 +580,14 @@ extern int spi_flash_reset(struct spi_flash *flash);
 
 extern int spi_flash_wait_till_ready(struct spi_flash *flash);
 
+/**
+ * Check once if the SPI flash is ready, i.e. no program or erase in progress.
+ *
+ * @flash:		Pointer to the SPI flash.
+ * Return: 1 if ready, 0 if busy, < 0 on error.
+ */
+extern int spi_flash_is_ready(struct spi_flash *flash);
+
 #ifdef CONFIG_HAVE_AESB
 extern void spi_flash_use_aesb(struct spi_flash* flash, bool enable);
 #endif
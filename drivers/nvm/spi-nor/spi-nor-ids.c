@@ -68,7 +68,7 @@
 	.sector_size = 65536U,			\
 	.n_sectors = (_n_sectors),		\
 	.page_size = 256,			\
-	.flags = SNOR_HAS_FSR | SNOR_SECT_4K | SNOR_NO_4BAIS
+	.flags = SNOR_HAS_FSR | SNOR_SECT_4K | SNOR_NO_4BAIS | SNOR_SUSPEND
 
 #define AT25(_name, _jedec_id, _n_sectors)	\
 	.name = _name,				\
@@ -108,7 +108,7 @@
 	.sector_size = 65536U,			\
 	.n_sectors = (_n_sectors),		\
 	.page_size = 256,			\
-	.flags = SNOR_SECT_4K
+	.flags = SNOR_SECT_4K | SNOR_SUSPEND
 
 #define MX66L(_name, _jedec_id, _n_sectors)	\
 	.name = _name,				\
@@ -116,7 +116,7 @@
 	.sector_size = 65536U,			\
 	.n_sectors = (_n_sectors),		\
 	.page_size = 256,			\
-	.flags = SNOR_SECT_4K
+	.flags = SNOR_SECT_4K | SNOR_SUSPEND
 
 #define S25FL(_name, _jedec_id, _n_sectors, _s_sector, _flags)	\
 	.name = _name,					\
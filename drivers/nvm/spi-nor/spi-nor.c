@@ -31,8 +31,10 @@
  *----------------------------------------------------------------------------*/
 
 #include "board.h"
+#include "dma/dma.h"
 #include "errno.h"
 #include "intmath.h"
+#include "irqflags.h"
 #include "mm/cache.h"
 #include "nvm/spi-nor/spi-nor.h"
 #include "peripherals/bus.h"
@@ -185,6 +187,24 @@ set_erase_map:
 		break;
 	}
 
+	/* Program/Erase Suspend, SFDP gives the exact timings if available. */
+	memset(&flash->program_suspend, 0, sizeof(flash->program_suspend));
+	memset(&flash->erase_suspend, 0, sizeof(flash->erase_suspend));
+	if (info && info->flags & SNOR_SUSPEND) {
+		struct spi_flash_suspend *suspend = &flash->erase_suspend;
+
+		if (spi_flash_get_mfr(flash) == SFLASH_MFR_MACRONIX) {
+			suspend->suspend_inst = SFLASH_INST_SUSPEND_MX;
+			suspend->resume_inst = SFLASH_INST_RESUME_MX;
+		} else {
+			suspend->suspend_inst = SFLASH_INST_SUSPEND;
+			suspend->resume_inst = SFLASH_INST_RESUME;
+		}
+		suspend->latency = 30;
+		suspend->interval = 100;
+		flash->program_suspend = *suspend;
+	}
+
 	/* Override the parameters with data read from SFDP tables. */
 	if (!info || !(info->flags & SNOR_SKIP_SFDP))
 		spi_flash_parse_sfdp(flash, fparams);
@@ -258,6 +278,7 @@ static void spi_nor_set_4bais(struct spi_flash *flash)
 	}
 
 	flash->addr_len = 4;
+	flash->flags |= SFLASH_FLG_4BAIS;
 }
 
 static int sst26_unlock_block_protection(struct spi_flash *flash)
@@ -354,6 +375,71 @@ init_params:
 	return 0;
 }
 
+static uint32_t spi_nor_erase_time(const struct spi_flash_erase_command *erase)
+{
+	/* Without SFDP timings, count operations: the largest erase wins. */
+	return erase->typ_time ? erase->typ_time : 1;
+}
+
+/*
+ * Select the erase command of the next step of erasing [offset, offset + len).
+ *
+ * The largest erase aligned on offset that fits in the range and in its erase
+ * region is a block that any plan has to erase, either at once or with
+ * smaller erases.  The sizes being powers of two, erasing it with N erases
+ * of a single smaller size is possible: the cheapest of these choices, from
+ * the typical erase times, is returned.  Mixed-size plans for the block are
+ * not considered, calling this again on the remaining range only gives a
+ * greedy plan.
+ */
+static const struct spi_flash_erase_command *spi_nor_select_erase(const struct spi_flash *flash, size_t offset, size_t len)
+{
+	const struct spi_flash_erase_map *map = &flash->erase_map;
+	const struct spi_flash_erase_region *region;
+	const struct spi_flash_erase_command *erase = NULL, *best;
+	uint32_t best_time, time, rem;
+	int i;
+
+	region = spi_flash_get_erase_region(flash, offset);
+	if (!region)
+		return NULL;
+	len = min_u32(len, region->offset + region->size - offset);
+
+	for (i = 0; i < SFLASH_CMD_ERASE_MAX; i++) {
+		const struct spi_flash_erase_command *e = &map->commands[i];
+
+		if (!(region->cmd_mask & (0x1UL << i)) || !e->size)
+			continue;
+
+		spi_flash_div_by_erase_size(e, offset, &rem);
+		if (rem)
+			continue;
+
+		if (e->size <= len && (!erase || erase->size < e->size))
+			erase = e;
+	}
+	if (!erase || !erase->size_shift)
+		return erase;
+
+	best = erase;
+	best_time = spi_nor_erase_time(erase);
+	for (i = 0; i < SFLASH_CMD_ERASE_MAX; i++) {
+		const struct spi_flash_erase_command *e = &map->commands[i];
+
+		if (!(region->cmd_mask & (0x1UL << i)) || !e->size_shift ||
+		    e->size >= erase->size)
+			continue;
+
+		time = spi_nor_erase_time(e) * (erase->size >> e->size_shift);
+		if (time < best_time) {
+			best = e;
+			best_time = time;
+		}
+	}
+
+	return best;
+}
+
 static int _bus_init(union spi_flash_priv* priv)
 {
 	return 0;
@@ -403,7 +489,7 @@ static int _bus_exec(union spi_flash_priv* priv, const struct spi_flash_command
 	_bus_exec_buffer[0].attr = BUS_BUF_ATTR_TX;
 	_bus_exec_buffer[0].size = 1 + cmd->addr_len + cmd->num_mode_cycles / 8 + cmd->num_wait_states / 8;
 
-	switch (cmd->flags) {
+	switch (cmd->flags & SFLASH_TYPE_MASK) {
 	case SFLASH_TYPE_READ:
 	case SFLASH_TYPE_READ_REG:
 #ifdef SPI_NOR_VERBOSE_DEBUG
@@ -453,8 +539,18 @@ static int _bus_exec(union spi_flash_priv* priv, const struct spi_flash_command
 #endif
 
 	bus_start_transaction(priv->spi.bus);
-	rc = bus_transfer(priv->spi.bus, priv->spi.spi_dev.chip_select, _bus_exec_buffer, buffers, NULL);
-	bus_wait_transfer(priv->spi.bus);
+	if (cmd->flags & SFLASH_OPT_POLLING) {
+		enum _bus_transfer_mode mode, polling = BUS_TRANSFER_MODE_POLLING;
+
+		bus_ioctl(priv->spi.bus, BUS_IOCTL_GET_TRANSFER_MODE, &mode);
+		bus_ioctl(priv->spi.bus, BUS_IOCTL_SET_TRANSFER_MODE, &polling);
+		rc = bus_transfer(priv->spi.bus, priv->spi.spi_dev.chip_select, _bus_exec_buffer, buffers, NULL);
+		bus_wait_transfer(priv->spi.bus);
+		bus_ioctl(priv->spi.bus, BUS_IOCTL_SET_TRANSFER_MODE, &mode);
+	} else {
+		rc = bus_transfer(priv->spi.bus, priv->spi.spi_dev.chip_select, _bus_exec_buffer, buffers, NULL);
+		bus_wait_transfer(priv->spi.bus);
+	}
 	bus_stop_transaction(priv->spi.bus);
 
 	return rc;
@@ -468,6 +564,176 @@ static const struct spi_ops _spi_bus_ops = {
 	.exec		= _bus_exec,
 };
 
+static const struct spi_flash_suspend *spi_nor_bg_suspend(const struct spi_flash *flash)
+{
+	if (flash->bg.op == SFLASH_BG_ERASE)
+		return &flash->erase_suspend;
+	return &flash->program_suspend;
+}
+
+static void spi_nor_bg_account_read(struct spi_flash *flash, uint32_t latency)
+{
+	struct spi_flash_read_stats *stats = &flash->bg.stats;
+	int i = 0;
+
+	while (i < SFLASH_READ_LATENCY_BUCKETS - 1 && latency >= (16u << i))
+		i++;
+	stats->histogram[i]++;
+	stats->count++;
+	if (latency > stats->max)
+		stats->max = latency;
+}
+
+#ifndef CONFIG_TIMER_POLLING
+
+static uint32_t spi_nor_bg_poll_period(const struct spi_flash *flash)
+{
+	if (flash->bg.op == SFLASH_BG_ERASE)
+		return CONFIG_SPI_NOR_ERASE_POLL_US;
+	return CONFIG_SPI_NOR_PROGRAM_POLL_US;
+}
+
+/* Start the next page program or erase of the background operation. */
+static int spi_nor_bg_start_step(struct spi_flash *flash)
+{
+	struct spi_flash_bg *bg = &flash->bg;
+	struct spi_flash_command cmd;
+	uint32_t delay = spi_nor_bg_poll_period(flash);
+	int rc;
+
+	if (bg->op == SFLASH_BG_ERASE) {
+		if (bg->offset == 0 && bg->len == flash->size) {
+			spi_flash_command_init(&cmd, SFLASH_INST_CHIP_ERASE, 0, SFLASH_TYPE_ERASE);
+			bg->step = bg->len;
+			delay = max_u32(delay, flash->erase_map.chip_erase_time * 1000);
+		} else {
+			const struct spi_flash_erase_command *erase;
+
+			erase = spi_nor_select_erase(flash, bg->offset, bg->len);
+			if (!erase)
+				return -EINVAL;
+			spi_flash_command_init(&cmd, erase->inst, flash->addr_len, SFLASH_TYPE_ERASE);
+			cmd.addr = bg->offset;
+			bg->step = erase->size;
+			delay = max_u32(delay, erase->typ_time * 1000);
+		}
+		cmd.proto = flash->reg_proto;
+	} else {
+		size_t page_offset = bg->offset & (flash->page_size - 1);
+
+		spi_flash_command_init(&cmd, flash->write_inst, flash->addr_len, SFLASH_TYPE_WRITE);
+		cmd.proto = flash->write_proto;
+		cmd.addr = bg->offset;
+		bg->step = min_u32(flash->page_size - page_offset, bg->len);
+		cmd.data_len = bg->step;
+		cmd.tx_data = bg->buf;
+	}
+#ifdef CONFIG_HAVE_AESB
+	cmd.use_aesb = flash->use_aesb;
+#endif
+	/* Following steps are started from the timer interrupt. */
+	cmd.flags |= SFLASH_OPT_POLLING;
+
+	rc = spi_flash_write_enable(flash);
+	rc = rc < 0 ? rc : spi_flash_exec(flash, &cmd);
+	if (rc < 0)
+		return rc;
+
+	bg->suspended = false;
+	bg->resume_time = timer_get_us();
+	bg->deadline = bg->resume_time + (uint64_t)SFLASH_DEFAULT_TIMEOUT * 1000;
+	timer_event_start(&bg->event, delay, 0);
+	return 0;
+}
+
+/*
+ * Status poll of the background operation, from the timer interrupt.  It
+ * backs off while a foreground access holds the flash or while another
+ * device owns the SPI bus.
+ */
+static int spi_nor_bg_poll(void* arg, void* arg2)
+{
+	struct spi_flash *flash = (struct spi_flash*)arg;
+	struct spi_flash_bg *bg = &flash->bg;
+	int rc;
+
+	if (bg->op == SFLASH_BG_IDLE)
+		return 0;
+
+	if (bg->hold)
+		goto rearm;
+#ifdef CONFIG_HAVE_SPI_BUS
+	if (flash->ops == &_spi_bus_ops && bus_is_in_transaction(flash->priv.spi.bus))
+		goto rearm;
+#endif
+
+	rc = spi_flash_is_ready(flash);
+	if (rc == 0) {
+		if (timer_get_us() < bg->deadline)
+			goto rearm;
+		rc = -ETIMEDOUT;
+	}
+
+	if (rc > 0) {
+		bg->offset += bg->step;
+		bg->len -= bg->step;
+		if (bg->buf)
+			bg->buf += bg->step;
+		rc = bg->len ? spi_nor_bg_start_step(flash) : 0;
+		if (rc == 0 && bg->len)
+			return 0;
+	}
+
+	bg->op = SFLASH_BG_IDLE;
+	callback_call(&bg->callback, (void*)rc);
+	return 0;
+
+rearm:
+	timer_event_start(&bg->event, spi_nor_bg_poll_period(flash), 0);
+	return 0;
+}
+
+static int spi_nor_bg_start(struct spi_flash *flash, enum spi_flash_bg_op op, size_t offset, const uint8_t* buf, size_t len, struct _callback *cb)
+{
+	struct spi_flash_bg *bg = &flash->bg;
+	struct _callback _cb;
+	int rc;
+
+	if (bg->op != SFLASH_BG_IDLE)
+		return -EBUSY;
+	if (offset + len > flash->size)
+		return -EINVAL;
+
+	rc = spi_flash_set_protection(flash, false);
+	if (rc < 0)
+		return rc;
+
+	bg->offset = offset;
+	bg->len = len;
+	bg->buf = buf;
+	bg->step = 0;
+	bg->suspended = false;
+	if (cb)
+		callback_copy(&bg->callback, cb);
+	else
+		callback_set(&bg->callback, NULL, NULL);
+	callback_set(&_cb, spi_nor_bg_poll, flash);
+	timer_event_init(&bg->event, &_cb);
+
+	if (!len) {
+		callback_call(&bg->callback, (void*)0);
+		return 0;
+	}
+
+	bg->op = op;
+	rc = spi_nor_bg_start_step(flash);
+	if (rc < 0)
+		bg->op = SFLASH_BG_IDLE;
+	return rc;
+}
+
+#endif /* !CONFIG_TIMER_POLLING */
+
 /*----------------------------------------------------------------------------
  *        Exported Functions
  *----------------------------------------------------------------------------*/
@@ -722,6 +988,18 @@ int spi_nor_configure(struct spi_flash *flash, const struct spi_flash_cfg *cfg)
 int spi_nor_read(struct spi_flash *flash, size_t from, uint8_t* buf, size_t len)
 {
 	struct spi_flash_command cmd;
+	bool held = flash->bg.op != SFLASH_BG_IDLE;
+	uint64_t start = 0;
+	int rc;
+
+	if (held) {
+		start = timer_get_us();
+		rc = spi_nor_suspend(flash);
+		if (rc < 0) {
+			spi_nor_resume(flash);
+			return rc;
+		}
+	}
 
 	spi_flash_command_init(&cmd, flash->read_inst, flash->addr_len, SFLASH_TYPE_READ);
 	cmd.proto = flash->read_proto;
@@ -734,7 +1012,151 @@ int spi_nor_read(struct spi_flash *flash, size_t from, uint8_t* buf, size_t len)
 #ifdef CONFIG_HAVE_AESB
 	cmd.use_aesb = flash->use_aesb;
 #endif
-	return spi_flash_exec(flash, &cmd);
+	rc = spi_flash_exec(flash, &cmd);
+
+	if (held) {
+		spi_nor_resume(flash);
+		spi_nor_bg_account_read(flash, (uint32_t)(timer_get_us() - start));
+	}
+
+	return rc;
+}
+
+int spi_nor_read_async(struct spi_flash *flash, size_t from, uint8_t* buf, size_t len, struct _callback *cb)
+{
+	struct spi_flash_command cmd;
+	int rc;
+
+	/* Reads suspending a background program/erase are synchronous. */
+	if (flash->bg.op != SFLASH_BG_IDLE) {
+		rc = spi_nor_read(flash, from, buf, len);
+		callback_call(cb, (void*)rc);
+		return rc;
+	}
+
+	spi_flash_command_init(&cmd, flash->read_inst, flash->addr_len, SFLASH_TYPE_READ);
+	cmd.proto = flash->read_proto;
+	cmd.addr = from;
+	cmd.mode = flash->normal_mode;
+	cmd.num_mode_cycles = flash->num_mode_cycles;
+	cmd.num_wait_states = flash->num_wait_states;
+	cmd.data_len = len;
+	cmd.rx_data = buf;
+	cmd.callback = cb;
+#ifdef CONFIG_HAVE_AESB
+	cmd.use_aesb = flash->use_aesb;
+#endif
+	rc = spi_flash_exec(flash, &cmd);
+	if (rc == -EINPROGRESS)
+		return 0;
+
+	callback_call(cb, (void*)rc);
+	return rc;
+}
+
+static int spi_nor_stream_callback(void* arg, void* arg2)
+{
+	struct spi_nor_stream *stream = (struct spi_nor_stream*)arg;
+
+	stream->status[stream->fill] = (int)arg2;
+	stream->pending[stream->fill] = false;
+	return 0;
+}
+
+/* Start reading the next part of the stream in buffer i, if any. */
+static int spi_nor_stream_fill(struct spi_nor_stream *stream, uint8_t i)
+{
+	size_t len = min_u32(stream->size, stream->end - stream->offset);
+	struct _callback cb;
+	int rc;
+
+	stream->len[i] = len;
+	stream->status[i] = 0;
+	if (!len)
+		return 0;
+
+	stream->fill = i;
+	stream->pending[i] = true;
+	callback_set(&cb, spi_nor_stream_callback, stream);
+	rc = spi_nor_read_async(stream->flash, stream->offset, stream->buf[i], len, &cb);
+	if (rc < 0)
+		return rc;
+
+	stream->offset += len;
+	return 0;
+}
+
+int spi_nor_stream_open(struct spi_nor_stream *stream, struct spi_flash *flash, size_t from, size_t len, uint8_t *buf, size_t size)
+{
+	if (!size || from + len > flash->size)
+		return -EINVAL;
+
+	memset(stream, 0, sizeof(*stream));
+	stream->flash = flash;
+	stream->offset = from;
+	stream->end = from + len;
+	stream->size = size;
+	stream->buf[0] = buf;
+	stream->buf[1] = buf + size;
+
+	return spi_nor_stream_fill(stream, 0);
+}
+
+int spi_nor_stream_next(struct spi_nor_stream *stream, const uint8_t **data)
+{
+	uint8_t i = stream->cur;
+	int rc;
+
+	while (stream->pending[i])
+		dma_poll();
+	if (stream->status[i] < 0)
+		return stream->status[i];
+
+	/* The other buffer was returned by the previous call: refill it. */
+	stream->cur = i ^ 1;
+	rc = spi_nor_stream_fill(stream, stream->cur);
+	if (rc < 0)
+		return rc;
+
+	*data = stream->buf[i];
+	return stream->len[i];
+}
+
+void spi_nor_stream_close(struct spi_nor_stream *stream)
+{
+	while (stream->pending[0] || stream->pending[1])
+		dma_poll();
+}
+
+int spi_nor_set_read_mode(struct spi_flash *flash, uint32_t hwcaps)
+{
+	const struct spi_flash_read_command *read;
+	int cmd;
+
+	hwcaps &= flash->hwcaps.mask & params.hwcaps.mask & SFLASH_HWCAPS_READ_MASK;
+	if (!hwcaps || !IS_POWER_OF_TWO(hwcaps))
+		return -ENOTSUP;
+	if (flash->bg.op != SFLASH_BG_IDLE)
+		return -EBUSY;
+
+	cmd = spi_flash_hwcaps2cmd(hwcaps);
+	if (cmd < 0)
+		return cmd;
+
+	read = &params.reads[cmd];
+	flash->num_mode_cycles = read->num_mode_cycles;
+	flash->num_wait_states = read->num_wait_states;
+	flash->read_inst = read->inst;
+	flash->read_proto = read->proto;
+	if (flash->flags & SFLASH_FLG_4BAIS)
+		flash->read_inst = spi_nor_convert_3to4_read(flash->read_inst);
+
+	/* Enable Quad I/O if needed. */
+	if (spi_flash_protocol_get_data_nbits(flash->read_proto) == 4 &&
+	    params.quad_enable)
+		return params.quad_enable(flash);
+
+	return 0;
 }
 
 int spi_nor_write(struct spi_flash *flash, size_t to, const uint8_t* buf, size_t len)
@@ -742,6 +1164,9 @@ int spi_nor_write(struct spi_flash *flash, size_t to, const uint8_t* buf, size_t
 	struct spi_flash_command cmd;
 	int rc = 0;
 
+	if (flash->bg.op != SFLASH_BG_IDLE)
+		return -EBUSY;
+
 	rc = spi_flash_set_protection(flash, false);
 	if (rc < 0)
 		return rc;
@@ -783,22 +1208,25 @@ int spi_nor_write(struct spi_flash *flash, size_t to, const uint8_t* buf, size_t
 
 int spi_nor_erase(struct spi_flash *flash, size_t offset, size_t len)
 {
-	const struct spi_flash_erase_map *map = &flash->erase_map;
 	struct spi_flash_command cmd;
 	int rc = 0;
 
+	if (flash->bg.op != SFLASH_BG_IDLE)
+		return -EBUSY;
+
 	rc = spi_flash_set_protection(flash, false);
 	if (rc < 0)
 		return rc;
 
-	if (!spi_flash_has_uniform_erase(flash)) {
-		/* @TODO: add support to non uniform erase map. */
-		return -ENOTSUP;
-	}
+	/* Whole device: one chip erase is faster than any sector plan. */
+	if (offset == 0 && len == flash->size) {
+		spi_flash_command_init(&cmd, SFLASH_INST_CHIP_ERASE, 0, SFLASH_TYPE_ERASE);
+		cmd.proto = flash->reg_proto;
 
-	rc = spi_flash_set_protection(flash, false);
-	if (rc < 0)
-		return rc;
+		rc = spi_flash_write_enable(flash);
+		rc = rc < 0 ? rc : spi_flash_exec(flash, &cmd);
+		return rc < 0 ? rc : spi_flash_wait_till_ready(flash);
+	}
 
 	spi_flash_command_init(&cmd, 0, flash->addr_len, SFLASH_TYPE_ERASE);
 	cmd.proto = flash->reg_proto;
@@ -806,25 +1234,11 @@ int spi_nor_erase(struct spi_flash *flash, size_t offset, size_t len)
 	cmd.use_aesb = flash->use_aesb;
 #endif
 	while (len) {
-		const struct spi_flash_erase_command *erase = NULL;
-		size_t i;
-
-		for (i = 0; i < SFLASH_CMD_ERASE_MAX; i++) {
-			const struct spi_flash_erase_command *e;
-			uint32_t rem;
-
-			if ((map->uniform_region.cmd_mask & (0x1UL << i))) {
-				e = &map->commands[i];
-				spi_flash_div_by_erase_size(e, offset, &rem);
-				if (rem)
-					continue;
-
-				if (e->size <= len && (!erase || erase->size < e->size))
-					erase = e;
-			}
-		}
+		const struct spi_flash_erase_command *erase;
+
+		erase = spi_nor_select_erase(flash, offset, len);
 		if (!erase)
-			return -1;
+			return -EINVAL;
 
 #ifdef SPI_NOR_VERBOSE_DEBUG
 		trace_info("spi-nor: erase params: inst=0x%x\r\n", erase->inst);
@@ -852,3 +1266,104 @@ int spi_nor_erase(struct spi_flash *flash, size_t offset, size_t len)
 
 	return rc;
 }
+
+#ifndef CONFIG_TIMER_POLLING
+int spi_nor_write_async(struct spi_flash *flash, size_t to, const uint8_t* buf, size_t len, struct _callback *cb)
+{
+	return spi_nor_bg_start(flash, SFLASH_BG_PROGRAM, to, buf, len, cb);
+}
+
+int spi_nor_erase_async(struct spi_flash *flash, size_t offset, size_t len, struct _callback *cb)
+{
+	return spi_nor_bg_start(flash, SFLASH_BG_ERASE, offset, NULL, len, cb);
+}
+#endif
+
+bool spi_nor_is_busy(const struct spi_flash *flash)
+{
+	return flash->bg.op != SFLASH_BG_IDLE;
+}
+
+int spi_nor_suspend(struct spi_flash *flash)
+{
+	struct spi_flash_bg *bg = &flash->bg;
+	const struct spi_flash_suspend *suspend;
+	uint32_t flags;
+	uint8_t hold;
+	uint64_t deadline;
+	int rc;
+
+	/* From now on the timer event leaves the flash alone. */
+	flags = arch_irq_save();
+	hold = bg->hold++;
+	arch_irq_restore(flags);
+	if (hold || bg->op == SFLASH_BG_IDLE)
+		return 0;
+
+	rc = spi_flash_is_ready(flash);
+	if (rc != 0)
+		return rc < 0 ? rc : 0;
+
+	suspend = spi_nor_bg_suspend(flash);
+	if (!suspend->suspend_inst)
+		return spi_flash_wait_till_ready(flash);
+
+	/* Let the operation progress between two suspends. */
+	while (timer_get_us() < bg->resume_time + suspend->interval);
+
+	rc = spi_flash_write_reg(flash, suspend->suspend_inst, NULL, 0);
+	if (rc < 0)
+		return rc;
+	bg->hold_time = timer_get_us();
+	bg->suspended = true;
+	bg->stats.suspends++;
+
+	/* Wait for the suspend latency, with some margin. */
+	deadline = bg->hold_time + 2 * suspend->latency + 100;
+	do {
+		rc = spi_flash_is_ready(flash);
+		if (rc != 0)
+			return rc < 0 ? rc : 0;
+	} while (timer_get_us() < deadline);
+
+	return -ETIMEDOUT;
+}
+
+int spi_nor_resume(struct spi_flash *flash)
+{
+	struct spi_flash_bg *bg = &flash->bg;
+	uint32_t flags;
+	int rc = 0;
+
+	if (bg->hold == 1 && bg->suspended) {
+		uint64_t now;
+
+		rc = spi_flash_write_reg(flash, spi_nor_bg_suspend(flash)->resume_inst, NULL, 0);
+		now = timer_get_us();
+		/* The time spent suspended does not count in the step timeout. */
+		bg->deadline += now - bg->hold_time;
+		bg->resume_time = now;
+		bg->suspended = false;
+	}
+
+	flags = arch_irq_save();
+	if (bg->hold)
+		bg->hold--;
+	arch_irq_restore(flags);
+
+	return rc;
+}
+
+void spi_nor_get_read_stats(const struct spi_flash *flash, struct spi_flash_read_stats *stats)
+{
+	uint32_t flags = arch_irq_save();
+	*stats = flash->bg.stats;
+	arch_irq_restore(flags);
+}
+
+void spi_nor_reset_read_stats(struct spi_flash *flash)
+{
+	uint32_t flags = arch_irq_save();
+	memset(&flash->bg.stats, 0, sizeof(flash->bg.stats));
+	arch_irq_restore(flags);
+}
@@ -49,6 +49,17 @@
 #define SNOR_SECT_4K_ONLY	(0x1UL << 5)
 #define SNOR_SST_ULBPR		(0x1UL << 6)
 #define SNOR_SECT_32K		(0x1UL << 7)
+#define SNOR_SUSPEND		(0x1UL << 8)
+
+/** Status poll period of background page programs, in us */
+#ifndef CONFIG_SPI_NOR_PROGRAM_POLL_US
+#define CONFIG_SPI_NOR_PROGRAM_POLL_US 100
+#endif
+
+/** Status poll period of background erases, in us */
+#ifndef CONFIG_SPI_NOR_ERASE_POLL_US
+#define CONFIG_SPI_NOR_ERASE_POLL_US 1000
+#endif
 
 /*----------------------------------------------------------------------------
  *        Exported Types
@@ -86,6 +97,24 @@ struct spi_flash_cfg {
 	};
 };
 
+/*
+ * Read-ahead stream: the range is read in buffer sized parts, the next part
+ * being read in the background (by DMA where the controller can) while the
+ * caller uses the current one.
+ */
+struct spi_nor_stream {
+	struct spi_flash *flash;
+	size_t offset;			/* next part to read */
+	size_t end;
+	uint8_t *buf[2];
+	size_t len[2];
+	size_t size;			/* size of each buffer */
+	uint8_t cur;			/* buffer returned next */
+	uint8_t fill;			/* buffer being read */
+	volatile bool pending[2];
+	volatile int status[2];
+};
+
 struct spi_nor_info {
 	const char		*name;
 
@@ -113,9 +142,64 @@ extern const struct spi_nor_info spi_nor_ids[];
 
 int spi_nor_configure(struct spi_flash *flash, const struct spi_flash_cfg *cfg);
 int spi_nor_read(struct spi_flash *flash, size_t from, uint8_t* buf, size_t len);
+
+/*
+ * Start a read and return: cb is called with the status as second argument,
+ * from the DMA interrupt, when the controller can read in the background,
+ * before returning otherwise.  buf and len should be aligned on cache lines.
+ */
+int spi_nor_read_async(struct spi_flash *flash, size_t from, uint8_t* buf, size_t len, struct _callback *cb);
+
+/*
+ * Open a read-ahead stream on [from, from + len): buf holds two buffers of
+ * size bytes, aligned on cache lines, and the first read is started.
+ */
+int spi_nor_stream_open(struct spi_nor_stream *stream, struct spi_flash *flash, size_t from, size_t len, uint8_t *buf, size_t size);
+
+/*
+ * Wait for the next part of the stream and start reading the one after it.
+ * The data is valid until the next call, and the size (0 at the end of the
+ * stream) or an error code is returned.
+ */
+int spi_nor_stream_next(struct spi_nor_stream *stream, const uint8_t **data);
+
+/* Wait for the read in progress, if any, before the buffers are reused. */
+void spi_nor_stream_close(struct spi_nor_stream *stream);
+
+/*
+ * Select the read command from one SFLASH_HWCAPS_READ_* capability (e.g.
+ * SFLASH_HWCAPS_READ_1_1_4), among those supported by the flash and the
+ * controller.  spi_nor_configure() selects the fastest one.
+ */
+int spi_nor_set_read_mode(struct spi_flash *flash, uint32_t hwcaps);
 int spi_nor_write(struct spi_flash *flash, size_t to, const uint8_t* buf, size_t len);
 int spi_nor_erase(struct spi_flash *flash, size_t offset, size_t len);
 
+#ifndef CONFIG_TIMER_POLLING
+/*
+ * Background program and erase: the operation is started and the function
+ * returns, the status register is then polled from a timer event and the
+ * next page or sector is started from there.  cb is called, from interrupt
+ * context, with the status as second argument.  Reads done meanwhile with
+ * spi_nor_read() suspend the operation if the flash supports it, or wait for
+ * the page or sector in progress otherwise.
+ */
+int spi_nor_write_async(struct spi_flash *flash, size_t to, const uint8_t* buf, size_t len, struct _callback *cb);
+int spi_nor_erase_async(struct spi_flash *flash, size_t offset, size_t len, struct _callback *cb);
+#endif
+bool spi_nor_is_busy(const struct spi_flash *flash);
+
+/*
+ * Hold the background operation for a foreground access to the flash (for
+ * instance XIP code or data), suspending it if possible: the flash can be
+ * read until spi_nor_resume().  Calls can be nested.
+ */
+int spi_nor_suspend(struct spi_flash *flash);
+int spi_nor_resume(struct spi_flash *flash);
+
+void spi_nor_get_read_stats(const struct spi_flash *flash, struct spi_flash_read_stats *stats);
+void spi_nor_reset_read_stats(struct spi_flash *flash);
+
 int spansion_new_quad_enable(struct spi_flash *flash);
 int spansion_quad_enable(struct spi_flash *flash);
 int macronix_quad_enable(struct spi_flash *flash);
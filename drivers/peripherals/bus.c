@@ -34,15 +34,18 @@
 #include <string.h>
 
 #include "callback.h"
+#include "cpuidle.h"
 #include "dma/dma.h"
 #include "errno.h"
 #include "peripherals/bus.h"
+#include "peripherals/pmc.h"
 #ifdef CONFIG_HAVE_BUS_SPI
 #include "spi/spid.h"
 #endif
 #ifdef CONFIG_HAVE_BUS_I2C
 #include "i2c/twid.h"
 #endif
+#include "irqflags.h"
 #include "timer.h"
 #include "trace.h"
 
@@ -71,11 +74,24 @@ struct _bus_desc {
 	uint32_t timeout;
 
 	struct _callback callback;
+	volatile int status;          /* status of the last bus_transfer() */
 
 	struct {
-		mutex_t lock;
-		mutex_t transaction;
+		mutex_t lock;                 /* a transfer is in progress */
+		mutex_t transaction;          /* the bus is granted to a transaction */
 	} mutex;
+
+	/* transfers and transactions waiting for the bus */
+	struct {
+		struct _bus_request* head;    /* waiting, by decreasing priority */
+		struct _bus_request* current; /* queued transfer in progress */
+		bool running;                 /* _bus_queue_run() in progress */
+		struct _bus_stats stats;
+	} queue;
+
+	/* restarts the queue once the driver is released after a master
+	 * clock change */
+	struct _pmc_mck_notifier mck_notifier;
 };
 
 /*----------------------------------------------------------------------------
@@ -88,6 +104,35 @@ static struct _bus_desc _bus[BUS_COUNT];
  *         Local functions
  *----------------------------------------------------------------------------*/
 
+/**
+ * \brief Tell if the caller can wait for a completion: with the interrupts
+ * masked (e.g. from an interrupt handler), the completion of an
+ * asynchronous transfer is never signalled.
+ */
+static bool _bus_can_wait(uint8_t bus_id)
+{
+	return !arch_irq_is_masked() ||
+	       _bus[bus_id].transfer_mode != BUS_TRANSFER_MODE_ASYNC;
+}
+
+/**
+ * \brief Wait for the completion interrupt, or poll when the completion
+ * cannot be signalled by an interrupt.
+ */
+static void _bus_idle(uint8_t bus_id)
+{
+#ifdef CONFIG_HAVE_I2C_BUS
+	/* short buffers of a chain may be interrupt driven */
+	if (_bus[bus_id].type == BUS_TYPE_I2C && arch_irq_is_masked())
+		twid_poll(&_bus[bus_id].iface.twid);
+#endif
+	if (_bus[bus_id].transfer_mode == BUS_TRANSFER_MODE_DMA &&
+	    (dma_is_polling() || arch_irq_is_masked()))
+		dma_poll();
+	else if (!arch_irq_is_masked())
+		cpu_idle();
+}
+
 static int _bus_callback(void* arg, void* arg2)
 {
 	uint32_t bus_id = (uint32_t)arg;
@@ -95,9 +140,179 @@ static int _bus_callback(void* arg, void* arg2)
 	if (bus_id >= BUS_COUNT)
 		return -ENODEV;
 
+	_bus[bus_id].status = (int)arg2;
 	mutex_unlock(&_bus[bus_id].mutex.lock);
 
-	return callback_call(&_bus[bus_id].callback, NULL);
+	return callback_call(&_bus[bus_id].callback, arg2);
+}
+
+static int _bus_start_transfer(uint8_t bus_id, uint16_t remote,
+		struct _buffer* buf, uint16_t buffers, struct _callback* cb)
+{
+	int err;
+
+	switch (_bus[bus_id].type) {
+#ifdef CONFIG_HAVE_SPI_BUS
+	case BUS_TYPE_SPI:
+		_bus[bus_id].iface.spid.chip_select = (uint8_t)remote;
+
+		err = spid_transfer(&_bus[bus_id].iface.spid, buf, buffers, cb);
+		break;
+#endif
+#ifdef CONFIG_HAVE_I2C_BUS
+	case BUS_TYPE_I2C:
+		_bus[bus_id].iface.twid.slave_addr = (uint8_t)remote;
+
+		err = twid_transfer(&_bus[bus_id].iface.twid, buf, buffers, cb);
+		break;
+#endif
+	default:
+		err = -EINVAL;
+		break;
+	}
+
+	return err;
+}
+
+static void _bus_queue_run(uint8_t bus_id);
+
+static void _bus_queue_complete(uint8_t bus_id, struct _bus_request* req, int status)
+{
+	struct _bus_desc* bus = &_bus[bus_id];
+
+	bus->queue.current = NULL;
+	mutex_unlock(&bus->mutex.lock);
+
+	bus->queue.stats.completed++;
+	if (status < 0)
+		bus->queue.stats.errors++;
+	req->status = status;
+	callback_call(&req->callback, (void*)status);
+}
+
+static int _bus_queue_callback(void* arg, void* arg2)
+{
+	uint8_t bus_id = (uint8_t)(uint32_t)arg;
+
+	_bus_queue_complete(bus_id, _bus[bus_id].queue.current, (int)arg2);
+
+	/* chain the next request from the completion interrupt */
+	_bus_queue_run(bus_id);
+
+	return 0;
+}
+
+static void _bus_queue_insert(uint8_t bus_id, struct _bus_request* req)
+{
+	struct _bus_desc* bus = &_bus[bus_id];
+	struct _bus_request** prev;
+	uint32_t flags;
+
+	req->status = -EINPROGRESS;
+	req->submit_us = timer_get_us();
+
+	flags = arch_irq_save();
+
+	/* after the requests of the same or of a higher priority */
+	prev = &bus->queue.head;
+	while (*prev && (*prev)->priority >= req->priority)
+		prev = &(*prev)->next;
+	req->next = *prev;
+	*prev = req;
+
+	bus->queue.stats.submitted++;
+	bus->queue.stats.depth++;
+	if (bus->queue.stats.depth > bus->queue.stats.max_depth)
+		bus->queue.stats.max_depth = bus->queue.stats.depth;
+
+	arch_irq_restore(flags);
+}
+
+/**
+ * \brief Start the waiting requests while the bus is free.
+ * Transfers completing synchronously (polling mode) are chained by the loop,
+ * other ones by _bus_queue_callback(). A request without buffers stands for
+ * a transaction: the bus is granted to it and the queue stops until
+ * bus_stop_transaction().
+ */
+static void _bus_queue_run(uint8_t bus_id)
+{
+	struct _bus_desc* bus = &_bus[bus_id];
+	struct _bus_request* req;
+	struct _callback _cb;
+	uint32_t flags, wait;
+	int err;
+
+	flags = arch_irq_save();
+	if (bus->queue.running) {
+		arch_irq_restore(flags);
+		return;
+	}
+	bus->queue.running = true;
+
+	while (bus->queue.head && !bus->queue.current) {
+		if (mutex_is_locked(&bus->mutex.transaction))
+			break;
+
+		req = bus->queue.head;
+		if (req->buf) {
+			if (!mutex_try_lock(&bus->mutex.lock))
+				break;
+		} else {
+			if (!mutex_try_lock(&bus->mutex.transaction))
+				break;
+		}
+
+		bus->queue.head = req->next;
+		bus->queue.stats.depth--;
+		wait = (uint32_t)(timer_get_us() - req->submit_us);
+		bus->queue.stats.wait_us += wait;
+		if (wait > bus->queue.stats.max_wait_us)
+			bus->queue.stats.max_wait_us = wait;
+
+		if (!req->buf) {
+			/* the waiter in bus_start_transaction() owns the bus */
+			bus->queue.stats.completed++;
+			req->status = 0;
+			break;
+		}
+
+		bus->queue.current = req;
+		arch_irq_restore(flags);
+
+		callback_set(&_cb, _bus_queue_callback, (void*)(uint32_t)bus_id);
+		err = _bus_start_transfer(bus_id, req->remote, req->buf, req->buffers, &_cb);
+
+		flags = arch_irq_save();
+		if (err == -EBUSY) {
+			/* the driver is held during a master clock change:
+			 * keep the request first, _bus_mck_notify() restarts
+			 * the queue */
+			bus->queue.current = NULL;
+			mutex_unlock(&bus->mutex.lock);
+			req->next = bus->queue.head;
+			bus->queue.head = req;
+			bus->queue.stats.depth++;
+			break;
+		}
+		if (err < 0)
+			_bus_queue_complete(bus_id, req, err);
+	}
+
+	/* cleared with the interrupts masked, so that no completion is missed */
+	bus->queue.running = false;
+	arch_irq_restore(flags);
+}
+
+static int _bus_mck_notify(void* arg, void* arg2)
+{
+	uint8_t bus_id = (uint8_t)(uint32_t)arg;
+	enum _pmc_mck_event event = (enum _pmc_mck_event)arg2;
+
+	if (event == PMC_MCK_POST_CHANGE)
+		_bus_queue_run(bus_id);
+
+	return 0;
 }
 
 static int _bus_fifo_enable(uint8_t bus_id)
@@ -299,11 +514,34 @@ int bus_configure(uint8_t bus_id, const struct _bus_iface* iface)
 	if (bus_id >= BUS_COUNT)
 		return -ENODEV;
 
+	/* The bus may be reconfigured: unhook the master clock notifier of
+	 * the driver before clearing it */
+	switch (_bus[bus_id].type) {
+#ifdef CONFIG_HAVE_SPI_BUS
+	case BUS_TYPE_SPI:
+		pmc_unregister_mck_notifier(&_bus[bus_id].iface.spid.mck_notifier);
+		break;
+#endif
+#ifdef CONFIG_HAVE_I2C_BUS
+	case BUS_TYPE_I2C:
+		pmc_unregister_mck_notifier(&_bus[bus_id].iface.twid.mck_notifier);
+		break;
+#endif
+	default:
+		break;
+	}
+	pmc_unregister_mck_notifier(&_bus[bus_id].mck_notifier);
+
 	memset(&_bus[bus_id], 0, sizeof(_bus[bus_id]));
 	_bus[bus_id].transfer_mode = iface->transfer_mode;
 	_bus[bus_id].options = O_BLOCK;
 	_bus[bus_id].type = iface->type;
 
+	/* registered before the driver one, so that it is called after it */
+	callback_set(&_bus[bus_id].mck_notifier.callback, _bus_mck_notify,
+			(void*)(uint32_t)bus_id);
+	pmc_register_mck_notifier(&_bus[bus_id].mck_notifier);
+
 	switch (_bus[bus_id].type) {
 #ifdef CONFIG_HAVE_SPI_BUS
 	case BUS_TYPE_SPI:
@@ -401,6 +639,35 @@ int bus_ioctl(uint8_t bus_id, int req, void* arg)
 	case BUS_IOCTL_SET_TIMEOUT:
 		_bus[bus_id].timeout = *(uint32_t*)arg;
 		break;
+	case BUS_IOCTL_GET_STATS:
+	{
+		uint32_t flags = arch_irq_save();
+		*(struct _bus_stats*)arg = _bus[bus_id].queue.stats;
+		arch_irq_restore(flags);
+		break;
+	}
+	case BUS_IOCTL_RESET_STATS:
+	{
+		uint32_t flags = arch_irq_save();
+		struct _bus_stats* stats = &_bus[bus_id].queue.stats;
+		uint32_t depth = stats->depth;
+		memset(stats, 0, sizeof(*stats));
+		stats->depth = depth;
+		stats->max_depth = depth;
+#ifdef CONFIG_HAVE_I2C_BUS
+		if (_bus[bus_id].type == BUS_TYPE_I2C)
+			twid_reset_stats(&_bus[bus_id].iface.twid);
+#endif
+		arch_irq_restore(flags);
+		break;
+	}
+#ifdef CONFIG_HAVE_I2C_BUS
+	case BUS_IOCTL_GET_I2C_STATS:
+		if (_bus[bus_id].type != BUS_TYPE_I2C)
+			return -ENOTSUP;
+		twid_get_stats(&_bus[bus_id].iface.twid, (struct _twid_stats*)arg);
+		break;
+#endif
 
 	default:
 		err = -EINVAL;
@@ -422,56 +689,68 @@ int bus_transfer(uint8_t bus_id, uint16_t remote, struct _buffer* buf, uint16_t
 		return 0;
 
 	if (!mutex_is_locked(&_bus[bus_id].mutex.transaction)) {
-		trace_error("bus: no opened transaction on the bus.");
-		return -EBUSY;
+		/* no transaction: queue the transfer behind the other users */
+		struct _bus_request req = {
+			.remote = remote,
+			.buf = buf,
+			.buffers = buffers,
+			.priority = BUS_PRIORITY_DEFAULT,
+		};
+
+		if (!_bus_can_wait(bus_id))
+			return -EAGAIN;
+
+		callback_copy(&req.callback, cb);
+		_bus_queue_insert(bus_id, &req);
+		_bus_queue_run(bus_id);
+		return bus_wait_request(bus_id, &req);
 	}
-	if (!mutex_try_lock(&_bus[bus_id].mutex.lock))
+
+	if ((_bus[bus_id].options & O_BLOCK) && !_bus_can_wait(bus_id))
 		return -EAGAIN;
 
+	/* previous transfer of the transaction still in progress */
+	while (!mutex_try_lock(&_bus[bus_id].mutex.lock)) {
+		if (!_bus_can_wait(bus_id))
+			return -EAGAIN;
+		_bus_idle(bus_id);
+	}
+
 	callback_copy(&_bus[bus_id].callback, cb);
+	_bus[bus_id].status = 0;
 
 	callback_set(&_cb, _bus_callback, (void*)(uint32_t)bus_id);
-	switch (_bus[bus_id].type) {
-#ifdef CONFIG_HAVE_SPI_BUS
-	case BUS_TYPE_SPI:
-		_bus[bus_id].iface.spid.chip_select = (uint8_t)remote;
-
-		err = spid_transfer(&_bus[bus_id].iface.spid, buf, buffers, &_cb);
-		break;
-#endif
-#ifdef CONFIG_HAVE_I2C_BUS
-	case BUS_TYPE_I2C:
-		_bus[bus_id].iface.twid.slave_addr = (uint8_t)remote;
-
-		err = twid_transfer(&_bus[bus_id].iface.twid, buf, buffers, &_cb);
-		break;
-#endif
-	default:
-		err = -EINVAL;
-		break;
-	}
-
+	err = _bus_start_transfer(bus_id, remote, buf, buffers, &_cb);
 	if (err < 0) {
 		mutex_unlock(&_bus[bus_id].mutex.lock);
 		return err;
 	}
-	if (_bus[bus_id].options & O_BLOCK)
-		while (bus_is_busy(bus_id)) {
-			if (_bus[bus_id].transfer_mode == BUS_TRANSFER_MODE_DMA)
-				dma_poll();
-		}
+	if (_bus[bus_id].options & O_BLOCK) {
+		while (bus_is_busy(bus_id))
+			_bus_idle(bus_id);
+		/* errors of the buffers completed from the callback chain */
+		err = _bus[bus_id].status;
+	}
 
 	return err;
 }
 
 int bus_start_transaction(uint8_t bus_id)
 {
+	/* a request without buffers is granted the bus in its turn */
+	struct _bus_request req = {
+		.priority = BUS_PRIORITY_DEFAULT,
+	};
+
 	if (bus_id >= BUS_COUNT)
 		return -ENODEV;
+	if (!_bus_can_wait(bus_id))
+		return -EAGAIN;
 
-	mutex_lock(&_bus[bus_id].mutex.transaction);
+	_bus_queue_insert(bus_id, &req);
+	_bus_queue_run(bus_id);
 
-	return 0;
+	return bus_wait_request(bus_id, &req);
 }
 
 int bus_stop_transaction(uint8_t bus_id)
@@ -481,9 +760,68 @@ int bus_stop_transaction(uint8_t bus_id)
 
 	mutex_unlock(&_bus[bus_id].mutex.transaction);
 
+	_bus_queue_run(bus_id);
+
+	return 0;
+}
+
+int bus_submit(uint8_t bus_id, struct _bus_request* req)
+{
+	if (bus_id >= BUS_COUNT)
+		return -ENODEV;
+	if (req->buf == NULL || req->buffers == 0)
+		return -EINVAL;
+
+	_bus_queue_insert(bus_id, req);
+	_bus_queue_run(bus_id);
+
 	return 0;
 }
 
+int bus_cancel(uint8_t bus_id, struct _bus_request* req)
+{
+	struct _bus_request** prev;
+	uint32_t flags;
+	int err = -EBUSY;
+
+	if (bus_id >= BUS_COUNT)
+		return -ENODEV;
+
+	flags = arch_irq_save();
+	for (prev = &_bus[bus_id].queue.head; *prev; prev = &(*prev)->next) {
+		if (*prev == req) {
+			*prev = req->next;
+			_bus[bus_id].queue.stats.depth--;
+			req->status = -ECANCELED;
+			err = 0;
+			break;
+		}
+	}
+	arch_irq_restore(flags);
+
+	return err;
+}
+
+int bus_wait_request(uint8_t bus_id, struct _bus_request* req)
+{
+	if (bus_id >= BUS_COUNT)
+		return -ENODEV;
+
+	while (req->status == -EINPROGRESS) {
+		if (!_bus_can_wait(bus_id))
+			return -EAGAIN;
+		_bus_idle(bus_id);
+	}
+
+	return req->status;
+}
+
+bool bus_is_in_transaction(uint8_t bus_id)
+{
+	return mutex_is_locked(&_bus[bus_id].mutex.transaction) ||
+	       _bus[bus_id].queue.current != NULL;
+}
+
 void bus_wait_transaction(uint8_t bus_id)
 {
 	while (mutex_is_locked(&_bus[bus_id].mutex.transaction));
@@ -51,6 +51,9 @@
 
 #define BUS_COUNT (SPI_IFACE_COUNT + TWI_IFACE_COUNT)
 
+/** Priority of transactions and of transfers queued by bus_transfer() */
+#define BUS_PRIORITY_DEFAULT 128
+
 enum _bus_type {
 	BUS_TYPE_NONE,
 	BUS_TYPE_I2C,
@@ -70,25 +73,16 @@ enum _bus_ioctl {
 	BUS_IOCTL_SET_TRANSFER_MODE = 6,
 	BUS_IOCTL_GET_TRANSFER_MODE = 7,
 	BUS_IOCTL_SET_TIMEOUT = 8,
+	BUS_IOCTL_GET_STATS = 9,
+	BUS_IOCTL_RESET_STATS = 10,
+	BUS_IOCTL_GET_I2C_STATS = 11,
 };
 
 /*----------------------------------------------------------------------------
  *         Exported types
  *----------------------------------------------------------------------------*/
 
-enum _bus_buf_attr {
-	BUS_BUF_ATTR_RX                = 0x0001,
-	BUS_BUF_ATTR_TX                = 0x0002,
-
-#ifdef CONFIG_HAVE_SPI_BUS
-	BUS_SPI_BUF_ATTR_RELEASE_CS        = 0x0800,
-#endif
-
-#ifdef CONFIG_HAVE_I2C_BUS
-	BUS_I2C_BUF_ATTR_START             = 0x1000,
-	BUS_I2C_BUF_ATTR_STOP              = 0x2000,
-#endif
-};
+/* enum _bus_buf_attr, the attributes of struct _buffer, is in io.h */
 
 enum _bus_transfer_mode {
 	BUS_TRANSFER_MODE_POLLING,
@@ -115,6 +109,39 @@ struct _bus_iface {
 	enum _bus_transfer_mode transfer_mode;
 };
 
+/**
+ * \brief Request queued with bus_submit()
+ *
+ * The request and its buffers must stay valid until its callback is called.
+ * The callback is called, from interrupt context, with the status of the
+ * transfer (0 or < 0) as second argument.
+ */
+struct _bus_request {
+	uint16_t remote;          /* chip select (SPI) or slave address (I2C) */
+	struct _buffer* buf;
+	uint16_t buffers;
+	uint8_t priority;         /* higher values are served first */
+	struct _callback callback;
+
+	/* internal */
+	struct _bus_request* next;
+	uint64_t submit_us;
+	volatile int status;
+};
+
+/**
+ * \brief Statistics of the request queue of a bus (BUS_IOCTL_GET_STATS)
+ */
+struct _bus_stats {
+	uint32_t submitted;
+	uint32_t completed;
+	uint32_t errors;
+	uint32_t depth;           /* requests waiting */
+	uint32_t max_depth;
+	uint64_t wait_us;         /* total time from submit to start */
+	uint32_t max_wait_us;
+};
+
 struct _bus_dev_cfg {
 	uint8_t bus;
 	union {
@@ -168,6 +195,9 @@ int bus_configure_slave(uint8_t bus_id, const struct _bus_dev_cfg* cfg);
  *  - BUS_IOCTL_SET_TRANSFER_MODE: arg is an enum _bus_transfer_mode*
  *  - BUS_IOCTL_GET_TRANSFER_MODE: arg is an enum _bus_transfer_mode*
  *  - BUS_IOCTL_SET_TIMEOUT: arg is a uint32_t*
+ *  - BUS_IOCTL_GET_STATS: arg is a struct _bus_stats*
+ *  - BUS_IOCTL_RESET_STATS: arg is ignored, resets the I2C counters too
+ *  - BUS_IOCTL_GET_I2C_STATS: arg is a struct _twid_stats* (I2C bus only)
  *
  * \param arg     Argument of a control
  * \return 0 on success, < 0 on error
@@ -178,7 +208,10 @@ int bus_ioctl(uint8_t bus_id, int req, void* arg);
  * Lock the bus to transfer data.
  * One transaction can lock the bus for multiple data transfer.
  *
- * It is mandatory to lock the bus before trasnferring data
+ * The transaction waits in the request queue of the bus with priority
+ * BUS_PRIORITY_DEFAULT, the CPU sleeping until the bus is granted. With the
+ * interrupts masked, the DMA completions are polled, and -EAGAIN is
+ * returned in BUS_TRANSFER_MODE_ASYNC since nothing can complete.
  * \param bus_id     Bus id
  * \return 0 on success, < 0 on error
  */
@@ -191,6 +224,14 @@ int bus_start_transaction(uint8_t bus_id);
  */
 int bus_stop_transaction(uint8_t bus_id);
 
+/**
+ * \brief Tell if a transaction is open on the bus
+ *
+ * \param bus_id     Bus id
+ * \return true if bus_start_transaction() would have to wait
+ */
+bool bus_is_in_transaction(uint8_t bus_id);
+
 /**
  * \brief Wait until the current transaction is over
  *
@@ -201,6 +242,12 @@ void bus_wait_transaction(uint8_t bus_id);
 /**
  * \brief Start a data transfer on bus \bus_id for remote at address \remote
  *
+ * Inside a transaction, the transfer starts once the previous one of the
+ * transaction is over. Outside of a transaction, it is queued with priority
+ * BUS_PRIORITY_DEFAULT and the call returns when it is over. As for
+ * bus_start_transaction(), a call which would wait with the interrupts
+ * masked returns -EAGAIN in BUS_TRANSFER_MODE_ASYNC.
+ *
  * \param bus_id     bus id
  * \param remote     Address of the remote device
  * \param buf        List of buffer to transfer
@@ -210,6 +257,41 @@ void bus_wait_transaction(uint8_t bus_id);
  */
 int bus_transfer(uint8_t bus_id, uint16_t remote, struct _buffer* buf, uint16_t buffers, struct _callback* cb);
 
+/**
+ * \brief Queue a transfer on bus \bus_id
+ *
+ * Requests, transactions opened with bus_start_transaction() and transfers
+ * issued by bus_transfer() outside of a transaction share the queue. They
+ * are served by decreasing priority, in submission order for the same
+ * priority. The next request is started from the completion interrupt of
+ * the previous one, or by bus_stop_transaction().
+ *
+ * \param bus_id     bus id
+ * \param req        Request to queue
+ * \return 0 on success, < 0 on error
+ */
+int bus_submit(uint8_t bus_id, struct _bus_request* req);
+
+/**
+ * \brief Remove a request from the queue of bus \bus_id
+ *
+ * \param bus_id     bus id
+ * \param req        Request to remove, its status is set to -ECANCELED
+ * \return 0 on success, -EBUSY if the request is not waiting anymore
+ */
+int bus_cancel(uint8_t bus_id, struct _bus_request* req);
+
+/**
+ * \brief Wait until a request is over, the CPU sleeping until the
+ * completion interrupt
+ *
+ * \param bus_id     bus id
+ * \param req        Request submitted with bus_submit()
+ * \return status of the request, -EAGAIN if it is still in progress and
+ * cannot complete because the interrupts are masked
+ */
+int bus_wait_request(uint8_t bus_id, struct _bus_request* req);
+
 /**
  * \brief Verify is the bus is in use
  *
@@ -95,6 +95,7 @@ struct _pmc_main_osc {
  *----------------------------------------------------------------------------*/
 
 static uint32_t _pmc_mck = 0;
+static struct _pmc_mck_notifier* _pmc_mck_notifiers = NULL;
 static struct _pmc_main_osc _pmc_main_oscillators = {
 	.rc_freq = MAIN_CLOCK_INT_OSC,
 };
@@ -474,6 +475,46 @@ uint32_t pmc_get_main_oscillator_freq(void)
 		return pmc_set_main_oscillator_freq(0);
 }
 
+void pmc_register_mck_notifier(struct _pmc_mck_notifier* notifier)
+{
+	struct _pmc_mck_notifier* cur;
+
+	for (cur = _pmc_mck_notifiers; cur; cur = cur->next)
+		if (cur == notifier)
+			return;
+
+	notifier->next = _pmc_mck_notifiers;
+	_pmc_mck_notifiers = notifier;
+}
+
+void pmc_unregister_mck_notifier(struct _pmc_mck_notifier* notifier)
+{
+	struct _pmc_mck_notifier** cur;
+
+	for (cur = &_pmc_mck_notifiers; *cur; cur = &(*cur)->next) {
+		if (*cur == notifier) {
+			*cur = notifier->next;
+			notifier->next = NULL;
+			return;
+		}
+	}
+}
+
+void pmc_notify_mck_change(enum _pmc_mck_event event)
+{
+	struct _pmc_mck_notifier* cur = _pmc_mck_notifiers;
+	struct _pmc_mck_notifier* next;
+
+	if (event == PMC_MCK_POST_CHANGE)
+		_pmc_mck = 0;
+
+	while (cur) {
+		next = cur->next;
+		callback_call(&cur->callback, (void*)event);
+		cur = next;
+	}
+}
+
 uint32_t pmc_get_master_clock(void)
 {
 	if (!_pmc_mck)
@@ -775,6 +816,8 @@ void pmc_set_mck_prescaler(uint32_t prescaler)
 	/* Change MCK Prescaler divider in PMC_MCKR register */
 	PMC->PMC_MCKR = (PMC->PMC_MCKR & ~PMC_MCKR_PRES_Msk) | prescaler;
 	while (!(PMC->PMC_SR & PMC_SR_MCKRDY));
+
+	_pmc_mck = 0;
 }
 
 #ifdef CONFIG_HAVE_PMC_PLLADIV2
@@ -829,6 +872,8 @@ void pmc_set_mck_divider(uint32_t divider)
 	/* change MCK Prescaler divider in PMC_MCKR register */
 	PMC->PMC_MCKR = (PMC->PMC_MCKR & ~PMC_MCKR_MDIV_Msk) | divider;
 	while (!(PMC->PMC_SR & PMC_SR_MCKRDY));
+
+	_pmc_mck = 0;
 }
 
 void pmc_configure_plla(const struct _pmc_plla_cfg* plla)
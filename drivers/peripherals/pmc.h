@@ -35,6 +35,7 @@
  *----------------------------------------------------------------------------*/
 
 #include "chip.h"
+#include "callback.h"
 
 #include <stdint.h>
 
@@ -137,6 +138,26 @@ enum _pmc_system_clock {
 	PMC_SYSTEM_CLOCK_ISC,
 };
 
+/**
+ * \brief Master clock change events, passed as second argument to the
+ * notifier callbacks
+ */
+enum _pmc_mck_event {
+	PMC_MCK_PRE_CHANGE,  /**< the master clock is about to change */
+	PMC_MCK_POST_CHANGE, /**< the master clock has changed */
+};
+
+/**
+ * \brief Master clock change notifier
+ *
+ * Drivers whose dividers depend on the master clock register one to
+ * quiesce before the change and recompute their dividers after it.
+ */
+struct _pmc_mck_notifier {
+	struct _callback callback;
+	struct _pmc_mck_notifier* next;
+};
+
 #ifdef CONFIG_HAVE_PMC_AUDIO_CLOCK
 /**
  * \brief Configuration data for Audio clock
@@ -178,6 +199,30 @@ extern uint32_t pmc_get_main_oscillator_freq(void);
  */
 extern void pmc_set_custom_pck_mck(const struct pck_mck_cfg *cfg);
 
+/**
+ * \brief Register a master clock change notifier.
+ *
+ * Registering an already registered notifier does nothing.
+ */
+extern void pmc_register_mck_notifier(struct _pmc_mck_notifier* notifier);
+
+/**
+ * \brief Unregister a master clock change notifier.
+ */
+extern void pmc_unregister_mck_notifier(struct _pmc_mck_notifier* notifier);
+
+/**
+ * \brief Call all registered master clock change notifiers.
+ *
+ * Must be called from thread context, with interrupts enabled, around any
+ * runtime change of the master clock frequency (see drivers/power/dvfs.h).
+ * Notifiers may wait for on-going transfers when receiving
+ * PMC_MCK_PRE_CHANGE.
+ *
+ * \param event  PMC_MCK_PRE_CHANGE or PMC_MCK_POST_CHANGE
+ */
+extern void pmc_notify_mck_change(enum _pmc_mck_event event);
+
 /**
  * \brief Get the configured frequency of the master clock
  * \return master clock frequency in Hz
@@ -150,3 +150,19 @@ int act8865_set_reg_voltage(struct _act8865* act8865, uint8_t volt_reg, uint8_t
 
 	return 0;
 }
+
+uint8_t act8865_get_voltage_code(uint16_t mv)
+{
+	/* 600mV to 1200mV by 25mV, 1200mV to 2400mV by 50mV, then by 100mV */
+	if (mv < 600)
+		mv = 600;
+	if (mv > 3900)
+		mv = 3900;
+
+	if (mv < 1200)
+		return (mv - 600) / 25;
+	else if (mv < 2400)
+		return 0x18 + (mv - 1200) / 50;
+	else
+		return 0x30 + (mv - 2400) / 100;
+}
@@ -108,5 +108,6 @@ struct _act8865 {
  */
 extern int act8865_set_reg_voltage(struct _act8865* act8865, uint8_t volt_reg, uint8_t value);
 extern int act8865_check_twi_status(struct _act8865* act8865);
+extern uint8_t act8865_get_voltage_code(uint16_t mv);
 
 #endif /* _ACT_8865_H_ */
@@ -49,7 +49,14 @@
  *        Types
  *----------------------------------------------------------------------------*/
 
-#define STATE_VSEL 1 // HW config DDR3L
+/* Level of the VSEL pin, which selects the VSET0 (low) or VSET1 (high)
+ * register of DC/DC regulators 1 to 3. It is tied high on SAMA5D2-Xplained
+ * (DDR3L configuration) and cannot be read back from the PMIC. */
+#ifndef CONFIG_ACT8945A_VSEL
+#define CONFIG_ACT8945A_VSEL 1
+#endif
+
+#define STATE_VSEL CONFIG_ACT8945A_VSEL
 
 // SYS @0x00
 union _sys0 {
@@ -281,7 +288,9 @@ static bool _act8945a_read_reg(struct _act8945a* act8945a, uint8_t iaddr, uint8_
 		},
 	};
 
-	bus_start_transaction(act8945a->bus);
+	err = bus_start_transaction(act8945a->bus);
+	if (err < 0)
+		return false;
 	err = bus_transfer(act8945a->bus, act8945a->addr, buf, 2, NULL);
 	bus_stop_transaction(act8945a->bus);
 
@@ -302,7 +311,9 @@ static bool _act8945a_write_reg(struct _act8945a* act8945a, uint8_t iaddr, uint8
 		}
 	};
 
-	bus_start_transaction(act8945a->bus);
+	err = bus_start_transaction(act8945a->bus);
+	if (err < 0)
+		return false;
 	err = bus_transfer(act8945a->bus, act8945a->addr, buf, 1, NULL);
 	bus_stop_transaction(act8945a->bus);
 
@@ -607,8 +618,7 @@ bool act8945a_set_regulator_voltage(struct _act8945a *act8945a,
 		vout = 3900;
 	}
 
-	// can only set voltage for regulators 4 to 7
-	if (reg < 4 || reg > 7) {
+	if (reg < 1 || reg > 7) {
 		trace_error("Cannot change voltage of regulator %d\r\n", reg);
 		return false;
 	};
@@ -622,7 +632,10 @@ bool act8945a_set_regulator_voltage(struct _act8945a *act8945a,
 		value = 0x30 + (vout - 2400) / 100;
 	}
 
+	// DC/DC regulators 1 to 3 output the VSETx register selected by VSEL
 	uint32_t iaddr = _iaddr_reg[reg - 1];
+	if (iaddr < IADDR_REG4 && STATE_VSEL == 1)
+		iaddr++;
 	return _act8945a_write_reg(act8945a, iaddr, value & 0x3f);
 }
 
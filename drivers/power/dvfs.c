@@ -0,0 +1,514 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "chip.h"
+#include "compiler.h"
+#include "cpuidle.h"
+#ifdef MPDDRC
+#include "extram/mpddrc.h"
+#endif
+#include "irqflags.h"
+#include "peripherals/pmc.h"
+#include "power/dvfs.h"
+#include "timer.h"
+#include "trace.h"
+
+/*----------------------------------------------------------------------------
+ *         Local constants
+ *----------------------------------------------------------------------------*/
+
+/* Default operating points: the first entry matches the clocks set by
+ * board_cfg_clocks(), the PLLA is never reprogrammed. */
+
+#if defined(CONFIG_SOC_SAMA5D2)
+static const struct _dvfs_opp _dvfs_default_opps[] = {
+	/* PCK 498MHz, MCK 166MHz */
+	{ .pck_pres = PMC_MCKR_PRES_CLOCK, .mck_div = PMC_MCKR_MDIV_PCK_DIV3,
+	  .vddcore = 1200 },
+	/* PCK 249MHz, MCK 124.5MHz */
+	{ .pck_pres = PMC_MCKR_PRES_CLOCK_DIV2, .mck_div = PMC_MCKR_MDIV_PCK_DIV2,
+	  .vddcore = 1150 },
+	/* PCK 124.5MHz, MCK 124.5MHz */
+	{ .pck_pres = PMC_MCKR_PRES_CLOCK_DIV4, .mck_div = PMC_MCKR_MDIV_EQ_PCK,
+	  .vddcore = 1100 },
+};
+#elif defined(CONFIG_SOC_SAMA5D3)
+static const struct _dvfs_opp _dvfs_default_opps[] = {
+	/* PCK 528MHz, MCK 132MHz */
+	{ .pck_pres = PMC_MCKR_PRES_CLOCK, .mck_div = PMC_MCKR_MDIV_PCK_DIV4,
+	  .vddcore = 1200 },
+	/* PCK 264MHz, MCK 132MHz */
+	{ .pck_pres = PMC_MCKR_PRES_CLOCK_DIV2, .mck_div = PMC_MCKR_MDIV_PCK_DIV2,
+	  .vddcore = 1150 },
+	/* PCK 132MHz, MCK 132MHz */
+	{ .pck_pres = PMC_MCKR_PRES_CLOCK_DIV4, .mck_div = PMC_MCKR_MDIV_EQ_PCK,
+	  .vddcore = 1100 },
+};
+#elif defined(CONFIG_SOC_SAMA5D4)
+/* VDDCORE is left at its boot value, tables given to dvfs_initialize()
+ * may still scale it through board_set_vddcore() */
+static const struct _dvfs_opp _dvfs_default_opps[] = {
+	/* PCK 600MHz, MCK 200MHz */
+	{ .pck_pres = PMC_MCKR_PRES_CLOCK, .mck_div = PMC_MCKR_MDIV_PCK_DIV3 },
+	/* PCK 300MHz, MCK 150MHz */
+	{ .pck_pres = PMC_MCKR_PRES_CLOCK_DIV2, .mck_div = PMC_MCKR_MDIV_PCK_DIV2 },
+	/* PCK 150MHz, MCK 150MHz */
+	{ .pck_pres = PMC_MCKR_PRES_CLOCK_DIV4, .mck_div = PMC_MCKR_MDIV_EQ_PCK },
+};
+#elif defined(CONFIG_SOC_SAMV71)
+static const struct _dvfs_opp _dvfs_default_opps[] = {
+	/* PCK 300MHz, MCK 150MHz */
+	{ .pck_pres = PMC_MCKR_PRES_CLOCK_DIV2, .mck_div = PMC_MCKR_MDIV_PCK_DIV2 },
+	/* PCK 150MHz, MCK 150MHz */
+	{ .pck_pres = PMC_MCKR_PRES_CLOCK_DIV4, .mck_div = PMC_MCKR_MDIV_EQ_PCK },
+	/* PCK 75MHz, MCK 75MHz */
+	{ .pck_pres = PMC_MCKR_PRES_CLOCK_DIV8, .mck_div = PMC_MCKR_MDIV_EQ_PCK },
+};
+#elif defined(CONFIG_SOC_SAM9XX5)
+static const struct _dvfs_opp _dvfs_default_opps[] = {
+	/* PCK 400MHz, MCK 133MHz */
+	{ .pck_pres = PMC_MCKR_PRES_CLOCK, .mck_div = PMC_MCKR_MDIV_PCK_DIV3 },
+	/* PCK 200MHz, MCK 100MHz */
+	{ .pck_pres = PMC_MCKR_PRES_CLOCK_DIV2, .mck_div = PMC_MCKR_MDIV_PCK_DIV2 },
+	/* PCK 100MHz, MCK 100MHz */
+	{ .pck_pres = PMC_MCKR_PRES_CLOCK_DIV4, .mck_div = PMC_MCKR_MDIV_EQ_PCK },
+};
+#else
+#define DVFS_NO_DEFAULT_OPPS
+#endif
+
+/*----------------------------------------------------------------------------
+ *         Local variables
+ *----------------------------------------------------------------------------*/
+
+static struct {
+	const struct _dvfs_opp* opps;
+	uint32_t count;
+	uint32_t current;               /* count if the clocks match no OPP */
+	uint32_t pck[DVFS_MAX_OPPS];
+	bool (*set_vddcore)(uint16_t mv);
+
+#ifdef MPDDRC
+	/* DDR initialized at boot and the master clock of its timings */
+	bool ddr;
+	uint32_t ddr_mck;
+#endif
+
+	bool governor;
+	struct _dvfs_governor_cfg cfg;
+	uint64_t window_start;
+	uint64_t idle;
+
+	struct _dvfs_hint* hints;
+	volatile bool hints_changed;
+
+	struct _dvfs_stats stats;
+	uint64_t since;
+} _dvfs;
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint32_t _dvfs_pres_div(uint32_t pres)
+{
+#ifdef PMC_MCKR_PRES_CLOCK_DIV3
+	if ((pres & PMC_MCKR_PRES_Msk) == PMC_MCKR_PRES_CLOCK_DIV3)
+		return 3;
+#endif
+	return 1u << ((pres & PMC_MCKR_PRES_Msk) >> PMC_MCKR_PRES_Pos);
+}
+
+static uint32_t _dvfs_compute_pck(const struct _dvfs_opp* opp)
+{
+	uint32_t clk;
+
+	if (opp->plla.mul > 0 && opp->plla.div > 0) {
+		clk = pmc_get_main_clock() / opp->plla.div * (opp->plla.mul + 1);
+#ifdef CONFIG_HAVE_PMC_PLLADIV2
+		if (PMC->PMC_MCKR & PMC_MCKR_PLLADIV2)
+			clk >>= 1;
+#endif
+	} else {
+		clk = pmc_get_plla_clock();
+	}
+
+	return clk / _dvfs_pres_div(opp->pck_pres);
+}
+
+static bool _dvfs_opp_is_current(const struct _dvfs_opp* opp)
+{
+	uint32_t mckr = PMC->PMC_MCKR;
+	uint32_t pllar = PMC->CKGR_PLLAR;
+
+	if ((mckr & PMC_MCKR_CSS_Msk) != PMC_MCKR_CSS_PLLA_CLK)
+		return false;
+	if ((mckr & PMC_MCKR_PRES_Msk) != opp->pck_pres)
+		return false;
+	if ((mckr & PMC_MCKR_MDIV_Msk) != opp->mck_div)
+		return false;
+	if (opp->plla.mul > 0) {
+		if (((pllar & CKGR_PLLAR_MULA_Msk) >> CKGR_PLLAR_MULA_Pos) != opp->plla.mul)
+			return false;
+		if (((pllar & CKGR_PLLAR_DIVA_Msk) >> CKGR_PLLAR_DIVA_Pos) != opp->plla.div)
+			return false;
+	}
+	return true;
+}
+
+/**
+ * \brief Put the DDR in self-refresh before the master clock changes.
+ *
+ * The DDR timings and the DLL of DDR2/DDR3 devices are only valid at the
+ * master clock set at boot, the DDR is not clocked within specification
+ * while running from the main clock or at a lower master clock.
+ */
+static void _dvfs_ddr_suspend(void)
+{
+#ifdef MPDDRC
+	if (!_dvfs.ddr)
+		return;
+
+	mpddrc_issue_low_power_command(MPDDRC_LPR_LPCB_SELFREFRESH);
+#ifdef MPDDRC_LPR_SELF_DONE
+	while (!(MPDDRC->MPDDRC_LPR & MPDDRC_LPR_SELF_DONE));
+#endif
+#endif
+}
+
+/**
+ * \brief Leave self-refresh if the master clock is back to its boot value,
+ * otherwise the DDR stays in self-refresh and must not be accessed.
+ */
+static void _dvfs_ddr_resume(void)
+{
+#ifdef MPDDRC
+	if (_dvfs.ddr && pmc_get_master_clock() == _dvfs.ddr_mck)
+		mpddrc_issue_low_power_command(MPDDRC_LPR_LPCB_DISABLED);
+#endif
+}
+
+/**
+ * \brief Program the clocks of an OPP, must be called with interrupts
+ * disabled, from code and stack outside of the DDR.
+ *
+ * MDIV and PLLA changes are made while running from the main clock, as
+ * done by pmc_set_custom_pck_mck(). A prescaler change alone is applied on
+ * the fly.
+ */
+static void _dvfs_switch_clocks(const struct _dvfs_opp* opp, bool full)
+{
+	_dvfs_ddr_suspend();
+
+	if (!full) {
+		pmc_set_mck_prescaler(opp->pck_pres);
+		_dvfs_ddr_resume();
+		return;
+	}
+
+	pmc_switch_mck_to_main();
+
+	if (opp->plla.mul > 0 && opp->plla.div > 0) {
+		pmc_disable_plla();
+		pmc_configure_plla(&opp->plla);
+	}
+
+	pmc_set_mck_prescaler(opp->pck_pres);
+	pmc_set_mck_divider(opp->mck_div);
+
+	pmc_switch_mck_to_pll();
+	_dvfs_ddr_resume();
+}
+
+/**
+ * \brief Get the slowest OPP satisfying all hints
+ */
+static uint32_t _dvfs_hint_floor(void)
+{
+	struct _dvfs_hint* hint;
+	uint32_t min_pck = 0;
+	uint32_t flags, i;
+
+	flags = arch_irq_save();
+	for (hint = _dvfs.hints; hint; hint = hint->next)
+		if (hint->min_pck > min_pck)
+			min_pck = hint->min_pck;
+	arch_irq_restore(flags);
+
+	for (i = _dvfs.count - 1; i > 0; i--)
+		if (_dvfs.pck[i] >= min_pck)
+			break;
+	return i;
+}
+
+/*----------------------------------------------------------------------------
+ *         Exported functions
+ *----------------------------------------------------------------------------*/
+
+const struct _dvfs_opp* dvfs_get_default_opps(uint32_t* count)
+{
+#ifdef DVFS_NO_DEFAULT_OPPS
+	*count = 0;
+	return NULL;
+#else
+	*count = ARRAY_SIZE(_dvfs_default_opps);
+	return _dvfs_default_opps;
+#endif
+}
+
+int dvfs_initialize(const struct _dvfs_opp* opps, uint32_t count,
+		bool (*set_vddcore)(uint16_t mv))
+{
+	uint32_t i;
+
+	if (!opps || count == 0 || count > DVFS_MAX_OPPS)
+		return -EINVAL;
+
+#if defined(MPDDRC) && defined(VARIANT_DDRAM)
+	/* the DDR goes through self-refresh on each transition */
+	trace_error("dvfs: cannot change the clocks while running from DDR\r\n");
+	return -ENOTSUP;
+#endif
+
+	memset(&_dvfs, 0, sizeof(_dvfs));
+	_dvfs.opps = opps;
+	_dvfs.count = count;
+	_dvfs.set_vddcore = set_vddcore;
+	for (i = 0; i < count; i++)
+		_dvfs.pck[i] = _dvfs_compute_pck(&opps[i]);
+
+#ifdef MPDDRC
+	_dvfs.ddr = pmc_is_peripheral_enabled(ID_MPDDRC);
+	_dvfs.ddr_mck = pmc_get_master_clock();
+#endif
+
+	_dvfs.current = count;
+	for (i = 0; i < count; i++) {
+		if (_dvfs_opp_is_current(&opps[i])) {
+			_dvfs.current = i;
+			break;
+		}
+	}
+
+	_dvfs.since = timer_get_us();
+	if (_dvfs.current == count)
+		return dvfs_set_opp(0);
+
+	return 0;
+}
+
+int dvfs_set_opp(uint32_t index)
+{
+	const struct _dvfs_opp* opp;
+	const struct _dvfs_opp* cur = NULL;
+	bool full;
+	uint32_t flags;
+	uint64_t now;
+
+	if (index >= _dvfs.count)
+		return -EINVAL;
+	if (index == _dvfs.current)
+		return 0;
+
+	opp = &_dvfs.opps[index];
+	if (_dvfs.current < _dvfs.count)
+		cur = &_dvfs.opps[_dvfs.current];
+
+	full = !cur || opp->plla.mul > 0 || cur->plla.mul > 0 ||
+	       opp->mck_div != cur->mck_div;
+
+	/* Raise the voltage before speeding up */
+	if (_dvfs.set_vddcore && opp->vddcore &&
+	    (!cur || opp->vddcore > cur->vddcore)) {
+		if (!_dvfs.set_vddcore(opp->vddcore)) {
+			trace_error("dvfs: cannot set VDDCORE to %umV\r\n",
+			            (unsigned)opp->vddcore);
+			return -EIO;
+		}
+	}
+
+	now = timer_get_us();
+	if (cur)
+		_dvfs.stats.time[_dvfs.current] += now - _dvfs.since;
+
+	pmc_notify_mck_change(PMC_MCK_PRE_CHANGE);
+	flags = arch_irq_save();
+	_dvfs_switch_clocks(opp, full);
+	arch_irq_restore(flags);
+	pmc_notify_mck_change(PMC_MCK_POST_CHANGE);
+
+	_dvfs.since = timer_get_us();
+	_dvfs.current = index;
+	_dvfs.stats.transitions++;
+
+	/* Lower the voltage after slowing down */
+	if (_dvfs.set_vddcore && opp->vddcore && cur &&
+	    opp->vddcore < cur->vddcore) {
+		if (!_dvfs.set_vddcore(opp->vddcore))
+			trace_warning("dvfs: cannot set VDDCORE to %umV\r\n",
+			              (unsigned)opp->vddcore);
+	}
+
+	trace_debug("dvfs: OPP %u, PCK %uHz, MCK %uHz\r\n", (unsigned)index,
+	            (unsigned)pmc_get_processor_clock(),
+	            (unsigned)pmc_get_master_clock());
+
+	return 0;
+}
+
+uint32_t dvfs_get_opp(void)
+{
+	return _dvfs.current;
+}
+
+uint32_t dvfs_get_opp_pck(uint32_t index)
+{
+	if (index >= _dvfs.count)
+		return 0;
+	return _dvfs.pck[index];
+}
+
+void dvfs_governor_start(const struct _dvfs_governor_cfg* cfg)
+{
+	_dvfs.cfg = *cfg;
+	if (_dvfs.cfg.period == 0)
+		_dvfs.cfg.period = 1;
+	_dvfs.idle = 0;
+	_dvfs.window_start = timer_get_us();
+	_dvfs.governor = true;
+}
+
+void dvfs_governor_stop(void)
+{
+	_dvfs.governor = false;
+}
+
+void dvfs_add_hint(struct _dvfs_hint* hint)
+{
+	struct _dvfs_hint* cur;
+	uint32_t flags = arch_irq_save();
+
+	for (cur = _dvfs.hints; cur; cur = cur->next)
+		if (cur == hint)
+			break;
+	if (!cur) {
+		hint->next = _dvfs.hints;
+		_dvfs.hints = hint;
+	}
+	_dvfs.hints_changed = true;
+
+	arch_irq_restore(flags);
+}
+
+void dvfs_remove_hint(struct _dvfs_hint* hint)
+{
+	struct _dvfs_hint** cur;
+	uint32_t flags = arch_irq_save();
+
+	for (cur = &_dvfs.hints; *cur; cur = &(*cur)->next) {
+		if (*cur == hint) {
+			*cur = hint->next;
+			hint->next = NULL;
+			break;
+		}
+	}
+	_dvfs.hints_changed = true;
+
+	arch_irq_restore(flags);
+}
+
+void dvfs_idle(void)
+{
+	uint64_t start;
+
+	if (!_dvfs.governor) {
+		cpu_idle();
+		return;
+	}
+
+	start = timer_get_us();
+	cpu_idle();
+	_dvfs.idle += timer_get_us() - start;
+}
+
+void dvfs_update(void)
+{
+	uint64_t now, elapsed, idle;
+	uint32_t load, target, floor;
+
+	if (!_dvfs.governor)
+		return;
+
+	target = _dvfs.current < _dvfs.count ? _dvfs.current : 0;
+
+	now = timer_get_us();
+	elapsed = now - _dvfs.window_start;
+	if (elapsed >= _dvfs.cfg.period) {
+		idle = _dvfs.idle < elapsed ? _dvfs.idle : elapsed;
+		load = 100 - (uint32_t)((idle * 100) / elapsed);
+
+		if (load >= _dvfs.cfg.up_threshold)
+			target = 0;
+		else if (load < _dvfs.cfg.down_threshold && target + 1 < _dvfs.count)
+			target++;
+
+		_dvfs.window_start = now;
+		_dvfs.idle = 0;
+	} else if (!_dvfs.hints_changed) {
+		return;
+	}
+
+	_dvfs.hints_changed = false;
+	floor = _dvfs_hint_floor();
+	if (target > floor)
+		target = floor;
+
+	if (target != _dvfs.current && dvfs_set_opp(target) == 0) {
+		/* start a new window at the new speed */
+		_dvfs.window_start = timer_get_us();
+		_dvfs.idle = 0;
+	}
+}
+
+void dvfs_get_stats(struct _dvfs_stats* stats)
+{
+	uint64_t now = timer_get_us();
+
+	*stats = _dvfs.stats;
+	if (_dvfs.current < _dvfs.count)
+		stats->time[_dvfs.current] += now - _dvfs.since;
+}
@@ -0,0 +1,199 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Dynamic voltage and frequency scaling.
+ *
+ * An operating point (OPP) is a PLLA setting, a processor clock prescaler,
+ * a master clock divider and a VDDCORE voltage.  Tables are ordered from the
+ * fastest to the slowest point; index 0 is the full speed point.  Default
+ * tables are provided for each SoC (see dvfs_get_default_opps()); they keep
+ * the boot PLLA and never run faster than the clocks set by the board, so
+ * that flash wait states programmed at boot stay valid.
+ *
+ * The DDR timings are only valid at the boot master clock: the DDR is put in
+ * self-refresh on each transition and only leaves it at the operating points
+ * running at the boot master clock.  DVFS is therefore not available to
+ * programs running from DDR (ddram variant), and the DDR must not be
+ * accessed, by the core or by DMA, at the other operating points.
+ *
+ * dvfs_set_opp() raises VDDCORE before speeding up and lowers it after
+ * slowing down.  Drivers registered with pmc_register_mck_notifier() are
+ * called before and after the master clock changes.
+ *
+ * The governor samples the CPU load over fixed windows: the time spent in
+ * dvfs_idle() is idle time, everything else is busy time.  A busy window
+ * selects the fastest point at once, an idle window steps one point down.
+ * Drivers can request a minimum processor clock with hints, for instance
+ * while a stream is running.  dvfs_update() must be called regularly from
+ * thread context; the scheduler does it when CONFIG_DVFS is set.
+ */
+
+#ifndef _DVFS_H_
+#define _DVFS_H_
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "peripherals/pmc.h"
+
+/*----------------------------------------------------------------------------
+ *         Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Maximum number of operating points in a table */
+#define DVFS_MAX_OPPS 8
+
+/*----------------------------------------------------------------------------
+ *         Types
+ *----------------------------------------------------------------------------*/
+
+struct _dvfs_opp {
+	/** Master/Processor Clock Prescaler (PMC_MCKR_PRES_xxx) */
+	uint32_t pck_pres;
+
+	/** Master Clock Division after Prescaler divider (PMC_MCKR_MDIV_xxx) */
+	uint32_t mck_div;
+
+	/** PLLA configuration, the current PLLA is kept if mul is 0 */
+	struct _pmc_plla_cfg plla;
+
+	/** VDDCORE voltage in mV, the voltage is not changed if 0 */
+	uint16_t vddcore;
+};
+
+struct _dvfs_governor_cfg {
+	uint32_t period;        /**< load sampling window (us) */
+	uint8_t up_threshold;   /**< load (%) selecting the fastest point */
+	uint8_t down_threshold; /**< load (%) under which to step down */
+};
+
+struct _dvfs_hint {
+	uint32_t min_pck;       /**< minimum processor clock (Hz) */
+	struct _dvfs_hint* next;
+};
+
+struct _dvfs_stats {
+	uint32_t transitions;               /**< number of OPP changes */
+	uint64_t time[DVFS_MAX_OPPS];       /**< time spent at each OPP (us) */
+};
+
+/*----------------------------------------------------------------------------
+ *         Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Get the default operating points of the SoC
+ * \param count  Filled with the number of operating points
+ * \return the OPP table, or NULL if the SoC has none
+ */
+extern const struct _dvfs_opp* dvfs_get_default_opps(uint32_t* count);
+
+/**
+ * \brief Initialize DVFS with an OPP table.
+ *
+ * The table must outlive the DVFS module. If the current clocks match
+ * an operating point, it becomes the current one, otherwise the fastest
+ * point is applied.
+ *
+ * \param opps  OPP table, ordered from the fastest to the slowest point
+ * \param count  number of operating points (at most DVFS_MAX_OPPS)
+ * \param set_vddcore  function setting VDDCORE (in mV), may be NULL
+ * \return 0 on success, -ENOTSUP when running from DDR, a negative error
+ * code otherwise
+ */
+extern int dvfs_initialize(const struct _dvfs_opp* opps, uint32_t count,
+		bool (*set_vddcore)(uint16_t mv));
+
+/**
+ * \brief Switch to an operating point.
+ *
+ * Must be called from thread context with interrupts enabled.
+ *
+ * \param index  index of the operating point in the table
+ * \return 0 on success, a negative error code otherwise
+ */
+extern int dvfs_set_opp(uint32_t index);
+
+/**
+ * \brief Get the index of the current operating point
+ */
+extern uint32_t dvfs_get_opp(void);
+
+/**
+ * \brief Get the processor clock of an operating point (in Hz)
+ */
+extern uint32_t dvfs_get_opp_pck(uint32_t index);
+
+/**
+ * \brief Start the load based governor
+ */
+extern void dvfs_governor_start(const struct _dvfs_governor_cfg* cfg);
+
+/**
+ * \brief Stop the governor, the current operating point is kept
+ */
+extern void dvfs_governor_stop(void);
+
+/**
+ * \brief Request a minimum processor clock until the hint is removed.
+ *
+ * May be called from interrupt context, the point is raised by the next
+ * dvfs_update().
+ */
+extern void dvfs_add_hint(struct _dvfs_hint* hint);
+
+/**
+ * \brief Remove a hint added with dvfs_add_hint()
+ */
+extern void dvfs_remove_hint(struct _dvfs_hint* hint);
+
+/**
+ * \brief Wait for an interrupt, accounting the time spent as idle time
+ */
+extern void dvfs_idle(void);
+
+/**
+ * \brief Run the governor: apply hints and, at the end of each sampling
+ * window, select the operating point from the measured load.
+ */
+extern void dvfs_update(void);
+
+/**
+ * \brief Get the transition count and the time spent at each point
+ */
+extern void dvfs_get_stats(struct _dvfs_stats* stats);
+
+#endif /* _DVFS_H_ */
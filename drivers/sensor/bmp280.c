@@ -66,7 +66,7 @@ static int _bmp280_read(struct _bmp280* bmp280, uint8_t iaddr, uint8_t* buffer,
 		{
 			.data = &iaddr,
 			.size = 1,
-			.attr = BUS_I2C_BUF_ATTR_START | BUS_BUF_ATTR_TX | BUS_I2C_BUF_ATTR_STOP,
+			.attr = BUS_I2C_BUF_ATTR_START | BUS_BUF_ATTR_TX,
 		},
 		{
 			.data = buffer,
@@ -73,12 +73,25 @@ void dbgu_configure(Dbgu* dbgu, uint32_t mode, uint32_t baudrate)
 	dbgu->DBGU_MR = mode;
 
 	/* Configure baudrate */
-	dbgu->DBGU_BRGR = ROUND_INT_DIV(pmc_get_peripheral_clock(ID_DBGU) / 16, baudrate);
+	dbgu_set_baudrate(dbgu, baudrate);
 
 	/* Enable receiver and transmitter */
 	dbgu->DBGU_CR = DBGU_CR_RXEN | DBGU_CR_TXEN;
 }
 
+/**
+ * \brief Configures the DBGU baudrate from the current peripheral clock.
+ *
+ * \param dbgu  Pointer to the DBGU peripheral
+ * \param baudrate  Baudrate at which the DBGU should operate (in Hz).
+ */
+void dbgu_set_baudrate(Dbgu* dbgu, uint32_t baudrate)
+{
+	assert(dbgu == DBGU);
+
+	dbgu->DBGU_BRGR = ROUND_INT_DIV(pmc_get_peripheral_clock(ID_DBGU) / 16, baudrate);
+}
+
 /**
  * \brief Outputs a character on the DBGU line.
  *
@@ -64,6 +64,7 @@
  *----------------------------------------------------------------------------*/
 
 typedef void (*init_handler_t)(void*, uint32_t, uint32_t);
+typedef void (*set_baudrate_handler_t)(void*, uint32_t);
 typedef void (*put_char_handler_t)(void*, uint8_t);
 typedef bool (*tx_empty_handler_t)(void*);
 typedef uint8_t (*get_char_handler_t)(void*);
@@ -75,6 +76,7 @@ struct _seriald_ops {
 	uint32_t             mode;
 	uint32_t             rx_int_mask;
 	init_handler_t       init;
+	set_baudrate_handler_t set_baudrate;
 	put_char_handler_t   put_char;
 	tx_empty_handler_t   tx_empty;
 	get_char_handler_t   get_char;
@@ -92,6 +94,7 @@ static const struct _seriald_ops seriald_ops_usart = {
 	.mode = US_MR_CHMODE_NORMAL | US_MR_PAR_NO | US_MR_CHRL_8_BIT,
 	.rx_int_mask = US_IER_RXRDY,
 	.init = (init_handler_t)usart_configure,
+	.set_baudrate = (set_baudrate_handler_t)usart_set_baudrate,
 	.put_char = (put_char_handler_t)usart_put_char,
 	.tx_empty = (tx_empty_handler_t)usart_is_tx_empty,
 	.get_char = (get_char_handler_t)usart_get_char,
@@ -106,6 +109,7 @@ static const struct _seriald_ops seriald_ops_uart = {
 	.mode = UART_MR_CHMODE_NORMAL | UART_MR_PAR_NO,
 	.rx_int_mask = UART_IER_RXRDY,
 	.init = (init_handler_t)uart_configure,
+	.set_baudrate = (set_baudrate_handler_t)uart_set_baudrate,
 	.put_char = (put_char_handler_t)uart_put_char,
 	.tx_empty = (tx_empty_handler_t)uart_is_tx_empty,
 	.get_char = (get_char_handler_t)uart_get_char,
@@ -120,6 +124,7 @@ static const struct _seriald_ops seriald_ops_dbgu = {
 	.mode = DBGU_MR_CHMODE_NORM | DBGU_MR_PAR_NONE,
 	.rx_int_mask = DBGU_IER_RXRDY,
 	.init = (init_handler_t)dbgu_configure,
+	.set_baudrate = (set_baudrate_handler_t)dbgu_set_baudrate,
 	.put_char = (put_char_handler_t)dbgu_put_char,
 	.tx_empty = (tx_empty_handler_t)dbgu_is_tx_empty,
 	.get_char = (get_char_handler_t)dbgu_get_char,
@@ -146,6 +151,21 @@ static void seriald_handler(uint32_t source, void* user_arg)
 		serial->rx_handler(c);
 }
 
+static int seriald_mck_notify(void* arg, void* arg2)
+{
+	struct _seriald* serial = (struct _seriald*)arg;
+	enum _pmc_mck_event event = (enum _pmc_mck_event)arg2;
+
+	if (event == PMC_MCK_PRE_CHANGE) {
+		/* Let the character being sent leave at the current rate */
+		while (!serial->ops->tx_empty(serial->addr));
+	} else {
+		serial->ops->set_baudrate(serial->addr, serial->baudrate);
+	}
+
+	return 0;
+}
+
 /*------------------------------------------------------------------------------
  *         Exported functions
  *------------------------------------------------------------------------------*/
@@ -187,16 +207,24 @@ int seriald_configure(struct _seriald* serial, void* addr, uint32_t baudrate)
 	if (!ops)
 		return -ENODEV;
 
+	/* The structure may be reconfigured: unhook it before clearing it */
+	pmc_unregister_mck_notifier(&serial->mck_notifier);
+
 	/* Save serial peripheral address and ID */
 	memset(serial, 0, sizeof(*serial));
 	serial->id = id;
 	serial->addr = addr;
 	serial->ops = ops;
+	serial->baudrate = baudrate;
 
 	/* Initialize driver to use */
 	pmc_configure_peripheral(id, NULL, true);
 	ops->init(addr, ops->mode, baudrate);
 
+	/* Follow master clock changes */
+	callback_set(&serial->mck_notifier.callback, seriald_mck_notify, serial);
+	pmc_register_mck_notifier(&serial->mck_notifier);
+
 	return 0;
 }
 
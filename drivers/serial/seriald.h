@@ -38,6 +38,8 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "peripherals/pmc.h"
+
 /*----------------------------------------------------------------------------
  *        Global Types
  *----------------------------------------------------------------------------*/
@@ -54,6 +56,8 @@ struct _seriald {
 	void *addr; /* peripheral address */
 	seriald_rx_handler_t rx_handler; /* rx callback */
 	const struct _seriald_ops* ops; /* low-level operations */
+	uint32_t baudrate; /* configured baudrate */
+	struct _pmc_mck_notifier mck_notifier; /* master clock change hook */
 };
 
 /* ----------------------------------------------------------------------------
@@ -52,15 +52,13 @@
  */
 void uart_configure(Uart* uart, uint32_t mode, uint32_t baudrate)
 {
-	uint32_t uart_id = get_uart_id_from_addr(uart);
-
 	/* Reset & disable receiver and transmitter, disable interrupts */
 	uart->UART_CR = UART_CR_RSTRX | UART_CR_RSTTX |
 	                UART_CR_RXDIS | UART_CR_TXDIS | UART_CR_RSTSTA;
 	uart->UART_IDR = 0xffffffffu;
 
 	/* Configure baud rate */
-	uart->UART_BRGR = pmc_get_peripheral_clock(uart_id) / (baudrate * 16);
+	uart_set_baudrate(uart, baudrate);
 
 	/* Configure mode register */
 	uart->UART_MR = mode;
@@ -69,6 +67,16 @@ void uart_configure(Uart* uart, uint32_t mode, uint32_t baudrate)
 	uart->UART_CR = UART_CR_RXEN | UART_CR_TXEN;
 }
 
+/* Configure baud rate from the current peripheral clock
+ *
+ */
+void uart_set_baudrate(Uart* uart, uint32_t baudrate)
+{
+	uint32_t uart_id = get_uart_id_from_addr(uart);
+
+	uart->UART_BRGR = pmc_get_peripheral_clock(uart_id) / (baudrate * 16);
+}
+
 /* Enable transmitter
  *
  */
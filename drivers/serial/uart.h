@@ -54,6 +54,7 @@
 /*------------------------------------------------------------------------------*/
 
 extern void uart_configure(Uart* uart, uint32_t mode, uint32_t baudrate);
+extern void uart_set_baudrate(Uart* uart, uint32_t baudrate);
 extern void uart_set_transmitter_enabled(Uart* uart, bool enabled);
 extern void uart_set_receiver_enabled (Uart* uart, bool enabled);
 extern void uart_enable_it(Uart* uart, uint32_t mask);
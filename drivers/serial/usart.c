@@ -107,7 +107,6 @@ void usart_reset_status(Usart *usart)
 
 void usart_configure(Usart *usart, uint32_t mode, uint32_t baudrate)
 {
-	uint32_t clock = pmc_get_peripheral_clock(get_usart_id_from_addr(usart));
 	/* Reset and disable receiver & transmitter */
 	uint32_t control = US_CR_RSTRX | US_CR_RSTTX | US_CR_RXDIS | US_CR_TXDIS;
 	/* apply */
@@ -116,9 +115,7 @@ void usart_configure(Usart *usart, uint32_t mode, uint32_t baudrate)
 	usart->US_MR = mode;
 
 	/* Configure baudrate */
-	/* Asynchronous, no oversampling */
-	if (((mode & US_MR_SYNC) == 0) && ((mode & US_MR_OVER) == 0))
-		usart->US_BRGR = (clock / baudrate) / 16;
+	usart_set_baudrate(usart, baudrate);
 
 	/* Disable all interrupts */
 	usart->US_IDR = 0xFFFFFFFF;
@@ -126,6 +123,16 @@ void usart_configure(Usart *usart, uint32_t mode, uint32_t baudrate)
 	usart->US_CR = US_CR_RXEN | US_CR_TXEN;
 }
 
+void usart_set_baudrate(Usart *usart, uint32_t baudrate)
+{
+	uint32_t clock = pmc_get_peripheral_clock(get_usart_id_from_addr(usart));
+	uint32_t mode = usart->US_MR;
+
+	/* Asynchronous, no oversampling */
+	if (((mode & US_MR_SYNC) == 0) && ((mode & US_MR_OVER) == 0))
+		usart->US_BRGR = (clock / baudrate) / 16;
+}
+
 uint32_t usart_get_status(Usart *usart)
 {
 	return usart->US_CSR;
@@ -102,6 +102,14 @@ extern void usart_reset_status(Usart *usart);
  */
 extern void usart_configure(Usart *usart, uint32_t mode, uint32_t baudrate);
 
+/**
+ * \brief Recompute the baudrate divider from the current peripheral clock,
+ * for the asynchronous mode without oversampling set by usart_configure().
+ *  \param usart  Pointer to the USART peripheral.
+ *  \param baudrate  Baudrate at which the USART should operate (in Hz).
+ */
+extern void usart_set_baudrate(Usart *usart, uint32_t baudrate);
+
 /**
  * \brief   Get present status
  * \param usart  Pointer to an USART peripheral.
@@ -231,6 +231,23 @@ static void _usartd_handler(uint32_t source, void* user_arg)
 	}
 }
 
+static int _usartd_mck_notify(void* arg, void* arg2)
+{
+	struct _usart_desc* desc = (struct _usart_desc*)arg;
+	enum _pmc_mck_event event = (enum _pmc_mck_event)arg2;
+
+	if (event == PMC_MCK_PRE_CHANGE) {
+		/* Hold the transmitter until the baudrate is updated */
+		while (!mutex_try_lock(&desc->tx.mutex));
+		while (!usart_is_tx_empty(desc->addr));
+	} else {
+		usart_set_baudrate(desc->addr, desc->baudrate);
+		mutex_unlock(&desc->tx.mutex);
+	}
+
+	return 0;
+}
+
 void usartd_configure(uint8_t iface, struct _usart_desc* config)
 {
 	uint32_t id = get_usart_id_from_addr(config->addr);
@@ -278,6 +295,9 @@ void usartd_configure(uint8_t iface, struct _usart_desc* config)
 
 	config->dma.tx.channel = dma_allocate_channel(DMA_PERIPH_MEMORY, id);
 	assert(config->dma.tx.channel);
+
+	callback_set(&config->mck_notifier.callback, _usartd_mck_notify, config);
+	pmc_register_mck_notifier(&config->mck_notifier);
 }
 
 uint32_t usartd_transfer(uint8_t iface, struct _buffer* buf, struct _callback* cb)
@@ -40,6 +40,7 @@
 #include "dma/dma.h"
 #include "io.h"
 #include "mutex.h"
+#include "peripherals/pmc.h"
 #include "serial/usart.h"
 
 /*----------------------------------------------------------------------------
@@ -102,6 +103,8 @@ struct _usart_desc
 			struct _dma_cfg cfg_dma;
 		} tx;
 	} dma;
+
+	struct _pmc_mck_notifier mck_notifier;
 };
 
 enum _usartd_trans_mode
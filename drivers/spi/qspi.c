@@ -56,26 +56,63 @@
  *        LOCAL FUNCTIONS
  *----------------------------------------------------------------------------*/
 
+/* Wait for INSTRuction End */
+static int qspi_wait_instre(Qspi* qspi, uint32_t timeout)
+{
+	struct _timeout _to;
+
+	timer_start_timeout(&_to, timeout);
+	while (!(qspi->QSPI_SR & QSPI_SR_INSTRE)) {
+		if (timer_timeout_reached(&_to)) {
+			trace_debug("qspi_exec timeout reached\r\n");
+			return -ETIMEDOUT;
+		}
+	}
+	return 0;
+}
+
+#ifdef CONFIG_HAVE_QSPI_DMA
+static int qspi_dma_start(union spi_flash_priv* priv, uint8_t *dst, const uint8_t *src, int count, struct _callback *cb)
+{
+	struct _dma_transfer_cfg cfg;
+	struct _dma_cfg dma_cfg;
+	int rc;
+
+	/* Longest bursts: the QSPI memory area is read like any memory */
+	dma_prepare_memory_transfer(&dma_cfg, &cfg, dst, src, count,
+			DMA_CHUNK_SIZE_16);
+
+	rc = dma_configure_transfer(priv->qspi.dma_ch, &dma_cfg, &cfg, 1);
+	if (rc < 0)
+		return rc;
+	dma_set_callback(priv->qspi.dma_ch, cb);
+	return dma_start_transfer(priv->qspi.dma_ch);
+}
+
+/* End of a read started by qspi_exec() with a callback. */
+static int qspi_dma_read_callback(void* arg, void* arg2)
+{
+	union spi_flash_priv* priv = (union spi_flash_priv*)arg;
+	int rc;
+
+	dma_reset_channel(priv->qspi.dma_ch);
+	dsb();
+	cache_invalidate_region(priv->qspi.async.buf, priv->qspi.async.len);
+
+	priv->qspi.addr->QSPI_CR = QSPI_CR_LASTXFER;
+	rc = qspi_wait_instre(priv->qspi.addr, priv->qspi.async.timeout);
+
+	priv->qspi.async.busy = false;
+	callback_call(&priv->qspi.async.callback, (void*)rc);
+	return 0;
+}
+#endif
+
 static void * qspi_memcpy(union spi_flash_priv* priv, uint8_t *dst, const uint8_t *src, int count, bool use_dma)
 {
 #ifdef CONFIG_HAVE_QSPI_DMA
 	if (use_dma) {
-		uint32_t rc;
-		struct _dma_transfer_cfg cfg = {
-			.daddr = (void *)dst,
-			.saddr = (void *)src,
-			.len = count,
-		};
-		static struct _dma_cfg dma_cfg = {
-			.incr_saddr = true,
-			.incr_daddr = true,
-			.data_width = DMA_DATA_WIDTH_BYTE,
-			.chunk_size = DMA_CHUNK_SIZE_1,
-			.loop = false,
-		};
-		dma_configure_transfer(priv->qspi.dma_ch, &dma_cfg, &cfg, 1);
-		rc = dma_start_transfer(priv->qspi.dma_ch);
-		if (rc != 0)
+		if (qspi_dma_start(priv, dst, src, count, NULL) < 0)
 			trace_fatal("Couldn't start xDMA transfer\n\r");
 		while (!dma_is_transfer_done(priv->qspi.dma_ch))
 			dma_poll();
@@ -307,6 +344,12 @@ static int qspi_exec(union spi_flash_priv* priv, const struct spi_flash_command
 	iar = 0;
 	icr = 0;
 
+#ifdef CONFIG_HAVE_QSPI_DMA
+	/* Wait for the end of a background read. */
+	while (priv->qspi.async.busy)
+		dma_poll();
+#endif
+
 	/* Init ifr. */
 	if (qspi_init_ifr(cmd, &ifr))
 		return -1;
@@ -474,13 +517,13 @@ next:
 	(void)qspi->QSPI_IFR;
 
 #ifdef CONFIG_HAVE_QSPI_DMA
-	if (((cmd->flags == QSPI_IFR_TFRTYP_TRSFR_WRITE_MEMORY) &&
+	if (((cmd->flags & SFLASH_TYPE_MASK) == SFLASH_TYPE_WRITE &&
 	     IS_CACHE_ALIGNED(cmd->tx_data) &&
 	     IS_CACHE_ALIGNED(cmd->data_len)) ||
-	    ((cmd->flags == QSPI_IFR_TFRTYP_TRSFR_READ_MEMORY) &&
+	    ((cmd->flags & SFLASH_TYPE_MASK) == SFLASH_TYPE_READ &&
 	     IS_CACHE_ALIGNED(cmd->rx_data) &&
 	     IS_CACHE_ALIGNED(cmd->data_len)))
-		use_dma = true;
+		use_dma = !(cmd->flags & SFLASH_OPT_POLLING);
 #endif
 
 	/* Stop here for Continuous Read. */
@@ -507,6 +550,34 @@ next:
 #endif
 			ptr = priv->qspi.mem;
 
+#ifdef CONFIG_HAVE_QSPI_DMA
+		/* no dirty line may be evicted over the data written by the
+		 * DMA, nor any stale line hit while it runs */
+		if (use_dma) {
+			cache_clean_region(cmd->rx_data, cmd->data_len);
+			cache_invalidate_region(cmd->rx_data, cmd->data_len);
+		}
+
+		if (use_dma && cmd->callback) {
+			struct _callback _cb;
+			int rc;
+
+			priv->qspi.async.buf = cmd->rx_data;
+			priv->qspi.async.len = cmd->data_len;
+			priv->qspi.async.timeout = cmd->timeout;
+			callback_copy(&priv->qspi.async.callback, cmd->callback);
+			callback_set(&_cb, qspi_dma_read_callback, priv);
+
+			priv->qspi.async.busy = true;
+			rc = qspi_dma_start(priv, cmd->rx_data, ptr + offset, cmd->data_len, &_cb);
+			if (rc < 0) {
+				priv->qspi.async.busy = false;
+				qspi->QSPI_CR = QSPI_CR_LASTXFER;
+				return rc;
+			}
+			return -EINPROGRESS;
+		}
+#endif
 		qspi_memcpy(priv, cmd->rx_data, ptr + offset, cmd->data_len, use_dma);
 #ifdef CONFIG_HAVE_QSPI_DMA
 		if (use_dma)
@@ -521,17 +592,8 @@ next:
 	qspi->QSPI_CR = QSPI_CR_LASTXFER;
 
 no_data:
-	{
-		/* Wait for INSTRuction End */
-		struct _timeout timeout;
-		timer_start_timeout(&timeout, cmd->timeout);
-		while (!(qspi->QSPI_SR & QSPI_SR_INSTRE)) {
-			if (timer_timeout_reached(&timeout)) {
-				trace_debug("qspi_exec timeout reached\r\n");
-				return -ETIMEDOUT;
-			}
-		}
-	}
+	if (qspi_wait_instre(qspi, cmd->timeout) < 0)
+		return -ETIMEDOUT;
 
 #ifdef QSPI_VERBOSE_DEBUG
 	{
@@ -50,6 +50,13 @@ struct qspi_priv {
 #endif
 #ifdef CONFIG_HAVE_QSPI_DMA
 	struct _dma_channel *dma_ch;
+	struct {
+		void *buf;
+		size_t len;
+		uint32_t timeout;
+		struct _callback callback;
+		volatile bool busy;
+	} async; /* read in progress, see spi_flash_command.callback */
 #endif
 };
 
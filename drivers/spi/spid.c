@@ -39,6 +39,7 @@
 #include "callback.h"
 #include "dma/dma.h"
 #include "errno.h"
+#include "intmath.h"
 #include "irq/irq.h"
 #include "mm/cache.h"
 #include "peripherals/bus.h"
@@ -48,6 +49,7 @@
 #include "peripherals/pmc.h"
 #include "spi/spi.h"
 #include "spi/spid.h"
+#include "spi/spid_sg.h"
 #include "trace.h"
 
 /*----------------------------------------------------------------------------
@@ -56,12 +58,25 @@
 
 #define SPID_POLLING_THRESHOLD      16
 
+/** Chunk sizes of the DMA controller, bit n set for 2^n data */
+#ifdef CONFIG_HAVE_XDMAC
+#define SPID_DMA_CHUNKS             0x1f
+#else
+#define SPID_DMA_CHUNKS             0x1d
+#endif
+
 /*----------------------------------------------------------------------------
  *        Local variables
  *----------------------------------------------------------------------------*/
 
+/* Dummy data sent while receiving */
 CACHE_ALIGNED
-static uint32_t _garbage = UINT32_MAX;
+static const uint32_t _dummy = UINT32_MAX;
+
+/* Data received while only sending, kept apart from _dummy which would be
+ * overwritten with the last received byte */
+CACHE_ALIGNED
+static uint32_t _garbage;
 
 /*----------------------------------------------------------------------------
  *        Local functions
@@ -123,7 +138,7 @@ static void _spid_transfer_current_buffer_dma(struct _spi_desc* desc)
 		.len = desc->xfer.current->size,
 	};
 	struct _dma_transfer_cfg tx_cfg = {
-		.saddr = &_garbage,
+		.saddr = &_dummy,
 		.daddr = (void*)&desc->addr->SPI_TDR,
 		.len = desc->xfer.current->size,
 	};
@@ -172,6 +187,141 @@ static void _spid_transfer_current_buffer_dma(struct _spi_desc* desc)
 	dma_start_transfer(desc->xfer.dma.tx_channel);
 }
 
+static int _spid_dma_chain_callback(void* arg, void* arg2)
+{
+	struct _spi_desc* desc = (struct _spi_desc*)arg;
+	struct _buffer* buf;
+
+	for (buf = desc->xfer.current; buf <= desc->xfer.dma.last; buf++)
+		if (buf->attr & BUS_BUF_ATTR_RX)
+			cache_invalidate_region(buf->data, buf->size);
+
+	dma_reset_channel(desc->xfer.dma.rx_channel);
+
+	/* the whole chain is done, continue after its last buffer */
+	desc->xfer.current = desc->xfer.dma.last;
+	_spid_transfer_next_buffer(desc);
+
+	return 0;
+}
+
+static uint32_t _spid_dma_chunk_size(uint8_t chunk)
+{
+#ifdef CONFIG_HAVE_XDMAC
+	return chunk;
+#else
+	/* no chunk of 2 data on DMAC */
+	return chunk ? chunk - 1 : DMA_CHUNK_SIZE_1;
+#endif
+}
+
+static void _spid_dma_sg_item(const struct _spid_sg_item* item,
+		struct _dma_transfer_cfg* cfg, struct _dma_cfg* cfg_dma)
+{
+	cfg->len = item->len;
+	cfg_dma->data_width = item->width;
+	cfg_dma->chunk_size = _spid_dma_chunk_size(item->chunk);
+	cfg_dma->loop = false;
+}
+
+/**
+ * \brief Transfer the next buffers of the transaction as a single DMA
+ * transfer, up to the next chip select release.
+ * \return true if started, false if the current buffer has to be transferred
+ * alone
+ */
+static bool _spid_transfer_dma_chain(struct _spi_desc* desc)
+{
+	uint32_t id = get_spi_id_from_addr(desc->addr);
+	struct _spid_sg_caps caps = {
+		.max_items = CONFIG_SPID_DMA_SG_ITEMS,
+		.max_len = DMA_MAX_BT_SIZE,
+		.chunks = SPID_DMA_CHUNKS,
+		.max_burst = 1,
+		.rx_width = DMA_DATA_WIDTH_BYTE,
+		.tx_width = DMA_DATA_WIDTH_BYTE,
+	};
+	/* lists kept in the descriptor: this runs again from the DMA
+	 * completion interrupt, on the shared IRQ stack */
+	struct _spid_sg_item* tx = desc->xfer.dma.sg.tx;
+	struct _spid_sg_item* rx = desc->xfer.dma.sg.rx;
+	struct _dma_transfer_cfg* tx_cfg = desc->xfer.dma.sg.tx_cfg;
+	struct _dma_transfer_cfg* rx_cfg = desc->xfer.dma.sg.rx_cfg;
+	struct _dma_cfg* tx_cfg_dma = desc->xfer.dma.sg.tx_cfg_dma;
+	struct _dma_cfg* rx_cfg_dma = desc->xfer.dma.sg.rx_cfg_dma;
+	struct _dma_cfg cfg_dma = { .loop = false };
+	struct _spid_sg_plan plan;
+	struct _callback _cb;
+	uint32_t i;
+
+	/* inside a segment already found too short for DMA */
+	if (desc->xfer.dma.last && desc->xfer.current <= desc->xfer.dma.last)
+		return false;
+
+#ifdef CONFIG_HAVE_SPI_FIFO
+	if (desc->use_fifo) {
+		/* Bursts up to the FIFO thresholds, and up to four bytes in
+		 * each read of SPI_RDR (RD0 to RD3) */
+		caps.max_burst = min_u32(desc->fifo.tx.threshold, desc->fifo.rx.threshold);
+		caps.rx_width = DMA_DATA_WIDTH_WORD;
+	}
+#endif
+
+	spid_sg_compile(desc->xfer.current, desc->xfer.last - desc->xfer.current + 1,
+			&caps, tx, rx, &plan);
+	if (plan.items == 0)
+		return false;
+	if (plan.size < SPID_POLLING_THRESHOLD) {
+		desc->xfer.dma.last = desc->xfer.current + plan.buffers - 1;
+		return false;
+	}
+
+	for (i = 0; i < plan.items; i++) {
+		_spid_dma_sg_item(&tx[i], &tx_cfg[i], &tx_cfg_dma[i]);
+		tx_cfg[i].saddr = tx[i].data ? (const void*)tx[i].data : (const void*)&_dummy;
+		tx_cfg[i].daddr = (void*)&desc->addr->SPI_TDR;
+		tx_cfg_dma[i].incr_saddr = tx[i].data != NULL;
+		tx_cfg_dma[i].incr_daddr = false;
+		if (tx[i].data)
+			cache_clean_region(tx[i].data, tx[i].len << tx[i].width);
+
+		_spid_dma_sg_item(&rx[i], &rx_cfg[i], &rx_cfg_dma[i]);
+		rx_cfg[i].saddr = (void*)&desc->addr->SPI_RDR;
+		rx_cfg[i].daddr = rx[i].data ? rx[i].data : (void*)&_garbage;
+		rx_cfg_dma[i].incr_saddr = false;
+		rx_cfg_dma[i].incr_daddr = rx[i].data != NULL;
+	}
+
+	if (!desc->xfer.dma.tx_channel)
+		desc->xfer.dma.tx_channel = dma_allocate_channel(DMA_PERIPH_MEMORY, id);
+	if (!desc->xfer.dma.rx_channel)
+		desc->xfer.dma.rx_channel = dma_allocate_channel(id, DMA_PERIPH_MEMORY);
+
+	dma_reset_channel(desc->xfer.dma.tx_channel);
+	dma_reset_channel(desc->xfer.dma.rx_channel);
+	if (dma_configure_sg_transfer(desc->xfer.dma.tx_channel, &cfg_dma,
+			tx_cfg_dma, tx_cfg, plan.items) < 0)
+		return false;
+	if (dma_configure_sg_transfer(desc->xfer.dma.rx_channel, &cfg_dma,
+			rx_cfg_dma, rx_cfg, plan.items) < 0) {
+		/* not enough descriptors left, use the buffer by buffer path */
+		dma_reset_channel(desc->xfer.dma.tx_channel);
+		return false;
+	}
+
+	callback_set(&_cb, _spid_dma_tx_callback, (void*)desc);
+	dma_set_callback(desc->xfer.dma.tx_channel, &_cb);
+	callback_set(&_cb, _spid_dma_chain_callback, (void*)desc);
+	dma_set_callback(desc->xfer.dma.rx_channel, &_cb);
+
+	desc->xfer.dma.last = desc->xfer.current + plan.buffers - 1;
+
+	dma_start_transfer(desc->xfer.dma.rx_channel);
+	dma_start_transfer(desc->xfer.dma.tx_channel);
+
+	return true;
+}
+
 static void _spid_handler(uint32_t source, void* user_arg)
 {
 	uint8_t data;
@@ -270,6 +420,9 @@ static void _spid_transfer_current_buffer(struct _spi_desc* desc)
 {
 	enum _bus_transfer_mode tmode = (enum _bus_transfer_mode)desc->transfer_mode;
 
+	if (tmode == BUS_TRANSFER_MODE_DMA && _spid_transfer_dma_chain(desc))
+		return;
+
 	if (desc->xfer.current->size < SPID_POLLING_THRESHOLD)
 		tmode = BUS_TRANSFER_MODE_POLLING;
 
@@ -293,15 +446,20 @@ static void _spid_transfer_current_buffer(struct _spi_desc* desc)
 
 static void _spid_transfer_next_buffer(struct _spi_desc* desc)
 {
+	/* the chip select is asserted again by the next transfer */
+	if (desc->xfer.current->attr & BUS_SPI_BUF_ATTR_RELEASE_CS)
+		spi_release_cs(desc->addr);
+
 	if (desc->xfer.current < desc->xfer.last) {
 		desc->xfer.current++;
 
 		_spid_transfer_current_buffer(desc);
 	} else {
-		if (desc->xfer.current->attr & BUS_SPI_BUF_ATTR_RELEASE_CS)
-			spi_release_cs(desc->addr);
-
 		desc->xfer.current = NULL;
+#ifdef CONFIG_DVFS
+		if (desc->transfer_mode != BUS_TRANSFER_MODE_POLLING)
+			dvfs_remove_hint(&desc->dvfs_hint);
+#endif
 		mutex_unlock(&desc->mutex);
 		callback_call(&desc->xfer.callback, NULL);
 	}
@@ -334,8 +492,19 @@ int spid_transfer(struct _spi_desc* desc,
 
 	desc->xfer.current = buffers;
 	desc->xfer.last = &buffers[buffer_count - 1];
+	desc->xfer.dma.last = NULL;
 	callback_copy(&desc->xfer.callback, cb);
 
+#ifdef CONFIG_DVFS
+	/* The CPU mostly idles while an asynchronous transfer runs: keep the
+	 * current clocks until it completes rather than let the governor
+	 * slow down in the middle of a burst. */
+	if (desc->transfer_mode != BUS_TRANSFER_MODE_POLLING) {
+		desc->dvfs_hint.min_pck = pmc_get_processor_clock();
+		dvfs_add_hint(&desc->dvfs_hint);
+	}
+#endif
+
 	_spid_transfer_current_buffer(desc);
 
 	return 0;
@@ -354,6 +523,32 @@ void spid_wait_transfer(struct _spi_desc* desc)
 	}
 }
 
+static int _spid_mck_notify(void* arg, void* arg2)
+{
+	struct _spi_desc* desc = (struct _spi_desc*)arg;
+	enum _pmc_mck_event event = (enum _pmc_mck_event)arg2;
+	uint8_t cs;
+
+	if (event == PMC_MCK_PRE_CHANGE) {
+		/* Hold the bus until the dividers are updated */
+		while (!mutex_try_lock(&desc->mutex)) {
+			if (desc->transfer_mode == BUS_TRANSFER_MODE_DMA)
+				dma_poll();
+		}
+	} else {
+		for (cs = 0; cs < SPID_CS_COUNT; cs++) {
+			if (!desc->cs[cs].bitrate)
+				continue;
+			spi_configure_cs(desc->addr, cs, desc->cs[cs].bitrate,
+					desc->cs[cs].dlybs, desc->cs[cs].dlybct,
+					desc->addr->SPI_CSR[cs]);
+		}
+		mutex_unlock(&desc->mutex);
+	}
+
+	return 0;
+}
+
 int spid_configure(struct _spi_desc* desc)
 {
 	uint32_t id = get_spi_id_from_addr(desc->addr);
@@ -378,6 +573,10 @@ int spid_configure(struct _spi_desc* desc)
 
 	spi_enable(desc->addr);
 
+	memset(desc->cs, 0, sizeof(desc->cs));
+	callback_set(&desc->mck_notifier.callback, _spid_mck_notify, desc);
+	pmc_register_mck_notifier(&desc->mck_notifier);
+
 	return 0;
 }
 
@@ -402,11 +601,19 @@ void spid_configure_cs(struct _spi_desc* desc, uint8_t cs,
 		break;
 	}
 
+	assert(cs < SPID_CS_COUNT);
+	desc->cs[cs].bitrate = bitrate;
+	desc->cs[cs].dlybs = delay_dlybs;
+	desc->cs[cs].dlybct = delay_dlybct;
+
 	spi_configure_cs(desc->addr, cs, bitrate, delay_dlybs, delay_dlybct, csr);
 }
 
 void spid_set_cs_bitrate(struct _spi_desc* desc, uint8_t cs, uint32_t bitrate)
 {
+	assert(cs < SPID_CS_COUNT);
+	desc->cs[cs].bitrate = bitrate;
+
 	spi_set_cs_bitrate(desc->addr, cs, bitrate);
 }
 
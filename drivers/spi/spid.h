@@ -41,6 +41,22 @@
 #include "dma/dma.h"
 #include "io.h"
 #include "mutex.h"
+#include "peripherals/pmc.h"
+#ifdef CONFIG_DVFS
+#include "power/dvfs.h"
+#endif
+#include "spi/spid_sg.h"
+
+/*------------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+#define SPID_CS_COUNT 4
+
+/** Buffers of a transaction compiled into a single DMA transfer */
+#ifndef CONFIG_SPID_DMA_SG_ITEMS
+#define CONFIG_SPID_DMA_SG_ITEMS    8
+#endif
 
 /*------------------------------------------------------------------------------
  *        Types
@@ -83,8 +99,31 @@ struct _spi_desc {
 		struct {
 			struct _dma_channel* rx_channel;
 			struct _dma_channel* tx_channel;
+			struct _buffer* last; /*< Last buffer of the DMA chain, or of the segment too short for it */
+
+			/* scatter/gather lists of the DMA chain */
+			struct {
+				struct _spid_sg_item tx[CONFIG_SPID_DMA_SG_ITEMS];
+				struct _spid_sg_item rx[CONFIG_SPID_DMA_SG_ITEMS];
+				struct _dma_transfer_cfg tx_cfg[CONFIG_SPID_DMA_SG_ITEMS];
+				struct _dma_transfer_cfg rx_cfg[CONFIG_SPID_DMA_SG_ITEMS];
+				struct _dma_cfg tx_cfg_dma[CONFIG_SPID_DMA_SG_ITEMS];
+				struct _dma_cfg rx_cfg_dma[CONFIG_SPID_DMA_SG_ITEMS];
+			} sg;
 		} dma;
 	} xfer;
+
+	/* chip select timings, kept to recompute dividers on clock changes */
+	struct {
+		uint32_t bitrate; /*< 0 if the chip select is not configured */
+		uint32_t dlybs;
+		uint32_t dlybct;
+	} cs[SPID_CS_COUNT];
+
+	struct _pmc_mck_notifier mck_notifier;
+#ifdef CONFIG_DVFS
+	struct _dvfs_hint dvfs_hint; /*< held while a transfer is in progress */
+#endif
 };
 
 /*------------------------------------------------------------------------------
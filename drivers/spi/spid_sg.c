@@ -0,0 +1,124 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "spi/spid_sg.h"
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Fill an item for a buffer of size bytes, picking the widest data
+ * and the longest chunk.  The dummy word is aligned on 32 bits.
+ * \return false if the buffer does not fit in an item
+ */
+static bool _spid_sg_item(struct _spid_sg_item* item, uint8_t* data,
+		uint32_t size, uint8_t max_width, const struct _spid_sg_caps* caps)
+{
+	uint8_t width = max_width > 2 ? 2 : max_width;
+	uint8_t chunk;
+
+	/* the data width is limited by the alignment of the buffer */
+	while (width > 0) {
+		uint32_t mask = (1u << width) - 1;
+		if ((size & mask) == 0 && ((uint32_t)(uintptr_t)data & mask) == 0)
+			break;
+		width--;
+	}
+
+	if ((size >> width) > caps->max_len)
+		return false;
+
+	/* the chunk must divide the item and fit in the FIFO */
+	for (chunk = 4; chunk > 0; chunk--) {
+		if ((caps->chunks & (1u << chunk)) == 0)
+			continue;
+		if (((size >> width) & ((1u << chunk) - 1)) != 0)
+			continue;
+		if ((1u << (chunk + width)) <= caps->max_burst)
+			break;
+	}
+
+	item->data = data;
+	item->len = size >> width;
+	item->width = width;
+	item->chunk = chunk;
+	return true;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+uint32_t spid_sg_compile(const struct _buffer* buffers, uint32_t count,
+		const struct _spid_sg_caps* caps,
+		struct _spid_sg_item* tx, struct _spid_sg_item* rx,
+		struct _spid_sg_plan* plan)
+{
+	uint32_t i;
+
+	plan->buffers = 0;
+	plan->items = 0;
+	plan->size = 0;
+	plan->release_cs = false;
+
+	for (i = 0; i < count; i++) {
+		const struct _buffer* buf = &buffers[i];
+		uint8_t* tx_data = (buf->attr & BUS_BUF_ATTR_TX) ? buf->data : NULL;
+		uint8_t* rx_data = (buf->attr & BUS_BUF_ATTR_RX) ? buf->data : NULL;
+
+		if (buf->size > 0) {
+			if (plan->items >= caps->max_items)
+				break;
+			if (!_spid_sg_item(&tx[plan->items], tx_data, buf->size,
+					   caps->tx_width, caps))
+				break;
+			if (!_spid_sg_item(&rx[plan->items], rx_data, buf->size,
+					   caps->rx_width, caps))
+				break;
+			plan->items++;
+			plan->size += buf->size;
+		}
+		plan->buffers++;
+
+		if (buf->attr & BUS_SPI_BUF_ATTR_RELEASE_CS) {
+			plan->release_cs = true;
+			break;
+		}
+	}
+
+	return plan->buffers;
+}
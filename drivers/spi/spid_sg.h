@@ -0,0 +1,117 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Compilation of SPI transactions into scatter/gather lists.
+ *
+ * A transaction is an array of struct _buffer (command, address, data...)
+ * sent with the chip select asserted.  Instead of one DMA setup and one
+ * interrupt per buffer, the SPI driver compiles the buffers into a pair of
+ * linked lists, one for the transmitter and one for the receiver, run as a
+ * single DMA transfer.  Buffers without BUS_BUF_ATTR_TX transmit the dummy
+ * word (all ones), buffers without BUS_BUF_ATTR_RX receive into it, with a
+ * fixed address.
+ *
+ * Each item gets the widest data width and the longest chunk allowed by the
+ * capabilities given by the driver (DMA controller, SPI FIFO) and by the
+ * alignment of its buffer.  Compilation stops after a buffer releasing the
+ * chip select, the rest of the array is another list.
+ *
+ * This file does not access the hardware and can be built on a host.
+ */
+
+#ifndef SPID_SG_H_
+#define SPID_SG_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "io.h"
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Memory side of a scatter/gather item, the other side is the SPI */
+struct _spid_sg_item {
+	uint8_t* data;  /**< Buffer, NULL for the dummy word */
+	uint32_t len;   /**< Length in data units */
+	uint8_t  width; /**< Data width, log2 of its size in bytes */
+	uint8_t  chunk; /**< Chunk size, log2 of its length in data units */
+};
+
+/** What the DMA controller and the SPI allow */
+struct _spid_sg_caps {
+	uint32_t max_items; /**< Items available in each list */
+	uint32_t max_len;   /**< Longest item, in data units */
+	uint32_t chunks;    /**< Allowed chunk sizes, bit n set for 2^n data */
+	uint32_t max_burst; /**< Longest chunk in bytes (room in the FIFOs) */
+	uint8_t  rx_width;  /**< Widest RX data, log2 of its size in bytes */
+	uint8_t  tx_width;  /**< Widest TX data, log2 of its size in bytes */
+};
+
+/** Result of the compilation of a transaction */
+struct _spid_sg_plan {
+	uint32_t buffers;  /**< Buffers compiled */
+	uint32_t items;    /**< Items in each list */
+	uint32_t size;     /**< Bytes transferred */
+	bool release_cs;   /**< The last compiled buffer releases the chip select */
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Compile the first buffers of a transaction into TX and RX lists.
+ *
+ * Buffers are compiled up to the first one releasing the chip select, or
+ * until an item limit of the capabilities is reached.  Empty buffers are
+ * skipped without any item.
+ * \param buffers  Buffers of the transaction
+ * \param count    Number of buffers
+ * \param caps     Capabilities of the driver
+ * \param tx       TX list, caps->max_items long
+ * \param rx       RX list, caps->max_items long
+ * \param plan     Filled with the result
+ * \return the number of buffers compiled, 0 if the first buffer does not fit
+ * in an item (it must be transferred otherwise)
+ */
+extern uint32_t spid_sg_compile(const struct _buffer* buffers, uint32_t count,
+		const struct _spid_sg_caps* caps,
+		struct _spid_sg_item* tx, struct _spid_sg_item* rx,
+		struct _spid_sg_plan* plan);
+
+#endif /* SPID_SG_H_ */
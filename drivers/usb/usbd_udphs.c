@@ -2025,6 +2025,16 @@ bool usbd_hal_is_high_speed(void)
 	return (UDPHS->UDPHS_INTSTA & UDPHS_INTSTA_SPEED) != 0;
 }
 
+/**
+ * Returns the last (micro)frame number received from the host: frame number
+ * in bits 13..3 and microframe number in bits 2..0 (zero in full-speed).
+ */
+uint16_t usbd_hal_get_frame_number(void)
+{
+	return UDPHS->UDPHS_FNUM & (UDPHS_FNUM_FRAME_NUMBER_Msk |
+			UDPHS_FNUM_MICRO_FRAME_NUM_Msk);
+}
+
 /**
  * Suspend USB Device HW Interface
  * -# Disable transceiver
@@ -2066,6 +2066,16 @@ bool usbd_hal_is_high_speed(void)
 		   true : false;
 }
 
+/**
+ * Returns the last (micro)frame number received from the host: frame number
+ * in bits 13..3 and microframe number in bits 2..0 (zero in full-speed).
+ */
+uint16_t usbd_hal_get_frame_number(void)
+{
+	return USBHS->USBHS_DEVFNUM & (USBHS_DEVFNUM_FNUM_Msk |
+			USBHS_DEVFNUM_MFNUM_Msk);
+}
+
 /**
  * Suspend USB Device HW Interface
  * -# Disable transceiver
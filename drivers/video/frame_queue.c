@@ -0,0 +1,288 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "irqflags.h"
+#include "timer.h"
+
+#include "video/frame_queue.h"
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static bool _is_older(const struct _frame* a, const struct _frame* b)
+{
+	return (int32_t)(a->sequence - b->sequence) < 0;
+}
+
+static void _set_link(struct _frame_queue* queue, uint8_t from, uint8_t to)
+{
+	queue->link[from] = to;
+	queue->link_cb(queue->link_arg, from, to);
+}
+
+/**
+ * \brief Find a buffer for the capture, according to the queue policy.
+ * \return buffer index, or -1 if none is available
+ */
+static int _pick(struct _frame_queue* queue)
+{
+	struct _frame* oldest = NULL;
+	int i;
+
+	for (i = 0; i < queue->count; i++) {
+		struct _frame* frame = &queue->frames[i];
+		if (frame->state == FRAME_STATE_FREE)
+			return i;
+		if (frame->state == FRAME_STATE_READY &&
+		    (!oldest || _is_older(frame, oldest)))
+			oldest = frame;
+	}
+
+	if (queue->policy == FRAME_QUEUE_DROP_OLDEST && oldest) {
+		queue->dropped++;
+		return oldest->index;
+	}
+
+	return -1;
+}
+
+/**
+ * \brief Link a buffer after the next one if it still loops on itself.
+ */
+static void _refill(struct _frame_queue* queue)
+{
+	uint8_t next = queue->next;
+	int i;
+
+	if (queue->link[next] != next)
+		return;
+
+	i = _pick(queue);
+	if (i < 0)
+		return;
+
+	queue->frames[i].state = FRAME_STATE_CAPTURE;
+	_set_link(queue, i, i);
+	_set_link(queue, next, i);
+}
+
+/**
+ * \brief Link a released buffer after the next one, from thread context.
+ *
+ * Only safe while the capture interrupt is not pending: the DMA state must
+ * match the queue state. If the DMA loads the next descriptor while it is
+ * being linked, the link may be missed, so the DMA state is read again and
+ * the link reverted when the DMA did not take it.
+ */
+static void _refill_released(struct _frame_queue* queue)
+{
+	uint8_t next = queue->next;
+	uint8_t writing, loaded;
+	int i;
+
+	if (!queue->dma_state_cb)
+		return;
+
+	/* when next loops on itself the DMA may already be on it */
+	if (queue->link[next] != next || next == queue->writing)
+		return;
+
+	/* end of frame not handled yet, the capture interrupt will refill */
+	queue->dma_state_cb(queue->link_arg, &writing, &loaded);
+	if (writing != queue->writing)
+		return;
+
+	for (i = 0; i < queue->count; i++)
+		if (queue->frames[i].state == FRAME_STATE_FREE)
+			break;
+	if (i == queue->count)
+		return;
+
+	queue->frames[i].state = FRAME_STATE_CAPTURE;
+	_set_link(queue, i, i);
+	_set_link(queue, next, i);
+
+	queue->dma_state_cb(queue->link_arg, &writing, &loaded);
+	if (writing != queue->writing && loaded != i) {
+		/* the DMA loaded the descriptor before the link */
+		_set_link(queue, next, next);
+		queue->frames[i].state = FRAME_STATE_FREE;
+	}
+}
+
+static struct _frame* _find_ready(struct _frame_queue* queue, bool latest)
+{
+	struct _frame* found = NULL;
+	int i;
+
+	for (i = 0; i < queue->count; i++) {
+		struct _frame* frame = &queue->frames[i];
+		if (frame->state != FRAME_STATE_READY)
+			continue;
+		if (!found || (latest ? _is_older(found, frame) : _is_older(frame, found)))
+			found = frame;
+	}
+
+	return found;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+void frame_queue_initialize(struct _frame_queue* queue, uint8_t count,
+		frame_queue_link_t link, frame_queue_dma_state_t dma_state, void* arg)
+{
+	int i;
+
+	assert(count >= 3 && count <= FRAME_QUEUE_MAX_FRAMES);
+
+	queue->count = count;
+	queue->sequence = 0;
+	queue->dropped = 0;
+	queue->link_cb = link;
+	queue->dma_state_cb = dma_state;
+	queue->link_arg = arg;
+
+	for (i = 0; i < count; i++) {
+		queue->frames[i].index = i;
+		queue->frames[i].sequence = 0;
+		queue->frames[i].timestamp = 0;
+		queue->frames[i].state = FRAME_STATE_FREE;
+		queue->frames[i].refs = 0;
+		queue->link[i] = i;
+	}
+
+	queue->writing = 0;
+	queue->next = 1;
+	queue->frames[0].state = FRAME_STATE_CAPTURE;
+	queue->frames[1].state = FRAME_STATE_CAPTURE;
+	_set_link(queue, 1, 1);
+	_set_link(queue, 0, 1);
+	_refill(queue);
+}
+
+struct _frame* frame_queue_capture_done(struct _frame_queue* queue)
+{
+	struct _frame* frame = NULL;
+	uint32_t sequence = queue->sequence++;
+
+	if (queue->next == queue->writing) {
+		/* no buffer was available, the DMA overwrites this one */
+		queue->dropped++;
+	} else {
+		frame = &queue->frames[queue->writing];
+		frame->sequence = sequence;
+		frame->timestamp = timer_get_us();
+		frame->state = FRAME_STATE_READY;
+		queue->writing = queue->next;
+	}
+
+	/* the DMA loads the next descriptor address with the descriptor of
+	 * the buffer it writes, only the following link can change */
+	queue->next = queue->link[queue->writing];
+	_refill(queue);
+
+	return frame;
+}
+
+struct _frame* frame_queue_dequeue(struct _frame_queue* queue)
+{
+	struct _frame* frame;
+	uint32_t flags = arch_irq_save();
+
+	frame = _find_ready(queue, false);
+	if (frame) {
+		frame->state = FRAME_STATE_HELD;
+		frame->refs = 1;
+	}
+
+	arch_irq_restore(flags);
+	return frame;
+}
+
+struct _frame* frame_queue_dequeue_latest(struct _frame_queue* queue)
+{
+	struct _frame* frame;
+	uint32_t flags = arch_irq_save();
+	int i;
+
+	frame = _find_ready(queue, true);
+	if (frame) {
+		for (i = 0; i < queue->count; i++) {
+			if (queue->frames[i].state == FRAME_STATE_READY &&
+			    &queue->frames[i] != frame) {
+				queue->frames[i].state = FRAME_STATE_FREE;
+				queue->dropped++;
+			}
+		}
+		frame->state = FRAME_STATE_HELD;
+		frame->refs = 1;
+		_refill_released(queue);
+	}
+
+	arch_irq_restore(flags);
+	return frame;
+}
+
+void frame_queue_ref(struct _frame_queue* queue, struct _frame* frame)
+{
+	uint32_t flags = arch_irq_save();
+
+	assert(frame->state == FRAME_STATE_HELD);
+	frame->refs++;
+
+	arch_irq_restore(flags);
+}
+
+void frame_queue_enqueue(struct _frame_queue* queue, struct _frame* frame)
+{
+	uint32_t flags = arch_irq_save();
+
+	assert(frame->state == FRAME_STATE_HELD && frame->refs > 0);
+	if (--frame->refs == 0) {
+		frame->state = FRAME_STATE_FREE;
+		_refill_released(queue);
+	}
+
+	arch_irq_restore(flags);
+}
+
+uint32_t frame_queue_get_dropped(const struct _frame_queue* queue)
+{
+	return queue->dropped;
+}
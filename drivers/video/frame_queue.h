@@ -0,0 +1,183 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef FRAME_QUEUE_H_
+#define FRAME_QUEUE_H_
+
+/*------------------------------------------------------------------------------
+ *        Header
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*------------------------------------------------------------------------------
+ *        Definition
+ *----------------------------------------------------------------------------*/
+
+#define FRAME_QUEUE_MAX_FRAMES (10)
+
+#define FRAME_QUEUE_MAX_PLANES (3)
+
+/*------------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** What to do when a capture completes and no buffer is free */
+enum _frame_queue_policy {
+	/** Recycle the oldest frame not yet dequeued */
+	FRAME_QUEUE_DROP_OLDEST = 0,
+	/** Keep the queued frames, the capture overwrites its buffer */
+	FRAME_QUEUE_DROP_NEWEST,
+};
+
+enum _frame_state {
+	FRAME_STATE_FREE = 0,  /**< Available for capture */
+	FRAME_STATE_CAPTURE,   /**< Linked in the capture DMA chain */
+	FRAME_STATE_READY,     /**< Captured, waiting to be dequeued */
+	FRAME_STATE_HELD,      /**< Dequeued, referenced by consumers */
+};
+
+struct _frame {
+	uint8_t index;                             /**< Buffer index */
+	uint32_t address[FRAME_QUEUE_MAX_PLANES];  /**< Plane addresses */
+	uint32_t sequence;                         /**< Capture sequence number */
+	uint64_t timestamp;                        /**< End of capture, in us */
+
+	/* private */
+	enum _frame_state state;
+	uint8_t refs;
+};
+
+/**
+ * Link the capture DMA descriptor of a buffer to the descriptor of another
+ * buffer, and make the change visible to the DMA.
+ */
+typedef void (*frame_queue_link_t)(void* arg, uint8_t from, uint8_t to);
+
+/**
+ * Read from the capture DMA registers the index of the buffer being written
+ * and the index of the buffer whose descriptor the DMA loads next. An index
+ * is set to 0xff if the register matches no buffer.
+ */
+typedef void (*frame_queue_dma_state_t)(void* arg, uint8_t* writing, uint8_t* next);
+
+/**
+ * Queue of captured frames, shared between a capture driver (iscd, isid)
+ * and the consumers of the frames.
+ *
+ * The capture DMA writes to buffers chained by descriptors. The DMA reads
+ * the next descriptor address when it loads a descriptor, so the buffer
+ * following the one being written cannot change; the queue links the
+ * buffer after it to a free buffer, which loops on itself until another
+ * free buffer is available. Buffers held by consumers are never written.
+ * Three buffers are always owned by the capture.
+ *
+ * The capture driver calls frame_queue_capture_done() at the end of each
+ * frame, it must run before the end of the following frame.
+ *
+ * When the driver can read the DMA state, a buffer released while the next
+ * buffer loops on itself is linked at once, instead of at the next end of
+ * frame, so that a consumer late by one frame does not cost a second drop.
+ */
+struct _frame_queue {
+	enum _frame_queue_policy policy;
+	struct _frame frames[FRAME_QUEUE_MAX_FRAMES];
+
+	/* private */
+	uint8_t count;
+	uint8_t writing;    /**< Buffer being written */
+	uint8_t next;       /**< Next buffer, already loaded by the DMA */
+	uint8_t link[FRAME_QUEUE_MAX_FRAMES];
+	uint32_t sequence;
+	uint32_t dropped;
+	frame_queue_link_t link_cb;
+	frame_queue_dma_state_t dma_state_cb;
+	void* link_arg;
+};
+
+/*------------------------------------------------------------------------------
+ *        Functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize a frame queue, to be called by the capture driver
+ * before starting the DMA on the descriptor of buffer 0.
+ * The frame addresses must be set by the caller.
+ * \param queue Frame queue
+ * \param count Number of buffers, at least 3
+ * \param link Function linking capture DMA descriptors
+ * \param dma_state Function reading the capture DMA state, or NULL
+ * \param arg Argument for link and dma_state
+ */
+extern void frame_queue_initialize(struct _frame_queue* queue, uint8_t count,
+		frame_queue_link_t link, frame_queue_dma_state_t dma_state, void* arg);
+
+/**
+ * \brief Publish the frame which has just been captured and relink the DMA
+ * chain. Called by the capture driver from its interrupt handler.
+ * \param queue Frame queue
+ * \return the captured frame, or NULL if it was dropped
+ */
+extern struct _frame* frame_queue_capture_done(struct _frame_queue* queue);
+
+/**
+ * \brief Take the oldest captured frame. The caller owns one reference and
+ * must release it with frame_queue_enqueue().
+ * \param queue Frame queue
+ * \return a frame, or NULL if none was captured
+ */
+extern struct _frame* frame_queue_dequeue(struct _frame_queue* queue);
+
+/**
+ * \brief Take the latest captured frame, older captured frames are given
+ * back to the capture.
+ * \param queue Frame queue
+ * \return a frame, or NULL if none was captured
+ */
+extern struct _frame* frame_queue_dequeue_latest(struct _frame_queue* queue);
+
+/**
+ * \brief Add a reference to a dequeued frame, to share it with another
+ * consumer.
+ */
+extern void frame_queue_ref(struct _frame_queue* queue, struct _frame* frame);
+
+/**
+ * \brief Release a reference to a dequeued frame. The buffer is given back
+ * to the capture when the last reference is released.
+ */
+extern void frame_queue_enqueue(struct _frame_queue* queue, struct _frame* frame);
+
+/**
+ * \brief Number of frames dropped since initialization.
+ */
+extern uint32_t frame_queue_get_dropped(const struct _frame_queue* queue);
+
+#endif /* FRAME_QUEUE_H_ */
@@ -31,20 +31,36 @@
  *        Headers
  *----------------------------------------------------------------------------*/
 
+#include <assert.h>
 #include <stdbool.h>
 #include <stdio.h>
 
 #include "chip.h"
 #include "errno.h"
 #include "i2c/twid.h"
+#include "mm/cache.h"
 #include "peripherals/bus.h"
 #include "timer.h"
 #include "trace.h"
 #include "video/image_sensor_inf.h"
 
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Size of the buffer receiving compiled register tables */
+#define SENSOR_TABLE_SIZE 512
+
+/** Maximum number of registers of an exposure or gain value */
+#define SENSOR_AE_MAX_REGS 4
+
 /*----------------------------------------------------------------------------
  *        Local variables
  *----------------------------------------------------------------------------*/
+
+/** Compiled register table, sent by DMA */
+CACHE_ALIGNED static uint8_t sensor_table[SENSOR_TABLE_SIZE];
+
 /** Supported sensor profiles */
 static const struct sensor_profile* sensor_profiles[SENSOR_SUPPORTED_NUMBER] = {
 	&ov2640_profile,
@@ -121,61 +137,46 @@ static int sensor_twi_read_reg(uint8_t twi_mode, uint8_t bus, uint8_t addr,
 }
 
 /**
- * \brief  Write a value to a register in an dedicated sensor device.
+ * \brief Execute a compiled register table.
+ * The bus is held during the whole table, each write record is sent as a
+ * single TWI transaction (by DMA if enabled on the bus and long enough).
  * \param bus  TWI bus
  * \param addr Sensor TWI addr
- * \param reg Register to be written
- * \param data Data written
+ * \param table Compiled table
  * \return SENSOR_OK if no error; otherwise SENSOR_TWI_ERROR
  */
-static int sensor_twi_write_reg(uint8_t twi_mode, uint8_t bus, uint8_t addr,
-				uint16_t reg, uint8_t *data)
+static uint32_t sensor_twi_run(uint8_t bus, uint8_t addr, const uint8_t* table)
 {
-	int err;
-	uint8_t addr_buf[2];
-	struct _buffer buf[2] = {
-		{
-			.data = addr_buf,
-			/* .size */
-			.attr = BUS_I2C_BUF_ATTR_START | BUS_BUF_ATTR_TX,
-		},
-		{
-			.data = data,
-			/* .size */
-			.attr = BUS_BUF_ATTR_TX | BUS_I2C_BUF_ATTR_STOP,
-		},
+	uint32_t status = SENSOR_OK;
+	uint16_t arg;
+	struct _buffer buf = {
+		/* .data */
+		/* .size */
+		.attr = BUS_I2C_BUF_ATTR_START | BUS_BUF_ATTR_TX | BUS_I2C_BUF_ATTR_STOP,
 	};
 
-	switch (twi_mode){
-	case SENSOR_TWI_REG_BYTE_DATA_BYTE:
-		buf[0].size = 1;
-		buf[1].size = 1;
-		addr_buf[0] = reg & 0xff;
-
-		break;
-
-	case SENSOR_TWI_REG_2BYTE_DATA_BYTE:
-		buf[0].size = 2;
-		buf[1].size = 1;
-		addr_buf[0] = (reg >> 8) & 0xff;
-		addr_buf[1] = reg & 0xff;
-		break;
-
-	case SENSOR_TWI_REG_BYTE_DATA_2BYTE:
-		buf[0].size = 1;
-		buf[1].size = 2;
-		addr_buf[0] = reg & 0xff;
-		break;
-
-	default:
-		return -EINVAL;
-	}
-
 	bus_start_transaction(bus);
-	err = bus_transfer(bus, addr, buf, 2, NULL);
+	while (table[0] != SENSOR_REGS_OP_END) {
+		arg = table[2] | (table[3] << 8);
+		if (table[0] == SENSOR_REGS_OP_DELAY) {
+			msleep(arg);
+			table += 4;
+		} else if (table[0] == SENSOR_REGS_OP_WRITE) {
+			buf.data = (uint8_t*)&table[4];
+			buf.size = arg;
+			if (bus_transfer(bus, addr, &buf, 1, NULL) < 0) {
+				status = SENSOR_TWI_ERROR;
+				break;
+			}
+			table += 4 + ((arg + 3) & ~3);
+		} else {
+			status = SENSOR_TWI_ERROR;
+			break;
+		}
+	}
 	bus_stop_transaction(bus);
 
-	return err;
+	return status;
 }
 
 /**
@@ -218,33 +219,81 @@ static uint32_t sensor_check_pid(uint8_t twi_bus, struct sensor_profile* sensor_
 /**
  * \brief  Initialize a list of registers.
  * The list of registers is terminated by the pair of values
+ * The list is compiled by chunks into burst writes and explicit delays.
  * \param twi_bus  TWI bus
  * \param sensor_profile   Sensor private profile
  * \param reglist Register list to be written
  * \return SENSOR_OK if no error; otherwise SENSOR_TWI_ERROR
  */
 static uint32_t sensor_twi_write_regs(uint8_t twi_bus,
-									  struct sensor_profile* sensor_profile,
+									  const struct sensor_profile* sensor_profile,
 									  const struct sensor_reg* reglist)
 {
-	int status;
+	uint32_t status;
 	const struct sensor_reg *next = reglist;
 
-	while (!((next->reg == SENSOR_REG_TERM) && (next->val == SENSOR_VAL_TERM))) {
-		status = sensor_twi_write_reg(sensor_profile->twi_inf_mode,
-									  twi_bus,
-									  sensor_profile->addr,
-									  next->reg,
-									  (uint8_t *)(&next->val));
-		msleep(2);
-		if (status < 0)
+	while (next) {
+		if (sensor_regs_compile(next, sensor_profile->twi_inf_mode,
+				sensor_profile->twi_flags, sensor_table,
+				sizeof(sensor_table), &next) < 0)
+			return SENSOR_TWI_ERROR;
+		status = sensor_twi_run(twi_bus, sensor_profile->addr,
+				sensor_table);
+		if (status != SENSOR_OK)
+			return status;
+	}
+
+	return SENSOR_OK;
+}
+
+/**
+ * \brief Read a value split MSB first over consecutive registers.
+ * \param twi_bus  TWI bus
+ * \param sensor Sensor profile
+ * \param reg First register
+ * \param count Number of registers
+ * \param value Value read
+ * \return SENSOR_OK if no error; otherwise SENSOR_TWI_ERROR
+ */
+static uint32_t sensor_read_value(uint8_t twi_bus,
+				  const struct sensor_profile* sensor,
+				  uint16_t reg, uint8_t count, uint32_t* value)
+{
+	/* use uint32_t to force 4-byte alignment */
+	uint32_t data;
+	uint8_t i;
+
+	*value = 0;
+	for (i = 0; i < count; i++) {
+		data = 0;
+		if (sensor_twi_read_reg(sensor->twi_inf_mode, twi_bus,
+					sensor->addr, reg + i, (uint8_t*)&data) < 0)
 			return SENSOR_TWI_ERROR;
-		next++;
+		*value = (*value << 8) | (data & 0xff);
 	}
 
 	return SENSOR_OK;
 }
 
+/**
+ * \brief Fill a register list with a value split MSB first over
+ * consecutive registers.
+ * \return Pointer to the entry following the last register filled
+ */
+static struct sensor_reg* sensor_fill_value(struct sensor_reg* list,
+					    uint16_t reg, uint8_t count,
+					    uint32_t value)
+{
+	uint8_t i;
+
+	for (i = 0; i < count; i++, list++) {
+		list->reg = reg + i;
+		list->val = (value >> (8 * (count - 1 - i))) & 0xff;
+	}
+
+	return list;
+}
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -273,6 +322,75 @@ uint32_t sensor_setup(uint8_t twi_bus, struct sensor_profile* sensor_profile,
 								 sensor_profile->output_conf[i]->output_setting);
 }
 
+uint32_t sensor_write_compiled(uint8_t twi_bus,
+			       const struct sensor_profile* sensor,
+			       const uint8_t* table)
+{
+	return sensor_twi_run(twi_bus, sensor->addr, table);
+}
+
+uint32_t sensor_start_manual_exposure(uint8_t twi_bus,
+				      const struct sensor_profile* sensor,
+				      uint32_t* exposure, uint16_t* gain)
+{
+	const struct sensor_ae* ae = sensor->ae;
+	uint32_t status;
+	uint32_t value;
+
+	if (!ae)
+		return SENSOR_NOT_SUPPORTED;
+
+	status = sensor_twi_write_regs(twi_bus, sensor, ae->manual);
+	if (status != SENSOR_OK)
+		return status;
+
+	status = sensor_read_value(twi_bus, sensor, ae->exposure_reg,
+				   ae->exposure_count, &value);
+	if (status != SENSOR_OK)
+		return status;
+	*exposure = value >> ae->exposure_shift;
+
+	status = sensor_read_value(twi_bus, sensor, ae->gain_reg,
+				   ae->gain_count, &value);
+	if (status != SENSOR_OK)
+		return status;
+	*gain = value >> ae->gain_shift;
+
+	return SENSOR_OK;
+}
+
+uint32_t sensor_set_exposure(uint8_t twi_bus,
+			     const struct sensor_profile* sensor,
+			     uint32_t exposure, uint16_t gain)
+{
+	const struct sensor_ae* ae = sensor->ae;
+	struct sensor_reg regs[2 * SENSOR_AE_MAX_REGS + 1];
+	struct sensor_reg* next;
+
+	if (!ae)
+		return SENSOR_NOT_SUPPORTED;
+	assert(ae->exposure_count <= SENSOR_AE_MAX_REGS);
+	assert(ae->gain_count <= SENSOR_AE_MAX_REGS);
+
+	if (exposure < ae->exposure_min)
+		exposure = ae->exposure_min;
+	if (exposure > ae->exposure_max)
+		exposure = ae->exposure_max;
+	if (gain < ae->gain_one)
+		gain = ae->gain_one;
+	if (gain > ae->gain_max)
+		gain = ae->gain_max;
+
+	next = sensor_fill_value(regs, ae->exposure_reg, ae->exposure_count,
+				 exposure << ae->exposure_shift);
+	next = sensor_fill_value(next, ae->gain_reg, ae->gain_count,
+				 (uint32_t)gain << ae->gain_shift);
+	next->reg = SENSOR_REG_TERM;
+	next->val = SENSOR_VAL_TERM;
+
+	return sensor_twi_write_regs(twi_bus, sensor, regs);
+}
+
 struct sensor_profile* sensor_detect(uint8_t twi_bus, bool detect_auto, uint8_t id)
 {
 	uint8_t i;
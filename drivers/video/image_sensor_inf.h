@@ -38,6 +38,7 @@
 
 #include <stdint.h>
 #include "board.h"
+#include "video/sensor_regs.h"
 
 /*---------------------------------------------------------------------------
  *         Definitions
@@ -53,11 +54,6 @@
 
 #define SENSOR_SUPPORTED_OUTPUTS 7
 
-/** terminating list entry for register in configuration file */
-#define SENSOR_REG_TERM         0xFF
-/** terminating list entry for value in configuration file */
-#define SENSOR_VAL_TERM         0xFF
-
 /*----------------------------------------------------------------------------
  *        Types
  *----------------------------------------------------------------------------*/
@@ -66,7 +62,8 @@ enum {
 	SENSOR_OK = 0,        /**< Operation is successful */
 	SENSOR_TWI_ERROR,
 	SENSOR_ID_ERROR,
-	SENSOR_RESOLUTION_NOT_SUPPORTED
+	SENSOR_RESOLUTION_NOT_SUPPORTED,
+	SENSOR_NOT_SUPPORTED
 };
 
 /** Sensor type */
@@ -75,13 +72,6 @@ enum {
 	SENSOR_CCD
 };
 
-/** Sensor TWI mode */
-enum {
-	SENSOR_TWI_REG_BYTE_DATA_BYTE = 0,
-	SENSOR_TWI_REG_2BYTE_DATA_BYTE,
-	SENSOR_TWI_REG_BYTE_DATA_2BYTE
-};
-
 /** Sensor resolution */
 enum {
 	QVGA = 0,
@@ -110,12 +100,6 @@ enum {
 	BIT_12
 };
 
-/** define a structure for sensor register initialization values */
-struct sensor_reg {
-	uint16_t reg; /* Register to be written */
-	uint16_t val; /* value to be written */
-};
-
 struct sensor_output {
 	uint8_t type;                               /** Index 0: normal, 1: AF setting*/
 	uint8_t output_resolution;                  /** sensor output resolution */
@@ -127,6 +111,22 @@ struct sensor_output {
 	const struct sensor_reg* output_setting;    /** sensor registers setting */
 };
 
+/** Exposure and gain registers of a sensor, values are split MSB first
+ * over consecutive registers */
+struct sensor_ae {
+	uint16_t exposure_reg;        /** First exposure register */
+	uint8_t exposure_count;       /** Number of exposure registers */
+	uint8_t exposure_shift;       /** Shift of the exposure in the registers */
+	uint32_t exposure_min;        /** Minimum exposure, in lines */
+	uint32_t exposure_max;        /** Maximum exposure, in lines */
+	uint16_t gain_reg;            /** First gain register */
+	uint8_t gain_count;           /** Number of gain registers */
+	uint8_t gain_shift;           /** Shift of the gain in the registers */
+	uint16_t gain_one;            /** Gain value for 1x */
+	uint16_t gain_max;            /** Maximum gain value */
+	const struct sensor_reg* manual; /** Registers selecting manual exposure */
+};
+
 /** define a structure for sensor profile */
 struct sensor_profile {
 	const char* name;             /** Sensor name */
@@ -139,6 +139,8 @@ struct sensor_profile {
 	uint16_t pid_low;             /** product ID low byte */
 	uint16_t version_mask;        /** version mask */
 	const struct sensor_output* output_conf[SENSOR_SUPPORTED_OUTPUTS]; /** sensor settings */
+	uint8_t twi_flags;            /** SENSOR_REGS_xxx flags */
+	const struct sensor_ae* ae;   /** Exposure and gain control, or NULL */
 };
 
 /*----------------------------------------------------------------------------
@@ -178,6 +180,45 @@ extern uint32_t sensor_setup(uint8_t twi_bus,
 							 uint8_t resolution,
 							 uint8_t format);
 
+/**
+ * \brief Write a compiled register table (see sensor_regs_compile()).
+ * \param twi_bus TWI bus
+ * \param sensor pointer to a sensor profile instance.
+ * \param table compiled table, 4-byte aligned
+ * \return SENSOR_OK if no error; otherwise return SENSOR_TWI_ERROR
+ */
+extern uint32_t sensor_write_compiled(uint8_t twi_bus,
+				      const struct sensor_profile* sensor,
+				      const uint8_t* table);
+
+/**
+ * \brief Switch the sensor to manual exposure and gain, and read their
+ * current values.
+ * \param twi_bus TWI bus
+ * \param sensor pointer to a sensor profile instance.
+ * \param exposure pointer to the exposure, in lines
+ * \param gain pointer to the gain, in sensor_ae.gain_one units
+ * \return SENSOR_OK if no error; otherwise return SENSOR_XXX_ERROR
+ */
+extern uint32_t sensor_start_manual_exposure(uint8_t twi_bus,
+					     const struct sensor_profile* sensor,
+					     uint32_t* exposure,
+					     uint16_t* gain);
+
+/**
+ * \brief Program the sensor exposure and gain.
+ * The sensor must be in manual mode, see sensor_start_manual_exposure().
+ * \param twi_bus TWI bus
+ * \param sensor pointer to a sensor profile instance.
+ * \param exposure exposure, in lines
+ * \param gain gain, in sensor_ae.gain_one units
+ * \return SENSOR_OK if no error; otherwise return SENSOR_XXX_ERROR
+ */
+extern uint32_t sensor_set_exposure(uint8_t twi_bus,
+				    const struct sensor_profile* sensor,
+				    uint32_t exposure,
+				    uint16_t gain);
+
 /**
  * \brief Retrieves sensor output bit width and size for giving resolution and format.
  * \param sensor pointer to a sensor profile instance.
@@ -687,6 +687,14 @@ void isc_dma_configure_desc_entry(uint32_t desc_entry)
 	ISC->ISC_DNDA = desc_entry;
 }
 
+/**
+ * \brief Get the address of the DMA descriptor VIEW loaded next.
+ */
+uint32_t isc_dma_get_desc_entry(void)
+{
+	return ISC->ISC_DNDA;
+}
+
 /**
  * \brief Enable ISC DMA with giving view.
  * \param ctrl setting for DMA descriptor VIEW.
@@ -707,3 +715,12 @@ void isc_dma_address(uint8_t channel, uint32_t address, uint32_t stride)
 	ISC->ISC_SUB0[channel].ISC_DAD = address;
 	ISC->ISC_SUB0[channel].ISC_DST = stride;
 }
+
+/**
+ * \brief Get ISC DMA address of the buffer being written.
+ * \param channel channel number.
+ */
+uint32_t isc_dma_get_address(uint8_t channel)
+{
+	return ISC->ISC_SUB0[channel].ISC_DAD;
+}
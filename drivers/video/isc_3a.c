@@ -0,0 +1,266 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file
+ *
+ * Auto white balance and auto exposure from the ISC histograms.
+ *
+ * This module only does integer computations on memory buffers: it can be
+ * called from interrupt context and built on a host to replay histogram
+ * dumps. Programming the ISC and the sensor is left to the caller.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stddef.h>
+#include <string.h>
+
+#include "video/isc_3a.h"
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Exposure ratios are 8.8 fixed point values */
+#define RATIO_ONE (256)
+
+/** Maximum AE correction per update */
+#define RATIO_MIN (RATIO_ONE / 8)
+#define RATIO_MAX (RATIO_ONE * 8)
+
+/** Maximum AE correction when too many pixels are saturated */
+#define RATIO_SATURATED (RATIO_ONE * 3 / 4)
+
+/*----------------------------------------------------------------------------
+ *        Exported variables
+ *----------------------------------------------------------------------------*/
+
+const struct _isc_3a_cfg isc_3a_default_cfg = {
+	.awb_mode = ISC_3A_AWB_COMBINED,
+	.white_ratio = 10,
+	.ae_target = 110,
+	.ae_tolerance = 8,
+	.saturation_ratio = 20,
+	.jump_ratio = 16,
+	.smooth_shift = 1,
+	.exposure_min = 0,
+	.exposure_max = 0,
+	.gain_one = 0,
+	.gain_max = 0,
+};
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Move a value toward its target.
+ * Large errors (lighting changes) are corrected at once, small ones are
+ * filtered to avoid oscillations. Errors smaller than 2^smooth_shift are
+ * ignored.
+ */
+static uint64_t _filter(const struct _isc_3a_cfg* cfg, uint64_t cur,
+		uint64_t target)
+{
+	uint64_t diff = cur > target ? cur - target : target - cur;
+	uint64_t step;
+
+	if (cur == 0 || (diff << 8) >= (uint64_t)cfg->jump_ratio * cur)
+		return target;
+
+	step = diff >> cfg->smooth_shift;
+	return cur > target ? cur - step : cur + step;
+}
+
+static uint32_t _clamp(uint32_t value, uint32_t min, uint32_t max)
+{
+	if (value < min)
+		return min;
+	if (value > max)
+		return max;
+	return value;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+void isc_3a_initialize(struct _isc_3a* ctx, const struct _isc_3a_cfg* cfg,
+		uint32_t exposure, uint16_t gain)
+{
+	int i;
+
+	memset(ctx, 0, sizeof(*ctx));
+	ctx->cfg = *cfg;
+	for (i = 0; i < BAYER_COUNT; i++)
+		ctx->wb_gain[i] = ISC_3A_WB_ONE;
+	ctx->exposure = exposure;
+	ctx->gain = gain;
+}
+
+void isc_3a_collect(struct _isc_3a* ctx, const uint32_t* histo)
+{
+	const uint32_t* gr = &histo[HISTOGRAM_GR * HIST_ENTRIES];
+	const uint32_t* r = &histo[HISTOGRAM_R * HIST_ENTRIES];
+	const uint32_t* gb = &histo[HISTOGRAM_GB * HIST_ENTRIES];
+	const uint32_t* b = &histo[HISTOGRAM_B * HIST_ENTRIES];
+	uint32_t count[BAYER_COUNT] = { 0 };
+	uint64_t sum[BAYER_COUNT] = { 0 };
+	uint32_t i, c, limit, acc;
+
+	/* single pass over the four channels */
+	for (i = 0; i < HIST_ENTRIES; i++) {
+		count[HISTOGRAM_GR] += gr[i];
+		sum[HISTOGRAM_GR] += (uint64_t)gr[i] * i;
+		count[HISTOGRAM_R] += r[i];
+		sum[HISTOGRAM_R] += (uint64_t)r[i] * i;
+		count[HISTOGRAM_GB] += gb[i];
+		sum[HISTOGRAM_GB] += (uint64_t)gb[i] * i;
+		count[HISTOGRAM_B] += b[i];
+		sum[HISTOGRAM_B] += (uint64_t)b[i] * i;
+	}
+
+	for (c = 0; c < BAYER_COUNT; c++) {
+		struct _isc_3a_stats* stats = &ctx->stats[c];
+		const uint32_t* h = &histo[c * HIST_ENTRIES];
+
+		stats->count = count[c];
+		stats->saturated = h[HIST_ENTRIES - 1];
+		stats->mean = count[c] ?
+			(uint32_t)((sum[c] << ISC_3A_MEAN_SHIFT) / count[c]) : 0;
+
+		/* white point: walk down from the top until the ignored
+		 * brightest pixels are skipped, usually only a few bins */
+		limit = (uint32_t)(((uint64_t)count[c] * ctx->cfg.white_ratio) >> 10);
+		acc = 0;
+		for (i = HIST_ENTRIES - 1; i > 0; i--) {
+			acc += h[i];
+			if (acc > limit)
+				break;
+		}
+		stats->white = i;
+	}
+}
+
+bool isc_3a_update_awb(struct _isc_3a* ctx)
+{
+	const struct _isc_3a_stats* stats = ctx->stats;
+	uint32_t g_mean, g_white, gain, gw, wp;
+	bool changed = false;
+	int c;
+
+	g_mean = (stats[HISTOGRAM_GR].mean + stats[HISTOGRAM_GB].mean) / 2;
+	g_white = (stats[HISTOGRAM_GR].white + stats[HISTOGRAM_GB].white) / 2;
+
+	for (c = 0; c < BAYER_COUNT; c++) {
+		if (!stats[c].mean || !stats[c].white)
+			return false;
+	}
+
+	for (c = 0; c < BAYER_COUNT; c++) {
+		gw = (g_mean << ISC_3A_WB_SHIFT) / stats[c].mean;
+		wp = (g_white << ISC_3A_WB_SHIFT) / stats[c].white;
+
+		switch (ctx->cfg.awb_mode) {
+		case ISC_3A_AWB_WHITE_PATCH:
+			gain = wp;
+			break;
+		case ISC_3A_AWB_COMBINED:
+			gain = (gw + wp) / 2;
+			break;
+		case ISC_3A_AWB_GRAY_WORLD:
+		default:
+			gain = gw;
+			break;
+		}
+		gain = _clamp(gain, ISC_3A_WB_MIN, ISC_3A_WB_MAX);
+		gain = (uint32_t)_filter(&ctx->cfg, ctx->wb_gain[c], gain);
+		if (gain != ctx->wb_gain[c]) {
+			ctx->wb_gain[c] = gain;
+			changed = true;
+		}
+	}
+
+	return changed;
+}
+
+bool isc_3a_update_ae(struct _isc_3a* ctx)
+{
+	const struct _isc_3a_cfg* cfg = &ctx->cfg;
+	const struct _isc_3a_stats* stats = ctx->stats;
+	uint32_t mean, target, tolerance, count, saturated, ratio;
+	uint32_t exposure, gain;
+	uint64_t product, wanted;
+	bool clipped;
+
+	count = stats[HISTOGRAM_GR].count + stats[HISTOGRAM_GB].count;
+	if (!cfg->exposure_max || !cfg->gain_one || !count)
+		return false;
+
+	mean = (stats[HISTOGRAM_GR].mean + stats[HISTOGRAM_GB].mean) / 2;
+	saturated = stats[HISTOGRAM_GR].saturated + stats[HISTOGRAM_GB].saturated;
+	target = cfg->ae_target << ISC_3A_MEAN_SHIFT;
+	tolerance = cfg->ae_tolerance << ISC_3A_MEAN_SHIFT;
+	clipped = ((uint64_t)saturated << 10) > (uint64_t)count * cfg->saturation_ratio;
+
+	if (!clipped && mean + tolerance >= target && mean <= target + tolerance)
+		return false;
+
+	/* the histogram is linear: the exposure ratio to reach the
+	 * target is the ratio of the means */
+	ratio = mean ? (uint32_t)(((uint64_t)target << 8) / mean) : RATIO_MAX;
+	ratio = _clamp(ratio, RATIO_MIN, RATIO_MAX);
+	if (clipped) {
+		/* the mean is underestimated, never increase and keep
+		 * decreasing while close to the target */
+		if (mean + tolerance >= target && ratio > RATIO_SATURATED)
+			ratio = RATIO_SATURATED;
+		else if (ratio > RATIO_ONE)
+			ratio = RATIO_ONE;
+	}
+
+	product = (uint64_t)ctx->exposure * ctx->gain;
+	if (product < cfg->gain_one)
+		product = cfg->gain_one;
+	wanted = (product * ratio) >> 8;
+	wanted = _filter(cfg, product, wanted);
+
+	/* prefer exposure to gain, for a lower noise */
+	exposure = _clamp((uint32_t)(wanted / cfg->gain_one),
+			cfg->exposure_min ? cfg->exposure_min : 1, cfg->exposure_max);
+	gain = _clamp((uint32_t)(wanted / exposure), cfg->gain_one, cfg->gain_max);
+
+	if (exposure == ctx->exposure && gain == ctx->gain)
+		return false;
+	ctx->exposure = exposure;
+	ctx->gain = gain;
+	return true;
+}
@@ -0,0 +1,149 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef ISC_3A_H_
+#define ISC_3A_H_
+
+/*------------------------------------------------------------------------------
+ *        Header
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*------------------------------------------------------------------------------
+ *        Definition
+ *----------------------------------------------------------------------------*/
+
+#define HISTOGRAM_GR (0)
+#define HISTOGRAM_R  (1)
+#define HISTOGRAM_GB (2)
+#define HISTOGRAM_B  (3)
+
+#define BAYER_COUNT (HISTOGRAM_B + 1)
+
+#define HIST_ENTRIES (512)
+
+/** White balance gains are unsigned 13 bits (0:4:9) fixed point values */
+#define ISC_3A_WB_SHIFT (9)
+#define ISC_3A_WB_ONE   (1 << ISC_3A_WB_SHIFT)
+#define ISC_3A_WB_MIN   (ISC_3A_WB_ONE / 8)
+#define ISC_3A_WB_MAX   (0x1fff)
+
+/** Histogram means are given in 1/16 of bin */
+#define ISC_3A_MEAN_SHIFT (4)
+
+/*------------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+enum _isc_3a_awb_mode {
+	ISC_3A_AWB_GRAY_WORLD = 0, /**< Equalize the channel means */
+	ISC_3A_AWB_WHITE_PATCH,    /**< Equalize the channel white points */
+	ISC_3A_AWB_COMBINED,       /**< Average of gray world and white patch */
+};
+
+struct _isc_3a_cfg {
+	enum _isc_3a_awb_mode awb_mode;
+	/** White point: brightest pixels ignored, in 1/1024 of the pixels */
+	uint16_t white_ratio;
+	/** AE target for the green mean, in bins */
+	uint16_t ae_target;
+	/** AE dead band around the target, in bins */
+	uint16_t ae_tolerance;
+	/** Saturated green pixels allowed, in 1/1024 of the pixels */
+	uint16_t saturation_ratio;
+	/** Errors above this ratio of the current value, in 1/256, are
+	 * corrected at once, smaller ones are filtered */
+	uint16_t jump_ratio;
+	/** Filter of small errors: 1/2^n of the error corrected per update */
+	uint8_t smooth_shift;
+	/** Exposure range, in sensor units. AE is disabled if zero. */
+	uint32_t exposure_min;
+	uint32_t exposure_max;
+	/** Gain range, in sensor units, gain_one being 1x */
+	uint16_t gain_one;
+	uint16_t gain_max;
+};
+
+struct _isc_3a_stats {
+	uint32_t count;     /**< Number of pixels */
+	uint32_t mean;      /**< Mean, in 1/16 bin */
+	uint32_t white;     /**< White point, in bins */
+	uint32_t saturated; /**< Pixels in the last bin */
+};
+
+struct _isc_3a {
+	struct _isc_3a_cfg cfg;
+	struct _isc_3a_stats stats[BAYER_COUNT];
+	uint16_t wb_gain[BAYER_COUNT]; /**< 0:4:9 white balance gains */
+	uint32_t exposure;             /**< Sensor exposure */
+	uint16_t gain;                 /**< Sensor gain */
+};
+
+/*------------------------------------------------------------------------------
+ *        Functions
+ *----------------------------------------------------------------------------*/
+
+/** Default configuration, AE disabled */
+extern const struct _isc_3a_cfg isc_3a_default_cfg;
+
+/**
+ * \brief Initialize the 3A state, white balance gains are set to 1x.
+ * \param ctx 3A state
+ * \param cfg Configuration, copied
+ * \param exposure Current sensor exposure
+ * \param gain Current sensor gain
+ */
+extern void isc_3a_initialize(struct _isc_3a* ctx,
+		const struct _isc_3a_cfg* cfg, uint32_t exposure, uint16_t gain);
+
+/**
+ * \brief Compute the statistics of the four Bayer histograms in one pass.
+ * \param ctx 3A state
+ * \param histo BAYER_COUNT histograms of HIST_ENTRIES entries, in
+ * HISTOGRAM_xx order, taken before white balance
+ */
+extern void isc_3a_collect(struct _isc_3a* ctx, const uint32_t* histo);
+
+/**
+ * \brief Update the white balance gains from the last statistics.
+ * \param ctx 3A state
+ * \return true if the gains changed
+ */
+extern bool isc_3a_update_awb(struct _isc_3a* ctx);
+
+/**
+ * \brief Update the sensor exposure and gain from the last statistics.
+ * \param ctx 3A state
+ * \return true if the exposure or the gain changed
+ */
+extern bool isc_3a_update_ae(struct _isc_3a* ctx);
+
+#endif /* ISC_3A_H_ */
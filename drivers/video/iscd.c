@@ -61,7 +61,7 @@ static int _dma_histo_callback(void *arg, void* arg2)
 
 	dma_reset_channel(awb.dma.dma_histo_channel);
 
-	cache_invalidate_region((uint32_t*)iscd->pipe.histo_buf,
+	cache_invalidate_region(&iscd->pipe.histo_buf[awb.op_mode * HIST_ENTRIES],
 			HIST_ENTRIES * sizeof(uint32_t));
 	awb.dma.dma_histo_done = true;
 
@@ -122,50 +122,55 @@ static uint32_t _float2hex(uint8_t sign_bit, uint8_t magnitude_bit,
 }
 
 /**
- * \brief Calculate gain for RGGB bayer and perform them with ISC WB module.
+ * \brief Update white balance gains and sensor exposure from the four
+ * Bayer histograms.
  */
-static void _awb_update(void)
+static void _3a_update(const uint32_t* histo_buf)
 {
-	uint32_t count[BAYER_COUNT];
-	float gain[BAYER_COUNT];
-	uint32_t gain_049[BAYER_COUNT];
-
-	count[HISTOGRAM_R] = (awb.count[HISTOGRAM_R] + awb.backup[HISTOGRAM_R]) / 2;
-	count[HISTOGRAM_GB] = (awb.count[HISTOGRAM_GB] +  awb.backup[HISTOGRAM_GB]) / 2;
-	count[HISTOGRAM_GR] = (awb.count[HISTOGRAM_GR] + awb.backup[HISTOGRAM_GR]) / 2;
-	count[HISTOGRAM_B] = (awb.count[HISTOGRAM_B] + awb.backup[HISTOGRAM_B]) / 2;
-
-	gain[HISTOGRAM_R] = (float)(count[HISTOGRAM_GB]) / (float)(count[HISTOGRAM_R]);
-	gain[HISTOGRAM_GB] = 1.0000000;
-	gain[HISTOGRAM_GR] = 1.0000000;
-	gain[HISTOGRAM_B] = (float)(count[HISTOGRAM_GB]) / (float)(count[HISTOGRAM_B]);
-
-	/* Convert R/G/BGAIN component gain to unsigned 13 bits (0:4:9) */
-	gain_049[HISTOGRAM_R] = _float2hex(0, 4, 9, gain[HISTOGRAM_R]);
-	gain_049[HISTOGRAM_GB] = _float2hex(0, 4, 9, gain[HISTOGRAM_GB]);
-	gain_049[HISTOGRAM_GR] = _float2hex(0, 4, 9, gain[HISTOGRAM_GR]);
-	gain_049[HISTOGRAM_B] = _float2hex(0, 4, 9, gain[HISTOGRAM_B]);
-
-	isc_wb_adjust_bayer_color(0, 0, 0, 0, gain_049[HISTOGRAM_R], gain_049[HISTOGRAM_GR],
-                                  gain_049[HISTOGRAM_B], gain_049[HISTOGRAM_GB]);
-	isc_update_profile();
+	const uint16_t* gain = awb.ctx.wb_gain;
+
+	isc_3a_collect(&awb.ctx, histo_buf);
+
+	if (isc_3a_update_awb(&awb.ctx)) {
+		isc_wb_adjust_bayer_color(0, 0, 0, 0,
+		                          gain[HISTOGRAM_R], gain[HISTOGRAM_GR],
+		                          gain[HISTOGRAM_B], gain[HISTOGRAM_GB]);
+		isc_update_profile();
+	}
 
-	awb.backup[HISTOGRAM_R] = awb.count[HISTOGRAM_R];
-	awb.backup[HISTOGRAM_GB] = awb.count[HISTOGRAM_GB];
-	awb.backup[HISTOGRAM_GR] = awb.count[HISTOGRAM_GR];
-	awb.backup[HISTOGRAM_B] = awb.count[HISTOGRAM_B];
+	if (awb.sensor && isc_3a_update_ae(&awb.ctx)) {
+		if (sensor_set_exposure(awb.twi_bus, awb.sensor,
+				awb.ctx.exposure, awb.ctx.gain) != SENSOR_OK)
+			trace_warning("Can't set sensor exposure\n\r");
+	}
 }
 
 /**
- * \brief Count up 4 channel R/G/Gr/Gb histogram data.
+ * \brief Initialize auto white balance and, if requested and supported by
+ * the sensor, auto exposure.
  */
-static void _awb_count_up(uint32_t* buf)
+static void _3a_initialize(struct _iscd_desc* desc)
 {
-	uint32_t i;
-
-	awb.count[awb.op_mode] = 0;
-	for (i = 0; i < HIST_ENTRIES; i++)
-		awb.count[awb.op_mode] += (*buf++) * i;
+	struct _isc_3a_cfg cfg = isc_3a_default_cfg;
+	const struct sensor_profile* sensor = desc->pipe.ae.sensor;
+	uint32_t exposure = 0;
+	uint16_t gain = 0;
+
+	awb.sensor = NULL;
+	if (desc->pipe.ae.ae_enable && sensor && sensor->ae) {
+		if (sensor_start_manual_exposure(desc->pipe.ae.twi_bus, sensor,
+				&exposure, &gain) == SENSOR_OK) {
+			cfg.exposure_min = sensor->ae->exposure_min;
+			cfg.exposure_max = sensor->ae->exposure_max;
+			cfg.gain_one = sensor->ae->gain_one;
+			cfg.gain_max = sensor->ae->gain_max;
+			awb.twi_bus = desc->pipe.ae.twi_bus;
+			awb.sensor = sensor;
+		} else {
+			trace_warning("Can't switch sensor to manual exposure\n\r");
+		}
+	}
+	isc_3a_initialize(&awb.ctx, &cfg, exposure, gain);
 }
 
 /**
@@ -174,10 +179,20 @@ static void _awb_count_up(uint32_t* buf)
 static void _isc_handler(uint32_t source, void* arg)
 {
 	struct _iscd_desc* iscd = (struct _iscd_desc*)arg;
+	struct _frame* frame;
 	uint32_t status;
 
 	status = isc_interrupt_status();
-	if ((status & ISC_INTSR_VD) == ISC_INTSR_VD) {
+	if (iscd->dma.queue) {
+		if ((status & ISC_INTSR_DDONE) == ISC_INTSR_DDONE) {
+			frame = frame_queue_capture_done(iscd->dma.queue);
+			if (frame) {
+				iscd->pipe.frame_idx = frame->index;
+				if (iscd->dma.callback)
+					iscd->dma.callback(frame->index);
+			}
+		}
+	} else if ((status & ISC_INTSR_VD) == ISC_INTSR_VD) {
 		if (iscd->pipe.frame_idx == (iscd->cfg.multi_bufs - 1))
 			iscd->pipe.frame_idx = 0;
 		else
@@ -189,6 +204,94 @@ static void _isc_handler(uint32_t source, void* arg)
 		awb.dma.dma_histo_ready = true;
 }
 
+/**
+ * \brief Link the DMA descriptor of a buffer to the one of another buffer.
+ */
+static void _iscd_link_desc(void* arg, uint8_t from, uint8_t to)
+{
+	struct _iscd_desc* desc = (struct _iscd_desc*)arg;
+
+	switch (desc->cfg.layout) {
+	case ISCD_LAYOUT_PACKED8:
+	case ISCD_LAYOUT_PACKED16:
+	case ISCD_LAYOUT_PACKED32:
+		_isc_dma_view_pool.view0[from].next_desc =
+			(uint32_t)&_isc_dma_view_pool.view0[to];
+		cache_clean_region(&_isc_dma_view_pool.view0[from],
+				sizeof(struct _isc_dma_view0));
+		break;
+	case ISCD_LAYOUT_YC420SP:
+	case ISCD_LAYOUT_YC422SP:
+		_isc_dma_view_pool.view1[from].next_desc =
+			(uint32_t)&_isc_dma_view_pool.view1[to];
+		cache_clean_region(&_isc_dma_view_pool.view1[from],
+				sizeof(struct _isc_dma_view1));
+		break;
+	default:
+		_isc_dma_view_pool.view2[from].next_desc =
+			(uint32_t)&_isc_dma_view_pool.view2[to];
+		cache_clean_region(&_isc_dma_view_pool.view2[from],
+				sizeof(struct _isc_dma_view2));
+		break;
+	}
+}
+
+/**
+ * \brief Read the buffer being written and the descriptor loaded next.
+ */
+static void _iscd_dma_state(void* arg, uint8_t* writing, uint8_t* next)
+{
+	struct _iscd_desc* desc = (struct _iscd_desc*)arg;
+	uint32_t address = isc_dma_get_address(0) - desc->dma.address0;
+	uint32_t entry = isc_dma_get_desc_entry();
+	uint32_t first, size;
+
+	switch (desc->cfg.layout) {
+	case ISCD_LAYOUT_PACKED8:
+	case ISCD_LAYOUT_PACKED16:
+	case ISCD_LAYOUT_PACKED32:
+		first = (uint32_t)_isc_dma_view_pool.view0;
+		size = sizeof(struct _isc_dma_view0);
+		break;
+	case ISCD_LAYOUT_YC420SP:
+	case ISCD_LAYOUT_YC422SP:
+		first = (uint32_t)_isc_dma_view_pool.view1;
+		size = sizeof(struct _isc_dma_view1);
+		break;
+	default:
+		first = (uint32_t)_isc_dma_view_pool.view2;
+		size = sizeof(struct _isc_dma_view2);
+		break;
+	}
+
+	*writing = 0xff;
+	if (address / desc->dma.size < desc->cfg.multi_bufs)
+		*writing = address / desc->dma.size;
+	*next = 0xff;
+	if ((entry - first) / size < desc->cfg.multi_bufs)
+		*next = (entry - first) / size;
+}
+
+/**
+ * \brief Hand the DMA descriptors over to the frame queue, if any.
+ */
+static void _iscd_configure_queue(struct _iscd_desc* desc)
+{
+	struct _frame_queue* queue = desc->dma.queue;
+	uint32_t i;
+
+	if (!queue)
+		return;
+
+	for (i = 0; i < desc->cfg.multi_bufs; i++) {
+		queue->frames[i].address[0] = desc->dma.address0 + i * desc->dma.size;
+		queue->frames[i].address[1] = desc->dma.address1 + i * desc->dma.size;
+		queue->frames[i].address[2] = desc->dma.address2 + i * desc->dma.size;
+	}
+	frame_queue_initialize(queue, desc->cfg.multi_bufs, _iscd_link_desc,
+			_iscd_dma_state, desc);
+}
+
 /**
  * \brief Setup DMA Descriptors.
  */
@@ -211,6 +314,7 @@ static uint8_t _iscd_configure_dma(struct _iscd_desc* desc)
 			dma_view0[i].stride = 0;
 		}
 		dma_view0[i - 1].next_desc = (uint32_t)&dma_view0[0];
+		_iscd_configure_queue(desc);
 		cache_clean_region(dma_view0, sizeof(struct _isc_dma_view0) * desc->cfg.multi_bufs);
 		isc_dma_configure_desc_entry((uint32_t)&dma_view0[0]);
 		isc_dma_configure_input_mode(ISC_DCFG_IMODE(desc->cfg.layout) |
@@ -232,6 +336,7 @@ static uint8_t _iscd_configure_dma(struct _iscd_desc* desc)
 			dma_view1[i].stride1 = 0;
 		}
 		dma_view1[i - 1].next_desc = (uint32_t)&dma_view1[0];
+		_iscd_configure_queue(desc);
 		cache_clean_region(dma_view1, sizeof(struct _isc_dma_view1) * desc->cfg.multi_bufs);
 		isc_dma_configure_desc_entry((uint32_t)&dma_view1[0]);
 		isc_dma_configure_input_mode(ISC_DCFG_IMODE(desc->cfg.layout) |
@@ -255,6 +360,7 @@ static uint8_t _iscd_configure_dma(struct _iscd_desc* desc)
 			dma_view2[i].stride2 = 0;
 		}
 		dma_view2[i - 1].next_desc = (uint32_t)&dma_view2[0];
+		_iscd_configure_queue(desc);
 		cache_clean_region(dma_view2, sizeof(struct _isc_dma_view2) * desc->cfg.multi_bufs);
 		isc_dma_configure_desc_entry((uint32_t)&dma_view2[0]);
 		isc_dma_configure_input_mode(ISC_DCFG_IMODE(desc->cfg.layout) |
@@ -362,6 +468,8 @@ uint8_t iscd_pipe_start(struct _iscd_desc* desc)
 
 		/* Default value for White balance setting */
 		isc_wb_adjust_bayer_color(0, 0, 0, 0, 0x200, 0x200, 0x200, 0x200);
+		if (desc->pipe.histo_enable)
+			_3a_initialize(desc);
 		isc_cbc_enabled(1);
 		/* Convert bright to signed 11 bits 1:10:0.
 			Convert contrast to unsigned 12 bits 0:4:8 */
@@ -416,7 +524,10 @@ uint8_t iscd_pipe_start(struct _iscd_desc* desc)
 
 	isc_update_profile();
 	irq_add_handler(ID_ISC, _isc_handler, desc);
-	isc_enable_interrupt(ISC_INTEN_VD | ISC_INTEN_HISDONE);
+	if (desc->dma.queue)
+		isc_enable_interrupt(ISC_INTEN_DDONE | ISC_INTEN_HISDONE);
+	else
+		isc_enable_interrupt(ISC_INTEN_VD | ISC_INTEN_HISDONE);
 	isc_interrupt_status();
 
 	irq_enable(ID_ISC);
@@ -426,7 +537,7 @@ uint8_t iscd_pipe_start(struct _iscd_desc* desc)
 }
 
 /**
- * \brief Image tuning for AWB, this is a reference algrothm only.
+ * \brief Image tuning for AWB and AE, this is a reference algrothm only.
  */
 void iscd_auto_white_balance_ref_algo(uint32_t* histo_buf)
 {
@@ -443,14 +554,13 @@ void iscd_auto_white_balance_ref_algo(uint32_t* histo_buf)
 		if (!awb.dma.dma_histo_ready)
 			break;
 		awb.dma.dma_histo_ready = false;
-		_iscd_dma_read_histogram((uint32_t)histo_buf);
+		_iscd_dma_read_histogram((uint32_t)&histo_buf[awb.op_mode * HIST_ENTRIES]);
 		awb.state = AWB_WAIT_DMA_READY;
 		break;
 	case AWB_WAIT_DMA_READY:
 		if (!awb.dma.dma_histo_done)
 			break;
 		awb.dma.dma_histo_done = false;
-		_awb_count_up(histo_buf);
 		awb.op_mode++;
 		if (awb.op_mode < BAYER_COUNT)
 			awb.state = AWB_INIT;
@@ -458,7 +568,7 @@ void iscd_auto_white_balance_ref_algo(uint32_t* histo_buf)
 			awb.state = AWB_WAIT_ISC_PERFORMED;
 		break;
 	case AWB_WAIT_ISC_PERFORMED:
-		_awb_update();
+		_3a_update(histo_buf);
 		awb.op_mode = 0;
 		awb.state = AWB_INIT;
 		break;
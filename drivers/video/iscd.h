@@ -39,6 +39,8 @@
 
 #include "callback.h"
 #include "dma/dma.h"
+#include "video/frame_queue.h"
+#include "video/isc_3a.h"
 
 /*------------------------------------------------------------------------------
  *        Definition
@@ -50,15 +52,6 @@
 /* GAMMA and HISTOGRAM definitions */
 #define GAMMA_ENTRIES (64)
 
-#define HISTOGRAM_GR (0)
-#define HISTOGRAM_R  (1)
-#define HISTOGRAM_GB (2)
-#define HISTOGRAM_B  (3)
-
-#define BAYER_COUNT (HISTOGRAM_B + 1)
-
-#define HIST_ENTRIES (512)
-
 #define ISCD_OK           (0)
 #define ISCD_ERROR_LOCK   (1)
 #define ISCD_ERROR_CONFIG (2)
@@ -121,7 +114,16 @@ struct _iscd_desc {
 		uint8_t bayer_color_filter;
 		enum _iscd_bayer_pattern bayer_pattern;
 		bool histo_enable;
+		/* BAYER_COUNT * HIST_ENTRIES entries, cache aligned */
 		uint32_t* histo_buf;
+		struct {
+			/* program the sensor exposure and gain from the
+			 * histograms, the sensor profile must provide
+			 * sensor_ae registers */
+			bool ae_enable;
+			uint8_t twi_bus;
+			const struct sensor_profile* sensor;
+		} ae;
 		struct _color_space* cs;
 		struct {
 			bool gamma_enable;
@@ -146,6 +148,9 @@ struct _iscd_desc {
 		uint32_t address2;
 		uint32_t size;
 		iscd_callback_t callback;
+		/* optional: frames are published to this queue at the end of
+		 * their capture, and buffers held by consumers are skipped */
+		struct _frame_queue* queue;
 	} dma;
 };
 
@@ -155,8 +160,9 @@ struct _iscd_awb {
 		bool dma_histo_ready;
 		bool dma_histo_done;
 	} dma;
-	uint32_t backup[BAYER_COUNT];
-	uint32_t count[BAYER_COUNT];
+	struct _isc_3a ctx;
+	uint8_t twi_bus;
+	const struct sensor_profile* sensor;
 	uint32_t op_mode;
 	enum _iscd_awb_state state;
 };
@@ -167,6 +173,12 @@ struct _iscd_awb {
 
 extern uint8_t iscd_pipe_start(struct _iscd_desc* desc);
 
+/**
+ * \brief Run the auto white balance and auto exposure state machine, to be
+ * called repeatedly from the main loop. One histogram is read per frame, the
+ * gains are updated once the four Bayer histograms have been read.
+ * \param histo_buf histogram buffer, BAYER_COUNT * HIST_ENTRIES entries
+ */
 extern void iscd_auto_white_balance_ref_algo(uint32_t* histo_buf);
 
 #endif /* ISCD_H_ */
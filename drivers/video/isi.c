@@ -371,6 +371,18 @@ void isi_set_dma_preview_path(uint32_t descriptor_address,
 	ISI->ISI_DMA_P_ADDR = frame_buffer_address;
 }
 
+/**
+ * \brief Get the DMA state of the Preview path.
+ * \param descriptor_address  Next Preview Descriptor Address.
+ * \param frame_buffer_address  Frame Buffer being written.
+ */
+void isi_get_dma_preview_path(uint32_t* descriptor_address,
+                              uint32_t* frame_buffer_address)
+{
+	*descriptor_address = ISI->ISI_DMA_P_DSCR;
+	*frame_buffer_address = ISI->ISI_DMA_P_ADDR;
+}
+
 /**
  * \brief Configure DMA for Codec path.
  * \param descriptor_address  Preview Descriptor Address.
@@ -386,6 +398,18 @@ void isi_set_dma_codec_path(uint32_t descriptor_address,
 	ISI->ISI_DMA_C_ADDR = frame_buffer_address;
 }
 
+/**
+ * \brief Get the DMA state of the Codec path.
+ * \param descriptor_address  Next Codec Descriptor Address.
+ * \param frame_buffer_address  Frame Buffer being written.
+ */
+void isi_get_dma_codec_path(uint32_t* descriptor_address,
+                            uint32_t* frame_buffer_address)
+{
+	*descriptor_address = ISI->ISI_DMA_C_DSCR;
+	*frame_buffer_address = ISI->ISI_DMA_C_ADDR;
+}
+
 /**
  * \brief ISI set matrix for YUV to RGB color space for preview path.
  * \param yuv2rgb structure of YUV to RBG parameters.
@@ -166,9 +166,15 @@ extern void isi_calc_scaler_factor( void );
 extern void isi_set_dma_preview_path(uint32_t descriptor_address,
 		uint32_t descriptor_dma_control, uint32_t frame_buffer_address);
 
+extern void isi_get_dma_preview_path(uint32_t* descriptor_address,
+		uint32_t* frame_buffer_address);
+
 extern void isi_set_dma_codec_path(uint32_t descriptor_address,
 		uint32_t descriptor_dma_control, uint32_t frame_buffer_address);
 
+extern void isi_get_dma_codec_path(uint32_t* descriptor_address,
+		uint32_t* frame_buffer_address);
+
 extern void isi_set_matrix_yuv2rgb(struct _isi_yuv2rgb *yuv2rgb);
 extern void isi_set_matrix_rgb2yuv(struct _isi_rgb2yuv *rgb2yuv);
 
@@ -56,8 +56,23 @@ struct _isid_desc* isid;
 static void _isi_handler(uint32_t source, void* arg)
 {
 	uint32_t status;
+	uint32_t done;
+	struct _frame* frame;
 
 	status = isi_get_status();
+	if (isid->dma.queue) {
+		done = (isid->pipe.pipe == ISID_PIPE_CODEC) ?
+			ISI_SR_CXFR_DONE : ISI_SR_PXFR_DONE;
+		if ((status & done) == done) {
+			frame = frame_queue_capture_done(isid->dma.queue);
+			if (frame) {
+				isid->pipe.frame_idx = frame->index;
+				if (isid->dma.callback)
+					isid->dma.callback(frame->index);
+			}
+		}
+		return;
+	}
 	if ((status & ISI_SR_PXFR_DONE) == ISI_SR_PXFR_DONE) {
 		if (isid->pipe.frame_idx == (isid->cfg.multi_bufs - 1))
 			isid->pipe.frame_idx = 0;
@@ -71,6 +86,58 @@ static void _isi_handler(uint32_t source, void* arg)
 	}
 }
 
+/**
+ * \brief Link the DMA descriptor of a buffer to the one of another buffer.
+ */
+static void _isid_link_desc(void* arg, uint8_t from, uint8_t to)
+{
+	struct _isi_dma_desc* dma_desc = (struct _isi_dma_desc*)arg;
+
+	dma_desc[from].next = (uint32_t)&dma_desc[to];
+	cache_clean_region(&dma_desc[from], sizeof(struct _isi_dma_desc));
+}
+
+/**
+ * \brief Read the buffer being written and the descriptor loaded next.
+ */
+static void _isid_dma_state(void* arg, uint8_t* writing, uint8_t* next)
+{
+	struct _isi_dma_desc* dma_desc = (struct _isi_dma_desc*)arg;
+	uint32_t entry, address, size;
+
+	if (dma_desc == _isi_dma_codec) {
+		isi_get_dma_codec_path(&entry, &address);
+		size = isid->dma.size_c;
+	} else {
+		isi_get_dma_preview_path(&entry, &address);
+		size = isid->dma.size_p;
+	}
+	address -= dma_desc[0].address;
+	entry -= (uint32_t)dma_desc;
+
+	*writing = 0xff;
+	if (address / size < isid->cfg.multi_bufs)
+		*writing = address / size;
+	*next = 0xff;
+	if (entry / sizeof(struct _isi_dma_desc) < isid->cfg.multi_bufs)
+		*next = entry / sizeof(struct _isi_dma_desc);
+}
+
+/**
+ * \brief Hand the DMA descriptors of a path over to the frame queue.
+ */
+static void _isid_configure_queue(struct _isid_desc* desc,
+		struct _isi_dma_desc* dma_desc, uint32_t address, uint32_t size)
+{
+	struct _frame_queue* queue = desc->dma.queue;
+	uint32_t i;
+
+	for (i = 0; i < desc->cfg.multi_bufs; i++)
+		queue->frames[i].address[0] = address + i * size;
+	frame_queue_initialize(queue, desc->cfg.multi_bufs, _isid_link_desc,
+			_isid_dma_state, dma_desc);
+}
+
 /**
  * \brief Set up DMA Descriptors.
  */
@@ -91,6 +158,9 @@ static uint8_t _isid_configure_dma(struct _isid_desc* desc)
 		/* Wrapping to first FBD */
 		_isi_dma_preview[i - 1].next = (uint32_t)_isi_dma_preview;
 		cache_clean_region(_isi_dma_preview, sizeof(_isi_dma_preview));
+		if (desc->dma.queue)
+			_isid_configure_queue(desc, _isi_dma_preview,
+					desc->dma.address_p, desc->dma.size_p);
 	}
 	if (desc->pipe.pipe != ISID_PIPE_PREVIEW) {
 		for(i = 0; i < desc->cfg.multi_bufs; i++) {
@@ -101,6 +171,9 @@ static uint8_t _isid_configure_dma(struct _isid_desc* desc)
 		}
 		_isi_dma_codec[i - 1].next = (uint32_t)_isi_dma_codec;
 		cache_clean_region(_isi_dma_codec, sizeof(_isi_dma_codec));
+		if (desc->dma.queue && desc->pipe.pipe == ISID_PIPE_CODEC)
+			_isid_configure_queue(desc, _isi_dma_codec,
+					desc->dma.address_c, desc->dma.size_c);
 	}
 	return ISID_OK;
 }
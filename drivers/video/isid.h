@@ -37,6 +37,8 @@
 
 #include <stdint.h>
 
+#include "video/frame_queue.h"
+
 /*------------------------------------------------------------------------------
  *        Definition
  *----------------------------------------------------------------------------*/
@@ -100,6 +102,10 @@ struct _isid_desc {
 		uint32_t size_c;
 		isid_callback_t callback;
 		void* cb_args;
+		/* optional: frames of the preview path (codec path if
+		 * ISID_PIPE_CODEC) are published to this queue at the end of
+		 * their capture, and buffers held by consumers are skipped */
+		struct _frame_queue* queue;
 	} dma;
 };
 
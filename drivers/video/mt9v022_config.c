@@ -243,5 +243,7 @@ const struct sensor_profile mt9v022_profile = {
 		0,
 		0,
 		0
-	}
+	},
+	0,                               /* TWI flags */
+	NULL,                            /* Exposure and gain control */
 };
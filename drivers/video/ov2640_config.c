@@ -57,6 +57,7 @@
 static const struct sensor_reg ov2640_yuv_qvga[] = {
 	{0xff, 0x01},
 	{0x12, 0x80},
+	{SENSOR_REG_DELAY, 5},
 	{0xff, 0x00},
 	{0x2c, 0xff},
 	{0x2e, 0xdf},
@@ -287,6 +288,7 @@ static const struct sensor_reg ov2640_yuv_qvga[] = {
 static const struct sensor_reg ov2640_raw_qvga[] = {
 	{0xff, 0x01},
 	{0x12, 0x80},
+	{SENSOR_REG_DELAY, 5},
 	{0xff, 0x00},
 	{0x2c, 0xff},
 	{0x2e, 0xdf},
@@ -517,6 +519,7 @@ static const struct sensor_reg ov2640_raw_qvga[] = {
 static const struct sensor_reg ov2640_yuv_vga[] = {
 	{0xff, 0x01}, //dsp
 	{0x12, 0x80}, //reset
+	{SENSOR_REG_DELAY, 5},
 	{0xff, 0x00}, //sensor
 	{0x2c, 0xff},
 	{0x2e, 0xdf}, //ADDVSH, VSYNC msb=223
@@ -780,5 +783,7 @@ const struct sensor_profile ov2640_profile =
 		0,
 		0,
 		0
-	}
+	},
+	0,                               /* TWI flags */
+	NULL,                            /* Exposure and gain control */
 };
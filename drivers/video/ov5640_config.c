@@ -56,7 +56,7 @@
 static const struct sensor_reg ov5640_raw_qvga[] = {
 	{0x3103, 0x11},
 	{0x3008, 0x82},
-	{0xFFFF, 0x05},
+	{SENSOR_REG_DELAY, 0x05},
 	{0x3008, 0x42},
 	{0x3103, 0x03},
 	{0x3017, 0xff},
@@ -187,7 +187,7 @@ static const struct sensor_reg ov5640_raw_qvga[] = {
 static const struct sensor_reg ov5640_yuv_qvga[] = {
 	{0x3103, 0x11},
 	{0x3008, 0x82},
-	{0xFFFF, 0x05},
+	{SENSOR_REG_DELAY, 0x05},
 	{0x3008, 0x42},
 	{0x3103, 0x03},
 	{0x3017, 0xff},
@@ -490,7 +490,7 @@ static const struct sensor_reg ov5640_yuv_qvga[] = {
 static const struct sensor_reg ov5640_yuv_vga[] = {
 	{0x3103, 0x11},
 	{0x3008, 0x82},
-	{0xFFFF, 0x05},
+	{SENSOR_REG_DELAY, 0x05},
 	{0x3008, 0x42},
 	{0x3103, 0x03},
 	{0x3017, 0xff},
@@ -790,7 +790,7 @@ static const struct sensor_reg ov5640_yuv_vga[] = {
 static const struct sensor_reg ov5640_yuv_wxga[] = {
 	{0x3103, 0x11},
 	{0x3008, 0x82},
-	{0xFFFF, 0x05},
+	{SENSOR_REG_DELAY, 0x05},
 	{0x3008, 0x42},
 	{0x3103, 0x03},
 	{0x3017, 0xff},
@@ -5254,6 +5254,23 @@ static const struct sensor_output ov5640_output_wxga =
 static const struct sensor_output ov5640_output_af =
 { 1, 0, 0, 0, 1, 0, 0, ov5640_afc };
 
+/* Manual exposure and gain, AEC/AGC disabled */
+static const struct sensor_reg ov5640_ae_manual[] = {
+	{0x3503, 0x03},
+	{0xFF, 0xFF}
+};
+
+static const struct sensor_ae ov5640_ae =
+{
+	0x3500, 3, 4,                    /* Exposure, 1/16 line in [19:0] */
+	1,                               /* Minimum exposure, in lines */
+	1000,                            /* Maximum exposure, in lines */
+	0x350A, 2, 0,                    /* Gain, 4.4 fixed point in [9:0] */
+	0x10,                            /* Register value for 1x gain */
+	0x3FF,                           /* Maximum gain */
+	ov5640_ae_manual
+};
+
 const struct sensor_profile ov5640_profile =
 {
 	"OV5640",
@@ -5273,5 +5290,7 @@ const struct sensor_profile ov5640_profile =
 		&ov5640_output_af,
 		0,
 		0
-	}
+	},
+	SENSOR_REGS_AUTO_INCREMENT,      /* TWI flags */
+	&ov5640_ae,                      /* Exposure and gain control */
 };
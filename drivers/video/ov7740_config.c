@@ -57,6 +57,7 @@
 static const struct sensor_reg ov7740_yuv_vga[] = {
 
 	{0x12, 0x80},
+	{SENSOR_REG_DELAY, 5},
 	/* flag for soft reset delay */
 	{0x55 ,0x40},
 
@@ -204,6 +205,7 @@ static const struct sensor_reg ov7740_yuv_vga[] = {
  */
 static const struct sensor_reg ov7740_qvga_yuv[] = {
 	{0x12, 0x80},
+	{SENSOR_REG_DELAY, 5},
 	/* flag for soft reset delay */
 	{0x55 ,0x40},
 
@@ -358,6 +360,7 @@ static const struct sensor_reg ov7740_qvga_yuv[] = {
  */
 static const struct sensor_reg ov7740_qvga_raw[] = {
 	{0x12, 0x80},
+	{SENSOR_REG_DELAY, 5},
 	/* flag for soft reset delay */
 	{0x55 ,0x40},
 
@@ -531,5 +534,7 @@ const struct sensor_profile ov7740_profile =
 		0,
 		0,
 		0
-	}
+	},
+	0,                               /* TWI flags */
+	NULL,                            /* Exposure and gain control */
 };
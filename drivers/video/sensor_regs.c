@@ -0,0 +1,154 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file
+ *
+ * Compiler for image sensor register lists.  This file has no dependency on
+ * the target and is also used by the host tools.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "errno.h"
+#include "video/sensor_regs.h"
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define SENSOR_REGS_HDR_SIZE 4
+
+#define SENSOR_REGS_ALIGN(len) (((len) + 3) & ~3u)
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static inline int sensor_regs_is_term(const struct sensor_reg* r)
+{
+	return (r->reg == SENSOR_REG_TERM) && (r->val == SENSOR_VAL_TERM);
+}
+
+static void sensor_regs_put_header(uint8_t* out, uint8_t op, uint16_t arg)
+{
+	out[0] = op;
+	out[1] = 0;
+	out[2] = arg & 0xff;
+	out[3] = arg >> 8;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+int sensor_regs_compile(const struct sensor_reg* list, uint8_t twi_mode,
+			uint8_t flags, uint8_t* out, uint32_t size,
+			const struct sensor_reg** next)
+{
+	uint32_t addr_len = (twi_mode == SENSOR_TWI_REG_2BYTE_DATA_BYTE) ? 2 : 1;
+	uint32_t data_len = (twi_mode == SENSOR_TWI_REG_BYTE_DATA_2BYTE) ? 2 : 1;
+	uint32_t max_regs = (flags & SENSOR_REGS_AUTO_INCREMENT) ?
+		SENSOR_REGS_BURST_MAX / data_len : 1;
+	const struct sensor_reg* r = list;
+	uint32_t pos = 0;
+
+	/* room for the smallest write and the end record */
+	if (size < 2 * SENSOR_REGS_HDR_SIZE + SENSOR_REGS_ALIGN(addr_len + data_len))
+		return -ENOSPC;
+	size -= SENSOR_REGS_HDR_SIZE;
+
+	while (!sensor_regs_is_term(r)) {
+		if (r->reg == SENSOR_REG_DELAY) {
+			uint32_t delay = 0;
+
+			if (pos + SENSOR_REGS_HDR_SIZE > size)
+				break;
+			/* merge consecutive delays */
+			while (r->reg == SENSOR_REG_DELAY &&
+			       delay + r->val <= 0xffff) {
+				delay += r->val;
+				r++;
+			}
+			sensor_regs_put_header(&out[pos], SENSOR_REGS_OP_DELAY,
+					       delay);
+			pos += SENSOR_REGS_HDR_SIZE;
+		} else {
+			uint32_t count, len, i;
+			uint8_t* msg;
+
+			/* count registers merged in this transaction */
+			for (count = 1; count < max_regs; count++) {
+				if (sensor_regs_is_term(&r[count]) ||
+				    r[count].reg == SENSOR_REG_DELAY ||
+				    r[count].reg != r[0].reg + count)
+					break;
+			}
+			len = addr_len + count * data_len;
+			if (pos + SENSOR_REGS_HDR_SIZE +
+			    SENSOR_REGS_ALIGN(len) > size) {
+				if (pos)
+					break;
+				/* shorten the burst to fit the buffer */
+				count = (size - SENSOR_REGS_HDR_SIZE - addr_len)
+					/ data_len;
+				len = addr_len + count * data_len;
+			}
+
+			sensor_regs_put_header(&out[pos], SENSOR_REGS_OP_WRITE,
+					       len);
+			msg = &out[pos + SENSOR_REGS_HDR_SIZE];
+			if (addr_len == 2)
+				*msg++ = (r->reg >> 8) & 0xff;
+			*msg++ = r->reg & 0xff;
+			for (i = 0; i < count; i++, r++) {
+				/* 16-bit values are sent low byte first, as
+				 * stored in memory */
+				*msg++ = r->val & 0xff;
+				if (data_len == 2)
+					*msg++ = r->val >> 8;
+			}
+			for (i = len; i < SENSOR_REGS_ALIGN(len); i++)
+				*msg++ = 0;
+			pos += SENSOR_REGS_HDR_SIZE + SENSOR_REGS_ALIGN(len);
+		}
+	}
+
+	sensor_regs_put_header(&out[pos], SENSOR_REGS_OP_END, 0);
+	pos += SENSOR_REGS_HDR_SIZE;
+
+	if (next)
+		*next = sensor_regs_is_term(r) ? NULL : r;
+
+	return pos;
+}
@@ -0,0 +1,120 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef SENSOR_REGS_H
+#define SENSOR_REGS_H
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*---------------------------------------------------------------------------
+ *         Definitions
+ *---------------------------------------------------------------------------*/
+
+/** terminating list entry for register in configuration file */
+#define SENSOR_REG_TERM         0xFF
+/** terminating list entry for value in configuration file */
+#define SENSOR_VAL_TERM         0xFF
+/** pseudo-register for a delay entry, the value is the delay in ms */
+#define SENSOR_REG_DELAY        0xFFFF
+
+/** Sensor register table flags */
+/** the sensor increments the register address after each write */
+#define SENSOR_REGS_AUTO_INCREMENT  (1 << 0)
+
+/** Maximum number of data bytes merged in one write transaction */
+#define SENSOR_REGS_BURST_MAX   64
+
+/**
+ * Compiled register table opcodes.
+ *
+ * A compiled table is a sequence of records, each starting with a 4-byte
+ * header: opcode, 0, 16-bit little-endian argument.
+ * - SENSOR_REGS_OP_WRITE: the argument is the length of the TWI message
+ *   (register address followed by the data) which follows the header, padded
+ *   to a multiple of 4 bytes;
+ * - SENSOR_REGS_OP_DELAY: the argument is a delay in ms;
+ * - SENSOR_REGS_OP_END: end of table.
+ * Messages are 4-byte aligned if the table is, so that they can be sent by
+ * DMA without any copy.
+ */
+enum {
+	SENSOR_REGS_OP_END = 0,
+	SENSOR_REGS_OP_WRITE,
+	SENSOR_REGS_OP_DELAY,
+};
+
+/** Sensor TWI mode */
+enum {
+	SENSOR_TWI_REG_BYTE_DATA_BYTE = 0,
+	SENSOR_TWI_REG_2BYTE_DATA_BYTE,
+	SENSOR_TWI_REG_BYTE_DATA_2BYTE
+};
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** define a structure for sensor register initialization values */
+struct sensor_reg {
+	uint16_t reg; /* Register to be written */
+	uint16_t val; /* value to be written */
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Compile a register list into write transactions and delays.
+ *
+ * Consecutive registers are merged in one transaction if the
+ * SENSOR_REGS_AUTO_INCREMENT flag is set, SENSOR_REG_DELAY entries become
+ * delay records.  If the output buffer is too small for the whole list, the
+ * compiled part is ended with a SENSOR_REGS_OP_END record and '*next' points
+ * to the first entry left, so that compilation can be resumed from there.
+ * '*next' is set to NULL once the list terminator has been reached.
+ *
+ * \param list     Register list, terminated by SENSOR_REG_TERM/SENSOR_VAL_TERM
+ * \param twi_mode Sensor TWI mode (SENSOR_TWI_REG_xxx)
+ * \param flags    SENSOR_REGS_xxx flags
+ * \param out      Output buffer, should be 4-byte aligned
+ * \param size     Size of the output buffer
+ * \param next     Set to the first entry left, or NULL
+ * \return number of bytes written in out, or -ENOSPC if the buffer cannot
+ * hold a single transaction.
+ */
+extern int sensor_regs_compile(const struct sensor_reg* list, uint8_t twi_mode,
+			       uint8_t flags, uint8_t* out, uint32_t size,
+			       const struct sensor_reg** next);
+
+#endif /* ! SENSOR_REGS_H */
@@ -0,0 +1,856 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \page audio_dsp_bench Audio Processing Benchmark
+ *
+ * \section Purpose
+ *
+ * This example checks and measures the audio processing library
+ * (audio_dsp.h): sample rate conversion, mixing, volume and format
+ * conversion.
+ *
+ * \section Requirements
+ *
+ * This package can be used with all SAMA5D2x, SAMA5D3x, SAMA5D4x and SAM9xx5
+ * boards, no audio device is used.  It can also be compiled for a Linux host
+ * with Makefile.linux, in which case the portable implementation is measured
+ * and WAV files can be processed.
+ *
+ * \section Description
+ *
+ * Format conversions, mixing and volume are first checked against
+ * straightforward reference code, and the resampler is checked to give the
+ * same output whatever the size of the blocks it is fed with.  Then the
+ * THD+N of a 997 Hz tone is measured after sample rate conversion for usual
+ * rate pairs and for a clock drift, and the throughput of each function is
+ * printed, in samples per second.
+ *
+ * On a Linux host, "./audio_dsp_bench in.wav out.wav rate [tone]" resamples
+ * a 16, 24 or 32-bit PCM WAV file to 16 bits at the given rate, prints the
+ * processing speed and, when the frequency of a test tone is given, the
+ * THD+N of the input and of the output.
+ *
+ * \section Usage
+ *
+ * -# Build the program and download it inside the board.
+ * -# On the computer, open and configure a terminal application
+ *    (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *   - 115200 baud rate
+ *   - 8 bits of data
+ *   - No parity
+ *   - 1 stop bit
+ *   - No flow control
+ * -# Start the application, the results are printed on the console.
+ * -# To run it on a Linux computer, run "make -f Makefile.linux" and
+ *    "./audio_dsp_bench" in the example directory.
+ *
+ * \section References
+ * - audio_dsp_bench/main.c
+ * - audio_dsp.h
+ * - perf.h
+ */
+
+/** \file
+ *
+ *  This file contains all the specific code for the audio processing
+ *  benchmark.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "audio_dsp.h"
+#include "compiler.h"
+#include "perf.h"
+
+#ifdef CONFIG_ARCH_ARM
+#include "board.h"
+#include "chip.h"
+#include "trace.h"
+
+#include "serial/console.h"
+#else
+#include <stdlib.h>
+
+#include "wav.h"
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Frequency of the test tone, in Hz */
+#define TONE_FREQ 997
+
+/** Amplitude of the test tone (-1 dBFS) */
+#define TONE_AMPLITUDE 29204.0
+
+/** Number of output frames analysed for THD+N */
+#define TONE_FRAMES 8192
+
+/** Input frames available for the tone (ratio up to 4) */
+#define TONE_IN_FRAMES (4 * (TONE_FRAMES + 2 * CONFIG_AUDIO_DSP_RS_TAPS))
+
+/** Highest THD+N accepted, in dB */
+#define MAX_THDN_DB (-74.0)
+
+/** Frames per benchmark run (100 ms at 48 kHz) */
+#define BENCH_FRAMES 4800
+
+/** Number of measured runs per benchmark */
+#define BENCH_RUNS 10
+
+/** Number of streams of the mixing benchmark */
+#define BENCH_STREAMS 4
+
+#define PI 3.14159265358979323846
+
+/*----------------------------------------------------------------------------
+ *        Local types
+ *----------------------------------------------------------------------------*/
+
+struct _rate_pair {
+	uint32_t in;
+	uint32_t out;
+	int32_t drift;  /**< ppb */
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static struct _audio_dsp_resampler rs;
+static struct _audio_dsp_resampler rs_ref;
+static struct _audio_dsp_volume vol;
+
+static int16_t tone_in[TONE_IN_FRAMES];
+static int16_t tone_out[TONE_FRAMES + 4 * CONFIG_AUDIO_DSP_RS_TAPS];
+static int16_t tone_ref[TONE_FRAMES + 4 * CONFIG_AUDIO_DSP_RS_TAPS];
+
+static int16_t stream[BENCH_STREAMS][BENCH_FRAMES * 2];
+static int16_t mix_out[BENCH_FRAMES * 2];
+static int32_t wide[BENCH_FRAMES * 2];
+static int16_t rs_out[4 * BENCH_FRAMES * 2];
+
+static const struct _rate_pair rate_pairs[] = {
+	{ 48000, 48000, 100000 },
+	{ 48000, 48000, -250000 },
+	{ 44100, 48000, 0 },
+	{ 48000, 44100, 0 },
+	{ 16000, 48000, 0 },
+	{ 48000, 16000, 0 },
+	{ 32000, 44100, 0 },
+};
+
+static uint32_t rand_state = 1;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint32_t _rand(void)
+{
+	rand_state = rand_state * 1103515245 + 12345;
+	return rand_state >> 8;
+}
+
+static int16_t _rand_sample(void)
+{
+	/* some full scale values to check the saturation */
+	switch (_rand() % 16) {
+	case 0:
+		return INT16_MAX;
+	case 1:
+		return INT16_MIN;
+	default:
+		return (int16_t)_rand();
+	}
+}
+
+static int16_t _sat16(int32_t v)
+{
+	return v > INT16_MAX ? INT16_MAX : v < INT16_MIN ? INT16_MIN : v;
+}
+
+/**
+ * \brief sin and cos without libm (Taylor series, |x| <= pi)
+ */
+static void _sincos(double x, double* s, double* c)
+{
+	double x2, sh, ch;
+
+	/* half angle, then double it */
+	x /= 2;
+	x2 = x * x;
+	sh = x * (1 - x2 / 6 * (1 - x2 / 20 * (1 - x2 / 42 * (1 - x2 / 72
+		* (1 - x2 / 110 * (1 - x2 / 156))))));
+	ch = 1 - x2 / 2 * (1 - x2 / 12 * (1 - x2 / 30 * (1 - x2 / 56
+		* (1 - x2 / 90 * (1 - x2 / 132)))));
+	*s = 2 * sh * ch;
+	*c = ch * ch - sh * sh;
+}
+
+/**
+ * \brief 10 * log10(x) without libm
+ */
+static double _db(double x)
+{
+	double z, z2, ln = 0.0;
+	int e = 0, k;
+
+	if (x <= 0.0)
+		return -999.0;
+	while (x >= 2.0) {
+		x /= 2;
+		e++;
+	}
+	while (x < 1.0) {
+		x *= 2;
+		e--;
+	}
+	/* ln(x) = 2 atanh((x - 1) / (x + 1)) */
+	z = (x - 1) / (x + 1);
+	z2 = z * z;
+	for (k = 19; k >= 1; k -= 2)
+		ln = ln * z2 + 1.0 / k;
+	ln = 2 * z * ln;
+	return 10 * (e * 0.69314718055994531 + ln) / 2.30258509299404568;
+}
+
+/**
+ * \brief Generate a tone with a rotating phasor
+ */
+static void _tone(int16_t* buf, uint32_t frames, double w, double amplitude)
+{
+	double s, c, x = 0.0, y = amplitude, t;
+	uint32_t i;
+
+	_sincos(w, &s, &c);
+	for (i = 0; i < frames; i++) {
+		buf[i] = (int16_t)(y >= 0 ? y + 0.5 : y - 0.5);
+		t = x * c + y * s;
+		y = y * c - x * s;
+		x = t;
+	}
+}
+
+/**
+ * \brief THD+N of a tone of known frequency, after a least squares fit of
+ * the tone and of the DC offset
+ * \param x       Samples
+ * \param frames  Number of frames
+ * \param stride  Samples per frame
+ * \param w       Tone frequency, in radians per frame
+ * \return THD+N in dB
+ */
+static double _thdn(const int16_t* x, uint32_t frames, uint8_t stride,
+		double w)
+{
+	/* normal equations of the fit of [1, cos, sin] */
+	double m[3][4], basis[3], s, c, t, res = 0, sig = 0, coef[3];
+	uint32_t i;
+	int r, k, l;
+
+	memset(m, 0, sizeof(m));
+	_sincos(w, &s, &c);
+	basis[0] = 1.0;
+	basis[1] = 1.0;
+	basis[2] = 0.0;
+	for (i = 0; i < frames; i++) {
+		for (r = 0; r < 3; r++) {
+			for (k = 0; k < 3; k++)
+				m[r][k] += basis[r] * basis[k];
+			m[r][3] += basis[r] * x[i * stride];
+		}
+		t = basis[1] * c - basis[2] * s;
+		basis[2] = basis[2] * c + basis[1] * s;
+		basis[1] = t;
+	}
+
+	/* Gauss-Jordan elimination, the matrix is positive definite */
+	for (r = 0; r < 3; r++) {
+		for (k = 0; k < 3; k++) {
+			if (k == r)
+				continue;
+			t = m[k][r] / m[r][r];
+			for (l = r; l < 4; l++)
+				m[k][l] -= t * m[r][l];
+		}
+	}
+	for (r = 0; r < 3; r++)
+		coef[r] = m[r][3] / m[r][r];
+
+	basis[1] = 1.0;
+	basis[2] = 0.0;
+	for (i = 0; i < frames; i++) {
+		double fit = coef[1] * basis[1] + coef[2] * basis[2];
+		double e = x[i * stride] - coef[0] - fit;
+		res += e * e;
+		sig += fit * fit;
+		t = basis[1] * c - basis[2] * s;
+		basis[2] = basis[2] * c + basis[1] * s;
+		basis[1] = t;
+	}
+	return _db(res / sig);
+}
+
+/*
+ * Functional checks
+ */
+
+static uint32_t _check_convert(void)
+{
+	static const enum _audio_dsp_format formats[] = {
+		AUDIO_DSP_S24, AUDIO_DSP_S24_32, AUDIO_DSP_S32
+	};
+	static const struct {
+		int32_t in;
+		int16_t out;
+	} rounding[] = {
+		{ INT32_MAX, INT16_MAX }, { INT32_MIN, INT16_MIN },
+		{ 0x8000, 1 }, { 0x7fff, 0 }, { -0x8000, 0 }, { -0x8001, -1 },
+	};
+	int16_t src[64 * 2], back[64 * 2], mono[64];
+	int32_t w32[64 * 2];
+	uint8_t w24[64 * 2 * 3];
+	uint32_t errors = 0, i, f;
+
+	for (i = 0; i < ARRAY_SIZE(src); i++)
+		src[i] = _rand_sample();
+
+	/* widening then narrowing is lossless */
+	for (f = 0; f < ARRAY_SIZE(formats); f++) {
+		void* wide_buf = formats[f] == AUDIO_DSP_S24 ?
+			(void*)w24 : (void*)w32;
+		audio_dsp_convert(wide_buf, formats[f], 2, src, AUDIO_DSP_S16,
+				2, 64);
+		memset(back, 0, sizeof(back));
+		audio_dsp_convert(back, AUDIO_DSP_S16, 2, wide_buf, formats[f],
+				2, 64);
+		if (memcmp(back, src, sizeof(src)))
+			errors++;
+	}
+
+	/* rounding and saturation to 16 bits */
+	for (i = 0; i < ARRAY_SIZE(rounding); i++) {
+		int16_t out;
+		audio_dsp_convert(&out, AUDIO_DSP_S16, 1, &rounding[i].in,
+				AUDIO_DSP_S32, 1, 1);
+		if (out != rounding[i].out)
+			errors++;
+	}
+
+	/* mono to stereo and back */
+	audio_dsp_convert(back, AUDIO_DSP_S16, 2, src, AUDIO_DSP_S16, 1, 64);
+	for (i = 0; i < 64; i++)
+		if (back[2 * i] != src[i] || back[2 * i + 1] != src[i])
+			errors++;
+	audio_dsp_convert(mono, AUDIO_DSP_S16, 1, back, AUDIO_DSP_S16, 2, 64);
+	if (memcmp(mono, src, sizeof(mono)))
+		errors++;
+
+	/* stereo to mono averages the channels */
+	audio_dsp_convert(mono, AUDIO_DSP_S16, 1, src, AUDIO_DSP_S16, 2, 64);
+	for (i = 0; i < 64; i++) {
+		/* halves are rounded up */
+		if (mono[i] != (src[2 * i] + src[2 * i + 1] + 1) >> 1)
+			errors++;
+	}
+
+	if (audio_dsp_convert(back, AUDIO_DSP_S16, 2, src, AUDIO_DSP_S16, 3,
+			1) == 0)
+		errors++;
+
+	printf("-I- Format conversion: %u error(s)\r\n", (unsigned)errors);
+	return errors;
+}
+
+static uint32_t _check_mix(void)
+{
+	static const uint16_t gains[3] = { AUDIO_DSP_UNITY, 16384, 5000 };
+	const int16_t* srcs[3] = { stream[0], stream[1], stream[2] };
+	const int32_t* srcs32[2] = { wide, wide + BENCH_FRAMES };
+	int32_t out32[BENCH_FRAMES];
+	uint32_t errors = 0, i;
+
+	for (i = 0; i < BENCH_FRAMES * 2; i++) {
+		stream[0][i] = _rand_sample();
+		stream[1][i] = _rand_sample();
+		stream[2][i] = _rand_sample();
+		wide[i] = (int32_t)(_rand() << 8);
+	}
+
+	/* odd length to exercise the tails of the vector kernels */
+	memcpy(mix_out, stream[0], sizeof(mix_out));
+	audio_dsp_add_s16(mix_out, stream[1], BENCH_FRAMES * 2 - 3);
+	for (i = 0; i < BENCH_FRAMES * 2 - 3; i++)
+		if (mix_out[i] != _sat16(stream[0][i] + stream[1][i]))
+			errors++;
+
+	audio_dsp_mix_s16(mix_out, srcs, NULL, 2, BENCH_FRAMES * 2);
+	for (i = 0; i < BENCH_FRAMES * 2; i++)
+		if (mix_out[i] != _sat16(stream[0][i] + stream[1][i]))
+			errors++;
+
+	audio_dsp_mix_s16(mix_out, srcs, gains, 3, BENCH_FRAMES * 2);
+	for (i = 0; i < BENCH_FRAMES * 2; i++) {
+		int64_t acc = (int64_t)stream[0][i] * gains[0] +
+			(int64_t)stream[1][i] * gains[1] +
+			(int64_t)stream[2][i] * gains[2];
+		if (mix_out[i] != _sat16((int32_t)((acc + 0x4000) >> 15)))
+			errors++;
+	}
+
+	audio_dsp_mix_s32(out32, srcs32, NULL, 2, BENCH_FRAMES);
+	for (i = 0; i < BENCH_FRAMES; i++) {
+		int64_t acc = (int64_t)wide[i] + wide[BENCH_FRAMES + i];
+		if (acc > INT32_MAX)
+			acc = INT32_MAX;
+		if (acc < INT32_MIN)
+			acc = INT32_MIN;
+		if (out32[i] != acc)
+			errors++;
+	}
+
+	printf("-I- Mixing: %u error(s)\r\n", (unsigned)errors);
+	return errors;
+}
+
+static uint32_t _check_volume(void)
+{
+	static const struct {
+		int16_t db;
+		uint16_t gain;
+	} db_gains[] = {
+		{ 0, 32768 }, { -6 * 256, 16423 }, { -20 * 256, 3277 },
+		{ -60 * 256, 33 }, { -100 * 256, 0 },
+	};
+	int16_t buf[203 * 2];
+	int32_t buf32[64];
+	uint32_t errors = 0, i;
+	int16_t prev;
+
+	/* constant gain, odd length */
+	for (i = 0; i < ARRAY_SIZE(buf); i++)
+		buf[i] = stream[0][i];
+	audio_dsp_volume_init(&vol, 20000);
+	audio_dsp_volume_apply_s16(&vol, buf, 203, 2);
+	for (i = 0; i < ARRAY_SIZE(buf); i++)
+		if (buf[i] != (int16_t)((stream[0][i] * 20000 + 0x4000) >> 15))
+			errors++;
+
+	/* unity gain leaves samples untouched */
+	audio_dsp_volume_set(&vol, AUDIO_DSP_UNITY, 0);
+	memcpy(buf, stream[0], sizeof(buf));
+	audio_dsp_volume_apply_s16(&vol, buf, 203, 2);
+	if (memcmp(buf, stream[0], sizeof(buf)))
+		errors++;
+
+	/* fade in of a constant signal: monotonic, ends on target */
+	for (i = 0; i < ARRAY_SIZE(buf); i++)
+		buf[i] = 10000;
+	audio_dsp_volume_init(&vol, 0);
+	audio_dsp_volume_set(&vol, AUDIO_DSP_UNITY, 100);
+	audio_dsp_volume_apply_s16(&vol, buf, 60, 2);
+	audio_dsp_volume_apply_s16(&vol, buf + 120, 143, 2);
+	prev = 0;
+	for (i = 0; i < 203; i++) {
+		if (buf[2 * i] != buf[2 * i + 1] || buf[2 * i] < prev)
+			errors++;
+		prev = buf[2 * i];
+	}
+	if (buf[0] != 0 || buf[2 * 100] != 10000 || buf[2 * 202] != 10000)
+		errors++;
+
+	/* 32-bit samples */
+	for (i = 0; i < ARRAY_SIZE(buf32); i++)
+		buf32[i] = wide[i];
+	audio_dsp_volume_init(&vol, 16384);
+	audio_dsp_volume_apply_s32(&vol, buf32, 32, 2);
+	for (i = 0; i < ARRAY_SIZE(buf32); i++)
+		if (buf32[i] != (int32_t)(((int64_t)wide[i] * 16384 + 0x4000) >> 15))
+			errors++;
+
+	/* dB to gain, within 0.1 dB */
+	for (i = 0; i < ARRAY_SIZE(db_gains); i++) {
+		int32_t g = audio_dsp_db_to_gain(db_gains[i].db);
+		int32_t tol = db_gains[i].gain / 80 + 1;
+		if (g < db_gains[i].gain - tol || g > db_gains[i].gain + tol)
+			errors++;
+	}
+
+	printf("-I- Volume: %u error(s)\r\n", (unsigned)errors);
+	return errors;
+}
+
+static uint32_t _check_resampler(void)
+{
+	uint32_t errors = 0, used, consumed, produced, total, n;
+
+	_tone(tone_in, 4000, 2 * PI * TONE_FREQ / 44100, TONE_AMPLITUDE);
+
+	/* reference: one call */
+	audio_dsp_resampler_init(&rs_ref, 1, 44100, 48000);
+	audio_dsp_resampler_set_drift(&rs_ref, 20000);
+	total = audio_dsp_resample_s16(&rs_ref, tone_in, 4000, &consumed,
+			tone_ref, ARRAY_SIZE(tone_ref));
+	if (consumed != 4000)
+		errors++;
+	/* 48000 / 44100 output frames per input frame, less the delay */
+	if (total < 4300 || total > 4360)
+		errors++;
+
+	/* same output with random input and output block sizes */
+	audio_dsp_resampler_init(&rs, 1, 44100, 48000);
+	audio_dsp_resampler_set_drift(&rs, 20000);
+	used = 0;
+	produced = 0;
+	while (produced < total) {
+		n = 1 + _rand() % 300;
+		if (n > 4000 - used)
+			n = 4000 - used;
+		produced += audio_dsp_resample_s16(&rs, tone_in + used, n,
+				&consumed, tone_out + produced,
+				1 + _rand() % 200);
+		used += consumed;
+		if (used == 4000 && !consumed)
+			break;
+	}
+	if (produced != total || memcmp(tone_out, tone_ref,
+			total * sizeof(int16_t)))
+		errors++;
+
+	if (audio_dsp_resampler_init(&rs, 3, 48000, 48000) == 0)
+		errors++;
+	if (audio_dsp_resampler_init(&rs, 1, 192000, 44100) == 0)
+		errors++;
+
+	printf("-I- Resampler streaming: %u error(s)\r\n", (unsigned)errors);
+	return errors;
+}
+
+/**
+ * \brief Resample a tone and measure the THD+N of the output
+ */
+static double _tone_thdn(uint32_t in_rate, uint32_t out_rate, int32_t drift)
+{
+	const uint32_t skip = 2 * CONFIG_AUDIO_DSP_RS_TAPS;
+	uint32_t in_frames, consumed, produced;
+	double step;
+
+	step = (double)in_rate / out_rate * (1.0 + drift * 1e-9);
+	in_frames = (uint32_t)((TONE_FRAMES + skip) * step) +
+		CONFIG_AUDIO_DSP_RS_TAPS;
+	_tone(tone_in, in_frames, 2 * PI * TONE_FREQ / in_rate,
+			TONE_AMPLITUDE);
+
+	audio_dsp_resampler_init(&rs, 1, in_rate, out_rate);
+	audio_dsp_resampler_set_drift(&rs, drift);
+	produced = audio_dsp_resample_s16(&rs, tone_in, in_frames, &consumed,
+			tone_out, TONE_FRAMES + skip);
+	if (produced < TONE_FRAMES + skip)
+		return 0.0;
+
+	return _thdn(tone_out + skip, TONE_FRAMES, 1,
+			2 * PI * TONE_FREQ / in_rate * step);
+}
+
+static uint32_t _check_quality(void)
+{
+	uint32_t errors = 0, i;
+	double thdn;
+
+	_tone(tone_in, TONE_FRAMES, 2 * PI * TONE_FREQ / 48000,
+			TONE_AMPLITUDE);
+	thdn = _thdn(tone_in, TONE_FRAMES, 1, 2 * PI * TONE_FREQ / 48000);
+	printf("-I- THD+N of the 16-bit source tone: %d.%d dB\r\n",
+	       (int)thdn, (int)(-thdn * 10) % 10);
+
+	for (i = 0; i < ARRAY_SIZE(rate_pairs); i++) {
+		thdn = _tone_thdn(rate_pairs[i].in, rate_pairs[i].out,
+				rate_pairs[i].drift);
+		printf("-I- %u -> %u Hz, drift %d ppm: THD+N %d.%d dB\r\n",
+		       (unsigned)rate_pairs[i].in, (unsigned)rate_pairs[i].out,
+		       (int)(rate_pairs[i].drift / 1000),
+		       (int)thdn, (int)(-thdn * 10) % 10);
+		if (thdn > MAX_THDN_DB)
+			errors++;
+	}
+	printf("-I- Resampler quality: %u error(s)\r\n", (unsigned)errors);
+	return errors;
+}
+
+/*
+ * Benchmarks
+ */
+
+static void _run_resample(void* arg)
+{
+	uint32_t consumed;
+
+	audio_dsp_resample_s16(&rs, stream[0], BENCH_FRAMES, &consumed,
+			rs_out, ARRAY_SIZE(rs_out) / 2);
+}
+
+static void _run_add(void* arg)
+{
+	audio_dsp_add_s16(mix_out, stream[1], BENCH_FRAMES * 2);
+}
+
+static void _run_mix(void* arg)
+{
+	static const uint16_t gains[BENCH_STREAMS] = {
+		AUDIO_DSP_UNITY, 20000, 10000, 5000
+	};
+	const int16_t* srcs[BENCH_STREAMS] = {
+		stream[0], stream[1], stream[2], stream[3]
+	};
+
+	audio_dsp_mix_s16(mix_out, srcs, gains, BENCH_STREAMS,
+			BENCH_FRAMES * 2);
+}
+
+static void _run_volume(void* arg)
+{
+	audio_dsp_volume_init(&vol, 20000);
+	audio_dsp_volume_apply_s16(&vol, mix_out, BENCH_FRAMES, 2);
+}
+
+static void _run_ramp(void* arg)
+{
+	audio_dsp_volume_init(&vol, 0);
+	audio_dsp_volume_set(&vol, AUDIO_DSP_UNITY, BENCH_FRAMES);
+	audio_dsp_volume_apply_s16(&vol, mix_out, BENCH_FRAMES, 2);
+}
+
+static void _run_to_s24(void* arg)
+{
+	audio_dsp_convert(wide, AUDIO_DSP_S24_32, 2, stream[0], AUDIO_DSP_S16,
+			2, BENCH_FRAMES);
+}
+
+static void _run_to_mono(void* arg)
+{
+	audio_dsp_convert(mix_out, AUDIO_DSP_S16, 1, stream[0], AUDIO_DSP_S16,
+			2, BENCH_FRAMES);
+}
+
+static void _bench(const char* name, void (*run)(void*), uint32_t samples)
+{
+	struct _perf_bench bench;
+	struct _perf_result result;
+
+	memset(&bench, 0, sizeof(bench));
+	bench.name = name;
+	bench.bytes = samples * sizeof(int16_t);
+	bench.run = run;
+	if (perf_bench_run(&bench, BENCH_RUNS, &result) == 0) {
+		perf_bench_print(&bench, &result);
+		if (result.best.ns)
+			printf("    %u ksamples/s\r\n", (unsigned)(
+			       (uint64_t)samples * 1000000 / result.best.ns));
+	}
+}
+
+static void _bench_all(void)
+{
+	uint32_t i, j;
+
+	for (i = 0; i < BENCH_STREAMS; i++)
+		for (j = 0; j < BENCH_FRAMES * 2; j++)
+			stream[i][j] = (int16_t)_rand() >> 2;
+
+	for (i = 0; i < ARRAY_SIZE(rate_pairs); i++) {
+		char name[40];
+		audio_dsp_resampler_init(&rs, 2, rate_pairs[i].in,
+				rate_pairs[i].out);
+		audio_dsp_resampler_set_drift(&rs, rate_pairs[i].drift);
+		snprintf(name, sizeof(name), "resample %u->%u st",
+		         (unsigned)rate_pairs[i].in,
+		         (unsigned)rate_pairs[i].out);
+		_bench(name, _run_resample, BENCH_FRAMES * 2);
+	}
+	_bench("add 2 streams", _run_add, BENCH_FRAMES * 2);
+	_bench("mix 4 streams, gains", _run_mix,
+	       BENCH_STREAMS * BENCH_FRAMES * 2);
+	_bench("volume", _run_volume, BENCH_FRAMES * 2);
+	_bench("volume ramp", _run_ramp, BENCH_FRAMES * 2);
+	_bench("s16 -> s24_32", _run_to_s24, BENCH_FRAMES * 2);
+	_bench("stereo -> mono", _run_to_mono, BENCH_FRAMES * 2);
+}
+
+#ifndef CONFIG_ARCH_ARM
+/**
+ * \brief Resample a WAV file to 16 bits
+ */
+static int _process_wav(const char* in_name, const char* out_name,
+		uint32_t out_rate, double tone)
+{
+	struct _wav_header hdr;
+	struct _perf_sample start, end, delta;
+	enum _audio_dsp_format format;
+	uint8_t *data = NULL;
+	int16_t *in = NULL, *out = NULL;
+	uint32_t frames, out_max, consumed, produced;
+	uint8_t ch;
+	FILE* f;
+	int err = 1;
+
+	f = fopen(in_name, "rb");
+	if (!f || fread(&hdr, sizeof(hdr), 1, f) != 1 || !wav_is_valid(&hdr)
+	    || hdr.audio_format != 1 || hdr.subchunk2_id != 0x61746164) {
+		printf("-E- %s: not a canonical PCM WAV file\r\n", in_name);
+		goto exit;
+	}
+	wav_display_info(&hdr);
+	switch (hdr.bits_per_sample) {
+	case 16:
+		format = AUDIO_DSP_S16;
+		break;
+	case 24:
+		format = AUDIO_DSP_S24;
+		break;
+	case 32:
+		format = AUDIO_DSP_S32;
+		break;
+	default:
+		printf("-E- %u bits per sample not supported\r\n",
+		       (unsigned)hdr.bits_per_sample);
+		goto exit;
+	}
+	ch = (uint8_t)hdr.num_channels;
+	frames = hdr.subchunk2_size / hdr.block_align;
+	if (audio_dsp_resampler_init(&rs, ch, hdr.sample_rate, out_rate)) {
+		printf("-E- unsupported channels or rates\r\n");
+		goto exit;
+	}
+
+	data = malloc(hdr.subchunk2_size);
+	in = malloc(frames * ch * sizeof(int16_t));
+	out_max = (uint32_t)((uint64_t)frames * out_rate / hdr.sample_rate) + 2;
+	out = malloc(out_max * ch * sizeof(int16_t));
+	if (!data || !in || !out)
+		goto exit;
+	frames = fread(data, hdr.block_align, frames, f);
+
+	perf_read(&start);
+	audio_dsp_convert(in, AUDIO_DSP_S16, ch, data, format, ch, frames);
+	produced = audio_dsp_resample_s16(&rs, in, frames, &consumed, out,
+			out_max);
+	perf_read(&end);
+	perf_diff(&start, &end, &delta);
+	printf("-I- %u -> %u frames: %u ms, %u ksamples/s\r\n",
+	       (unsigned)frames, (unsigned)produced,
+	       (unsigned)(delta.ns / 1000000),
+	       (unsigned)((uint64_t)frames * ch * 1000000 / (delta.ns + 1)));
+
+	if (tone > 0.0 && frames > 2 * TONE_FRAMES &&
+	    produced > 2 * TONE_FRAMES) {
+		double thdn;
+		thdn = _thdn(in + TONE_FRAMES * ch, TONE_FRAMES, ch,
+				2 * PI * tone / hdr.sample_rate);
+		printf("-I- THD+N input:  %.1f dB\r\n", thdn);
+		thdn = _thdn(out + TONE_FRAMES * ch, TONE_FRAMES, ch,
+				2 * PI * tone / out_rate);
+		printf("-I- THD+N output: %.1f dB\r\n", thdn);
+	}
+
+	fclose(f);
+	f = fopen(out_name, "wb");
+	if (!f)
+		goto exit;
+	hdr.sample_rate = out_rate;
+	hdr.bits_per_sample = 16;
+	hdr.block_align = ch * 2;
+	hdr.byte_rate = out_rate * hdr.block_align;
+	hdr.subchunk2_size = produced * hdr.block_align;
+	hdr.chunk_size = 36 + hdr.subchunk2_size;
+	if (fwrite(&hdr, sizeof(hdr), 1, f) == 1 &&
+	    fwrite(out, hdr.block_align, produced, f) == produced)
+		err = 0;
+
+exit:
+	if (f)
+		fclose(f);
+	free(data);
+	free(in);
+	free(out);
+	return err;
+}
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+
+#ifdef CONFIG_ARCH_ARM
+int main(void)
+#else
+int main(int argc, char* argv[])
+#endif
+{
+	uint32_t errors = 0;
+
+#ifdef CONFIG_ARCH_ARM
+	console_example_info("Audio Processing Benchmark");
+#else
+	printf("-- Audio Processing Benchmark (host) --\r\n");
+	perf_initialize();
+	if (argc >= 4)
+		return _process_wav(argv[1], argv[2], atoi(argv[3]),
+				argc > 4 ? atof(argv[4]) : 0.0);
+#endif
+
+	errors += _check_convert();
+	errors += _check_mix();
+	errors += _check_volume();
+	errors += _check_resampler();
+	errors += _check_quality();
+	printf("-I- Functional check: %u error(s)\r\n", (unsigned)errors);
+
+	perf_initialize();
+	printf("%u runs per benchmark, figures of the best run\r\n",
+	       (unsigned)BENCH_RUNS);
+	perf_bench_print_header();
+	_bench_all();
+
+#ifdef CONFIG_ARCH_ARM
+	while (1);
+#else
+	return errors ? 1 : 0;
+#endif
+}
@@ -155,6 +155,14 @@
 /* record 10 seconds */
 #define SAMPLE_COUNT (10 * SAMPLE_RATE)
 
+/** Duration of a period of the audio streams, in ms */
+#define PERIOD_MS (5)
+
+/** Size of a period, in bytes (16-bit mono samples) */
+#define PERIOD_SIZE (SAMPLE_RATE * PERIOD_MS / 1000 * 2)
+
+/** Number of periods of the audio streams */
+#define PERIODS (4)
 
 /*----------------------------------------------------------------------------
  *         Internal variables
@@ -163,56 +171,46 @@ static uint32_t _start_tick;
 
 CACHE_ALIGNED_DDR static uint16_t _sound_buffer[SAMPLE_COUNT];
 
+/** Rings of periods of the record and play streams */
+CACHE_ALIGNED static uint8_t _record_ring[PERIODS][PERIOD_SIZE];
+CACHE_ALIGNED static uint8_t _play_ring[PERIODS][PERIOD_SIZE];
+
 static volatile bool _sound_recorded = false;
 
 /** audio playing volume */
 static uint8_t play_vol = AUDIO_PLAY_MAX_VOLUME/2;
 
-struct {
-	mutex_t rx;
-	mutex_t tx;
-} mutex;
-
 /*----------------------------------------------------------------------------
  *         Internal functions
  *----------------------------------------------------------------------------*/
 
-static void _record_stop(void)
-{
-	uint32_t elapsed = timer_get_interval(_start_tick, timer_get_tick());
-	printf("<Record Stop (%ums elapsed)>\r\n", (unsigned)elapsed);
-	_sound_recorded = true;
-	audio_enable(&audio_record_device, false);
-}
-
-static void _play_stop(void)
+static void _print_stats(struct _audio_desc* desc)
 {
+	struct _audio_stream_stats stats;
 	uint32_t elapsed = timer_get_interval(_start_tick, timer_get_tick());
-	printf("<Play Stop (%ums elapsed)>\r\n", (unsigned)elapsed);
-	audio_enable(&audio_play_device, false);
-}
 
-/**
- *  \brief DMA TX callback
- */
-static int _audio_play_finish_callback(void* arg, void* arg2)
-{
-	mutex_unlock(&mutex.tx);
-	_play_stop();
-	audio_mute(&audio_play_device, true);
-
-	return 0;
+	audio_stream_get_stats(desc, &stats, false);
+	printf("  %ums elapsed, %u periods, %u xrun(s), %u period(s) lost\r\n",
+	       (unsigned)elapsed, (unsigned)stats.periods,
+	       (unsigned)stats.xruns, (unsigned)stats.lost);
+	printf("  latency %u to %u us\r\n", (unsigned)stats.min_latency,
+	       (unsigned)stats.max_latency);
 }
 
 /**
- *  \brief DMA RX callback
+ * \brief Wait until the play stream runs out of data, i.e. the last period
+ * written has been played
  */
-static int _audio_record_finish_callback(void* arg, void* arg2)
+static void _play_drain(void)
 {
-	mutex_unlock(&mutex.rx);
-	_record_stop();
-
-	return 0;
+	struct _audio_stream_stats stats;
+	uint32_t lost;
+
+	audio_stream_get_stats(&audio_play_device, &stats, false);
+	lost = stats.lost;
+	do {
+		audio_stream_get_stats(&audio_play_device, &stats, false);
+	} while (stats.lost == lost);
 }
 
 /**
@@ -230,35 +228,35 @@ static void _display_menu(void)
 	printf("=>");
 }
 
-static void _record_start(void)
-{
-	printf("<Record Start>\r\n");
-	_start_tick = timer_get_tick();
-	_sound_recorded = false;
-	audio_enable(&audio_record_device, true);
-}
-
-static void _play_start(void)
-{
-	printf("<Play Start>\r\n");
-	_start_tick = timer_get_tick();
-	audio_enable(&audio_play_device, true);
-}
-
 /**
  * \brief Record sound.
  */
 static void _record_sound(void)
 {
-	uint32_t  audio_length = SAMPLE_COUNT * 2;
-	struct _callback _cb;
+	uint8_t* data = (uint8_t*)_sound_buffer;
+	uint32_t audio_length = SAMPLE_COUNT * 2;
+	uint32_t recorded = 0;
+
+	audio_stream_configure(&audio_record_device, _record_ring, PERIOD_SIZE,
+			PERIODS, NULL);
+
+	printf("<Record Start>\r\n");
+	_start_tick = timer_get_tick();
+	_sound_recorded = false;
+	if (audio_stream_start(&audio_record_device) != 0) {
+		printf("Cannot start recording\r\n");
+		return;
+	}
 
-	mutex_lock(&mutex.rx);
-	_record_start();
-	callback_set(&_cb, _audio_record_finish_callback, &audio_record_device);
-	audio_transfer(&audio_record_device, (void *)_sound_buffer, audio_length, &_cb);
+	/* Move the periods recorded out of the ring */
+	while (recorded < audio_length)
+		recorded += audio_stream_read(&audio_record_device,
+				data + recorded, audio_length - recorded);
 
-	while (mutex_is_locked(&mutex.rx));
+	audio_stream_stop(&audio_record_device);
+	printf("<Record Stop>\r\n");
+	_print_stats(&audio_record_device);
+	_sound_recorded = true;
 }
 
 /**
@@ -267,21 +265,38 @@ static void _record_sound(void)
 static void _playback_sound(void)
 {
 	/* our Classd support 16 bit sound only*/
-	uint32_t  audio_length = SAMPLE_COUNT * 2;
-	struct _callback _cb;
+	const uint8_t* data = (const uint8_t*)_sound_buffer;
+	uint32_t audio_length = SAMPLE_COUNT * 2;
+	uint32_t played;
 
 	if (!_sound_recorded) {
 	       printf("Please record the sound first\n\r");
 	       return;
 	}
 
+	/* Fill the ring before starting */
+	audio_stream_configure(&audio_play_device, _play_ring, PERIOD_SIZE,
+			PERIODS, NULL);
+	played = audio_stream_write(&audio_play_device, data, audio_length);
+
 	audio_mute(&audio_play_device, false);
-	_play_start();
+	printf("<Play Start>\r\n");
+	_start_tick = timer_get_tick();
+	if (audio_stream_start(&audio_play_device) != 0) {
+		audio_mute(&audio_play_device, true);
+		printf("Cannot start playback\r\n");
+		return;
+	}
 
-	callback_set(&_cb, _audio_play_finish_callback, &audio_play_device);
-	audio_transfer(&audio_play_device, (void *)_sound_buffer, audio_length, &_cb);
+	while (played < audio_length)
+		played += audio_stream_write(&audio_play_device,
+				data + played, audio_length - played);
+	_play_drain();
 
-	while (mutex_is_locked(&mutex.tx));
+	audio_stream_stop(&audio_play_device);
+	audio_mute(&audio_play_device, true);
+	printf("<Play Stop>\r\n");
+	_print_stats(&audio_play_device);
 }
 
 /*----------------------------------------------------------------------------
@@ -297,9 +312,6 @@ extern int main(void)
 {
 	uint8_t key;
 
-	mutex.tx = 0;
-	mutex.rx = 0;
-
 	/* output example information */
 	console_example_info("Audio Recorder Example");
 
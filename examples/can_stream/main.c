@@ -0,0 +1,328 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \page can_stream MCAN Batched Streaming
+ *
+ * \section Purpose
+ *
+ * This example streams CAN FD frames through the batched interface of the
+ * MCAN driver (mcand.h): Rx FIFO watermark batches read in place from the
+ * Message RAM, Tx FIFO queueing with Tx Event FIFO completion, and filter
+ * statistics.
+ *
+ * \section Requirements
+ *
+ * This package can be used with SAMA5D2-XPLAINED, SAMA5D27-SOM1-EK,
+ * SAME70-XPLAINED and SAMV71-XPLAINED. The first CAN bus of the board is used
+ * in internal loop-back mode, no cable nor transceiver is needed.
+ *
+ * \section Description
+ *
+ * The MCAN is switched to CAN FD with bit rate switching and two classic
+ * filters route a standard and an extended identifier range to Rx FIFO 0.
+ * A burst of 64-byte frames, alternating both ranges and carrying a sequence
+ * number, is queued in the Tx FIFO as fast as it frees up. Received batches
+ * are checked in place and each Tx event is checked against its message
+ * marker.
+ *
+ * When the burst is complete, the throughput, the average batch size and the
+ * driver statistics (matches per filter, Rx FIFO full and lost events) are
+ * printed.
+ *
+ * \section Usage
+ *
+ * -# Build the program and download it inside the board.
+ * -# On the computer, open and configure a terminal application
+ *    (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *   - 115200 baud rate
+ *   - 8 bits of data
+ *   - No parity
+ *   - 1 stop bit
+ *   - No flow control
+ * -# Start the application.
+ * -# In the terminal window, the following text should appear:
+ *    \code
+ *     -- MCAN Batched Streaming Example xxx --
+ *     -- xxxxxx-xx
+ *     -- Compiled: xxx xx xxxx xx:xx:xx --
+ *    \endcode
+ *
+ * \section References
+ * - can_stream/main.c
+ * - mcand.h
+ */
+
+/** \file
+ *
+ *  This file contains all the specific code for the can_stream example.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "board.h"
+#include "callback.h"
+#include "trace.h"
+#include "timer.h"
+
+#include "can/can-bus.h"
+#include "can/mcand.h"
+#include "serial/console.h"
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** CAN operation timeout (ms) */
+#define CAN_TO 500
+
+/** Number of frames in the burst */
+#define BURST_FRAMES 20000
+
+/** Payload length */
+#define FRAME_LEN 64
+
+/** Rx FIFO 0 watermark */
+#define RX_WATERMARK 8
+
+/** Maximum wait of the frames below the watermark, in bit times */
+#define RX_TIMEOUT 500
+
+/** Identifier ranges */
+#define STD_ID   0x120
+#define STD_MASK 0x7f0
+#define EXT_ID   0x1a000000
+#define EXT_MASK 0x1fff0000
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static struct _mcan_desc* mcan;
+
+static volatile uint32_t rx_count;
+static volatile uint32_t rx_errors;
+static volatile uint32_t tx_count;
+static volatile uint32_t tx_errors;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static void frame_fill(uint8_t* data, uint32_t seq)
+{
+	int i;
+
+	for (i = 0; i < FRAME_LEN; i++)
+		data[i] = (uint8_t)(seq * 7 + i);
+	memcpy(data, &seq, sizeof(seq));
+}
+
+static uint32_t frame_id(uint32_t seq, uint8_t* flags)
+{
+	if (seq & 1) {
+		*flags = MCAND_MSG_EXTENDED;
+		return EXT_ID | (seq & 0xffff);
+	}
+	*flags = 0;
+	return STD_ID | (seq & 0xf);
+}
+
+static int rx_batch(void* arg, void* arg2)
+{
+	const struct _mcan_batch* batch = (const struct _mcan_batch*)arg2;
+	uint8_t expected[FRAME_LEN];
+	uint8_t flags;
+	uint32_t seq;
+	int i;
+
+	for (i = 0; i < batch->count; i++) {
+		const struct _mcan_msg* msg = &batch->msgs[i];
+		seq = rx_count++;
+		frame_fill(expected, seq);
+		if (msg->len != FRAME_LEN || msg->id != frame_id(seq, &flags)
+		    || (msg->flags & MCAND_MSG_EXTENDED) != flags
+		    || memcmp(msg->data, expected, FRAME_LEN))
+			rx_errors++;
+	}
+	return 0;
+}
+
+static int tx_batch(void* arg, void* arg2)
+{
+	const struct _mcan_batch* batch = (const struct _mcan_batch*)arg2;
+	int i;
+
+	for (i = 0; i < batch->count; i++) {
+		if (batch->msgs[i].marker != (uint8_t)tx_count)
+			tx_errors++;
+		tx_count++;
+	}
+	return 0;
+}
+
+static int stream_start(void)
+{
+	struct _callback rx_cb, tx_cb;
+	int err;
+
+	mcan = mcand_get_desc((Mcan*)BOARD_CAN_BUS0);
+
+	if (can_bus_loopback(0, true) < 0
+	    || can_bus_mode(0, CAN_MODE_CAN_FD_DUAL_RATE) < 0)
+		return -ENOTSUP;
+
+	/* FIFO configuration requires the initialization mode */
+	mcan_disable(mcan->addr);
+
+	err = mcand_add_filter(mcan, STD_ID, STD_MASK, 0, 0);
+	if (err < 0)
+		return err;
+	printf("Standard filter %d: 0x%03x/0x%03x -> Rx FIFO 0\r\n",
+	       err, STD_ID, STD_MASK);
+	err = mcand_add_filter(mcan, EXT_ID, EXT_MASK, MCAND_MSG_EXTENDED, 0);
+	if (err < 0)
+		return err;
+	printf("Extended filter %d: 0x%08x/0x%08x -> Rx FIFO 0\r\n",
+	       err, EXT_ID, EXT_MASK);
+
+	callback_set(&rx_cb, rx_batch, NULL);
+	err = mcand_rx_fifo_start(mcan, 0, RX_WATERMARK, RX_TIMEOUT, &rx_cb);
+	if (err < 0)
+		return err;
+	callback_set(&tx_cb, tx_batch, NULL);
+	err = mcand_tx_fifo_start(mcan, 0, &tx_cb);
+	if (err < 0)
+		return err;
+
+	return can_bus_activate(0, CAN_TO);
+}
+
+static void stream_burst(void)
+{
+	const struct _mcan_stats* stats = mcand_get_stats(mcan);
+	struct _timeout timeout;
+	uint64_t start, elapsed;
+	uint8_t* data;
+	uint8_t flags;
+	uint32_t seq, id, i;
+
+	mcand_clear_stats(mcan);
+	rx_count = rx_errors = tx_count = tx_errors = 0;
+
+	start = timer_get_tick();
+	for (seq = 0; seq < BURST_FRAMES; seq++) {
+		id = frame_id(seq, &flags);
+		/* fill the next Tx FIFO element in place */
+		timer_start_timeout(&timeout, CAN_TO);
+		while (!(data = mcand_tx_fifo_get_buffer(mcan, id, flags,
+				FRAME_LEN, (uint8_t)seq))) {
+			if (timer_timeout_reached(&timeout)) {
+				printf("Tx FIFO stalled at frame %u\r\n", (unsigned)seq);
+				return;
+			}
+		}
+		frame_fill(data, seq);
+		mcand_tx_fifo_submit(mcan);
+	}
+	timer_start_timeout(&timeout, CAN_TO);
+	while (rx_count < BURST_FRAMES || tx_count < BURST_FRAMES) {
+		if (timer_timeout_reached(&timeout))
+			break;
+	}
+	elapsed = timer_get_interval(start, timer_get_tick());
+	if (elapsed == 0)
+		elapsed = 1;
+
+	printf("\r\n%u frames of %u bytes in %u ms: %u frames/s\r\n",
+	       BURST_FRAMES, FRAME_LEN, (unsigned)elapsed,
+	       (unsigned)(rx_count * 1000ull / elapsed));
+	printf("Rx: %u frames, %u error(s), %u batches (%u.%u frames/batch)\r\n",
+	       (unsigned)rx_count, (unsigned)rx_errors,
+	       (unsigned)stats->rx_batches[0],
+	       (unsigned)(stats->rx_batches[0] ? rx_count / stats->rx_batches[0] : 0),
+	       (unsigned)(stats->rx_batches[0] ?
+			  (rx_count * 10 / stats->rx_batches[0]) % 10 : 0));
+	printf("Rx FIFO 0: %u full, %u lost, %u without filter match\r\n",
+	       (unsigned)stats->rx_full[0], (unsigned)stats->rx_lost[0],
+	       (unsigned)stats->rx_no_match);
+	for (i = 0; i < ARRAY_SIZE(stats->filt_std); i++)
+		if (stats->filt_std[i])
+			printf("Standard filter %u: %u matches\r\n",
+			       (unsigned)i, (unsigned)stats->filt_std[i]);
+	for (i = 0; i < ARRAY_SIZE(stats->filt_ext); i++)
+		if (stats->filt_ext[i])
+			printf("Extended filter %u: %u matches\r\n",
+			       (unsigned)i, (unsigned)stats->filt_ext[i]);
+	printf("Tx: %u queued, %u events, %u marker error(s), %u events lost\r\n",
+	       (unsigned)stats->tx_queued, (unsigned)tx_count,
+	       (unsigned)tx_errors, (unsigned)stats->tx_events_lost);
+
+	if (rx_count == BURST_FRAMES && tx_count == BURST_FRAMES
+	    && !rx_errors && !tx_errors && !stats->rx_lost[0])
+		printf("-------- test PASSED\r\n");
+	else
+		printf("-------- test FAILED\r\n");
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ *  \brief Application entry point.
+ *
+ *  \return Unused (ANSI-C compatibility).
+ */
+int main(void)
+{
+	int err;
+
+	/* Output example information */
+	console_example_info("MCAN Batched Streaming Example");
+
+	err = stream_start();
+	if (err < 0) {
+		printf("Failed to start streaming (%d)\r\n", err);
+		while (1);
+	}
+
+	while (1) {
+		stream_burst();
+		printf("\r\nPress a key to run the burst again\r\n");
+		console_get_char();
+	}
+}
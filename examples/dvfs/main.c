@@ -0,0 +1,333 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \page dvfs DVFS Governor Example
+ *
+ * \section Purpose
+ *
+ * This example shows how the DVFS governor runs the core at full speed
+ * during bursts of work and at a lower operating point otherwise.
+ *
+ * \section Requirements
+ *
+ * This package can be used with SAMA5D2-XPLAINED, SAMA5D3-XPLAINED and
+ * SAMA5D4-XPLAINED boards.
+ *
+ * \section Description
+ *
+ * Every two seconds a burst of work (checksums over a buffer in SRAM) is
+ * posted to the cooperative scheduler in small chunks.  The governor
+ * measures the CPU load over 20ms windows: it selects the fastest operating
+ * point as soon as a window is 80% busy and steps down one point after each
+ * window less than 30% busy.  The duration of each burst and the time
+ * spent at each operating point are printed on the console, along with the
+ * number of transitions.
+ *
+ * The console keeps working across transitions: the serial driver
+ * recomputes its baudrate divider on master clock changes.
+ *
+ * The example runs from SRAM: the DDR is kept in self-refresh while the
+ * master clock differs from its boot value.
+ *
+ * \section Usage
+ *
+ * -# Build the program and download it inside the board.
+ * -# On the computer, open and configure a terminal application
+ *    (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *   - 115200 baud rate
+ *   - 8 bits of data
+ *   - No parity
+ *   - 1 stop bit
+ *   - No flow control
+ * -# Start the application and use the console menu.
+ *
+ * \section References
+ * - dvfs/main.c
+ * - dvfs.h
+ * - sched.h
+ */
+
+/** \file
+ *
+ *  This file contains all the specific code for the DVFS governor example.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "board.h"
+#include "chip.h"
+#include "compiler.h"
+#include "sched.h"
+#include "timer.h"
+#include "trace.h"
+
+#include "peripherals/pmc.h"
+#include "power/dvfs.h"
+#include "serial/console.h"
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Event priorities */
+#define PRIO_CONSOLE 0
+#define PRIO_WORK    1
+#define PRIO_STATS   SCHED_PRIORITY_LOWEST
+
+/** Burst period (us) */
+#define BURST_PERIOD  2000000
+
+/** Number of chunks per burst, each chunk scans the work buffer once */
+#define BURST_CHUNKS  800
+
+/** Work buffer size (32-bit words) */
+#define WORK_WORDS    (16 * 1024 / 4)
+
+/** Statistics period (us) */
+#define STATS_PERIOD  10000000
+
+/** Governor settings */
+static const struct _dvfs_governor_cfg governor_cfg = {
+	.period = 20000,
+	.up_threshold = 80,
+	.down_threshold = 30,
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static uint32_t work_buffer[WORK_WORDS];
+
+static struct _sched_event work_event;
+static struct _timer_event burst_timer;
+static uint32_t burst_chunk;
+static uint64_t burst_start;
+static uint32_t burst_checksum;
+
+static struct _sched_event stats_event;
+static struct _timer_event stats_timer;
+
+static struct _sched_event console_event;
+static volatile uint8_t console_cmd;
+
+static bool governor_enabled;
+static struct _dvfs_hint hint;
+static bool hint_enabled;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static void _print_menu(void)
+{
+	uint32_t i, count;
+
+	dvfs_get_default_opps(&count);
+
+	printf("\r\nOperating points:\r\n");
+	for (i = 0; i < count; i++)
+		printf("  %u: PCK %uMHz\r\n", (unsigned)i,
+				(unsigned)(dvfs_get_opp_pck(i) / 1000000));
+	printf("Menu:\r\n"
+	       "  g: start/stop the governor\r\n"
+	       "  0-%u: stop the governor and select an operating point\r\n"
+	       "  h: add/remove a hint keeping at least operating point 1\r\n"
+	       "  s: print statistics\r\n"
+	       "  m: print this menu\r\n",
+	       (unsigned)(count - 1));
+}
+
+static void _print_stats(void)
+{
+	struct _dvfs_stats stats;
+	uint32_t i, count;
+
+	dvfs_get_default_opps(&count);
+	dvfs_get_stats(&stats);
+
+	printf("-- OPP %u, PCK %uMHz, MCK %uMHz, %u transitions, governor %s\r\n",
+			(unsigned)dvfs_get_opp(),
+			(unsigned)(pmc_get_processor_clock() / 1000000),
+			(unsigned)(pmc_get_master_clock() / 1000000),
+			(unsigned)stats.transitions,
+			governor_enabled ? "on" : "off");
+	for (i = 0; i < count; i++)
+		printf("   OPP %u: %ums\r\n", (unsigned)i,
+				(unsigned)(stats.time[i] / 1000));
+}
+
+static int _timer_post(void* arg, void* arg2)
+{
+	sched_post((struct _sched_event*)arg);
+	return 0;
+}
+
+static int _burst_start(void* arg, void* arg2)
+{
+	if (burst_chunk == 0) {
+		burst_chunk = BURST_CHUNKS;
+		sched_post(&work_event);
+	}
+	return 0;
+}
+
+static int _work(void* arg, void* arg2)
+{
+	uint32_t i, sum = burst_checksum;
+
+	if (burst_chunk == BURST_CHUNKS)
+		burst_start = timer_get_us();
+
+	for (i = 0; i < WORK_WORDS; i++)
+		sum = (sum << 1 | sum >> 31) ^ work_buffer[i];
+	burst_checksum = sum;
+
+	if (--burst_chunk > 0) {
+		/* yield to higher priority events between chunks */
+		sched_post(&work_event);
+	} else {
+		printf("-- burst done in %ums at OPP %u\r\n",
+				(unsigned)((timer_get_us() - burst_start) / 1000),
+				(unsigned)dvfs_get_opp());
+	}
+
+	return 0;
+}
+
+static int _stats(void* arg, void* arg2)
+{
+	_print_stats();
+	return 0;
+}
+
+static int _console_command(void* arg, void* arg2)
+{
+	uint8_t c = console_cmd;
+	uint32_t count;
+
+	dvfs_get_default_opps(&count);
+
+	if (c >= '0' && c < '0' + count) {
+		dvfs_governor_stop();
+		governor_enabled = false;
+		if (dvfs_set_opp(c - '0') < 0)
+			printf("-- cannot switch to OPP %c\r\n", c);
+		_print_stats();
+	} else if (c == 'g') {
+		governor_enabled = !governor_enabled;
+		if (governor_enabled)
+			dvfs_governor_start(&governor_cfg);
+		else
+			dvfs_governor_stop();
+		printf("-- governor %s\r\n", governor_enabled ? "on" : "off");
+	} else if (c == 'h') {
+		hint_enabled = !hint_enabled;
+		if (hint_enabled)
+			dvfs_add_hint(&hint);
+		else
+			dvfs_remove_hint(&hint);
+		printf("-- hint %s\r\n", hint_enabled ? "added" : "removed");
+	} else if (c == 's') {
+		_print_stats();
+	} else if (c == 'm') {
+		_print_menu();
+	}
+
+	return 0;
+}
+
+static void _console_handler(uint8_t c)
+{
+	console_cmd = c;
+	sched_post(&console_event);
+}
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ *  \brief Application entry point for the DVFS example.
+ *
+ *  \return Unused (ANSI-C compatibility).
+ */
+int main(void)
+{
+	struct _callback cb;
+	const struct _dvfs_opp* opps;
+	uint32_t i, count;
+
+	console_example_info("DVFS Governor Example");
+
+	for (i = 0; i < WORK_WORDS; i++)
+		work_buffer[i] = i * 2654435761u;
+
+	opps = dvfs_get_default_opps(&count);
+	if (dvfs_initialize(opps, count, board_set_vddcore) < 0) {
+		printf("-- cannot initialize DVFS\r\n");
+		while (1);
+	}
+
+	hint.min_pck = dvfs_get_opp_pck(1);
+
+	callback_set(&cb, _work, NULL);
+	sched_event_init(&work_event, PRIO_WORK, &cb);
+	callback_set(&cb, _burst_start, NULL);
+	timer_event_init(&burst_timer, &cb);
+	timer_event_start(&burst_timer, BURST_PERIOD, BURST_PERIOD);
+
+	callback_set(&cb, _stats, NULL);
+	sched_event_init(&stats_event, PRIO_STATS, &cb);
+	callback_set(&cb, _timer_post, &stats_event);
+	timer_event_init(&stats_timer, &cb);
+	timer_event_start(&stats_timer, STATS_PERIOD, STATS_PERIOD);
+
+	callback_set(&cb, _console_command, NULL);
+	sched_event_init(&console_event, PRIO_CONSOLE, &cb);
+	console_set_rx_handler(_console_handler);
+	console_enable_rx_interrupt();
+
+	_print_menu();
+
+	governor_enabled = true;
+	dvfs_governor_start(&governor_cfg);
+
+	sched_run();
+
+	return 0;
+}
@@ -43,4 +43,11 @@
 #define LWIP_IPV6                       0
 #define LWIP_PERF                       0
 
+/* Let the netif skip the checksums computed or verified by the GMAC
+ * (the software checksums are kept on EMAC) */
+#define LWIP_CHECKSUM_CTRL_PER_NETIF    1
+
+/* Compute the TCP checksum of the application data while copying it */
+#define LWIP_CHECKSUM_ON_COPY           1
+
 #endif /* LWIPOPTS_H */
@@ -273,6 +273,7 @@ int main(void)
 	timer_start_timeout(&arp_timer, 10000);
 	/* Init uIP */
 	uip_init();
+	eth_tapdev_init(eth_port);
 
 #ifdef __DHCPC_H__
 	printf("P: DHCP Supported\n\r");
@@ -274,6 +274,7 @@ int main(void)
 
 	/* Init uIP */
 	uip_init();
+	eth_tapdev_init(eth_port);
 
 #ifdef __DHCPC_H__
 	printf("P: DHCP Supported\n\r");
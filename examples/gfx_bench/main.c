@@ -0,0 +1,742 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \page gfx_bench 2D Drawing Benchmark
+ *
+ * \section Purpose
+ *
+ * This example checks and measures the 2D drawing module (gfx.h) on a
+ * framebuffer in memory, against straightforward per-pixel drawing.
+ *
+ * \section Requirements
+ *
+ * This package can be used with the boards having a LCD controller.  It can
+ * also be compiled for a Linux host with Makefile.linux, in which case the
+ * portable implementation is measured, without DMA nor cache maintenance.
+ *
+ * \section Description
+ *
+ * For 16, 24 and 32 bpp framebuffers, fills, image copies, scrolling, lines
+ * and text are first checked against a per-pixel reference, alpha blending
+ * is checked for its exact cases, and every changed pixel must be covered by
+ * a dirty rectangle.  Then the time of usual HMI operations is measured for
+ * the per-pixel reference and for the gfx module.  On target, consecutive
+ * full screen DMA fills and copies are checked to all go through the DMA,
+ * then the DMA fills and copies (until gfx_sync()) and the cache cleaning of
+ * the whole canvas versus gfx_flush() are measured as well.
+ *
+ * \section Usage
+ *
+ * -# Build the program and download it inside the board.
+ * -# On the computer, open and configure a terminal application
+ *    (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *   - 115200 baud rate
+ *   - 8 bits of data
+ *   - No parity
+ *   - 1 stop bit
+ *   - No flow control
+ * -# Start the application, the results are printed on the console.
+ * -# To run it on a Linux computer, run "make -f Makefile.linux" and
+ *    "./gfx_bench" in the example directory.
+ *
+ * \section References
+ * - gfx_bench/main.c
+ * - gfx.h
+ * - perf.h
+ */
+
+/** \file
+ *
+ *  This file contains all the specific code for the 2D drawing benchmark.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "compiler.h"
+#include "perf.h"
+
+#include "display/gfx.h"
+
+#include "font.h"
+
+#ifdef CONFIG_ARCH_ARM
+#include "board.h"
+#include "chip.h"
+#include "trace.h"
+
+#include "mm/cache.h"
+#include "serial/console.h"
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Framebuffer size, in pixels */
+#define FB_WIDTH  800
+#define FB_HEIGHT 480
+
+/** Number of random operations of the functional check */
+#define CHECK_OPS 200
+
+/** Number of full screen DMA fills and copies of the DMA check */
+#define DMA_CHECK_OPS 8
+
+/** Number of measured runs per benchmark */
+#define BENCH_RUNS 10
+
+/** Size of the icon blended in the benchmarks, in pixels */
+#define ICON_SIZE 64
+
+#ifdef CONFIG_ARCH_ARM
+#define FB_SECTION CACHE_ALIGNED_DDR
+#else
+#define FB_SECTION ALIGNED(32)
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Local types
+ *----------------------------------------------------------------------------*/
+
+struct _bench_arg {
+	struct _gfx_surface* surface;
+	int x, y, w, h;
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+FB_SECTION static uint8_t fb[FB_WIDTH * FB_HEIGHT * 4];
+FB_SECTION static uint8_t fb_ref[FB_WIDTH * FB_HEIGHT * 4];
+FB_SECTION static uint8_t fb_img[FB_WIDTH * FB_HEIGHT * 4];
+static uint8_t fb_tmp[FB_WIDTH * FB_HEIGHT * 4];
+
+static uint32_t icon[ICON_SIZE * ICON_SIZE];
+
+static const char bench_text[] = "Temperature 21.5 C  Pressure 1013 hPa";
+
+static uint32_t rand_state = 1;
+
+static bool _pixel_10x14(const struct _gfx_font* font, uint8_t c, uint8_t x,
+		uint8_t y);
+
+static const struct _gfx_font font10x14 = {
+	10, 14, 2, pCharset10x14, _pixel_10x14
+};
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint32_t _rand(void)
+{
+	rand_state = rand_state * 1103515245 + 12345;
+	return rand_state >> 8;
+}
+
+static int _rand_range(int min, int max)
+{
+	return min + (int)(_rand() % (uint32_t)(max - min + 1));
+}
+
+static bool _pixel_10x14(const struct _gfx_font* font, uint8_t c, uint8_t x,
+		uint8_t y)
+{
+	const uint8_t* col = (const uint8_t*)font->data + (c - 0x20) * 20 + x * 2;
+
+	if (y < 8)
+		return (col[0] >> (7 - y)) & 1;
+	return (col[1] >> (15 - y)) & 1;
+}
+
+/*
+ * Per-pixel reference, as drawn before the gfx module
+ */
+
+static void _ref_pixel(struct _gfx_surface* s, int x, int y, uint32_t color)
+{
+	if (x < 0 || y < 0 || x >= s->width || y >= s->height)
+		return;
+	memcpy(s->buffer + y * s->stride + x * (s->bpp / 8), &color, s->bpp / 8);
+}
+
+static void _ref_fill(struct _gfx_surface* s, int x, int y, int w, int h,
+		uint32_t color)
+{
+	int i, j;
+
+	for (j = y; j < y + h; j++)
+		for (i = x; i < x + w; i++)
+			_ref_pixel(s, i, j, color);
+}
+
+static void _ref_line(struct _gfx_surface* s, int x0, int y0, int x1, int y1,
+		uint32_t color)
+{
+	int dx = x1 > x0 ? x1 - x0 : x0 - x1;
+	int dy = y1 > y0 ? y1 - y0 : y0 - y1;
+	int sx = x0 < x1 ? 1 : -1;
+	int sy = y0 < y1 ? 1 : -1;
+	int err = dx - dy;
+	int e2;
+
+	while (1) {
+		_ref_pixel(s, x0, y0, color);
+		if (x0 == x1 && y0 == y1)
+			break;
+		e2 = 2 * err;
+		if (e2 > -dy) {
+			err -= dy;
+			x0 += sx;
+		}
+		if (e2 < dx) {
+			err += dx;
+			y0 += sy;
+		}
+	}
+}
+
+static void _ref_copy(struct _gfx_surface* s, int x, int y, int sx, int sy,
+		int w, int h)
+{
+	uint32_t cw = s->bpp / 8;
+	uint32_t color;
+	int i, j;
+
+	memcpy(fb_tmp, s->buffer, s->stride * s->height);
+	for (j = 0; j < h; j++) {
+		for (i = 0; i < w; i++) {
+			if (sx + i < 0 || sy + j < 0 || sx + i >= s->width ||
+			    sy + j >= s->height)
+				continue;
+			color = 0;
+			memcpy(&color, fb_tmp + (sy + j) * s->stride + (sx + i) * cw,
+			       cw);
+			_ref_pixel(s, x + i, y + j, color);
+		}
+	}
+}
+
+static void _ref_char(struct _gfx_surface* s, int x, int y,
+		const struct _gfx_font* font, uint8_t c, uint32_t color)
+{
+	uint8_t i, j;
+
+	for (i = 0; i < font->width; i++)
+		for (j = 0; j < font->height; j++)
+			if (font->pixel(font, c, i, j))
+				_ref_pixel(s, x + i, y + j, color);
+}
+
+static void _ref_string(struct _gfx_surface* s, int x, int y,
+		const struct _gfx_font* font, const char* str, uint32_t color)
+{
+	for (; *str; str++) {
+		_ref_char(s, x, y, font, *str, color);
+		x += font->width + font->spacing;
+	}
+}
+
+/**
+ * \brief Check that every pixel differing from the snapshot is dirty
+ * \return number of uncovered pixels
+ */
+static uint32_t _check_dirty(struct _gfx_surface* s, const uint8_t* snapshot)
+{
+	uint32_t cw = s->bpp / 8, errors = 0;
+	int x, y;
+	uint8_t i;
+	bool covered;
+
+	for (y = 0; y < s->height; y++) {
+		for (x = 0; x < s->width; x++) {
+			if (!memcmp(s->buffer + y * s->stride + x * cw,
+			            snapshot + y * s->stride + x * cw, cw))
+				continue;
+			covered = false;
+			for (i = 0; i < s->dirty_count; i++)
+				if (x >= s->dirty[i].x && y >= s->dirty[i].y &&
+				    x < s->dirty[i].x + s->dirty[i].w &&
+				    y < s->dirty[i].y + s->dirty[i].h)
+					covered = true;
+			if (!covered)
+				errors++;
+		}
+	}
+	return errors;
+}
+
+/**
+ * \brief Check one random operation of each kind against the reference
+ * \return number of errors
+ */
+static uint32_t _check_op(struct _gfx_surface* s, struct _gfx_surface* ref,
+		uint32_t op)
+{
+	uint32_t size = s->stride * s->height;
+	uint32_t color = _rand() & (s->bpp == 32 ? 0xffffffff : (1u << s->bpp) - 1);
+	int x = _rand_range(-40, s->width);
+	int y = _rand_range(-40, s->height);
+	int w = _rand_range(0, 300);
+	int h = _rand_range(0, 200);
+	int sx, sy;
+	char str[4];
+
+	switch (op % 5) {
+	case 0:
+		gfx_fill_rect(s, x, y, w, h, color);
+		_ref_fill(ref, x, y, w, h, color);
+		break;
+	case 1:
+		/* image taken from the other framebuffer */
+		gfx_blit(s, x, y, fb_img, s->stride, w, h);
+		for (sy = 0; sy < h; sy++) {
+			for (sx = 0; sx < w; sx++) {
+				memcpy(&color, fb_img + sy * s->stride + sx * (s->bpp / 8),
+				       sizeof(color));
+				_ref_pixel(ref, x + sx, y + sy, color);
+			}
+		}
+		break;
+	case 2:
+		/* scroll, overlapping in any direction */
+		sx = x + _rand_range(-20, 20);
+		sy = y + _rand_range(-20, 20);
+		gfx_copy_rect(s, x, y, s, sx, sy, w, h);
+		_ref_copy(ref, x, y, sx, sy, w, h);
+		break;
+	case 3:
+		str[0] = _rand_range(0x20, 0x7e);
+		str[1] = _rand_range(0x20, 0x7e);
+		str[2] = _rand_range(0x20, 0x7e);
+		str[3] = 0;
+		gfx_draw_string(s, x, y, &font10x14, str, color, 0, false);
+		_ref_string(ref, x, y, &font10x14, str, color);
+		break;
+	case 4:
+		gfx_draw_line(s, x, y, x + w - 150, y + h - 100, color);
+		_ref_line(ref, x, y, x + w - 150, y + h - 100, color);
+		break;
+	}
+
+	gfx_sync();
+	return memcmp(s->buffer, ref->buffer, size) ? 1 : 0;
+}
+
+/**
+ * \brief Check the scroll of the whole surface against memmove
+ */
+static uint32_t _check_scroll(struct _gfx_surface* s)
+{
+	uint32_t size = s->stride * s->height;
+	uint32_t errors = 0;
+	int d, shift;
+
+	for (d = -3; d <= 3; d += 2) {
+		memcpy(fb_ref, s->buffer, size);
+		gfx_copy_rect(s, 0, d, s, 0, 0, s->width, s->height);
+		gfx_sync();
+		shift = d * (int)s->stride;
+		if (d > 0)
+			memmove(fb_ref + shift, fb_ref, size - shift);
+		else
+			memmove(fb_ref, fb_ref - shift, size + shift);
+		if (memcmp(s->buffer, fb_ref, size))
+			errors++;
+	}
+	return errors;
+}
+
+/**
+ * \brief Check the exact cases of alpha blending
+ */
+static uint32_t _check_blend(struct _gfx_surface* s)
+{
+	uint32_t errors = 0;
+	uint32_t d, e;
+	int c;
+
+	gfx_fill_rect(s, 0, 0, 4, 1, gfx_color(s, 0xff204080));
+	gfx_blend_rect(s, 0, 0, 1, 1, 0x00ffffff);
+	gfx_blend_rect(s, 1, 0, 1, 1, 0xffc0a060);
+	gfx_blend_rect(s, 2, 0, 1, 1, 0x80ffffff);
+	gfx_sync();
+
+	if (gfx_read_pixel(s, 0, 0) != gfx_color(s, 0xff204080))
+		errors++;
+	if (gfx_read_pixel(s, 1, 0) != gfx_color(s, 0xffc0a060))
+		errors++;
+
+	/* half white over the color: each component half-way, +/- 1 LSB of
+	 * the format */
+	d = gfx_read_pixel(s, 2, 0);
+	e = gfx_color(s, 0xff90a0c0);
+	if (s->bpp == 16) {
+		for (c = 0; c < 3; c++) {
+			int shift = c == 0 ? 0 : (c == 1 ? 5 : 11);
+			int mask = c == 1 ? 0x3f : 0x1f;
+			int diff = (int)((d >> shift) & mask) - (int)((e >> shift) & mask);
+			if (diff < -1 || diff > 1)
+				errors++;
+		}
+	} else {
+		for (c = 0; c < 24; c += 8) {
+			int diff = (int)((d >> c) & 0xff) - (int)((e >> c) & 0xff);
+			if (diff < -1 || diff > 1)
+				errors++;
+		}
+	}
+	return errors;
+}
+
+static uint32_t _check(uint8_t bpp)
+{
+	struct _gfx_surface s, ref;
+	uint32_t errors = 0, dirty_errors = 0;
+	uint32_t i, size;
+
+	gfx_surface_initialize(&s, fb, FB_WIDTH, FB_HEIGHT, bpp);
+	gfx_surface_initialize(&ref, fb_ref, FB_WIDTH, FB_HEIGHT, bpp);
+	gfx_enable_dma(&s, true);
+	size = s.stride * s.height;
+
+	for (i = 0; i < sizeof(fb_img); i++)
+		fb_img[i] = _rand();
+	memset(fb, 0, size);
+	memset(fb_ref, 0, size);
+
+	for (i = 0; i < CHECK_OPS; i++) {
+		if (_check_op(&s, &ref, i)) {
+			errors++;
+			memcpy(fb_ref, fb, size);
+		}
+	}
+
+	/* dirty tracking, the snapshot is taken after a flush */
+	gfx_enable_dma(&s, false);
+	for (i = 0; i < 20; i++) {
+		gfx_flush(&s);
+		memcpy(fb_ref, fb, size);
+		gfx_draw_string(&s, _rand_range(-20, 780), _rand_range(-20, 470),
+		                &font10x14, "Dirty", 0xffffff, 0, true);
+		gfx_fill_rect(&s, _rand_range(-20, 780), _rand_range(-20, 470),
+		              50, 30, _rand());
+		gfx_draw_line(&s, _rand_range(-20, 820), _rand_range(-20, 500),
+		              _rand_range(-20, 820), _rand_range(-20, 500), _rand());
+		gfx_blend_rect(&s, _rand_range(-20, 780), _rand_range(-20, 470),
+		               40, 40, 0x80ffffff);
+		gfx_copy_rect(&s, _rand_range(0, 700), _rand_range(0, 400), &s,
+		              _rand_range(0, 700), _rand_range(0, 400), 60, 60);
+		gfx_draw_pixel(&s, _rand_range(0, 799), _rand_range(0, 479), _rand());
+		dirty_errors += _check_dirty(&s, fb_ref);
+	}
+
+	errors += _check_scroll(&s);
+	errors += _check_blend(&s);
+
+	printf("-I- %2u bpp: %u error(s), %u pixel(s) out of dirty rectangles\r\n",
+	       (unsigned)bpp, (unsigned)errors, (unsigned)dirty_errors);
+	return errors + dirty_errors;
+}
+
+#ifdef CONFIG_ARCH_ARM
+/**
+ * \brief Check that consecutive full screen fills and copies, each made of
+ * many DMA transfers, all go through the DMA
+ * \return number of errors
+ */
+static uint32_t _check_dma(uint8_t bpp)
+{
+	struct _gfx_surface s, ref;
+	uint32_t errors = 0;
+	uint32_t i, size, rows;
+	uint32_t color;
+
+	gfx_surface_initialize(&s, fb, FB_WIDTH, FB_HEIGHT, bpp);
+	gfx_surface_initialize(&ref, fb_ref, FB_WIDTH, FB_HEIGHT, bpp);
+	gfx_enable_dma(&s, true);
+	size = s.stride * s.height;
+
+	rows = gfx_get_dma_rows();
+	for (i = 0; i < DMA_CHECK_OPS; i++) {
+		if (i & 1) {
+			gfx_blit(&s, 0, 0, fb_img, s.stride, FB_WIDTH, FB_HEIGHT);
+			gfx_sync();
+			if (memcmp(fb, fb_img, size))
+				errors++;
+		} else {
+			color = _rand() & (bpp == 32 ? 0xffffffff : (1u << bpp) - 1);
+			gfx_fill_rect(&s, 0, 0, FB_WIDTH, FB_HEIGHT, color);
+			gfx_sync();
+			_ref_fill(&ref, 0, 0, FB_WIDTH, FB_HEIGHT, color);
+			if (memcmp(fb, fb_ref, size))
+				errors++;
+		}
+	}
+	rows = gfx_get_dma_rows() - rows;
+	if (rows != DMA_CHECK_OPS * FB_HEIGHT)
+		errors++;
+	gfx_enable_dma(&s, false);
+
+	printf("-I- %2u bpp: %u error(s), %u of %u row(s) by DMA\r\n",
+	       (unsigned)bpp, (unsigned)errors, (unsigned)rows,
+	       (unsigned)(DMA_CHECK_OPS * FB_HEIGHT));
+	return errors;
+}
+#endif
+
+/*
+ * Benchmarks
+ */
+
+static void _run_ref_fill(void* arg)
+{
+	struct _bench_arg* a = (struct _bench_arg*)arg;
+
+	_ref_fill(a->surface, a->x, a->y, a->w, a->h, 0x123456);
+}
+
+static void _run_fill(void* arg)
+{
+	struct _bench_arg* a = (struct _bench_arg*)arg;
+
+	gfx_fill_rect(a->surface, a->x, a->y, a->w, a->h, 0x123456);
+	gfx_sync();
+}
+
+static void _run_ref_text(void* arg)
+{
+	struct _bench_arg* a = (struct _bench_arg*)arg;
+	int i;
+
+	for (i = 0; i < 10; i++)
+		_ref_string(a->surface, a->x, a->y + i * 16, &font10x14, bench_text,
+		            0xffffff);
+}
+
+static void _run_text(void* arg)
+{
+	struct _bench_arg* a = (struct _bench_arg*)arg;
+	int i;
+
+	for (i = 0; i < 10; i++)
+		gfx_draw_string(a->surface, a->x, a->y + i * 16, &font10x14,
+		                bench_text, 0xffffff, 0, false);
+}
+
+static void _run_blit(void* arg)
+{
+	struct _bench_arg* a = (struct _bench_arg*)arg;
+
+	gfx_blit(a->surface, a->x, a->y, fb_img, a->surface->stride, a->w, a->h);
+	gfx_sync();
+}
+
+static void _run_scroll(void* arg)
+{
+	struct _bench_arg* a = (struct _bench_arg*)arg;
+
+	gfx_copy_rect(a->surface, 0, 0, a->surface, 0, 16, a->surface->width,
+	              a->surface->height - 16);
+}
+
+static void _run_blend(void* arg)
+{
+	struct _bench_arg* a = (struct _bench_arg*)arg;
+
+	gfx_blend_rect(a->surface, a->x, a->y, a->w, a->h, 0x80000000);
+}
+
+static void _run_icons(void* arg)
+{
+	struct _bench_arg* a = (struct _bench_arg*)arg;
+	int i;
+
+	for (i = 0; i < 8; i++)
+		gfx_blit_argb(a->surface, a->x + i * ICON_SIZE, a->y, icon,
+		              ICON_SIZE, ICON_SIZE, ICON_SIZE);
+}
+
+#ifdef CONFIG_ARCH_ARM
+static void _run_clean_all(void* arg)
+{
+	struct _bench_arg* a = (struct _bench_arg*)arg;
+
+	cache_clean_region(a->surface->buffer,
+	                   a->surface->stride * a->surface->height);
+}
+
+static void _prepare_flush(void* arg)
+{
+	struct _bench_arg* a = (struct _bench_arg*)arg;
+
+	/* a status line update */
+	gfx_fill_rect(a->surface, a->x, a->y, 400, 16, 0);
+	gfx_draw_string(a->surface, a->x, a->y, &font10x14, bench_text,
+	                0xffffff, 0, false);
+}
+
+static void _run_flush(void* arg)
+{
+	struct _bench_arg* a = (struct _bench_arg*)arg;
+
+	gfx_flush(a->surface);
+}
+#endif
+
+static void _bench(const char* name, void (*prepare)(void*),
+		void (*run)(void*), struct _bench_arg* arg, uint32_t bytes)
+{
+	struct _perf_bench bench;
+	struct _perf_result result;
+	char full_name[32];
+
+	memset(&bench, 0, sizeof(bench));
+	snprintf(full_name, sizeof(full_name), "%s %u", name,
+	         (unsigned)arg->surface->bpp);
+	bench.name = full_name;
+	bench.bytes = bytes;
+	bench.arg = arg;
+	bench.prepare = prepare;
+	bench.run = run;
+	if (perf_bench_run(&bench, BENCH_RUNS, &result) == 0)
+		perf_bench_print(&bench, &result);
+}
+
+static void _bench_bpp(uint8_t bpp)
+{
+	struct _gfx_surface s;
+	struct _bench_arg arg = { &s, 0, 0, FB_WIDTH, FB_HEIGHT };
+	uint32_t frame;
+#ifdef CONFIG_ARCH_ARM
+	uint32_t rows;
+#endif
+
+	gfx_surface_initialize(&s, fb, FB_WIDTH, FB_HEIGHT, bpp);
+	frame = s.stride * s.height;
+
+	_bench("ref fill screen", NULL, _run_ref_fill, &arg, frame);
+	_bench("fill screen", NULL, _run_fill, &arg, frame);
+	arg.x = 100;
+	arg.y = 100;
+	arg.w = 100;
+	arg.h = 100;
+	_bench("ref fill 100x100", NULL, _run_ref_fill, &arg, 0);
+	_bench("fill 100x100", NULL, _run_fill, &arg, 0);
+	arg.x = 10;
+	arg.y = 10;
+	_bench("ref text 10 lines", NULL, _run_ref_text, &arg, 0);
+	_bench("text 10 lines", NULL, _run_text, &arg, 0);
+	arg.w = 400;
+	arg.h = 240;
+	_bench("blit 400x240", NULL, _run_blit, &arg, 400 * 240 * bpp / 8);
+	_bench("scroll screen", NULL, _run_scroll, &arg, frame);
+	_bench("blend 400x240", NULL, _run_blend, &arg, 400 * 240 * bpp / 8);
+	_bench("8 icons 64x64", NULL, _run_icons, &arg, 0);
+
+#ifdef CONFIG_ARCH_ARM
+	gfx_enable_dma(&s, true);
+	rows = gfx_get_dma_rows();
+	arg.x = 0;
+	arg.y = 0;
+	arg.w = FB_WIDTH;
+	arg.h = FB_HEIGHT;
+	_bench("dma fill screen", NULL, _run_fill, &arg, frame);
+	arg.w = 400;
+	arg.h = 240;
+	_bench("dma blit 400x240", NULL, _run_blit, &arg, 400 * 240 * bpp / 8);
+	gfx_enable_dma(&s, false);
+	printf("-I- %u row(s) by DMA\r\n", (unsigned)(gfx_get_dma_rows() - rows));
+
+	arg.x = 10;
+	arg.y = 200;
+	_bench("clean canvas", _prepare_flush, _run_clean_all, &arg, frame);
+	_bench("flush status line", _prepare_flush, _run_flush, &arg, 0);
+#endif
+}
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	uint32_t errors = 0;
+	uint32_t i;
+
+#ifdef CONFIG_ARCH_ARM
+	console_example_info("2D Drawing Benchmark");
+#else
+	printf("-- 2D Drawing Benchmark (host) --\r\n");
+#endif
+
+	errors += _check(16);
+	errors += _check(24);
+	errors += _check(32);
+#ifdef CONFIG_ARCH_ARM
+	errors += _check_dma(16);
+	errors += _check_dma(24);
+	errors += _check_dma(32);
+#endif
+	printf("-I- Functional check: %u error(s)\r\n", (unsigned)errors);
+
+	/* round icon, alpha fading to the border */
+	for (i = 0; i < ARRAY_SIZE(icon); i++) {
+		int x = (int)(i % ICON_SIZE) - ICON_SIZE / 2;
+		int y = (int)(i / ICON_SIZE) - ICON_SIZE / 2;
+		int d = x * x + y * y;
+		int a = d > ICON_SIZE * ICON_SIZE / 4 ? 0 :
+		        255 - d * 255 / (ICON_SIZE * ICON_SIZE / 4);
+		icon[i] = ((uint32_t)a << 24) | 0x3080c0;
+	}
+
+	perf_initialize();
+	printf("%u runs per benchmark, figures of the best run\r\n",
+	       (unsigned)BENCH_RUNS);
+	perf_bench_print_header();
+	_bench_bpp(16);
+	_bench_bpp(24);
+	_bench_bpp(32);
+
+#ifdef CONFIG_ARCH_ARM
+	while (1);
+#else
+	return errors ? 1 : 0;
+#endif
+}
@@ -0,0 +1,443 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \page inet_cksum_bench Internet Checksum Benchmark
+ *
+ * \section Purpose
+ *
+ * This example checks and measures the Internet checksum library
+ * (inet_cksum.h) used by the uIP and lwIP ports.
+ *
+ * \section Requirements
+ *
+ * This package can be used with all SAMA5D2x, SAMA5D3x, SAMA5D4x and SAM9xx5
+ * boards, no network device is used.  It can also be compiled for a Linux
+ * host with Makefile.linux, in which case the portable implementation is
+ * checked and measured.
+ *
+ * \section Description
+ *
+ * The checksum and the copy-and-checksum functions are compared with the
+ * byte-wise reference implementation of uIP for random lengths, alignments,
+ * initial sums and contents, including buffers of 0xff bytes that produce
+ * a carry on each addition.  The copy is also checked not to write outside
+ * of the destination buffer.  Then the throughput of the reference and of
+ * the library functions is printed for usual packet sizes, in MB/s and, when
+ * the core has a cycle counter, in bytes per cycle.
+ *
+ * \section Usage
+ *
+ * -# Build the program and download it inside the board.
+ * -# On the computer, open and configure a terminal application
+ *    (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *   - 115200 baud rate
+ *   - 8 bits of data
+ *   - No parity
+ *   - 1 stop bit
+ *   - No flow control
+ * -# Start the application, the results are printed on the console.
+ * -# To run it on a Linux computer, run "make -f Makefile.linux" and
+ *    "./inet_cksum_bench" in the example directory.
+ *
+ * \section References
+ * - inet_cksum_bench/main.c
+ * - inet_cksum.h
+ * - perf.h
+ */
+
+/** \file
+ *
+ *  This file contains all the specific code for the Internet checksum
+ *  benchmark.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "compiler.h"
+#include "inet_cksum.h"
+#include "perf.h"
+
+#ifdef CONFIG_ARCH_ARM
+#include "board.h"
+#include "chip.h"
+#include "trace.h"
+
+#include "serial/console.h"
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Number of random checks of each function */
+#ifdef CONFIG_ARCH_ARM
+#define FUZZ_RUNS 20000
+#else
+#define FUZZ_RUNS 500000
+#endif
+
+/** Maximum length of the random checks */
+#define FUZZ_MAX_LEN 2048
+
+/** Length of the large buffer check (several NEON passes) */
+#define LARGE_LEN (3 * 65536 + 77)
+
+/** Guard bytes around the copy destination */
+#define GUARD 8
+
+/** Fill value of the guard bytes */
+#define GUARD_BYTE 0xa5
+
+/** Number of measured runs per benchmark */
+#define BENCH_RUNS 10
+
+/** Packets summed per benchmark run */
+#define BENCH_PACKETS 64
+
+/*----------------------------------------------------------------------------
+ *        Local types
+ *----------------------------------------------------------------------------*/
+
+struct _bench_arg {
+	uint32_t len;
+	uint32_t offset;
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static uint8_t src_buf[LARGE_LEN + 8];
+static uint8_t dst_buf[LARGE_LEN + 8 + 2 * GUARD];
+
+static uint32_t rand_state = 1;
+
+static volatile uint16_t bench_sum;
+
+static const uint32_t bench_sizes[] = { 64, 576, 1500 };
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint32_t _rand(void)
+{
+	rand_state = rand_state * 1103515245 + 12345;
+	return rand_state >> 8;
+}
+
+/**
+ * \brief Convert between a sum of big endian words and the same sum in
+ * memory byte order (the conversion is its own inverse)
+ */
+static uint16_t _to_mem(uint16_t sum)
+{
+	uint8_t b[2] = { (uint8_t)(sum >> 8), (uint8_t)sum };
+	uint16_t v;
+
+	memcpy(&v, b, sizeof(v));
+	return v;
+}
+
+/**
+ * \brief Reference implementation: byte-wise chksum() of uIP, returns the
+ * sum in memory byte order
+ */
+static uint16_t _ref_cksum(uint16_t sum, const uint8_t* data, uint32_t len)
+{
+	const uint8_t* last_byte = data + len - 1;
+	uint16_t t;
+
+	sum = _to_mem(sum);
+	while (len && data < last_byte) {
+		t = (data[0] << 8) + data[1];
+		sum += t;
+		if (sum < t)
+			sum++;
+		data += 2;
+	}
+	if (len && data == last_byte) {
+		t = data[0] << 8;
+		sum += t;
+		if (sum < t)
+			sum++;
+	}
+	return _to_mem(sum);
+}
+
+static void _fill(uint8_t* buf, uint32_t len)
+{
+	uint32_t i;
+
+	switch (_rand() % 4) {
+	case 0:
+		/* a carry on each addition */
+		memset(buf, 0xff, len);
+		break;
+	case 1:
+		for (i = 0; i < len; i++)
+			buf[i] = (_rand() & 1) ? 0xff : (uint8_t)_rand();
+		break;
+	default:
+		for (i = 0; i < len; i++)
+			buf[i] = (uint8_t)_rand();
+		break;
+	}
+}
+
+static uint32_t _rand_len(void)
+{
+	/* mostly short buffers, where the alignment code matters */
+	if (_rand() % 2)
+		return _rand() % 64;
+	return _rand() % (FUZZ_MAX_LEN + 1);
+}
+
+static uint32_t _check_add(void)
+{
+	uint32_t errors = 0;
+	uint32_t run;
+
+	for (run = 0; run < FUZZ_RUNS; run++) {
+		uint32_t len = _rand_len();
+		uint32_t off = _rand() % 8;
+		uint16_t sum = (run % 4) ? (uint16_t)_rand() : 0;
+		uint16_t ref, res;
+
+		_fill(src_buf + off, len);
+		ref = _ref_cksum(sum, src_buf + off, len);
+		res = inet_cksum_add(sum, src_buf + off, len);
+		if (res != ref) {
+			if (errors < 10)
+				printf("-E- add: len %u offset %u sum 0x%04x: "
+				       "0x%04x, expected 0x%04x\r\n",
+				       (unsigned)len, (unsigned)off,
+				       (unsigned)sum, (unsigned)res,
+				       (unsigned)ref);
+			errors++;
+		}
+	}
+
+	/* Large buffers of 0xff, worst case for the accumulators */
+	memset(src_buf, 0xff, sizeof(src_buf));
+	for (run = 0; run < 2; run++) {
+		uint16_t ref = _ref_cksum(0, src_buf + run, LARGE_LEN);
+		uint16_t res = inet_cksum_add(0, src_buf + run, LARGE_LEN);
+		if (res != ref) {
+			printf("-E- add: large buffer offset %u: 0x%04x, "
+			       "expected 0x%04x\r\n", (unsigned)run,
+			       (unsigned)res, (unsigned)ref);
+			errors++;
+		}
+	}
+
+	printf("-I- inet_cksum_add: %u error(s)\r\n", (unsigned)errors);
+	return errors;
+}
+
+static uint32_t _check_copy(void)
+{
+	uint32_t errors = 0;
+	uint32_t run, i;
+
+	for (run = 0; run < FUZZ_RUNS; run++) {
+		uint32_t len = _rand_len();
+		uint32_t soff = _rand() % 8;
+		uint32_t doff = (run % 2) ? soff : _rand() % 8;
+		uint8_t* dst = dst_buf + GUARD + doff;
+		bool ok = true;
+		uint16_t ref, res;
+
+		_fill(src_buf + soff, len);
+		memset(dst_buf, GUARD_BYTE, len + 8 + 2 * GUARD);
+		ref = _ref_cksum(0, src_buf + soff, len);
+		res = inet_cksum_copy(dst, src_buf + soff, len);
+
+		if (memcmp(dst, src_buf + soff, len))
+			ok = false;
+		for (i = 0; i < GUARD + doff; i++)
+			if (dst_buf[i] != GUARD_BYTE)
+				ok = false;
+		for (i = 0; i < GUARD; i++)
+			if (dst[len + i] != GUARD_BYTE)
+				ok = false;
+
+		if (res != ref || !ok) {
+			if (errors < 10)
+				printf("-E- copy: len %u offsets %u/%u: "
+				       "0x%04x, expected 0x%04x%s\r\n",
+				       (unsigned)len, (unsigned)soff,
+				       (unsigned)doff, (unsigned)res,
+				       (unsigned)ref,
+				       ok ? "" : ", bad data");
+			errors++;
+		}
+	}
+
+	memset(src_buf, 0xff, sizeof(src_buf));
+	for (run = 0; run < 2; run++) {
+		uint16_t ref = _ref_cksum(0, src_buf + run, LARGE_LEN);
+		uint16_t res = inet_cksum_copy(dst_buf + run, src_buf + run,
+				LARGE_LEN);
+		if (res != ref || memcmp(dst_buf + run, src_buf + run,
+				LARGE_LEN)) {
+			printf("-E- copy: large buffer offset %u: 0x%04x, "
+			       "expected 0x%04x\r\n", (unsigned)run,
+			       (unsigned)res, (unsigned)ref);
+			errors++;
+		}
+	}
+
+	printf("-I- inet_cksum_copy: %u error(s)\r\n", (unsigned)errors);
+	return errors;
+}
+
+static void _run_ref(void* arg)
+{
+	struct _bench_arg* b = (struct _bench_arg*)arg;
+	uint32_t i;
+
+	for (i = 0; i < BENCH_PACKETS; i++)
+		bench_sum = _ref_cksum(0, src_buf + b->offset, b->len);
+}
+
+static void _run_add(void* arg)
+{
+	struct _bench_arg* b = (struct _bench_arg*)arg;
+	uint32_t i;
+
+	for (i = 0; i < BENCH_PACKETS; i++)
+		bench_sum = inet_cksum_add(0, src_buf + b->offset, b->len);
+}
+
+static void _run_memcpy_add(void* arg)
+{
+	struct _bench_arg* b = (struct _bench_arg*)arg;
+	uint32_t i;
+
+	for (i = 0; i < BENCH_PACKETS; i++) {
+		memcpy(dst_buf + b->offset, src_buf + b->offset, b->len);
+		bench_sum = inet_cksum_add(0, dst_buf + b->offset, b->len);
+	}
+}
+
+static void _run_copy(void* arg)
+{
+	struct _bench_arg* b = (struct _bench_arg*)arg;
+	uint32_t i;
+
+	for (i = 0; i < BENCH_PACKETS; i++)
+		bench_sum = inet_cksum_copy(dst_buf + b->offset,
+				src_buf + b->offset, b->len);
+}
+
+static void _bench(const char* name, void (*run)(void*),
+		struct _bench_arg* arg)
+{
+	struct _perf_bench bench;
+	struct _perf_result result;
+	char label[32];
+
+	snprintf(label, sizeof(label), "%s %u%s", name, (unsigned)arg->len,
+		 arg->offset ? "+1" : "");
+	memset(&bench, 0, sizeof(bench));
+	bench.name = label;
+	bench.bytes = arg->len * BENCH_PACKETS;
+	bench.arg = arg;
+	bench.run = run;
+	if (perf_bench_run(&bench, BENCH_RUNS, &result) == 0) {
+		perf_bench_print(&bench, &result);
+		if (result.best.cycles) {
+			uint32_t bpc = (uint32_t)((uint64_t)bench.bytes * 100 /
+					result.best.cycles);
+			printf("    %u.%02u bytes/cycle\r\n",
+			       (unsigned)(bpc / 100), (unsigned)(bpc % 100));
+		}
+	}
+}
+
+static void _bench_all(void)
+{
+	struct _bench_arg arg;
+	uint32_t i, j;
+
+	for (i = 0; i < sizeof(src_buf); i++)
+		src_buf[i] = (uint8_t)_rand();
+
+	for (i = 0; i < ARRAY_SIZE(bench_sizes); i++) {
+		for (j = 0; j < 2; j++) {
+			arg.len = bench_sizes[i];
+			arg.offset = j;
+			_bench("ref", _run_ref, &arg);
+			_bench("add", _run_add, &arg);
+			_bench("memcpy+add", _run_memcpy_add, &arg);
+			_bench("copy", _run_copy, &arg);
+		}
+	}
+}
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	uint32_t errors = 0;
+
+#ifdef CONFIG_ARCH_ARM
+	console_example_info("Internet Checksum Benchmark");
+#else
+	printf("-- Internet Checksum Benchmark (host) --\r\n");
+#endif
+
+	errors += _check_add();
+	errors += _check_copy();
+	printf("-I- Functional check: %u error(s)\r\n", (unsigned)errors);
+
+	perf_initialize();
+	printf("%u runs of %u packets per benchmark, figures of the best run\r\n",
+	       (unsigned)BENCH_RUNS, (unsigned)BENCH_PACKETS);
+	perf_bench_print_header();
+	_bench_all();
+
+#ifdef CONFIG_ARCH_ARM
+	while (1);
+#else
+	return errors ? 1 : 0;
+#endif
+}
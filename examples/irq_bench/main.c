@@ -0,0 +1,274 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \page irq_bench IRQ Dispatch Benchmark
+ *
+ * \section Purpose
+ *
+ * This example measures the CPU cycles spent by the interrupt dispatcher
+ * between the interrupt request and the call of the handler.
+ *
+ * \section Requirements
+ *
+ * This package can be used with SAMA5D2x, SAMA5D3x, SAMA5D4x, SAME70 and
+ * SAMV71 boards (a cycle counter is required).
+ *
+ * \section Description
+ *
+ * An otherwise unused interrupt source is triggered by software in a loop,
+ * its handler timestamps its entry with the CPU cycle counter and the main
+ * loop timestamps the return.  Three dispatch paths are measured:
+ * - vectored: a single handler registered with irq_add_handler(), called
+ *   directly from the per-source vector,
+ * - shared: two handlers registered on the source, walked as a chain,
+ * - legacy: a common vector reading back the current source from the
+ *   interrupt controller and walking a handler list, as the dispatcher did
+ *   before per-source vectors were used.
+ *
+ * The legacy vector replaces the irq layer one for the benchmark source, so
+ * it is measured last.
+ *
+ * \section Usage
+ *
+ * -# Build the program and download it inside the board.
+ * -# On the computer, open and configure a terminal application
+ *    (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *   - 115200 baud rate
+ *   - 8 bits of data
+ *   - No parity
+ *   - 1 stop bit
+ *   - No flow control
+ * -# Start the application, the results are printed on the console.
+ *
+ * \section References
+ * - irq_bench/main.c
+ * - irq.h
+ * - cycle_counter.h
+ */
+
+/** \file
+ *
+ *  This file contains all the specific code for the IRQ dispatch benchmark.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "barriers.h"
+#include "board.h"
+#include "chip.h"
+#include "cycle_counter.h"
+#include "trace.h"
+
+#if defined(CONFIG_HAVE_AIC5)
+#include "irq/aic.h"
+#elif defined(CONFIG_HAVE_NVIC)
+#include "irq/nvic.h"
+#endif
+#include "irq/irq.h"
+#include "serial/console.h"
+
+#ifndef CONFIG_HAVE_CYCLE_COUNTER
+#error This example requires a cycle counter (ARMv7-A PMU or ARMv7-M DWT)
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Interrupt source triggered by software, its peripheral is left unused */
+#define BENCH_SOURCE ID_TC1
+
+/** Number of interrupts per measurement */
+#define BENCH_ITERATIONS 10000
+
+/*----------------------------------------------------------------------------
+ *        Local types
+ *----------------------------------------------------------------------------*/
+
+struct _bench_result {
+	uint32_t entry_min;
+	uint32_t entry_max;
+	uint64_t entry_total;
+	uint32_t total_min;
+	uint32_t total_max;
+	uint64_t total_total;
+};
+
+struct _legacy_entry {
+	irq_handler_t handler;
+	void* user_arg;
+	struct _legacy_entry* next;
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static volatile bool bench_done;
+static volatile uint32_t bench_entry;
+
+static struct _legacy_entry legacy_entry;
+static struct _legacy_entry* legacy_handlers[ID_PERIPH_COUNT];
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static void _bench_handler(uint32_t source, void* user_arg)
+{
+	bench_entry = cycle_counter_read();
+	bench_done = true;
+}
+
+static void _dummy_handler(uint32_t source, void* user_arg)
+{
+}
+
+/**
+ * \brief Dispatcher as it was before per-source vectors: read the current
+ * source back from the interrupt controller and walk its handler list.
+ */
+static void _legacy_irq_handler(void)
+{
+	uint32_t source;
+	struct _legacy_entry* entry;
+
+#if defined(CONFIG_HAVE_AIC5)
+	source = aic_get_current_interrupt_source();
+#elif defined(CONFIG_HAVE_NVIC)
+	source = nvic_get_current_interrupt_source();
+#endif
+
+	entry = legacy_handlers[source];
+	if (!entry) {
+		// no handler for interrupt, block
+		while (1);
+	}
+
+	while (entry) {
+		if (entry->handler)
+			entry->handler(source, entry->user_arg);
+		entry = entry->next;
+	}
+}
+
+static void _trigger(uint32_t source)
+{
+#if defined(CONFIG_HAVE_AIC5)
+	AIC->AIC_SSR = AIC_SSR_INTSEL(source);
+	AIC->AIC_ISCR = AIC_ISCR_INTSET;
+#elif defined(CONFIG_HAVE_NVIC)
+	NVIC->NVIC_STIR = NVIC_STIR_INTID(source);
+#endif
+	dsb();
+}
+
+static void _run(const char* name)
+{
+	struct _bench_result r = { .entry_min = UINT32_MAX, .total_min = UINT32_MAX };
+	uint32_t i, start, entry, total;
+
+	for (i = 0; i < BENCH_ITERATIONS; i++) {
+		bench_done = false;
+		start = cycle_counter_read();
+		_trigger(BENCH_SOURCE);
+		while (!bench_done);
+		total = cycle_counter_read() - start;
+		entry = bench_entry - start;
+
+		if (entry < r.entry_min)
+			r.entry_min = entry;
+		if (entry > r.entry_max)
+			r.entry_max = entry;
+		r.entry_total += entry;
+		if (total < r.total_min)
+			r.total_min = total;
+		if (total > r.total_max)
+			r.total_max = total;
+		r.total_total += total;
+	}
+
+	printf("%-9s %6u/%6u/%6u   %6u/%6u/%6u\r\n", name,
+		(unsigned)r.entry_min,
+		(unsigned)(r.entry_total / BENCH_ITERATIONS),
+		(unsigned)r.entry_max,
+		(unsigned)r.total_min,
+		(unsigned)(r.total_total / BENCH_ITERATIONS),
+		(unsigned)r.total_max);
+}
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	console_example_info("IRQ Dispatch Benchmark");
+
+	cycle_counter_enable();
+
+	/* internal edge-triggered, so that the software trigger is latched */
+	irq_configure_mode(BENCH_SOURCE, IRQ_MODE_NEGATIVE_EDGE);
+	irq_enable(BENCH_SOURCE);
+
+	printf("%u interrupts per test, CPU cycles\r\n",
+		(unsigned)BENCH_ITERATIONS);
+	printf("path      entry min/avg/max        round trip min/avg/max\r\n");
+
+	irq_add_handler(BENCH_SOURCE, _bench_handler, NULL);
+	_run("vectored");
+
+	irq_add_handler(BENCH_SOURCE, _dummy_handler, NULL);
+	_run("shared");
+	irq_remove_handler(BENCH_SOURCE, _dummy_handler);
+	irq_remove_handler(BENCH_SOURCE, _bench_handler);
+
+	legacy_entry.handler = _bench_handler;
+	legacy_entry.user_arg = NULL;
+	legacy_entry.next = NULL;
+	legacy_handlers[BENCH_SOURCE] = &legacy_entry;
+#if defined(CONFIG_HAVE_AIC5)
+	aic_set_source_vector(BENCH_SOURCE, _legacy_irq_handler);
+#elif defined(CONFIG_HAVE_NVIC)
+	nvic_set_source_vector(BENCH_SOURCE, _legacy_irq_handler);
+#endif
+	_run("legacy");
+
+	irq_disable(BENCH_SOURCE);
+
+	while (1);
+}
@@ -134,7 +134,7 @@
 /** Supported sensor profiles */
 static struct sensor_profile *sensor;
 
-CACHE_ALIGNED uint32_t buffer_histogram[HIST_ENTRIES];
+CACHE_ALIGNED uint32_t buffer_histogram[BAYER_COUNT * HIST_ENTRIES];
 
 /** LCD buffer.*/
 static uint8_t *heo_buffer = (uint8_t*)ISC_OUTPUT_BASE_ADDRESS;
@@ -249,6 +249,9 @@ static void configure_isc(void)
 	iscd.cfg.input_format = sensor_mode;
 	iscd.pipe.histo_enable = true;
 	iscd.pipe.histo_buf = buffer_histogram;
+	iscd.pipe.ae.ae_enable = true;
+	iscd.pipe.ae.twi_bus = SENSOR_TWI_BUS;
+	iscd.pipe.ae.sensor = sensor;
 	iscd_pipe_start(&iscd);
 }
 
@@ -43,14 +43,13 @@
 #include "board.h"
 #include "compiler.h"
 
+#include "display/gfx.h"
 #include "display/lcdc.h"
 
 #include "lcd_draw.h"
 #include "lcd_font.h"
 #include "font.h"
 
-#include <string.h>
-#include <stdlib.h>
 #include <assert.h>
 
 /*----------------------------------------------------------------------------
@@ -60,6 +59,9 @@
 /** Front color cache */
 static uint32_t front_color;
 
+/** Drawing surface on the canvas layer */
+static struct _gfx_surface canvas;
+
 /*----------------------------------------------------------------------------
  *        Local functions
  *----------------------------------------------------------------------------*/
@@ -73,10 +75,12 @@ static void _hide_canvas(void)
 }
 
 /**
- * Update canvas
+ * Update canvas: write back the lines drawn by the CPU
  */
 static void _show_canvas(void)
 {
+	if (canvas.buffer != NULL)
+		gfx_flush(&canvas);
 	//lcdc_enable_layer(lcdc_get_canvas()->layer_id, true);
 }
 
@@ -97,39 +101,11 @@ static void _set_front_color(uint32_t color)
  */
 static void _draw_pixel(uint32_t dwX, uint32_t dwY)
 {
-	struct _lcdc_layer *pDisp = lcdc_get_canvas();
-	uint8_t *buffer = pDisp->buffer;
-	uint16_t w = pDisp->width;
-	//uint16_t h = pDisp->height;
-	uint16_t cw = pDisp->bpp / 8;	/* color width */
-	uint32_t rw = w * cw;	/* row width in bytes */
-	//uint8_t  r, g, b;
-	uint8_t *pPix;
-
-	if (buffer == NULL)
-		return;
+	struct _gfx_surface *surface = lcd_get_surface();
 
-	if (rw & 0x3)
-		rw = (rw | 0x3) + 1;	/* 4-byte aligned rows */
-	pPix = &buffer[dwY * rw + cw * dwX];
-
-	switch (pDisp->bpp) {
-	case 16:		/* TRGB 1555 */
-		pPix[0] = (front_color) & 0xFF;
-		pPix[1] = (front_color >> 8) & 0xFF;
-		break;
-	case 24:		/*  RGB  888 */
-		pPix[0] = (front_color) & 0xFF;
-		pPix[1] = (front_color >> 8) & 0xFF;
-		pPix[2] = (front_color >> 16) & 0xFF;
-		break;
-	case 32:		/* ARGB 8888 */
-		pPix[0] = (front_color) & 0xFF;
-		pPix[1] = (front_color >> 8) & 0xFF;
-		pPix[2] = (front_color >> 16) & 0xFF;
-		pPix[3] = (front_color >> 24) & 0xFF;
-		break;
-	}
+	if (surface->buffer == NULL)
+		return;
+	gfx_draw_pixel(surface, dwX, dwY, front_color);
 }
 
 /**
@@ -141,146 +117,45 @@ static void _draw_pixel(uint32_t dwX, uint32_t dwY)
  */
 static void _fill_rect(uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2)
 {
-	struct _lcdc_layer *pDisp = lcdc_get_canvas();
-	uint16_t w = pDisp->width;
-	uint16_t cw = pDisp->bpp / 8;	/* color width */
-	uint32_t rw = w * cw;	/* row width in bytes */
-	uint8_t *base;
-	uint8_t *buffer = pDisp->buffer;
-	uint32_t fillStart, fillEnd;
-	uint32_t i;
-	if (buffer == NULL)
-		return;
-
-	/* 4-byte aligned rows */
-	if (rw & 0x3)
-		rw = (rw | 0x3) + 1;
-	/* Buffer address for the starting row */
-	base = &buffer[dwY1 * rw];
-
-	fillStart = dwX1 * cw;
-	fillEnd = dwX2 * cw;
-
-#if 1				/* Memcopy pixel */
-	buffer = base;
-	for (; dwY1 <= dwY2; dwY1++) {
-		for (i = fillStart; i <= fillEnd; i += cw) {
-			memcpy(&buffer[i], &front_color, cw);
-		}
-		buffer = &buffer[rw];
-	}
-#endif
-
-#if 0				/* Pixel by pixel */
-	for (; dwY1 <= dwY2; dwY1++) {
-		for (i = dwX1; i <= dwX2; i++) {
-			_draw_pixel(i, dwY1);
-		}
-	}
-#endif
+	struct _gfx_surface *surface = lcd_get_surface();
 
-#if 0				/* Optimized */
-	/* First row */
-	for (i = fillStart; i <= fillEnd; i += cw) {
-		memcpy(&base[i], &front_color, cw);
-	}
-	/* Next rows, copy first */
-	buffer = &base[rw + fillStart];
-	for (i = dwY1 + 1; i <= dwY2; i++) {
-		memcpy(buffer, &base[fillStart], fillEnd - fillStart + cw);
-		buffer = &buffer[rw];
-	}
-#endif
+	if (surface->buffer == NULL)
+		return;
+	gfx_fill_rect(surface, dwX1, dwY1, dwX2 - dwX1 + 1, dwY2 - dwY1 + 1,
+		      front_color);
 }
 
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
 /**
- * \brief Draw a line on LCD, which is not horizontal or vertical.
- *
- * \param dwX1       X-coordinate of line start.
- * \param dwY1       Y-coordinate of line start.
- * \param dwX2       X-coordinate of line end.
- * \param dwY2       Y-coordinate of line end.
+ * \brief Get the drawing surface of the canvas, following canvas changes.
  */
-
-/*
-static uint32_t _draw_line_bresenham (uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2)
+struct _gfx_surface *lcd_get_surface(void)
 {
-	int dx, dy;
-	int i;
-	int xinc, yinc, cumul;
-	int x, y;
-
-	x = dwX1;
-	y = dwY1;
-	dx = dwX2 - dwX1;
-	dy = dwY2 - dwY1;
-
-	xinc = (dx > 0) ? 1 : -1;
-	yinc = (dy > 0) ? 1 : -1;
-	dx = (dx > 0) ? dx : -dx;
-	dy = (dy > 0) ? dy : -dy;
-
-	_draw_pixel(x, y);
-
-	if (dx > dy) {
-		cumul = dx / 2;
-		for (i = 1; i <= dx; i++) {
-			x += xinc;
-			cumul += dy;
-
-			if (cumul >= dx) {
-				cumul -= dx;
-				y += yinc;
-			}
-			_draw_pixel(x, y);
-		}
-	} else {
-		cumul = dy / 2;
-		for (i = 1; i <= dy; i++) {
-			y += yinc;
-			cumul += dx;
-
-			if (cumul >= dy) {
-				cumul -= dy;
-				x += xinc;
-			}
+	struct _lcdc_layer *pDisp = lcdc_get_canvas();
 
-			_draw_pixel(x, y);
-		}
+	if (canvas.buffer != pDisp->buffer || canvas.width != pDisp->width ||
+	    canvas.height != pDisp->height || canvas.bpp != pDisp->bpp) {
+		if (gfx_surface_initialize(&canvas, pDisp->buffer, pDisp->width,
+					   pDisp->height, pDisp->bpp) < 0)
+			canvas.buffer = NULL;	/* not a RGB canvas */
+		else
+			gfx_enable_dma(&canvas, true);
 	}
-
-	return 0;
+	return &canvas;
 }
-*/
 
-static uint32_t _draw_line_bresenham (uint32_t dwX1, uint32_t dwY1, uint32_t dwX2, uint32_t dwY2)
+/**
+ * \brief Write back the lines drawn on the canvas since last flush, for the
+ * LCD controller to display them.
+ */
+void lcd_flush(void)
 {
-    int dx = abs(dwX2 - dwX1);
-    int dy = abs(dwY2 - dwY1);
-    int sx = (dwX1 < dwX2) ? 1 : -1;
-    int sy = (dwY1 < dwY2) ? 1 : -1;
-    int err = dx - dy;
-    int e2 ;
-
-    while (1) {
-      _draw_pixel(dwX1, dwY1);
-      if ((dwX1 == dwX2) && (dwY1 == dwY2))
-        break;
-      e2 = 2 * err;
-	  if (e2 > -dy) {
-		  err -= dy; dwX1 += sx;
-	  }
-      if (e2 < dx) {
-		  err += dx; dwY1 += sy;
-	  }
-    }
-	return 0;
+	_show_canvas();
 }
 
-/*----------------------------------------------------------------------------
- *        Exported functions
- *----------------------------------------------------------------------------*/
-
 /**
  * \brief Fills the given LCD buffer with a particular color.
  *
@@ -333,36 +208,11 @@ void lcd_draw_pixel(uint32_t x, uint32_t y, uint32_t color)
  */
 extern uint32_t lcd_read_pixel(uint32_t x, uint32_t y)
 {
-	struct _lcdc_layer *pDisp = lcdc_get_canvas();
-	uint8_t *buffer = pDisp->buffer;
-	uint16_t w = pDisp->width;
-	//uint16_t h = pDisp->height;
-	uint16_t cw = pDisp->bpp / 8;	/* color width */
-	uint32_t rw = w * cw;	/* row width in bytes */
-	uint8_t *pPix;
-	uint32_t color = 0;
-
-	if (buffer == NULL)
-		return 0;
+	struct _gfx_surface *surface = lcd_get_surface();
 
-	if (rw & 0x3)
-		rw = (rw | 0x3) + 1;	/* 4-byte aligned rows */
-	pPix = &buffer[x * rw + cw * y];
-
-	switch (pDisp->bpp) {
-	case 16:		/* TRGB 1555 */
-		color = pPix[0] | (pPix[1] << 8);
-		break;
-	case 24:		/*  RGB  888 */
-		color = pPix[0] | (pPix[1] << 8) | (pPix[2] << 16);
-		break;
-	case 32:		/* ARGB 8888 */
-		color =
-			pPix[0] | (pPix[1] << 8) | (pPix[2] << 16) | (pPix[3] <<
-								      24);
-		break;
-	}
-	return color;
+	if (surface->buffer == NULL)
+		return 0;
+	return gfx_read_pixel(surface, x, y);
 }
 
 /**
@@ -390,7 +240,8 @@ void lcd_draw_line(uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2,
 		lcd_draw_filled_rectangle(x1, y1, x2, y2, color);
 	} else {
 		_hide_canvas();
-		_draw_line_bresenham(x1, y1, x2, y2);
+		if (lcd_get_surface()->buffer != NULL)
+			gfx_draw_line(lcd_get_surface(), x1, y1, x2, y2, color);
 		_show_canvas();
 	}
 }
@@ -539,28 +390,14 @@ void lcd_draw_filled_circle(uint32_t dwX, uint32_t dwY, uint32_t dwR,
  */
 void lcd_draw_string(uint32_t x, uint32_t y, const char *p_string, uint32_t color)
 {
-	uint32_t xorg = x;
-	uint8_t font_sel = lcd_get_selected_font();
-	uint8_t width = font_param[font_sel].width ;
-	uint8_t height = font_param[font_sel].height;
-	uint8_t char_space = font_param[font_sel].char_space;
-
-	/* Font 10*8 reverse height and width */
-	if (font_sel == FONT10x8) {
-		width = font_param[font_sel].height ;
-		height = font_param[font_sel].width;
-	}
+	struct _gfx_surface *surface = lcd_get_surface();
 
-	while (*p_string) {
-		if (*p_string == '\n') {
-			y += height + char_space;
-			x = xorg;
-		} else {
-			lcd_draw_char(x, y, *p_string, color);
-			x += width + char_space;
-		}
-		p_string++;
-	}
+	if (surface->buffer == NULL)
+		return;
+	_hide_canvas();
+	gfx_draw_string(surface, x, y, lcd_get_gfx_font(), p_string, color, 0,
+			false);
+	_show_canvas();
 }
 
 /**
@@ -578,28 +415,14 @@ void lcd_draw_string_with_bgcolor(uint32_t x, uint32_t y,
 								   uint32_t fontColor,
 								   uint32_t bgColor)
 {
-	uint32_t xorg = x;
-	uint8_t font_sel = lcd_get_selected_font();
-	uint8_t width = font_param[font_sel].width ;
-	uint8_t height = font_param[font_sel].height;
-	uint8_t char_space = font_param[font_sel].char_space;
+	struct _gfx_surface *surface = lcd_get_surface();
 
-	/* Font 10*8 reverse height and width */
-	if (font_sel == FONT10x8) {
-		width = font_param[font_sel].height ;
-		height = font_param[font_sel].width;
-	}
-
-	while (*p_string) {
-		if (*p_string == '\n') {
-			y += height + char_space;;
-			x = xorg;
-		} else {
-			lcd_draw_char_with_bgcolor(x, y, *p_string, fontColor, bgColor);
-			x += width + char_space;;
-		}
-		p_string++;
-	}
+	if (surface->buffer == NULL)
+		return;
+	_hide_canvas();
+	gfx_draw_string(surface, x, y, lcd_get_gfx_font(), p_string, fontColor,
+			bgColor, true);
+	_show_canvas();
 }
 
 /**
@@ -654,24 +477,15 @@ void lcd_get_string_size(const char *p_string, uint32_t * p_width, uint32_t * p_
 void lcd_draw_image(uint32_t dwX, uint32_t dwY, const uint8_t * pImage,
 		     uint32_t width, uint32_t height)
 {
-	struct _lcdc_layer *pDisp = lcdc_get_canvas();
-	uint16_t cw = pDisp->bpp / 8;	/* color width */
-	uint32_t rw = pDisp->width * cw;	/* Row width in bytes */
-	uint32_t rws = width * cw;	/* Source Row Width */
-	uint32_t rl = (rw & 0x3) ? ((rw | 0x3) + 1) : rw;	/* Aligned length */
+	struct _gfx_surface *surface = lcd_get_surface();
+	uint32_t rws = width * (surface->bpp / 8);	/* Source Row Width */
 	uint32_t rls = (rws & 0x3) ? ((rws | 0x3) + 1) : rws;	/* Aligned length */
-	uint8_t *pSrc, *pDst;
-	uint32_t i;
-
-	pSrc = (uint8_t *) pImage;
-	pDst = pDisp->buffer;
-	pDst = &pDst[dwX * cw + dwY * rl];
 
-	for (i = 0; i < height; i++) {
-		memcpy(pDst, pSrc, rws);
-		pSrc = &pSrc[rls];
-		pDst = &pDst[rl];
-	}
+	if (surface->buffer == NULL)
+		return;
+	_hide_canvas();
+	gfx_blit(surface, dwX, dwY, pImage, rls, width, height);
+	_show_canvas();
 }
 
 /**
@@ -701,22 +515,22 @@ void lcd_clear_window(uint32_t dwX, uint32_t dwY, uint32_t width,
  */
 void lcd_draw_fast_vline (uint32_t x, uint32_t y, uint32_t h, uint32_t color)
 {
-	lcd_draw_line(x, y, x, y+h-1, color);
+	lcd_draw_filled_rectangle(x, y, x, y+h-1, color);
 }
 /**
  * Draw fast horizontal line
  */
 void lcd_draw_fast_hline (uint32_t x, uint32_t y, uint32_t w, uint32_t color)
 {
-	lcd_draw_line(x, y, x+w-1, y, color);
+	lcd_draw_filled_rectangle(x, y, x+w-1, y, color);
 }
 /**
  * Fill rectangle with color
  */
 static void _lcd_fill_rectangle (uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint32_t color)
 {
-	uint32_t i;
-	for (i=x; i<x+w; i++) lcd_draw_fast_vline(i, y, h, color);
+	_set_front_color(color);
+	_fill_rect(x, y, x+w-1, y+h-1);
 }
 /**
  * Draw a circle
@@ -62,6 +62,8 @@
  *        Headers
  *----------------------------------------------------------------------------*/
 
+#include "display/gfx.h"
+
 #include <stdint.h>
 
 /*----------------------------------------------------------------------------
@@ -74,6 +76,10 @@
 
 	 /** \addtogroup lcdc_draw_func LCD Drawing Functions */
 /** @{*/
+
+extern struct _gfx_surface *lcd_get_surface(void);
+
+extern void lcd_flush(void);
 extern void lcd_fill_white(void);
 
 extern void lcd_fill(uint32_t color);
@@ -43,16 +43,65 @@
 #include "font.h"
 
 #include <assert.h>
+#include <stddef.h>
 
 /*----------------------------------------------------------------------------
- *        Local variables
+ *        Local functions
  *----------------------------------------------------------------------------*/
 
-/** Global variable describing the font being instanced. */
-//const Font gFont = { 10, 14 };
+static bool _pixel_10x14(const struct _gfx_font* font, uint8_t c, uint8_t x,
+			 uint8_t y)
+{
+	const uint8_t* pfont = (const uint8_t*)font->data;
+	const uint8_t* col = &pfont[((c - 0x20) * 20) + x * 2];
+
+	if (y < 8)
+		return (col[0] >> (7 - y)) & 0x1;
+	else
+		return (col[1] >> (15 - y)) & 0x1;
+}
+
+/* glyphs are rotated, drawn one pixel right of the origin */
+static bool _pixel_10x8(const struct _gfx_font* font, uint8_t c, uint8_t x,
+			uint8_t y)
+{
+	const uint8_t* pfont = (const uint8_t*)font->data;
+
+	if (x == 0)
+		return false;
+	return (pfont[((c - 0x20) * 10) + y] >> (8 - x)) & 0x1;
+}
+
+static bool _pixel_8x8(const struct _gfx_font* font, uint8_t c, uint8_t x,
+		       uint8_t y)
+{
+	const uint8_t* pfont = (const uint8_t*)font->data;
+
+	return (pfont[((c - 0x20) * 8) + y] >> x) & 0x1;
+}
+
+static bool _pixel_6x8(const struct _gfx_font* font, uint8_t c, uint8_t x,
+		       uint8_t y)
+{
+	const uint8_t* pfont = (const uint8_t*)font->data;
+
+	return (pfont[((c - 0x20) * 6) + x] >> y) & 0x1;
+}
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
 
 static uint8_t font_sel = FONT10x14;
 
+/** Fonts as drawn by the gfx module, same order as _FONT_enum */
+static const struct _gfx_font gfx_fonts[NB_FONT] = {
+	{ 10, 14, 2, pCharset10x14, _pixel_10x14 },
+	{ 9, 10, 0, pCharset10x8, _pixel_10x8 },
+	{ 8, 8, 1, pCharset8x8, _pixel_8x8 },
+	{ 6, 8, 0, pCharset6x8, _pixel_6x8 },
+};
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -68,61 +117,29 @@ uint8_t lcd_get_selected_font (void)
 	return font_sel;
 }
 
+const struct _gfx_font* lcd_get_gfx_font (void)
+{
+	return &gfx_fonts[font_sel];
+}
+
+/**
+ * \brief Draws an ASCII character on LCD.
+ *
+ * \param x          X-coordinate of character upper-left corner.
+ * \param y          Y-coordinate of character upper-left corner.
+ * \param c          Character to output.
+ * \param color      Character color.
+ */
 void lcd_draw_char(uint32_t x, uint32_t y, uint8_t c, uint32_t color)
 {
-	uint32_t row, col;
-	uint8_t Ch;
-	uint8_t width = font_param[font_sel].width ;
-    uint8_t height = font_param[font_sel].height;
-	const uint8_t* pfont = font_param[font_sel].pfont;
+	struct _gfx_surface* surface = lcd_get_surface();
 
 	assert((c >= 0x20) && (c <= 0x7F));
 
-    switch (font_sel)
-    {
-      case FONT10x14:
-        for (col=0 ; col < width ; col++ ) {
-          for (row=0 ; row<8 ; row++ ) {
-            Ch = (pfont[((c - 0x20) * 20) + col * 2] >> (7 - row)) & 0x1;
-            if (Ch) lcd_draw_pixel( x+col, y+row, color) ;
-          }
-          for (row=0; row<6; row++ ) {
-            Ch = (pfont[((c - 0x20) * 20) + col * 2 + 1] >> (7 - row)) & 0x1;
-            if (Ch) lcd_draw_pixel( x+col, y+row+8, color) ;
-          }
-        }
-        break;
-
-       case FONT10x8:
-        for (col=0 ; col < width ; col++ ) {
-          Ch = pfont[((c-0x20)*width)+ col];
-		  if (Ch) {
-            for (row=0 ; row < height; row++ ) {
-              if ((Ch>>row)&0x1) {
-                  lcd_draw_pixel( x+(height-row), y+col, color) ;
-              }
-            }
-          }
-        }
-        break;
-
-      case FONT8x8:
-      case FONT6x8:
-        for (col=0 ; col < width ; col++ ) {
-          Ch = pfont[((c-0x20)*width)+ col];
-          if (Ch) {
-            for (row=0 ; row < height; row++ ) {
-              if ((Ch>>row)&0x1)  {
-                if (font_sel == FONT8x8)
-                  lcd_draw_pixel( x+row, y+col, color) ;
-                else
-                  lcd_draw_pixel( x+col, y+row, color) ;
-              }
-            }
-          }
-        }
-        break;
-    }
+	if (surface->buffer == NULL)
+		return;
+	gfx_draw_char(surface, x, y, &gfx_fonts[font_sel], c, color, 0, false);
+	lcd_flush();
 }
 
 /**
@@ -137,68 +154,13 @@ void lcd_draw_char(uint32_t x, uint32_t y, uint8_t c, uint32_t color)
 void lcd_draw_char_with_bgcolor(uint32_t x, uint32_t y, uint8_t c, uint32_t fontColor,
 			 uint32_t bgColor)
 {
-	uint32_t row, col;
-	uint8_t Ch;
-	uint8_t width = font_param[font_sel].width ;
-    uint8_t height = font_param[font_sel].height;
-	const uint8_t* pfont = font_param[font_sel].pfont;
+	struct _gfx_surface* surface = lcd_get_surface();
 
 	assert((c >= 0x20) && (c <= 0x7F));
 
-    switch (font_sel)
-    {
-      case FONT10x14:
-        for (col=0 ; col < width ; col++ ) {
-          for (row=0 ; row<8 ; row++ ) {
-            Ch = (pfont[((c - 0x20) * 20) + col * 2] >> (7 - row)) & 0x1;
-            if (Ch) lcd_draw_pixel( x+col, y+row, fontColor) ;
-			else lcd_draw_pixel( x+col, y+row, bgColor) ;
-          }
-          for (row=0; row<6; row++ ) {
-            Ch = (pfont[((c - 0x20) * 20) + col * 2 + 1] >> (7 - row)) & 0x1;
-            if (Ch) lcd_draw_pixel( x+col, y+row+8, fontColor) ;
-			else lcd_draw_pixel( x+col, y+row+8, bgColor) ;
-          }
-        }
-        break;
-
-       case FONT10x8:
-        for (col=0 ; col < width ; col++ ) {
-          Ch = pfont[((c-0x20)*width)+ col];
-		  if (Ch) {
-            for (row=0 ; row < height; row++ ) {
-              if ((Ch>>row)&0x1) {
-                  lcd_draw_pixel( x+(height-row), y+col, fontColor) ;
-			  }
-			  else {
-				  lcd_draw_pixel( x+(height-row), y+col, bgColor) ;
-			  }
-            }
-          }
-        }
-        break;
-
-      case FONT8x8:
-      case FONT6x8:
-        for (col=0 ; col < width ; col++ ) {
-          Ch = pfont[((c-0x20)*width)+ col];
-          if (Ch) {
-            for (row=0 ; row < height; row++ ) {
-              if ((Ch>>row)&0x1)  {
-                if (font_sel == FONT8x8)
-                  lcd_draw_pixel( x+row, y+col, fontColor) ;
-                else
-                  lcd_draw_pixel( x+col, y+row, fontColor) ;
-              }
-			  else {
-				  if (font_sel == FONT8x8)
-                  lcd_draw_pixel( x+row, y+col, bgColor) ;
-                else
-                  lcd_draw_pixel( x+col, y+row, bgColor) ;
-			  }
-            }
-          }
-        }
-        break;
-    }
+	if (surface->buffer == NULL)
+		return;
+	gfx_draw_char(surface, x, y, &gfx_fonts[font_sel], c, fontColor,
+		      bgColor, true);
+	lcd_flush();
 }
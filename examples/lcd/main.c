@@ -325,7 +325,6 @@ static void _LcdOn(void)
 				   13 * EXAMPLE_LCD_SCALE,
 				   13 * EXAMPLE_LCD_SCALE, COLOR_BLACK);
 
-	cache_clean_region(_heo_buffer, sizeof(_heo_buffer));
 	lcdc_put_image_rotated(LCDC_HEO, _heo_buffer, heo_bpp, SCR_X(heo_x),
 			      SCR_Y(heo_y), heo_w, heo_h, heo_img_w,
 			      heo_img_h, 0);
@@ -345,7 +344,6 @@ static void _LcdOn(void)
 	/* Display message font 8x8 */
 	lcd_select_font(FONT8x8);
 	lcd_draw_string(8, 56, "ATMEL RFO", COLOR_BLACK);
-	cache_clean_region(_ovr2_buffer, sizeof(_ovr2_buffer));
 #endif /* CONFIG_HAVE_LCDC_OVR2 */
 
 #ifdef CONFIG_HAVE_LCDC_OVR1
@@ -357,7 +355,6 @@ static void _LcdOn(void)
 	lcdc_create_canvas(LCDC_OVR1, _ovr1_buffer, 24, SCR_X(ovr1_x),
 			   SCR_Y(ovr1_y), orv1_w, ovr1_h);
 	lcd_fill(OVR1_BG);
-	cache_clean_region(_ovr1_buffer, sizeof(_ovr1_buffer));
 #endif /* CONFIG_HAVE_LCDC_OVR1 */
 
 	printf("- LCD ON\r\n");
@@ -586,7 +583,6 @@ static void _draws(void)
 			"graphic functionnalities\n"
 			"       on a SAMA5", COLOR_BLACK);
 
-	cache_clean_region(_ovr1_buffer, sizeof(_ovr1_buffer));
 }
 
 #endif /* CONFIG_HAVE_LCDC_OVR1 */
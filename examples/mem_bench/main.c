@@ -0,0 +1,344 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \page mem_bench Memory Copy Benchmark
+ *
+ * \section Purpose
+ *
+ * This example checks and measures the optimized memory copy functions
+ * (fast_memcpy, fast_memset and fast_memmove) against the C library ones,
+ * and the asynchronous DMA copy (dma_memcpy).
+ *
+ * \section Requirements
+ *
+ * This package can be used with SAMA5D2x, SAMA5D3x, SAMA5D4x, SAME70 and
+ * SAMV71 boards.  It can also be compiled for a Linux host with
+ * Makefile.linux, in which case the portable C implementation is measured.
+ *
+ * \section Description
+ *
+ * The functions are first checked against the C library for all sizes up to
+ * 256 bytes and all source/destination alignments.  Then, throughput is
+ * measured with the perf module for sizes from 64 bytes to 64KB, with aligned
+ * buffers and with misaligned source and destination.  On target, the DMA
+ * copy is measured from its start to its completion callback.
+ *
+ * \section Usage
+ *
+ * -# Build the program and download it inside the board.
+ * -# On the computer, open and configure a terminal application
+ *    (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *   - 115200 baud rate
+ *   - 8 bits of data
+ *   - No parity
+ *   - 1 stop bit
+ *   - No flow control
+ * -# Start the application, the results are printed on the console.
+ * -# To run it on a Linux computer, run "make -f Makefile.linux" and
+ *    "./mem_bench" in the example directory.
+ *
+ * \section References
+ * - mem_bench/main.c
+ * - fastmem.h
+ * - dma.h
+ * - perf.h
+ */
+
+/** \file
+ *
+ *  This file contains all the specific code for the memory copy benchmark.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "compiler.h"
+#include "fastmem.h"
+#include "perf.h"
+
+#ifdef CONFIG_ARCH_ARM
+#include "board.h"
+#include "chip.h"
+#include "trace.h"
+
+#include "dma/dma.h"
+#include "mm/cache.h"
+#include "serial/console.h"
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Largest copy size, in bytes */
+#define BENCH_MAX_SIZE (64 * 1024)
+
+/** Sizes up to this value are checked with every alignment */
+#define CHECK_MAX_SIZE 256
+
+/** Number of measured runs per benchmark */
+#define BENCH_RUNS 10
+
+/*----------------------------------------------------------------------------
+ *        Local types
+ *----------------------------------------------------------------------------*/
+
+struct _copy_arg {
+	void* (*copy)(void*, const void*, size_t);
+	uint8_t* dst;
+	const uint8_t* src;
+	uint32_t size;
+};
+
+struct _set_arg {
+	void* (*set)(void*, int, size_t);
+	uint8_t* dst;
+	uint32_t size;
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+ALIGNED(32) static uint8_t bench_src[BENCH_MAX_SIZE + 32];
+ALIGNED(32) static uint8_t bench_dst[BENCH_MAX_SIZE + 32];
+ALIGNED(32) static uint8_t bench_ref[BENCH_MAX_SIZE + 32];
+
+static const uint32_t bench_sizes[] = {
+	64, 256, 1024, 4096, 16384, 65536,
+};
+
+/** source and destination offsets from a cache line boundary */
+static const uint8_t bench_offsets[][2] = {
+	{ 0, 0 },
+	{ 1, 1 },
+	{ 1, 2 },
+};
+
+#ifdef CONFIG_ARCH_ARM
+static volatile bool dma_done;
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static void _fill(uint8_t* buf, uint32_t len, uint8_t seed)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = (uint8_t)(i * 13 + seed);
+}
+
+static void* _memcpy(void* dst, const void* src, size_t len)
+{
+	return memcpy(dst, src, len);
+}
+
+static void* _memmove(void* dst, const void* src, size_t len)
+{
+	return memmove(dst, src, len);
+}
+
+/**
+ * \brief Check fast_memcpy, fast_memset and fast_memmove results against the
+ * C library for all sizes up to CHECK_MAX_SIZE and all alignments
+ * \return number of errors
+ */
+static uint32_t _check(void)
+{
+	uint32_t errors = 0;
+	uint32_t size, so, dof;
+
+	for (size = 0; size <= CHECK_MAX_SIZE; size++) {
+		for (so = 0; so < 8; so++) {
+			for (dof = 0; dof < 8; dof++) {
+				_fill(bench_src, CHECK_MAX_SIZE + 32, 7);
+				memset(bench_dst, 0xee, CHECK_MAX_SIZE + 32);
+				memset(bench_ref, 0xee, CHECK_MAX_SIZE + 32);
+				fast_memcpy(bench_dst + dof, bench_src + so, size);
+				memcpy(bench_ref + dof, bench_src + so, size);
+				if (memcmp(bench_dst, bench_ref, CHECK_MAX_SIZE + 32))
+					errors++;
+
+				fast_memset(bench_dst + dof, size, size);
+				memset(bench_ref + dof, size, size);
+				if (memcmp(bench_dst, bench_ref, CHECK_MAX_SIZE + 32))
+					errors++;
+
+				/* overlapping, both directions */
+				_fill(bench_dst, CHECK_MAX_SIZE + 32, 3);
+				_fill(bench_ref, CHECK_MAX_SIZE + 32, 3);
+				fast_memmove(bench_dst + dof, bench_dst + so, size);
+				memmove(bench_ref + dof, bench_ref + so, size);
+				if (memcmp(bench_dst, bench_ref, CHECK_MAX_SIZE + 32))
+					errors++;
+				fast_memmove(bench_dst + so + 16, bench_dst + dof, size);
+				memmove(bench_ref + so + 16, bench_ref + dof, size);
+				if (memcmp(bench_dst, bench_ref, CHECK_MAX_SIZE + 32))
+					errors++;
+			}
+		}
+	}
+
+	return errors;
+}
+
+static void _copy_run(void* arg)
+{
+	struct _copy_arg* a = (struct _copy_arg*)arg;
+
+	a->copy(a->dst, a->src, a->size);
+}
+
+static void _set_run(void* arg)
+{
+	struct _set_arg* a = (struct _set_arg*)arg;
+
+	a->set(a->dst, 0x5a, a->size);
+}
+
+#ifdef CONFIG_ARCH_ARM
+static int _dma_done_callback(void* arg, void* arg2)
+{
+	dma_done = true;
+	return 0;
+}
+
+static void _dma_run(void* arg)
+{
+	struct _copy_arg* a = (struct _copy_arg*)arg;
+	struct _callback cb;
+
+	callback_set(&cb, _dma_done_callback, NULL);
+	dma_done = false;
+	dma_memcpy(a->dst, a->src, a->size, &cb);
+	while (!dma_done)
+		dma_poll();
+}
+#endif
+
+static void _bench(const char* name, struct _perf_bench* bench, void* arg,
+		uint32_t size)
+{
+	struct _perf_result result;
+
+	bench->name = name;
+	bench->bytes = size;
+	bench->arg = arg;
+	if (perf_bench_run(bench, BENCH_RUNS, &result) == 0)
+		perf_bench_print(bench, &result);
+}
+
+static void _bench_copy(const char* fn, void* (*copy)(void*, const void*, size_t),
+		void (*run)(void*))
+{
+	struct _perf_bench bench = { .run = run };
+	struct _copy_arg arg = { .copy = copy };
+	char name[32];
+	uint32_t i, j;
+
+	for (i = 0; i < ARRAY_SIZE(bench_offsets); i++) {
+		for (j = 0; j < ARRAY_SIZE(bench_sizes); j++) {
+			arg.src = bench_src + bench_offsets[i][0];
+			arg.dst = bench_dst + bench_offsets[i][1];
+			arg.size = bench_sizes[j];
+			snprintf(name, sizeof(name), "%s %u +%u/+%u", fn,
+			         (unsigned)bench_sizes[j],
+			         (unsigned)bench_offsets[i][0],
+			         (unsigned)bench_offsets[i][1]);
+			_bench(name, &bench, &arg, arg.size);
+		}
+	}
+}
+
+static void _bench_set(const char* fn, void* (*set)(void*, int, size_t))
+{
+	struct _perf_bench bench = { .run = _set_run };
+	struct _set_arg arg = { .set = set };
+	char name[32];
+	uint32_t i;
+
+	for (i = 0; i < ARRAY_SIZE(bench_sizes); i++) {
+		arg.dst = bench_dst + 1;
+		arg.size = bench_sizes[i];
+		snprintf(name, sizeof(name), "%s %u +1", fn,
+		         (unsigned)bench_sizes[i]);
+		_bench(name, &bench, &arg, arg.size);
+	}
+}
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	uint32_t errors;
+
+#ifdef CONFIG_ARCH_ARM
+	console_example_info("Memory Copy Benchmark");
+#else
+	printf("-- Memory Copy Benchmark (host) --\r\n");
+#endif
+
+	errors = _check();
+	printf("-I- Functional check: %u error(s)\r\n", (unsigned)errors);
+
+	perf_initialize();
+	_fill(bench_src, sizeof(bench_src), 1);
+
+	printf("%u runs per benchmark, figures of the best run\r\n",
+	       (unsigned)BENCH_RUNS);
+	perf_bench_print_header();
+	_bench_copy("memcpy", _memcpy, _copy_run);
+	_bench_copy("fast_memcpy", fast_memcpy, _copy_run);
+	_bench_copy("memmove", _memmove, _copy_run);
+	_bench_copy("fast_memmove", fast_memmove, _copy_run);
+	_bench_set("memset", memset);
+	_bench_set("fast_memset", fast_memset);
+#ifdef CONFIG_ARCH_ARM
+	printf("-I- DMA copies above %u bytes\r\n",
+	       (unsigned)CONFIG_DMA_MEMCPY_THRESHOLD);
+	_bench_copy("dma_memcpy", NULL, _dma_run);
+
+	while (1);
+#else
+	return errors ? 1 : 0;
+#endif
+}
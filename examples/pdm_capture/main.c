@@ -0,0 +1,360 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \page pdm_capture PDM Microphone Capture through SSC
+ *
+ * \section Purpose
+ *
+ * This example captures a PDM microphone with the receiver of a Synchronous
+ * Serial Controller (SSC) and converts it to PCM in software with the PDM
+ * decimation library (pdm_decim.h).  Unlike the PDMIC peripheral, which
+ * decimates one channel, each SSC or SPI data line can carry a microphone
+ * and the decimation library handles up to 8 channels.
+ *
+ * \section Requirements
+ *
+ * This package can be used with SAMA5D2-XPLAINED (SSC1, PIOA17/PIOA18),
+ * SAMA5D3-EK and SAMA5D4-EK (SSC0, the on-board codec must not drive RD0).
+ * A PDM microphone is connected with its CLK input on RK, its DATA output on
+ * RD, and its SELECT pin tied to ground.
+ *
+ * \section Description
+ *
+ * The SSC receiver outputs the PDM clock on RK, 64 times the PCM rate, and
+ * receives continuous 8-bit words, MSB first.  The DMA writes them into a
+ * ring of periods; each completed period is decimated and the level of the
+ * microphone and the CPU load of the decimation are printed every second.
+ *
+ * \section Usage
+ *
+ * -# Build the program and download it inside the board.
+ * -# On the computer, open and configure a terminal application
+ *    (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *   - 115200 baud rate
+ *   - 8 bits of data
+ *   - No parity
+ *   - 1 stop bit
+ *   - No flow control
+ * -# Start the application, the level of the microphone is printed every
+ *    second.
+ * -# Press '1', '2' or '3' to capture at 16, 32 or 48 kHz, 'd' to enable or
+ *    disable the DC blocking filter.
+ *
+ * \section References
+ * - pdm_capture/main.c
+ * - pdm_decim.h
+ * - ssc.h
+ * - dma.h
+ */
+
+/** \file
+ *
+ *  This file contains all the specific code for the PDM capture example.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "board.h"
+#include "chip.h"
+#include "compiler.h"
+#include "pdm_decim.h"
+#include "perf.h"
+#include "trace.h"
+
+#include "audio/ssc.h"
+#include "dma/dma.h"
+#include "mm/cache.h"
+#include "peripherals/pmc.h"
+#include "serial/console.h"
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+#if defined(CONFIG_BOARD_SAMA5D2_XPLAINED)
+#define MIC_SSC SSC1
+#elif defined(CONFIG_BOARD_SAMA5D3_EK) || defined(CONFIG_BOARD_SAMA5D4_EK)
+#define MIC_SSC SSC0
+#else
+#error Unsupported board!
+#endif
+
+/** Highest output rate */
+#define MAX_RATE 48000
+
+/** Output rate at startup */
+#define DEFAULT_RATE 16000
+
+/** Periods per second */
+#define PERIODS_PER_SECOND 100
+
+/** Periods in the DMA ring */
+#define PERIODS 4
+
+/** PDM bytes per period at the highest rate */
+#define PERIOD_MAX_BYTES (MAX_RATE / PERIODS_PER_SECOND * \
+	PDM_DECIM_BYTES_PER_SAMPLE)
+
+/** Output gain, microphones are usually far below full scale (+12 dB) */
+#define MIC_GAIN (4 * PDM_DECIM_UNITY)
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** PDM ring written by the DMA */
+CACHE_ALIGNED_DDR static uint8_t pdm_ring[PERIODS][PERIOD_MAX_BYTES];
+
+static int16_t pcm[MAX_RATE / PERIODS_PER_SECOND];
+
+static struct _pdm_decim dec;
+
+static struct _ssc_desc ssc_desc = {
+	.addr = MIC_SSC,
+	.slot_num = 1,
+	.slot_length = 8,
+	.rx_start_selection = SSC_RCMR_START_CONTINUOUS,
+};
+
+static struct {
+	volatile uint32_t hw;    /**< periods received */
+	uint32_t appl;           /**< periods decimated */
+	uint32_t period_bytes;
+	uint32_t period_samples;
+	uint32_t overruns;
+	/* statistics of the current second */
+	uint32_t periods;
+	uint64_t busy_ns;
+	uint64_t sum_squares;
+	int32_t peak;
+} capture;
+
+static volatile char key;
+
+static bool dc_block = true;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief 10 * log10(x) without libm
+ */
+static double _db(double x)
+{
+	double z, z2, ln = 0.0;
+	int e = 0, k;
+
+	if (x <= 0.0)
+		return -999.0;
+	while (x >= 2.0) {
+		x /= 2;
+		e++;
+	}
+	while (x < 1.0) {
+		x *= 2;
+		e--;
+	}
+	/* ln(x) = 2 atanh((x - 1) / (x + 1)) */
+	z = (x - 1) / (x + 1);
+	z2 = z * z;
+	for (k = 19; k >= 1; k -= 2)
+		ln = ln * z2 + 1.0 / k;
+	ln = 2 * z * ln;
+	return 10 * (e * 0.69314718055994531 + ln) / 2.30258509299404568;
+}
+
+static void _console_handler(uint8_t c)
+{
+	key = (char)c;
+}
+
+/**
+ * \brief DMA callback, called each time a period of the ring is full
+ */
+static int _dma_callback(void* arg, void* arg2)
+{
+	capture.hw++;
+	return 0;
+}
+
+static void _stop(void)
+{
+	ssc_disable_receiver(&ssc_desc);
+	dma_stop_transfer(ssc_desc.rx.dma.channel);
+}
+
+/**
+ * \brief Configure the SSC and the decimator for an output rate and start
+ * the capture
+ */
+static void _start(uint32_t rate)
+{
+	struct _dma_transfer_cfg list[PERIODS];
+	struct _dma_cfg cfg;
+	struct _callback cb;
+	uint32_t clock, div, i;
+
+	/* the receiver outputs the divided clock on RK and samples RD on
+	 * the falling edge, continuously */
+	ssc_desc.bit_rate = rate * PDM_DECIM_RATIO;
+	if (!ssc_desc.rx.dma.channel)
+		ssc_configure(&ssc_desc);
+	clock = pmc_get_peripheral_clock(get_ssc_id_from_addr(MIC_SSC));
+	div = (clock + ssc_desc.bit_rate) / (2 * ssc_desc.bit_rate);
+	MIC_SSC->SSC_CMR = div;
+	ssc_configure_receiver(&ssc_desc,
+		SSC_RCMR_CKS_MCK | SSC_RCMR_CKO_CONTINUOUS |
+		SSC_RCMR_START_CONTINUOUS | SSC_RCMR_STTDLY(0) |
+		SSC_RCMR_PERIOD(0),
+		SSC_RFMR_DATLEN(7) | SSC_RFMR_MSBF | SSC_RFMR_DATNB(0));
+
+	pdm_decim_init(&dec, 1, rate, false);
+	pdm_decim_set_output(&dec, MIC_GAIN, dc_block);
+
+	memset(&capture, 0, sizeof(capture));
+	capture.period_samples = rate / PERIODS_PER_SECOND;
+	capture.period_bytes = capture.period_samples *
+		PDM_DECIM_BYTES_PER_SAMPLE;
+
+	for (i = 0; i < PERIODS; i++) {
+		list[i].saddr = (void*)&MIC_SSC->SSC_RHR;
+		list[i].daddr = pdm_ring[i];
+		list[i].len = capture.period_bytes;
+	}
+	cfg = ssc_desc.rx.dma.cfg_dma;
+	cfg.data_width = DMA_DATA_WIDTH_BYTE;
+	cfg.loop = true;
+	dma_configure_transfer(ssc_desc.rx.dma.channel, &cfg, list, PERIODS);
+	callback_set(&cb, _dma_callback, NULL);
+	dma_set_callback(ssc_desc.rx.dma.channel, &cb);
+
+	printf("-I- %u Hz: PDM clock %u Hz\r\n", (unsigned)rate,
+	       (unsigned)(clock / (2 * div)));
+	dma_start_transfer(ssc_desc.rx.dma.channel);
+	ssc_enable_receiver(&ssc_desc);
+}
+
+/**
+ * \brief Decimate the periods received
+ */
+static void _process(void)
+{
+	struct _perf_sample start, end, delta;
+	uint32_t i;
+
+	while (capture.appl != capture.hw) {
+		uint8_t* period = pdm_ring[capture.appl % PERIODS];
+
+		if (capture.hw - capture.appl >= PERIODS) {
+			/* the DMA wrote over the oldest periods */
+			capture.overruns++;
+			capture.appl = capture.hw - 1;
+			continue;
+		}
+
+		cache_invalidate_region(period, capture.period_bytes);
+		perf_read(&start);
+		pdm_decim_process(&dec, period, pcm, capture.period_samples);
+		perf_read(&end);
+		perf_diff(&start, &end, &delta);
+		capture.busy_ns += delta.ns;
+		capture.appl++;
+
+		for (i = 0; i < capture.period_samples; i++) {
+			int32_t v = pcm[i] < 0 ? -pcm[i] : pcm[i];
+			capture.sum_squares += pcm[i] * pcm[i];
+			if (v > capture.peak)
+				capture.peak = v;
+		}
+
+		if (++capture.periods == PERIODS_PER_SECOND) {
+			double rms = _db((double)capture.sum_squares /
+				((double)capture.period_samples *
+				 PERIODS_PER_SECOND * 32768.0 * 32768.0));
+			double peak = _db((double)capture.peak * capture.peak /
+				(32768.0 * 32768.0));
+			printf("-I- level %d dBFS, peak %d dBFS, "
+			       "CPU %u.%u%%, %u overrun(s)\r\n",
+			       (int)rms, (int)peak,
+			       (unsigned)(capture.busy_ns / 10000000),
+			       (unsigned)(capture.busy_ns / 1000000 % 10),
+			       (unsigned)capture.overruns);
+			capture.periods = 0;
+			capture.busy_ns = 0;
+			capture.sum_squares = 0;
+			capture.peak = 0;
+		}
+	}
+}
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	console_example_info("PDM Capture Example");
+
+	console_set_rx_handler(_console_handler);
+	console_enable_rx_interrupt();
+	perf_initialize();
+
+	printf("1: 16 kHz, 2: 32 kHz, 3: 48 kHz, d: DC blocking on/off\r\n");
+	_start(DEFAULT_RATE);
+
+	while (1) {
+		switch (key) {
+		case '1':
+		case '2':
+		case '3':
+			_stop();
+			_start((key - '0') * 16000);
+			break;
+		case 'd':
+			dc_block = !dc_block;
+			pdm_decim_set_output(&dec, MIC_GAIN, dc_block);
+			printf("-I- DC blocking %s\r\n", dc_block ? "on" : "off");
+			break;
+		default:
+			break;
+		}
+		key = 0;
+		_process();
+	}
+}
@@ -0,0 +1,614 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \page pdm_decim_bench PDM Decimation Benchmark
+ *
+ * \section Purpose
+ *
+ * This example checks and measures the PDM to PCM decimation library
+ * (pdm_decim.h) used to capture PDM microphones through serial interfaces.
+ *
+ * \section Requirements
+ *
+ * This package can be used with all SAMA5D2x, SAMA5D3x, SAMA5D4x and SAM9xx5
+ * boards, no microphone is used.  It can also be compiled for a Linux host
+ * with Makefile.linux, in which case the portable implementation is
+ * measured.
+ *
+ * \section Description
+ *
+ * The decimator is first checked to give the same output whatever the size
+ * of the blocks it is fed with, whatever the layout of the channels and
+ * whatever the bit order.  Then PDM streams are generated with a second
+ * order sigma-delta modulator and decimated: the THD+N of a 1 kHz tone is
+ * measured for each output rate, then the pass band flatness and the
+ * rejection of the frequencies folding into the pass band.
+ *
+ * Last, 1 to PDM_DECIM_MAX_CHANNELS channels are decimated to 48 kHz and the
+ * time per output sample is printed, with the number of channels that can be
+ * decimated in real time by the whole CPU and per MHz of CPU clock.  On a
+ * Linux host, the CPU clock is read from /proc/cpuinfo or given on the
+ * command line in MHz ("./pdm_decim_bench 2400").
+ *
+ * \section Usage
+ *
+ * -# Build the program and download it inside the board.
+ * -# On the computer, open and configure a terminal application
+ *    (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *   - 115200 baud rate
+ *   - 8 bits of data
+ *   - No parity
+ *   - 1 stop bit
+ *   - No flow control
+ * -# Start the application, the results are printed on the console.
+ * -# To run it on a Linux computer, run "make -f Makefile.linux" and
+ *    "./pdm_decim_bench" in the example directory.
+ *
+ * \section References
+ * - pdm_decim_bench/main.c
+ * - pdm_decim.h
+ * - perf.h
+ */
+
+/** \file
+ *
+ *  This file contains all the specific code for the PDM decimation
+ *  benchmark.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "compiler.h"
+#include "pdm_decim.h"
+#include "perf.h"
+
+#ifdef CONFIG_ARCH_ARM
+#include "board.h"
+#include "chip.h"
+#include "trace.h"
+
+#include "peripherals/pmc.h"
+#include "serial/console.h"
+#else
+#include <stdlib.h>
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Frequency of the test tone, in Hz */
+#define TONE_FREQ 1000
+
+/** Amplitude of the test tone, relative to full scale (-6 dBFS) */
+#define TONE_AMPLITUDE 0.5
+
+/** Output samples skipped while the filters settle */
+#define TONE_SKIP 64
+
+/** Number of output samples analysed */
+#define TONE_FRAMES 4096
+
+/** Highest THD+N accepted, in dB (the test modulator limits it to about
+ * -70 dB) */
+#define MAX_THDN_DB (-66.0)
+
+/** Largest pass band gain error, in dB */
+#define MAX_RIPPLE_DB 0.2
+
+/** Highest level of a frequency folding into the pass band, in dB */
+#define MAX_ALIAS_DB (-70.0)
+
+/** Output rate of the benchmarks */
+#define BENCH_RATE 48000
+
+/** Frames per benchmark run (10 ms) */
+#define BENCH_FRAMES (BENCH_RATE / 100)
+
+/** Number of measured runs per benchmark */
+#define BENCH_RUNS 10
+
+#define PI 3.14159265358979323846
+
+/*----------------------------------------------------------------------------
+ *        Local types
+ *----------------------------------------------------------------------------*/
+
+struct _band_check {
+	double freq;      /**< relative to the output rate */
+	double gain_db;   /**< expected gain */
+	bool alias;       /**< measured at the folded frequency */
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static struct _pdm_decim dec;
+
+static uint8_t pdm[(TONE_SKIP + TONE_FRAMES) * PDM_DECIM_BYTES_PER_SAMPLE];
+static int16_t pcm[TONE_SKIP + TONE_FRAMES];
+
+static uint8_t bench_pdm[BENCH_FRAMES * PDM_DECIM_BYTES_PER_SAMPLE
+	* PDM_DECIM_MAX_CHANNELS];
+static int16_t bench_pcm[BENCH_FRAMES * PDM_DECIM_MAX_CHANNELS];
+
+static uint8_t check_pdm[2 * 500 * PDM_DECIM_BYTES_PER_SAMPLE];
+static int16_t check_ref[2 * 500];
+static int16_t check_out[2 * 500];
+
+static const struct _band_check band_checks[] = {
+	{ 0.02, 0.0, false },
+	{ 0.1, 0.0, false },
+	{ 0.25, 0.0, false },
+	{ 0.35, 0.0, false },
+	{ 0.4, 0.0, false },
+	{ 0.6, 0.0, true },
+	{ 0.75, 0.0, true },
+	{ 1.02, 0.0, true },
+};
+
+static uint32_t rand_state = 1;
+
+static uint32_t cpu_mhz;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint32_t _rand(void)
+{
+	rand_state = rand_state * 1103515245 + 12345;
+	return rand_state >> 8;
+}
+
+/**
+ * \brief sin and cos without libm (Taylor series, |x| <= pi)
+ */
+static void _sincos(double x, double* s, double* c)
+{
+	double x2, sh, ch;
+
+	/* half angle, then double it */
+	x /= 2;
+	x2 = x * x;
+	sh = x * (1 - x2 / 6 * (1 - x2 / 20 * (1 - x2 / 42 * (1 - x2 / 72
+		* (1 - x2 / 110 * (1 - x2 / 156))))));
+	ch = 1 - x2 / 2 * (1 - x2 / 12 * (1 - x2 / 30 * (1 - x2 / 56
+		* (1 - x2 / 90 * (1 - x2 / 132)))));
+	*s = 2 * sh * ch;
+	*c = ch * ch - sh * sh;
+}
+
+/**
+ * \brief 10 * log10(x) without libm
+ */
+static double _db(double x)
+{
+	double z, z2, ln = 0.0;
+	int e = 0, k;
+
+	if (x <= 0.0)
+		return -999.0;
+	while (x >= 2.0) {
+		x /= 2;
+		e++;
+	}
+	while (x < 1.0) {
+		x *= 2;
+		e--;
+	}
+	/* ln(x) = 2 atanh((x - 1) / (x + 1)) */
+	z = (x - 1) / (x + 1);
+	z2 = z * z;
+	for (k = 19; k >= 1; k -= 2)
+		ln = ln * z2 + 1.0 / k;
+	ln = 2 * z * ln;
+	return 10 * (e * 0.69314718055994531 + ln) / 2.30258509299404568;
+}
+
+/**
+ * \brief Print a value in dB with one decimal
+ */
+static void _print_db(const char* label, double db)
+{
+	int32_t v = (int32_t)(db * 10 + (db >= 0 ? 0.5 : -0.5));
+
+	printf("%s%s%d.%d dB", label, v < 0 ? "-" : "",
+	       (int)((v < 0 ? -v : v) / 10), (int)((v < 0 ? -v : v) % 10));
+}
+
+static uint8_t _reverse_bits(uint8_t v)
+{
+	v = (uint8_t)((v >> 4) | (v << 4));
+	v = (uint8_t)(((v >> 2) & 0x33) | ((v & 0x33) << 2));
+	return (uint8_t)(((v >> 1) & 0x55) | ((v & 0x55) << 1));
+}
+
+/**
+ * \brief Generate the PDM stream of a tone with a second order sigma-delta
+ * modulator, first bit in the MSB
+ * \param buf        PDM buffer
+ * \param bytes      Number of bytes
+ * \param w          Tone frequency, in radians per PDM bit
+ * \param amplitude  Tone amplitude, relative to full scale
+ */
+static void _modulate(uint8_t* buf, uint32_t bytes, double w,
+		double amplitude)
+{
+	double s, c, x = 0.0, y = amplitude, t, e1 = 0.0, e2 = 0.0;
+	uint32_t i;
+	int b;
+
+	_sincos(w, &s, &c);
+	for (i = 0; i < bytes; i++) {
+		uint8_t v = 0;
+		for (b = 7; b >= 0; b--) {
+			/* noise transfer function (1 - z^-1)^2, small dither */
+			double u = y - 2 * e1 + e2 +
+				((double)(_rand() & 0xffff) - 32768.0) * 1e-8;
+			double q = u >= 0.0 ? 1.0 : -1.0;
+			if (q > 0.0)
+				v |= 1 << b;
+			e2 = e1;
+			e1 = q - u;
+			t = x * c + y * s;
+			y = y * c - x * s;
+			x = t;
+		}
+		buf[i] = v;
+	}
+}
+
+/**
+ * \brief Fit of a tone of known frequency and of the DC offset
+ * \param x       Samples
+ * \param frames  Number of samples
+ * \param w       Tone frequency, in radians per sample
+ * \param power   Power of the fitted tone (squared amplitude)
+ * \return THD+N in dB
+ */
+static double _fit(const int16_t* x, uint32_t frames, double w,
+		double* power)
+{
+	/* normal equations of the fit of [1, cos, sin] */
+	double m[3][4], basis[3], s, c, t, res = 0, sig = 0, coef[3];
+	uint32_t i;
+	int r, k, l;
+
+	memset(m, 0, sizeof(m));
+	_sincos(w, &s, &c);
+	basis[0] = 1.0;
+	basis[1] = 1.0;
+	basis[2] = 0.0;
+	for (i = 0; i < frames; i++) {
+		for (r = 0; r < 3; r++) {
+			for (k = 0; k < 3; k++)
+				m[r][k] += basis[r] * basis[k];
+			m[r][3] += basis[r] * x[i];
+		}
+		t = basis[1] * c - basis[2] * s;
+		basis[2] = basis[2] * c + basis[1] * s;
+		basis[1] = t;
+	}
+
+	/* Gauss-Jordan elimination, the matrix is positive definite */
+	for (r = 0; r < 3; r++) {
+		for (k = 0; k < 3; k++) {
+			if (k == r)
+				continue;
+			t = m[k][r] / m[r][r];
+			for (l = r; l < 4; l++)
+				m[k][l] -= t * m[r][l];
+		}
+	}
+	for (r = 0; r < 3; r++)
+		coef[r] = m[r][3] / m[r][r];
+	*power = coef[1] * coef[1] + coef[2] * coef[2];
+
+	basis[1] = 1.0;
+	basis[2] = 0.0;
+	for (i = 0; i < frames; i++) {
+		double fit = coef[1] * basis[1] + coef[2] * basis[2];
+		double e = x[i] - coef[0] - fit;
+		res += e * e;
+		sig += fit * fit;
+		t = basis[1] * c - basis[2] * s;
+		basis[2] = basis[2] * c + basis[1] * s;
+		basis[1] = t;
+	}
+	return _db(res / sig);
+}
+
+/**
+ * \brief Decimate a modulated tone
+ * \param rate  Output rate
+ * \param freq  Tone frequency, relative to the output rate
+ * \param w     Frequency of the output tone, in radians per sample
+ * \param power Output level relative to the input level, in dB
+ * \return THD+N in dB
+ */
+static double _decimate_tone(uint32_t rate, double freq, double w,
+		double* level)
+{
+	double power, thdn;
+
+	_modulate(pdm, sizeof(pdm), 2 * PI * freq / PDM_DECIM_RATIO,
+			TONE_AMPLITUDE);
+	pdm_decim_init(&dec, 1, rate, false);
+	pdm_decim_process(&dec, pdm, pcm, ARRAY_SIZE(pcm));
+	thdn = _fit(pcm + TONE_SKIP, TONE_FRAMES, w, &power);
+	*level = _db(power / (TONE_AMPLITUDE * TONE_AMPLITUDE * 32768.0
+			* 32768.0));
+	return thdn;
+}
+
+/*
+ * Functional checks
+ */
+
+static uint32_t _check_streaming(void)
+{
+	const uint32_t frames = ARRAY_SIZE(check_ref) / 2;
+	uint32_t errors = 0, i, done, n;
+
+	for (i = 0; i < sizeof(check_pdm); i++)
+		check_pdm[i] = (uint8_t)_rand();
+
+	/* reference: interleaved, one call */
+	pdm_decim_init(&dec, 2, 16000, false);
+	pdm_decim_set_output(&dec, 3 * PDM_DECIM_UNITY, true);
+	pdm_decim_process(&dec, check_pdm, check_ref, frames);
+
+	/* same output with random block sizes */
+	pdm_decim_reset(&dec);
+	for (done = 0; done < frames; done += n) {
+		n = 1 + _rand() % 80;
+		if (n > frames - done)
+			n = frames - done;
+		pdm_decim_process(&dec, check_pdm +
+				done * 2 * PDM_DECIM_BYTES_PER_SAMPLE,
+				check_out + 2 * done, n);
+	}
+	if (memcmp(check_out, check_ref, sizeof(check_ref)))
+		errors++;
+
+	/* same output channel per channel */
+	pdm_decim_reset(&dec);
+	memset(check_out, 0, sizeof(check_out));
+	pdm_decim_process_channel(&dec, 1, check_pdm + 1, 2, check_out + 1, 2,
+			frames);
+	pdm_decim_process_channel(&dec, 0, check_pdm, 2, check_out, 2, frames);
+	if (memcmp(check_out, check_ref, sizeof(check_ref)))
+		errors++;
+
+	/* same output with the first bit in the LSB */
+	for (i = 0; i < sizeof(check_pdm); i++)
+		check_pdm[i] = _reverse_bits(check_pdm[i]);
+	pdm_decim_init(&dec, 2, 16000, true);
+	pdm_decim_set_output(&dec, 3 * PDM_DECIM_UNITY, true);
+	pdm_decim_process(&dec, check_pdm, check_out, frames);
+	if (memcmp(check_out, check_ref, sizeof(check_ref)))
+		errors++;
+
+	/* idle pattern gives silence, ones give full scale */
+	pdm_decim_init(&dec, 1, 48000, false);
+	memset(check_pdm, 0x55, sizeof(check_pdm));
+	pdm_decim_process(&dec, check_pdm, check_out, 100);
+	for (i = 0; i < 100; i++)
+		if (check_out[i] != 0)
+			errors++;
+	memset(check_pdm, 0xff, sizeof(check_pdm));
+	pdm_decim_process(&dec, check_pdm, check_out, 100);
+	for (i = 50; i < 100; i++)
+		if (check_out[i] != INT16_MAX)
+			errors++;
+
+	if (pdm_decim_init(&dec, 0, 48000, false) == 0)
+		errors++;
+	if (pdm_decim_init(&dec, PDM_DECIM_MAX_CHANNELS + 1, 48000, false) == 0)
+		errors++;
+	if (pdm_decim_init(&dec, 1, 44100, false) == 0)
+		errors++;
+
+	printf("-I- Streaming and layouts: %u error(s)\r\n", (unsigned)errors);
+	return errors;
+}
+
+static uint32_t _check_quality(void)
+{
+	static const uint32_t rates[] = { 16000, 32000, 48000 };
+	uint32_t errors = 0, i;
+	double thdn, level;
+
+	for (i = 0; i < ARRAY_SIZE(rates); i++) {
+		thdn = _decimate_tone(rates[i], (double)TONE_FREQ / rates[i],
+				2 * PI * TONE_FREQ / rates[i], &level);
+		printf("-I- %u Hz, PDM clock %u kHz:",
+		       (unsigned)rates[i],
+		       (unsigned)(pdm_decim_get_clock(&dec) / 1000));
+		_print_db(" THD+N ", thdn);
+		_print_db(", gain ", level);
+		printf("\r\n");
+		if (thdn > MAX_THDN_DB)
+			errors++;
+		if (level > MAX_RIPPLE_DB || level < -MAX_RIPPLE_DB)
+			errors++;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(band_checks); i++) {
+		double f = band_checks[i].freq;
+		/* frequencies above fs / 2 fold to the distance to fs */
+		double folded = f - (uint32_t)(f + 0.5);
+
+		thdn = _decimate_tone(48000, f, 2 * PI * folded, &level);
+		printf("-I- %u.%02u fs: level", (unsigned)f,
+		       (unsigned)(f * 100 + 0.5) % 100);
+		_print_db(" ", level);
+		printf("\r\n");
+		if (band_checks[i].alias) {
+			if (level > MAX_ALIAS_DB)
+				errors++;
+		} else if (level > MAX_RIPPLE_DB || level < -MAX_RIPPLE_DB) {
+			errors++;
+		}
+	}
+	printf("-I- Decimation quality: %u error(s)\r\n", (unsigned)errors);
+	return errors;
+}
+
+/*
+ * Benchmarks
+ */
+
+static void _run_decimate(void* arg)
+{
+	pdm_decim_process(&dec, bench_pdm, bench_pcm, BENCH_FRAMES);
+}
+
+static void _bench(uint8_t channels)
+{
+	struct _perf_bench bench;
+	struct _perf_result result;
+	char name[40];
+	uint64_t sample_ns, cycles;
+
+	pdm_decim_init(&dec, channels, BENCH_RATE, false);
+	pdm_decim_set_output(&dec, PDM_DECIM_UNITY, true);
+
+	snprintf(name, sizeof(name), "decimate %u ch to %u Hz",
+	         (unsigned)channels, (unsigned)BENCH_RATE);
+	memset(&bench, 0, sizeof(bench));
+	bench.name = name;
+	bench.bytes = BENCH_FRAMES * PDM_DECIM_BYTES_PER_SAMPLE * channels;
+	bench.run = _run_decimate;
+	if (perf_bench_run(&bench, BENCH_RUNS, &result) != 0)
+		return;
+	perf_bench_print(&bench, &result);
+	if (!result.best.ns)
+		return;
+
+	/* per output sample of one channel, in 1/1000 ns and cycles */
+	sample_ns = result.best.ns * 1000 / (BENCH_FRAMES * channels);
+	if (perf_has_cycles())
+		cycles = (uint64_t)result.best.cycles * 1000 /
+			(BENCH_FRAMES * channels);
+	else
+		cycles = sample_ns * cpu_mhz / 1000;
+	printf("    %u ns/sample, %u channels in real time",
+	       (unsigned)((sample_ns + 500) / 1000),
+	       (unsigned)(1000000000000ull / (sample_ns * BENCH_RATE)));
+	if (cycles) {
+		/* 1000 times the channels per MHz */
+		uint32_t per_mhz = (uint32_t)(1000000000000ull /
+				(cycles * BENCH_RATE));
+		printf(", %u.%03u channels/MHz (%u cycles/sample)",
+		       (unsigned)(per_mhz / 1000), (unsigned)(per_mhz % 1000),
+		       (unsigned)((cycles + 500) / 1000));
+	}
+	printf("\r\n");
+}
+
+static void _bench_all(void)
+{
+	uint8_t channels;
+
+	_modulate(bench_pdm, sizeof(bench_pdm),
+			2 * PI * TONE_FREQ / BENCH_RATE / PDM_DECIM_RATIO,
+			TONE_AMPLITUDE);
+	for (channels = 1; channels <= PDM_DECIM_MAX_CHANNELS; channels *= 2)
+		_bench(channels);
+}
+
+#ifndef CONFIG_ARCH_ARM
+/**
+ * \brief CPU clock of the host in MHz, from /proc/cpuinfo
+ */
+static uint32_t _host_cpu_mhz(void)
+{
+	char line[128];
+	double mhz = 0.0;
+	FILE* f = fopen("/proc/cpuinfo", "r");
+
+	if (!f)
+		return 0;
+	while (fgets(line, sizeof(line), f))
+		if (sscanf(line, "cpu MHz : %lf", &mhz) == 1)
+			break;
+	fclose(f);
+	return (uint32_t)mhz;
+}
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+
+#ifdef CONFIG_ARCH_ARM
+int main(void)
+#else
+int main(int argc, char* argv[])
+#endif
+{
+	uint32_t errors = 0;
+
+#ifdef CONFIG_ARCH_ARM
+	console_example_info("PDM Decimation Benchmark");
+	cpu_mhz = pmc_get_processor_clock() / 1000000;
+#else
+	printf("-- PDM Decimation Benchmark (host) --\r\n");
+	perf_initialize();
+	cpu_mhz = argc > 1 ? atoi(argv[1]) : _host_cpu_mhz();
+#endif
+
+	errors += _check_streaming();
+	errors += _check_quality();
+	printf("-I- Functional check: %u error(s)\r\n", (unsigned)errors);
+
+	perf_initialize();
+	printf("%u runs per benchmark, figures of the best run, CPU %u MHz\r\n",
+	       (unsigned)BENCH_RUNS, (unsigned)cpu_mhz);
+	perf_bench_print_header();
+	_bench_all();
+
+#ifdef CONFIG_ARCH_ARM
+	while (1);
+#else
+	return errors ? 1 : 0;
+#endif
+}
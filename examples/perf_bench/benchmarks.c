@@ -0,0 +1,152 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file
+ *
+ * Benchmarks that only use the CPU and memory.  This file is also compiled
+ * by Makefile.linux to get reference figures on a host computer.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "compiler.h"
+#include "perf.h"
+
+#include "benchmarks.h"
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static uint32_t crc_table[256];
+
+/* results are stored here so that the compiler keeps the computations */
+static volatile uint32_t bench_sink;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static int _fill_setup(void* arg)
+{
+	uint32_t i;
+
+	for (i = 0; i < BENCH_BUFFER_SIZE; i++)
+		bench_src[i] = (uint8_t)(i * 7 + 3);
+	return 0;
+}
+
+static void _memcpy_run(void* arg)
+{
+	memcpy(bench_dst, bench_src, BENCH_BUFFER_SIZE);
+}
+
+static void _memset_run(void* arg)
+{
+	memset(bench_dst, 0x55, BENCH_BUFFER_SIZE);
+}
+
+static int _crc32_setup(void* arg)
+{
+	uint32_t i, j, c;
+
+	for (i = 0; i < 256; i++) {
+		c = i;
+		for (j = 0; j < 8; j++)
+			c = (c & 1) ? (c >> 1) ^ 0xedb88320u : (c >> 1);
+		crc_table[i] = c;
+	}
+	return _fill_setup(arg);
+}
+
+static void _crc32_run(void* arg)
+{
+	uint32_t crc = 0xffffffffu;
+	uint32_t i;
+
+	for (i = 0; i < BENCH_BUFFER_SIZE; i++)
+		crc = crc_table[(crc ^ bench_src[i]) & 0xff] ^ (crc >> 8);
+	bench_sink = ~crc;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported variables
+ *----------------------------------------------------------------------------*/
+
+ALIGNED(32) uint8_t bench_src[BENCH_BUFFER_SIZE];
+ALIGNED(32) uint8_t bench_dst[BENCH_BUFFER_SIZE];
+
+const struct _perf_bench common_benchmarks[] = {
+	{
+		.name = "memcpy 64K",
+		.bytes = BENCH_BUFFER_SIZE,
+		.setup = _fill_setup,
+		.run = _memcpy_run,
+	},
+	{
+		.name = "memset 64K",
+		.bytes = BENCH_BUFFER_SIZE,
+		.run = _memset_run,
+	},
+	{
+		.name = "crc32 (sw) 64K",
+		.bytes = BENCH_BUFFER_SIZE,
+		.setup = _crc32_setup,
+		.run = _crc32_run,
+	},
+};
+
+const uint32_t common_benchmarks_count = ARRAY_SIZE(common_benchmarks);
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+void benchmarks_run(const struct _perf_bench* list, uint32_t count,
+		uint32_t runs)
+{
+	struct _perf_result result;
+	uint32_t i;
+	int err;
+
+	for (i = 0; i < count; i++) {
+		err = perf_bench_run(&list[i], runs, &result);
+		if (err < 0)
+			printf("%-24s skipped (error %d)\r\n", list[i].name, err);
+		else
+			perf_bench_print(&list[i], &result);
+	}
+}
@@ -0,0 +1,370 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \page perf_bench Performance Benchmark
+ *
+ * \section Purpose
+ *
+ * This example runs a set of micro-benchmarks with the perf module and
+ * prints comparable figures: execution time, CPU cycles, throughput and
+ * hardware events (cache and TLB misses, L2 cache requests).
+ *
+ * \section Requirements
+ *
+ * This package can be used with SAMA5D2x, SAMA5D3x, SAMA5D4x, SAME70 and
+ * SAMV71 boards.  The portable benchmarks can also be compiled for a Linux
+ * host with Makefile.linux.
+ *
+ * \section Description
+ *
+ * Each benchmark is run once to warm up the caches, then BENCH_RUNS times.
+ * The best and average times are printed, with the cycles and events of the
+ * best run.  The following benchmarks are available:
+ * - memcpy, memset and software CRC32 over 64KB (all platforms),
+ * - clean and invalidate of a 64KB region from the data caches,
+ * - memory to memory DMA copy of 64KB, including the channel setup,
+ * - AES-128 ECB encryption and SHA-256 digest of 64KB, with the hardware
+ *   accelerators in polling mode.
+ *
+ * Hardware events are counted by the ARMv7-A PMU (Cortex-A5/A7) and by the
+ * L2 cache controller event counters when available.  Cortex-M7 devices only
+ * report cycles.
+ *
+ * \section Usage
+ *
+ * -# Build the program and download it inside the board.
+ * -# On the computer, open and configure a terminal application
+ *    (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *   - 115200 baud rate
+ *   - 8 bits of data
+ *   - No parity
+ *   - 1 stop bit
+ *   - No flow control
+ * -# Start the application, the results are printed on the console.
+ * -# To get reference figures on a Linux computer, run
+ *    "make -f Makefile.linux" and "./perf_bench" in the example directory.
+ *
+ * \section References
+ * - perf_bench/main.c
+ * - perf.h
+ */
+
+/** \file
+ *
+ *  This file contains all the specific code for the performance benchmark.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "compiler.h"
+#include "errno.h"
+#include "perf.h"
+
+#ifdef CONFIG_ARCH_ARM
+#include "board.h"
+#include "chip.h"
+#include "trace.h"
+
+#include "dma/dma.h"
+#include "mm/cache.h"
+#include "serial/console.h"
+
+#ifdef CONFIG_HAVE_AES
+#include "crypto/aesd.h"
+#endif
+#ifdef CONFIG_HAVE_SHA
+#include "crypto/shad.h"
+#endif
+#endif /* CONFIG_ARCH_ARM */
+
+#include "benchmarks.h"
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Number of measured runs per benchmark */
+#define BENCH_RUNS 10
+
+/** Length of a DMA micro-block, in words (below the XDMAC block limit) */
+#define BENCH_DMA_BLOCK_WORDS 2048
+
+#define BENCH_DMA_BLOCKS (BENCH_BUFFER_SIZE / (BENCH_DMA_BLOCK_WORDS * 4))
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** Events tried in order, the first set supported by the core is used */
+static const enum _perf_event bench_events[][PERF_MAX_EVENTS] = {
+	{ PERF_EVENT_INSTRUCTIONS, PERF_EVENT_L1D_MISS,
+	  PERF_EVENT_L2_READ_REQ, PERF_EVENT_L2_READ_HIT },
+	{ PERF_EVENT_INSTRUCTIONS, PERF_EVENT_L1D_MISS },
+};
+
+static const uint8_t bench_events_count[] = { 4, 2 };
+
+#ifdef CONFIG_ARCH_ARM
+
+static struct _dma_channel* bench_dma;
+
+#ifdef CONFIG_HAVE_AES
+static struct _aesd_desc bench_aesd;
+#endif
+
+#ifdef CONFIG_HAVE_SHA
+static struct _shad_desc bench_shad;
+ALIGNED(32) static uint8_t bench_digest[32];
+#endif
+
+#endif /* CONFIG_ARCH_ARM */
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+#ifdef CONFIG_ARCH_ARM
+
+static void _dirty_prepare(void* arg)
+{
+	memset(bench_dst, 0xaa, BENCH_BUFFER_SIZE);
+}
+
+static void _cache_clean_run(void* arg)
+{
+	cache_clean_region(bench_dst, BENCH_BUFFER_SIZE);
+}
+
+static void _clean_prepare(void* arg)
+{
+	memset(bench_dst, 0xaa, BENCH_BUFFER_SIZE);
+	cache_clean_region(bench_dst, BENCH_BUFFER_SIZE);
+}
+
+static void _cache_invalidate_run(void* arg)
+{
+	cache_invalidate_region(bench_dst, BENCH_BUFFER_SIZE);
+}
+
+static int _dma_setup(void* arg)
+{
+	uint32_t i;
+
+	for (i = 0; i < BENCH_BUFFER_SIZE; i++)
+		bench_src[i] = (uint8_t)i;
+	cache_clean_region(bench_src, BENCH_BUFFER_SIZE);
+
+	bench_dma = dma_allocate_channel(DMA_PERIPH_MEMORY, DMA_PERIPH_MEMORY);
+	if (!bench_dma)
+		return -EBUSY;
+	return 0;
+}
+
+static void _dma_run(void* arg)
+{
+	struct _dma_transfer_cfg xfer[BENCH_DMA_BLOCKS];
+	struct _dma_cfg cfg = {
+		.data_width = DMA_DATA_WIDTH_WORD,
+		.chunk_size = DMA_CHUNK_SIZE_1,
+		.incr_saddr = true,
+		.incr_daddr = true,
+		.loop = false,
+	};
+	uint32_t i;
+
+	for (i = 0; i < BENCH_DMA_BLOCKS; i++) {
+		xfer[i].saddr = bench_src + i * BENCH_DMA_BLOCK_WORDS * 4;
+		xfer[i].daddr = bench_dst + i * BENCH_DMA_BLOCK_WORDS * 4;
+		xfer[i].len = BENCH_DMA_BLOCK_WORDS;
+	}
+	dma_configure_transfer(bench_dma, &cfg, xfer, BENCH_DMA_BLOCKS);
+	dma_set_callback(bench_dma, NULL);
+	dma_start_transfer(bench_dma);
+	while (!dma_is_transfer_done(bench_dma))
+		dma_poll();
+	cache_invalidate_region(bench_dst, BENCH_BUFFER_SIZE);
+}
+
+static void _dma_teardown(void* arg)
+{
+	dma_free_channel(bench_dma);
+	bench_dma = NULL;
+}
+
+#ifdef CONFIG_HAVE_AES
+static int _aes_setup(void* arg)
+{
+	uint32_t i;
+
+	aesd_init(&bench_aesd);
+	bench_aesd.cfg.encrypt = true;
+	bench_aesd.cfg.mode = AESD_MODE_ECB;
+	bench_aesd.cfg.key_size = AESD_AES128;
+	bench_aesd.cfg.transfer_mode = AESD_TRANS_POLLING_AUTO;
+	for (i = 0; i < ARRAY_SIZE(bench_aesd.cfg.key); i++)
+		bench_aesd.cfg.key[i] = 0x01020304u * (i + 1);
+	aesd_configure_mode(&bench_aesd);
+	return 0;
+}
+
+static void _aes_run(void* arg)
+{
+	struct _buffer in = {
+		.data = bench_src,
+		.size = BENCH_BUFFER_SIZE,
+	};
+	struct _buffer out = {
+		.data = bench_dst,
+		.size = BENCH_BUFFER_SIZE,
+	};
+
+	aesd_transfer(&bench_aesd, &in, &out, NULL);
+	aesd_wait_transfer(&bench_aesd);
+}
+#endif /* CONFIG_HAVE_AES */
+
+#ifdef CONFIG_HAVE_SHA
+static int _sha_setup(void* arg)
+{
+	shad_init(&bench_shad);
+	bench_shad.cfg.algo = ALGO_SHA_256;
+	bench_shad.cfg.transfer_mode = SHAD_TRANS_POLLING;
+	return 0;
+}
+
+static void _sha_run(void* arg)
+{
+	struct _buffer in = {
+		.data = bench_src,
+		.size = BENCH_BUFFER_SIZE,
+	};
+	struct _buffer out = {
+		.data = bench_digest,
+		.size = sizeof(bench_digest),
+	};
+
+	shad_start(&bench_shad);
+	shad_update(&bench_shad, &in, NULL);
+	shad_wait_completion(&bench_shad);
+	shad_finish(&bench_shad, &out, NULL);
+	shad_wait_completion(&bench_shad);
+}
+#endif /* CONFIG_HAVE_SHA */
+
+static const struct _perf_bench target_benchmarks[] = {
+	{
+		.name = "cache clean 64K",
+		.bytes = BENCH_BUFFER_SIZE,
+		.prepare = _dirty_prepare,
+		.run = _cache_clean_run,
+	},
+	{
+		.name = "cache inval 64K",
+		.bytes = BENCH_BUFFER_SIZE,
+		.prepare = _clean_prepare,
+		.run = _cache_invalidate_run,
+	},
+	{
+		.name = "dma copy 64K",
+		.bytes = BENCH_BUFFER_SIZE,
+		.setup = _dma_setup,
+		.run = _dma_run,
+		.teardown = _dma_teardown,
+	},
+#ifdef CONFIG_HAVE_AES
+	{
+		.name = "aes128 ecb 64K",
+		.bytes = BENCH_BUFFER_SIZE,
+		.setup = _aes_setup,
+		.run = _aes_run,
+	},
+#endif
+#ifdef CONFIG_HAVE_SHA
+	{
+		.name = "sha256 64K",
+		.bytes = BENCH_BUFFER_SIZE,
+		.setup = _sha_setup,
+		.run = _sha_run,
+	},
+#endif
+};
+
+#endif /* CONFIG_ARCH_ARM */
+
+static void _configure_events(void)
+{
+	uint32_t i;
+
+	for (i = 0; i < ARRAY_SIZE(bench_events); i++) {
+		if (perf_configure_events(bench_events[i],
+				bench_events_count[i]) == 0)
+			return;
+	}
+	printf("-I- No hardware event available, ");
+	printf(perf_has_cycles() ? "counting cycles only\r\n" :
+	       "timing only\r\n");
+}
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+#ifdef CONFIG_ARCH_ARM
+	console_example_info("Performance Benchmark");
+#else
+	printf("-- Performance Benchmark (host) --\r\n");
+#endif
+
+	perf_initialize();
+	_configure_events();
+
+	printf("%u runs per benchmark, figures of the best run\r\n",
+	       (unsigned)BENCH_RUNS);
+	perf_bench_print_header();
+
+	benchmarks_run(common_benchmarks, common_benchmarks_count, BENCH_RUNS);
+#ifdef CONFIG_ARCH_ARM
+	benchmarks_run(target_benchmarks, ARRAY_SIZE(target_benchmarks),
+	               BENCH_RUNS);
+
+	while (1);
+#else
+	return 0;
+#endif
+}
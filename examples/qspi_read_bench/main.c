@@ -0,0 +1,211 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \page qspi_read_bench QSPI Read Benchmark
+ *
+ * \section Purpose
+ *
+ * This example measures the read throughput of the QSPI flash for the
+ * 1-1-1, 1-1-4 and 1-4-4 read modes.
+ *
+ * \section Requirements
+ *
+ * This package can be used with SAMA5D2-XPLAINED and SAMA5D27-SOM1-EK boards.
+ *
+ * \section Description
+ *
+ * For each read mode supported by the flash, 1MB is read:
+ * - by the CPU, with buffers that are not aligned on cache lines,
+ * - by DMA, with aligned buffers (word or double-word accesses and bursts),
+ * - with a read-ahead stream, the next part being read by DMA while the CPU
+ *   computes a checksum of the current one, which shows how much of the
+ *   processing is hidden behind the transfers.
+ * The throughput is printed in KB/s, and the checksums of all the reads must
+ * be the same.
+ *
+ * \section Usage
+ *
+ * -# Build the program and download it inside the board.
+ * -# On the computer, open and configure a terminal application
+ *    (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *   - 115200 baud rate
+ *   - 8 bits of data
+ *   - No parity
+ *   - 1 stop bit
+ *   - No flow control
+ * -# Start the application, the results are printed on the console.
+ *
+ * \section References
+ * - qspi_read_bench/main.c
+ * - spi-nor.h
+ * - qspi.h
+ */
+
+/** \file
+ *
+ *  This file contains all the specific code for the qspi_read_bench example.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "board.h"
+#include "board_spi.h"
+#include "chip.h"
+#include "compiler.h"
+#include "mm/cache.h"
+#include "nvm/spi-nor/spi-nor.h"
+#include "serial/console.h"
+#include "timer.h"
+#include "trace.h"
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define BOARD_SPI_FLASH_QSPI0 0
+
+/** Size read by each benchmark */
+#define BENCH_SIZE (1024 * 1024)
+
+/** Size of each read (and of each read-ahead buffer) */
+#define BLOCK_SIZE (16 * 1024)
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+CACHE_ALIGNED static uint8_t buffer[2 * BLOCK_SIZE + L1_CACHE_BYTES];
+
+static const struct {
+	uint32_t hwcaps;
+	const char* name;
+} modes[] = {
+	{ SFLASH_HWCAPS_READ_FAST, "1-1-1" },
+	{ SFLASH_HWCAPS_READ_1_1_4, "1-1-4" },
+	{ SFLASH_HWCAPS_READ_1_4_4, "1-4-4" },
+};
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint32_t _checksum(uint32_t sum, const uint8_t* data, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		sum = (sum << 1 | sum >> 31) ^ data[i];
+	return sum;
+}
+
+static void _print_result(const char* mode, const char* name, uint64_t start, uint32_t sum)
+{
+	uint32_t us = (uint32_t)(timer_get_us() - start);
+
+	printf("%s %-10s %6u KB/s  checksum %08x\r\n", mode, name,
+	       (unsigned)((uint64_t)BENCH_SIZE * 1000 / 1024 * 1000 / us),
+	       (unsigned)sum);
+}
+
+/* Synchronous reads, from an unaligned buffer (CPU) or aligned one (DMA) */
+static int _bench_read(struct spi_flash* flash, const char* mode, const char* name, uint8_t* buf)
+{
+	uint64_t start = timer_get_us();
+	uint32_t sum = 0;
+	size_t offset;
+	int rc;
+
+	for (offset = 0; offset < BENCH_SIZE; offset += BLOCK_SIZE) {
+		rc = spi_nor_read(flash, offset, buf, BLOCK_SIZE);
+		if (rc < 0)
+			return rc;
+		sum = _checksum(sum, buf, BLOCK_SIZE);
+	}
+	_print_result(mode, name, start, sum);
+	return 0;
+}
+
+static int _bench_stream(struct spi_flash* flash, const char* mode)
+{
+	struct spi_nor_stream stream;
+	uint64_t start = timer_get_us();
+	const uint8_t* data;
+	uint32_t sum = 0;
+	int rc;
+
+	rc = spi_nor_stream_open(&stream, flash, 0, BENCH_SIZE, buffer, BLOCK_SIZE);
+	if (rc < 0)
+		return rc;
+	while ((rc = spi_nor_stream_next(&stream, &data)) > 0)
+		sum = _checksum(sum, data, rc);
+	spi_nor_stream_close(&stream);
+	if (rc < 0)
+		return rc;
+
+	_print_result(mode, "read-ahead", start, sum);
+	return 0;
+}
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	struct spi_flash* flash = board_get_spi_flash(BOARD_SPI_FLASH_QSPI0);
+	int i, rc;
+
+	/* Output example information */
+	console_example_info("QSPI Read Benchmark");
+
+	printf("%uKB read by blocks of %uKB\r\n", BENCH_SIZE / 1024, BLOCK_SIZE / 1024);
+
+	for (i = 0; i < ARRAY_SIZE(modes); i++) {
+		rc = spi_nor_set_read_mode(flash, modes[i].hwcaps);
+		if (rc < 0) {
+			printf("%s not supported\r\n", modes[i].name);
+			continue;
+		}
+
+		rc = _bench_read(flash, modes[i].name, "cpu", buffer + 1);
+		rc = rc < 0 ? rc : _bench_read(flash, modes[i].name, "dma", buffer);
+		rc = rc < 0 ? rc : _bench_stream(flash, modes[i].name);
+		if (rc < 0)
+			printf("%s: error %d\r\n", modes[i].name, rc);
+	}
+
+	while (1);
+}
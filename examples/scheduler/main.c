@@ -0,0 +1,466 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \page scheduler Cooperative Scheduler Example
+ *
+ * \section Purpose
+ *
+ * This example shows how to run several subsystems concurrently with the
+ * run-to-completion scheduler from utils/sched.h instead of a super-loop.
+ *
+ * \section Requirements
+ *
+ * This package can be used with SAMA5D2-XPLAINED.
+ *
+ * \section Description
+ *
+ * Three independent activities share the CPU:
+ * - a USB Mass Storage device exposing a RAM disk,
+ * - an Ethernet responder answering ARP and ICMP echo requests,
+ * - a ClassD audio playback of a 1kHz tone.
+ *
+ * Interrupt handlers and driver callbacks only post events.  The audio
+ * refill has the highest priority, Ethernet reception comes next, USB MSD
+ * processing has the lowest priority.  When there is nothing to do the core
+ * sleeps until the next interrupt.  Scheduler statistics are printed every
+ * 5 seconds.
+ *
+ * When built with CONFIG_IRQ_PROFILE=y, pressing 'p' on the console dumps the
+ * per-source interrupt handler duration and nesting statistics, 'r' resets
+ * them.  The entry latency is also reported for the system timer, measured
+ * against its counter.
+ *
+ * \section Usage
+ *
+ * -# Build the program and download it inside the board.
+ * -# On the computer, open and configure a terminal application
+ *    (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *   - 115200 baud rate
+ *   - 8 bits of data
+ *   - No parity
+ *   - 1 stop bit
+ *   - No flow control
+ * -# Start the application.
+ * -# Connect the USB device port, the Ethernet port and a speaker, then copy
+ *    files to the disk while pinging 192.168.1.3.
+ *
+ * \section References
+ * - scheduler/main.c
+ * - sched.h
+ * - timer.h
+ */
+
+/** \file
+ *
+ *  This file contains all the specific code for the scheduler example.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "board.h"
+#include "board_eth.h"
+#include "chip.h"
+#include "compiler.h"
+#include "sched.h"
+#include "timer.h"
+#include "trace.h"
+
+#include "audio/classd.h"
+#include "irq/irq.h"
+#include "mm/cache.h"
+#include "network/ethd.h"
+#include "serial/console.h"
+
+#include "libstoragemedia/media.h"
+#include "libstoragemedia/media_private.h"
+#include "libstoragemedia/media_ramdisk.h"
+#include "usb/device/msd/msd_driver.h"
+#include "usb/device/msd/msd_lun.h"
+
+#include "../eth/mini_ip.h"
+#include "../usb_common/main_usb_common.h"
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Event priorities */
+#define PRIO_AUDIO  0
+#define PRIO_ETH    1
+#define PRIO_MSD    2
+#define PRIO_STATS  SCHED_PRIORITY_LOWEST
+
+/** Audio: 48kHz stereo, 10ms per buffer, 1kHz tone */
+#define AUDIO_SAMPLE_RATE   48000
+#define AUDIO_FRAMES        480
+#define AUDIO_TONE_PERIOD   48
+#define AUDIO_AMPLITUDE     8000
+
+/** RAM disk */
+#define BLOCK_SIZE          512
+#define RAMDISK_SIZE        (1024 * 1024)
+#define MSD_BUFFER_SIZE     (32 * BLOCK_SIZE)
+
+/** USB MSD poll period (us) when idle */
+#define MSD_POLL_PERIOD     1000
+
+/** Statistics period (us) */
+#define STATS_PERIOD        5000000
+
+/** Interrupt latency plus handler budget flagged in the IRQ profile dump (us) */
+#define IRQ_BUDGET          20
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/** MSD Driver Descriptors List */
+extern const USBDDriverDescriptors msd_driver_descriptors;
+
+static struct _classd_desc classd_desc = {
+	.addr = BOARD_CLASSD0_ADDR,
+	.sample_rate = AUDIO_SAMPLE_RATE,
+	.mode = BOARD_CLASSD0_MODE,
+	.non_ovr = CLASSD_NONOVR_10NS,
+	.swap_channels = false,
+	.mono = BOARD_CLASSD0_MONO,
+	.mono_mode = BOARD_CLASSD0_MONO_MODE,
+	.left_enable = true,
+	.right_enable = true,
+	.transfer_mode = CLASSD_MODE_DMA,
+};
+
+CACHE_ALIGNED static int16_t audio_buffer[AUDIO_FRAMES * 2];
+static struct _sched_deferred audio_deferred;
+static struct _callback audio_cb;
+static uint32_t audio_buffers_played;
+
+static uint8_t eth_port = 0;
+static uint8_t mac_addr[6];
+static uint8_t src_ip[4] = { 192, 168, 1, 3 };
+static uint8_t eth_buffer[ETH_MAX_FRAME_LENGTH];
+static struct _sched_event eth_event;
+static uint32_t eth_frames;
+
+SECTION(".region_ddr")
+ALIGNED(BLOCK_SIZE)
+static uint8_t ramdisk_reserved[RAMDISK_SIZE];
+CACHE_ALIGNED_DDR static uint8_t ram_buffer[MSD_BUFFER_SIZE];
+static struct _media medias[1];
+static MSDLun luns[1];
+static struct _sched_event msd_event;
+static struct _timer_event msd_timer;
+
+static struct _sched_event stats_event;
+static struct _timer_event stats_timer;
+
+#ifdef CONFIG_IRQ_PROFILE
+static struct _sched_event profile_event;
+static volatile uint8_t profile_cmd;
+#endif
+
+/*----------------------------------------------------------------------------
+ *        USB callbacks
+ *----------------------------------------------------------------------------*/
+
+void usbd_callbacks_request_received(const USBGenericRequest *request)
+{
+	msd_driver_request_handler(request);
+}
+
+void usbd_driver_callbacks_configuration_changed(unsigned char cfgnum)
+{
+	msd_driver_configuration_change_handler(cfgnum);
+}
+
+/**
+ * Invoked when the MSD finishes a READ/WRITE: more work is likely to follow,
+ * run the state machine again without waiting for the poll timer.
+ */
+static void msd_callbacks_data(uint8_t flow_direction, uint32_t data_length,
+		uint32_t fifo_null_count, uint32_t fifo_full_count)
+{
+	sched_post(&msd_event);
+}
+
+/*----------------------------------------------------------------------------
+ *        Event handlers
+ *----------------------------------------------------------------------------*/
+
+static int _audio_refill(void* arg, void* arg2)
+{
+	struct _buffer tx = {
+		.data = (uint8_t*)audio_buffer,
+		.size = sizeof(audio_buffer),
+		.attr = CLASSD_BUF_ATTR_WRITE,
+	};
+
+	audio_buffers_played++;
+	classd_transfer(&classd_desc, &tx, &audio_cb);
+	return 0;
+}
+
+static void _eth_rx_callback(uint8_t queue, uint32_t status)
+{
+	sched_post(&eth_event);
+}
+
+static int _eth_process(void* arg, void* arg2)
+{
+	struct _eth_packet* pkt = (struct _eth_packet*)eth_buffer;
+	uint32_t length = 0;
+	uint32_t i;
+
+	while (ethd_poll(board_get_eth(eth_port), 0, eth_buffer,
+				sizeof(eth_buffer), &length) == ETH_OK) {
+		if (length == 0)
+			continue;
+		eth_frames++;
+
+		switch (SWAP16(pkt->eth.et_protlen)) {
+		case ETH_PROT_ARP:
+			if (SWAP16(pkt->arp.ar_op) != ARP_REQUEST ||
+			    memcmp(pkt->arp.ar_tpa, src_ip, 4))
+				break;
+			pkt->arp.ar_op = SWAP16(ARP_REPLY);
+			for (i = 0; i < 6; i++) {
+				pkt->eth.et_dest[i] = pkt->eth.et_src[i];
+				pkt->eth.et_src[i] = mac_addr[i];
+				pkt->arp.ar_tha[i] = pkt->arp.ar_sha[i];
+				pkt->arp.ar_sha[i] = mac_addr[i];
+			}
+			for (i = 0; i < 4; i++) {
+				pkt->arp.ar_tpa[i] = pkt->arp.ar_spa[i];
+				pkt->arp.ar_spa[i] = src_ip[i];
+			}
+			ethd_send(board_get_eth(eth_port), 0, pkt, 42, NULL);
+			break;
+
+		case ETH_PROT_IP:
+			if (pkt->ip.ip_p != IP_PROT_ICMP ||
+			    pkt->icmp.type != ICMP_ECHO_REQUEST)
+				break;
+			pkt->icmp.type = ICMP_ECHO_REPLY;
+			pkt->icmp.code = 0;
+			pkt->icmp.cksum = 0;
+			{
+				uint32_t icmp_len = SWAP16(pkt->ip.ip_len) - 20;
+				if (icmp_len % 2) {
+					*((uint8_t*)&pkt->icmp + icmp_len) = 0;
+					icmp_len++;
+				}
+				pkt->icmp.cksum = SWAP16(icmp_chksum(
+					(uint16_t*)&pkt->icmp, icmp_len / 2));
+			}
+			for (i = 0; i < 4; i++) {
+				pkt->ip.ip_dst[i] = pkt->ip.ip_src[i];
+				pkt->ip.ip_src[i] = src_ip[i];
+			}
+			for (i = 0; i < 6; i++) {
+				pkt->eth.et_dest[i] = pkt->eth.et_src[i];
+				pkt->eth.et_src[i] = mac_addr[i];
+			}
+			ethd_send(board_get_eth(eth_port), 0, pkt,
+					SWAP16(pkt->ip.ip_len) + 14, NULL);
+			break;
+
+		default:
+			break;
+		}
+	}
+	return 0;
+}
+
+static int _msd_process(void* arg, void* arg2)
+{
+	if (usbd_get_state() >= USBD_STATE_CONFIGURED)
+		msd_driver_state_machine();
+	return 0;
+}
+
+static int _stats_print(void* arg, void* arg2)
+{
+	struct _sched_stats stats;
+	uint32_t i;
+
+	sched_get_stats(&stats);
+	printf("-- %u audio buffers, %u eth frames, idle %u, coalesced %u\r\n",
+			(unsigned)audio_buffers_played, (unsigned)eth_frames,
+			(unsigned)stats.idle, (unsigned)stats.coalesced);
+	for (i = 0; i < SCHED_PRIORITY_COUNT; i++)
+		printf("   priority %u: %u events\r\n", (unsigned)i,
+				(unsigned)stats.dispatched[i]);
+	return 0;
+}
+
+#ifdef CONFIG_IRQ_PROFILE
+static int _profile_command(void* arg, void* arg2)
+{
+	if (profile_cmd == 'p') {
+		irq_profile_dump(IRQ_BUDGET);
+	} else if (profile_cmd == 'r') {
+		irq_profile_reset();
+		printf("IRQ profile reset\r\n");
+	}
+	return 0;
+}
+
+static void _console_handler(uint8_t c)
+{
+	profile_cmd = c;
+	sched_post(&profile_event);
+}
+#endif
+
+/** Timer event callback (interrupt context): post the scheduler event */
+static int _timer_post(void* arg, void* arg2)
+{
+	sched_post((struct _sched_event*)arg);
+	return 0;
+}
+
+/*----------------------------------------------------------------------------
+ *        Initialization
+ *----------------------------------------------------------------------------*/
+
+static void _audio_init(void)
+{
+	struct _callback refill;
+	uint32_t i;
+
+	for (i = 0; i < AUDIO_FRAMES; i++) {
+		/* triangle wave */
+		int32_t phase = i % AUDIO_TONE_PERIOD;
+		int32_t value = phase < AUDIO_TONE_PERIOD / 2 ? phase
+			: AUDIO_TONE_PERIOD - phase;
+		value = (value * 4 * AUDIO_AMPLITUDE) / AUDIO_TONE_PERIOD - AUDIO_AMPLITUDE;
+		audio_buffer[2 * i] = value;
+		audio_buffer[2 * i + 1] = value;
+	}
+
+	if (classd_configure(&classd_desc) < 0) {
+		printf("ClassD configuration failed!\r\n");
+		return;
+	}
+	classd_set_equalizer(&classd_desc, CLASSD_EQCFG_FLAT);
+	classd_set_left_attenuation(&classd_desc, 30);
+	classd_set_right_attenuation(&classd_desc, 30);
+	classd_volume_unmute(&classd_desc, true, true);
+
+	/* DMA completion (interrupt context) posts the refill event */
+	callback_set(&refill, _audio_refill, NULL);
+	sched_defer_callback(&audio_deferred, PRIO_AUDIO, &refill, &audio_cb);
+	sched_post(&audio_deferred.event);
+}
+
+static void _eth_init(void)
+{
+	struct _callback cb;
+
+	callback_set(&cb, _eth_process, NULL);
+	sched_event_init(&eth_event, PRIO_ETH, &cb);
+
+	ethd_get_mac_addr(board_get_eth(eth_port), 0, mac_addr);
+	printf("-- MAC %02x:%02x:%02x:%02x:%02x:%02x IP %d.%d.%d.%d\r\n",
+	       mac_addr[0], mac_addr[1], mac_addr[2],
+	       mac_addr[3], mac_addr[4], mac_addr[5],
+	       src_ip[0], src_ip[1], src_ip[2], src_ip[3]);
+	ethd_set_rx_callback(board_get_eth(eth_port), 0, _eth_rx_callback);
+}
+
+static void _msd_init(void)
+{
+	struct _callback cb;
+
+	usb_power_configure();
+
+	media_ramdisk_init(&medias[0], (uint32_t)ramdisk_reserved / BLOCK_SIZE,
+			RAMDISK_SIZE / BLOCK_SIZE, BLOCK_SIZE);
+	lun_init(&luns[0], &medias[0], ram_buffer, MSD_BUFFER_SIZE,
+			0, 0, 0, 0, msd_callbacks_data);
+	msd_driver_initialize(&msd_driver_descriptors, luns, 1);
+
+	callback_set(&cb, _msd_process, NULL);
+	sched_event_init(&msd_event, PRIO_MSD, &cb);
+	callback_set(&cb, _timer_post, &msd_event);
+	timer_event_init(&msd_timer, &cb);
+	timer_event_start(&msd_timer, MSD_POLL_PERIOD, MSD_POLL_PERIOD);
+
+	usb_vbus_configure();
+}
+
+static void _stats_init(void)
+{
+	struct _callback cb;
+
+	callback_set(&cb, _stats_print, NULL);
+	sched_event_init(&stats_event, PRIO_STATS, &cb);
+	callback_set(&cb, _timer_post, &stats_event);
+	timer_event_init(&stats_timer, &cb);
+	timer_event_start(&stats_timer, STATS_PERIOD, STATS_PERIOD);
+
+#ifdef CONFIG_IRQ_PROFILE
+	callback_set(&cb, _profile_command, NULL);
+	sched_event_init(&profile_event, PRIO_STATS, &cb);
+	console_set_rx_handler(_console_handler);
+	console_enable_rx_interrupt();
+#endif
+}
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ *  \brief Application entry point for the scheduler example.
+ *
+ *  \return Unused (ANSI-C compatibility).
+ */
+int main(void)
+{
+	console_example_info("Cooperative Scheduler Example");
+
+	_msd_init();
+	_eth_init();
+	_audio_init();
+	_stats_init();
+
+	sched_run();
+
+	return 0;
+}
@@ -0,0 +1,249 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \page spi_nor_bg_erase SPI-NOR Background Erase Example
+ *
+ * \section Purpose
+ *
+ * This example erases and programs the QSPI flash in the background while
+ * the application keeps reading it, and measures the latency of these reads.
+ *
+ * \section Requirements
+ *
+ * This package can be used with SAMA5D2-XPLAINED and SAMA5D27-SOM1-EK boards.
+ *
+ * \section Description
+ *
+ * The latency of reads is first measured on an idle flash.  Then a 256KB
+ * range is erased with spi_nor_erase_async() and programmed with
+ * spi_nor_write_async() while 256-byte reads are issued in a loop: each read
+ * suspends the operation if the flash supports erase/program suspend, or
+ * waits for the sector or page in progress otherwise.  The latency histogram
+ * of the reads is printed for each phase, and the programmed data is checked.
+ *
+ * \section Usage
+ *
+ * -# Build the program and download it inside the board.
+ * -# On the computer, open and configure a terminal application
+ *    (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *   - 115200 baud rate
+ *   - 8 bits of data
+ *   - No parity
+ *   - 1 stop bit
+ *   - No flow control
+ * -# Start the application, the results are printed on the console.
+ *
+ * \section References
+ * - spi_nor_bg_erase/main.c
+ * - spi-nor.h
+ */
+
+/** \file
+ *
+ *  This file contains all the specific code for the spi_nor_bg_erase example.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "board.h"
+#include "board_spi.h"
+#include "callback.h"
+#include "chip.h"
+#include "compiler.h"
+#include "mm/cache.h"
+#include "nvm/spi-nor/spi-nor.h"
+#include "serial/console.h"
+#include "timer.h"
+#include "trace.h"
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define BOARD_SPI_FLASH_QSPI0 0
+
+/** Start and size of the erased range */
+#define TEST_OFFSET 0x280000
+#define TEST_SIZE   (256 * 1024)
+
+/** Size of the foreground reads */
+#define READ_SIZE 256
+
+/** Number of reads measured on the idle flash */
+#define IDLE_READS 1000
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+CACHE_ALIGNED static uint8_t rd_buf[READ_SIZE];
+
+CACHE_ALIGNED static uint8_t wr_buf[4096];
+
+static volatile bool bg_done;
+
+static volatile int bg_status;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static int _bg_callback(void* arg, void* arg2)
+{
+	bg_status = (int)arg2;
+	bg_done = true;
+	return 0;
+}
+
+static void _print_stats(const char* name, const struct spi_flash_read_stats* stats)
+{
+	int i;
+
+	printf("%s: %u reads, %u suspends, max %uus\r\n", name,
+	       (unsigned)stats->count, (unsigned)stats->suspends,
+	       (unsigned)stats->max);
+	for (i = 0; i < SFLASH_READ_LATENCY_BUCKETS; i++) {
+		if (!stats->histogram[i])
+			continue;
+		if (i < SFLASH_READ_LATENCY_BUCKETS - 1)
+			printf("  < %6uus: %u\r\n", 16u << i,
+			       (unsigned)stats->histogram[i]);
+		else
+			printf("  >=%6uus: %u\r\n", 16u << (i - 1),
+			       (unsigned)stats->histogram[i]);
+	}
+}
+
+/* Read the flash in a loop until the background operation completes */
+static void _read_while_busy(struct spi_flash* flash, const char* name)
+{
+	struct spi_flash_read_stats stats;
+	uint64_t start = timer_get_us();
+	size_t offset = 0;
+	int rc;
+
+	while (!bg_done) {
+		rc = spi_nor_read(flash, offset, rd_buf, READ_SIZE);
+		if (rc < 0) {
+			printf("read error %d\r\n", rc);
+			break;
+		}
+		offset = (offset + READ_SIZE) % TEST_OFFSET;
+	}
+	while (!bg_done);
+
+	printf("%s returns %d after %ums\r\n", name, bg_status,
+	       (unsigned)((timer_get_us() - start) / 1000));
+	spi_nor_get_read_stats(flash, &stats);
+	_print_stats(name, &stats);
+	spi_nor_reset_read_stats(flash);
+}
+
+/* Measure the reads of the idle flash, spi_nor_read() does not account them */
+static void _read_idle(struct spi_flash* flash)
+{
+	struct spi_flash_read_stats stats;
+	int i, j;
+
+	memset(&stats, 0, sizeof(stats));
+	for (i = 0; i < IDLE_READS; i++) {
+		uint64_t start = timer_get_us();
+		uint32_t latency;
+
+		spi_nor_read(flash, i * READ_SIZE, rd_buf, READ_SIZE);
+		latency = (uint32_t)(timer_get_us() - start);
+
+		for (j = 0; j < SFLASH_READ_LATENCY_BUCKETS - 1; j++)
+			if (latency < (16u << j))
+				break;
+		stats.histogram[j]++;
+		stats.count++;
+		if (latency > stats.max)
+			stats.max = latency;
+	}
+	_print_stats("idle", &stats);
+}
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	struct spi_flash* flash = board_get_spi_flash(BOARD_SPI_FLASH_QSPI0);
+	struct _callback cb;
+	size_t offset;
+	int i, rc, errors = 0;
+
+	/* Output example information */
+	console_example_info("SPI-NOR Background Erase Example");
+
+	printf("erase suspend: %s, program suspend: %s\r\n",
+	       flash->erase_suspend.suspend_inst ? "yes" : "no",
+	       flash->program_suspend.suspend_inst ? "yes" : "no");
+
+	_read_idle(flash);
+
+	callback_set(&cb, _bg_callback, NULL);
+
+	printf("erasing %uKB at 0x%08x\r\n", TEST_SIZE / 1024, TEST_OFFSET);
+	bg_done = false;
+	rc = spi_nor_erase_async(flash, TEST_OFFSET, TEST_SIZE, &cb);
+	if (rc < 0)
+		printf("erase returns %d\r\n", rc);
+	else
+		_read_while_busy(flash, "erase");
+
+	for (i = 0; i < sizeof(wr_buf); i++)
+		wr_buf[i] = i ^ (i >> 8);
+
+	printf("programming %uKB at 0x%08x\r\n", (unsigned)sizeof(wr_buf) / 1024, TEST_OFFSET);
+	bg_done = false;
+	rc = spi_nor_write_async(flash, TEST_OFFSET, wr_buf, sizeof(wr_buf), &cb);
+	if (rc < 0)
+		printf("write returns %d\r\n", rc);
+	else
+		_read_while_busy(flash, "program");
+
+	for (offset = 0; offset < sizeof(wr_buf); offset += READ_SIZE) {
+		spi_nor_read(flash, TEST_OFFSET + offset, rd_buf, READ_SIZE);
+		if (memcmp(rd_buf, wr_buf + offset, READ_SIZE))
+			errors++;
+	}
+	printf("verify: %d error(s)\r\n", errors);
+
+	while (1);
+}
@@ -0,0 +1,645 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \page spi_sg_bench SPI Transaction Compiler Benchmark
+ *
+ * \section Purpose
+ *
+ * This example checks the compilation of SPI transactions into DMA
+ * scatter/gather lists (spid_sg.h) and compares the cost of a transaction
+ * transferred buffer by buffer with the cost of a compiled transaction.
+ *
+ * \section Requirements
+ *
+ * This package can be used with all SAMA5D2x, SAMA5D3x, SAMA5D4x and SAM9xx5
+ * boards, no SPI device is used: transfers run on a simulated DMA model.  It
+ * can also be compiled for a Linux host with Makefile.linux.
+ *
+ * \section Description
+ *
+ * The model has a loopback SPI with a TX and a RX FIFO, and a DMA channel
+ * per direction that moves one chunk per request, as soon as the FIFO has
+ * room for it (TX) or holds it (RX).  Usual transactions (command, address,
+ * dummy and data phases, several chip select cycles, full duplex) with
+ * random alignments are run with and without SPI FIFO:
+ * - buffer by buffer, as the SPI driver did before: buffers shorter than 16
+ *   bytes are polled, others get their own byte-wide DMA transfer;
+ * - compiled, as the SPI driver does now: one transfer up to each chip
+ *   select release.
+ * The received data and the chip select releases are checked, and the items
+ * must respect the alignment of their data width and the FIFO size.
+ *
+ * Then, for each transaction, the number of DMA setups, interrupts, data
+ * accesses and polled bytes is printed, along with the number of
+ * transactions per second achieved by the CPU side of the driver (setups of
+ * the simulated registers and descriptors, interrupt handling, polling),
+ * assuming a bus fast enough for the CPU to be the limit.
+ *
+ * \section Usage
+ *
+ * -# Build the program and download it inside the board.
+ * -# On the computer, open and configure a terminal application
+ *    (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *   - 115200 baud rate
+ *   - 8 bits of data
+ *   - No parity
+ *   - 1 stop bit
+ *   - No flow control
+ * -# Start the application, the results are printed on the console.
+ * -# To run it on a Linux computer, run "make -f Makefile.linux" and
+ *    "./spi_sg_bench" in the example directory.
+ *
+ * \section References
+ * - spi_sg_bench/main.c
+ * - spid_sg.h
+ * - perf.h
+ */
+
+/** \file
+ *
+ *  This file contains all the specific code for the SPI transaction
+ *  compiler benchmark.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "compiler.h"
+#include "perf.h"
+#include "spi/spid_sg.h"
+
+#ifdef CONFIG_ARCH_ARM
+#include "board.h"
+#include "chip.h"
+#include "trace.h"
+
+#include "serial/console.h"
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Same threshold as the SPI driver */
+#define POLLING_THRESHOLD 16
+
+/** Items per list, as CONFIG_SPID_DMA_SG_ITEMS */
+#define SG_ITEMS 8
+
+/** Size and threshold of the SPI FIFOs (SAMA5D2 SPI) */
+#define FIFO_SIZE 16
+#define FIFO_THRESHOLD 8
+
+/** Longest buffer of the transactions */
+#define MAX_BUFFER 512
+
+/** Number of random checks of each transaction */
+#define CHECK_RUNS 2000
+
+/** Number of measured runs per benchmark */
+#define BENCH_RUNS 10
+
+/** Transactions per benchmark run */
+#define BENCH_TRANSACTIONS 1000
+
+/** Cost model of the target for the transactions per second: SPI clock,
+ * access to a peripheral register through the bus bridge, and interrupt
+ * (entry, AIC, DMA driver handler and return) */
+#define MODEL_SCK_HZ 50000000
+#define MODEL_REG_NS 40
+#define MODEL_IRQ_NS 1000
+
+/** Buffer attributes */
+#define TX BUS_BUF_ATTR_TX
+#define RX BUS_BUF_ATTR_RX
+#define CS BUS_SPI_BUF_ATTR_RELEASE_CS
+
+/*----------------------------------------------------------------------------
+ *        Local types
+ *----------------------------------------------------------------------------*/
+
+struct _phase {
+	uint32_t size;
+	uint32_t attr;
+};
+
+struct _transaction {
+	const char* name;
+	struct _phase phases[6];
+};
+
+/** Simulated DMA channel, its registers and its descriptors */
+struct _sim_channel {
+	volatile uint32_t regs[16];
+	volatile uint32_t desc[SG_ITEMS][5];
+	const struct _spid_sg_item* items;
+	uint32_t count;
+};
+
+/** Counters of a transaction */
+struct _stats {
+	uint32_t setups;    /**< DMA channel configurations */
+	uint32_t irqs;      /**< DMA interrupts */
+	uint32_t regs;      /**< peripheral register accesses by the CPU */
+	uint32_t accesses;  /**< DMA accesses to SPI_TDR/SPI_RDR */
+	uint32_t polled;    /**< bytes transferred by the CPU */
+	uint32_t releases;  /**< chip select releases */
+};
+
+/** State of the model */
+struct _sim {
+	const struct _spid_sg_caps* caps;
+	uint32_t fifo_size;
+	bool move_data;    /**< run the data path, false when timing the CPU */
+	struct _buffer* buffers;
+	uint32_t count;
+	uint32_t current;
+	struct _sim_channel tx, rx;
+	struct _stats stats;
+	uint32_t errors;
+	/* FIFOs, the loopback copies TX to RX */
+	uint8_t fifo[2 * MAX_BUFFER * 6];
+	uint32_t fifo_in, fifo_out;
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static const struct _transaction transactions[] = {
+	{ "read 16", { { 1, TX }, { 3, TX }, { 16, RX | CS } } },
+	{ "read 64", { { 1, TX }, { 3, TX }, { 64, RX | CS } } },
+	{ "fast read 256", { { 1, TX }, { 3, TX }, { 1, TX }, { 256, RX | CS } } },
+	{ "page program 256", { { 1, TX | CS }, { 1, TX }, { 3, TX }, { 256, TX | CS } } },
+	{ "2x register write", { { 1, TX }, { 2, TX | CS }, { 1, TX }, { 2, TX | CS } } },
+	{ "full duplex 32", { { 32, TX | RX | CS } } },
+	{ "sensor read 6", { { 1, TX }, { 6, RX | CS } } },
+	{ "gather write 4x64", { { 1, TX }, { 64, TX }, { 64, TX }, { 64, TX }, { 64, TX | CS } } },
+};
+
+static const struct _spid_sg_caps caps_fifo = {
+	.max_items = SG_ITEMS,
+	.max_len = 0xffffff,
+	.chunks = 0x1f,
+	.max_burst = FIFO_THRESHOLD,
+	.rx_width = 2,
+	.tx_width = 0,
+};
+
+static const struct _spid_sg_caps caps_no_fifo = {
+	.max_items = SG_ITEMS,
+	.max_len = 0xffffff,
+	.chunks = 0x1f,
+	.max_burst = 1,
+	.rx_width = 0,
+	.tx_width = 0,
+};
+
+/* data of the transactions, expected data and copy of the TX data */
+ALIGNED(4) static uint8_t data[6][MAX_BUFFER + 4];
+static uint8_t expected[6][MAX_BUFFER];
+
+static struct _sim sim;
+
+static uint32_t rand_state = 1;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint32_t _rand(void)
+{
+	rand_state = rand_state * 1103515245 + 12345;
+	return rand_state >> 16;
+}
+
+static void _reg_write(volatile uint32_t* reg, uint32_t value)
+{
+	*reg = value;
+	sim.stats.regs++;
+}
+
+static void _reg_read(volatile uint32_t* reg)
+{
+	(void)*reg;
+	sim.stats.regs++;
+}
+
+/** Program the registers and descriptors of a channel, as the DMA driver */
+static void _sim_configure(struct _sim_channel* ch,
+		const struct _spid_sg_item* items, uint32_t count)
+{
+	uint32_t i;
+
+	ch->items = items;
+	ch->count = count;
+	for (i = 0; i < count; i++)
+		sim.stats.accesses += items[i].len;
+	if (count > 1) {
+		/* view 2 descriptors, the channel starts on the first one */
+		for (i = 0; i < count; i++) {
+			ch->desc[i][0] = (uint32_t)(uintptr_t)ch->desc[i + 1];
+			ch->desc[i][1] = items[i].len | (2u << 27);
+			ch->desc[i][2] = (uint32_t)(uintptr_t)items[i].data;
+			ch->desc[i][3] = 0;
+			ch->desc[i][4] = items[i].width << 11 | items[i].chunk << 8;
+		}
+		_reg_write(&ch->regs[0], ch->desc[0][4]);
+		_reg_write(&ch->regs[1], (uint32_t)(uintptr_t)ch->desc[0]);
+		_reg_write(&ch->regs[2], 0x1d);
+	} else {
+		_reg_write(&ch->regs[0], items[0].width << 11 | items[0].chunk << 8);
+		_reg_write(&ch->regs[3], items[0].len);
+		_reg_write(&ch->regs[4], (uint32_t)(uintptr_t)items[0].data);
+		_reg_write(&ch->regs[5], 0);
+	}
+	/* clear status, block/stride registers, interrupts, enable */
+	_reg_read(&ch->regs[6]);
+	_reg_write(&ch->regs[7], 0);
+	_reg_write(&ch->regs[8], 0);
+	_reg_write(&ch->regs[9], 0);
+	_reg_write(&ch->regs[10], 0);
+	_reg_write(&ch->regs[11], ~0u);
+	_reg_write(&ch->regs[12], count > 1 ? 2 : 1);
+	_reg_write(&ch->regs[13], 1);
+	sim.stats.setups++;
+}
+
+static void _sim_check_item(const struct _spid_sg_item* item)
+{
+	uint32_t bytes = 1u << (item->chunk + item->width);
+
+	if ((uintptr_t)item->data & ((1u << item->width) - 1))
+		sim.errors++;
+	if (item->len & ((1u << item->chunk) - 1))
+		sim.errors++;
+	if (bytes > sim.fifo_size)
+		sim.errors++;
+}
+
+/** Run both lists of the channels on the loopback SPI */
+static void _sim_run(void)
+{
+	uint32_t tx_i = 0, tx_pos = 0, rx_i = 0, rx_pos = 0;
+	uint32_t tx_level = 0;
+	const uint8_t dummy[4] = { 0xff, 0xff, 0xff, 0xff };
+	uint8_t garbage[4];
+	uint32_t i;
+
+	for (i = 0; i < sim.tx.count; i++) {
+		_sim_check_item(&sim.tx.items[i]);
+		_sim_check_item(&sim.rx.items[i]);
+	}
+
+	while (tx_i < sim.tx.count || rx_i < sim.rx.count) {
+		bool progress = false;
+
+		/* TX request: a chunk when the FIFO has room for it */
+		if (tx_i < sim.tx.count) {
+			const struct _spid_sg_item* item = &sim.tx.items[tx_i];
+			uint32_t unit = 1u << item->width;
+			uint32_t bytes = unit << item->chunk;
+
+			if (tx_level + bytes <= sim.fifo_size) {
+				for (i = 0; i < bytes; i++) {
+					const uint8_t* src = item->data ?
+						item->data + tx_pos * unit : dummy;
+					sim.fifo[sim.fifo_in++] = src[i % unit];
+					if ((i + 1) % unit == 0)
+						tx_pos++;
+				}
+				tx_level += bytes;
+				if (tx_pos == item->len) {
+					tx_i++;
+					tx_pos = 0;
+				}
+				progress = true;
+			}
+		}
+
+		/* shift one byte from the TX FIFO to the RX FIFO */
+		if (tx_level > 0 && sim.fifo_in - sim.fifo_out - tx_level < sim.fifo_size) {
+			tx_level--;
+			progress = true;
+		}
+
+		/* RX request: a chunk when the FIFO holds it */
+		if (rx_i < sim.rx.count) {
+			const struct _spid_sg_item* item = &sim.rx.items[rx_i];
+			uint32_t unit = 1u << item->width;
+			uint32_t bytes = unit << item->chunk;
+
+			if (sim.fifo_in - sim.fifo_out - tx_level >= bytes) {
+				for (i = 0; i < bytes; i++) {
+					uint8_t* dst = item->data ?
+						item->data + rx_pos * unit : garbage;
+					dst[i % unit] = sim.fifo[sim.fifo_out++];
+					if ((i + 1) % unit == 0)
+						rx_pos++;
+				}
+				if (rx_pos == item->len) {
+					rx_i++;
+					rx_pos = 0;
+				}
+				progress = true;
+			}
+		}
+
+		if (!progress) {
+			printf("-E- DMA model stalled\r\n");
+			sim.errors++;
+			return;
+		}
+	}
+}
+
+/** Interrupt of the simulated RX channel: status read and callback */
+static void _sim_irq(void (*handler)(void))
+{
+	_reg_read(&sim.rx.regs[6]);
+	_reg_read(&sim.tx.regs[6]);
+	sim.stats.irqs += 2;
+	handler();
+}
+
+static void _transfer_next(void);
+
+static void _transfer_done(void)
+{
+	if (sim.buffers[sim.current].attr & CS)
+		sim.stats.releases++;
+	sim.current++;
+	if (sim.current < sim.count)
+		_transfer_next();
+}
+
+/** Transfer the current buffer by the CPU */
+static void _transfer_polling(void)
+{
+	struct _buffer* buf = &sim.buffers[sim.current];
+	uint32_t i;
+
+	for (i = 0; i < buf->size; i++) {
+		uint8_t out = (buf->attr & TX) ? buf->data[i] : 0xff;
+		/* TDR write, status poll and RDR read */
+		_reg_write(&sim.rx.regs[14], out);
+		_reg_read(&sim.rx.regs[15]);
+		_reg_read(&sim.rx.regs[15]);
+		if (buf->attr & RX)
+			buf->data[i] = out;
+	}
+	sim.stats.polled += buf->size;
+	_transfer_done();
+}
+
+/** Transfer the current buffer with its own byte-wide DMA transfer */
+static void _transfer_buffer_dma(void)
+{
+	struct _buffer* buf = &sim.buffers[sim.current];
+	static struct _spid_sg_item tx, rx;
+
+	tx.data = (buf->attr & TX) ? buf->data : NULL;
+	rx.data = (buf->attr & RX) ? buf->data : NULL;
+	tx.len = rx.len = buf->size;
+	tx.width = rx.width = 0;
+	tx.chunk = rx.chunk = 0;
+	_sim_configure(&sim.tx, &tx, 1);
+	_sim_configure(&sim.rx, &rx, 1);
+	if (sim.move_data)
+		_sim_run();
+	_sim_irq(_transfer_done);
+}
+
+static bool compiled;
+static struct _spid_sg_plan plan;
+static uint32_t short_last;
+
+static void _transfer_chain_done(void)
+{
+	sim.current += plan.buffers - 1;
+	_transfer_done();
+}
+
+static void _transfer_next(void)
+{
+	static struct _spid_sg_item tx[SG_ITEMS], rx[SG_ITEMS];
+
+	/* skip the segments found too short for DMA, as the driver */
+	if (compiled && (short_last == UINT32_MAX || sim.current > short_last)) {
+		spid_sg_compile(&sim.buffers[sim.current], sim.count - sim.current,
+				sim.caps, tx, rx, &plan);
+		if (plan.items > 0 && plan.size < POLLING_THRESHOLD)
+			short_last = sim.current + plan.buffers - 1;
+		if (plan.items > 0 && plan.size >= POLLING_THRESHOLD) {
+			_sim_configure(&sim.tx, tx, plan.items);
+			_sim_configure(&sim.rx, rx, plan.items);
+			if (sim.move_data)
+				_sim_run();
+			_sim_irq(_transfer_chain_done);
+			return;
+		}
+	}
+
+	if (sim.buffers[sim.current].size < POLLING_THRESHOLD)
+		_transfer_polling();
+	else
+		_transfer_buffer_dma();
+}
+
+/** Prepare the buffers of a transaction with random data and alignments */
+static uint32_t _prepare(const struct _transaction* t, struct _buffer* buffers,
+		bool random_offsets)
+{
+	uint32_t i, j;
+
+	for (i = 0; i < ARRAY_SIZE(t->phases) && t->phases[i].size; i++) {
+		uint32_t offset = random_offsets ? _rand() & 3 : 0;
+
+		buffers[i].data = data[i] + offset;
+		buffers[i].size = t->phases[i].size;
+		buffers[i].attr = t->phases[i].attr;
+		for (j = 0; j < buffers[i].size; j++) {
+			buffers[i].data[j] = (uint8_t)_rand();
+			expected[i][j] = (buffers[i].attr & TX) ? buffers[i].data[j] : 0xff;
+		}
+	}
+	return i;
+}
+
+static void _transfer(struct _buffer* buffers, uint32_t count, bool compile)
+{
+	compiled = compile;
+	sim.buffers = buffers;
+	sim.count = count;
+	sim.current = 0;
+	short_last = UINT32_MAX;
+	memset(&sim.stats, 0, sizeof(sim.stats));
+	sim.fifo_in = sim.fifo_out = 0;
+	_transfer_next();
+}
+
+static uint32_t _check(const struct _spid_sg_caps* caps, uint32_t fifo_size)
+{
+	struct _buffer buffers[6];
+	uint32_t i, j, k, count, releases;
+	uint32_t errors = 0;
+
+	sim.caps = caps;
+	sim.fifo_size = fifo_size;
+	sim.move_data = true;
+
+	for (i = 0; i < ARRAY_SIZE(transactions); i++) {
+		for (j = 0; j < CHECK_RUNS; j++) {
+			count = _prepare(&transactions[i], buffers, j > 0);
+			releases = 0;
+			for (k = 0; k < count; k++)
+				releases += (buffers[k].attr & CS) ? 1 : 0;
+
+			sim.errors = 0;
+			_transfer(buffers, count, (j & 1) == 0);
+			if (sim.stats.releases != releases)
+				sim.errors++;
+			for (k = 0; k < count; k++)
+				if ((buffers[k].attr & RX) &&
+				    memcmp(buffers[k].data, expected[k], buffers[k].size))
+					sim.errors++;
+			if (sim.errors && !errors)
+				printf("-E- %s: %u error(s)\r\n", transactions[i].name,
+				       (unsigned)sim.errors);
+			errors += sim.errors;
+		}
+	}
+	return errors;
+}
+
+static struct _buffer bench_buffers[6];
+static uint32_t bench_count;
+static bool bench_compiled;
+
+static void _run(void* arg)
+{
+	uint32_t i;
+
+	for (i = 0; i < BENCH_TRANSACTIONS; i++)
+		_transfer(bench_buffers, bench_count, bench_compiled);
+}
+
+static void _bench(const struct _spid_sg_caps* caps, uint32_t fifo_size)
+{
+	struct _perf_bench bench;
+	struct _perf_result result;
+	uint32_t i, mode, size, sw_ns, total_ns;
+	uint32_t rate[2];
+
+	sim.caps = caps;
+	sim.fifo_size = fifo_size;
+	sim.move_data = false;
+
+	for (i = 0; i < ARRAY_SIZE(transactions); i++) {
+		bench_count = _prepare(&transactions[i], bench_buffers, false);
+		for (size = 0, mode = 0; mode < bench_count; mode++)
+			size += bench_buffers[mode].size;
+
+		for (mode = 0; mode < 2; mode++) {
+			bench_compiled = mode == 1;
+			memset(&bench, 0, sizeof(bench));
+			bench.name = transactions[i].name;
+			bench.run = _run;
+			sw_ns = 0;
+			if (perf_bench_run(&bench, BENCH_RUNS, &result) == 0)
+				sw_ns = (uint32_t)(result.best.ns / BENCH_TRANSACTIONS);
+
+			total_ns = sw_ns + sim.stats.regs * MODEL_REG_NS
+				+ sim.stats.irqs * MODEL_IRQ_NS
+				+ (uint32_t)((uint64_t)size * 8 * 1000000000 / MODEL_SCK_HZ);
+			rate[mode] = 1000000000 / total_ns;
+
+			printf("%-18s %-8s %6u %4u %4u %6u %6u %8u",
+			       transactions[i].name, mode ? "compiled" : "buffers",
+			       (unsigned)sim.stats.setups, (unsigned)sim.stats.irqs,
+			       (unsigned)sim.stats.regs, (unsigned)sim.stats.polled,
+			       (unsigned)sw_ns, (unsigned)rate[mode]);
+			if (mode)
+				printf("  x%u.%02u", (unsigned)(rate[1] / rate[0]),
+				       (unsigned)(rate[1] * 100 / rate[0] % 100));
+			printf("\r\n");
+		}
+	}
+}
+
+static void _bench_header(const char* title)
+{
+	printf("\r\n%s\r\n", title);
+	printf("%-18s %-8s %6s %4s %4s %6s %6s %8s\r\n", "transaction", "mode",
+	       "setups", "irqs", "regs", "polled", "sw ns", "trans/s");
+}
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+
+int main(void)
+{
+	uint32_t errors = 0;
+
+#ifdef CONFIG_ARCH_ARM
+	console_example_info("SPI Transaction Compiler Benchmark");
+#else
+	printf("-- SPI Transaction Compiler Benchmark (host) --\r\n");
+#endif
+
+	errors += _check(&caps_fifo, FIFO_SIZE);
+	errors += _check(&caps_no_fifo, 1);
+	printf("-I- Functional check: %u error(s)\r\n", (unsigned)errors);
+
+	perf_initialize();
+	printf("%u runs of %u transactions per benchmark, figures of the best run\r\n",
+	       (unsigned)BENCH_RUNS, (unsigned)BENCH_TRANSACTIONS);
+	printf("Model: %u MHz SPI clock, %u ns per register access, %u ns per interrupt\r\n",
+	       (unsigned)(MODEL_SCK_HZ / 1000000), (unsigned)MODEL_REG_NS,
+	       (unsigned)MODEL_IRQ_NS);
+	_bench_header("With SPI FIFO:");
+	_bench(&caps_fifo, FIFO_SIZE);
+	_bench_header("Without SPI FIFO:");
+	_bench(&caps_no_fifo, 1);
+
+#ifdef CONFIG_ARCH_ARM
+	while (1);
+#else
+	return errors ? 1 : 0;
+#endif
+}
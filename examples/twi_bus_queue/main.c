@@ -0,0 +1,411 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \page twi_bus_queue TWI Bus Request Queue Example
+ *
+ * \section Purpose
+ *
+ * This example shows how several users share a TWI bus through the request
+ * queue of the bus driver, with priorities and without busy waiting.
+ *
+ * \section Requirements
+ *
+ * This package can be used with SAMA5D2-XPLAINED board.
+ *
+ * \section Description
+ *
+ * Three users access the ACT8945A PMIC on the same TWI bus:
+ * - a monitor reads the charger state every 5ms from the timer interrupt,
+ *   with bus_submit() at a high priority;
+ * - a background task keeps eight register reads queued at a low priority,
+ *   each one submitted again from its own completion callback;
+ * - the console reads the regulator settings on request with bus_transfer(),
+ *   which is queued at BUS_PRIORITY_DEFAULT.
+ *
+ * Requests are started from the completion interrupt of the previous one,
+ * the CPU sleeps in the scheduler meanwhile.  The queue statistics
+ * (BUS_IOCTL_GET_STATS) and the latency of each class of requests are
+ * printed on the console: the monitor waits at most for one background read
+ * to complete, however deep the queue.
+ *
+ * \section Usage
+ *
+ * -# Build the program and download it inside the board.
+ * -# On the computer, open and configure a terminal application
+ *    (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *   - 115200 baud rate
+ *   - 8 bits of data
+ *   - No parity
+ *   - 1 stop bit
+ *   - No flow control
+ * -# Start the application and use the console menu.
+ *
+ * \section References
+ * - twi_bus_queue/main.c
+ * - bus.h
+ */
+
+/** \file
+ *
+ *  This file contains all the specific code for the TWI bus queue example.
+ *
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "board.h"
+#include "callback.h"
+#include "chip.h"
+#include "compiler.h"
+#include "errno.h"
+#include "irqflags.h"
+#include "sched.h"
+#include "timer.h"
+#include "trace.h"
+
+#include "peripherals/bus.h"
+#include "serial/console.h"
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define PMIC_BUS  BOARD_ACT8945A_TWI_BUS
+#define PMIC_ADDR BOARD_ACT8945A_TWI_ADDR
+
+/** Request priorities */
+#define PRIO_MONITOR    200
+#define PRIO_BACKGROUND 16
+
+/** Monitor period (us) */
+#define MONITOR_PERIOD 5000
+
+/** Charger state register of the ACT8945A */
+#define IADDR_APCH_7A  0x7a
+
+/** Event priorities */
+#define PRIO_CONSOLE 0
+
+enum {
+	CLASS_MONITOR,
+	CLASS_BACKGROUND,
+	CLASS_CONSOLE,
+	CLASS_COUNT,
+};
+
+/** Read of one PMIC register, as a queued request */
+struct _reg_read {
+	struct _bus_request req;
+	struct _buffer buf[2];
+	uint8_t iaddr;
+	uint8_t value;
+	uint8_t class;
+	uint64_t submit_us;
+};
+
+/** Completion latency of a class of requests */
+struct _latency {
+	uint32_t count;
+	uint32_t errors;
+	uint64_t total_us;
+	uint32_t max_us;
+};
+
+/*----------------------------------------------------------------------------
+ *        Local constants
+ *----------------------------------------------------------------------------*/
+
+/** VSET registers of the regulators, read by the background task */
+static const uint8_t background_regs[] = {
+	0x20, 0x21, 0x30, 0x31, 0x40, 0x41, 0x50, 0x54,
+};
+
+static const char* const class_names[CLASS_COUNT] = {
+	"monitor", "background", "console",
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static struct _reg_read monitor;
+static uint32_t monitor_overruns;
+static struct _timer_event monitor_timer;
+
+static struct _reg_read background[ARRAY_SIZE(background_regs)];
+static volatile bool background_enabled;
+
+static struct _latency latency[CLASS_COUNT];
+
+static struct _sched_event console_event;
+static volatile uint8_t console_cmd;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static void _reg_read_init(struct _reg_read* rd, uint8_t iaddr, uint8_t class,
+		uint8_t priority, struct _callback* cb)
+{
+	memset(rd, 0, sizeof(*rd));
+	rd->iaddr = iaddr;
+	rd->class = class;
+	rd->buf[0].data = &rd->iaddr;
+	rd->buf[0].size = 1;
+	rd->buf[0].attr = BUS_I2C_BUF_ATTR_START | BUS_BUF_ATTR_TX | BUS_I2C_BUF_ATTR_STOP;
+	rd->buf[1].data = &rd->value;
+	rd->buf[1].size = 1;
+	rd->buf[1].attr = BUS_I2C_BUF_ATTR_START | BUS_BUF_ATTR_RX | BUS_I2C_BUF_ATTR_STOP;
+	rd->req.remote = PMIC_ADDR;
+	rd->req.buf = rd->buf;
+	rd->req.buffers = 2;
+	rd->req.priority = priority;
+	callback_copy(&rd->req.callback, cb);
+}
+
+static int _reg_read_submit(struct _reg_read* rd)
+{
+	rd->submit_us = timer_get_us();
+	return bus_submit(PMIC_BUS, &rd->req);
+}
+
+/* From the completion interrupt */
+static void _latency_record(uint8_t class, uint64_t submit_us, int status)
+{
+	struct _latency* l = &latency[class];
+	uint32_t us = (uint32_t)(timer_get_us() - submit_us);
+
+	l->count++;
+	if (status < 0)
+		l->errors++;
+	l->total_us += us;
+	if (us > l->max_us)
+		l->max_us = us;
+}
+
+static int _monitor_done(void* arg, void* arg2)
+{
+	struct _reg_read* rd = (struct _reg_read*)arg;
+
+	_latency_record(rd->class, rd->submit_us, (int)arg2);
+	return 0;
+}
+
+static int _monitor_tick(void* arg, void* arg2)
+{
+	/* the previous read is still waiting, do not queue it twice */
+	if (monitor.req.status == -EINPROGRESS) {
+		monitor_overruns++;
+		return 0;
+	}
+	_reg_read_submit(&monitor);
+	return 0;
+}
+
+static int _background_done(void* arg, void* arg2)
+{
+	struct _reg_read* rd = (struct _reg_read*)arg;
+
+	_latency_record(rd->class, rd->submit_us, (int)arg2);
+
+	/* keep the request queued from its own completion */
+	if (background_enabled)
+		_reg_read_submit(rd);
+	return 0;
+}
+
+static void _background_start(void)
+{
+	uint32_t i;
+
+	background_enabled = true;
+	for (i = 0; i < ARRAY_SIZE(background); i++)
+		if (background[i].req.status != -EINPROGRESS)
+			_reg_read_submit(&background[i]);
+}
+
+static void _print_regulators(void)
+{
+	uint64_t start;
+	uint8_t iaddr, value;
+	uint32_t i;
+	int err;
+
+	for (i = 0; i < ARRAY_SIZE(background_regs); i++) {
+		struct _buffer buf[2] = {
+			{
+				.data = &iaddr,
+				.size = 1,
+				.attr = BUS_I2C_BUF_ATTR_START | BUS_BUF_ATTR_TX | BUS_I2C_BUF_ATTR_STOP,
+			},
+			{
+				.data = &value,
+				.size = 1,
+				.attr = BUS_I2C_BUF_ATTR_START | BUS_BUF_ATTR_RX | BUS_I2C_BUF_ATTR_STOP,
+			},
+		};
+
+		iaddr = background_regs[i];
+		start = timer_get_us();
+		/* no transaction opened: queued behind the other users */
+		err = bus_transfer(PMIC_BUS, PMIC_ADDR, buf, 2, NULL);
+		_latency_record(CLASS_CONSOLE, start, err);
+		if (err < 0)
+			printf("   0x%02x: error %d\r\n", (unsigned)iaddr, err);
+		else
+			printf("   0x%02x: 0x%02x\r\n", (unsigned)iaddr, (unsigned)value);
+	}
+}
+
+static void _print_stats(void)
+{
+	struct _bus_stats stats;
+	struct _latency l[CLASS_COUNT];
+	uint32_t flags, i;
+
+	bus_ioctl(PMIC_BUS, BUS_IOCTL_GET_STATS, &stats);
+	flags = arch_irq_save();
+	memcpy(l, latency, sizeof(l));
+	arch_irq_restore(flags);
+
+	printf("-- queue: %u submitted, %u completed, %u errors, depth %u (max %u)\r\n",
+			(unsigned)stats.submitted, (unsigned)stats.completed,
+			(unsigned)stats.errors, (unsigned)stats.depth,
+			(unsigned)stats.max_depth);
+	printf("   wait before start: avg %uus, max %uus\r\n",
+			(unsigned)(stats.completed ? stats.wait_us / stats.completed : 0),
+			(unsigned)stats.max_wait_us);
+	for (i = 0; i < CLASS_COUNT; i++)
+		printf("   %-10s: %u done, %u errors, latency avg %uus, max %uus\r\n",
+				class_names[i], (unsigned)l[i].count,
+				(unsigned)l[i].errors,
+				(unsigned)(l[i].count ? l[i].total_us / l[i].count : 0),
+				(unsigned)l[i].max_us);
+	printf("   monitor overruns: %u\r\n", (unsigned)monitor_overruns);
+}
+
+static void _print_menu(void)
+{
+	printf("Menu:\r\n"
+	       "  b: start/stop the background reads\r\n"
+	       "  v: read the regulator settings with bus_transfer()\r\n"
+	       "  s: print statistics\r\n"
+	       "  r: reset statistics\r\n"
+	       "  m: print this menu\r\n");
+}
+
+static int _console_command(void* arg, void* arg2)
+{
+	uint8_t c = console_cmd;
+	uint32_t flags;
+
+	if (c == 'b') {
+		if (background_enabled)
+			background_enabled = false;
+		else
+			_background_start();
+		printf("-- background reads %s\r\n",
+				background_enabled ? "on" : "off");
+	} else if (c == 'v') {
+		_print_regulators();
+	} else if (c == 's') {
+		_print_stats();
+	} else if (c == 'r') {
+		bus_ioctl(PMIC_BUS, BUS_IOCTL_RESET_STATS, NULL);
+		flags = arch_irq_save();
+		memset(latency, 0, sizeof(latency));
+		monitor_overruns = 0;
+		arch_irq_restore(flags);
+		printf("-- statistics reset\r\n");
+	} else if (c == 'm') {
+		_print_menu();
+	}
+
+	return 0;
+}
+
+static void _console_handler(uint8_t c)
+{
+	console_cmd = c;
+	sched_post(&console_event);
+}
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ *  \brief Application entry point for the TWI bus queue example.
+ *
+ *  \return Unused (ANSI-C compatibility).
+ */
+int main(void)
+{
+	struct _callback cb;
+	enum _bus_transfer_mode mode = BUS_TRANSFER_MODE_ASYNC;
+	uint32_t i;
+
+	console_example_info("TWI Bus Queue Example");
+
+	/* completions are signalled by the TWI interrupt */
+	bus_ioctl(PMIC_BUS, BUS_IOCTL_SET_TRANSFER_MODE, &mode);
+
+	callback_set(&cb, _monitor_done, &monitor);
+	_reg_read_init(&monitor, IADDR_APCH_7A, CLASS_MONITOR, PRIO_MONITOR, &cb);
+	for (i = 0; i < ARRAY_SIZE(background); i++) {
+		callback_set(&cb, _background_done, &background[i]);
+		_reg_read_init(&background[i], background_regs[i],
+				CLASS_BACKGROUND, PRIO_BACKGROUND, &cb);
+	}
+
+	callback_set(&cb, _console_command, NULL);
+	sched_event_init(&console_event, PRIO_CONSOLE, &cb);
+	console_set_rx_handler(_console_handler);
+	console_enable_rx_interrupt();
+
+	_print_menu();
+
+	callback_set(&cb, _monitor_tick, NULL);
+	timer_event_init(&monitor_timer, &cb);
+	timer_event_start(&monitor_timer, MONITOR_PERIOD, MONITOR_PERIOD);
+
+	_background_start();
+
+	sched_run();
+
+	return 0;
+}
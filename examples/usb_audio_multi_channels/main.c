@@ -134,15 +134,18 @@
  *         Definitions
  *----------------------------------------------------------------------------*/
 
-/**  Number of available audio buffers. */
-#define BUFFERS (32)
+/**  Size of the buffer receiving USB packets, in bytes. */
+#define PACKET_SIZE ROUND_UP_MULT(AUDDSpeakerDriver_BYTESPERFRAME, L1_CACHE_BYTES)
 
-/**  Size of one buffer in bytes. */
-#define BUFFER_SIZE ROUND_UP_MULT(AUDDSpeakerDriver_BYTESPERFRAME, L1_CACHE_BYTES)
+/**  Size of a period of the audio stream: one USB frame (1 ms). */
+#define PERIOD_SIZE (AUDDSpeakerDriver_BYTESPERFRAME)
 
-/**  Delay (in number of buffers) before starting the DAC transmission
-     after data has been received. */
-#define BUFFER_THRESHOLD (8)
+/**  Number of periods of the audio stream. */
+#define PERIODS (16)
+
+/**  Periods queued before starting the DAC transmission, and kept queued
+     by the clock adjustment: 5 ms of latency. */
+#define TARGET_LEVEL (5)
 
 /*----------------------------------------------------------------------------
  *         External variables
@@ -155,31 +158,17 @@ extern const USBDDriverDescriptors audd_speaker_driver_descriptors;
  *         Internal variables
  *----------------------------------------------------------------------------*/
 
-/**  Data buffers for receiving audio frames from the USB host. */
-CACHE_ALIGNED static uint8_t _buffer[BUFFERS][BUFFER_SIZE];
+/**  Data buffer for receiving audio frames from the USB host. */
+CACHE_ALIGNED static uint8_t _packet[PACKET_SIZE];
 
-/**  Number of samples stored in each data buffer. */
-static uint32_t _samples[BUFFERS];
+/**  Ring of periods of the audio stream. */
+CACHE_ALIGNED static uint8_t _ring[PERIODS][PERIOD_SIZE];
 
 /**  Audio context */
 static struct _audio_ctx {
-	uint32_t* samples;
-	uint32_t threshold;
-	struct {
-		uint16_t rx;
-		uint16_t tx;
-		uint32_t count;
-	} circ;
 	uint8_t volume;
-	bool playing;
+	volatile bool playing;
 } _audio_ctx = {
-	.samples = _samples,
-	.threshold = BUFFER_THRESHOLD,
-	.circ = {
-		.rx = 0,
-		.tx = 0,
-		.count = 0,
-	},
 	.volume =  AUDIO_PLAY_MAX_VOLUME / 2,
 	.playing = false,
 };
@@ -188,31 +177,6 @@ static struct _audio_ctx {
  *         Internal functions
  *----------------------------------------------------------------------------*/
 
-/**
- *  \brief Audio TX callback
- */
-static int _audio_transfer_callback(void* arg1, void* arg2)
-{
-	struct _audio_desc* desc = (struct _audio_desc*)arg1;
-	struct _callback _cb;
-
-	if (_audio_ctx.circ.count > 0) {
-		_audio_ctx.circ.tx = (_audio_ctx.circ.tx + 1) % BUFFERS;
-		_audio_ctx.circ.count--;
-		/* Load next buffer */
-		callback_set(&_cb, _audio_transfer_callback, desc);
-		audio_transfer(desc,
-			       _buffer[_audio_ctx.circ.tx],
-			       _audio_ctx.samples[_audio_ctx.circ.tx],
-			       &_cb);
-	} else {
-		_audio_ctx.playing = false;
-		audio_enable(desc, true);
-	}
-
-	return 0;
-}
-
 /**
  *  Invoked when a frame has been received.
  */
@@ -221,43 +185,23 @@ static void _usb_frame_recv_callback(void* arg, uint8_t status, uint32_t transfe
 	struct _audio_desc* desc = (struct _audio_desc*)arg;
 
 	if (status == USBD_STATUS_SUCCESS) {
-		if (_audio_ctx.circ.count >= (BUFFERS - 1)) {
-			_audio_ctx.circ.tx = (_audio_ctx.circ.tx + 1) % BUFFERS;
-			_audio_ctx.circ.count--;
-		}
-
-		_audio_ctx.samples[_audio_ctx.circ.rx] = transferred;
-		_audio_ctx.circ.rx = (_audio_ctx.circ.rx + 1) % BUFFERS;
-		_audio_ctx.circ.count++;
+		/* Data that does not fit in the stream ring is dropped */
+		audio_stream_write(desc, _packet, transferred);
 
-		if (_audio_ctx.circ.count >= _audio_ctx.threshold) {
-			if (!_audio_ctx.playing) {
-				audio_enable(desc, true);
+		/* Start DAC transmission once the target latency is reached */
+		if (!_audio_ctx.playing &&
+		    audio_stream_get_level(desc) >= TARGET_LEVEL) {
+			if (audio_stream_start(desc) == 0)
 				_audio_ctx.playing = true;
-			}
-			if (audio_transfer_is_done(&audio_device)) {
-				struct _callback _cb;
-
-				/* Start DAC transmission if necessary */
-				callback_set(&_cb, _audio_transfer_callback, desc);
-				audio_transfer(desc,
-					       _buffer[_audio_ctx.circ.tx],
-					       _audio_ctx.samples[_audio_ctx.circ.tx],
-					       &_cb);
-				_audio_ctx.circ.tx = (_audio_ctx.circ.tx + 1) % BUFFERS;
-				_audio_ctx.circ.count--;
-			}
+			else
+				trace_error("Cannot start audio stream\r\n");
 		}
-	} else if (status == USBD_STATUS_ABORTED) {
-		/* Error , ABORT, add NULL buffer */
-		_audio_ctx.samples[_audio_ctx.circ.rx] = 0;
 	} else {
-		/* Packet is discarded */
+		/* Packet is discarded, silence is played if needed */
 	}
 
 	/* Receive next packet */
-	audd_speaker_driver_read(_buffer[_audio_ctx.circ.rx],
-				 AUDDSpeakerDriver_BYTESPERFRAME,
+	audd_speaker_driver_read(_packet, AUDDSpeakerDriver_BYTESPERFRAME,
 				 _usb_frame_recv_callback, desc);
 }
 
@@ -323,10 +267,12 @@ void audd_speaker_driver_mute_changed(uint8_t channel, uint8_t muted)
 void audd_speaker_driver_stream_setting_changed(uint8_t new_setting)
 {
 	if (new_setting) {
-		audio_stop(&audio_device);
-		_audio_ctx.circ.count = 0;
-		_audio_ctx.circ.tx = 0;
-		_audio_ctx.circ.rx = 0;
+		/* Restart with an empty stream */
+		if (_audio_ctx.playing)
+			audio_stream_stop(&audio_device);
+		_audio_ctx.playing = false;
+		audio_stream_configure(&audio_device, _ring, PERIOD_SIZE,
+				PERIODS, NULL);
 	}
 }
 
@@ -392,6 +338,11 @@ int main(void)
 	/* Configure audio play volume */
 	audio_set_volume(&audio_device, _audio_ctx.volume);
 
+	/* Configure the audio stream */
+	if (audio_stream_configure(&audio_device, _ring, PERIOD_SIZE,
+				PERIODS, NULL))
+		trace_fatal("Cannot configure the audio stream\r\n");
+
 	/* USB audio driver initialization */
 	audd_speaker_driver_initialize(&audd_speaker_driver_descriptors);
 
@@ -405,7 +356,7 @@ int main(void)
 			continue;
 		}
 
-		_jitter_curr = (_audio_ctx.circ.count - _audio_ctx.threshold);
+		_jitter_curr = (int32_t)audio_stream_get_level(&audio_device) - TARGET_LEVEL;
 
 		if (jitter != _jitter_curr) {
 			jitter = _jitter_curr;
@@ -424,7 +375,7 @@ int main(void)
 		if (!usb_conn) {
 			trace_info("USB connected\r\n");
 			/* Start Reading the incoming audio stream */
-			audd_speaker_driver_read(_buffer[_audio_ctx.circ.rx],
+			audd_speaker_driver_read(_packet,
 					AUDDSpeakerDriver_BYTESPERFRAME,
 					_usb_frame_recv_callback, &audio_device);
 
@@ -53,6 +53,11 @@
  *  amplifier. At the same time, the audio stream received is also sent
  *  back to host from EK for recording.
  *
+ *  The streaming endpoint is asynchronous: the DAC runs from its own clock,
+ *  and the rate it consumes samples, measured from the DMA position, is sent
+ *  back to the host through a feedback endpoint. The feedback also keeps the
+ *  buffered audio at 5 ms, so that the stream never underruns or overruns.
+ *
  *  \section Usage
  *
  *  -# Build the program and download it inside the evaluation board. Please
@@ -84,6 +89,7 @@
  *     device list.
  *  -# You can play sound in host side through the USB Audio Device, and it
  *     can be heard from the speaker connected to the EK.
+ *  -# Input 's' to display the statistics of the stream and of the feedback.
  *
  *  \section References
  *  - usb_audio_speaker/main.c
@@ -122,6 +128,7 @@
 #include "serial/console.h"
 #include "trace.h"
 #include "../usb_common/main_usb_common.h"
+#include "usb/device/audio/audd_feedback.h"
 #include "usb/device/audio/audd_speaker_driver.h"
 
 #if defined(CONFIG_BOARD_SAMA5D2_XPLAINED)
@@ -150,15 +157,18 @@
  *         Definitions
  *----------------------------------------------------------------------------*/
 
-/**  Number of available audio buffers. */
-#define BUFFERS (32)
+/**  Size of the buffer receiving USB packets, in bytes. */
+#define PACKET_SIZE ROUND_UP_MULT(AUDDSpeakerDriver_MAXBYTESPERFRAME, L1_CACHE_BYTES)
+
+/**  Size of a period of the audio stream: one USB frame (1 ms). */
+#define PERIOD_SIZE (AUDDSpeakerDriver_BYTESPERFRAME)
 
-/**  Size of one buffer in bytes. */
-#define BUFFER_SIZE ROUND_UP_MULT(AUDDSpeakerDriver_BYTESPERFRAME, L1_CACHE_BYTES)
+/**  Number of periods of the audio stream. */
+#define PERIODS (16)
 
-/**  Delay (in number of buffers) before starting the DAC transmission
-     after data has been received. */
-#define BUFFER_THRESHOLD (8)
+/**  Periods queued before starting the DAC transmission, and kept queued
+     by the feedback: 5 ms of latency. */
+#define TARGET_LEVEL (5)
 
 /*----------------------------------------------------------------------------
  *         External variables
@@ -171,31 +181,23 @@ extern const USBDDriverDescriptors audd_speaker_driver_descriptors;
  *         Internal variables
  *----------------------------------------------------------------------------*/
 
-/**  Data buffers for receiving audio frames from the USB host. */
-CACHE_ALIGNED static uint8_t _buffer[BUFFERS][BUFFER_SIZE];
+/**  Data buffer for receiving audio frames from the USB host. */
+CACHE_ALIGNED static uint8_t _packet[PACKET_SIZE];
+
+/**  Ring of periods of the audio stream. */
+CACHE_ALIGNED static uint8_t _ring[PERIODS][PERIOD_SIZE];
 
-/**  Number of samples stored in each data buffer. */
-static uint32_t _samples[BUFFERS];
+/**  Feedback packet sent to the USB host. */
+CACHE_ALIGNED static uint8_t _feedback_packet[L1_CACHE_BYTES];
+
+/**  Feedback of the rate of the DAC. */
+static AUDDFeedback _feedback;
 
 /**  Audio context */
 static struct _audio_ctx {
-	uint32_t* samples;
-	uint32_t threshold;
-	struct {
-		uint16_t rx;
-		uint16_t tx;
-		uint32_t count;
-	} circ;
 	uint8_t volume;
-	bool playing;
+	volatile bool playing;
 } _audio_ctx = {
-	.samples = _samples,
-	.threshold = BUFFER_THRESHOLD,
-	.circ = {
-		.rx = 0,
-		.tx = 0,
-		.count = 0,
-	},
 	.volume =  (AUDIO_PLAY_MAX_VOLUME * 80) / 100,
 	.playing = false,
 };
@@ -209,31 +211,6 @@ static const struct _pin button_pins[] = PINS_PUSHBUTTONS;
  *         Internal functions
  *----------------------------------------------------------------------------*/
 
-/**
- *  \brief Audio TX callback
- */
-static int _audio_transfer_callback(void* arg, void* arg2)
-{
-	struct _audio_desc* desc = (struct _audio_desc*)arg;
-	struct _callback _cb;
-
-	if (_audio_ctx.circ.count > 0) {
-		_audio_ctx.circ.tx = (_audio_ctx.circ.tx + 1) % BUFFERS;
-		_audio_ctx.circ.count--;
-		/* Load next buffer */
-		callback_set(&_cb, _audio_transfer_callback, desc);
-		audio_transfer(desc,
-			       _buffer[_audio_ctx.circ.tx],
-			       _audio_ctx.samples[_audio_ctx.circ.tx],
-			       &_cb);
-	} else {
-		_audio_ctx.playing = false;
-		audio_enable(desc, false);
-	}
-
-	return 0;
-}
-
 /**
  *  Invoked when a frame has been received.
  */
@@ -242,46 +219,84 @@ static void _usb_frame_recv_callback(void* arg, uint8_t status, uint32_t transfe
 	struct _audio_desc* desc = (struct _audio_desc*)arg;
 
 	if (status == USBD_STATUS_SUCCESS) {
-		if (_audio_ctx.circ.count >= (BUFFERS - 1)) {
-			_audio_ctx.circ.tx = (_audio_ctx.circ.tx + 1) % BUFFERS;
-			_audio_ctx.circ.count--;
-		}
-
-		_audio_ctx.samples[_audio_ctx.circ.rx] = transferred;
-		_audio_ctx.circ.rx = (_audio_ctx.circ.rx + 1) % BUFFERS;
-		_audio_ctx.circ.count++;
+		/* Data that does not fit in the stream ring is dropped */
+		audio_stream_write(desc, _packet, transferred);
 
-		if (_audio_ctx.circ.count >= _audio_ctx.threshold) {
-			if (!_audio_ctx.playing) {
-				audio_enable(desc, true);
+		/* Start DAC transmission once the target latency is reached */
+		if (!_audio_ctx.playing &&
+		    audio_stream_get_level(desc) >= TARGET_LEVEL) {
+			if (audio_stream_start(desc) == 0)
 				_audio_ctx.playing = true;
-			}
-			if (audio_transfer_is_done(&audio_device)) {
-				struct _callback _cb;
-
-				/* Start DAC transmission if necessary */
-				callback_set(&_cb, _audio_transfer_callback, desc);
-				audio_transfer(desc,
-					       _buffer[_audio_ctx.circ.tx],
-					       _audio_ctx.samples[_audio_ctx.circ.tx],
-					       &_cb);
-				_audio_ctx.circ.tx = (_audio_ctx.circ.tx + 1) % BUFFERS;
-				_audio_ctx.circ.count--;
-			}
+			else
+				trace_error("Cannot start audio stream\r\n");
 		}
-	} else if (status == USBD_STATUS_ABORTED) {
-		/* Error , ABORT, add NULL buffer */
-		_audio_ctx.samples[_audio_ctx.circ.rx] = 0;
 	} else {
-		/* Packet is discarded */
+		/* Packet is discarded, silence is played if needed */
 	}
 
 	/* Receive next packet */
-	audd_speaker_driver_read(_buffer[_audio_ctx.circ.rx],
-				 AUDDSpeakerDriver_BYTESPERFRAME,
+	audd_speaker_driver_read(_packet, AUDDSpeakerDriver_MAXBYTESPERFRAME,
 				 _usb_frame_recv_callback, desc);
 }
 
+static void _usb_feedback_callback(void* arg, uint8_t status, uint32_t transferred, uint32_t remaining);
+
+/**
+ *  Update the feedback from the DAC position and the buffered audio, and
+ *  send it to the host.
+ */
+static void _send_feedback(struct _audio_desc* desc)
+{
+	uint32_t position = 0, length;
+
+	if (_audio_ctx.playing)
+		position = audio_stream_get_position(desc);
+	audd_feedback_update(&_feedback, usbd_get_frame_number(), position,
+			audio_stream_get_delay(desc));
+
+	length = audd_feedback_encode(&_feedback, _feedback_packet);
+	audd_speaker_driver_write_feedback(_feedback_packet, length,
+			_usb_feedback_callback, desc);
+}
+
+/**
+ *  Invoked when the host has read the feedback.
+ */
+static void _usb_feedback_callback(void* arg, uint8_t status, uint32_t transferred, uint32_t remaining)
+{
+	/* Canceled when the streaming interface is closed */
+	if (status != USBD_STATUS_SUCCESS)
+		return;
+
+	_send_feedback((struct _audio_desc*)arg);
+}
+
+/**
+ *  Display the statistics of the stream and of the feedback.
+ */
+static void _print_stats(void)
+{
+	struct _audio_stream_stats stream;
+	AUDDFeedbackStats fb;
+
+	audio_stream_get_stats(&audio_device, &stream, true);
+	audd_feedback_get_stats(&_feedback, &fb, true);
+
+	printf("Stream: %u periods, %u xruns, %u lost, latency %u..%u us\r\n",
+	       (unsigned)stream.periods, (unsigned)stream.xruns,
+	       (unsigned)stream.lost, (unsigned)stream.min_latency,
+	       (unsigned)stream.max_latency);
+	printf("Feedback: rate %u.%04u samples/ms, value %u.%04u..%u.%04u, "
+	       "level error %d..%d samples\r\n",
+	       (unsigned)(fb.rate >> 16),
+	       (unsigned)(((fb.rate & 0xFFFF) * 10000) >> 16),
+	       (unsigned)(fb.min_value >> 16),
+	       (unsigned)(((fb.min_value & 0xFFFF) * 10000) >> 16),
+	       (unsigned)(fb.max_value >> 16),
+	       (unsigned)(((fb.max_value & 0xFFFF) * 10000) >> 16),
+	       (int)fb.min_error, (int)fb.max_error);
+}
+
 static void console_handler(uint8_t key)
 {
 	switch (key) {
@@ -316,6 +331,11 @@ static void console_handler(uint8_t key)
 		audio_mute(&audio_device, true);
 		break;
 
+	case 's':
+	case 'S':
+		_print_stats();
+		break;
+
 	default:
 		break;
 	}
@@ -424,10 +444,19 @@ void audd_speaker_driver_mute_changed(uint8_t channel, uint8_t muted)
 void audd_speaker_driver_stream_setting_changed(uint8_t new_setting)
 {
 	if (new_setting) {
-		audio_stop(&audio_device);
-		_audio_ctx.circ.count = 0;
-		_audio_ctx.circ.tx = 0;
-		_audio_ctx.circ.rx = 0;
+		/* Restart with an empty stream */
+		if (_audio_ctx.playing)
+			audio_stream_stop(&audio_device);
+		_audio_ctx.playing = false;
+		audio_stream_configure(&audio_device, _ring, PERIOD_SIZE,
+				PERIODS, NULL);
+
+		/* Report the rate of the DAC */
+		audd_feedback_initialize(&_feedback,
+				AUDDSpeakerDriver_SAMPLERATE,
+				AUDDSpeakerDriver_BYTESPERSUBFRAME,
+				TARGET_LEVEL * PERIOD_SIZE, usbd_is_high_speed());
+		_send_feedback(&audio_device);
 	}
 }
 
@@ -444,9 +473,6 @@ int main(void)
 {
 	bool usb_conn = false;
 
-	int32_t jitter = 0, _jitter_curr;
-	int8_t clock_adjust = 0;
-
 	console_set_rx_handler(console_handler);
 	console_enable_rx_interrupt();
 
@@ -462,6 +488,11 @@ int main(void)
 	/* Configure audio play volume */
 	audio_set_volume(&audio_device, _audio_ctx.volume);
 
+	/* Configure the audio stream */
+	if (audio_stream_configure(&audio_device, _ring, PERIOD_SIZE,
+				PERIODS, NULL))
+		trace_fatal("Cannot configure the audio stream\r\n");
+
 #ifdef PINS_PUSHBUTTONS
 	configure_buttons();
 #endif
@@ -476,6 +507,7 @@ int main(void)
 	printf("Input '+' or '-' to increase or decrease volume\n\r");
 	printf("Input '0' or '1' to set volume to min / max\n\r");
 	printf("Input 'm' or 'u' to mute or unmute sound\n\r");
+	printf("Input 's' to display the stream statistics\n\r");
 	printf("=========================================================\n\r");
 
 	/* Infinite loop */
@@ -485,27 +517,11 @@ int main(void)
 			continue;
 		}
 
-		_jitter_curr = (_audio_ctx.circ.count - _audio_ctx.threshold);
-
-		if (jitter != _jitter_curr) {
-			jitter = _jitter_curr;
-			if (jitter > 0 && clock_adjust != 1) {
-				/* USB too fast or SSC too slow: faster clock */
-				clock_adjust = 1;
-				audio_sync_adjust(&audio_device, clock_adjust);
-			}
-			if (jitter < 0 && clock_adjust != -1) {
-				/* USB too slow or SSC too fast: slower clock */
-				clock_adjust = -1;
-				audio_sync_adjust(&audio_device, clock_adjust);
-			}
-		}
-
 		if (!usb_conn) {
 			trace_info("USB connected\r\n");
 			/* Start Reading the incoming audio stream */
-			audd_speaker_driver_read(_buffer[_audio_ctx.circ.rx],
-					AUDDSpeakerDriver_BYTESPERFRAME,
+			audd_speaker_driver_read(_packet,
+					AUDDSpeakerDriver_MAXBYTESPERFRAME,
 					_usb_frame_recv_callback, &audio_device);
 
 			usb_conn = true;
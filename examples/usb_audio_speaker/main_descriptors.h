@@ -75,6 +75,10 @@
 /** Number of bytes in one USB frame. */
 #define AUDDSpeakerDriver_BYTESPERFRAME     (AUDDSpeakerDriver_SAMPLESPERFRAME * \
 		AUDDSpeakerDriver_BYTESPERSAMPLE)
+/** Maximum number of bytes in one USB frame: the host sends one more sample
+ *  when the feedback is above the nominal rate. */
+#define AUDDSpeakerDriver_MAXBYTESPERFRAME  (AUDDSpeakerDriver_BYTESPERFRAME + \
+		AUDDSpeakerDriver_BYTESPERSUBFRAME)
 /**     @}*/
 
 /** \addtogroup usbd_audio_id USB Device Audio Speaker Codes
@@ -97,8 +101,11 @@
  *      @{
  * This page lists the definitions for USB Audio Speaker Device Driver.
  * - \ref AUDDSpeakerDriverDescriptors_DATAOUT
+ * - \ref AUDDSpeakerDriverDescriptors_FEEDBACK
  * - \ref AUDDSpeakerDriverDescriptors_FS_INTERVAL
  * - \ref AUDDSpeakerDriverDescriptors_HS_INTERVAL
+ * - \ref AUDDSpeakerDriverDescriptors_FS_REFRESH
+ * - \ref AUDDSpeakerDriverDescriptors_HS_FB_INTERVAL
  *
  * \note for UDP, uses IN EPs that support double buffer; for UDPHS, uses
  *       IN EPs that support DMA and High bandwidth.
@@ -109,6 +116,12 @@
 #define AUDDSpeakerDriverDescriptors_HS_INTERVAL        0x04
 /** Endpoint polling interval 2^(x-1) * ms */
 #define AUDDSpeakerDriverDescriptors_FS_INTERVAL        0x01
+/** Feedback endpoint number. */
+#define AUDDSpeakerDriverDescriptors_FEEDBACK           0x03
+/** Full-speed feedback refresh period 2^x ms (32 ms) */
+#define AUDDSpeakerDriverDescriptors_FS_REFRESH         0x05
+/** High-speed feedback polling interval 2^(x-1) * 125us (8 ms) */
+#define AUDDSpeakerDriverDescriptors_HS_FB_INTERVAL     0x07
 /**     @}*/
 
 /**@}*/
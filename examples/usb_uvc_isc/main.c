@@ -138,7 +138,7 @@
  *        Local definitions
  *----------------------------------------------------------------------------*/
 
-#define NUM_FRAME_BUFFER     4
+#define NUM_FRAME_BUFFER     5
 
 #define SENSOR_TWI_BUS BOARD_ISC_TWI_BUS
 
@@ -168,6 +168,11 @@ static struct sensor_profile *sensor;
 
 static struct _iscd_desc iscd;
 
+/** Captured frames, the UVC function streams the latest one */
+static struct _frame_queue frame_queue = {
+	.policy = FRAME_QUEUE_DROP_OLDEST,
+};
+
 /** Video buffers */
 CACHE_ALIGNED_DDR
 static uint8_t stream_buffers[FRAME_BUFFER_SIZEC(640, 480) * NUM_FRAME_BUFFER];
@@ -176,11 +181,6 @@ static uint8_t stream_buffers[FRAME_BUFFER_SIZEC(640, 480) * NUM_FRAME_BUFFER];
  *        Local functions
  *----------------------------------------------------------------------------*/
 
-static void isc_vd_callback(uint8_t frame_idx)
-{
-	uvc_function_update_frame_idx(frame_idx);
-}
-
 /**
  * \brief ISC initialization.
  */
@@ -201,7 +201,8 @@ static void configure_isc(void)
 	iscd.cfg.layout = ISCD_LAYOUT_PACKED8;
 	iscd.dma.address0 = (uint32_t)stream_buffers;
 	iscd.dma.size = FRAME_BUFFER_SIZEC(image_width, image_height);
-	iscd.dma.callback = isc_vd_callback;
+	iscd.dma.callback = NULL;
+	iscd.dma.queue = &frame_queue;
 	iscd_pipe_start(&iscd);
 }
 
@@ -310,7 +311,9 @@ extern int main( void )
 				}
 				memset(stream_buffers, 0, sizeof(stream_buffers));
 				cache_clean_region(stream_buffers, sizeof(stream_buffers));
+				uvc_function_set_frame_queue(NULL);
 				start_preview();
+				uvc_function_set_frame_queue(&frame_queue);
 				uvc_function_payload_sent(NULL, USBD_STATUS_SUCCESS, 0, 0);
 				printf("vidS\r\n");
 			}
@@ -127,7 +127,7 @@
  *        Local definitions
  *----------------------------------------------------------------------------*/
 
-#define NUM_FRAME_BUFFER     4
+#define NUM_FRAME_BUFFER     5
 
 #define SENSOR_TWI_BUS BOARD_ISI_TWI_BUS
 
@@ -158,6 +158,11 @@ static struct sensor_profile *sensor;
 
 static struct _isid_desc isid;
 
+/** Captured frames, the UVC function streams the latest one */
+static struct _frame_queue frame_queue = {
+	.policy = FRAME_QUEUE_DROP_OLDEST,
+};
+
 /** Video buffers */
 CACHE_ALIGNED_DDR
 static uint8_t stream_buffers[FRAME_BUFFER_SIZEC(640, 480) * NUM_FRAME_BUFFER];
@@ -166,11 +171,6 @@ static uint8_t stream_buffers[FRAME_BUFFER_SIZEC(640, 480) * NUM_FRAME_BUFFER];
  *        Local functions
  *----------------------------------------------------------------------------*/
 
-static void isi_vd_callback (uint8_t index)
-{
-	uvc_function_update_frame_idx(index);
-}
-
 /**
  * \brief ISI initialization.
  */
@@ -191,7 +191,8 @@ static void configure_isi(void)
 	isid.pipe.rgb2yuv_matrix = NULL;
 	isid.dma.address_p = (uint32_t)stream_buffers;
 	isid.dma.size_p = FRAME_BUFFER_SIZEC(image_width, image_height);
-	isid.dma.callback = isi_vd_callback;
+	isid.dma.callback = NULL;
+	isid.dma.queue = &frame_queue;
 
 	isid_pipe_start(&isid);
 }
@@ -300,7 +301,9 @@ extern int main( void )
 				/* clear video buffer */
 				memset(stream_buffers, 0, sizeof(stream_buffers));
 				cache_clean_region(stream_buffers, sizeof(stream_buffers));
+				uvc_function_set_frame_queue(NULL);
 				start_preview();
+				uvc_function_set_frame_queue(&frame_queue);
 				uvc_function_payload_sent(NULL, USBD_STATUS_SUCCESS, 0, 0);
 				printf("vidS\r\n");
 			}
@@ -33,6 +33,7 @@
  *         Headers
  *---------------------------------------------------------------------------*/
 
+#include "fastmem.h"
 #include "media.h"
 #include "media_ramdisk.h"
 #include "media_private.h"
@@ -73,7 +74,7 @@ static uint8_t media_ramdisk_read(struct _media *media,
 
 	// Copy data
 	source = (uint8_t*)((media->base_address + address) * media->block_size);
-	memcpy(data, source, length);
+	fast_memcpy(data, source, length);
 
 	// Leave the Busy state
 	media->state = MEDIA_STATE_READY;
@@ -115,7 +116,7 @@ static uint8_t media_ramdisk_write(struct _media *media,
 
 	// Copy data
 	dest = (uint8_t*)((media->base_address + address) * media->block_size);
-	memcpy(dest, data, length);
+	fast_memcpy(dest, data, length);
 
 	// Leave the Busy state
 	media->state = MEDIA_STATE_READY;
@@ -32,6 +32,8 @@
 
 #include <stdio.h>
 
+#include "inet_cksum.h"
+
 /* Define platform endianness */
 #ifndef BYTE_ORDER
 #define BYTE_ORDER LITTLE_ENDIAN
@@ -68,6 +70,11 @@
     #error "This compiler does not support."
 #endif
 
+/* Word-wide Internet checksum, with a copy variant used when
+ * LWIP_CHECKSUM_ON_COPY is enabled */
+#define LWIP_CHKSUM(dataptr, len)        inet_cksum_add(0, dataptr, len)
+#define LWIP_CHKSUM_COPY(dst, src, len)  inet_cksum_copy(dst, src, len)
+
 /* No assert */
 #define LWIP_NOASSERT
 
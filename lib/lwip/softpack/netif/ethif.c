@@ -70,6 +70,11 @@
 #define IFNAME0 'e'
 #define IFNAME1 'n'
 
+/* Checksums generated by the MAC when the checksum offload is enabled, ICMP
+ * is not handled by the hardware */
+#define ETHIF_CHECKSUM_GEN_HW \
+	(NETIF_CHECKSUM_GEN_IP | NETIF_CHECKSUM_GEN_UDP | NETIF_CHECKSUM_GEN_TCP)
+
 /*----------------------------------------------------------------------------
  *        Types
  *----------------------------------------------------------------------------*/
@@ -155,7 +160,47 @@ static void glow_level_init(struct netif *netif, struct _ethd* ethd)
 	netif->mtu = 1500;
 	/* device capabilities */
 	netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP | NETIF_FLAG_ETHERNET| NETIF_FLAG_LINK_UP;
+#if LWIP_CHECKSUM_CTRL_PER_NETIF
+	/* use the checksum engines of the MAC if any (GMAC), keep the
+	 * software checksums otherwise (EMAC) */
+	if (ethd_set_checksum_offload(ethd, true))
+		NETIF_SET_CHECKSUM_CTRL(netif,
+				NETIF_CHECKSUM_ENABLE_ALL & ~ETHIF_CHECKSUM_GEN_HW);
+#endif
+}
+
+#if LWIP_CHECKSUM_CTRL_PER_NETIF
+/**
+ * Skip the software verification of the checksums already checked by the
+ * MAC for the frame about to be passed to the stack. Frames with a bad
+ * checksum have been dropped by the MAC.
+ *
+ * @param netif the lwip network interface structure for this ethif
+ */
+static void glow_level_rx_checksum(struct netif *netif)
+{
+	struct _ethd* ethd = board_get_eth(netif->num);
+	u16_t flags = NETIF_CHECKSUM_ENABLE_ALL;
+
+	if (!ethd_get_checksum_offload(ethd))
+		return;
+
+	switch (ethd_get_rx_checksum(ethd, 0)) {
+	case ETH_RX_STATUS_CSUM_IP:
+		flags &= ~NETIF_CHECKSUM_CHECK_IP;
+		break;
+	case ETH_RX_STATUS_CSUM_TCP:
+		flags &= ~(NETIF_CHECKSUM_CHECK_IP | NETIF_CHECKSUM_CHECK_TCP);
+		break;
+	case ETH_RX_STATUS_CSUM_UDP:
+		flags &= ~(NETIF_CHECKSUM_CHECK_IP | NETIF_CHECKSUM_CHECK_UDP);
+		break;
+	default:
+		break;
+	}
+	NETIF_SET_CHECKSUM_CTRL(netif, flags & ~ETHIF_CHECKSUM_GEN_HW);
 }
+#endif
 
 /**
  * This function should do the actual transmission of the packet. The packet is
@@ -303,6 +348,11 @@ static void ethif_input(struct netif *netif)
         case ETHTYPE_IP:
             /* skip Ethernet header */
             pbuf_header(p, -(s16_t)sizeof(struct eth_hdr));
+#if LWIP_CHECKSUM_CTRL_PER_NETIF
+            /* the frame is processed synchronously (NO_SYS) so the
+             * flags apply to this frame only */
+            glow_level_rx_checksum(netif);
+#endif
             /* pass to network layer */
             netif->input(p, netif);
             break;
@@ -0,0 +1,114 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file
+ *
+ * uIP checksum functions (UIP_ARCH_CHKSUM) based on the word-wide Internet
+ * checksum of inet_cksum.h.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "inet_cksum.h"
+
+#include "uip.h"
+#include "uip_arch.h"
+
+#if UIP_ARCH_CHKSUM
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+#define BUF ((struct uip_tcpip_hdr *)&uip_buf[UIP_LLH_LEN])
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static u16_t upper_layer_chksum(u8_t proto)
+{
+	u16_t upper_layer_len;
+	u16_t sum;
+
+#if UIP_CONF_IPV6
+	upper_layer_len = (((u16_t)(BUF->len[0]) << 8) + BUF->len[1]);
+#else
+	upper_layer_len = (((u16_t)(BUF->len[0]) << 8) + BUF->len[1]) - UIP_IPH_LEN;
+#endif
+
+	/* Pseudo header: protocol and length (cannot carry), source and
+	 * destination addresses. The sums are kept in network byte order. */
+	sum = HTONS(upper_layer_len + proto);
+	sum = inet_cksum_add(sum, &BUF->srcipaddr[0], 2 * sizeof(uip_ipaddr_t));
+
+	/* Upper layer header and data */
+	sum = inet_cksum_add(sum, &uip_buf[UIP_IPH_LEN + UIP_LLH_LEN],
+			upper_layer_len);
+
+	return (sum == 0) ? 0xffff : sum;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+u16_t uip_chksum(u16_t *data, u16_t len)
+{
+	return inet_cksum_add(0, data, len);
+}
+
+u16_t uip_ipchksum(void)
+{
+	u16_t sum = inet_cksum_add(0, &uip_buf[UIP_LLH_LEN], UIP_IPH_LEN);
+	return (sum == 0) ? 0xffff : sum;
+}
+
+#if UIP_CONF_IPV6
+u16_t uip_icmp6chksum(void)
+{
+	return upper_layer_chksum(UIP_PROTO_ICMP6);
+}
+#endif
+
+u16_t uip_tcpchksum(void)
+{
+	return upper_layer_chksum(UIP_PROTO_TCP);
+}
+
+#if UIP_UDP_CHECKSUMS
+u16_t uip_udpchksum(void)
+{
+	return upper_layer_chksum(UIP_PROTO_UDP);
+}
+#endif
+
+#endif /* UIP_ARCH_CHKSUM */
@@ -46,12 +46,38 @@
  *        Exported functions
  *----------------------------------------------------------------------------*/
 
+void eth_tapdev_init(u8_t iface)
+{
+#if UIP_CHECKSUM_OFFLOAD
+	uip_csum_flags = 0;
+	if (ethd_set_checksum_offload(board_get_eth(iface), true))
+		uip_csum_flags = UIP_CSUM_TX;
+#endif
+}
+
 uint32_t eth_tapdev_read(u8_t iface)
 {
+	struct _ethd* ethd = board_get_eth(iface);
 	uint32_t pkt_len = 0;
-	uint8_t rc = ethd_poll(board_get_eth(iface), 0, (uint8_t*)uip_buf, UIP_CONF_BUFFER_SIZE, &pkt_len);
+	uint8_t rc = ethd_poll(ethd, 0, (uint8_t*)uip_buf, UIP_CONF_BUFFER_SIZE, &pkt_len);
 	if (rc != ETH_OK)
 		return 0;
+#if UIP_CHECKSUM_OFFLOAD
+	uip_csum_flags &= ~UIP_CSUM_RX_MASK;
+	switch (ethd_get_rx_checksum(ethd, 0)) {
+	case ETH_RX_STATUS_CSUM_IP:
+		uip_csum_flags |= UIP_CSUM_RX_IP;
+		break;
+	case ETH_RX_STATUS_CSUM_TCP:
+		uip_csum_flags |= UIP_CSUM_RX_IP | UIP_CSUM_RX_TCP;
+		break;
+	case ETH_RX_STATUS_CSUM_UDP:
+		uip_csum_flags |= UIP_CSUM_RX_IP | UIP_CSUM_RX_UDP;
+		break;
+	default:
+		break;
+	}
+#endif
 	return pkt_len;
 }
 
@@ -32,6 +32,13 @@
 
 #include "uip-conf.h"
 
+/**
+ * Initialize the ETH device for uIP, enable the checksum offload when
+ * supported by the device.
+ * \param iface Interface index
+ */
+void eth_tapdev_init(u8_t iface);
+
 /**
  * Read from ETH device.
  * \param iface Interface index
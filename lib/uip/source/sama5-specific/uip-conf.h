@@ -132,6 +132,20 @@ typedef unsigned short uip_stats_t;
  */
 #define UIP_CONF_UDP_CHECKSUMS   0
 
+/**
+ * Checksum offload on or off (used on GMAC, ignored on EMAC)
+ *
+ * \hideinitializer
+ */
+#define UIP_CONF_CHECKSUM_OFFLOAD 1
+
+/**
+ * Use the word-wide checksum functions of chksum-arch.c
+ *
+ * \hideinitializer
+ */
+#define UIP_ARCH_CHKSUM          1
+
 /**
  * uIP statistics on or off
  *
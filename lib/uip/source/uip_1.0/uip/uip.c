@@ -157,6 +157,14 @@ u16_t uip_len, uip_slen;
 				depending on the maximum packet
 				size. */
 
+#if UIP_CHECKSUM_OFFLOAD
+u8_t uip_csum_flags; /* Checksums computed or verified by the
+			network device. */
+#define UIP_CSUM_DONE(flag) (uip_csum_flags & (flag))
+#else /* UIP_CHECKSUM_OFFLOAD */
+#define UIP_CSUM_DONE(flag) 0
+#endif /* UIP_CHECKSUM_OFFLOAD */
+
 u8_t uip_flags;     /* The uip_flags variable is used for
 				communication between the TCP/IP stack
 				and the application program. */
@@ -937,7 +945,8 @@ uip_process(u8_t flag)
   }
 
 #if !UIP_CONF_IPV6
-  if(uip_ipchksum() != 0xffff) { /* Compute and check the IP header
+  if(!UIP_CSUM_DONE(UIP_CSUM_RX_IP) &&
+     uip_ipchksum() != 0xffff) { /* Compute and check the IP header
 				    checksum. */
     UIP_STAT(++uip_stat.ip.drop);
     UIP_STAT(++uip_stat.ip.chkerr);
@@ -1088,7 +1097,8 @@ uip_process(u8_t flag)
 #if UIP_UDP_CHECKSUMS
   uip_len = uip_len - UIP_IPUDPH_LEN;
   uip_appdata = &uip_buf[UIP_LLH_LEN + UIP_IPUDPH_LEN];
-  if(UDPBUF->udpchksum != 0 && uip_udpchksum() != 0xffff) {
+  if(UDPBUF->udpchksum != 0 && !UIP_CSUM_DONE(UIP_CSUM_RX_UDP) &&
+     uip_udpchksum() != 0xffff) {
     UIP_STAT(++uip_stat.udp.drop);
     UIP_STAT(++uip_stat.udp.chkerr);
     UIP_LOG("udp: bad checksum.");
@@ -1159,10 +1169,12 @@ uip_process(u8_t flag)
   uip_appdata = &uip_buf[UIP_LLH_LEN + UIP_IPTCPH_LEN];
 
 #if UIP_UDP_CHECKSUMS
-  /* Calculate UDP checksum. */
-  UDPBUF->udpchksum = ~(uip_udpchksum());
-  if(UDPBUF->udpchksum == 0) {
-    UDPBUF->udpchksum = 0xffff;
+  /* Calculate UDP checksum, unless the device does it. */
+  if(!UIP_CSUM_DONE(UIP_CSUM_TX)) {
+    UDPBUF->udpchksum = ~(uip_udpchksum());
+    if(UDPBUF->udpchksum == 0) {
+      UDPBUF->udpchksum = 0xffff;
+    }
   }
 #endif /* UIP_UDP_CHECKSUMS */
 
@@ -1175,7 +1187,8 @@ uip_process(u8_t flag)
 
   /* Start of TCP input header processing code. */
 
-  if(uip_tcpchksum() != 0xffff) {   /* Compute and check the TCP
+  if(!UIP_CSUM_DONE(UIP_CSUM_RX_TCP) &&
+     uip_tcpchksum() != 0xffff) {   /* Compute and check the TCP
 				       checksum. */
     UIP_STAT(++uip_stat.tcp.drop);
     UIP_STAT(++uip_stat.tcp.chkerr);
@@ -1840,9 +1853,11 @@ uip_process(u8_t flag)
 
   BUF->urgp[0] = BUF->urgp[1] = 0;
 
-  /* Calculate TCP checksum. */
+  /* Calculate TCP checksum, unless the device does it. */
   BUF->tcpchksum = 0;
-  BUF->tcpchksum = ~(uip_tcpchksum());
+  if(!UIP_CSUM_DONE(UIP_CSUM_TX)) {
+    BUF->tcpchksum = ~(uip_tcpchksum());
+  }
 
  ip_send_nolen:
 
@@ -1857,9 +1872,11 @@ uip_process(u8_t flag)
   ++ipid;
   BUF->ipid[0] = ipid >> 8;
   BUF->ipid[1] = ipid & 0xff;
-  /* Calculate IP checksum. */
+  /* Calculate IP checksum, unless the device does it. */
   BUF->ipchksum = 0;
-  BUF->ipchksum = ~(uip_ipchksum());
+  if(!UIP_CSUM_DONE(UIP_CSUM_TX)) {
+    BUF->ipchksum = ~(uip_ipchksum());
+  }
   DEBUG_PRINTF("uip ip_send_nolen: chkecum 0x%04x\n", uip_ipchksum());
 #endif /* UIP_CONF_IPV6 */
 
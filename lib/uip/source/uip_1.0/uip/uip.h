@@ -421,6 +421,26 @@ void uip_setipid(u16_t id);
  */
 extern u8_t uip_buf[UIP_BUFSIZE+2];
 
+#if UIP_CHECKSUM_OFFLOAD
+/**
+ * The checksum offload flags.
+ *
+ * Set by the device driver when checksum offload is enabled
+ * (UIP_CHECKSUM_OFFLOAD): UIP_CSUM_TX tells that the device generates
+ * the IP, TCP and UDP checksums of the outgoing packets, and the
+ * UIP_CSUM_RX_xxx flags tell which checksums of the packet placed in
+ * uip_buf have been verified by the device. The RX flags must be
+ * updated for each incoming packet.
+ */
+extern u8_t uip_csum_flags;
+
+#define UIP_CSUM_TX      0x01 /* IP, TCP and UDP checksums generated */
+#define UIP_CSUM_RX_IP   0x02 /* IP header checksum verified */
+#define UIP_CSUM_RX_TCP  0x04 /* TCP checksum verified */
+#define UIP_CSUM_RX_UDP  0x08 /* UDP checksum verified */
+#define UIP_CSUM_RX_MASK 0x0e
+#endif /* UIP_CHECKSUM_OFFLOAD */
+
 /** @} */
 
 /*---------------------------------------------------------------------------*/
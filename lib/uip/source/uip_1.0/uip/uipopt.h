@@ -195,6 +195,23 @@
 #define UIP_UDP_CHECKSUMS 0
 #endif
 
+/**
+ * Toggles support for network devices computing and verifying the
+ * IP, TCP and UDP checksums.
+ *
+ * When enabled, the device driver reports through uip_csum_flags
+ * which checksums the hardware generates on transmission and which
+ * checksums it has verified for the packet in uip_buf, and uIP skips
+ * the corresponding software checksums.
+ *
+ * \hideinitializer
+ */
+#ifdef UIP_CONF_CHECKSUM_OFFLOAD
+#define UIP_CHECKSUM_OFFLOAD UIP_CONF_CHECKSUM_OFFLOAD
+#else
+#define UIP_CHECKSUM_OFFLOAD 0
+#endif
+
 /**
  * The maximum amount of concurrent UDP connections.
  *
@@ -0,0 +1,208 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file
+ * \addtogroup usbd_audio_feedback
+ *@{
+ */
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "irqflags.h"
+
+#include "usb/device/audio/audd_feedback.h"
+
+/*------------------------------------------------------------------------------
+ *         Local definitions
+ *------------------------------------------------------------------------------*/
+
+/** The frame number counts 125us units on 14 bits */
+#define FRAME_MASK 0x3FFF
+
+/** Measurements are averaged on 2^N windows */
+#define RATE_FILTER_SHIFT 3
+
+/*------------------------------------------------------------------------------
+ *         Internal functions
+ *------------------------------------------------------------------------------*/
+
+static void _feedback_reset_stats(AUDDFeedback *fb)
+{
+	memset(&fb->stats, 0, sizeof(fb->stats));
+	fb->stats.rate = fb->rate;
+	fb->stats.value = fb->value;
+	fb->stats.min_value = UINT32_MAX;
+	fb->stats.min_error = INT32_MAX;
+	fb->stats.max_error = INT32_MIN;
+}
+
+/*------------------------------------------------------------------------------
+ *         Exported functions
+ *------------------------------------------------------------------------------*/
+
+/**
+ * Initialize the feedback of a stream, reporting the nominal rate until the
+ * first measurement.
+ * \param fb          Pointer to AUDDFeedback instance.
+ * \param sample_rate Nominal sample rate in Hz.
+ * \param frame_size  Size of one sample of all channels, in bytes.
+ * \param target      Fill level of the device buffer to keep, in bytes.
+ * \param high_speed  true if the USB device runs in high-speed.
+ */
+void audd_feedback_initialize(AUDDFeedback *fb, uint32_t sample_rate,
+		uint16_t frame_size, uint32_t target, bool high_speed)
+{
+	fb->nominal = (uint32_t)(((uint64_t)sample_rate << 16) / 1000);
+	fb->rate = fb->nominal;
+	fb->value = fb->nominal;
+	fb->frame_size = frame_size;
+	fb->frame = 0;
+	fb->position = 0;
+	fb->target = target;
+	fb->high_speed = high_speed;
+	fb->started = false;
+	_feedback_reset_stats(fb);
+}
+
+/**
+ * Update the feedback value. The rate is measured when at least
+ * CONFIG_AUDD_FEEDBACK_WINDOW ms elapsed since the previous measurement; the
+ * fill level correction is applied on each call.
+ * \param fb       Pointer to AUDDFeedback instance.
+ * \param frame    Current USB (micro)frame number, see usbd_get_frame_number().
+ * \param position Bytes consumed by the audio device since it started.
+ * \param fill     Bytes received from the host not yet consumed.
+ */
+void audd_feedback_update(AUDDFeedback *fb, uint16_t frame,
+		uint32_t position, uint32_t fill)
+{
+	uint32_t elapsed, samples, rate, limit;
+	int32_t error;
+	int64_t value;
+
+	if (!fb->started) {
+		fb->frame = frame;
+		fb->position = position;
+		fb->started = true;
+	}
+
+	elapsed = (uint16_t)(frame - fb->frame) & FRAME_MASK;
+	if (elapsed >= CONFIG_AUDD_FEEDBACK_WINDOW * 8) {
+		samples = (position - fb->position) / fb->frame_size;
+		rate = (uint32_t)(((uint64_t)samples << 19) / elapsed);
+
+		/* Ignore measurements across a stall of the device, or longer
+		 * than the frame number period */
+		limit = fb->nominal >> 3;
+		if (rate > fb->nominal - limit && rate < fb->nominal + limit) {
+			fb->rate += ((int32_t)(rate - fb->rate)) >> RATE_FILTER_SHIFT;
+			fb->stats.rate = fb->rate;
+			fb->stats.updates++;
+			/* Keep the remainder of the partial audio frame */
+			fb->position += samples * fb->frame_size;
+		} else {
+			fb->position = position;
+		}
+		fb->frame = frame;
+	}
+
+	/* Steer the fill level to its target */
+	error = ((int32_t)fb->target - (int32_t)fill) / (int32_t)fb->frame_size;
+	value = (int64_t)fb->rate +
+		(((int64_t)error << 16) >> CONFIG_AUDD_FEEDBACK_LEVEL_SHIFT);
+
+	/* Never request more than 1/64 away from the nominal rate */
+	limit = fb->nominal >> 6;
+	if (value < (int64_t)(fb->nominal - limit))
+		value = fb->nominal - limit;
+	if (value > (int64_t)(fb->nominal + limit))
+		value = fb->nominal + limit;
+	fb->value = (uint32_t)value;
+
+	fb->stats.value = fb->value;
+	if (fb->value < fb->stats.min_value)
+		fb->stats.min_value = fb->value;
+	if (fb->value > fb->stats.max_value)
+		fb->stats.max_value = fb->value;
+	if (error < fb->stats.min_error)
+		fb->stats.min_error = error;
+	if (error > fb->stats.max_error)
+		fb->stats.max_error = error;
+}
+
+/**
+ * Encode the feedback value for the feedback endpoint: 10.14 samples per
+ * frame in full-speed, 16.16 samples per microframe in high-speed.
+ * \param fb     Pointer to AUDDFeedback instance.
+ * \param buffer Buffer of at least AUDD_FEEDBACK_HS_SIZE bytes.
+ * \return the size of the feedback packet in bytes.
+ */
+uint32_t audd_feedback_encode(AUDDFeedback *fb, uint8_t *buffer)
+{
+	uint32_t value;
+
+	if (fb->high_speed) {
+		value = fb->value >> 3;
+		buffer[0] = value & 0xFF;
+		buffer[1] = (value >> 8) & 0xFF;
+		buffer[2] = (value >> 16) & 0xFF;
+		buffer[3] = (value >> 24) & 0xFF;
+		return AUDD_FEEDBACK_HS_SIZE;
+	} else {
+		value = fb->value >> 2;
+		buffer[0] = value & 0xFF;
+		buffer[1] = (value >> 8) & 0xFF;
+		buffer[2] = (value >> 16) & 0xFF;
+		return AUDD_FEEDBACK_FS_SIZE;
+	}
+}
+
+/**
+ * Get the statistics of the feedback.
+ * \param fb    Pointer to AUDDFeedback instance.
+ * \param stats Filled with the statistics.
+ * \param reset true to restart the min/max statistics.
+ */
+void audd_feedback_get_stats(AUDDFeedback *fb, AUDDFeedbackStats *stats,
+		bool reset)
+{
+	uint32_t flags;
+
+	flags = arch_irq_save();
+	*stats = fb->stats;
+	if (reset)
+		_feedback_reset_stats(fb);
+	arch_irq_restore(flags);
+}
+
+/**@}*/
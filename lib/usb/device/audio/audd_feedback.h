@@ -0,0 +1,153 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * \section Purpose
+ *
+ *   Explicit feedback for USB Audio asynchronous OUT streams. The rate of the
+ *   device audio clock is measured against the USB (micro)frames from the
+ *   position of the audio output, and corrected by the error between the fill
+ *   level of the device buffer and its target, so that the host sends exactly
+ *   the number of samples the device consumes.
+ *
+ * \section Usage
+ *
+ *   -# Initialize the feedback with audd_feedback_initialize() each time the
+ *      streaming interface is opened.
+ *   -# Each time a feedback packet has been sent, call audd_feedback_update()
+ *      with the audio position and fill level, then send the next packet
+ *      filled by audd_feedback_encode().
+ *   -# Monitor the feedback with audd_feedback_get_stats().
+ */
+
+#ifndef _AUDD_FEEDBACK_H_
+#define _AUDD_FEEDBACK_H_
+
+/** \addtogroup usbd_audio_feedback
+ *@{
+ */
+
+/*------------------------------------------------------------------------------
+ *         Headers
+ *------------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*------------------------------------------------------------------------------
+ *         Defines
+ *------------------------------------------------------------------------------*/
+
+/** Minimum duration of a rate measurement, in ms */
+#ifndef CONFIG_AUDD_FEEDBACK_WINDOW
+#define CONFIG_AUDD_FEEDBACK_WINDOW 64
+#endif
+
+/** Gain of the fill level control: each ms, the feedback requests
+ *  1/2^N of the fill level error in addition to the measured rate */
+#ifndef CONFIG_AUDD_FEEDBACK_LEVEL_SHIFT
+#define CONFIG_AUDD_FEEDBACK_LEVEL_SHIFT 10
+#endif
+
+/** Size of a full-speed feedback packet (10.14 samples per frame) */
+#define AUDD_FEEDBACK_FS_SIZE 3
+
+/** Size of a high-speed feedback packet (16.16 samples per microframe) */
+#define AUDD_FEEDBACK_HS_SIZE 4
+
+/*------------------------------------------------------------------------------
+ *         Types
+ *------------------------------------------------------------------------------*/
+
+/**
+ * Statistics of the feedback. Rates are in 16.16 samples per ms, fill level
+ * errors in samples (positive when the buffer is below its target).
+ */
+typedef struct _AUDDFeedbackStats {
+	/** Number of rate measurements */
+	uint32_t updates;
+	/** Measured rate of the audio device */
+	uint32_t rate;
+	/** Last feedback value */
+	uint32_t value;
+	/** Minimum feedback value */
+	uint32_t min_value;
+	/** Maximum feedback value */
+	uint32_t max_value;
+	/** Minimum fill level error */
+	int32_t min_error;
+	/** Maximum fill level error */
+	int32_t max_error;
+} AUDDFeedbackStats;
+
+/**
+ * Feedback state of an asynchronous OUT stream.
+ */
+typedef struct _AUDDFeedback {
+	/** Nominal rate, 16.16 samples per ms */
+	uint32_t nominal;
+	/** Measured (filtered) rate, 16.16 samples per ms */
+	uint32_t rate;
+	/** Feedback value, 16.16 samples per ms */
+	uint32_t value;
+	/** Size of an audio frame (one sample of each channel) in bytes */
+	uint16_t frame_size;
+	/** Frame number at the start of the measurement */
+	uint16_t frame;
+	/** Audio position at the start of the measurement, in bytes */
+	uint32_t position;
+	/** Target fill level of the device buffer, in bytes */
+	uint32_t target;
+	/** true if the USB device runs in high-speed */
+	bool high_speed;
+	/** true once a measurement is started */
+	bool started;
+	/** Statistics */
+	AUDDFeedbackStats stats;
+} AUDDFeedback;
+
+/*------------------------------------------------------------------------------
+ *         Functions
+ *------------------------------------------------------------------------------*/
+
+extern void audd_feedback_initialize(AUDDFeedback *fb, uint32_t sample_rate,
+		uint16_t frame_size, uint32_t target, bool high_speed);
+
+extern void audd_feedback_update(AUDDFeedback *fb, uint16_t frame,
+		uint32_t position, uint32_t fill);
+
+extern uint32_t audd_feedback_encode(AUDDFeedback *fb, uint8_t *buffer);
+
+extern void audd_feedback_get_stats(AUDDFeedback *fb,
+		AUDDFeedbackStats *stats, bool reset);
+
+/**@}*/
+#endif /* _AUDD_FEEDBACK_H_ */
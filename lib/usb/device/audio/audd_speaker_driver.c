@@ -42,6 +42,7 @@
 #include "usb/device/audio/audd_speaker_driver.h"
 #include "usb/device/audio/audd_speaker_phone.h"
 #include "usb/device/usbd_driver.h"
+#include "usb/device/usbd_hal.h"
 #include "usb/device/usbd.h"
 
 /*----------------------------------------------------------------------------
@@ -162,6 +163,11 @@ void audd_speaker_driver_interface_setting_changed_handler(uint8_t interface,
 
 	if (setting == 0) {
 		audd_speaker_phone_close_stream(p_audf, interface);
+		/* cancel the pending feedback */
+		if (p_audf->pSpeaker->bEndpointFeedback)
+			usbd_hal_reset_endpoints(
+				1 << p_audf->pSpeaker->bEndpointFeedback,
+				USBRC_CANCELED, 1);
 	}
 
 	if (NULL != (void*)audd_speaker_driver_stream_setting_changed)
@@ -220,4 +226,28 @@ uint8_t audd_speaker_driver_read(void *buffer, uint32_t length,
 			buffer, length, callback, argument);
 }
 
+/**
+ * Sends a feedback packet, giving the rate of the device to the USB host
+ * for an asynchronous stream. When the host has read it, an optional callback
+ * function is invoked, which usually sends the next packet.
+ * \param buffer Pointer to the feedback packet (see audd_feedback_encode).
+ * \param length Size of the packet in bytes.
+ * \param callback Optional callback function.
+ * \param argument Optional argument to the callback function.
+ * \return USBD_STATUS_SUCCESS if the transfer is started successfully;
+ *         otherwise an error code.
+ */
+uint8_t audd_speaker_driver_write_feedback(const void *buffer, uint32_t length,
+		usbd_xfer_cb_t callback, void *argument)
+{
+	AUDDSpeakerDriver *p_audd = &audd_speaker_driver;
+	AUDDSpeakerPhone *p_audf  = &p_audd->fun;
+
+	if (p_audf->pSpeaker->bEndpointFeedback == 0)
+		return USBRC_STATE_ERR;
+
+	return usbd_write(p_audf->pSpeaker->bEndpointFeedback,
+			buffer, length, callback, argument);
+}
+
 /**@}*/
@@ -132,8 +132,10 @@ static uint32_t audd_speaker_phone_parse(USBGenericDescriptor *desc,
 		/* Find Control Interface */
 		/* Find Entities */
 		/* Find Streaming Interface & Endpoints */
+		/* (feedback endpoints are given by the data endpoints) */
 		if (desc->bDescriptorType == USBGenericDescriptor_ENDPOINT
-			&& (pEp->bmAttributes & 0x3) == USBEndpointDescriptor_ISOCHRONOUS) {
+			&& (pEp->bmAttributes & 0x3) == USBEndpointDescriptor_ISOCHRONOUS
+			&& (pEp->bmAttributes & 0x30) != USBEndpointDescriptor_Feedback_ISOCHRONOUS) {
 			if (pEp->bEndpointAddress & 0x80 && p_mic) {
 				p_mic->bEndpointIn = pEp->bEndpointAddress & 0x7F;
 				p_mic->bAsInterface = p_arg->p_if_desc->bInterfaceNumber;
@@ -141,7 +143,12 @@ static uint32_t audd_speaker_phone_parse(USBGenericDescriptor *desc,
 				p_mic->bFeatureUnitIn = AUDD_ID_MicrophoneFU;
 			}
 			else if (p_speaker) {
+				AUDEndpointDescriptor *p_aud_ep = (AUDEndpointDescriptor*)desc;
 				p_speaker->bEndpointOut = pEp->bEndpointAddress;
+				/* Asynchronous endpoint with explicit feedback */
+				if (p_aud_ep->bLength >= sizeof(AUDEndpointDescriptor))
+					p_speaker->bEndpointFeedback =
+						p_aud_ep->bSyncAddress & 0x7F;
 				p_speaker->bAsInterface = p_arg->p_if_desc->bInterfaceNumber;
 				/* Fixed FU */
 				p_speaker->bFeatureUnitOut = AUDD_ID_SpeakerFU;
@@ -337,6 +344,7 @@ void audd_stream_initialize(AUDDStream *p_auds,
 	p_auds->bAsInterface    = 0xFF;
 	p_auds->bEndpointOut    = 0;
 	p_auds->bEndpointIn     = 0;
+	p_auds->bEndpointFeedback = 0;
 
 	p_auds->bNumChannels   = num_channels;
 	p_auds->bmMute         = 0;
@@ -506,6 +514,11 @@ uint32_t audd_stream_close(AUDDStream *stream)
 		bm_eps |= 1 << stream->bEndpointOut;
 	}
 
+	/* Close feedback of input stream */
+	if (stream->bEndpointFeedback) {
+		bm_eps |= 1 << stream->bEndpointFeedback;
+	}
+
 	usbd_hal_reset_endpoints(bm_eps, USBRC_CANCELED, 1);
 
 	return USBRC_SUCCESS;
@@ -536,6 +549,7 @@ void audd_speaker_phone_initializeStream(AUDDStream *p_auds,
 	p_auds->bAsInterface    = 0xFF;
 	p_auds->bEndpointOut    = 0;
 	p_auds->bEndpointIn     = 0;
+	p_auds->bEndpointFeedback = 0;
 
 	p_auds->bNumChannels   = numChannels;
 	p_auds->bmMute         = 0;
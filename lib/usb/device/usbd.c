@@ -263,6 +263,16 @@ bool usbd_is_high_speed(void)
 	return usbd_hal_is_high_speed();
 }
 
+/**
+ * Returns the last (micro)frame number received from the host, as a counter
+ * of 125us units wrapping every 2048ms: frame number in bits 13..3 and
+ * microframe number in bits 2..0 (always zero in full-speed).
+ */
+uint16_t usbd_get_frame_number(void)
+{
+	return usbd_hal_get_frame_number();
+}
+
 /**
  * Causes the given endpoint to acknowledge the next packet it receives
  * with a STALL handshake.
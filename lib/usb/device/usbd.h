@@ -173,6 +173,8 @@ extern uint8_t usbd_get_state(void);
 
 extern bool usbd_is_high_speed(void);
 
+extern uint16_t usbd_get_frame_number(void);
+
 extern void usbd_test(uint8_t index);
 
 extern void usbd_suspend_handler(void);
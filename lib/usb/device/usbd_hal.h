@@ -87,6 +87,8 @@ extern void usbd_hal_force_full_speed(void);
 
 extern bool usbd_hal_is_high_speed(void);
 
+extern uint16_t usbd_hal_get_frame_number(void);
+
 extern void usbd_hal_suspend(void);
 
 extern void usbd_hal_activate(void);
@@ -40,6 +40,7 @@
 #include "usb/device/usbd.h"
 #include "usb/device/usbd_hal.h"
 #include "usb/device/uvc/uvc_function.h"
+#include "video/frame_queue.h"
 #include "timer.h"
 #include <string.h>
 
@@ -86,6 +87,12 @@ static struct _uvc_driver *uvc_driver;
 
 static volatile uint32_t frame_buffer_addr;
 
+/** Frame queue of the capture driver, if any */
+static struct _frame_queue *frame_queue;
+
+/** Frame being sent, dequeued from frame_queue */
+static struct _frame *frame_sent;
+
 /*-----------------------------------------------------------------------------
  *      Exported functions
  *-----------------------------------------------------------------------------*/
@@ -285,6 +292,19 @@ void uvc_function_payload_sent(void *arg, uint8_t state,
 
 		return;
 	}
+	if (frame_queue) {
+		if (uvc_driver->frm_offset == 0) {
+			/* send the latest capture, or the previous frame again */
+			struct _frame *frame = frame_queue_dequeue_latest(frame_queue);
+			if (frame) {
+				if (frame_sent)
+					frame_queue_enqueue(frame_queue, frame_sent);
+				frame_sent = frame;
+			}
+		}
+		if (frame_sent)
+			uncompressed_stream = (uint8_t*)frame_sent->address[0];
+	}
 	dma_transfer_size = frame_size - uvc_driver->frm_offset;
 	header->bHeaderLength = FRAME_PAYLOAD_HDR_SIZE;
 	header->bmHeaderInfo.B = 0;
@@ -332,5 +352,13 @@ void uvc_function_update_frame_idx(uint32_t idx)
 	uvc_driver->stream_frm_index = idx;
 }
 
+void uvc_function_set_frame_queue(struct _frame_queue *queue)
+{
+	if (frame_queue && frame_sent)
+		frame_queue_enqueue(frame_queue, frame_sent);
+	frame_sent = NULL;
+	frame_queue = queue;
+}
+
 /**@}*/
 
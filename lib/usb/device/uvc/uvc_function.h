@@ -44,6 +44,7 @@
 
 #include <stdint.h>
 #include "usb/device/uvc/uvc_driver.h"
+#include "video/frame_queue.h"
 
 /*------------------------------------------------------------------------------
  *      Global functions
@@ -61,6 +62,14 @@ extern void uvc_function_set_cur(const USBGenericRequest *request);
 extern uint8_t uvc_function_is_video_on(void);
 extern uint8_t uvc_function_get_frame_format(void);
 extern void uvc_function_update_frame_idx(uint32_t idx);
+
+/**
+ * \brief Stream the frames of a capture frame queue: each video frame sent
+ * is the latest one captured, held until the next one is dequeued.
+ * Replaces uvc_function_update_frame_idx() and the fixed buffer rotation.
+ * \param queue Frame queue of the capture driver, or NULL
+ */
+extern void uvc_function_set_frame_queue(struct _frame_queue *queue);
 /**@}*/
 
 #endif /* UVCDRIVER_H */
@@ -0,0 +1,288 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file
+ *
+ * Host tool running the ISC auto white balance and auto exposure
+ * (drivers/video/isc_3a.c) outside of the target.
+ *
+ * Usage:
+ *   isc_3a [-e exposure] [-g gain] dump.bin
+ *     Replay recorded histograms. The dump is a sequence of sets of
+ *     BAYER_COUNT * HIST_ENTRIES little-endian 32-bit entries, as read by
+ *     iscd into pipe.histo_buf (e.g. saved from a debugger). AE runs open
+ *     loop from the given exposure and gain.
+ *   isc_3a -s
+ *     Closed loop simulation of a scene whose illuminant and brightness
+ *     change, reports the number of updates needed to converge.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "video/isc_3a.h"
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Simulated sensor, 1/16 gain units */
+#define SIM_GAIN_ONE      16
+#define SIM_GAIN_MAX      0x3ff
+#define SIM_EXPOSURE_MAX  1000
+
+/** Simulated scene */
+#define SIM_PIXELS        16384
+#define SIM_UPDATES       24
+#define SIM_CHANGE        8
+
+/** Convergence criteria: white balance within 3%, exposure within the
+ * AE dead band */
+#define SIM_WB_TOLERANCE  3
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static uint32_t histo[BAYER_COUNT * HIST_ENTRIES];
+
+static const char* channel_names[BAYER_COUNT] = { "Gr", "R", "Gb", "B" };
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static void _print_header(void)
+{
+	int c;
+
+	printf("%6s", "update");
+	for (c = 0; c < BAYER_COUNT; c++)
+		printf(" %6s", channel_names[c]);
+	printf(" |");
+	for (c = 0; c < BAYER_COUNT; c++)
+		printf(" %6s", channel_names[c]);
+	printf(" | %8s %6s\n", "exposure", "gain");
+	printf("%6s %27s   %27s\n", "", "means (bins)", "wb gains");
+}
+
+static void _print(uint32_t frame, const struct _isc_3a* ctx)
+{
+	int c;
+
+	printf("%6u", frame);
+	for (c = 0; c < BAYER_COUNT; c++)
+		printf(" %6.1f", ctx->stats[c].mean / (double)(1 << ISC_3A_MEAN_SHIFT));
+	printf(" |");
+	for (c = 0; c < BAYER_COUNT; c++)
+		printf(" %6.3f", ctx->wb_gain[c] / (double)ISC_3A_WB_ONE);
+	printf(" | %8u %6.2f\n", ctx->exposure, ctx->gain / (double)SIM_GAIN_ONE);
+}
+
+static void _configure(struct _isc_3a* ctx, uint32_t exposure, uint16_t gain)
+{
+	struct _isc_3a_cfg cfg = isc_3a_default_cfg;
+
+	cfg.exposure_min = 1;
+	cfg.exposure_max = SIM_EXPOSURE_MAX;
+	cfg.gain_one = SIM_GAIN_ONE;
+	cfg.gain_max = SIM_GAIN_MAX;
+	isc_3a_initialize(ctx, &cfg, exposure, gain);
+}
+
+static int _replay(const char* path, uint32_t exposure, uint16_t gain)
+{
+	struct _isc_3a ctx;
+	uint32_t frame = 0;
+	uint8_t raw[sizeof(histo)];
+	uint32_t i;
+	FILE* f;
+
+	f = fopen(path, "rb");
+	if (!f) {
+		perror(path);
+		return 1;
+	}
+
+	_configure(&ctx, exposure, gain);
+	_print_header();
+	while (fread(raw, sizeof(raw), 1, f) == 1) {
+		for (i = 0; i < BAYER_COUNT * HIST_ENTRIES; i++)
+			histo[i] = raw[4 * i] | (raw[4 * i + 1] << 8) |
+				(raw[4 * i + 2] << 16) | ((uint32_t)raw[4 * i + 3] << 24);
+		isc_3a_collect(&ctx, histo);
+		isc_3a_update_awb(&ctx);
+		isc_3a_update_ae(&ctx);
+		_print(frame++, &ctx);
+	}
+	fclose(f);
+
+	return 0;
+}
+
+/**
+ * \brief Build the pre white balance histograms of a scene of neutral
+ * patches under a colored illuminant.
+ */
+static void _simulate_frame(const double* reflectance, const double* illuminant,
+		double brightness, uint32_t exposure, uint16_t gain)
+{
+	double scale = brightness * exposure * gain / SIM_GAIN_ONE;
+	uint32_t i, c, bin;
+	double v;
+
+	memset(histo, 0, sizeof(histo));
+	for (c = 0; c < BAYER_COUNT; c++) {
+		for (i = 0; i < SIM_PIXELS; i++) {
+			v = reflectance[i] * illuminant[c] * scale;
+			bin = v >= HIST_ENTRIES - 1 ? HIST_ENTRIES - 1 : (uint32_t)v;
+			histo[c * HIST_ENTRIES + bin]++;
+		}
+	}
+}
+
+static bool _converged(const struct _isc_3a* ctx, const double* illuminant)
+{
+	double ideal, err;
+	uint32_t target = ctx->cfg.ae_target << ISC_3A_MEAN_SHIFT;
+	uint32_t tolerance = ctx->cfg.ae_tolerance << ISC_3A_MEAN_SHIFT;
+	uint32_t mean;
+	int c;
+
+	for (c = 0; c < BAYER_COUNT; c++) {
+		ideal = illuminant[HISTOGRAM_GR] / illuminant[c];
+		err = ctx->wb_gain[c] / (double)ISC_3A_WB_ONE / ideal - 1.0;
+		if (err * 100 > SIM_WB_TOLERANCE || -err * 100 > SIM_WB_TOLERANCE)
+			return false;
+	}
+
+	mean = (ctx->stats[HISTOGRAM_GR].mean + ctx->stats[HISTOGRAM_GB].mean) / 2;
+	return mean + tolerance >= target && mean <= target + tolerance;
+}
+
+static int _simulate(void)
+{
+	static double reflectance[SIM_PIXELS];
+	/* Gr, R, Gb, B: daylight, then tungsten */
+	static const double daylight[BAYER_COUNT] = { 1.0, 0.85, 1.0, 0.9 };
+	static const double tungsten[BAYER_COUNT] = { 1.0, 1.6, 1.0, 0.45 };
+	const double* illuminant = daylight;
+	double brightness = 0.1;
+	struct _isc_3a ctx;
+	uint32_t seed = 1, i, update, settled = 0;
+	int converged = -1;
+
+	/* gray patches, reflectance from 5% to 90% */
+	for (i = 0; i < SIM_PIXELS; i++) {
+		seed = seed * 1103515245 + 12345;
+		reflectance[i] = 0.05 + 0.85 * ((seed >> 8) & 0xffff) / 65535.0;
+	}
+
+	_configure(&ctx, 100, SIM_GAIN_ONE);
+	_print_header();
+	for (update = 0; update < SIM_UPDATES; update++) {
+		if (update == SIM_CHANGE) {
+			printf("----- light change: tungsten, 1/4 brightness\n");
+			illuminant = tungsten;
+			brightness /= 4;
+			converged = -1;
+		}
+		_simulate_frame(reflectance, illuminant, brightness,
+				ctx.exposure, ctx.gain);
+		isc_3a_collect(&ctx, histo);
+		isc_3a_update_awb(&ctx);
+		isc_3a_update_ae(&ctx);
+		_print(update, &ctx);
+
+		/* sensor settings apply to the next frame, check them there */
+		if (update >= SIM_CHANGE && converged < 0) {
+			_simulate_frame(reflectance, illuminant, brightness,
+					ctx.exposure, ctx.gain);
+			isc_3a_collect(&ctx, histo);
+			if (_converged(&ctx, illuminant)) {
+				converged = update - SIM_CHANGE + 1;
+				settled = update;
+			}
+		}
+	}
+
+	if (converged < 0) {
+		printf("not converged after %u updates\n", SIM_UPDATES - SIM_CHANGE);
+		return 1;
+	}
+	printf("converged %d update(s) after the light change (update %u)\n",
+	       converged, settled);
+	return 0;
+}
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+
+int main(int argc, char** argv)
+{
+	uint32_t exposure = 100;
+	uint16_t gain = SIM_GAIN_ONE;
+	bool simulate = false;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "e:g:s")) != -1) {
+		switch (opt) {
+		case 'e':
+			exposure = strtoul(optarg, NULL, 0);
+			break;
+		case 'g':
+			gain = strtoul(optarg, NULL, 0);
+			break;
+		case 's':
+			simulate = true;
+			break;
+		default:
+			optind = argc + 1;
+			break;
+		}
+	}
+
+	if (simulate)
+		return _simulate();
+	if (optind != argc - 1) {
+		fprintf(stderr, "usage: %s [-e exposure] [-g gain] dump.bin\n"
+				"       %s -s\n", argv[0], argv[0]);
+		return 1;
+	}
+	return _replay(argv[optind], exposure, gain);
+}
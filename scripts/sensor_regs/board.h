@@ -0,0 +1,2 @@
+/* Empty on purpose: the sensor register tables are built on the host by
+ * sensor_regs, without any target definitions. */
@@ -0,0 +1,5 @@
+/* Empty on purpose: the sensor register tables are built on the host by
+ * sensor_regs, without any target definitions. */
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
@@ -0,0 +1,237 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file
+ *
+ * Host tool compiling the image sensor register tables with
+ * sensor_regs_compile(), as done by the driver at run time.
+ *
+ * For each sensor output, it reports the number of TWI transactions and the
+ * estimated duration of the sensor setup, before (one transaction and a 2ms
+ * delay per register) and after compilation (burst writes and explicit
+ * delays only).  With -e, the compiled tables are printed as C arrays which
+ * can be given to sensor_write_compiled().
+ *
+ * Usage: sensor_regs [-f twi_frequency_hz] [-e]
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "video/image_sensor_inf.h"
+#include "video/sensor_regs.h"
+
+/*----------------------------------------------------------------------------
+ *        Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Per-register delay of the former driver, in us */
+#define LEGACY_DELAY_US 2000
+
+/** Bit times for START, slave address byte and STOP */
+#define TWI_OVERHEAD_BITS (1 + 9 + 1)
+
+/*----------------------------------------------------------------------------
+ *        Local types
+ *----------------------------------------------------------------------------*/
+
+struct table_stats {
+	uint32_t entries;
+	uint32_t transactions;
+	uint32_t bytes;
+	uint32_t delay_ms;
+	uint64_t bus_us;
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static const struct sensor_profile* profiles[] = {
+	&mt9v022_profile,
+	&ov2640_profile,
+	&ov2643_profile,
+	&ov5640_profile,
+	&ov7670_profile,
+	&ov7740_profile,
+	&ov9740_profile,
+};
+
+static const char* resolutions[] = {
+	"qvga", "vga", "svga", "xga", "wxga", "uvga",
+};
+
+static const char* formats[] = {
+	"raw", "yuv", "rgb", "ccir656", "mono",
+};
+
+static uint8_t table[64 * 1024] __attribute__((aligned(4)));
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint64_t _bus_time_us(uint32_t bytes, uint32_t freq)
+{
+	return ((uint64_t)(TWI_OVERHEAD_BITS + 9 * bytes) * 1000000 + freq - 1)
+		/ freq;
+}
+
+static void _legacy_stats(const struct sensor_profile* sensor,
+		const struct sensor_reg* list, uint32_t freq,
+		struct table_stats* stats)
+{
+	uint32_t addr_len = (sensor->twi_inf_mode == SENSOR_TWI_REG_2BYTE_DATA_BYTE) ? 2 : 1;
+	uint32_t data_len = (sensor->twi_inf_mode == SENSOR_TWI_REG_BYTE_DATA_2BYTE) ? 2 : 1;
+
+	for (; !(list->reg == SENSOR_REG_TERM && list->val == SENSOR_VAL_TERM); list++) {
+		stats->entries++;
+		stats->transactions++;
+		stats->bytes += addr_len + data_len;
+		stats->bus_us += _bus_time_us(addr_len + data_len, freq) + LEGACY_DELAY_US;
+	}
+}
+
+static void _compiled_stats(const uint8_t* t, uint32_t freq,
+		struct table_stats* stats)
+{
+	uint16_t arg;
+
+	while (t[0] != SENSOR_REGS_OP_END) {
+		arg = t[2] | (t[3] << 8);
+		if (t[0] == SENSOR_REGS_OP_DELAY) {
+			stats->delay_ms += arg;
+			stats->bus_us += (uint64_t)arg * 1000;
+			t += 4;
+		} else {
+			stats->transactions++;
+			stats->bytes += arg;
+			stats->bus_us += _bus_time_us(arg, freq);
+			t += 4 + ((arg + 3) & ~3);
+		}
+	}
+}
+
+static void _emit(const char* name, const uint8_t* t, uint32_t size)
+{
+	uint32_t i;
+
+	printf("ALIGNED(4) static const uint8_t %s[] = {", name);
+	for (i = 0; i < size; i++)
+		printf("%s0x%02x,", (i % 12) ? " " : "\n\t", t[i]);
+	printf("\n};\n\n");
+}
+
+static int _process(const struct sensor_profile* sensor,
+		const struct sensor_output* output, uint32_t freq, bool emit)
+{
+	struct table_stats legacy = { 0 }, compiled = { 0 };
+	const struct sensor_reg* next = output->output_setting;
+	char name[64];
+	int len;
+
+	_legacy_stats(sensor, output->output_setting, freq, &legacy);
+
+	len = sensor_regs_compile(next, sensor->twi_inf_mode, sensor->twi_flags,
+			table, sizeof(table), &next);
+	if (len < 0 || next) {
+		fprintf(stderr, "%s: table too large\n", sensor->name);
+		return -1;
+	}
+	_compiled_stats(table, freq, &compiled);
+
+	snprintf(name, sizeof(name), "%s_%s_%s%s", sensor->name,
+		 output->output_resolution < 6 ? resolutions[output->output_resolution] : "?",
+		 output->output_format < 5 ? formats[output->output_format] : "?",
+		 output->type ? "_af" : "");
+
+	if (emit) {
+		_emit(name, table, len);
+		return 0;
+	}
+
+	printf("%-22s %7u %7u %10.1f   %7u %7u %6u %10.1f %6.1fx\n", name,
+	       legacy.entries, legacy.transactions, legacy.bus_us / 1000.0,
+	       compiled.transactions, compiled.bytes, compiled.delay_ms,
+	       compiled.bus_us / 1000.0,
+	       compiled.bus_us ? (double)legacy.bus_us / compiled.bus_us : 0.0);
+	return 0;
+}
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+
+int main(int argc, char** argv)
+{
+	uint32_t freq = 400000;
+	bool emit = false;
+	int opt, err = 0;
+	uint32_t i, j;
+
+	while ((opt = getopt(argc, argv, "f:e")) != -1) {
+		switch (opt) {
+		case 'f':
+			freq = strtoul(optarg, NULL, 0);
+			break;
+		case 'e':
+			emit = true;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-f twi_frequency_hz] [-e]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (freq == 0)
+		return 1;
+
+	if (!emit) {
+		printf("TWI at %u Hz, times in ms\n", freq);
+		printf("%-22s %7s %7s %10s   %7s %7s %6s %10s %7s\n", "table",
+		       "regs", "xfers", "before", "xfers", "bytes", "delay",
+		       "after", "gain");
+	}
+
+	for (i = 0; i < sizeof(profiles) / sizeof(profiles[0]); i++) {
+		for (j = 0; j < SENSOR_SUPPORTED_OUTPUTS; j++) {
+			const struct sensor_output* output = profiles[i]->output_conf[j];
+			if (output && output->output_setting)
+				err |= _process(profiles[i], output, freq, emit);
+		}
+	}
+
+	return err ? 1 : 0;
+}
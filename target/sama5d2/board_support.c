@@ -699,3 +699,20 @@ Fail:
 	trace_error("Error initializing ACT8945A PMIC\r\n");
 #endif
 }
+
+bool board_set_vddcore(uint16_t mv)
+{
+#ifdef CONFIG_HAVE_PMIC_ACT8945A
+	if (!act8945a_initialized) {
+		board_cfg_pmic();
+		if (!act8945a_initialized)
+			return false;
+	}
+
+	/* VDDCORE is supplied by DC/DC regulator 2, through the VSETx register
+	 * selected by the VSEL pin (see CONFIG_ACT8945A_VSEL) */
+	return act8945a_set_regulator_voltage(&act8945a, 2, mv);
+#else
+	return false;
+#endif
+}
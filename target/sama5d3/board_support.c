@@ -506,6 +506,17 @@ void board_cfg_pmic(void)
 #endif
 }
 
+bool board_set_vddcore(uint16_t mv)
+{
+#ifdef CONFIG_HAVE_PMIC_ACT8865
+	/* VDDCORE is supplied by DC/DC regulator 2 */
+	return act8865_set_reg_voltage(&pmic, REG2_0,
+			act8865_get_voltage_code(mv)) == 0;
+#else
+	return false;
+#endif
+}
+
 bool board_cfg_sdmmc(uint32_t periph_id)
 {
 	switch (periph_id) {
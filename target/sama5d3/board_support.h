@@ -115,6 +115,12 @@ extern void board_cfg_nor_flash(void);
  */
 extern void board_cfg_pmic(void);
 
+/**
+ * \brief Set the VDDCORE voltage (in mV) through the PMIC
+ * \return true on success, false if the board cannot change VDDCORE
+ */
+extern bool board_set_vddcore(uint16_t mv);
+
 /**
  * \brief Configures the board.
  */
@@ -0,0 +1,749 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "audio_dsp.h"
+
+/*----------------------------------------------------------------------------
+ *         Local definitions
+ *----------------------------------------------------------------------------*/
+
+#if defined(CONFIG_ARCH_ARMV7A) && defined(__GNUC__)
+#define AUDIO_DSP_ARM
+#endif
+
+#if defined(AUDIO_DSP_ARM) && defined(CONFIG_HAVE_NEON)
+#define AUDIO_DSP_NEON
+#endif
+
+#define TAPS CONFIG_AUDIO_DSP_RS_TAPS
+#define PHASE_BITS CONFIG_AUDIO_DSP_RS_PHASE_BITS
+
+#if (TAPS % 8) != 0
+#error CONFIG_AUDIO_DSP_RS_TAPS must be a multiple of 8
+#endif
+
+/** Resampler filter: Kaiser window parameter */
+#define RS_KAISER_BETA 7.0
+
+/** Resampler filter: cut-off, relative to the Nyquist frequency of the lower
+ * of the input and output rates */
+#define RS_CUTOFF 0.91
+
+/** Resampler coefficients scale (Q14, leaves headroom for sinc overshoot) */
+#define RS_COEF_BITS 14
+
+/** Samples converted per pass by audio_dsp_convert() */
+#define CONVERT_SAMPLES 128
+
+/** Samples accumulated per pass by the mixers */
+#define MIX_SAMPLES 64
+
+#define PI 3.14159265358979323846
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+static inline int16_t _sat16(int32_t x)
+{
+#ifdef AUDIO_DSP_ARM
+	asm("ssat %0, #16, %1" : "=r"(x) : "r"(x));
+	return (int16_t)x;
+#else
+	if (x > INT16_MAX)
+		return INT16_MAX;
+	if (x < INT16_MIN)
+		return INT16_MIN;
+	return (int16_t)x;
+#endif
+}
+
+static inline int32_t _sat32(int64_t x)
+{
+	if (x > INT32_MAX)
+		return INT32_MAX;
+	if (x < INT32_MIN)
+		return INT32_MIN;
+	return (int32_t)x;
+}
+
+/**
+ * \brief sin(pi * x), without libm
+ */
+static double _sin_pi(double x)
+{
+	double t, t2;
+
+	while (x > 1.0)
+		x -= 2.0;
+	while (x < -1.0)
+		x += 2.0;
+	if (x > 0.5)
+		x = 1.0 - x;
+	else if (x < -0.5)
+		x = -1.0 - x;
+
+	/* Taylor series up to t^13, |t| <= pi/2 */
+	t = x * PI;
+	t2 = t * t;
+	return t * (1 - t2 / 6 * (1 - t2 / 20 * (1 - t2 / 42 * (1 - t2 / 72
+		* (1 - t2 / 110 * (1 - t2 / 156))))));
+}
+
+/**
+ * \brief Modified Bessel function I0(x), given y = (x / 2)^2
+ */
+static double _bessel_i0(double y)
+{
+	double sum = 1.0, term = 1.0;
+	int k;
+
+	for (k = 1; k < 64; k++) {
+		term *= y / ((double)k * k);
+		sum += term;
+		if (term < sum * 1e-12)
+			break;
+	}
+	return sum;
+}
+
+/**
+ * \brief Convert samples to Q31
+ */
+static void _load(int32_t* q, const void* src, enum _audio_dsp_format format,
+		uint32_t samples)
+{
+	uint32_t i;
+
+	switch (format) {
+	case AUDIO_DSP_S16:
+	{
+		const int16_t* s = (const int16_t*)src;
+		for (i = 0; i < samples; i++)
+			q[i] = (int32_t)((uint32_t)s[i] << 16);
+		break;
+	}
+	case AUDIO_DSP_S24:
+	{
+		const uint8_t* s = (const uint8_t*)src;
+		for (i = 0; i < samples; i++, s += 3)
+			q[i] = (int32_t)(((uint32_t)s[0] << 8) |
+					((uint32_t)s[1] << 16) | ((uint32_t)s[2] << 24));
+		break;
+	}
+	case AUDIO_DSP_S24_32:
+	{
+		const int32_t* s = (const int32_t*)src;
+		for (i = 0; i < samples; i++)
+			q[i] = (int32_t)((uint32_t)s[i] << 8);
+		break;
+	}
+	case AUDIO_DSP_S32:
+		memcpy(q, src, samples * sizeof(int32_t));
+		break;
+	}
+}
+
+/**
+ * \brief Round a Q31 sample to 'bits' bits, with saturation
+ */
+static inline int32_t _round(int32_t q, int bits)
+{
+	int32_t v = (q >> (32 - bits)) + ((q >> (31 - bits)) & 1);
+	int32_t max = (1 << (bits - 1)) - 1;
+
+	return v > max ? max : v;
+}
+
+/**
+ * \brief Convert Q31 samples to a format
+ */
+static void _store(void* dst, enum _audio_dsp_format format, const int32_t* q,
+		uint32_t samples)
+{
+	uint32_t i;
+
+	switch (format) {
+	case AUDIO_DSP_S16:
+	{
+		int16_t* d = (int16_t*)dst;
+		for (i = 0; i < samples; i++)
+			d[i] = (int16_t)_round(q[i], 16);
+		break;
+	}
+	case AUDIO_DSP_S24:
+	{
+		uint8_t* d = (uint8_t*)dst;
+		for (i = 0; i < samples; i++, d += 3) {
+			int32_t v = _round(q[i], 24);
+			d[0] = (uint8_t)v;
+			d[1] = (uint8_t)(v >> 8);
+			d[2] = (uint8_t)(v >> 16);
+		}
+		break;
+	}
+	case AUDIO_DSP_S24_32:
+	{
+		int32_t* d = (int32_t*)dst;
+		for (i = 0; i < samples; i++)
+			d[i] = _round(q[i], 24);
+		break;
+	}
+	case AUDIO_DSP_S32:
+		memcpy(dst, q, samples * sizeof(int32_t));
+		break;
+	}
+}
+
+static uint8_t _sample_size(enum _audio_dsp_format format)
+{
+	switch (format) {
+	case AUDIO_DSP_S16:
+		return 2;
+	case AUDIO_DSP_S24:
+		return 3;
+	default:
+		return 4;
+	}
+}
+
+/**
+ * \brief Multiply 16-bit samples by a constant Q15 gain below unity, with
+ * rounding
+ */
+static void _scale_s16(int16_t* buf, uint32_t samples, int16_t gain)
+{
+	uint32_t i = 0;
+
+#ifdef AUDIO_DSP_NEON
+	uint32_t n = samples & ~7u;
+	if (n) {
+		int16_t* p = buf;
+		asm volatile(
+			".fpu neon-vfpv4\n"
+			"vdup.16 q1, %2\n"
+			"1:\n"
+			"vld1.16 {d0-d1}, [%0]\n"
+			"vqrdmulh.s16 q0, q0, q1\n"
+			"subs %1, %1, #8\n"
+			"vst1.16 {d0-d1}, [%0]!\n"
+			"bgt 1b\n"
+			: "+r"(p), "+r"(n)
+			: "r"((int32_t)gain)
+			: "d0", "d1", "d2", "d3", "cc", "memory");
+		i = samples & ~7u;
+	}
+#endif
+	for (; i < samples; i++)
+		buf[i] = (int16_t)((buf[i] * gain + 0x4000) >> 15);
+}
+
+/**
+ * \brief Dot products of TAPS input samples with two adjacent filter phases
+ */
+static void _dot2(const int16_t* h, const int16_t* x, int32_t* a, int32_t* b)
+{
+#if defined(AUDIO_DSP_NEON)
+	const int16_t* h1 = h + TAPS;
+	uint32_t n = TAPS;
+	int32_t sa, sb;
+
+	asm volatile(
+		".fpu neon-vfpv4\n"
+		"vmov.i32 q3, #0\n"
+		"vmov.i32 q4, #0\n"
+		"1:\n"
+		"vld1.16 {d0-d1}, [%[x]]!\n"
+		"vld1.16 {d2-d3}, [%[h0]]!\n"
+		"vld1.16 {d4-d5}, [%[h1]]!\n"
+		"vmlal.s16 q3, d2, d0\n"
+		"vmlal.s16 q3, d3, d1\n"
+		"vmlal.s16 q4, d4, d0\n"
+		"vmlal.s16 q4, d5, d1\n"
+		"subs %[n], %[n], #8\n"
+		"bgt 1b\n"
+		"vpadd.i32 d6, d6, d7\n"
+		"vpadd.i32 d8, d8, d9\n"
+		"vpadd.i32 d6, d6, d8\n"
+		"vmov %[a], %[b], d6\n"
+		: [x] "+r"(x), [h0] "+r"(h), [h1] "+r"(h1), [n] "+r"(n),
+		  [a] "=&r"(sa), [b] "=&r"(sb)
+		:
+		: "d0", "d1", "d2", "d3", "d4", "d5", "d6", "d7", "d8", "d9",
+		  "cc", "memory");
+	*a = sa;
+	*b = sb;
+#elif defined(AUDIO_DSP_ARM)
+	/* dual 16-bit multiply-accumulate */
+	int32_t sa = 0, sb = 0;
+	uint32_t xv, h0v, h1v;
+	int i;
+
+	for (i = 0; i < TAPS; i += 2) {
+		memcpy(&xv, x + i, sizeof(xv));
+		memcpy(&h0v, h + i, sizeof(h0v));
+		memcpy(&h1v, h + TAPS + i, sizeof(h1v));
+		asm("smlad %0, %1, %2, %0" : "+r"(sa) : "r"(h0v), "r"(xv));
+		asm("smlad %0, %1, %2, %0" : "+r"(sb) : "r"(h1v), "r"(xv));
+	}
+	*a = sa;
+	*b = sb;
+#else
+	int32_t sa = 0, sb = 0;
+	int i;
+
+	for (i = 0; i < TAPS; i++) {
+		sa += h[i] * x[i];
+		sb += h[i + TAPS] * x[i];
+	}
+	*a = sa;
+	*b = sb;
+#endif
+}
+
+/**
+ * \brief Append input frames to the resampler history
+ * \return Number of input frames consumed
+ */
+static uint32_t _rs_feed(struct _audio_dsp_resampler* rs, const int16_t* in,
+		uint32_t frames)
+{
+	uint32_t skip = 0, n, i;
+	uint8_t c, ch = rs->channels;
+
+	/* drop the frames no longer reached by the filter */
+	if (rs->pos >= rs->filled) {
+		rs->pos -= rs->filled;
+		rs->filled = 0;
+		/* the step went past the buffered input */
+		skip = rs->pos < frames ? rs->pos : frames;
+		rs->pos -= skip;
+		in += skip * ch;
+		frames -= skip;
+	} else if (rs->pos) {
+		for (c = 0; c < ch; c++)
+			memmove(rs->hist[c], rs->hist[c] + rs->pos,
+					(rs->filled - rs->pos) * sizeof(int16_t));
+		rs->filled -= rs->pos;
+		rs->pos = 0;
+	}
+
+	n = TAPS + CONFIG_AUDIO_DSP_RS_BLOCK - rs->filled;
+	if (n > frames)
+		n = frames;
+	if (ch == 1) {
+		memcpy(rs->hist[0] + rs->filled, in, n * sizeof(int16_t));
+	} else {
+		for (i = 0; i < n; i++)
+			for (c = 0; c < ch; c++)
+				rs->hist[c][rs->filled + i] = in[i * ch + c];
+	}
+	rs->filled += n;
+
+	return skip + n;
+}
+
+/*----------------------------------------------------------------------------
+ *         Global functions
+ *----------------------------------------------------------------------------*/
+
+int audio_dsp_convert(void* dst, enum _audio_dsp_format dst_format,
+		uint8_t dst_channels, const void* src,
+		enum _audio_dsp_format src_format, uint8_t src_channels,
+		uint32_t frames)
+{
+	int32_t in[CONVERT_SAMPLES];
+	int32_t out[CONVERT_SAMPLES];
+	uint8_t* d = (uint8_t*)dst;
+	const uint8_t* s = (const uint8_t*)src;
+	uint8_t max_channels;
+	uint32_t chunk, n, i;
+	uint8_t c;
+
+	if (!src_channels || !dst_channels)
+		return -EINVAL;
+	if (src_channels != dst_channels && src_channels != 1 &&
+	    dst_channels != 1)
+		return -EINVAL;
+
+	if (src_format == dst_format && src_channels == dst_channels) {
+		memmove(dst, src, frames * src_channels *
+				_sample_size(src_format));
+		return 0;
+	}
+
+	max_channels = src_channels > dst_channels ? src_channels : dst_channels;
+	chunk = CONVERT_SAMPLES / max_channels;
+	if (!chunk)
+		return -EINVAL;
+
+	while (frames) {
+		n = frames < chunk ? frames : chunk;
+		_load(in, s, src_format, n * src_channels);
+
+		if (src_channels == dst_channels) {
+			memcpy(out, in, n * src_channels * sizeof(int32_t));
+		} else if (src_channels == 1) {
+			for (i = 0; i < n; i++)
+				for (c = 0; c < dst_channels; c++)
+					out[i * dst_channels + c] = in[i];
+		} else {
+			for (i = 0; i < n; i++) {
+				int64_t sum = 0;
+				for (c = 0; c < src_channels; c++)
+					sum += in[i * src_channels + c];
+				out[i] = (int32_t)(sum / src_channels);
+			}
+		}
+
+		_store(d, dst_format, out, n * dst_channels);
+		s += n * src_channels * _sample_size(src_format);
+		d += n * dst_channels * _sample_size(dst_format);
+		frames -= n;
+	}
+	return 0;
+}
+
+void audio_dsp_add_s16(int16_t* dst, const int16_t* src, uint32_t samples)
+{
+	uint32_t i = 0;
+
+#if defined(AUDIO_DSP_NEON)
+	uint32_t n = samples & ~7u;
+	if (n) {
+		int16_t* d = dst;
+		const int16_t* s = src;
+		asm volatile(
+			".fpu neon-vfpv4\n"
+			"1:\n"
+			"vld1.16 {d0-d1}, [%0]\n"
+			"vld1.16 {d2-d3}, [%1]!\n"
+			"vqadd.s16 q0, q0, q1\n"
+			"subs %2, %2, #8\n"
+			"vst1.16 {d0-d1}, [%0]!\n"
+			"bgt 1b\n"
+			: "+r"(d), "+r"(s), "+r"(n)
+			:
+			: "d0", "d1", "d2", "d3", "cc", "memory");
+		i = samples & ~7u;
+	}
+#elif defined(AUDIO_DSP_ARM)
+	/* dual 16-bit saturating add */
+	for (; i + 2 <= samples; i += 2) {
+		uint32_t a, b;
+		memcpy(&a, dst + i, sizeof(a));
+		memcpy(&b, src + i, sizeof(b));
+		asm("qadd16 %0, %1, %2" : "=r"(a) : "r"(a), "r"(b));
+		memcpy(dst + i, &a, sizeof(a));
+	}
+#endif
+	for (; i < samples; i++)
+		dst[i] = _sat16(dst[i] + src[i]);
+}
+
+void audio_dsp_mix_s16(int16_t* dst, const int16_t* const* src,
+		const uint16_t* gain, uint8_t count, uint32_t samples)
+{
+	int64_t acc[MIX_SAMPLES];
+	uint32_t off, n, i;
+	uint8_t k;
+
+	if (!count) {
+		memset(dst, 0, samples * sizeof(int16_t));
+		return;
+	}
+
+	/* two streams at unity gain: vector saturating add */
+	if (count == 2 && (!gain || (gain[0] == AUDIO_DSP_UNITY &&
+	                             gain[1] == AUDIO_DSP_UNITY))) {
+		if (dst == src[1]) {
+			audio_dsp_add_s16(dst, src[0], samples);
+		} else {
+			if (dst != src[0])
+				memmove(dst, src[0], samples * sizeof(int16_t));
+			audio_dsp_add_s16(dst, src[1], samples);
+		}
+		return;
+	}
+
+	for (off = 0; off < samples; off += n) {
+		n = samples - off < MIX_SAMPLES ? samples - off : MIX_SAMPLES;
+		memset(acc, 0, n * sizeof(acc[0]));
+		for (k = 0; k < count; k++) {
+			const int16_t* s = src[k] + off;
+			int32_t g = gain ? gain[k] : AUDIO_DSP_UNITY;
+			for (i = 0; i < n; i++)
+				acc[i] += s[i] * g;
+		}
+		for (i = 0; i < n; i++)
+			dst[off + i] = _sat16((int32_t)(_sat32(acc[i] + 0x4000) >> 15));
+	}
+}
+
+void audio_dsp_mix_s32(int32_t* dst, const int32_t* const* src,
+		const uint16_t* gain, uint8_t count, uint32_t samples)
+{
+	int64_t acc[MIX_SAMPLES];
+	uint32_t off, n, i;
+	uint8_t k;
+
+	for (off = 0; off < samples; off += n) {
+		n = samples - off < MIX_SAMPLES ? samples - off : MIX_SAMPLES;
+		memset(acc, 0, n * sizeof(acc[0]));
+		for (k = 0; k < count; k++) {
+			const int32_t* s = src[k] + off;
+			int32_t g = gain ? gain[k] : AUDIO_DSP_UNITY;
+			for (i = 0; i < n; i++)
+				acc[i] += (int64_t)s[i] * g;
+		}
+		for (i = 0; i < n; i++)
+			dst[off + i] = _sat32((acc[i] + 0x4000) >> 15);
+	}
+}
+
+uint16_t audio_dsp_db_to_gain(int16_t db)
+{
+	/* log2(10) / 20 / 256, Q24 */
+	const int32_t log2_per_db = 10885;
+	int32_t x, f, p;
+	int shift;
+
+	if (db >= 0)
+		return AUDIO_DSP_UNITY;
+	if (db < -90 * 256)
+		return 0;
+
+	/* 2^x = 2^-shift * 2^f, 0 <= f < 1 */
+	x = db * log2_per_db;
+	shift = -(x >> 24);
+	f = (x & 0xffffff) >> 9;
+
+	/* 2^f, cubic fit in Q15 */
+	p = (2565 * f) >> 15;
+	p = ((p + 7411) * f) >> 15;
+	p = ((p + 22792) * f) >> 15;
+	p += 32768;
+
+	return (uint16_t)((p + (1 << (shift - 1))) >> shift);
+}
+
+void audio_dsp_volume_init(struct _audio_dsp_volume* vol, uint16_t gain)
+{
+	if (gain > AUDIO_DSP_UNITY)
+		gain = AUDIO_DSP_UNITY;
+	vol->gain = (int32_t)gain << 15;
+	vol->target = vol->gain;
+	vol->step = 0;
+	vol->remaining = 0;
+}
+
+void audio_dsp_volume_set(struct _audio_dsp_volume* vol, uint16_t gain,
+		uint32_t frames)
+{
+	if (gain > AUDIO_DSP_UNITY)
+		gain = AUDIO_DSP_UNITY;
+	vol->target = (int32_t)gain << 15;
+	if (!frames || vol->target == vol->gain) {
+		vol->gain = vol->target;
+		vol->remaining = 0;
+		return;
+	}
+	vol->step = (vol->target - vol->gain) / (int32_t)frames;
+	vol->remaining = frames;
+}
+
+void audio_dsp_volume_apply_s16(struct _audio_dsp_volume* vol,
+		int16_t* buf, uint32_t frames, uint8_t channels)
+{
+	int32_t g;
+	uint8_t c;
+
+	/* ramp, gain updated every frame */
+	for (; frames && vol->remaining; frames--, buf += channels) {
+		g = vol->gain >> 15;
+		for (c = 0; c < channels; c++)
+			buf[c] = (int16_t)((buf[c] * g + 0x4000) >> 15);
+		if (--vol->remaining)
+			vol->gain += vol->step;
+		else
+			vol->gain = vol->target;
+	}
+
+	g = vol->gain >> 15;
+	if (!frames || g >= AUDIO_DSP_UNITY)
+		return;
+	_scale_s16(buf, frames * channels, (int16_t)g);
+}
+
+void audio_dsp_volume_apply_s32(struct _audio_dsp_volume* vol,
+		int32_t* buf, uint32_t frames, uint8_t channels)
+{
+	uint32_t i;
+	int32_t g;
+	uint8_t c;
+
+	for (; frames && vol->remaining; frames--, buf += channels) {
+		g = vol->gain >> 15;
+		for (c = 0; c < channels; c++)
+			buf[c] = (int32_t)(((int64_t)buf[c] * g + 0x4000) >> 15);
+		if (--vol->remaining)
+			vol->gain += vol->step;
+		else
+			vol->gain = vol->target;
+	}
+
+	g = vol->gain >> 15;
+	if (!frames || g >= AUDIO_DSP_UNITY)
+		return;
+	for (i = 0; i < frames * channels; i++)
+		buf[i] = (int32_t)(((int64_t)buf[i] * g + 0x4000) >> 15);
+}
+
+int audio_dsp_resampler_init(struct _audio_dsp_resampler* rs,
+		uint8_t channels, uint32_t in_rate, uint32_t out_rate)
+{
+	const double half = TAPS / 2;
+	double h[TAPS];
+	double cutoff, i0_beta, sum;
+	int32_t q, total;
+	int p, k;
+
+	if (!channels || channels > AUDIO_DSP_MAX_CHANNELS)
+		return -EINVAL;
+	if (!in_rate || !out_rate || in_rate > 4 * out_rate)
+		return -EINVAL;
+
+	cutoff = RS_CUTOFF;
+	if (in_rate > out_rate)
+		cutoff = cutoff * out_rate / in_rate;
+	i0_beta = _bessel_i0(RS_KAISER_BETA * RS_KAISER_BETA / 4);
+
+	/* phase p computes the output at (TAPS / 2 - 1 + p / PHASES) from the
+	 * first tap, each row is normalized to unity DC gain */
+	for (p = 0; p <= AUDIO_DSP_RS_PHASES; p++) {
+		sum = 0.0;
+		for (k = 0; k < TAPS; k++) {
+			double t = half - 1 + (double)p / AUDIO_DSP_RS_PHASES - k;
+			double r = t / half;
+			double u = cutoff * t;
+			double v = 0.0;
+
+			if (r > -1.0 && r < 1.0) {
+				v = u == 0.0 ? 1.0 : _sin_pi(u) / (PI * u);
+				v *= _bessel_i0(RS_KAISER_BETA * RS_KAISER_BETA
+						* (1 - r * r) / 4) / i0_beta;
+			}
+			h[k] = v;
+			sum += v;
+		}
+		total = 0;
+		for (k = 0; k < TAPS; k++) {
+			double v = h[k] / sum * (1 << RS_COEF_BITS);
+			q = (int32_t)(v >= 0 ? v + 0.5 : v - 0.5);
+			rs->coefs[p * TAPS + k] = (int16_t)q;
+			total += q;
+		}
+		/* rounding error on the central tap */
+		k = p < AUDIO_DSP_RS_PHASES / 2 ? TAPS / 2 - 1 : TAPS / 2;
+		rs->coefs[p * TAPS + k] += (int16_t)((1 << RS_COEF_BITS) - total);
+	}
+
+	rs->channels = channels;
+	rs->base_step = ((uint64_t)in_rate << 32) / out_rate;
+	rs->step = rs->base_step;
+	audio_dsp_resampler_reset(rs);
+	return 0;
+}
+
+void audio_dsp_resampler_reset(struct _audio_dsp_resampler* rs)
+{
+	memset(rs->hist, 0, sizeof(rs->hist));
+	/* first input frame is aligned with the first output */
+	rs->filled = TAPS / 2 - 1;
+	rs->pos = 0;
+	rs->frac = 0;
+}
+
+void audio_dsp_resampler_set_drift(struct _audio_dsp_resampler* rs,
+		int32_t drift)
+{
+	/* base_step < 2^35, 256 * 3906250 = 10^9 */
+	int64_t delta = (int64_t)(rs->base_step >> 8) * drift / 3906250;
+
+	rs->step = rs->base_step + delta;
+}
+
+uint32_t audio_dsp_resample_s16(struct _audio_dsp_resampler* rs,
+		const int16_t* in, uint32_t in_frames, uint32_t* consumed,
+		int16_t* out, uint32_t out_frames)
+{
+	uint32_t used = 0, produced = 0;
+	uint8_t c, ch = rs->channels;
+
+	while (produced < out_frames) {
+		const int16_t* h;
+		uint32_t f;
+		uint64_t next;
+
+		if (rs->pos + TAPS > rs->filled) {
+			if (used == in_frames)
+				break;
+			used += _rs_feed(rs, in + used * ch, in_frames - used);
+			continue;
+		}
+
+		h = rs->coefs + (rs->frac >> (32 - PHASE_BITS)) * TAPS;
+		f = (rs->frac >> (32 - PHASE_BITS - 15)) & 0x7fff;
+		for (c = 0; c < ch; c++) {
+			int32_t a, b, y;
+
+			_dot2(h, rs->hist[c] + rs->pos, &a, &b);
+			y = a + (int32_t)(((int64_t)(b - a) * f) >> 15);
+			*out++ = _sat16((y + (1 << (RS_COEF_BITS - 1))) >> RS_COEF_BITS);
+		}
+		produced++;
+
+		next = (uint64_t)rs->frac + rs->step;
+		rs->frac = (uint32_t)next;
+		rs->pos += (uint32_t)(next >> 32);
+	}
+
+	*consumed = used;
+	return produced;
+}
@@ -0,0 +1,271 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef AUDIO_DSP_H_
+#define AUDIO_DSP_H_
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *         Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Unity gain for the Q15 gains of the mixer and of the volume */
+#define AUDIO_DSP_UNITY 0x8000
+
+/** Maximum number of interleaved channels processed by the resampler */
+#define AUDIO_DSP_MAX_CHANNELS 2
+
+/** Taps per phase of the resampler filter (multiple of 8) */
+#ifndef CONFIG_AUDIO_DSP_RS_TAPS
+#define CONFIG_AUDIO_DSP_RS_TAPS 32
+#endif
+
+/** Number of phases of the resampler filter is 2^CONFIG_AUDIO_DSP_RS_PHASE_BITS,
+ * outputs are interpolated between two adjacent phases */
+#ifndef CONFIG_AUDIO_DSP_RS_PHASE_BITS
+#define CONFIG_AUDIO_DSP_RS_PHASE_BITS 6
+#endif
+
+/** Number of phases of the resampler filter */
+#define AUDIO_DSP_RS_PHASES (1 << CONFIG_AUDIO_DSP_RS_PHASE_BITS)
+
+/** Input frames buffered per channel by the resampler */
+#ifndef CONFIG_AUDIO_DSP_RS_BLOCK
+#define CONFIG_AUDIO_DSP_RS_BLOCK 128
+#endif
+
+/*----------------------------------------------------------------------------
+ *         Type definitions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Sample formats, all signed little-endian
+ */
+enum _audio_dsp_format {
+	AUDIO_DSP_S16,     /**< 16-bit samples */
+	AUDIO_DSP_S24,     /**< 24-bit samples packed in 3 bytes */
+	AUDIO_DSP_S24_32,  /**< 24-bit samples in the LSBs of 32-bit words */
+	AUDIO_DSP_S32,     /**< 32-bit samples */
+};
+
+/**
+ * \brief Asynchronous polyphase resampler state
+ *
+ * The filter is a Kaiser windowed sinc, sampled on
+ * AUDIO_DSP_RS_PHASES + 1 phases of CONFIG_AUDIO_DSP_RS_TAPS taps.
+ * Output samples are computed for the two phases around the exact position
+ * and linearly interpolated, so the ratio can be any value and can be
+ * changed while running (e.g. to follow the drift between an USB host clock
+ * and the codec clock).
+ */
+struct _audio_dsp_resampler {
+	/** Q14 coefficients, one row per phase */
+	int16_t coefs[(AUDIO_DSP_RS_PHASES + 1) * CONFIG_AUDIO_DSP_RS_TAPS];
+	/** Deinterleaved input history */
+	int16_t hist[AUDIO_DSP_MAX_CHANNELS]
+		[CONFIG_AUDIO_DSP_RS_TAPS + CONFIG_AUDIO_DSP_RS_BLOCK];
+	uint64_t base_step;  /**< nominal input frames per output frame, Q32 */
+	uint64_t step;       /**< current step, including the drift, Q32 */
+	uint32_t frac;       /**< fractional input position, Q32 */
+	uint32_t pos;        /**< index in hist of the first tap */
+	uint32_t filled;     /**< frames in hist */
+	uint8_t channels;
+};
+
+/**
+ * \brief Volume with linear ramps between gains
+ */
+struct _audio_dsp_volume {
+	int32_t gain;        /**< current gain, Q30 */
+	int32_t target;      /**< gain at the end of the ramp, Q30 */
+	int32_t step;        /**< gain increment per frame, Q30 */
+	uint32_t remaining;  /**< frames left in the ramp */
+};
+
+/*----------------------------------------------------------------------------
+ *         Global functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Convert samples between formats and channel counts
+ *
+ * Narrowing conversions are rounded and saturated.  A mono source is copied
+ * to every destination channel, a multichannel source is averaged into a
+ * mono destination.
+ *
+ * \param dst          Destination buffer (must not overlap src)
+ * \param dst_format   Destination sample format
+ * \param dst_channels Destination channels per frame
+ * \param src          Source buffer
+ * \param src_format   Source sample format
+ * \param src_channels Source channels per frame
+ * \param frames       Number of frames
+ * \return 0 on success, -EINVAL if the channel counts are neither equal nor
+ * one of them 1.
+ */
+extern int audio_dsp_convert(void* dst, enum _audio_dsp_format dst_format,
+		uint8_t dst_channels, const void* src,
+		enum _audio_dsp_format src_format, uint8_t src_channels,
+		uint32_t frames);
+
+/**
+ * \brief Add a 16-bit stream into another one, with saturation
+ *
+ * \param dst      Accumulated stream, updated in place
+ * \param src      Added stream
+ * \param samples  Number of samples (frames times channels)
+ */
+extern void audio_dsp_add_s16(int16_t* dst, const int16_t* src,
+		uint32_t samples);
+
+/**
+ * \brief Mix 16-bit streams with individual gains, with saturation
+ *
+ * Products are accumulated on 32 bits and saturated once, so streams
+ * cancelling each other do not clip.
+ *
+ * \param dst      Destination stream, may be one of the sources
+ * \param src      Source streams
+ * \param gain     Q15 gain of each stream (AUDIO_DSP_UNITY for 0 dB), or
+ *                 NULL for unity gains
+ * \param count    Number of streams
+ * \param samples  Number of samples (frames times channels)
+ */
+extern void audio_dsp_mix_s16(int16_t* dst, const int16_t* const* src,
+		const uint16_t* gain, uint8_t count, uint32_t samples);
+
+/**
+ * \brief Mix 32-bit streams (S32 or S24_32) with individual gains, with
+ * saturation to the 32-bit range
+ *
+ * \see audio_dsp_mix_s16()
+ */
+extern void audio_dsp_mix_s32(int32_t* dst, const int32_t* const* src,
+		const uint16_t* gain, uint8_t count, uint32_t samples);
+
+/**
+ * \brief Convert a gain in 1/256 dB (USB Audio volume unit) to Q15
+ *
+ * \param db  Gain in 1/256 dB, positive values are limited to 0 dB
+ * \return Q15 gain, AUDIO_DSP_UNITY for 0 dB, 0 below -90 dB
+ */
+extern uint16_t audio_dsp_db_to_gain(int16_t db);
+
+/**
+ * \brief Initialize a volume to a fixed gain
+ *
+ * \param vol   Volume state
+ * \param gain  Q15 gain, at most AUDIO_DSP_UNITY
+ */
+extern void audio_dsp_volume_init(struct _audio_dsp_volume* vol,
+		uint16_t gain);
+
+/**
+ * \brief Start a linear ramp to a new gain
+ *
+ * \param vol     Volume state
+ * \param gain    Q15 target gain, at most AUDIO_DSP_UNITY
+ * \param frames  Duration of the ramp in frames, 0 to apply it at once
+ */
+extern void audio_dsp_volume_set(struct _audio_dsp_volume* vol,
+		uint16_t gain, uint32_t frames);
+
+/**
+ * \brief Apply a volume to interleaved 16-bit frames in place
+ *
+ * The gain is updated every frame during a ramp.  Constant gains use the
+ * vector kernel, unity gain leaves the buffer untouched.
+ */
+extern void audio_dsp_volume_apply_s16(struct _audio_dsp_volume* vol,
+		int16_t* buf, uint32_t frames, uint8_t channels);
+
+/**
+ * \brief Apply a volume to interleaved 32-bit frames in place
+ *
+ * \see audio_dsp_volume_apply_s16()
+ */
+extern void audio_dsp_volume_apply_s32(struct _audio_dsp_volume* vol,
+		int32_t* buf, uint32_t frames, uint8_t channels);
+
+/**
+ * \brief Initialize a resampler
+ *
+ * The filter cut-off follows the lower of the two rates.  The filter is
+ * computed here, in floating point: do not call from an interrupt handler.
+ *
+ * \param rs        Resampler state
+ * \param channels  Interleaved channels (1 to AUDIO_DSP_MAX_CHANNELS)
+ * \param in_rate   Input sample rate in Hz
+ * \param out_rate  Output sample rate in Hz
+ * \return 0 on success, -EINVAL on unsupported parameters (ratio above 4)
+ */
+extern int audio_dsp_resampler_init(struct _audio_dsp_resampler* rs,
+		uint8_t channels, uint32_t in_rate, uint32_t out_rate);
+
+/**
+ * \brief Drop the buffered input, the next output starts from silence
+ */
+extern void audio_dsp_resampler_reset(struct _audio_dsp_resampler* rs);
+
+/**
+ * \brief Correct the ratio for a clock drift
+ *
+ * \param rs     Resampler state
+ * \param drift  Input clock drift versus the nominal input rate, in parts
+ *               per billion (positive when the input is faster, so more
+ *               input frames are consumed per output frame)
+ */
+extern void audio_dsp_resampler_set_drift(struct _audio_dsp_resampler* rs,
+		int32_t drift);
+
+/**
+ * \brief Resample interleaved 16-bit frames
+ *
+ * Input frames are consumed until the output buffer is full or the input is
+ * exhausted; the filter delay (CONFIG_AUDIO_DSP_RS_TAPS / 2 input frames) is
+ * kept between calls.
+ *
+ * \param rs          Resampler state
+ * \param in          Input frames
+ * \param in_frames   Number of input frames
+ * \param consumed    Set to the number of input frames consumed
+ * \param out         Output frames
+ * \param out_frames  Room in the output buffer, in frames
+ * \return Number of output frames produced
+ */
+extern uint32_t audio_dsp_resample_s16(struct _audio_dsp_resampler* rs,
+		const int16_t* in, uint32_t in_frames, uint32_t* consumed,
+		int16_t* out, uint32_t out_frames);
+
+#endif /* AUDIO_DSP_H_ */
@@ -0,0 +1,315 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+#include "fastmem.h"
+
+/*----------------------------------------------------------------------------
+ *         Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Copies shorter than this are done byte per byte */
+#define FASTMEM_SMALL 16
+
+#if defined(CONFIG_ARCH_ARMV7A) && defined(__GNUC__)
+#define FASTMEM_ARM_BURST
+#endif
+
+/** Size of the bulk copy bursts, in bytes */
+#if defined(FASTMEM_ARM_BURST) && defined(CONFIG_HAVE_NEON)
+#define FASTMEM_BURST 64
+#else
+#define FASTMEM_BURST 32
+#endif
+
+/** Distance of the cache preload ahead of the source, in bytes */
+#define FASTMEM_PRELOAD 128
+
+/* words are accessed through a type allowed to alias the byte buffers */
+#ifdef __GNUC__
+typedef uint32_t __attribute__((__may_alias__)) word_t;
+#else
+typedef uint32_t word_t;
+#endif
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Copy 'len' bytes, multiple of FASTMEM_BURST, between word aligned
+ * buffers
+ */
+static void _copy_bursts(uint8_t* d, const uint8_t* s, size_t len)
+{
+#if defined(FASTMEM_ARM_BURST) && defined(CONFIG_HAVE_NEON)
+	asm volatile(
+		".fpu neon-vfpv4\n"
+		"1:\n"
+		"pld [%1, %3]\n"
+		"vld1.8 {d0-d3}, [%1]!\n"
+		"vld1.8 {d4-d7}, [%1]!\n"
+		"subs %2, %2, #64\n"
+		"vst1.8 {d0-d3}, [%0]!\n"
+		"vst1.8 {d4-d7}, [%0]!\n"
+		"bgt 1b\n"
+		: "+r"(d), "+r"(s), "+r"(len)
+		: "I"(FASTMEM_PRELOAD)
+		: "d0", "d1", "d2", "d3", "d4", "d5", "d6", "d7", "cc", "memory");
+#elif defined(FASTMEM_ARM_BURST)
+	asm volatile(
+		"1:\n"
+		"pld [%1, %3]\n"
+		"ldmia %1!, {r3, r4, r5, r6, r8, r10, r12, lr}\n"
+		"subs %2, %2, #32\n"
+		"stmia %0!, {r3, r4, r5, r6, r8, r10, r12, lr}\n"
+		"bgt 1b\n"
+		: "+r"(d), "+r"(s), "+r"(len)
+		: "I"(FASTMEM_PRELOAD)
+		: "r3", "r4", "r5", "r6", "r8", "r10", "r12", "lr", "cc", "memory");
+#else
+	word_t* wd = (word_t*)d;
+	const word_t* ws = (const word_t*)s;
+
+	for (; len; len -= FASTMEM_BURST) {
+		wd[0] = ws[0];
+		wd[1] = ws[1];
+		wd[2] = ws[2];
+		wd[3] = ws[3];
+		wd[4] = ws[4];
+		wd[5] = ws[5];
+		wd[6] = ws[6];
+		wd[7] = ws[7];
+		wd += 8;
+		ws += 8;
+	}
+#endif
+}
+
+/**
+ * \brief Fill 'len' bytes, multiple of 32, of a word aligned buffer
+ */
+static void _set_bursts(uint8_t* d, uint32_t pattern, size_t len)
+{
+#ifdef FASTMEM_ARM_BURST
+	asm volatile(
+		"mov r3, %2\n"
+		"mov r4, %2\n"
+		"mov r5, %2\n"
+		"mov r6, %2\n"
+		"mov r8, %2\n"
+		"mov r10, %2\n"
+		"mov r12, %2\n"
+		"mov lr, %2\n"
+		"1:\n"
+		"subs %1, %1, #32\n"
+		"stmia %0!, {r3, r4, r5, r6, r8, r10, r12, lr}\n"
+		"bgt 1b\n"
+		: "+r"(d), "+r"(len)
+		: "r"(pattern)
+		: "r3", "r4", "r5", "r6", "r8", "r10", "r12", "lr", "cc", "memory");
+#else
+	word_t* wd = (word_t*)d;
+
+	for (; len; len -= 32) {
+		wd[0] = pattern;
+		wd[1] = pattern;
+		wd[2] = pattern;
+		wd[3] = pattern;
+		wd[4] = pattern;
+		wd[5] = pattern;
+		wd[6] = pattern;
+		wd[7] = pattern;
+		wd += 8;
+	}
+#endif
+}
+
+/**
+ * \brief Copy 'words' words to a word aligned destination from a source
+ * which is not word aligned
+ *
+ * Only aligned words are loaded from the source, each destination word is
+ * merged from two of them (little-endian).  The loads never go beyond the
+ * word holding the last source byte.
+ */
+static void _copy_shifted(uint8_t* d, const uint8_t* s, size_t words)
+{
+	uint32_t off = (uintptr_t)s & 3;
+	uint32_t rshift = off * 8;
+	uint32_t lshift = 32 - rshift;
+	word_t* wd = (word_t*)d;
+	const word_t* ws = (const word_t*)(s - off);
+	uint32_t lo = *ws++;
+	uint32_t hi;
+
+	while (words--) {
+		hi = *ws++;
+		*wd++ = (lo >> rshift) | (hi << lshift);
+		lo = hi;
+	}
+}
+
+/*----------------------------------------------------------------------------
+ *         Exported functions
+ *----------------------------------------------------------------------------*/
+
+void* fast_memcpy(void* dst, const void* src, size_t len)
+{
+	uint8_t* d = (uint8_t*)dst;
+	const uint8_t* s = (const uint8_t*)src;
+	size_t bulk;
+
+	if (len >= FASTMEM_SMALL) {
+		/* head: align destination */
+		while ((uintptr_t)d & 3) {
+			*d++ = *s++;
+			len--;
+		}
+
+		if (((uintptr_t)s & 3) == 0) {
+			bulk = len & ~(size_t)(FASTMEM_BURST - 1);
+			if (bulk) {
+				_copy_bursts(d, s, bulk);
+				d += bulk;
+				s += bulk;
+				len -= bulk;
+			}
+			for (; len >= 4; len -= 4) {
+				*(word_t*)d = *(const word_t*)s;
+				d += 4;
+				s += 4;
+			}
+		} else {
+			bulk = len & ~(size_t)3;
+			_copy_shifted(d, s, bulk / 4);
+			d += bulk;
+			s += bulk;
+			len -= bulk;
+		}
+	}
+
+	/* tail */
+	while (len--)
+		*d++ = *s++;
+
+	return dst;
+}
+
+void* fast_memset(void* dst, int c, size_t len)
+{
+	uint8_t* d = (uint8_t*)dst;
+	uint32_t pattern = (uint8_t)c;
+	size_t bulk;
+
+	if (len >= FASTMEM_SMALL) {
+		pattern |= pattern << 8;
+		pattern |= pattern << 16;
+
+		while ((uintptr_t)d & 3) {
+			*d++ = (uint8_t)c;
+			len--;
+		}
+
+		bulk = len & ~(size_t)31;
+		if (bulk) {
+			_set_bursts(d, pattern, bulk);
+			d += bulk;
+			len -= bulk;
+		}
+		for (; len >= 4; len -= 4) {
+			*(word_t*)d = pattern;
+			d += 4;
+		}
+	}
+
+	while (len--)
+		*d++ = (uint8_t)c;
+
+	return dst;
+}
+
+void* fast_memset32(void* dst, uint32_t pattern, size_t len)
+{
+	uint8_t* d = (uint8_t*)dst;
+	size_t bulk;
+
+	bulk = len & ~(size_t)31;
+	if (bulk) {
+		_set_bursts(d, pattern, bulk);
+		d += bulk;
+		len -= bulk;
+	}
+	for (; len >= 4; len -= 4) {
+		*(word_t*)d = pattern;
+		d += 4;
+	}
+	for (; len; len--) {
+		*d++ = (uint8_t)pattern;
+		pattern >>= 8;
+	}
+
+	return dst;
+}
+
+void* fast_memmove(void* dst, const void* src, size_t len)
+{
+	uint8_t* d = (uint8_t*)dst;
+	const uint8_t* s = (const uint8_t*)src;
+
+	/* forward copy is safe unless the destination starts inside the
+	 * source */
+	if (d <= s || d >= s + len)
+		return fast_memcpy(dst, src, len);
+
+	d += len;
+	s += len;
+
+	if ((((uintptr_t)d ^ (uintptr_t)s) & 3) == 0 && len >= FASTMEM_SMALL) {
+		while ((uintptr_t)d & 3) {
+			*--d = *--s;
+			len--;
+		}
+		for (; len >= 4; len -= 4) {
+			d -= 4;
+			s -= 4;
+			*(word_t*)d = *(const word_t*)s;
+		}
+	}
+
+	while (len--)
+		*--d = *--s;
+
+	return dst;
+}
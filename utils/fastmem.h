@@ -0,0 +1,98 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef FASTMEM_H_
+#define FASTMEM_H_
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *         Global functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Copy memory, optimized for large and cache-resident buffers
+ *
+ * The head is copied byte per byte until the destination is word aligned.
+ * When the source then is word aligned as well, the bulk is copied in
+ * 32-byte LDM/STM bursts (64-byte NEON bursts when CONFIG_HAVE_NEON is
+ * defined) with a cache preload ahead of the source, otherwise words are
+ * rebuilt from aligned loads and shifts.  Small copies go straight to a byte
+ * loop.  On other architectures or compilers, a portable C implementation of
+ * the same algorithm is used.
+ *
+ * \param dst  Destination buffer
+ * \param src  Source buffer, must not overlap dst
+ * \param len  Number of bytes to copy
+ * \return dst
+ */
+extern void* fast_memcpy(void* dst, const void* src, size_t len);
+
+/**
+ * \brief Fill memory, with word and burst stores for the bulk
+ *
+ * \param dst  Destination buffer
+ * \param c    Value of the bytes (converted to unsigned char)
+ * \param len  Number of bytes to set
+ * \return dst
+ */
+extern void* fast_memset(void* dst, int c, size_t len);
+
+/**
+ * \brief Fill memory with a 32-bit pattern, with burst stores for the bulk
+ *
+ * Used to fill pixel rows, where the pattern holds one or more pixels.
+ *
+ * \param dst      Destination buffer, word aligned
+ * \param pattern  Value of the words (stored little-endian)
+ * \param len      Number of bytes to set, a trailing partial word gets the
+ *                 first bytes of the pattern
+ * \return dst
+ */
+extern void* fast_memset32(void* dst, uint32_t pattern, size_t len);
+
+/**
+ * \brief Copy memory, handling overlapping buffers
+ *
+ * Forward copies use fast_memcpy(), backward copies are done per word when
+ * source and destination have the same alignment.
+ *
+ * \param dst  Destination buffer
+ * \param src  Source buffer
+ * \param len  Number of bytes to copy
+ * \return dst
+ */
+extern void* fast_memmove(void* dst, const void* src, size_t len);
+
+#endif /* FASTMEM_H_ */
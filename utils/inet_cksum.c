@@ -0,0 +1,415 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file
+ *
+ * Internet checksum (RFC 1071) used by the uIP and lwIP ports.
+ *
+ * The data is summed 32 bits at a time into a 64-bit accumulator, the
+ * carries being folded once at the end instead of after each addition.
+ * Aligned blocks are processed by unrolled LDM/ADCS loops on ARMv5TE and
+ * ARMv7-A, and by NEON pairwise accumulations on Cortex-A with NEON.
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "inet_cksum.h"
+
+/*----------------------------------------------------------------------------
+ *         Local definitions
+ *----------------------------------------------------------------------------*/
+
+#if defined(__GNUC__) && \
+	(defined(CONFIG_ARCH_ARMV7A) || defined(CONFIG_ARCH_ARMV5TE))
+#define INET_CKSUM_ARM
+#endif
+
+#if defined(INET_CKSUM_ARM) && defined(CONFIG_ARCH_ARMV7A) && \
+	defined(CONFIG_HAVE_NEON)
+#define INET_CKSUM_NEON
+#endif
+
+/** Bytes processed per iteration of the block loops */
+#define BLOCK_SIZE 32
+
+/** Smaller blocks are not worth the NEON setup and use the LDM loops */
+#define NEON_MIN_SIZE 256
+
+/** Bytes per NEON pass, so that the 32-bit lanes cannot overflow */
+#define NEON_MAX_SIZE 65536
+
+/* Value of a byte as the first or the second byte of a 16-bit word */
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define FIRST_BYTE(b)  ((uint32_t)(b) << 8)
+#define SECOND_BYTE(b) ((uint32_t)(b))
+#else
+#define FIRST_BYTE(b)  ((uint32_t)(b))
+#define SECOND_BYTE(b) ((uint32_t)(b) << 8)
+#endif
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+static inline uint16_t _fold(uint64_t acc)
+{
+	uint32_t sum;
+
+	acc = (acc & 0xffffffffu) + (acc >> 32);
+	acc = (acc & 0xffffffffu) + (acc >> 32);
+	sum = (uint32_t)acc;
+	sum = (sum & 0xffff) + (sum >> 16);
+	sum = (sum & 0xffff) + (sum >> 16);
+	return (uint16_t)sum;
+}
+
+static inline uint16_t _swap16(uint16_t x)
+{
+	return (uint16_t)((x << 8) | (x >> 8));
+}
+
+#if defined(INET_CKSUM_NEON)
+
+/**
+ * \brief Sum word aligned blocks with NEON, 16-bit lanes are accumulated
+ * pairwise into 32-bit lanes (bytes: multiple of BLOCK_SIZE, at most
+ * NEON_MAX_SIZE)
+ */
+static uint64_t _sum_blocks_neon(const uint32_t* p, uint32_t bytes)
+{
+	uint32_t lo, hi;
+
+	asm volatile(
+		".fpu neon-vfpv4\n"
+		"vmov.i32 q8, #0\n"
+		"vmov.i32 q9, #0\n"
+		"1:\n"
+		"pld [%[p], #128]\n"
+		"vld1.32 {d0-d3}, [%[p]]!\n"
+		"vpadal.u16 q8, q0\n"
+		"vpadal.u16 q9, q1\n"
+		"subs %[n], %[n], #32\n"
+		"bgt 1b\n"
+		"vadd.i32 q8, q8, q9\n"
+		"vpaddl.u32 q8, q8\n"
+		"vadd.i64 d16, d16, d17\n"
+		"vmov %[lo], %[hi], d16\n"
+		: [p] "+r"(p), [n] "+r"(bytes), [lo] "=r"(lo), [hi] "=r"(hi)
+		:
+		: "d0", "d1", "d2", "d3", "d16", "d17", "d18", "d19",
+		  "cc", "memory");
+	return ((uint64_t)hi << 32) | lo;
+}
+
+/**
+ * \brief Copy and sum word aligned blocks with NEON (same constraints as
+ * _sum_blocks_neon)
+ */
+static uint64_t _copy_blocks_neon(uint32_t* d, const uint32_t* s,
+		uint32_t bytes)
+{
+	uint32_t lo, hi;
+
+	asm volatile(
+		".fpu neon-vfpv4\n"
+		"vmov.i32 q8, #0\n"
+		"vmov.i32 q9, #0\n"
+		"1:\n"
+		"pld [%[s], #128]\n"
+		"vld1.32 {d0-d3}, [%[s]]!\n"
+		"vst1.32 {d0-d3}, [%[d]]!\n"
+		"vpadal.u16 q8, q0\n"
+		"vpadal.u16 q9, q1\n"
+		"subs %[n], %[n], #32\n"
+		"bgt 1b\n"
+		"vadd.i32 q8, q8, q9\n"
+		"vpaddl.u32 q8, q8\n"
+		"vadd.i64 d16, d16, d17\n"
+		"vmov %[lo], %[hi], d16\n"
+		: [d] "+r"(d), [s] "+r"(s), [n] "+r"(bytes),
+		  [lo] "=r"(lo), [hi] "=r"(hi)
+		:
+		: "d0", "d1", "d2", "d3", "d16", "d17", "d18", "d19",
+		  "cc", "memory");
+	return ((uint64_t)hi << 32) | lo;
+}
+
+#endif /* INET_CKSUM_NEON */
+
+/**
+ * \brief Sum word aligned blocks (bytes: non-zero multiple of BLOCK_SIZE)
+ */
+static uint64_t _sum_blocks(const uint32_t* p, size_t bytes)
+{
+#if defined(INET_CKSUM_NEON)
+	if (bytes >= NEON_MIN_SIZE) {
+		uint64_t acc = 0;
+		while (bytes) {
+			uint32_t n = bytes < NEON_MAX_SIZE ? bytes : NEON_MAX_SIZE;
+			acc += _sum_blocks_neon(p, n);
+			p += n / 4;
+			bytes -= n;
+		}
+		return acc;
+	}
+#endif
+#if defined(INET_CKSUM_ARM)
+	/* ADCS chain over two LDMs of 4 words, the carry flag is kept across
+	 * iterations (TEQ does not modify it) and added once at the end */
+	const uint32_t* end = p + bytes / 4;
+	uint32_t sum, carry;
+
+	asm volatile(
+		"mov %[c], #0\n"
+		"adds %[sum], %[c], #0\n"
+		"1:\n"
+#ifdef CONFIG_ARCH_ARMV7A
+		"pld [%[p], #64]\n"
+#endif
+		"ldmia %[p]!, {r3, r4, r5, r6}\n"
+		"adcs %[sum], %[sum], r3\n"
+		"adcs %[sum], %[sum], r4\n"
+		"adcs %[sum], %[sum], r5\n"
+		"adcs %[sum], %[sum], r6\n"
+		"ldmia %[p]!, {r3, r4, r5, r6}\n"
+		"adcs %[sum], %[sum], r3\n"
+		"adcs %[sum], %[sum], r4\n"
+		"adcs %[sum], %[sum], r5\n"
+		"adcs %[sum], %[sum], r6\n"
+		"teq %[p], %[end]\n"
+		"bne 1b\n"
+		"adc %[c], %[c], #0\n"
+		: [p] "+r"(p), [sum] "=&r"(sum), [c] "=&r"(carry)
+		: [end] "r"(end)
+		: "r3", "r4", "r5", "r6", "cc", "memory");
+	return ((uint64_t)carry << 32) | sum;
+#else
+	const uint32_t* end = p + bytes / 4;
+	uint64_t acc = 0;
+
+	while (p < end) {
+		acc += p[0];
+		acc += p[1];
+		acc += p[2];
+		acc += p[3];
+		acc += p[4];
+		acc += p[5];
+		acc += p[6];
+		acc += p[7];
+		p += 8;
+	}
+	return acc;
+#endif
+}
+
+/**
+ * \brief Copy and sum word aligned blocks (same constraints as _sum_blocks)
+ */
+static uint64_t _copy_blocks(uint32_t* d, const uint32_t* s, size_t bytes)
+{
+#if defined(INET_CKSUM_NEON)
+	if (bytes >= NEON_MIN_SIZE) {
+		uint64_t acc = 0;
+		while (bytes) {
+			uint32_t n = bytes < NEON_MAX_SIZE ? bytes : NEON_MAX_SIZE;
+			acc += _copy_blocks_neon(d, s, n);
+			d += n / 4;
+			s += n / 4;
+			bytes -= n;
+		}
+		return acc;
+	}
+#endif
+#if defined(INET_CKSUM_ARM)
+	const uint32_t* end = s + bytes / 4;
+	uint32_t sum, carry;
+
+	asm volatile(
+		"mov %[c], #0\n"
+		"adds %[sum], %[c], #0\n"
+		"1:\n"
+#ifdef CONFIG_ARCH_ARMV7A
+		"pld [%[s], #64]\n"
+#endif
+		"ldmia %[s]!, {r3, r4, r5, r6}\n"
+		"stmia %[d]!, {r3, r4, r5, r6}\n"
+		"adcs %[sum], %[sum], r3\n"
+		"adcs %[sum], %[sum], r4\n"
+		"adcs %[sum], %[sum], r5\n"
+		"adcs %[sum], %[sum], r6\n"
+		"ldmia %[s]!, {r3, r4, r5, r6}\n"
+		"stmia %[d]!, {r3, r4, r5, r6}\n"
+		"adcs %[sum], %[sum], r3\n"
+		"adcs %[sum], %[sum], r4\n"
+		"adcs %[sum], %[sum], r5\n"
+		"adcs %[sum], %[sum], r6\n"
+		"teq %[s], %[end]\n"
+		"bne 1b\n"
+		"adc %[c], %[c], #0\n"
+		: [d] "+r"(d), [s] "+r"(s), [sum] "=&r"(sum), [c] "=&r"(carry)
+		: [end] "r"(end)
+		: "r3", "r4", "r5", "r6", "cc", "memory");
+	return ((uint64_t)carry << 32) | sum;
+#else
+	const uint32_t* end = s + bytes / 4;
+	uint64_t acc = 0;
+
+	while (s < end) {
+		uint32_t w0 = s[0], w1 = s[1], w2 = s[2], w3 = s[3];
+		d[0] = w0;
+		d[1] = w1;
+		d[2] = w2;
+		d[3] = w3;
+		acc += w0;
+		acc += w1;
+		acc += w2;
+		acc += w3;
+		s += 4;
+		d += 4;
+	}
+	return acc;
+#endif
+}
+
+/*----------------------------------------------------------------------------
+ *         Global functions
+ *----------------------------------------------------------------------------*/
+
+uint16_t inet_cksum_add(uint16_t sum, const void* data, size_t len)
+{
+	const uint8_t* p = (const uint8_t*)data;
+	bool odd = ((uintptr_t)p & 1) != 0;
+	uint64_t acc = 0;
+	size_t n;
+	uint16_t res;
+
+	/* The words are summed at even addresses: when the buffer starts at an
+	 * odd address, its bytes are summed swapped and the result is swapped
+	 * back at the end */
+	if (odd && len) {
+		acc += SECOND_BYTE(*p);
+		p++;
+		len--;
+	}
+	if (((uintptr_t)p & 2) && len >= 2) {
+		acc += *(const uint16_t*)p;
+		p += 2;
+		len -= 2;
+	}
+
+	n = len & ~(size_t)(BLOCK_SIZE - 1);
+	if (n) {
+		acc += _sum_blocks((const uint32_t*)p, n);
+		p += n;
+		len -= n;
+	}
+
+	for (; len >= 4; p += 4, len -= 4)
+		acc += *(const uint32_t*)p;
+	if (len >= 2) {
+		acc += *(const uint16_t*)p;
+		p += 2;
+		len -= 2;
+	}
+	if (len)
+		acc += FIRST_BYTE(*p);
+
+	res = _fold(acc);
+	if (odd)
+		res = _swap16(res);
+	return _fold((uint64_t)res + sum);
+}
+
+uint16_t inet_cksum_copy(void* dst, const void* src, size_t len)
+{
+	uint8_t* d = (uint8_t*)dst;
+	const uint8_t* s = (const uint8_t*)src;
+	bool odd = ((uintptr_t)s & 1) != 0;
+	uint64_t acc = 0;
+	size_t n;
+	uint16_t res;
+
+	/* The buffers cannot be both word aligned, copy then sum the
+	 * destination while it is in cache */
+	if (((uintptr_t)d ^ (uintptr_t)s) & 3) {
+		memcpy(dst, src, len);
+		return inet_cksum_add(0, dst, len);
+	}
+
+	if (odd && len) {
+		*d = *s;
+		acc += SECOND_BYTE(*s);
+		d++;
+		s++;
+		len--;
+	}
+	if (((uintptr_t)s & 2) && len >= 2) {
+		uint16_t w = *(const uint16_t*)s;
+		*(uint16_t*)d = w;
+		acc += w;
+		d += 2;
+		s += 2;
+		len -= 2;
+	}
+
+	n = len & ~(size_t)(BLOCK_SIZE - 1);
+	if (n) {
+		acc += _copy_blocks((uint32_t*)d, (const uint32_t*)s, n);
+		d += n;
+		s += n;
+		len -= n;
+	}
+
+	for (; len >= 4; d += 4, s += 4, len -= 4) {
+		uint32_t w = *(const uint32_t*)s;
+		*(uint32_t*)d = w;
+		acc += w;
+	}
+	if (len >= 2) {
+		uint16_t w = *(const uint16_t*)s;
+		*(uint16_t*)d = w;
+		acc += w;
+		d += 2;
+		s += 2;
+		len -= 2;
+	}
+	if (len) {
+		*d = *s;
+		acc += FIRST_BYTE(*s);
+	}
+
+	res = _fold(acc);
+	return odd ? _swap16(res) : res;
+}
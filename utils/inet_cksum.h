@@ -0,0 +1,73 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef INET_CKSUM_H_
+#define INET_CKSUM_H_
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *         Global functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Add a buffer to an Internet (RFC 1071) ones' complement sum
+ *
+ * The buffer is summed as 16-bit words in memory byte order, starting with
+ * its first byte whatever its alignment, an odd trailing byte is padded with
+ * zero.  The result is not complemented: ~result is the checksum to store in
+ * a protocol header.
+ *
+ * \param sum   Sum of the previous buffers (0 for the first one), in memory
+ *              byte order
+ * \param data  Buffer, no alignment needed
+ * \param len   Size of the buffer in bytes
+ * \return Updated ones' complement sum, in memory byte order
+ */
+extern uint16_t inet_cksum_add(uint16_t sum, const void* data, size_t len);
+
+/**
+ * \brief Copy a buffer and compute its ones' complement sum in the same pass
+ *
+ * Same as memcpy() followed by inet_cksum_add(0, dst, len), the data is only
+ * read once.  Buffers must not overlap.
+ *
+ * \param dst  Destination buffer
+ * \param src  Source buffer
+ * \param len  Size of the buffers in bytes
+ * \return Ones' complement sum of the data, in memory byte order
+ */
+extern uint16_t inet_cksum_copy(void* dst, const void* src, size_t len);
+
+#endif /* INET_CKSUM_H_ */
@@ -39,6 +39,22 @@ struct _buffer
 	uint32_t attr; /* Attribute on buffer (depending of the peripheral) */
 };
 
+/* Attributes of struct _buffer, kept with it so that portable code handling
+ * transfers does not depend on the bus drivers */
+enum _bus_buf_attr {
+	BUS_BUF_ATTR_RX                = 0x0001,
+	BUS_BUF_ATTR_TX                = 0x0002,
+
+#ifdef CONFIG_HAVE_SPI_BUS
+	BUS_SPI_BUF_ATTR_RELEASE_CS        = 0x0800,
+#endif
+
+#ifdef CONFIG_HAVE_I2C_BUS
+	BUS_I2C_BUF_ATTR_START             = 0x1000,
+	BUS_I2C_BUF_ATTR_STOP              = 0x2000,
+#endif
+};
+
 static inline void writeb(volatile void* reg, uint8_t value)
 {
 	*(volatile uint8_t*)reg = value;
@@ -0,0 +1,371 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "compiler.h"
+#include "intmath.h"
+#include "pdm_decim.h"
+
+/*----------------------------------------------------------------------------
+ *         Local definitions
+ *----------------------------------------------------------------------------*/
+
+#if defined(CONFIG_ARCH_ARMV7A) && defined(__GNUC__)
+#define PDM_DECIM_ARM
+#endif
+
+#if defined(PDM_DECIM_ARM) && defined(CONFIG_HAVE_NEON)
+#define PDM_DECIM_NEON
+#endif
+
+/** CIC filter: order and decimation ratio */
+#define CIC_ORDER 5
+#define CIC_RATIO 16
+
+/** CIC filter: impulse response length */
+#define CIC_TAPS (CIC_ORDER * (CIC_RATIO - 1) + 1)
+
+/** CIC filter: DC gain is 2^CIC_GAIN_BITS, scaled to Q15 */
+#define CIC_GAIN_BITS 20
+#define CIC_SHIFT (CIC_GAIN_BITS - 15)
+
+/** Droop compensation [-a, 1 + 2a, -a], Q15 */
+#define COMP_A 688
+
+/** DC blocking filter pole is 1 - 2^-DC_SHIFT */
+#define DC_SHIFT 10
+
+#define HB1_SIDE ((PDM_DECIM_HB1_TAPS + 1) / 2)
+#define HB2_SIDE ((PDM_DECIM_HB2_TAPS + 1) / 2)
+
+#define CIC_HIST (PDM_DECIM_CIC_BYTES - 2)
+#define HB1_HIST (PDM_DECIM_HB1_TAPS - 1)
+#define HB2_HIST (PDM_DECIM_HB2_TAPS - 1)
+
+/*----------------------------------------------------------------------------
+ *         Local constants
+ *----------------------------------------------------------------------------*/
+
+/** First half-band filter, Kaiser window (beta 9.4), Q15 coefficients of
+ * the even taps, the central tap is 0.5.  Pass band 0.1125, stop band
+ * 0.3875 of the input rate. */
+static const int16_t hb1_coefs[HB1_SIDE] = {
+	-1, 28, -199, 793, -2484, 10055, 10055, -2484,
+	793, -199, 28, -1
+};
+
+/** Second half-band filter, Kaiser window (beta 9), Q15 coefficients of
+ * the even taps, the central tap is 0.5.  Pass band 0.2, stop band 0.3 of
+ * the input rate. */
+static const int16_t hb2_coefs[HB2_SIDE] __attribute__((aligned(8))) = {
+	0, 2, -6, 14, -29, 54, -94, 154,
+	-242, 368, -547, 805, -1197, 1867, -3341, 10384,
+	10384, -3341, 1867, -1197, 805, -547, 368, -242,
+	154, -94, 54, -29, 14, -6, 2, 0
+};
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+static inline int16_t _sat16(int32_t x)
+{
+#ifdef PDM_DECIM_ARM
+	asm("ssat %0, #16, %1" : "=r"(x) : "r"(x));
+	return (int16_t)x;
+#else
+	if (x > INT16_MAX)
+		return INT16_MAX;
+	if (x < INT16_MIN)
+		return INT16_MIN;
+	return (int16_t)x;
+#endif
+}
+
+/**
+ * \brief CIC stage: 4 outputs per PDM sample
+ * \param table  Lookup tables of the decimator
+ * \param bits   CIC_HIST bytes of history followed by the new bytes
+ * \param out    Output, 2 per new byte
+ * \param count  Number of outputs
+ */
+static void _cic(const int32_t (*table)[256], const uint8_t* bits,
+		int16_t* out, uint32_t count)
+{
+	const int32_t *t0 = table[0], *t1 = table[1], *t2 = table[2],
+		*t3 = table[3], *t4 = table[4], *t5 = table[5],
+		*t6 = table[6], *t7 = table[7], *t8 = table[8],
+		*t9 = table[9];
+	uint32_t i;
+
+	for (i = 0; i < count; i++, bits += 2) {
+		int32_t s = t0[bits[0]] + t1[bits[1]] + t2[bits[2]] +
+			t3[bits[3]] + t4[bits[4]] + t5[bits[5]] +
+			t6[bits[6]] + t7[bits[7]] + t8[bits[8]] +
+			t9[bits[9]];
+		out[i] = _sat16((s + (1 << (CIC_SHIFT - 1))) >> CIC_SHIFT);
+	}
+}
+
+/**
+ * \brief First half-band stage, symmetric form
+ * \param x      HB1_HIST samples of history followed by 2 * count samples
+ * \param out    Output
+ * \param count  Number of outputs
+ */
+static void _hb1(const int16_t* x, int16_t* out, uint32_t count)
+{
+	uint32_t i;
+	int j;
+
+	for (i = 0; i < count; i++, x += 2) {
+		const int16_t* p = x + 1;
+		int32_t acc = (p[HB1_HIST / 2] << 14) + 0x4000;
+		for (j = 0; j < HB1_SIDE / 2; j++)
+			acc += hb1_coefs[j] * (p[2 * j] + p[HB1_HIST - 2 * j]);
+		out[i] = _sat16(acc >> 15);
+	}
+}
+
+/**
+ * \brief Second half-band stage
+ * \param x      HB2_HIST samples of history followed by 2 * count samples,
+ *               and one more readable sample
+ * \param out    Output
+ * \param count  Number of outputs
+ */
+static void _hb2(const int16_t* x, int16_t* out, uint32_t count)
+{
+	uint32_t i;
+
+	for (i = 0; i < count; i++, x += 2) {
+		const int16_t* p = x + 1;
+		int32_t acc;
+#if defined(PDM_DECIM_NEON)
+		/* vld2 deinterleaves the even taps into q0 */
+		const int16_t* h = hb2_coefs;
+		uint32_t n = HB2_SIDE;
+
+		asm volatile(
+			".fpu neon-vfpv4\n"
+			"vmov.i32 q3, #0\n"
+			"1:\n"
+			"vld2.16 {d0-d3}, [%[p]]!\n"
+			"vld1.16 {d4-d5}, [%[h]]!\n"
+			"vmlal.s16 q3, d0, d4\n"
+			"vmlal.s16 q3, d1, d5\n"
+			"subs %[n], %[n], #8\n"
+			"bgt 1b\n"
+			"vpadd.i32 d6, d6, d7\n"
+			"vpadd.i32 d6, d6, d6\n"
+			"vmov.32 %[acc], d6[0]\n"
+			: [p] "+r"(p), [h] "+r"(h), [n] "+r"(n), [acc] "=&r"(acc)
+			:
+			: "d0", "d1", "d2", "d3", "d4", "d5", "d6", "d7",
+			  "cc", "memory");
+		acc += (x[1 + HB2_HIST / 2] << 14) + 0x4000;
+#else
+		int j;
+
+		acc = (p[HB2_HIST / 2] << 14) + 0x4000;
+		for (j = 0; j < HB2_SIDE / 2; j++)
+			acc += hb2_coefs[j] * (p[2 * j] + p[HB2_HIST - 2 * j]);
+#endif
+		out[i] = _sat16(acc >> 15);
+	}
+}
+
+/**
+ * \brief Droop compensation, DC blocking and gain
+ */
+static void _output(const struct _pdm_decim* dec,
+		struct _pdm_decim_channel* ch, const int16_t* x, int16_t* pcm,
+		uint32_t pcm_stride, uint32_t count)
+{
+	int32_t c0 = ch->comp[0], c1 = ch->comp[1];
+	int32_t dc_x = ch->dc_x, dc_y = ch->dc_y;
+	int32_t gain = dec->gain;
+	uint32_t i;
+
+	for (i = 0; i < count; i++, pcm += pcm_stride) {
+		int32_t c = x[i];
+		int32_t v = c1 + ((COMP_A * (2 * c1 - c - c0) + 0x4000) >> 15);
+
+		c0 = c1;
+		c1 = c;
+		if (dec->dc_block) {
+			dc_y += ((v - dc_x) << 12) - ((dc_y + (1 << (DC_SHIFT - 1)))
+					>> DC_SHIFT);
+			dc_x = v;
+			v = (dc_y + 0x800) >> 12;
+		}
+		*pcm = _sat16((v * gain + 0x800) >> 12);
+	}
+	ch->comp[0] = (int16_t)c0;
+	ch->comp[1] = (int16_t)c1;
+	ch->dc_x = dc_x;
+	ch->dc_y = dc_y;
+}
+
+/*----------------------------------------------------------------------------
+ *         Global functions
+ *----------------------------------------------------------------------------*/
+
+int pdm_decim_init(struct _pdm_decim* dec, uint8_t channels, uint32_t rate,
+		bool lsb_first)
+{
+	int32_t h[PDM_DECIM_CIC_BYTES * 8];
+	int32_t tmp[CIC_TAPS];
+	int k, n, j, b, v;
+
+	if (!channels || channels > PDM_DECIM_MAX_CHANNELS)
+		return -EINVAL;
+	if (rate != 16000 && rate != 32000 && rate != 48000)
+		return -EINVAL;
+
+	/* impulse response of the CIC: 5 moving sums of 16 samples */
+	memset(tmp, 0, sizeof(tmp));
+	tmp[0] = 1;
+	for (k = 0; k < CIC_ORDER; k++) {
+		for (n = CIC_TAPS - 1; n >= 0; n--) {
+			int32_t s = 0;
+			for (j = 0; j < CIC_RATIO && j <= n; j++)
+				s += tmp[n - j];
+			tmp[n] = s;
+		}
+	}
+
+	/* centered in the window, t = 0 is the oldest PDM bit */
+	memset(h, 0, sizeof(h));
+	for (n = 0; n < CIC_TAPS; n++)
+		h[(ARRAY_SIZE(h) - CIC_TAPS) / 2 + n] = tmp[n];
+
+	/* a PDM bit is +1 when set, -1 when clear */
+	for (k = 0; k < PDM_DECIM_CIC_BYTES; k++) {
+		for (v = 0; v < 256; v++) {
+			int32_t s = 0;
+			for (b = 0; b < 8; b++) {
+				int t = 8 * k + (lsb_first ? b : 7 - b);
+				s += (v & (1 << b)) ? h[t] : -h[t];
+			}
+			dec->cic_table[k][v] = s;
+		}
+	}
+
+	dec->channels = channels;
+	dec->rate = rate;
+	dec->lsb_first = lsb_first;
+	pdm_decim_set_output(dec, PDM_DECIM_UNITY, false);
+	pdm_decim_reset(dec);
+	return 0;
+}
+
+void pdm_decim_reset(struct _pdm_decim* dec)
+{
+	uint8_t c;
+
+	memset(dec->ch, 0, sizeof(dec->ch));
+	/* silence is a PDM stream of alternate ones and zeros, starting with a
+	 * zero whatever the bit order */
+	for (c = 0; c < PDM_DECIM_MAX_CHANNELS; c++)
+		memset(dec->ch[c].cic, dec->lsb_first ? 0xaa : 0x55,
+				sizeof(dec->ch[c].cic));
+}
+
+void pdm_decim_set_output(struct _pdm_decim* dec, int16_t gain,
+		bool dc_block)
+{
+	dec->gain = gain;
+	dec->dc_block = dc_block;
+}
+
+uint32_t pdm_decim_get_clock(const struct _pdm_decim* dec)
+{
+	return dec->rate * PDM_DECIM_RATIO;
+}
+
+void pdm_decim_process_channel(struct _pdm_decim* dec, uint8_t channel,
+		const uint8_t* pdm, uint32_t pdm_stride, int16_t* pcm,
+		uint32_t pcm_stride, uint32_t samples)
+{
+	struct _pdm_decim_channel* ch = &dec->ch[channel];
+	int16_t out[CONFIG_PDM_DECIM_BLOCK];
+
+	memcpy(dec->bits, ch->cic, sizeof(ch->cic));
+	memcpy(dec->x1, ch->hb1, sizeof(ch->hb1));
+	memcpy(dec->x2, ch->hb2, sizeof(ch->hb2));
+
+	while (samples) {
+		uint32_t n = min_u32(samples, CONFIG_PDM_DECIM_BLOCK);
+		uint32_t bytes = n * PDM_DECIM_BYTES_PER_SAMPLE;
+		uint32_t i;
+
+		if (pdm_stride == 1) {
+			memcpy(dec->bits + CIC_HIST, pdm, bytes);
+		} else {
+			for (i = 0; i < bytes; i++)
+				dec->bits[CIC_HIST + i] = pdm[i * pdm_stride];
+		}
+		pdm += bytes * pdm_stride;
+
+		_cic(dec->cic_table, dec->bits, dec->x1 + HB1_HIST, 4 * n);
+		_hb1(dec->x1, dec->x2 + HB2_HIST, 2 * n);
+		_hb2(dec->x2, out, n);
+		_output(dec, ch, out, pcm, pcm_stride, n);
+		pcm += n * pcm_stride;
+
+		memmove(dec->bits, dec->bits + bytes, CIC_HIST);
+		memmove(dec->x1, dec->x1 + 4 * n, HB1_HIST * sizeof(int16_t));
+		memmove(dec->x2, dec->x2 + 2 * n, HB2_HIST * sizeof(int16_t));
+		samples -= n;
+	}
+
+	memcpy(ch->cic, dec->bits, sizeof(ch->cic));
+	memcpy(ch->hb1, dec->x1, sizeof(ch->hb1));
+	memcpy(ch->hb2, dec->x2, sizeof(ch->hb2));
+}
+
+void pdm_decim_process(struct _pdm_decim* dec, const uint8_t* pdm,
+		int16_t* pcm, uint32_t frames)
+{
+	uint8_t c;
+
+	for (c = 0; c < dec->channels; c++)
+		pdm_decim_process_channel(dec, c, pdm + c, dec->channels,
+				pcm + c, dec->channels, frames);
+}
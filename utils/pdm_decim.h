@@ -0,0 +1,185 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef PDM_DECIM_H_
+#define PDM_DECIM_H_
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *         Definitions
+ *----------------------------------------------------------------------------*/
+
+/** PDM bits per PCM sample: the PDM clock is 64 times the output rate */
+#define PDM_DECIM_RATIO 64
+
+/** PDM bytes per PCM sample and per channel */
+#define PDM_DECIM_BYTES_PER_SAMPLE (PDM_DECIM_RATIO / 8)
+
+/** Maximum number of channels of a decimator */
+#define PDM_DECIM_MAX_CHANNELS 8
+
+/** CIC filter: bytes of PDM covered by the impulse response (5th order,
+ * decimation by 16, 76 taps padded to 80) */
+#define PDM_DECIM_CIC_BYTES 10
+
+/** First half-band filter (4 fs to 2 fs) length */
+#define PDM_DECIM_HB1_TAPS 23
+
+/** Second half-band filter (2 fs to fs) length */
+#define PDM_DECIM_HB2_TAPS 63
+
+/** Unity gain of the output stage (Q12) */
+#define PDM_DECIM_UNITY 0x1000
+
+/** PCM samples computed per channel and per pass */
+#ifndef CONFIG_PDM_DECIM_BLOCK
+#define CONFIG_PDM_DECIM_BLOCK 32
+#endif
+
+/*----------------------------------------------------------------------------
+ *         Type definitions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Filter history of one channel
+ */
+struct _pdm_decim_channel {
+	uint8_t cic[PDM_DECIM_CIC_BYTES - 2];
+	int16_t hb1[PDM_DECIM_HB1_TAPS - 1];
+	int16_t hb2[PDM_DECIM_HB2_TAPS - 1];
+	int16_t comp[2];
+	int32_t dc_x;
+	int32_t dc_y;  /**< Q12 */
+};
+
+/**
+ * \brief PDM to PCM decimator
+ *
+ * The PDM stream is decimated by 64 in three stages: a 5th order CIC down
+ * to 4 fs, computed with lookup tables on whole bytes of PDM, then two
+ * half-band FIR filters down to fs.  A 3-tap FIR compensates the droop of
+ * the CIC, the response is flat within 0.1 dB up to 0.4 fs and the
+ * attenuation above 0.6 fs is more than 75 dB.  An optional high-pass
+ * filter removes the DC offset of the microphones.
+ */
+struct _pdm_decim {
+	/** CIC output for each value of each byte of the window, the most
+	 * recent byte last */
+	int32_t cic_table[PDM_DECIM_CIC_BYTES][256];
+	struct _pdm_decim_channel ch[PDM_DECIM_MAX_CHANNELS];
+	/** working buffers, history followed by the samples of a pass */
+	uint8_t bits[PDM_DECIM_CIC_BYTES - 2 +
+		PDM_DECIM_BYTES_PER_SAMPLE * CONFIG_PDM_DECIM_BLOCK];
+	int16_t x1[PDM_DECIM_HB1_TAPS - 1 + 4 * CONFIG_PDM_DECIM_BLOCK];
+	int16_t x2[PDM_DECIM_HB2_TAPS + 1 + 2 * CONFIG_PDM_DECIM_BLOCK];
+	uint32_t rate;
+	int16_t gain;     /**< Q12 */
+	uint8_t channels;
+	bool lsb_first;   /**< first PDM bit in the LSB of each byte */
+	bool dc_block;
+};
+
+/*----------------------------------------------------------------------------
+ *         Global functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize a decimator
+ *
+ * \param dec        Decimator state
+ * \param channels   Number of channels (1 to PDM_DECIM_MAX_CHANNELS)
+ * \param rate       Output sample rate: 16000, 32000 or 48000 Hz, the PDM
+ *                   clock must be PDM_DECIM_RATIO times this rate
+ * \param lsb_first  true if the first PDM bit is received in the LSB of
+ *                   each byte, false if it is in the MSB
+ * \return 0 on success, -EINVAL on unsupported parameters
+ */
+extern int pdm_decim_init(struct _pdm_decim* dec, uint8_t channels,
+		uint32_t rate, bool lsb_first);
+
+/**
+ * \brief Clear the filter history of all channels
+ */
+extern void pdm_decim_reset(struct _pdm_decim* dec);
+
+/**
+ * \brief Set the output gain and the DC blocking filter
+ *
+ * A PDM stream of ones gives INT16_MAX at unity gain.
+ *
+ * \param dec       Decimator state
+ * \param gain      Q12 gain, PDM_DECIM_UNITY for 0 dB, up to 8 (+18 dB)
+ * \param dc_block  Enable the high-pass filter (cut-off at fs / 6400)
+ */
+extern void pdm_decim_set_output(struct _pdm_decim* dec, int16_t gain,
+		bool dc_block);
+
+/**
+ * \brief PDM clock frequency for the output rate of a decimator
+ */
+extern uint32_t pdm_decim_get_clock(const struct _pdm_decim* dec);
+
+/**
+ * \brief Decimate the PDM stream of one channel
+ *
+ * \param dec         Decimator state
+ * \param channel     Channel index
+ * \param pdm         First PDM byte of the channel
+ * \param pdm_stride  Distance in bytes between two PDM bytes of the channel
+ * \param pcm         First output sample
+ * \param pcm_stride  Distance in samples between two output samples
+ * \param samples     Number of output samples, PDM_DECIM_BYTES_PER_SAMPLE
+ *                    PDM bytes are read per sample
+ */
+extern void pdm_decim_process_channel(struct _pdm_decim* dec,
+		uint8_t channel, const uint8_t* pdm, uint32_t pdm_stride,
+		int16_t* pcm, uint32_t pcm_stride, uint32_t samples);
+
+/**
+ * \brief Decimate byte-interleaved PDM streams to interleaved PCM frames
+ *
+ * The PDM buffer holds one byte of each channel in turn, as received from
+ * several serial data lines sharing the same clock, or from one line
+ * carrying time-multiplexed microphones.
+ *
+ * \param dec     Decimator state
+ * \param pdm     PDM bytes, frames * channels * PDM_DECIM_BYTES_PER_SAMPLE
+ * \param pcm     PCM frames
+ * \param frames  Number of output frames
+ */
+extern void pdm_decim_process(struct _pdm_decim* dec, const uint8_t* pdm,
+		int16_t* pcm, uint32_t frames);
+
+#endif /* PDM_DECIM_H_ */
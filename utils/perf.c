@@ -0,0 +1,388 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "errno.h"
+#include "perf.h"
+
+#ifdef CONFIG_ARCH_ARM
+#include "chip.h"
+#include "cycle_counter.h"
+#include "peripherals/pmc.h"
+#include "timer.h"
+#ifdef CONFIG_HAVE_L2CC
+#include "mm/l2cache.h"
+#include "mm/l2cache_l2cc.h"
+#endif
+#else
+#include <time.h>
+#endif
+
+/*----------------------------------------------------------------------------
+ *         Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Intervals shorter than this are timed with the cycle counter */
+#define PERF_CYCLE_TIMING_MAX_NS 1000000000ull
+
+/** No hardware event number for this event */
+#define PERF_HW_NONE 0xff
+
+/*----------------------------------------------------------------------------
+ *         Local types
+ *----------------------------------------------------------------------------*/
+
+enum _perf_unit {
+	PERF_UNIT_PMU,
+	PERF_UNIT_L2CC,
+};
+
+struct _perf_event_desc {
+	const char* name;
+	uint8_t unit;
+	uint8_t hw;          /**< ARMv7 PMU event number or L2CC source */
+};
+
+/*----------------------------------------------------------------------------
+ *         Local constants
+ *----------------------------------------------------------------------------*/
+
+static const struct _perf_event_desc _perf_events[PERF_EVENT_COUNT] = {
+	[PERF_EVENT_INSTRUCTIONS] = { "instr", PERF_UNIT_PMU, 0x08 },
+	[PERF_EVENT_L1I_MISS] = { "l1i-miss", PERF_UNIT_PMU, 0x01 },
+	[PERF_EVENT_L1D_MISS] = { "l1d-miss", PERF_UNIT_PMU, 0x03 },
+	[PERF_EVENT_L1D_ACCESS] = { "l1d-acc", PERF_UNIT_PMU, 0x04 },
+	[PERF_EVENT_ITLB_MISS] = { "itlb-miss", PERF_UNIT_PMU, 0x02 },
+	[PERF_EVENT_DTLB_MISS] = { "dtlb-miss", PERF_UNIT_PMU, 0x05 },
+	[PERF_EVENT_BRANCH_MISS] = { "br-miss", PERF_UNIT_PMU, 0x10 },
+#ifdef CONFIG_HAVE_L2CC
+	[PERF_EVENT_L2_READ_REQ] = { "l2-rd", PERF_UNIT_L2CC, L2CC_ECFGR0_ESRC_SRC_DRREQ },
+	[PERF_EVENT_L2_READ_HIT] = { "l2-rd-hit", PERF_UNIT_L2CC, L2CC_ECFGR0_ESRC_SRC_DRHIT },
+	[PERF_EVENT_L2_WRITE_REQ] = { "l2-wr", PERF_UNIT_L2CC, L2CC_ECFGR0_ESRC_SRC_DWREQ },
+	[PERF_EVENT_L2_WRITE_HIT] = { "l2-wr-hit", PERF_UNIT_L2CC, L2CC_ECFGR0_ESRC_SRC_DWHIT },
+#else
+	[PERF_EVENT_L2_READ_REQ] = { "l2-rd", PERF_UNIT_L2CC, PERF_HW_NONE },
+	[PERF_EVENT_L2_READ_HIT] = { "l2-rd-hit", PERF_UNIT_L2CC, PERF_HW_NONE },
+	[PERF_EVENT_L2_WRITE_REQ] = { "l2-wr", PERF_UNIT_L2CC, PERF_HW_NONE },
+	[PERF_EVENT_L2_WRITE_HIT] = { "l2-wr-hit", PERF_UNIT_L2CC, PERF_HW_NONE },
+#endif
+};
+
+/*----------------------------------------------------------------------------
+ *         Local variables
+ *----------------------------------------------------------------------------*/
+
+static struct {
+	uint8_t count;
+	uint8_t events[PERF_MAX_EVENTS];
+	uint8_t counter[PERF_MAX_EVENTS];   /**< PMU or L2CC counter index */
+} _perf;
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint64_t _perf_get_ns(void)
+{
+#ifdef CONFIG_ARCH_ARM
+	return timer_get_us() * 1000;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#endif
+}
+
+static uint32_t _perf_get_cycles(void)
+{
+#ifdef CONFIG_HAVE_CYCLE_COUNTER
+	return cycle_counter_read();
+#else
+	return 0;
+#endif
+}
+
+static uint32_t _perf_read_counter(uint8_t slot)
+{
+	switch (_perf_events[_perf.events[slot]].unit) {
+#ifdef CONFIG_ARCH_ARMV7A
+	case PERF_UNIT_PMU:
+		cp15_write_pmselr(_perf.counter[slot]);
+		return cp15_read_pmxevcntr();
+#endif
+#ifdef CONFIG_HAVE_L2CC
+	case PERF_UNIT_L2CC:
+		return l2cc_event_counter_value(_perf.counter[slot]);
+#endif
+	default:
+		return 0;
+	}
+}
+
+#ifdef CONFIG_ARCH_ARMV7A
+static uint8_t _perf_pmu_counters(void)
+{
+	return (cp15_read_pmcr() & CP15_PMCR_N_Msk) >> CP15_PMCR_N_Pos;
+}
+#endif
+
+/*----------------------------------------------------------------------------
+ *         Exported functions
+ *----------------------------------------------------------------------------*/
+
+void perf_initialize(void)
+{
+	memset(&_perf, 0, sizeof(_perf));
+#ifdef CONFIG_HAVE_CYCLE_COUNTER
+	cycle_counter_enable();
+#endif
+}
+
+int perf_configure_events(const enum _perf_event* events, uint8_t count)
+{
+	uint8_t used[2] = { 0, 0 };
+	uint8_t i;
+
+	if (count > PERF_MAX_EVENTS)
+		return -ENOSPC;
+
+	for (i = 0; i < count; i++) {
+		if (events[i] >= PERF_EVENT_COUNT)
+			return -EINVAL;
+		switch (_perf_events[events[i]].unit) {
+		case PERF_UNIT_PMU:
+#ifdef CONFIG_ARCH_ARMV7A
+			if (used[PERF_UNIT_PMU] >= _perf_pmu_counters())
+				return -ENOSPC;
+			used[PERF_UNIT_PMU]++;
+			break;
+#else
+			return -ENOTSUP;
+#endif
+		case PERF_UNIT_L2CC:
+#ifdef CONFIG_HAVE_L2CC
+			if (!l2cache_is_enabled())
+				return -ENOTSUP;
+			if (used[PERF_UNIT_L2CC] >= 2)
+				return -ENOSPC;
+			used[PERF_UNIT_L2CC]++;
+			break;
+#else
+			return -ENOTSUP;
+#endif
+		}
+	}
+
+#ifdef CONFIG_ARCH_ARMV7A
+	/* stop event counters, cycle counter keeps running */
+	cp15_write_pmcntenclr(~CP15_PMCNTEN_C);
+#endif
+#ifdef CONFIG_HAVE_L2CC
+	if (used[PERF_UNIT_L2CC])
+		l2cc_disable_event_counters();
+#endif
+
+	used[PERF_UNIT_PMU] = used[PERF_UNIT_L2CC] = 0;
+	for (i = 0; i < count; i++) {
+		const struct _perf_event_desc* desc = &_perf_events[events[i]];
+
+		_perf.events[i] = events[i];
+		_perf.counter[i] = used[desc->unit]++;
+		switch (desc->unit) {
+#ifdef CONFIG_ARCH_ARMV7A
+		case PERF_UNIT_PMU:
+			cp15_write_pmselr(_perf.counter[i]);
+			cp15_write_pmxevtyper(desc->hw);
+			cp15_write_pmxevcntr(0);
+			break;
+#endif
+#ifdef CONFIG_HAVE_L2CC
+		case PERF_UNIT_L2CC:
+			l2cc_event_config(_perf.counter[i], desc->hw,
+			                  L2CC_ECFGR0_EIGEN_INT_DIS);
+			break;
+#endif
+		default:
+			break;
+		}
+	}
+	_perf.count = count;
+
+#ifdef CONFIG_ARCH_ARMV7A
+	if (used[PERF_UNIT_PMU])
+		cp15_write_pmcntenset((1u << used[PERF_UNIT_PMU]) - 1);
+#endif
+#ifdef CONFIG_HAVE_L2CC
+	for (i = 0; i < used[PERF_UNIT_L2CC]; i++)
+		l2cc_enable_event_counter(i);
+#endif
+
+	return 0;
+}
+
+bool perf_has_cycles(void)
+{
+#ifdef CONFIG_HAVE_CYCLE_COUNTER
+	return true;
+#else
+	return false;
+#endif
+}
+
+void perf_read(struct _perf_sample* sample)
+{
+	uint8_t i;
+
+	for (i = 0; i < _perf.count; i++)
+		sample->events[i] = _perf_read_counter(i);
+	for (; i < PERF_MAX_EVENTS; i++)
+		sample->events[i] = 0;
+	sample->ns = _perf_get_ns();
+	sample->cycles = _perf_get_cycles();
+}
+
+void perf_diff(const struct _perf_sample* start,
+		const struct _perf_sample* end, struct _perf_sample* delta)
+{
+	uint8_t i;
+
+	delta->ns = end->ns - start->ns;
+	delta->cycles = end->cycles - start->cycles;
+	for (i = 0; i < PERF_MAX_EVENTS; i++)
+		delta->events[i] = end->events[i] - start->events[i];
+
+#if defined(CONFIG_ARCH_ARM) && defined(CONFIG_HAVE_CYCLE_COUNTER)
+	/* the timer resolution is 1us, use cycles when they cannot have
+	 * wrapped more than once */
+	if (delta->ns < PERF_CYCLE_TIMING_MAX_NS) {
+		uint32_t pck = pmc_get_processor_clock();
+		if (pck)
+			delta->ns = (uint64_t)delta->cycles * 1000000000ull / pck;
+	}
+#endif
+}
+
+const char* perf_event_name(enum _perf_event event)
+{
+	if (event >= PERF_EVENT_COUNT)
+		return "?";
+	return _perf_events[event].name;
+}
+
+int perf_bench_run(const struct _perf_bench* bench, uint32_t runs,
+		struct _perf_result* result)
+{
+	struct _perf_sample start, end, delta;
+	uint64_t ns = 0, cycles = 0;
+	uint64_t events[PERF_MAX_EVENTS] = { 0 };
+	uint32_t r;
+	uint8_t i;
+	int err;
+
+	memset(result, 0, sizeof(*result));
+
+	if (bench->setup) {
+		err = bench->setup(bench->arg);
+		if (err < 0)
+			return err;
+	}
+
+	/* warm-up run */
+	if (bench->prepare)
+		bench->prepare(bench->arg);
+	bench->run(bench->arg);
+
+	for (r = 0; r < runs; r++) {
+		if (bench->prepare)
+			bench->prepare(bench->arg);
+		perf_read(&start);
+		bench->run(bench->arg);
+		perf_read(&end);
+		perf_diff(&start, &end, &delta);
+
+		if (r == 0 || delta.ns < result->best.ns)
+			result->best = delta;
+		ns += delta.ns;
+		cycles += delta.cycles;
+		for (i = 0; i < PERF_MAX_EVENTS; i++)
+			events[i] += delta.events[i];
+	}
+
+	if (bench->teardown)
+		bench->teardown(bench->arg);
+
+	result->runs = runs;
+	if (runs) {
+		result->avg.ns = ns / runs;
+		result->avg.cycles = cycles / runs;
+		for (i = 0; i < PERF_MAX_EVENTS; i++)
+			result->avg.events[i] = events[i] / runs;
+	}
+
+	return 0;
+}
+
+void perf_bench_print_header(void)
+{
+	uint8_t i;
+
+	printf("%-24s %12s %12s %10s %10s", "benchmark", "best (us)",
+	       "avg (us)", "cycles", "MB/s");
+	for (i = 0; i < _perf.count; i++)
+		printf(" %10s", perf_event_name(_perf.events[i]));
+	printf("\r\n");
+}
+
+void perf_bench_print(const struct _perf_bench* bench,
+		const struct _perf_result* result)
+{
+	const struct _perf_sample* best = &result->best;
+	uint32_t mbps = 0;
+	uint8_t i;
+
+	/* throughput of the best run, in tenths of MB/s */
+	if (bench->bytes && best->ns)
+		mbps = (uint32_t)((uint64_t)bench->bytes * 10000 / best->ns);
+
+	printf("%-24s %8u.%03u %8u.%03u %10u %6u.%u", bench->name,
+	       (unsigned)(best->ns / 1000), (unsigned)(best->ns % 1000),
+	       (unsigned)(result->avg.ns / 1000),
+	       (unsigned)(result->avg.ns % 1000),
+	       (unsigned)best->cycles, (unsigned)(mbps / 10),
+	       (unsigned)(mbps % 10));
+	for (i = 0; i < _perf.count; i++)
+		printf(" %10u", (unsigned)best->events[i]);
+	printf("\r\n");
+}
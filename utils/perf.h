@@ -0,0 +1,181 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef PERF_H_
+#define PERF_H_
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *         Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Maximum number of events counted simultaneously */
+#define PERF_MAX_EVENTS 4
+
+/*----------------------------------------------------------------------------
+ *         Type definitions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Hardware events that can be counted alongside cycles
+ *
+ * PMU events are only available on Cortex-A cores, L2 events only on devices
+ * with a L2 cache controller.  perf_configure_events() rejects unsupported
+ * events with -ENOTSUP.
+ */
+enum _perf_event {
+	PERF_EVENT_INSTRUCTIONS,   /**< architecturally executed instructions */
+	PERF_EVENT_L1I_MISS,       /**< L1 instruction cache refills */
+	PERF_EVENT_L1D_MISS,       /**< L1 data cache refills */
+	PERF_EVENT_L1D_ACCESS,     /**< L1 data cache accesses */
+	PERF_EVENT_ITLB_MISS,      /**< instruction TLB refills */
+	PERF_EVENT_DTLB_MISS,      /**< data TLB refills */
+	PERF_EVENT_BRANCH_MISS,    /**< mispredicted branches */
+	PERF_EVENT_L2_READ_REQ,    /**< L2 data read requests */
+	PERF_EVENT_L2_READ_HIT,    /**< L2 data read hits */
+	PERF_EVENT_L2_WRITE_REQ,   /**< L2 data write requests */
+	PERF_EVENT_L2_WRITE_HIT,   /**< L2 data write hits */
+	PERF_EVENT_COUNT,
+};
+
+/**
+ * \brief Snapshot of the time base and of the enabled counters
+ */
+struct _perf_sample {
+	uint64_t ns;                        /**< time stamp, in nanoseconds */
+	uint32_t cycles;                    /**< core cycles (0 if unavailable) */
+	uint32_t events[PERF_MAX_EVENTS];   /**< configured event counters */
+};
+
+/**
+ * \brief Micro-benchmark description
+ *
+ * setup() and teardown() are called once per perf_bench_run(), prepare() is
+ * called before each run outside of the measured window (e.g. to dirty the
+ * cache), only run() is measured.  All callbacks except run() are optional.
+ */
+struct _perf_bench {
+	const char* name;
+	uint32_t bytes;             /**< bytes processed per run, 0 if n/a */
+	void* arg;
+	int (*setup)(void* arg);
+	void (*prepare)(void* arg);
+	void (*run)(void* arg);
+	void (*teardown)(void* arg);
+};
+
+/**
+ * \brief Result of perf_bench_run()
+ */
+struct _perf_result {
+	uint32_t runs;
+	struct _perf_sample best;   /**< fastest run */
+	struct _perf_sample avg;    /**< average over all measured runs */
+};
+
+/*----------------------------------------------------------------------------
+ *         Global functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Enable the cycle counter and reset the event configuration
+ *
+ * On target, the timer (see timer_configure()) must be running as it
+ * provides the time base.  On a Linux host, CLOCK_MONOTONIC is used and no
+ * counters are available.
+ */
+extern void perf_initialize(void);
+
+/**
+ * \brief Select the events counted in the 'events' field of the samples
+ *
+ * \param events  Array of events
+ * \param count   Number of events (at most PERF_MAX_EVENTS)
+ * \return 0 on success, -ENOTSUP if an event is not available on this core,
+ * -ENOSPC if there are not enough hardware counters.
+ */
+extern int perf_configure_events(const enum _perf_event* events, uint8_t count);
+
+/**
+ * \brief Tells if perf_read() provides a cycle count
+ */
+extern bool perf_has_cycles(void);
+
+/**
+ * \brief Read time base and counters
+ */
+extern void perf_read(struct _perf_sample* sample);
+
+/**
+ * \brief Compute the difference between two samples
+ *
+ * Counters wrapping once between the samples are handled.  On target, short
+ * intervals are timed with the cycle counter instead of the timer to get a
+ * sub-microsecond resolution.
+ */
+extern void perf_diff(const struct _perf_sample* start,
+		const struct _perf_sample* end, struct _perf_sample* delta);
+
+/**
+ * \brief Get a short printable name of an event
+ */
+extern const char* perf_event_name(enum _perf_event event);
+
+/**
+ * \brief Execute a micro-benchmark
+ *
+ * One warm-up run is done first and is not accounted.
+ *
+ * \param bench   Benchmark to execute
+ * \param runs    Number of measured runs
+ * \param result  Filled with the best and average figures
+ * \return 0 on success, or the error returned by the setup callback
+ */
+extern int perf_bench_run(const struct _perf_bench* bench, uint32_t runs,
+		struct _perf_result* result);
+
+/**
+ * \brief Print a benchmark result on one line (time, cycles, throughput and
+ * configured events)
+ */
+extern void perf_bench_print(const struct _perf_bench* bench,
+		const struct _perf_result* result);
+
+/**
+ * \brief Print the header line matching perf_bench_print() output
+ */
+extern void perf_bench_print_header(void);
+
+#endif /* PERF_H_ */
@@ -0,0 +1,278 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stddef.h>
+
+#include "compiler.h"
+#include "cpuidle.h"
+#include "irqflags.h"
+#ifdef CONFIG_DVFS
+#include "power/dvfs.h"
+#endif
+#include "sched.h"
+
+/*----------------------------------------------------------------------------
+ *         Local types
+ *----------------------------------------------------------------------------*/
+
+struct _sched_queue {
+	struct _sched_event* head;
+	struct _sched_event* tail;
+};
+
+/*----------------------------------------------------------------------------
+ *         Local variables
+ *----------------------------------------------------------------------------*/
+
+static struct _sched_queue _queues[SCHED_PRIORITY_COUNT];
+
+/** Bit n set if queue n is not empty */
+static volatile uint32_t _pending;
+
+/** Priority of the event being dispatched, SCHED_PRIORITY_COUNT if none */
+static uint8_t _current_priority = SCHED_PRIORITY_COUNT;
+
+static struct _sched_stats _stats;
+
+/*----------------------------------------------------------------------------
+ *         Local functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Pop the first event of the highest priority queue whose priority is
+ * strictly higher than max_priority.
+ */
+static struct _sched_event* _sched_pop(uint8_t max_priority)
+{
+	struct _sched_event* event = NULL;
+	uint32_t flags = arch_irq_save();
+	uint32_t pending = _pending & ((1u << max_priority) - 1);
+
+	if (pending) {
+		uint8_t prio = 31 - CLZ(pending & -pending);
+		struct _sched_queue* queue = &_queues[prio];
+
+		event = queue->head;
+		queue->head = event->next;
+		if (!queue->head) {
+			queue->tail = NULL;
+			_pending &= ~(1u << prio);
+		}
+		event->next = NULL;
+		event->queued = false;
+	}
+
+	arch_irq_restore(flags);
+	return event;
+}
+
+static void _sched_dispatch(struct _sched_event* event)
+{
+	uint8_t prev = _current_priority;
+
+	_current_priority = event->priority;
+	_stats.dispatched[event->priority]++;
+	callback_call(&event->callback, event);
+	_current_priority = prev;
+}
+
+/**
+ * \brief Dispatch one event above max_priority or sleep until the next
+ * interrupt.
+ */
+static void _sched_step(uint8_t max_priority, volatile bool* done)
+{
+	struct _sched_event* event = _sched_pop(max_priority);
+	uint32_t flags;
+
+	if (event) {
+		_sched_dispatch(event);
+		return;
+	}
+
+	/* WFI wakes up on pending interrupts even when they are masked, so
+	 * checking with interrupts disabled cannot miss a post. */
+	flags = arch_irq_save();
+	if (!(_pending & ((1u << max_priority) - 1)) && !(done && *done)) {
+		_stats.idle++;
+#ifdef CONFIG_DVFS
+		dvfs_idle();
+#else
+		cpu_idle();
+#endif
+	}
+	arch_irq_restore(flags);
+}
+
+static int _sched_completion_callback(void* arg, void* arg2)
+{
+	struct _sched_completion* completion = (struct _sched_completion*)arg;
+
+	completion->result = arg2;
+	completion->done = true;
+	return 0;
+}
+
+static int _sched_deferred_post(void* arg, void* arg2)
+{
+	struct _sched_deferred* deferred = (struct _sched_deferred*)arg;
+
+	deferred->arg2 = arg2;
+	sched_post(&deferred->event);
+	return 0;
+}
+
+static int _sched_deferred_dispatch(void* arg, void* arg2)
+{
+	struct _sched_deferred* deferred = (struct _sched_deferred*)arg;
+
+	return callback_call(&deferred->target, deferred->arg2);
+}
+
+/*----------------------------------------------------------------------------
+ *         Exported functions
+ *----------------------------------------------------------------------------*/
+
+void sched_event_init(struct _sched_event* event, uint8_t priority,
+		struct _callback* cb)
+{
+	if (priority > SCHED_PRIORITY_LOWEST)
+		priority = SCHED_PRIORITY_LOWEST;
+	callback_copy(&event->callback, cb);
+	event->priority = priority;
+	event->queued = false;
+	event->next = NULL;
+}
+
+bool sched_post(struct _sched_event* event)
+{
+	struct _sched_queue* queue = &_queues[event->priority];
+	uint32_t flags = arch_irq_save();
+
+	if (event->queued) {
+		_stats.coalesced++;
+		arch_irq_restore(flags);
+		return false;
+	}
+
+	event->queued = true;
+	event->next = NULL;
+	if (queue->tail)
+		queue->tail->next = event;
+	else
+		queue->head = event;
+	queue->tail = event;
+	_pending |= 1u << event->priority;
+
+	arch_irq_restore(flags);
+	return true;
+}
+
+void sched_cancel(struct _sched_event* event)
+{
+	struct _sched_queue* queue = &_queues[event->priority];
+	struct _sched_event *prev = NULL, *cur;
+	uint32_t flags = arch_irq_save();
+
+	for (cur = queue->head; cur; prev = cur, cur = cur->next) {
+		if (cur != event)
+			continue;
+		if (prev)
+			prev->next = cur->next;
+		else
+			queue->head = cur->next;
+		if (queue->tail == cur)
+			queue->tail = prev;
+		if (!queue->head)
+			_pending &= ~(1u << event->priority);
+		cur->next = NULL;
+		cur->queued = false;
+		break;
+	}
+
+	arch_irq_restore(flags);
+}
+
+bool sched_run_once(void)
+{
+	struct _sched_event* event = _sched_pop(_current_priority);
+
+	if (!event)
+		return false;
+	_sched_dispatch(event);
+	return true;
+}
+
+void sched_run(void)
+{
+	while (1) {
+#ifdef CONFIG_DVFS
+		dvfs_update();
+#endif
+		_sched_step(SCHED_PRIORITY_COUNT, NULL);
+	}
+}
+
+void sched_completion_init(struct _sched_completion* completion,
+		struct _callback* cb)
+{
+	completion->done = false;
+	completion->result = NULL;
+	callback_set(cb, _sched_completion_callback, completion);
+}
+
+void* sched_wait(struct _sched_completion* completion)
+{
+	while (!completion->done)
+		_sched_step(_current_priority, &completion->done);
+	return completion->result;
+}
+
+void sched_defer_callback(struct _sched_deferred* deferred,
+		uint8_t priority, struct _callback* target, struct _callback* cb)
+{
+	struct _callback dispatch;
+
+	callback_copy(&deferred->target, target);
+	deferred->arg2 = NULL;
+	callback_set(&dispatch, _sched_deferred_dispatch, deferred);
+	sched_event_init(&deferred->event, priority, &dispatch);
+	callback_set(cb, _sched_deferred_post, deferred);
+}
+
+void sched_get_stats(struct _sched_stats* stats)
+{
+	uint32_t flags = arch_irq_save();
+	*stats = _stats;
+	arch_irq_restore(flags);
+}
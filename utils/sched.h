@@ -0,0 +1,195 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2016, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * Run-to-completion cooperative scheduler.
+ *
+ * Work is described by events (struct _sched_event) posted to one of
+ * SCHED_PRIORITY_COUNT FIFO queues.  sched_run() pops the oldest event of the
+ * highest priority non-empty queue and invokes its callback; when all queues
+ * are empty the core is put to sleep until the next interrupt.
+ *
+ * Events may be posted from interrupt handlers.  Driver completion callbacks
+ * can be deferred to scheduler context with sched_defer_callback(), so that
+ * interrupt handlers only queue work.
+ *
+ * A handler that needs the result of an asynchronous operation may call
+ * sched_wait() on a completion: events of strictly higher priority keep being
+ * dispatched while it waits.
+ */
+
+#ifndef _SCHED_H_
+#define _SCHED_H_
+
+/*----------------------------------------------------------------------------
+ *         Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "callback.h"
+
+/*----------------------------------------------------------------------------
+ *         Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Number of priority levels, 0 is the highest priority */
+#ifndef CONFIG_SCHED_PRIORITY_COUNT
+#define CONFIG_SCHED_PRIORITY_COUNT 4
+#endif
+#define SCHED_PRIORITY_COUNT CONFIG_SCHED_PRIORITY_COUNT
+
+#define SCHED_PRIORITY_HIGHEST 0
+#define SCHED_PRIORITY_LOWEST (SCHED_PRIORITY_COUNT - 1)
+
+/*----------------------------------------------------------------------------
+ *         Types
+ *----------------------------------------------------------------------------*/
+
+struct _sched_event {
+	struct _callback callback;   /**< invoked with the event as 2nd argument */
+	uint8_t priority;
+	volatile bool queued;
+	struct _sched_event* next;
+};
+
+struct _sched_completion {
+	volatile bool done;
+	void* result;                /**< 2nd argument given to the callback */
+};
+
+struct _sched_deferred {
+	struct _sched_event event;
+	struct _callback target;
+	void* arg2;
+};
+
+struct _sched_stats {
+	uint32_t dispatched[SCHED_PRIORITY_COUNT];
+	uint32_t coalesced;          /**< posts of an already queued event */
+	uint32_t idle;               /**< number of times the core went idle */
+};
+
+/*----------------------------------------------------------------------------
+ *         Exported functions
+ *----------------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief Initialize an event
+ *
+ * \param event     Pointer to the event
+ * \param priority  Queue the event will be posted to (0 is highest)
+ * \param cb        Callback invoked when the event is dispatched
+ */
+extern void sched_event_init(struct _sched_event* event, uint8_t priority,
+		struct _callback* cb);
+
+/**
+ * \brief Queue an event for dispatch
+ *
+ * This function can be called from interrupt context.  Posting an event that
+ * is already queued has no effect: it will be dispatched only once.
+ *
+ * \return true if the event was queued, false if it was already queued
+ */
+extern bool sched_post(struct _sched_event* event);
+
+/**
+ * \brief Remove an event from its queue if it has not been dispatched yet
+ */
+extern void sched_cancel(struct _sched_event* event);
+
+/**
+ * \brief Dispatch the highest priority pending event
+ *
+ * \return true if an event was dispatched, false if all queues were empty
+ */
+extern bool sched_run_once(void);
+
+/**
+ * \brief Dispatch events forever, sleeping when all queues are empty
+ */
+extern void sched_run(void);
+
+/**
+ * \brief Prepare a completion and a callback that signals it
+ *
+ * The callback can be given to any driver function taking a struct _callback
+ * and will mark the completion done when invoked.
+ *
+ * \param completion  Pointer to the completion
+ * \param cb          Filled with the callback signaling the completion
+ */
+extern void sched_completion_init(struct _sched_completion* completion,
+		struct _callback* cb);
+
+/**
+ * \brief Wait for a completion
+ *
+ * While waiting, events with a priority strictly higher than the current one
+ * are dispatched.  When called from outside of the scheduler all events are
+ * eligible.  The core sleeps when nothing can be dispatched.
+ *
+ * \return the second argument given to the completion callback
+ */
+extern void* sched_wait(struct _sched_completion* completion);
+
+/**
+ * \brief Defer a callback to scheduler context
+ *
+ * Fills cb with a callback that, when invoked (typically from an interrupt
+ * handler), records its second argument and posts an event.  When the event
+ * is dispatched, target is invoked with the recorded argument.  If cb is
+ * invoked several times before dispatch, only the last argument is kept.
+ *
+ * \param deferred  Pointer to the deferred callback storage
+ * \param priority  Priority of the dispatching event
+ * \param target    Callback to invoke from scheduler context
+ * \param cb        Filled with the interrupt-side callback
+ */
+extern void sched_defer_callback(struct _sched_deferred* deferred,
+		uint8_t priority, struct _callback* target, struct _callback* cb);
+
+/**
+ * \brief Get dispatch statistics
+ */
+extern void sched_get_stats(struct _sched_stats* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SCHED_H_ */
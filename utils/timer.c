@@ -32,21 +32,80 @@
  *----------------------------------------------------------------------------*/
 
 #include "board.h"
-#include "irqflags.h"
+#include "compiler.h"
+#include "cpuidle.h"
+#include "intmath.h"
 #include "irq/irq.h"
+#include "irqflags.h"
 #include "peripherals/pmc.h"
 #include "peripherals/tc.h"
 #include "timer.h"
 
+/*----------------------------------------------------------------------------
+ *         Local definitions
+ *----------------------------------------------------------------------------*/
+
+/** Target resolution of the timer event wheel, in Hz */
+#ifndef CONFIG_TIMER_EVENT_RESOLUTION
+#define CONFIG_TIMER_EVENT_RESOLUTION 10000
+#endif
+
+/** Number of bits of wheel index per level (32 slots per level) */
+#define WHEEL_BITS 5
+#define WHEEL_SIZE (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+
+/** Number of levels, covers 2^20 wheel units before re-cascading */
+#define WHEEL_LEVELS 4
+#define WHEEL_RANGE (1ull << (WHEEL_BITS * WHEEL_LEVELS))
+
+/** Minimum distance between the counter and RC when arming the compare */
+#define COMPARE_MARGIN 2
+
+#define NO_DEADLINE 0xffffffffffffffffull
+
 /*----------------------------------------------------------------------------
  *         Local type definitions
  *----------------------------------------------------------------------------*/
 
+struct _mult_shift {
+	uint32_t mult;
+	uint8_t shift;
+};
+
+struct _timer_wheel {
+	uint64_t jiffies;               /**< next wheel unit to process */
+	uint8_t unit_shift;             /**< log2(TC ticks per wheel unit) */
+	uint32_t bitmap[WHEEL_LEVELS];  /**< non-empty slots */
+	struct _timer_event* slots[WHEEL_LEVELS][WHEEL_SIZE];
+};
+
 struct _timer {
 	Tc* tc;
 	uint8_t channel;
+	uint32_t id;
 	uint32_t channel_freq;
+	struct _mult_shift tick_to_ms;
+	struct _mult_shift tick_to_us;
+	struct _mult_shift us_to_tick;
 	volatile uint32_t upper;
+
+	/* time base, rebased on each master clock change */
+	uint64_t tick_base;
+	uint64_t ms_base;
+	uint64_t us_base;
+
+	/* state saved before a master clock change */
+	struct {
+		uint64_t tick;
+		uint64_t ms;
+		uint64_t us;
+	} pre_change;
+	struct _pmc_mck_notifier mck_notifier;
+#ifndef CONFIG_TIMER_POLLING
+	volatile bool compare_armed;
+	struct _timer_wheel wheel;
+#endif
 };
 
 /*----------------------------------------------------------------------------
@@ -60,11 +119,69 @@ static struct _timer _timer;
  *         Local Functions
  *----------------------------------------------------------------------------*/
 
-static void timer_update_upper_tick_counter(void)
+/**
+ * \brief Compute constants so that (x * to / from) ~= (x * mult) >> shift
+ *
+ * The shift is chosen as large as possible while keeping mult on 32 bits.
+ */
+static void _compute_mult_shift(struct _mult_shift* ms, uint32_t from, uint32_t to)
+{
+	uint8_t shift = 0;
+
+	while (shift < 63) {
+		uint64_t num = (uint64_t)to << (shift + 1);
+		if ((num >> (shift + 1)) != to || (num / from) > 0xffffffffu)
+			break;
+		shift++;
+	}
+	ms->mult = (uint32_t)((((uint64_t)to) << shift) / from);
+	ms->shift = shift;
+}
+
+/**
+ * \brief Apply multiply-shift constants to a 64-bit value
+ *
+ * The value is split in two 32-bit halves so that the intermediate products
+ * never overflow.
+ */
+static uint64_t _apply_mult_shift(const struct _mult_shift* ms, uint64_t value)
+{
+	uint64_t hi = (value >> 32) * ms->mult;
+	uint64_t lo = ((value & 0xffffffffu) * ms->mult) >> ms->shift;
+
+	if (ms->shift >= 32)
+		return (hi >> (ms->shift - 32)) + lo;
+	return (hi << (32 - ms->shift)) + lo;
+}
+
+#ifndef CONFIG_TIMER_POLLING
+static void _timer_retrigger_compare(void)
+{
+	uint32_t rc = tc_get_cv(_timer.tc, _timer.channel) + COMPARE_MARGIN;
+	tc_set_ra_rb_rc(_timer.tc, _timer.channel, NULL, NULL, &rc);
+}
+#endif
+
+static uint32_t timer_read_status(void)
 {
 	uint32_t status = tc_get_status(_timer.tc, _timer.channel);
 	if ((status & TC_SR_COVFS) == TC_SR_COVFS)
 		_timer.upper++;
+	return status;
+}
+
+static void timer_update_upper_tick_counter(void)
+{
+	uint32_t status = timer_read_status();
+#ifndef CONFIG_TIMER_POLLING
+	/* Reading the status register clears the compare flag.  If it was set,
+	 * the interrupt handler may not see it so arm the compare again a few
+	 * ticks ahead. */
+	if ((status & TC_SR_CPCS) == TC_SR_CPCS && _timer.compare_armed)
+		_timer_retrigger_compare();
+#else
+	(void)status;
+#endif
 }
 
 static uint32_t timer_get_upper_tick_counter(void)
@@ -73,28 +190,356 @@ static uint32_t timer_get_upper_tick_counter(void)
 	return _timer.upper;
 }
 
+static uint64_t _timer_get_tick(void)
+{
+	uint32_t upper, lower;
+
+	do {
+		upper = timer_get_upper_tick_counter();
+		COMPILER_BARRIER();
+		lower = tc_get_cv(_timer.tc, _timer.channel);
+	} while (upper != timer_get_upper_tick_counter());
+	return (((uint64_t)upper) << TC_CHANNEL_SIZE) | lower;
+}
+
+/**
+ * \brief Compute the conversion constants for a new channel frequency
+ */
+static void _timer_set_rate(uint32_t freq)
+{
+	_timer.channel_freq = freq;
+	_compute_mult_shift(&_timer.tick_to_ms, freq, 1000);
+	_compute_mult_shift(&_timer.tick_to_us, freq, 1000000);
+	_compute_mult_shift(&_timer.us_to_tick, 1000000, freq);
+#ifndef CONFIG_TIMER_POLLING
+	{
+		uint32_t units = freq / CONFIG_TIMER_EVENT_RESOLUTION;
+		_timer.wheel.unit_shift = units > 1 ? fls(units) - 1 : 0;
+	}
+#endif
+}
+
 #ifndef CONFIG_TIMER_POLLING
 
+static void _wheel_add(struct _timer_event* event)
+{
+	struct _timer_wheel* wheel = &_timer.wheel;
+	uint64_t expires, delta;
+	struct _timer_event** slot;
+	uint32_t level, idx;
+
+	/* round deadline up to the next wheel unit, never expire early */
+	expires = (event->expires + (1ull << wheel->unit_shift) - 1) >> wheel->unit_shift;
+	if (expires < wheel->jiffies)
+		expires = wheel->jiffies;
+	delta = expires - wheel->jiffies;
+	if (delta >= WHEEL_RANGE) {
+		/* will be re-cascaded when the last level wraps */
+		delta = WHEEL_RANGE - 1;
+		expires = wheel->jiffies + delta;
+	}
+
+	for (level = 0; level < WHEEL_LEVELS - 1; level++)
+		if (delta < (1ull << (WHEEL_BITS * (level + 1))))
+			break;
+	idx = (expires >> (WHEEL_BITS * level)) & WHEEL_MASK;
+
+	slot = &wheel->slots[level][idx];
+	event->next = *slot;
+	if (event->next)
+		event->next->pprev = &event->next;
+	event->pprev = slot;
+	*slot = event;
+	wheel->bitmap[level] |= 1u << idx;
+}
+
+static void _wheel_remove(struct _timer_event* event)
+{
+	struct _timer_wheel* wheel = &_timer.wheel;
+	uint32_t level, idx;
+
+	*event->pprev = event->next;
+	if (event->next)
+		event->next->pprev = event->pprev;
+
+	/* update bitmap if the slot became empty */
+	if (!*event->pprev) {
+		for (level = 0; level < WHEEL_LEVELS; level++) {
+			struct _timer_event** first = &wheel->slots[level][0];
+			if (event->pprev >= first && event->pprev < first + WHEEL_SIZE) {
+				idx = event->pprev - first;
+				wheel->bitmap[level] &= ~(1u << idx);
+				break;
+			}
+		}
+	}
+
+	event->next = NULL;
+	event->pprev = NULL;
+}
+
+static struct _timer_event* _wheel_detach_slot(uint32_t level, uint32_t idx)
+{
+	struct _timer_wheel* wheel = &_timer.wheel;
+	struct _timer_event* list = wheel->slots[level][idx];
+
+	wheel->slots[level][idx] = NULL;
+	wheel->bitmap[level] &= ~(1u << idx);
+	return list;
+}
+
+/**
+ * \brief Find the next wheel unit at which a slot must be processed or
+ * cascaded.
+ */
+static uint64_t _wheel_next_jiffy(void)
+{
+	struct _timer_wheel* wheel = &_timer.wheel;
+	uint64_t next = NO_DEADLINE;
+	uint32_t level;
+
+	for (level = 0; level < WHEEL_LEVELS; level++) {
+		uint32_t shift = WHEEL_BITS * level;
+		uint64_t block, candidate;
+		uint32_t start, bitmap;
+
+		if (!wheel->bitmap[level])
+			continue;
+
+		/* first block whose slot has not been processed/cascaded yet */
+		block = wheel->jiffies >> shift;
+		if (wheel->jiffies & ((1ull << shift) - 1))
+			block++;
+		start = block & WHEEL_MASK;
+
+		/* rotate bitmap so that bit 0 is the start slot */
+		bitmap = wheel->bitmap[level];
+		if (start)
+			bitmap = (bitmap >> start) | (bitmap << (WHEEL_SIZE - start));
+		candidate = (block + (31 - CLZ(bitmap & -bitmap))) << shift;
+		if (candidate < next)
+			next = candidate;
+	}
+
+	return next;
+}
+
+/**
+ * \brief Process the wheel unit wheel.jiffies: cascade upper levels if needed
+ * and run all expired events.
+ */
+static void _wheel_process_jiffy(void)
+{
+	struct _timer_wheel* wheel = &_timer.wheel;
+	struct _timer_event *list, *event;
+	uint64_t jiffies = wheel->jiffies;
+	uint32_t level;
+
+	for (level = 1; level < WHEEL_LEVELS; level++) {
+		uint32_t shift = WHEEL_BITS * level;
+		if (jiffies & ((1ull << shift) - 1))
+			break;
+		list = _wheel_detach_slot(level, (jiffies >> shift) & WHEEL_MASK);
+		while (list) {
+			event = list;
+			list = list->next;
+			_wheel_add(event);
+		}
+	}
+
+	list = _wheel_detach_slot(0, jiffies & WHEEL_MASK);
+	wheel->jiffies = jiffies + 1;
+
+	while (list) {
+		event = list;
+		list = list->next;
+		event->next = NULL;
+		event->pprev = NULL;
+		if (event->period) {
+			event->expires += event->period;
+			_wheel_add(event);
+		}
+		callback_call(&event->callback, event);
+	}
+}
+
+static void _timer_program_compare(void)
+{
+	uint64_t deadline, now;
+	uint32_t rc;
+
+	deadline = _wheel_next_jiffy();
+	if (deadline == NO_DEADLINE) {
+		_timer.compare_armed = false;
+		tc_disable_it(_timer.tc, _timer.channel, TC_IDR_CPCS);
+		return;
+	}
+	deadline <<= _timer.wheel.unit_shift;
+
+	do {
+		now = _timer_get_tick();
+		if (deadline < now + COMPARE_MARGIN)
+			deadline = now + COMPARE_MARGIN;
+		if ((deadline >> TC_CHANNEL_SIZE) != (now >> TC_CHANNEL_SIZE)) {
+			/* deadline is after the next overflow, COVFS will
+			 * re-evaluate it */
+			_timer.compare_armed = false;
+			tc_disable_it(_timer.tc, _timer.channel, TC_IDR_CPCS);
+			return;
+		}
+		rc = (uint32_t)deadline;
+		tc_set_ra_rb_rc(_timer.tc, _timer.channel, NULL, NULL, &rc);
+		_timer.compare_armed = true;
+		tc_enable_it(_timer.tc, _timer.channel, TC_IER_CPCS);
+		/* make sure the counter did not pass RC while we were writing it */
+	} while (_timer_get_tick() >= deadline);
+}
+
+static void _timer_dispatch_events(void)
+{
+	struct _timer_wheel* wheel = &_timer.wheel;
+	uint64_t now_jiffy, next;
+
+	for (;;) {
+		now_jiffy = _timer_get_tick() >> wheel->unit_shift;
+		next = _wheel_next_jiffy();
+		if (next > now_jiffy) {
+			if (wheel->jiffies <= now_jiffy)
+				wheel->jiffies = now_jiffy + 1;
+			break;
+		}
+		wheel->jiffies = next;
+		_wheel_process_jiffy();
+	}
+
+	_timer_program_compare();
+}
+
+static void _timer_event_arm(struct _timer_event* event, uint64_t expires,
+		uint64_t period)
+{
+	irq_disable(_timer.id);
+	if (event->pprev)
+		_wheel_remove(event);
+	event->expires = expires;
+	event->period = period;
+	_wheel_add(event);
+	_timer_program_compare();
+	irq_enable(_timer.id);
+}
+
 /**
  *  \brief Handler for timer interrupt.
  */
 static void timer_irq_handler(uint32_t source, void* user_arg)
 {
-	timer_update_upper_tick_counter();
+	timer_read_status();
+	_timer_dispatch_events();
+}
+
+#ifdef CONFIG_IRQ_PROFILE
+/**
+ * \brief Entry latency of the timer interrupt, in CPU cycles, measured
+ * against the counter: ticks since it reached RC, or since it wrapped when
+ * no compare is armed.  The resolution is one channel tick.
+ */
+static uint32_t _timer_irq_latency(uint32_t source, void* user_arg)
+{
+	uint32_t cv = tc_get_cv(_timer.tc, _timer.channel);
+	uint32_t rc, ticks = cv;
+
+	if (_timer.compare_armed) {
+		tc_get_ra_rb_rc(_timer.tc, _timer.channel, NULL, NULL, &rc);
+		if (cv >= rc)
+			ticks = cv - rc;
+	}
+	return (uint32_t)(((uint64_t)ticks * pmc_get_processor_clock()) /
+			_timer.channel_freq);
+}
+#endif
+
+/**
+ * \brief Convert the deadlines of all pending events after a change of the
+ * channel frequency, the remaining delays are preserved.
+ */
+static void _timer_rescale_events(uint64_t pre_tick, uint64_t now,
+		uint32_t old_freq, uint32_t new_freq)
+{
+	struct _timer_wheel* wheel = &_timer.wheel;
+	struct _timer_event *list = NULL, *slot, *event;
+	struct _mult_shift ratio;
+	uint64_t remaining;
+	uint32_t level, idx;
+
+	_compute_mult_shift(&ratio, old_freq, new_freq);
+
+	for (level = 0; level < WHEEL_LEVELS; level++) {
+		for (idx = 0; idx < WHEEL_SIZE; idx++) {
+			slot = _wheel_detach_slot(level, idx);
+			while (slot) {
+				event = slot;
+				slot = slot->next;
+				event->next = list;
+				list = event;
+			}
+		}
+	}
+
+	/* unit_shift was updated by _timer_set_rate() */
+	wheel->jiffies = now >> wheel->unit_shift;
+
+	while (list) {
+		event = list;
+		list = list->next;
+		event->next = NULL;
+		event->pprev = NULL;
+		remaining = event->expires > pre_tick ? event->expires - pre_tick : 0;
+		event->expires = now + _apply_mult_shift(&ratio, remaining);
+		event->period = _apply_mult_shift(&ratio, event->period);
+		_wheel_add(event);
+	}
 }
 
 #endif /* !CONFIG_TIMER_POLLING */
 
-static uint64_t _timer_get_tick(void)
+/**
+ * \brief Master clock change notifier: the channel frequency changes with
+ * MCK unless the TC is clocked from the slow clock or a generated clock.
+ */
+static int _timer_mck_notify(void* arg, void* arg2)
 {
-	uint32_t upper, lower;
+	enum _pmc_mck_event event = (enum _pmc_mck_event)arg2;
+	uint32_t old_freq, new_freq;
+	uint64_t now;
 
-	do {
-		upper = timer_get_upper_tick_counter();
-		COMPILER_BARRIER();
-		lower = tc_get_cv(_timer.tc, _timer.channel);
-	} while (upper != timer_get_upper_tick_counter());
-	return (((uint64_t)upper) << TC_CHANNEL_SIZE) | lower;
+	if (event == PMC_MCK_PRE_CHANGE) {
+#ifndef CONFIG_TIMER_POLLING
+		irq_disable(_timer.id);
+#endif
+		_timer.pre_change.tick = _timer_get_tick();
+		_timer.pre_change.ms = timer_get_tick();
+		_timer.pre_change.us = timer_get_us();
+		return 0;
+	}
+
+	old_freq = _timer.channel_freq;
+	new_freq = tc_get_channel_freq(_timer.tc, _timer.channel);
+	if (new_freq != old_freq) {
+		now = _timer_get_tick();
+		_timer.tick_base = now;
+		_timer.ms_base = _timer.pre_change.ms;
+		_timer.us_base = _timer.pre_change.us;
+		_timer_set_rate(new_freq);
+#ifndef CONFIG_TIMER_POLLING
+		_timer_rescale_events(_timer.pre_change.tick, now, old_freq, new_freq);
+#endif
+	}
+
+#ifndef CONFIG_TIMER_POLLING
+	_timer_program_compare();
+	irq_enable(_timer.id);
+#endif
+	return 0;
 }
 
 /*----------------------------------------------------------------------------
@@ -107,19 +552,31 @@ void timer_configure(Tc* tc, uint8_t channel, uint32_t clock_source)
 
 	_timer.tc = tc;
 	_timer.channel = channel;
+	_timer.id = tc_id;
 
 	if (!pmc_is_peripheral_enabled(tc_id))
 		pmc_configure_peripheral(tc_id, NULL, true);
 
 	tc_configure(tc, channel, TC_CMR_WAVE | TC_CMR_WAVSEL_UP |
 			(clock_source & TC_CMR_TCCLKS_Msk));
-	_timer.channel_freq = tc_get_channel_freq(tc, channel);
+	_timer_set_rate(tc_get_channel_freq(tc, channel));
+	_timer.tick_base = 0;
+	_timer.ms_base = 0;
+	_timer.us_base = 0;
+	callback_set(&_timer.mck_notifier.callback, _timer_mck_notify, NULL);
+	pmc_register_mck_notifier(&_timer.mck_notifier);
 #ifndef CONFIG_TIMER_POLLING
 	irq_add_handler(tc_id, timer_irq_handler, &_timer);
+#ifdef CONFIG_IRQ_PROFILE
+	irq_profile_set_latency_probe(tc_id, _timer_irq_latency, NULL);
+#endif
 	irq_enable(tc_id);
 	tc_enable_it(tc, channel, TC_IER_COVFS);
 #endif
 	tc_start(tc, channel);
+#ifndef CONFIG_TIMER_POLLING
+	_timer.wheel.jiffies = _timer_get_tick() >> _timer.wheel.unit_shift;
+#endif
 }
 
 uint64_t timer_get_interval(uint64_t start, uint64_t end)
@@ -148,13 +605,49 @@ uint8_t timer_timeout_reached(struct _timeout* timeout)
 void timer_sleep(uint64_t count)
 {
 	uint64_t end_tick = timer_get_tick() + count;
-
+#ifndef CONFIG_TIMER_POLLING
+	struct _timer_event event;
+
+	/* With interrupts masked (e.g. from a timer event callback), the TC
+	 * interrupt cannot be taken: poll the counter instead of sleeping. */
+	if (arch_irq_is_masked()) {
+		while (timer_get_tick() <= end_tick);
+		return;
+	}
+
+	/* The event has no callback, it is only used to program the compare
+	 * register so that WFI wakes up at the deadline.  It is periodic (1ms)
+	 * so that a wake-up missed between the tick check and WFI only delays
+	 * the return by one period. */
+	timer_event_init(&event, NULL);
+	_timer_event_arm(&event,
+			_timer_get_tick() + ((count + 1) * _timer.channel_freq) / 1000,
+			_timer.channel_freq / 1000);
+
+	while (timer_get_tick() <= end_tick)
+		cpu_idle();
+
+	timer_event_stop(&event);
+#else
 	while (timer_get_tick() <= end_tick);
+#endif
 }
 
 uint64_t timer_get_tick(void)
 {
-	return (_timer_get_tick() * 1000) / _timer.channel_freq;
+	return _timer.ms_base +
+		_apply_mult_shift(&_timer.tick_to_ms, _timer_get_tick() - _timer.tick_base);
+}
+
+uint64_t timer_get_us(void)
+{
+	return _timer.us_base +
+		_apply_mult_shift(&_timer.tick_to_us, _timer_get_tick() - _timer.tick_base);
+}
+
+uint64_t timer_us_to_ticks(uint32_t us)
+{
+	return _apply_mult_shift(&_timer.us_to_tick, us);
 }
 
 void sleep(uint32_t count)
@@ -171,16 +664,45 @@ void usleep(uint32_t count)
 {
 	uint64_t deadline;
 
-	/* Disable interrupts */
-	arch_irq_disable();
-
 	/* Compute deadline */
-	deadline = _timer_get_tick();
-	deadline += ROUND_INT_DIV((_timer.channel_freq / 1000) * count, 1000);
+	deadline = _timer_get_tick() + timer_us_to_ticks(count) + 1;
 
 	/* Wait for deadline to be reached */
 	while ((int64_t)(_timer_get_tick() - deadline) < 0);
+}
+
+#ifndef CONFIG_TIMER_POLLING
+
+void timer_event_init(struct _timer_event* event, struct _callback* cb)
+{
+	event->expires = 0;
+	event->period = 0;
+	callback_copy(&event->callback, cb);
+	event->next = NULL;
+	event->pprev = NULL;
+}
 
-	/* Re-enable interrupts */
-	arch_irq_enable();
+void timer_event_start(struct _timer_event* event, uint32_t delay,
+		uint32_t period)
+{
+	_timer_event_arm(event, _timer_get_tick() + timer_us_to_ticks(delay),
+			timer_us_to_ticks(period));
 }
+
+void timer_event_stop(struct _timer_event* event)
+{
+	irq_disable(_timer.id);
+	if (event->pprev) {
+		_wheel_remove(event);
+		_timer_program_compare();
+	}
+	event->period = 0;
+	irq_enable(_timer.id);
+}
+
+bool timer_event_is_pending(const struct _timer_event* event)
+{
+	return event->pprev != NULL;
+}
+
+#endif /* !CONFIG_TIMER_POLLING */
@@ -34,9 +34,11 @@
  *         Headers
  *----------------------------------------------------------------------------*/
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include "board.h"
+#include "callback.h"
 
 /*----------------------------------------------------------------------------
  *         Type definitions
@@ -48,6 +50,26 @@ struct _timeout
 	uint64_t count;
 };
 
+/**
+ * \brief Software timer event
+ *
+ * Timer events are kept in a hierarchical timing wheel driven by the TC
+ * channel given to timer_configure().  The RC compare register is programmed
+ * for the next deadline only, so no periodic tick interrupt is needed.
+ * Callbacks are invoked from the TC interrupt handler with the event as second
+ * argument.
+ *
+ * \note Timer events are not available if CONFIG_TIMER_POLLING is defined.
+ */
+struct _timer_event
+{
+	uint64_t expires;          /**< absolute deadline, in TC ticks */
+	uint64_t period;           /**< reload value in TC ticks, 0 for one-shot */
+	struct _callback callback; /**< called on expiry */
+	struct _timer_event* next;
+	struct _timer_event** pprev;
+};
+
 /*----------------------------------------------------------------------------
  *         Global functions
  *----------------------------------------------------------------------------*/
@@ -70,9 +92,11 @@ extern void timer_configure(Tc* tc, uint8_t channel, uint32_t clock_source);
 /**
  * \brief Wait for count times the timer resolution
  *
- * If interrupts are enabled, the waiting loop will use WFI instructions to put
- * the core to sleep between timer ticks.  Otherwise, if polling is enabled, a
- * busy-loop is used to poll the TC counter value.
+ * If interrupts are enabled, a one-shot timer event is armed for the deadline
+ * and the waiting loop uses WFI instructions to put the core to sleep until
+ * then.  Otherwise, if polling is enabled or if interrupts are masked (when
+ * called from an interrupt handler), a busy-loop is used to poll the TC
+ * counter value.
  */
 extern void timer_sleep(uint64_t count);
 
@@ -119,12 +143,66 @@ extern void msleep(uint32_t count);
  *  \brief Wait for at least count microseconds
  *
  * Notes:
- * - interrupts are disabled during the wait
- * - if count is <2, it is assumed to be 2
- * - maximum wait interval depends on the effective TC frequency and the TC
- * channel resolution (it is expected that this function is called with
- * count<1000)
+ * - the wait is a busy-loop, interrupts are left enabled
+ * - it is expected that this function is called with count<1000, use msleep()
+ * for longer delays
  */
 extern void usleep(uint32_t count);
 
+/**
+ * \brief Convert a duration in microseconds to TC ticks
+ *
+ * Uses multiply-shift constants precomputed by timer_configure().
+ */
+extern uint64_t timer_us_to_ticks(uint32_t us);
+
+/**
+ * \brief Get the time elapsed since the timer was configured, in
+ * microseconds
+ *
+ * Like timer_get_tick(), this time base stays monotonic across master clock
+ * changes (see pmc_notify_mck_change()), the duration of the change itself is
+ * not accounted.
+ */
+extern uint64_t timer_get_us(void);
+
+#ifndef CONFIG_TIMER_POLLING
+
+/**
+ * \brief Initialize a timer event
+ *
+ * \param event  Pointer to the timer event
+ * \param cb     Callback invoked (from interrupt context) when event expires
+ */
+extern void timer_event_init(struct _timer_event* event, struct _callback* cb);
+
+/**
+ * \brief Arm a timer event
+ *
+ * If the event is already pending, it is re-armed with the new deadline.
+ *
+ * \param event  Pointer to the timer event
+ * \param delay  Delay before first expiry, in microseconds
+ * \param period Period for subsequent expiries, in microseconds (0 for
+ * one-shot events)
+ */
+extern void timer_event_start(struct _timer_event* event, uint32_t delay,
+		uint32_t period);
+
+/**
+ * \brief Cancel a pending timer event
+ *
+ * Does nothing if the event is not pending.
+ */
+extern void timer_event_stop(struct _timer_event* event);
+
+/**
+ * \brief Tells if a timer event is armed and has not expired yet
+ *
+ * Periodic events stay pending until timer_event_stop() is called.
+ */
+extern bool timer_event_is_pending(const struct _timer_event* event);
+
+#endif /* !CONFIG_TIMER_POLLING */
+
 #endif /* TIMER_H_ */